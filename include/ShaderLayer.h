@@ -122,6 +122,12 @@ public:
 	 */
 	virtual void evaluateExpressions(std::size_t time, const IRenderEntity& entity) = 0;
 
+	/**
+	 * Returns true if the expressions of this stage read entity shaderparms,
+	 * otherwise they evaluate to the same values for every renderentity.
+	 */
+	virtual bool dependsOnEntity() const = 0;
+
 	/**
 	 * The flags set on this stage.
 	 */
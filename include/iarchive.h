@@ -57,6 +57,11 @@ public:
 	/// The stream may be read forwards until it is exhausted.
 	/// The stream remains valid for the lifetime of the file.
 	virtual InputStream& getInputStream() = 0;
+	/// \brief Returns the complete file data if it is directly accessible in
+	/// memory, like the stored files of a memory mapped archive, NULL otherwise.
+	/// The data remains valid for the lifetime of the file, reading the stream
+	/// doesn't affect it.
+	virtual const unsigned char* getData() const { return NULL; }
 };
 typedef boost::shared_ptr<ArchiveFile> ArchiveFilePtr;
 
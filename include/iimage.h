@@ -76,6 +76,15 @@ public:
 	virtual bool isPrecompressed() const {
 		return false;
 	}
+
+	/**
+	 * Uploads the pixel data into the given, already existing GL
+	 * texture object, replacing its previous contents. This allows a texture
+	 * to be filled after its texture number has been handed out.
+	 *
+	 * @returns: false if the upload failed.
+	 */
+	virtual bool uploadToTexture(GLuint textureNum) const = 0;
 };
 typedef boost::shared_ptr<Image> ImagePtr;
 
@@ -105,6 +114,17 @@ public:
 	virtual std::string getPrefix() const {
 		return "";
 	}
+
+	/* Reads the dimensions of the image from the header of the given
+	 * file, without decoding the pixel data. This allows the texture size to be
+	 * known before the image itself has been loaded.
+	 *
+	 * @returns: false if the header is invalid or if this loader doesn't
+	 * support reading the dimensions (which is the default).
+	 */
+	virtual bool getDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height) const {
+		return false;
+	}
 }; // class ImageLoader
 typedef boost::shared_ptr<ImageLoader> ImageLoaderPtr;
 
@@ -53,9 +53,8 @@ public:
 		Vector3 origin;
 		Quaternion orientation;
 	};
-	
-	// Each frame has a series of float values, applied to one or more animated components (x, y, z, yaw, pitch, roll)
-	typedef std::vector<float> FrameKeys;
+
+	typedef std::vector<Key> Keys;
 
 	/**
 	 * Get the number of joints in this animation.
@@ -83,9 +82,11 @@ public:
 	virtual std::size_t getNumFrames() const = 0;
 
 	/**
-	 * Returns the float values of the given frame index.
+	 * Calculates the pose of each joint at the given time (in msecs),
+	 * interpolating between the two nearest frames. The poses are relative
+	 * to the parent joints, the vector is resized to the number of joints.
 	 */
-	virtual const FrameKeys& getFrameKeys(std::size_t index) const = 0;
+	virtual void getJointPoses(std::size_t time, Keys& poses) const = 0;
 };
 typedef boost::shared_ptr<IMD5Anim> IMD5AnimPtr;
 
@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 /* Forward decls */
 class AABB;
 class ModelSkin;
+class ArchiveFile;
 
 namespace model
 {
@@ -128,6 +129,17 @@ public:
 };
 typedef boost::shared_ptr<ModelNode> ModelNodePtr;
 
+/**
+ * The parsed contents of a model file as returned by
+ * ModelLoader::prepareModel(). Each loader derives its own type.
+ */
+class PreparedModel
+{
+public:
+	virtual ~PreparedModel() {}
+};
+typedef boost::shared_ptr<PreparedModel> PreparedModelPtr;
+
 } // namespace model
 
 // Utility methods
@@ -163,6 +175,28 @@ public:
 	 *           NULL if the model loader could not load the file.
 	 */
 	virtual model::IModelPtr loadModelFromPath(const std::string& path) = 0;
+
+	/**
+	 * Reads and parses the given model file, this is the first half of
+	 * loadModelFromPath(). It is called on worker threads by the ModelCache,
+	 * so it must not use any other module (the file has been opened already).
+	 * Log output is collected and written on the main thread before
+	 * createModel() is called.
+	 *
+	 * @returns: the parsed model or NULL if the file could not be parsed or
+	 *           the loader doesn't support loading in the background.
+	 */
+	virtual model::PreparedModelPtr prepareModel(ArchiveFile& file) = 0;
+
+	/**
+	 * Creates the model from the result of prepareModel() for the given VFS
+	 * path, this is the second half of loadModelFromPath(). Called on the
+	 * main thread.
+	 *
+	 * @returns: the IModelPtr containing the renderable model or NULL.
+	 */
+	virtual model::IModelPtr createModel(const std::string& path,
+										 const model::PreparedModelPtr& prepared) = 0;
 };
 typedef boost::shared_ptr<ModelLoader> ModelLoaderPtr;
 
@@ -4,11 +4,31 @@
 #include "imodule.h"
 #include "imodel.h"
 #include "inode.h"
+#include <sigc++/signal.h>
 
 const std::string MODULE_MODELCACHE("ModelCache");
 
 namespace model {
 
+/**
+ * Placeholder returned by IModelCache::getModelNodeAsync() while the
+ * model is being loaded in the background. It is a model node rendering as
+ * box, like the NullModel.
+ */
+class IModelProxyNode
+{
+public:
+	virtual ~IModelProxyNode() {}
+
+	/**
+	 * Emitted on the main thread as soon as the model has been loaded, passing
+	 * the real model node. The owner of the proxy is responsible for replacing
+	 * the proxy with the given node in the scene.
+	 */
+	virtual sigc::signal<void, scene::INodePtr> signal_modelLoaded() const = 0;
+};
+typedef boost::shared_ptr<IModelProxyNode> IModelProxyNodePtr;
+
 /** Modelcache interface.
  */
 class IModelCache :
@@ -25,6 +45,22 @@ public:
 	 */
 	virtual scene::INodePtr getModelNode(const std::string& modelPath) = 0;
 
+	/**
+	 * Like getModelNode(), but models which are not in the cache yet
+	 *         are parsed on worker threads. In that case an IModelProxyNode is
+	 *         returned right away, which is replaced later on, see there.
+	 *
+	 * @returns: a valid scene::INodePtr, which is never NULL.
+	 */
+	virtual scene::INodePtr getModelNodeAsync(const std::string& modelPath) = 0;
+
+	/**
+	 * Blocks until all models requested by getModelNodeAsync() have been
+	 * loaded and their proxies have been replaced. Use this before any task
+	 * which needs the actual geometry of all models in the scene.
+	 */
+	virtual void waitForPendingModels() = 0;
+
 	/**
 	 * greebo: Get the IModel object for the given VFS path. The request is cached,
 	 *         so calling this with the same path twice will return the same
@@ -158,6 +158,22 @@ typedef boost::shared_ptr<IRenderableParticle> IRenderableParticlePtr;
  */
 typedef boost::function< void (const IParticleDef&) > ParticleDefVisitor;
 
+// If enabled, all instances of a particle def show the same particles, which
+// lets them share the evaluated bunches. Otherwise each emitter looks different.
+const char* const RKEY_PARTICLES_SHARE_SEEDS = "user/ui/particles/shareEmitterSeeds";
+
+// Particle evaluation cache figures, see IParticlesManager::getCacheStats()
+struct ParticleCacheStats
+{
+	// Bunch lookups of the last simulation run and how many were cached
+	std::size_t numLookups;
+	std::size_t numHits;
+
+	// Cached bunch evaluations and the memory used by them
+	std::size_t numEntries;
+	std::size_t memoryBytes;
+};
+
 /// Inteface for the particles manager
 class IParticlesManager :
 	public RegisterableModule
@@ -198,6 +214,12 @@ public:
      * reload.
 	 */
 	virtual void reloadParticleDefs() = 0;
+
+	/**
+	 * Returns the figures of the cache shared by all renderable particles,
+	 * which stores the evaluated particle bunches of each stage and time.
+	 */
+	virtual ParticleCacheStats getCacheStats() const = 0;
 };
 
 } // namespace
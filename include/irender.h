@@ -202,6 +202,15 @@ public:
     /// Return true if this light intersects the given AABB
 	virtual bool intersectsAABB(const AABB& aabb) const = 0;
 
+    /**
+     * \brief
+     * Return the world-space bounds of the light volume.
+     *
+     * This is used by the renderer to sort the light into its spatial index,
+     * it may be larger than the actual volume but must not be smaller.
+     */
+	virtual AABB lightAABB() const = 0;
+
     /**
      * \brief
      * Return the light origin in world space.
@@ -248,6 +257,10 @@ public:
     /// Test if the given light intersects the LitObject
     virtual bool intersectsLight(const RendererLight& light) const = 0;
 
+    /// Return the world-space bounds of this object, used for sorting it
+    /// into the renderer's light index
+    virtual const AABB& getLitObjectAABB() const = 0;
+
     /// Add a light to the set of lights which do intersect this object
     virtual void insertLight(const RendererLight& light) {}
 
@@ -288,11 +301,12 @@ typedef boost::function<void(const RendererLight&)> RendererLightCallback;
  * it invokes LightList::calculateIntersectingLights() on the stored LightList
  * reference.
  * 4. calculateIntersectingLights() first checks to see if the lights need
- * updating, which is true if EITHER this LightList's setDirty() method OR the
- * RenderSystem's lightChanged() has been called since the last calculation. If
- * no update is needed, it returns.
- * 5. If an update IS needed, the LightList iterates over all lights in the
- * scene, and tests if each one intersects its associated lit object (which is
+ * updating, which is true if EITHER this LightList's setDirty() method has been
+ * called OR a light passed to the RenderSystem's lightChanged() entered or left
+ * the object since the last calculation. If no update is needed, it returns.
+ * 5. If an update IS needed, the LightList iterates over the lights sharing
+ * a cell of the renderer's spatial light index with the object's
+ * getLitObjectAABB(), and tests if each one intersects its associated lit object (which is
  * the one that just invoked calculateIntersectingLights(), although nothing
  * enforces this). This intersection test is performed by passing the light to
  * the LitObject::intersectsLight() method.
@@ -25,6 +25,7 @@ namespace scene
 
 class ISpacePartitionSystem;
 typedef boost::shared_ptr<ISpacePartitionSystem> ISpacePartitionSystemPtr;
+class ISPNode;
 
 /**
 * A scene-graph - a Directed Acyclic Graph (DAG).
@@ -77,13 +78,40 @@ public:
     /// Accessor for the signal emitted when bounds are changed
     virtual sigc::signal<void> signal_boundsChanged() const = 0;
 
-	/// \brief Invokes all bounds-changed callbacks. Called when the bounds of any instance in the scene change.
+	/// \brief Called when the bounds of any instance in the scene change.
+	/// The bounds-changed callbacks are not invoked immediately, the notifications
+	/// are coalesced until the next call to flushBoundsChanged().
 	/// \todo Move to a separate class.
 	virtual void boundsChanged() = 0;
 
+	/// \brief Invokes all bounds-changed callbacks once, if any bounds changed since
+	/// the last call. This is done automatically before traversing the scene for
+	/// rendering or selection, call it if you need the signal to be emitted right now.
+	virtual void flushBoundsChanged() = 0;
+
 	// A specific node has changed its bounds
 	virtual void nodeBoundsChanged(const scene::INodePtr& node) = 0;
 
+	/// \brief Opens a bulk change, used when thousands of nodes are changed at once
+	/// (e.g. by undo). Until the matching endBulkChange() call the scene-changed
+	/// notifications are coalesced and the nodes changing their bounds are re-linked
+	/// in the space partition only once at the end. Nodes notified several times
+	/// about a transform or bounds change only pass it on once. Insertions and removals are
+	/// still passed to the observers right away. Bulk changes can be nested.
+	virtual void beginBulkChange() = 0;
+
+	/// \brief Closes a bulk change, the deferred notifications are sent
+	/// when the outermost bulk change is closed.
+	virtual void endBulkChange() = 0;
+
+	/// \brief True while a bulk change is open
+	virtual bool inBulkChange() const = 0;
+
+	/// \brief Emitted when the outermost bulk change has been closed, after the
+	/// scene observers have been notified. Systems holding back their own
+	/// notifications during the bulk change (like the selection system) send them here.
+	virtual sigc::signal<void> signal_bulkChangeFinished() const = 0;
+
 	// A walker class to be used in "foreachNodeInVolume"
 	class Walker
 	{
@@ -92,6 +120,14 @@ public:
 
 		// Called for each visited node, returns TRUE if traversal should continue
 		virtual bool visit(const INodePtr& node) = 0;
+
+		// Called for each space partition node intersecting the volume, before its
+		// members are visited. Returns FALSE to skip the node and its subtree,
+		// e.g. if the walker deals with its members on its own.
+		virtual bool visitSPNode(const ISPNode& node)
+		{
+			return true;
+		}
 	};
 
 	// Visit each scene node in the given volume using the given walker class, even hidden ones
@@ -118,6 +154,25 @@ public:
 typedef boost::shared_ptr<Graph> GraphPtr;
 typedef boost::weak_ptr<Graph> GraphWeakPtr;
 
+/**
+ * Keeps a bulk change on the given scene graph open for its lifetime.
+ */
+class BulkChange
+{
+	Graph& _graph;
+public:
+	BulkChange(Graph& graph) :
+		_graph(graph)
+	{
+		_graph.beginBulkChange();
+	}
+
+	~BulkChange()
+	{
+		_graph.endBulkChange();
+	}
+};
+
 class Cloneable
 {
 public:
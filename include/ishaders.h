@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <ostream>
 #include <vector>
+#include <sigc++/signal.h>
 
 #include "Texture.h"
 #include "ShaderLayer.h"
@@ -379,6 +380,19 @@ class ModuleObserver;
 
 const char* const MODULE_SHADERSYSTEM = "MaterialManager";
 
+// Texture memory figures, see MaterialManager::getTextureMemoryStats()
+struct TextureMemoryStats
+{
+	std::size_t currentBytes;
+	std::size_t peakBytes;
+	std::size_t budgetBytes; // 0 if unlimited
+
+	std::size_t numTextures;
+
+	// Textures which have been reduced to a smaller mipmap
+	std::size_t numReduced;
+};
+
 /**
  * \brief
  * Interface for the material manager.
@@ -482,6 +496,33 @@ public:
 			const std::string& filename,
 			const std::string& moduleNames = "GDK") = 0;
 
+	/**
+	 * Image maps are loaded in the background, their textures show a
+	 * placeholder until the image has been uploaded. This uploads the images
+	 * which have been loaded since the last call, spending no more than the
+	 * time budget set in the preferences. It needs to be called on the main
+	 * thread while a GL context is current, usually right before rendering.
+	 */
+	virtual void uploadStreamedTextures() = 0;
+
+	/**
+	 * Emitted when images have been loaded in the background. Views showing
+	 * textures should redraw themselves, which gets the images uploaded.
+	 */
+	virtual sigc::signal<void> signal_texturesStreamed() const = 0;
+
+	/**
+	 * Reports the GL textures drawn by a view. Textures which have not been
+	 * visible for a while are reduced to a smaller mipmap when the texture
+	 * memory budget is exceeded, reduced textures are reloaded when they
+	 * become visible again. This doesn't touch the GL state, it can be
+	 * called right after rendering.
+	 */
+	virtual void markTexturesVisible(const std::vector<GLuint>& textureNums) = 0;
+
+	// Returns the video memory used by the textures of the materials
+	virtual TextureMemoryStats getTextureMemoryStats() const = 0;
+
 	/**
 	 * Creates a new shader expression for the given string. This can be used to create standalone
 	 * expression objects for unit testing purposes.
@@ -3,6 +3,65 @@
 #include <glibmm.h>
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <vector>
+#include "itextstream.h"
+
+/**
+ * \brief
+ * Log output collected on a worker thread, see ThreadManager::beginLogCapture().
+ *
+ * The console is a GTK widget and must only be written to from the main
+ * thread, so worker threads collect their messages here and the main thread
+ * passes them to the log afterwards, using writeToLog().
+ */
+class CapturedLog
+{
+public:
+    enum Level
+    {
+        Message,
+        Warning,
+        Error,
+    };
+
+private:
+    typedef std::pair<Level, std::string> Entry;
+    std::vector<Entry> _entries;
+
+public:
+    bool empty() const
+    {
+        return _entries.empty();
+    }
+
+    void append(Level level, const char* text, std::size_t length)
+    {
+        // Continue the last entry if the level doesn't change
+        if (_entries.empty() || _entries.back().first != level)
+        {
+            _entries.push_back(Entry(level, std::string()));
+        }
+
+        _entries.back().second.append(text, length);
+    }
+
+    /// Write the collected text to the log streams, main thread only
+    void writeToLog() const
+    {
+        for (std::vector<Entry>::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+        {
+            std::ostream& stream = i->first == Error ? rError() :
+                i->first == Warning ? rWarning() : rMessage();
+
+            stream << i->second << std::flush;
+        }
+    }
+
+    void clear()
+    {
+        _entries.clear();
+    }
+};
 
 /**
  * \brief
@@ -17,4 +76,35 @@ public:
 
     /// Execute the given function in a separate thread
     virtual void execute(boost::function<void()> func) const = 0;
+
+    /**
+     * \brief
+     * Collect the log output of the calling thread in the given buffer instead
+     * of writing it to the console, until endLogCapture() is called.
+     *
+     * Jobs parsing or decoding files use this to keep the messages of the
+     * loaders away from the console, the main thread writes them later.
+     */
+    virtual void beginLogCapture(CapturedLog& log) const = 0;
+
+    /// Stop collecting the log output of the calling thread
+    virtual void endLogCapture() const = 0;
+};
+
+/// Captures the log output of the calling thread during its lifetime
+class ScopedLogCapture
+{
+    const ThreadManager& _manager;
+
+public:
+    ScopedLogCapture(const ThreadManager& manager, CapturedLog& log) :
+        _manager(manager)
+    {
+        _manager.beginLogCapture(log);
+    }
+
+    ~ScopedLogCapture()
+    {
+        _manager.endLogCapture();
+    }
 };
@@ -6,6 +6,7 @@
 #include "imodule.h"
 #include <cstddef>
 #include <memory>
+#include <sigc++/signal.h>
 
 /** 
  * greebo: An UndoMemento has to be allocated on the heap
@@ -16,6 +17,10 @@ class IUndoMemento
 {
 public:
     virtual ~IUndoMemento() {}
+
+	// Returns the approximate number of bytes occupied by this memento,
+	// the undo history is kept within a memory budget based on this.
+	virtual std::size_t getMemorySize() const = 0;
 };
 typedef std::shared_ptr<IUndoMemento> IUndoMementoPtr;
 
@@ -27,6 +32,9 @@ typedef std::shared_ptr<IUndoMemento> IUndoMementoPtr;
  *
  * The importState() method should re-import the values saved in the
  * UndoMemento
+ *
+ * Once the operation is finished, compactState() is called with the exported
+ * memento to reduce it to the parts which actually changed.
  */
 class IUndoable
 {
@@ -34,6 +42,24 @@ public:
     virtual ~IUndoable() {}
 	virtual IUndoMementoPtr exportState() const = 0;
 	virtual void importState(const IUndoMementoPtr& state) = 0;
+
+	/**
+	 * Gets called when the operation which exported the given state is
+	 * finished, with this object being in its state after the operation.
+	 * Returns a memento containing only the parts of the saved state which
+	 * differ from the current state, or an empty pointer if nothing changed.
+	 * The undo system imports the returned memento only when this object is
+	 * back in exactly the current state. The default keeps the full state.
+	 *
+	 * This relies on the object not being changed outside of an operation:
+	 * every change between UndoSystem::finish() and the next start() is
+	 * missing from the delta, and undoing would mix the two states. Objects
+	 * changing state without an operation must keep their full state.
+	 */
+	virtual IUndoMementoPtr compactState(const IUndoMementoPtr& state) const
+	{
+		return state;
+	}
 };
 
 /**
@@ -67,6 +93,9 @@ public:
 
 const std::string MODULE_UNDOSYSTEM("UndoSystem");
 
+// The maximum memory of the undo and redo history in MB
+const char* const RKEY_UNDO_MEMORY_BUDGET = "user/ui/undo/memoryBudget";
+
 class UndoSystem :
 	public RegisterableModule
 {
@@ -77,8 +106,20 @@ public:
 	virtual void releaseStateSaver(IUndoable& undoable) = 0;
 
 	virtual std::size_t size() const = 0;
+
+	// Begins an operation. All changes to undoables need to happen between
+	// start() and finish(), the saved states are compacted against the state
+	// of the undoables at finish(), see IUndoable::compactState().
 	virtual void start() = 0;
 	virtual void finish(const std::string& command) = 0;
+
+	// True between start() and finish() or cancel()
+	virtual bool operationStarted() const = 0;
+
+	// Emitted after finish() or cancel() has closed the operation, changes
+	// made by the listeners are no longer recorded in it
+	virtual sigc::signal<void> signal_operationFinished() const = 0;
+
 	virtual void undo() = 0;
 	virtual void redo() = 0;
 	virtual void clear() = 0;
@@ -102,6 +143,12 @@ public:
 
 	virtual void attachTracker(IUndoTracker& tracker) = 0;
 	virtual void detachTracker(IUndoTracker& tracker) = 0;
+
+	// Returns the approximate number of bytes used by the undo and redo history
+	virtual std::size_t getMemorySize() const = 0;
+
+	// Emitted when operations have been added to or removed from the history
+	virtual sigc::signal<void> signal_historyChanged() const = 0;
 };
 
 // The accessor function
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "iradiant.h"
+#include "ithread.h"
+
+#include <deque>
+#include <vector>
+#include <glibmm.h>
+#include <sigc++/signal.h>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+/**
+ * Processes requests in a limited number of jobs in the Radiant thread pool
+ * and hands them back to the main thread, which is woken up through a
+ * Glib::Dispatcher. Used to load files in the background, the files need to
+ * be opened on the main thread before queueing them.
+ *
+ * The Request type needs a CapturedLog member called "log". Everything the
+ * process function writes to the log streams is collected there, the main
+ * thread writes it to the console when picking up the request.
+ */
+template<typename Request>
+class BackgroundRequestQueue :
+	public boost::noncopyable
+{
+public:
+	typedef boost::shared_ptr<Request> RequestPtr;
+	typedef std::vector<RequestPtr> Requests;
+
+	// Processes a single request, called on a worker thread
+	typedef boost::function<void(Request&)> ProcessFunc;
+
+private:
+	ProcessFunc _process;
+
+	// Maximum number of thread pool jobs working at the same time
+	std::size_t _maxWorkers;
+
+	// Guards the queues and the worker count
+	Glib::Mutex _lock;
+
+	// Signalled when the last running worker finishes
+	Glib::Cond _workersFinished;
+
+	// Requests waiting to be processed
+	std::deque<RequestPtr> _pending;
+
+	// Processed requests waiting to be picked up
+	Requests _finished;
+
+	// Number of jobs currently running in the thread pool
+	std::size_t _numWorkers;
+
+	// Wakes up the main thread when requests have been processed
+	Glib::Dispatcher _dispatcher;
+
+	sigc::signal<void> _sigRequestsFinished;
+
+public:
+	// Needs to be constructed on the main thread
+	BackgroundRequestQueue(const ProcessFunc& process, std::size_t maxWorkers) :
+		_process(process),
+		_maxWorkers(maxWorkers),
+		_numWorkers(0)
+	{
+		_dispatcher.connect(sigc::mem_fun(*this, &BackgroundRequestQueue::onRequestsFinished));
+	}
+
+	// Cancels all pending requests and waits for the running jobs
+	~BackgroundRequestQueue()
+	{
+		cancel();
+	}
+
+	// Queues the given request, a job is started if the limit allows it
+	void push(const RequestPtr& request)
+	{
+		bool startWorker = false;
+
+		{
+			Glib::Mutex::Lock lock(_lock);
+
+			_pending.push_back(request);
+
+			if (_numWorkers < _maxWorkers)
+			{
+				++_numWorkers;
+				startWorker = true;
+			}
+		}
+
+		if (startWorker)
+		{
+			GlobalRadiant().getThreadManager().execute(
+				boost::bind(&BackgroundRequestQueue::runWorker, this)
+			);
+		}
+	}
+
+	// Moves the processed requests into the given list, doesn't block
+	void takeFinishedRequests(Requests& finished)
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		finished.insert(finished.end(), _finished.begin(), _finished.end());
+		_finished.clear();
+	}
+
+	/**
+	 * Puts back requests which have been taken but not handled yet, they are
+	 * returned first by the next takeFinishedRequests() call. The main thread
+	 * is notified again.
+	 */
+	void returnFinishedRequests(const Requests& requests)
+	{
+		if (requests.empty()) return;
+
+		{
+			Glib::Mutex::Lock lock(_lock);
+			_finished.insert(_finished.begin(), requests.begin(), requests.end());
+		}
+
+		_dispatcher();
+	}
+
+	// True if no request is pending, being processed or waiting to be picked up
+	bool isIdle()
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		return _pending.empty() && _finished.empty() && _numWorkers == 0;
+	}
+
+	// Blocks until all queued requests have been processed
+	void waitForPendingRequests()
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		// There's always a worker running as long as requests are pending
+		while (_numWorkers > 0)
+		{
+			_workersFinished.wait(_lock);
+		}
+	}
+
+	// Drops the pending requests and waits for the running jobs to finish
+	void cancel()
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		_pending.clear();
+
+		while (_numWorkers > 0)
+		{
+			_workersFinished.wait(_lock);
+		}
+
+		_finished.clear();
+	}
+
+	/**
+	 * Emitted on the main thread when processed requests are waiting, and
+	 * once more when the last job has finished.
+	 */
+	sigc::signal<void> signal_requestsFinished() const
+	{
+		return _sigRequestsFinished;
+	}
+
+private:
+	// Thread pool job, processes pending requests until the queue is empty
+	void runWorker()
+	{
+		while (true)
+		{
+			RequestPtr request;
+
+			{
+				Glib::Mutex::Lock lock(_lock);
+
+				if (_pending.empty())
+				{
+					if (--_numWorkers == 0)
+					{
+						// Let the main thread notice that we're idle
+						_dispatcher();
+						_workersFinished.broadcast();
+					}
+
+					return;
+				}
+
+				request = _pending.front();
+				_pending.pop_front();
+			}
+
+			{
+				ScopedLogCapture capture(GlobalRadiant().getThreadManager(), request->log);
+
+				try
+				{
+					_process(*request);
+				}
+				catch (std::exception& e)
+				{
+					rError() << "Background request failed: " << e.what() << std::endl;
+				}
+			}
+
+			bool wakeMainThread = false;
+
+			{
+				Glib::Mutex::Lock lock(_lock);
+
+				// The main thread has been notified already if the list is non-empty
+				wakeMainThread = _finished.empty();
+				_finished.push_back(request);
+			}
+
+			if (wakeMainThread)
+			{
+				_dispatcher();
+			}
+		}
+	}
+
+	// Invoked on the main thread by the dispatcher
+	void onRequestsFinished()
+	{
+		_sigRequestsFinished.emit();
+	}
+};
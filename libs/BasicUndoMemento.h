@@ -1,10 +1,75 @@
 #pragma once
 
 #include "iundo.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <utility>
 
 namespace undo
 {
 
+// The number of bytes an object occupies on the heap, in addition to its own
+// size. Used to estimate the memory of the undo history, so the overloads
+// only cover the containers actually stored in mementos.
+template<typename T>
+std::size_t getHeapSize(const T& object);
+
+inline std::size_t getHeapSize(const std::string& str);
+
+template<typename First, typename Second>
+std::size_t getHeapSize(const std::pair<First, Second>& pair);
+
+template<typename T, typename Allocator>
+std::size_t getHeapSize(const std::vector<T, Allocator>& vector);
+
+template<typename T, typename Allocator>
+std::size_t getHeapSize(const std::list<T, Allocator>& list);
+
+template<typename T>
+std::size_t getHeapSize(const T& object)
+{
+	return 0;
+}
+
+inline std::size_t getHeapSize(const std::string& str)
+{
+	return str.capacity();
+}
+
+template<typename First, typename Second>
+std::size_t getHeapSize(const std::pair<First, Second>& pair)
+{
+	return getHeapSize(pair.first) + getHeapSize(pair.second);
+}
+
+template<typename T, typename Allocator>
+std::size_t getHeapSize(const std::vector<T, Allocator>& vector)
+{
+	std::size_t size = vector.capacity() * sizeof(T);
+
+	for (typename std::vector<T, Allocator>::const_iterator i = vector.begin(); i != vector.end(); ++i)
+	{
+		size += getHeapSize(*i);
+	}
+
+	return size;
+}
+
+template<typename T, typename Allocator>
+std::size_t getHeapSize(const std::list<T, Allocator>& list)
+{
+	// Each element lives in its own node with two pointers
+	std::size_t size = list.size() * (sizeof(T) + 2 * sizeof(void*));
+
+	for (typename std::list<T, Allocator>::const_iterator i = list.begin(); i != list.end(); ++i)
+	{
+		size += getHeapSize(*i);
+	}
+
+	return size;
+}
+
 /**
  * An UndoMemento implementation capable of holding a single
  * copyable object, which is stored by value.
@@ -23,6 +88,11 @@ public:
 	{
 		return _data;
 	}
+
+	std::size_t getMemorySize() const
+	{
+		return sizeof(*this) + getHeapSize(_data);
+	}
 };
 
 } // namespace
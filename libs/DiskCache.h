@@ -0,0 +1,360 @@
+#pragma once
+
+#include "imodule.h"
+#include "itextstream.h"
+#include "string/convert.h"
+
+#include <map>
+#include <string>
+#include <ctime>
+#include <cstring>
+#include <fstream>
+#include <glib.h>
+#include <glibmm/thread.h>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/filesystem.hpp>
+
+/**
+ * Accumulates data into a 64 bit FNV-1a hash, used as key for the DiskCache.
+ * Eight bytes are mixed in at once, the hashed files can be large.
+ */
+class DiskCacheKey
+{
+	guint64 _hash;
+
+public:
+	DiskCacheKey() :
+		_hash(14695981039346656037ULL)
+	{}
+
+	void add(const void* data, std::size_t length)
+	{
+		static const guint64 FNV_PRIME = 1099511628211ULL;
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		const unsigned char* end = bytes + length;
+
+		for (; end - bytes >= 8; bytes += 8)
+		{
+			guint64 word;
+			std::memcpy(&word, bytes, sizeof(word));
+
+			_hash = (_hash ^ word) * FNV_PRIME;
+
+			// The multiplication only carries upwards, fold the high bits back in
+			_hash ^= _hash >> 32;
+		}
+
+		for (; bytes != end; ++bytes)
+		{
+			_hash = (_hash ^ *bytes) * FNV_PRIME;
+		}
+	}
+
+	void add(const std::string& str)
+	{
+		add(str.c_str(), str.size() + 1); // include the terminator to separate the strings
+	}
+
+	template<typename T>
+	void addValue(const T& value)
+	{
+		add(&value, sizeof(value));
+	}
+
+	// Returns the hash as hexadecimal string, 16 characters
+	std::string toString() const
+	{
+		static const char* const HEX_DIGITS = "0123456789abcdef";
+
+		std::string result(16, '0');
+
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			result[15 - i] = HEX_DIGITS[(_hash >> (i * 4)) & 0xf];
+		}
+
+		return result;
+	}
+};
+
+/**
+ * Persistent, content-addressed cache folder in the user's settings path.
+ * Files are written to a temporary name and renamed when complete, so
+ * several editor instances can share the folder. The least recently used
+ * files are removed as soon as the folder exceeds its size limit, the file
+ * modification time keeps track of the usage across sessions.
+ *
+ * The folder is scanned on first use. All methods are thread-safe.
+ */
+class DiskCache :
+	public boost::noncopyable
+{
+	struct Entry
+	{
+		std::size_t size;
+		std::time_t lastUsed;
+	};
+
+	// Maps the keys to the cached files
+	typedef std::map<std::string, Entry> EntryMap;
+	EntryMap _entries;
+
+	// Guards the entry map and the sizes
+	Glib::Mutex _lock;
+
+	// Folder name relative to the settings path and the file extension
+	std::string _folder;
+	std::string _extension;
+
+	std::string _path;
+
+	std::size_t _totalSize;
+	std::size_t _maxSize;
+
+	// Used to generate unique names for files being written
+	std::size_t _tempFileCounter;
+
+	bool _initialised;
+
+public:
+	// Writes the contents of a cache file to the given stream
+	typedef boost::function<void(std::ostream&)> WriteFunction;
+
+	/**
+	 * Construct a cache using the given folder (e.g. "modelcache/") and file
+	 * extension (e.g. ".dmdl"), limited to the given number of bytes.
+	 */
+	DiskCache(const std::string& folder, const std::string& extension, std::size_t maxSize) :
+		_folder(folder),
+		_extension(extension),
+		_totalSize(0),
+		_maxSize(maxSize),
+		_tempFileCounter(0),
+		_initialised(false)
+	{}
+
+	// Changes the size limit, removes old files if necessary
+	void setMaxSize(std::size_t maxSize)
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		_maxSize = maxSize;
+
+		if (_initialised)
+		{
+			evict();
+		}
+	}
+
+	/**
+	 * Maps the cache file with the given key into memory, returns NULL if
+	 * there is none. The caller owns the returned mapping and is expected
+	 * to remove() the file if its contents turn out to be invalid. A
+	 * copy-on-write mapping can be modified without touching the file.
+	 */
+	GMappedFile* open(const std::string& key, bool copyOnWrite = false)
+	{
+		{
+			Glib::Mutex::Lock lock(_lock);
+
+			ensureInitialised();
+
+			EntryMap::iterator found = _entries.find(key);
+
+			if (found == _entries.end())
+			{
+				return NULL;
+			}
+
+			found->second.lastUsed = std::time(NULL);
+		}
+
+		std::string filename = getFilename(key);
+
+		GError* error = NULL;
+		GMappedFile* file = g_mapped_file_new(filename.c_str(), copyOnWrite ? TRUE : FALSE, &error);
+
+		if (file == NULL)
+		{
+			g_error_free(error);
+			remove(key);
+			return NULL;
+		}
+
+		// Record the usage for the next session's LRU order
+		boost::system::error_code ec;
+		boost::filesystem::last_write_time(filename, std::time(NULL), ec);
+
+		return file;
+	}
+
+	// Removes the cache file with the given key, reporting it as invalid
+	void remove(const std::string& key)
+	{
+		rWarning() << "Removing invalid cache file " << getFilename(key) << std::endl;
+
+		Glib::Mutex::Lock lock(_lock);
+
+		EntryMap::iterator found = _entries.find(key);
+
+		if (found != _entries.end())
+		{
+			removeEntry(found);
+		}
+	}
+
+	// Stores a cache file under the given key, its contents are written by the given function
+	void store(const std::string& key, const WriteFunction& write)
+	{
+		namespace fs = boost::filesystem;
+
+		std::string tempFilename;
+
+		{
+			Glib::Mutex::Lock lock(_lock);
+
+			ensureInitialised();
+
+			if (_maxSize == 0) return;
+
+			tempFilename = _path + key + "_" + string::to_string(_tempFileCounter++) + ".tmp";
+		}
+
+		std::size_t fileSize = 0;
+
+		{
+			std::ofstream stream(tempFilename.c_str(), std::ios::binary);
+
+			write(stream);
+
+			fileSize = static_cast<std::size_t>(stream.tellp());
+
+			if (!stream)
+			{
+				rWarning() << "Could not write cache file " << tempFilename << std::endl;
+
+				stream.close();
+
+				boost::system::error_code ec;
+				fs::remove(tempFilename, ec);
+				return;
+			}
+		}
+
+		// Move the completed file into place, another thread or
+		// another editor instance might have been faster
+		std::string filename = getFilename(key);
+
+		boost::system::error_code ec;
+		fs::rename(tempFilename, filename, ec);
+
+		if (ec)
+		{
+			fs::remove(tempFilename, ec);
+			return;
+		}
+
+		Glib::Mutex::Lock lock(_lock);
+
+		EntryMap::iterator existing = _entries.find(key);
+
+		if (existing != _entries.end())
+		{
+			_totalSize -= existing->second.size;
+		}
+
+		Entry& entry = _entries[key];
+
+		entry.size = fileSize;
+		entry.lastUsed = std::time(NULL);
+
+		_totalSize += fileSize;
+
+		evict();
+	}
+
+private:
+	// Scans the cache folder, needs to be called with the lock held
+	void ensureInitialised()
+	{
+		namespace fs = boost::filesystem;
+
+		if (_initialised) return;
+
+		_initialised = true;
+
+		_path = module::GlobalModuleRegistry().getApplicationContext().getSettingsPath() + _folder;
+
+		boost::system::error_code ec;
+		fs::create_directories(_path, ec);
+
+		for (fs::directory_iterator it(_path, ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+		{
+			const fs::path& candidate = it->path();
+
+			if (!fs::is_regular_file(candidate, ec)) continue;
+
+			std::string extension = candidate.extension().string();
+
+			if (extension == ".tmp")
+			{
+				// Left over from an interrupted session, unless another
+				// instance is writing it right now
+				if (std::time(NULL) - fs::last_write_time(candidate, ec) > 60)
+				{
+					fs::remove(candidate, ec);
+				}
+
+				continue;
+			}
+
+			if (extension != _extension) continue;
+
+			Entry& entry = _entries[candidate.stem().string()];
+
+			entry.size = static_cast<std::size_t>(fs::file_size(candidate, ec));
+			entry.lastUsed = fs::last_write_time(candidate, ec);
+
+			_totalSize += entry.size;
+		}
+
+		evict();
+	}
+
+	// Removes the least recently used files until the size limit is met,
+	// needs to be called with the lock held
+	void evict()
+	{
+		while (_totalSize > _maxSize && !_entries.empty())
+		{
+			EntryMap::iterator oldest = _entries.begin();
+
+			for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i)
+			{
+				if (i->second.lastUsed < oldest->second.lastUsed)
+				{
+					oldest = i;
+				}
+			}
+
+			removeEntry(oldest);
+		}
+	}
+
+	// Removes the given entry and its file, needs to be called with the lock held
+	void removeEntry(EntryMap::iterator entry)
+	{
+		boost::system::error_code ec;
+		boost::filesystem::remove(getFilename(entry->first), ec);
+
+		_totalSize -= entry->second.size;
+		_entries.erase(entry);
+	}
+
+	std::string getFilename(const std::string& key) const
+	{
+		return _path + key + _extension;
+	}
+};
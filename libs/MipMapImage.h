@@ -0,0 +1,230 @@
+#pragma once
+
+#include "igl.h"
+#include "iimage.h"
+#include "BasicTexture2D.h"
+#include "image/MipMapGenerator.h"
+#include "image/DXTCompressor.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+class MipMapImage;
+typedef boost::shared_ptr<MipMapImage> MipMapImagePtr;
+
+/**
+ * An image carrying its complete mipmap chain, either as RGBA pixels
+ * or compressed to DXT1/DXT5. The chain is generated on the CPU by create(),
+ * which can be called from worker threads, so the upload doesn't need to
+ * compute anything anymore (unlike gluBuild2DMipmaps).
+ */
+class MipMapImage :
+	public Image,
+	public boost::noncopyable
+{
+public:
+	struct Options
+	{
+		image::MipMapOptions mipMaps;
+
+		// Compress to DXT1 (opaque) or DXT5 (with alpha)
+		bool compress;
+
+		Options() :
+			compress(false)
+		{}
+	};
+
+private:
+	std::vector<byte> _data;
+	std::vector<image::MipMapLevel> _levels;
+
+	// GL_RGBA or one of the S3TC formats
+	GLenum _format;
+
+	MipMapImage() :
+		_format(GL_RGBA)
+	{}
+
+public:
+	/**
+	 * Generates the mipmaps of the given image, which needs to be an
+	 * uncompressed RGBA image. The dimensions are kept as they are, images
+	 * which are not a power of two in size are uploaded as such.
+	 */
+	static MipMapImagePtr create(const Image& source, const Options& options)
+	{
+		std::size_t width = source.getWidth(0);
+		std::size_t height = source.getHeight(0);
+
+		const byte* pixels = source.getMipMapPixels(0);
+
+		image::MipMapChain chain;
+		image::generateMipMaps(pixels, width, height, options.mipMaps, chain);
+
+		MipMapImagePtr result(new MipMapImage);
+
+		if (!options.compress)
+		{
+			result->_data.swap(chain.data);
+			result->_levels.swap(chain.levels);
+
+			return result;
+		}
+
+		image::DXTFormat format = image::hasTransparency(pixels, width * height) ?
+			image::DXT_FORMAT_DXT5 : image::DXT_FORMAT_DXT1;
+
+		result->_format = format == image::DXT_FORMAT_DXT5 ?
+			GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+		std::size_t totalSize = 0;
+
+		for (std::size_t i = 0; i < chain.levels.size(); ++i)
+		{
+			image::MipMapLevel level = chain.levels[i];
+
+			level.offset = totalSize;
+			level.size = image::getCompressedSize(format, level.width, level.height);
+
+			result->_levels.push_back(level);
+			totalSize += level.size;
+		}
+
+		result->_data.resize(totalSize);
+
+		for (std::size_t i = 0; i < chain.levels.size(); ++i)
+		{
+			const image::MipMapLevel& level = chain.levels[i];
+
+			image::compressDXT(format, chain.getPixels(i), level.width, level.height,
+				&result->_data[result->_levels[i].offset]);
+		}
+
+		return result;
+	}
+
+	// Returns GL_RGBA or the compressed GL format of the pixel data
+	GLenum getFormat() const
+	{
+		return _format;
+	}
+
+	std::size_t getNumMipMaps() const
+	{
+		return _levels.size();
+	}
+
+	// Returns the size of the given mipmap's pixel data in bytes
+	std::size_t getMipMapSize(std::size_t mipMapIndex) const
+	{
+		assert(mipMapIndex < _levels.size());
+
+		return _levels[mipMapIndex].size;
+	}
+
+	virtual byte* getMipMapPixels(std::size_t mipMapIndex) const
+	{
+		assert(mipMapIndex < _levels.size());
+
+		return const_cast<byte*>(&_data[_levels[mipMapIndex].offset]);
+	}
+
+	virtual std::size_t getWidth(std::size_t mipMapIndex) const
+	{
+		assert(mipMapIndex < _levels.size());
+
+		return _levels[mipMapIndex].width;
+	}
+
+	virtual std::size_t getHeight(std::size_t mipMapIndex) const
+	{
+		assert(mipMapIndex < _levels.size());
+
+		return _levels[mipMapIndex].height;
+	}
+
+	bool isPrecompressed() const
+	{
+		return _format != GL_RGBA;
+	}
+
+	bool uploadToTexture(GLuint textureNum) const
+	{
+		glBindTexture(GL_TEXTURE_2D, textureNum);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+
+		// Levels exceeding the maximum texture size are skipped
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+		std::size_t first = 0;
+
+		while (first + 1 < _levels.size() && maxSize > 0 &&
+			   (_levels[first].width > static_cast<std::size_t>(maxSize) ||
+				_levels[first].height > static_cast<std::size_t>(maxSize)))
+		{
+			++first;
+		}
+
+		for (std::size_t i = first; i < _levels.size(); ++i)
+		{
+			const image::MipMapLevel& level = _levels[i];
+			GLint glLevel = static_cast<GLint>(i - first);
+
+			if (_format == GL_RGBA)
+			{
+				glTexImage2D(GL_TEXTURE_2D, glLevel, GL_RGBA,
+					static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height),
+					0, GL_RGBA, GL_UNSIGNED_BYTE, &_data[level.offset]);
+			}
+			else
+			{
+				glCompressedTexImage2D(GL_TEXTURE_2D, glLevel, _format,
+					static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height),
+					0, static_cast<GLsizei>(level.size), &_data[level.offset]);
+			}
+
+			// Handle unsupported format error
+			if (glGetError() == GL_INVALID_ENUM)
+			{
+				glBindTexture(GL_TEXTURE_2D, 0);
+				return false;
+			}
+		}
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(_levels.size() - 1 - first));
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		return true;
+	}
+
+	/* BindableTexture implementation */
+	TexturePtr bindTexture(const std::string& name) const
+	{
+		GLuint textureNum;
+
+		GlobalOpenGL().assertNoErrors();
+
+		glGenTextures(1, &textureNum);
+
+		if (!uploadToTexture(textureNum))
+		{
+			glDeleteTextures(1, &textureNum);
+			return TexturePtr();
+		}
+
+		BasicTexture2DPtr tex2DObject(new BasicTexture2D(textureNum, name));
+		tex2DObject->setWidth(getWidth(0));
+		tex2DObject->setHeight(getHeight(0));
+
+		GlobalOpenGL().assertNoErrors();
+
+		return tex2DObject;
+	}
+};
@@ -69,6 +69,17 @@ public:
 
 		_importCallback(std::static_pointer_cast<BasicUndoMemento<Copyable> >(state)->data());
 	}
+
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const
+	{
+		// The object is either saved as a whole or not at all
+		if (std::static_pointer_cast<BasicUndoMemento<Copyable> >(state)->data() == _object)
+		{
+			return IUndoMementoPtr();
+		}
+
+		return state;
+	}
 };
 
 } // namespace
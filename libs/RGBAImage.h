@@ -3,6 +3,7 @@
 #include "igl.h"
 #include "iimage.h"
 #include "BasicTexture2D.h"
+#include "MipMapImage.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
@@ -58,6 +59,13 @@ public:
 		return height;
 	}
 
+	bool uploadToTexture(GLuint textureNum) const
+	{
+		// Generate the mipmaps with the default options (box filter),
+		// the texture manager converts its images with the user's settings
+		return MipMapImage::create(*this, MipMapImage::Options())->uploadToTexture(textureNum);
+	}
+
     /* BindableTexture implementation */
     TexturePtr bindTexture(const std::string& name) const
     {
@@ -67,21 +75,7 @@ public:
 
 		// Allocate a new texture number and store it into the Texture structure
 		glGenTextures(1, &textureNum);
-		glBindTexture(GL_TEXTURE_2D, textureNum);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-
-		// Download the image to OpenGL
-		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA,
-			static_cast<GLint>(getWidth(0)), static_cast<GLint>(getHeight(0)),
-			GL_RGBA, GL_UNSIGNED_BYTE,
-			getMipMapPixels(0)
-		);
-
-		// Un-bind the texture
-		glBindTexture(GL_TEXTURE_2D, 0);
+		uploadToTexture(textureNum);
 
         // Construct texture object
         BasicTexture2DPtr tex2DObject(new BasicTexture2D(textureNum, name));
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glibmm/thread.h>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * A fixed set of worker threads executing numbered jobs. run() distributes
+ * the jobs and returns when all of them are done, the calling thread takes
+ * part in the work. Used to spread per-frame work like skinning or particle
+ * simulation across the available cores.
+ */
+class WorkerPool :
+	public boost::noncopyable
+{
+public:
+	typedef boost::function<void(std::size_t)> Job;
+
+private:
+	std::vector<Glib::Thread*> _threads;
+
+	// Serialises calls to run()
+	Glib::Mutex _runLock;
+
+	// Guards the members below
+	Glib::Mutex _lock;
+	Glib::Cond _jobsAvailable;
+	Glib::Cond _jobsDone;
+
+	const Job* _job;
+	std::size_t _numJobs;
+	std::size_t _nextJob;
+	std::size_t _finishedJobs;
+	bool _shutdown;
+
+public:
+	// The number of threads executing jobs, including the calling thread
+	WorkerPool(std::size_t numThreads) :
+		_job(NULL),
+		_numJobs(0),
+		_nextJob(0),
+		_finishedJobs(0),
+		_shutdown(false)
+	{
+		for (std::size_t i = 1; i < numThreads; ++i)
+		{
+			_threads.push_back(Glib::Thread::create(
+				sigc::mem_fun(*this, &WorkerPool::runWorker), true
+			));
+		}
+	}
+
+	~WorkerPool()
+	{
+		{
+			Glib::Mutex::Lock lock(_lock);
+
+			_shutdown = true;
+			_jobsAvailable.broadcast();
+		}
+
+		for (std::vector<Glib::Thread*>::const_iterator i = _threads.begin(); i != _threads.end(); ++i)
+		{
+			(*i)->join();
+		}
+	}
+
+	// The number of threads executing jobs, including the calling thread
+	std::size_t getNumThreads() const
+	{
+		return _threads.size() + 1;
+	}
+
+	// The number of processors the jobs can run on, at least 1
+	static std::size_t getNumHardwareThreads()
+	{
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+
+		long count = static_cast<long>(info.dwNumberOfProcessors);
+#else
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		return count > 1 ? static_cast<std::size_t>(count) : 1;
+	}
+
+	// Calls job(0) to job(numJobs - 1), returns when all calls are done
+	void run(std::size_t numJobs, const Job& job)
+	{
+		if (numJobs == 0) return;
+
+		if (numJobs == 1 || _threads.empty())
+		{
+			for (std::size_t i = 0; i < numJobs; ++i)
+			{
+				job(i);
+			}
+
+			return;
+		}
+
+		Glib::Mutex::Lock runLock(_runLock);
+		Glib::Mutex::Lock lock(_lock);
+
+		_job = &job;
+		_numJobs = numJobs;
+		_nextJob = 0;
+		_finishedJobs = 0;
+
+		_jobsAvailable.broadcast();
+
+		// The calling thread helps out instead of waiting idly
+		executeJobs();
+
+		while (_finishedJobs < _numJobs)
+		{
+			_jobsDone.wait(_lock);
+		}
+
+		_job = NULL;
+		_numJobs = 0;
+		_nextJob = 0;
+	}
+
+private:
+	void runWorker()
+	{
+		Glib::Mutex::Lock lock(_lock);
+
+		while (true)
+		{
+			while (!_shutdown && _nextJob >= _numJobs)
+			{
+				_jobsAvailable.wait(_lock);
+			}
+
+			if (_shutdown) return;
+
+			executeJobs();
+		}
+	}
+
+	// Executes jobs until none is left, called with _lock held
+	void executeJobs()
+	{
+		while (_nextJob < _numJobs)
+		{
+			std::size_t index = _nextJob++;
+			const Job& job = *_job;
+
+			_lock.unlock();
+			job(index);
+			_lock.lock();
+
+			if (++_finishedJobs == _numJobs)
+			{
+				_jobsDone.signal();
+			}
+		}
+	}
+};
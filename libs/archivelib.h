@@ -29,6 +29,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "string/string.h"
 #include "os/path.h"
 #include "iregistry.h"
+#include <vector>
+#include <algorithm>
 
 /// \brief A single-byte-reader wrapper around an InputStream.
 /// Optimised for reading one byte at a time.
@@ -157,19 +159,20 @@ public:
     /**
      * Constructor.
      *
-     * @param modDir
-     * Name of the mod directory containing this file.
+     * @param modName
+     * Name of the mod directory containing this file, relative to the engine
+     * path. Computed once by the archive, files may be opened on any thread.
      */
     StoredArchiveTextFile(const std::string& name,
                           const std::string& archiveName,
-                          const std::string& modDir,
+                          const std::string& modName,
                           position_type position,
                           size_type stream_size)
     : m_name(name),
       m_filestream(archiveName),
       m_substream(m_filestream, position, stream_size),
       m_textStream(m_substream),
-	  _modDir(os::getRelativePathMinusFilename(modDir, GlobalRegistry().get(RKEY_ENGINE_PATH)))
+	  _modDir(modName)
     {}
 
  	const std::string& getName() const {
@@ -242,12 +245,13 @@ class DirectoryArchiveTextFile :
     std::string _modDir;
 public:
 
+    // The mod name is relative to the engine path, see StoredArchiveTextFile
     DirectoryArchiveTextFile(const std::string& name,
-                             const std::string& modDir,
+                             const std::string& modName,
                              const std::string& filename)
     : m_name(name),
       m_inputStream(filename.c_str()),
-      _modDir(os::getRelativePathMinusFilename(modDir, GlobalRegistry().get(RKEY_ENGINE_PATH)))
+      _modDir(modName)
     {}
 
 	bool failed() const {
@@ -271,4 +275,80 @@ public:
 };
 typedef boost::shared_ptr<DirectoryArchiveTextFile> DirectoryArchiveTextFilePtr;
 
+/// \brief An ArchiveFile holding another file's contents in memory.
+/// Useful if the data is needed by several readers. The contents are
+/// copied, unless the source file provides them directly (see
+/// ArchiveFile::getData()), in which case the source must outlive this file.
+class MemoryArchiveFile :
+	public ArchiveFile
+{
+	class MemoryInputStream :
+		public InputStream
+	{
+		const byte_type* _cur;
+		const byte_type* _end;
+
+	public:
+		MemoryInputStream(const byte_type* begin, const byte_type* end) :
+			_cur(begin),
+			_end(end)
+		{}
+
+		size_type read(byte_type* buffer, size_type length)
+		{
+			size_type count = std::min(static_cast<size_type>(_end - _cur), length);
+
+			std::copy(_cur, _cur + count, buffer);
+			_cur += count;
+
+			return count;
+		}
+	};
+
+	std::string m_name;
+	std::vector<InputStream::byte_type> m_copy;
+	const InputStream::byte_type* m_data;
+	std::size_t m_size;
+	MemoryInputStream m_istream;
+
+public:
+	typedef InputStream::size_type size_type;
+
+	// Uses the data of the given file, or reads the remaining data of its stream
+	MemoryArchiveFile(ArchiveFile& source) :
+		m_name(source.getName()),
+		m_data(source.getData()),
+		m_size(source.size()),
+		m_istream(NULL, NULL)
+	{
+		if (m_data == NULL && m_size > 0)
+		{
+			m_copy.resize(m_size);
+			m_copy.resize(source.getInputStream().read(&m_copy.front(), m_copy.size()));
+
+			m_data = m_copy.empty() ? NULL : &m_copy.front();
+			m_size = m_copy.size();
+		}
+
+		m_istream = m_data == NULL ? MemoryInputStream(NULL, NULL) :
+			MemoryInputStream(m_data, m_data + m_size);
+	}
+
+	size_type size() const {
+		return m_size;
+	}
+
+	const std::string& getName() const {
+		return m_name;
+	}
+
+	InputStream& getInputStream() {
+		return m_istream;
+	}
+
+	const InputStream::byte_type* getData() const {
+		return m_data;
+	}
+};
+
 #endif
@@ -0,0 +1,534 @@
+#include "DXTCompressor.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace image
+{
+
+namespace
+{
+
+// Number of least squares refinement passes per colour block
+const int REFINE_ITERATIONS = 2;
+
+struct Colour
+{
+	float r, g, b;
+
+	Colour() : r(0), g(0), b(0) {}
+	Colour(float r_, float g_, float b_) : r(r_), g(g_), b(b_) {}
+
+	Colour operator+(const Colour& other) const { return Colour(r + other.r, g + other.g, b + other.b); }
+	Colour operator-(const Colour& other) const { return Colour(r - other.r, g - other.g, b - other.b); }
+	Colour operator*(float f) const { return Colour(r * f, g * f, b * f); }
+
+	float dot(const Colour& other) const { return r * other.r + g * other.g + b * other.b; }
+};
+
+inline int clampInt(int value, int lower, int upper)
+{
+	return value < lower ? lower : (value > upper ? upper : value);
+}
+
+inline unsigned short packColour(const Colour& colour)
+{
+	int r = clampInt(static_cast<int>(colour.r * 31.0f / 255.0f + 0.5f), 0, 31);
+	int g = clampInt(static_cast<int>(colour.g * 63.0f / 255.0f + 0.5f), 0, 63);
+	int b = clampInt(static_cast<int>(colour.b * 31.0f / 255.0f + 0.5f), 0, 31);
+
+	return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+}
+
+inline void unpackColour(unsigned short packed, int* rgb)
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Fills the four palette entries, the fourth is unused (transparent) in 3 colour mode
+void buildPalette(unsigned short c0, unsigned short c1, bool threeColourMode, int palette[4][3])
+{
+	unpackColour(c0, palette[0]);
+	unpackColour(c1, palette[1]);
+
+	for (int c = 0; c < 3; ++c)
+	{
+		if (threeColourMode)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		else
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	}
+}
+
+// A 4x4 block of RGBA pixels, replicated at the image borders
+struct Block
+{
+	byte pixels[16][4];
+
+	Block(const byte* image, std::size_t width, std::size_t height, std::size_t blockX, std::size_t blockY)
+	{
+		for (std::size_t y = 0; y < 4; ++y)
+		{
+			std::size_t sourceY = std::min(blockY * 4 + y, height - 1);
+
+			for (std::size_t x = 0; x < 4; ++x)
+			{
+				std::size_t sourceX = std::min(blockX * 4 + x, width - 1);
+
+				std::memcpy(pixels[y * 4 + x], image + (sourceY * width + sourceX) * 4, 4);
+			}
+		}
+	}
+};
+
+struct ColourFit
+{
+	unsigned short c0;
+	unsigned short c1;
+	unsigned char indices[16];
+	int error;
+};
+
+// Picks the nearest palette entries for the active pixels, returns the summed squared error
+void assignIndices(const Block& block, const bool* active, bool threeColourMode, ColourFit& fit)
+{
+	int palette[4][3];
+	buildPalette(fit.c0, fit.c1, threeColourMode, palette);
+
+	int numEntries = threeColourMode ? 3 : 4;
+
+	fit.error = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!active[i])
+		{
+			fit.indices[i] = 3; // transparent
+			continue;
+		}
+
+		int best = 0;
+		int bestError = 0x7fffffff;
+
+		for (int e = 0; e < numEntries; ++e)
+		{
+			int dr = block.pixels[i][0] - palette[e][0];
+			int dg = block.pixels[i][1] - palette[e][1];
+			int db = block.pixels[i][2] - palette[e][2];
+
+			int error = dr * dr + dg * dg + db * db;
+
+			if (error < bestError)
+			{
+				bestError = error;
+				best = e;
+			}
+		}
+
+		fit.indices[i] = static_cast<unsigned char>(best);
+		fit.error += bestError;
+	}
+}
+
+// Solves for the endpoints which minimise the error of the current indices
+bool refineEndpoints(const Block& block, const bool* active, bool threeColourMode,
+					 const ColourFit& fit, Colour& end0, Colour& end1)
+{
+	// Weight of the first endpoint for each index
+	static const float WEIGHTS_4[4] = { 1.0f, 0.0f, 2.0f / 3, 1.0f / 3 };
+	static const float WEIGHTS_3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+
+	const float* weights = threeColourMode ? WEIGHTS_3 : WEIGHTS_4;
+
+	float aa = 0, ab = 0, bb = 0;
+	Colour ax, bx;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!active[i] || (threeColourMode && fit.indices[i] == 3)) continue;
+
+		float a = weights[fit.indices[i]];
+		float b = 1.0f - a;
+
+		Colour colour(block.pixels[i][0], block.pixels[i][1], block.pixels[i][2]);
+
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+
+		ax = ax + colour * a;
+		bx = bx + colour * b;
+	}
+
+	float det = aa * bb - ab * ab;
+
+	if (std::fabs(det) < 1e-6f) return false;
+
+	float inv = 1.0f / det;
+
+	end0 = (ax * bb - bx * ab) * inv;
+	end1 = (bx * aa - ax * ab) * inv;
+
+	return true;
+}
+
+void encodeColourBlock(const Block& block, bool punchThrough, byte* out)
+{
+	bool active[16];
+	int numActive = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		active[i] = !punchThrough || block.pixels[i][3] >= 128;
+
+		if (active[i]) ++numActive;
+	}
+
+	// Blocks with transparent pixels use the 3 colour mode, index 3 is transparent
+	bool threeColourMode = punchThrough && numActive < 16;
+
+	ColourFit fit;
+
+	if (numActive == 0)
+	{
+		fit.c0 = fit.c1 = 0;
+		std::fill(fit.indices, fit.indices + 16, 3);
+	}
+	else
+	{
+		// Principal axis of the colours, by power iteration on the covariance matrix
+		Colour mean;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (active[i]) mean = mean + Colour(block.pixels[i][0], block.pixels[i][1], block.pixels[i][2]);
+		}
+
+		mean = mean * (1.0f / numActive);
+
+		float cov[6] = { 0, 0, 0, 0, 0, 0 }; // rr rg rb gg gb bb
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (!active[i]) continue;
+
+			Colour d = Colour(block.pixels[i][0], block.pixels[i][1], block.pixels[i][2]) - mean;
+
+			cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+			cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+		}
+
+		Colour axis(1, 1, 1);
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			Colour next(
+				cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+				cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+				cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b
+			);
+
+			float length = std::sqrt(next.dot(next));
+
+			if (length < 1e-6f) break; // uniform colour
+
+			axis = next * (1.0f / length);
+		}
+
+		float minT = 0, maxT = 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			if (!active[i]) continue;
+
+			float t = (Colour(block.pixels[i][0], block.pixels[i][1], block.pixels[i][2]) - mean).dot(axis);
+
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		fit.c0 = packColour(mean + axis * maxT);
+		fit.c1 = packColour(mean + axis * minT);
+
+		assignIndices(block, active, threeColourMode, fit);
+
+		for (int iteration = 0; iteration < REFINE_ITERATIONS && fit.error > 0; ++iteration)
+		{
+			Colour end0, end1;
+
+			if (!refineEndpoints(block, active, threeColourMode, fit, end0, end1)) break;
+
+			ColourFit refined;
+			refined.c0 = packColour(end0);
+			refined.c1 = packColour(end1);
+
+			assignIndices(block, active, threeColourMode, refined);
+
+			if (refined.error >= fit.error) break;
+
+			fit = refined;
+		}
+
+		// The endpoint order selects the mode in the decoder
+		if (threeColourMode)
+		{
+			if (fit.c0 > fit.c1)
+			{
+				std::swap(fit.c0, fit.c1);
+
+				for (int i = 0; i < 16; ++i)
+				{
+					if (fit.indices[i] < 2) fit.indices[i] ^= 1;
+				}
+			}
+		}
+		else if (fit.c0 < fit.c1)
+		{
+			std::swap(fit.c0, fit.c1);
+
+			for (int i = 0; i < 16; ++i)
+			{
+				fit.indices[i] ^= 1;
+			}
+		}
+		else if (fit.c0 == fit.c1)
+		{
+			// Would be decoded in 3 colour mode, only the first entry is safe
+			std::fill(fit.indices, fit.indices + 16, 0);
+		}
+	}
+
+	unsigned int indices = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		indices |= static_cast<unsigned int>(fit.indices[i]) << (i * 2);
+	}
+
+	out[0] = static_cast<byte>(fit.c0 & 0xff);
+	out[1] = static_cast<byte>(fit.c0 >> 8);
+	out[2] = static_cast<byte>(fit.c1 & 0xff);
+	out[3] = static_cast<byte>(fit.c1 >> 8);
+	out[4] = static_cast<byte>(indices & 0xff);
+	out[5] = static_cast<byte>((indices >> 8) & 0xff);
+	out[6] = static_cast<byte>((indices >> 16) & 0xff);
+	out[7] = static_cast<byte>(indices >> 24);
+}
+
+void buildAlphaPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; ++i)
+		{
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		}
+	}
+	else
+	{
+		for (int i = 1; i < 5; ++i)
+		{
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		}
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+void encodeAlphaBlock(const Block& block, byte* out)
+{
+	int maxAlpha = 0;
+	int minAlpha = 255;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		maxAlpha = std::max<int>(maxAlpha, block.pixels[i][3]);
+		minAlpha = std::min<int>(minAlpha, block.pixels[i][3]);
+	}
+
+	out[0] = static_cast<byte>(maxAlpha);
+	out[1] = static_cast<byte>(minAlpha);
+
+	// 8 alpha mode, unless all values are the same (index 0 everywhere)
+	int palette[8];
+	buildAlphaPalette(maxAlpha, minAlpha, palette);
+
+	unsigned long long indices = 0;
+
+	if (maxAlpha > minAlpha)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			int bestError = 256;
+
+			for (int e = 0; e < 8; ++e)
+			{
+				int error = std::abs(block.pixels[i][3] - palette[e]);
+
+				if (error < bestError)
+				{
+					bestError = error;
+					best = e;
+				}
+			}
+
+			indices |= static_cast<unsigned long long>(best) << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; ++i)
+	{
+		out[2 + i] = static_cast<byte>((indices >> (i * 8)) & 0xff);
+	}
+}
+
+void decodeColourBlock(const byte* in, bool allowThreeColourMode, byte pixels[16][4])
+{
+	unsigned short c0 = static_cast<unsigned short>(in[0] | (in[1] << 8));
+	unsigned short c1 = static_cast<unsigned short>(in[2] | (in[3] << 8));
+
+	bool threeColourMode = allowThreeColourMode && c0 <= c1;
+
+	int palette[4][3];
+	buildPalette(c0, c1, threeColourMode, palette);
+
+	unsigned int indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<unsigned int>(in[7]) << 24);
+
+	for (int i = 0; i < 16; ++i)
+	{
+		int index = (indices >> (i * 2)) & 3;
+
+		pixels[i][0] = static_cast<byte>(palette[index][0]);
+		pixels[i][1] = static_cast<byte>(palette[index][1]);
+		pixels[i][2] = static_cast<byte>(palette[index][2]);
+		pixels[i][3] = (threeColourMode && index == 3) ? 0 : 255;
+	}
+}
+
+void decodeAlphaBlock(const byte* in, byte pixels[16][4])
+{
+	int palette[8];
+	buildAlphaPalette(in[0], in[1], palette);
+
+	unsigned long long indices = 0;
+
+	for (int i = 0; i < 6; ++i)
+	{
+		indices |= static_cast<unsigned long long>(in[2 + i]) << (i * 8);
+	}
+
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels[i][3] = static_cast<byte>(palette[(indices >> (i * 3)) & 7]);
+	}
+}
+
+inline std::size_t getNumBlocks(std::size_t size)
+{
+	return std::max<std::size_t>(1, (size + 3) / 4);
+}
+
+inline std::size_t getBlockSize(DXTFormat format)
+{
+	return format == DXT_FORMAT_DXT1 ? 8 : 16;
+}
+
+} // namespace
+
+std::size_t getCompressedSize(DXTFormat format, std::size_t width, std::size_t height)
+{
+	return getNumBlocks(width) * getNumBlocks(height) * getBlockSize(format);
+}
+
+void compressDXT(DXTFormat format, const byte* pixels, std::size_t width, std::size_t height, byte* out)
+{
+	std::size_t blocksX = getNumBlocks(width);
+	std::size_t blocksY = getNumBlocks(height);
+
+	for (std::size_t by = 0; by < blocksY; ++by)
+	{
+		for (std::size_t bx = 0; bx < blocksX; ++bx)
+		{
+			Block block(pixels, width, height, bx, by);
+
+			if (format == DXT_FORMAT_DXT1)
+			{
+				encodeColourBlock(block, true, out);
+				out += 8;
+			}
+			else
+			{
+				encodeAlphaBlock(block, out);
+				encodeColourBlock(block, false, out + 8);
+				out += 16;
+			}
+		}
+	}
+}
+
+void decompressDXT(DXTFormat format, const byte* data, std::size_t width, std::size_t height, byte* out)
+{
+	std::size_t blocksX = getNumBlocks(width);
+	std::size_t blocksY = getNumBlocks(height);
+
+	for (std::size_t by = 0; by < blocksY; ++by)
+	{
+		for (std::size_t bx = 0; bx < blocksX; ++bx)
+		{
+			byte pixels[16][4];
+
+			if (format == DXT_FORMAT_DXT1)
+			{
+				decodeColourBlock(data, true, pixels);
+				data += 8;
+			}
+			else
+			{
+				// The colour block of DXT5 is always in 4 colour mode
+				decodeColourBlock(data + 8, false, pixels);
+				decodeAlphaBlock(data, pixels);
+				data += 16;
+			}
+
+			// Copy the part of the block inside the image
+			for (std::size_t y = 0; y < 4 && by * 4 + y < height; ++y)
+			{
+				for (std::size_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+				{
+					std::memcpy(out + ((by * 4 + y) * width + bx * 4 + x) * 4, pixels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+bool hasTransparency(const byte* pixels, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i)
+	{
+		if (pixels[i * 4 + 3] != 255) return true;
+	}
+
+	return false;
+}
+
+} // namespace image
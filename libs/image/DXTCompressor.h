@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ImageKernels.h"
+
+/**
+ * Compresses 8 bit RGBA images into the S3TC formats DXT1 and DXT5,
+ * which can be uploaded with glCompressedTexImage2D like the DDS images.
+ *
+ * The encoder fits the colour endpoints of each 4x4 block to the principal
+ * axis of its colours, followed by a least squares refinement. It's meant
+ * for textures loaded in the background, not for offline tools.
+ */
+namespace image
+{
+
+enum DXTFormat
+{
+	// RGB with 1 bit alpha, 8 bytes per block
+	DXT_FORMAT_DXT1,
+
+	// RGB with interpolated alpha, 16 bytes per block
+	DXT_FORMAT_DXT5
+};
+
+// Returns the number of bytes needed to store an image of the given size
+std::size_t getCompressedSize(DXTFormat format, std::size_t width, std::size_t height);
+
+/**
+ * Compresses the given image, the output buffer needs to be at least
+ * getCompressedSize() bytes large. Pixels with an alpha value below 128
+ * are stored as transparent in DXT1.
+ */
+void compressDXT(DXTFormat format, const byte* pixels, std::size_t width, std::size_t height, byte* out);
+
+// The inverse of compressDXT, writes width * height RGBA pixels
+void decompressDXT(DXTFormat format, const byte* data, std::size_t width, std::size_t height, byte* out);
+
+// Returns true if any pixel is not fully opaque, such images need DXT5
+bool hasTransparency(const byte* pixels, std::size_t numPixels);
+
+} // namespace image
@@ -0,0 +1,420 @@
+#include "ImageKernels.h"
+#include "ScalarKernels.h"
+
+#include <vector>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(IMAGE_KERNELS_X86)
+#include <intrin.h>
+#endif
+
+namespace image
+{
+
+namespace
+{
+
+void applyGammaTable(byte* pixels, std::size_t numPixels, const byte* table)
+{
+	for (byte* end = pixels + numPixels * 4; pixels != end; pixels += 4)
+	{
+		pixels[0] = table[pixels[0]];
+		pixels[1] = table[pixels[1]];
+		pixels[2] = table[pixels[2]];
+	}
+}
+
+void mipReduce(const byte* in, byte* out, std::size_t width, std::size_t height,
+			   bool reduceWidth, bool reduceHeight)
+{
+	std::size_t x, y, width2, height2, nextrow;
+
+	if (reduceWidth && reduceHeight)
+	{
+		width2 = width >> 1;
+		height2 = height >> 1;
+		nextrow = width << 2;
+
+		for (y = 0; y < height2; y++)
+		{
+			for (x = 0; x < width2; x++)
+			{
+				out[0] = (byte) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
+				out[1] = (byte) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
+				out[2] = (byte) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
+				out[3] = (byte) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
+				out += 4;
+				in += 8;
+			}
+			in += nextrow; // skip a line
+		}
+	}
+	else if (reduceWidth)
+	{
+		width2 = width >> 1;
+
+		for (y = 0; y < height; y++)
+		{
+			for (x = 0; x < width2; x++)
+			{
+				out[0] = (byte) ((in[0] + in[4]) >> 1);
+				out[1] = (byte) ((in[1] + in[5]) >> 1);
+				out[2] = (byte) ((in[2] + in[6]) >> 1);
+				out[3] = (byte) ((in[3] + in[7]) >> 1);
+				out += 4;
+				in += 8;
+			}
+		}
+	}
+	else if (reduceHeight)
+	{
+		height2 = height >> 1;
+		nextrow = width << 2;
+
+		for (y = 0; y < height2; y++)
+		{
+			for (x = 0; x < width; x++)
+			{
+				out[0] = (byte) ((in[0] + in[nextrow  ]) >> 1);
+				out[1] = (byte) ((in[1] + in[nextrow+1]) >> 1);
+				out[2] = (byte) ((in[2] + in[nextrow+2]) >> 1);
+				out[3] = (byte) ((in[3] + in[nextrow+3]) >> 1);
+				out += 4;
+				in += 4;
+			}
+			in += nextrow; // skip a line
+		}
+	}
+}
+
+void resampleLine(const byte* in, byte* out, std::size_t inWidth, std::size_t outWidth)
+{
+	std::size_t j, xi, oldx = 0, f, lerp;
+
+	std::size_t fstep = static_cast<std::size_t>(inWidth * 65536.0f / outWidth);
+	std::size_t endx = (inWidth - 1);
+
+	for (j = 0, f = 0; j < outWidth; j++, f += fstep)
+	{
+		xi = f >> 16;
+
+		if (xi != oldx)
+		{
+			in += (xi - oldx) * 4;
+			oldx = xi;
+		}
+
+		if (xi < endx)
+		{
+			lerp = f & 0xFFFF;
+			*out++ = (byte) ((((in[4] - in[0]) * lerp) >> 16) + in[0]);
+			*out++ = (byte) ((((in[5] - in[1]) * lerp) >> 16) + in[1]);
+			*out++ = (byte) ((((in[6] - in[2]) * lerp) >> 16) + in[2]);
+			*out++ = (byte) ((((in[7] - in[3]) * lerp) >> 16) + in[3]);
+		}
+		else // last pixel of the line has no pixel to lerp to
+		{
+			*out++ = in[0];
+			*out++ = in[1];
+			*out++ = in[2];
+			*out++ = in[3];
+		}
+	}
+}
+
+void lerpRows(const byte* row1, const byte* row2, byte* out, std::size_t numBytes, std::size_t lerp)
+{
+	for (std::size_t i = 0; i < numBytes; ++i)
+	{
+		out[i] = (byte) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i]);
+	}
+}
+
+void average(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels * 4; ++i)
+	{
+		out[i] = float_to_integer((static_cast<float>(in1[i]) + in2[i]) * 0.5f);
+	}
+}
+
+void addNormals(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in1 += 4, in2 += 4, out += 4)
+	{
+		out[0] = float_to_integer((static_cast<double>(in1[0]) + in2[0]) * 0.5);
+		out[1] = float_to_integer((static_cast<double>(in1[1]) + in2[1]) * 0.5);
+		out[2] = float_to_integer((static_cast<double>(in1[2]) + in2[2]) * 0.5);
+		out[3] = 255;
+	}
+}
+
+void scale(const byte* in, byte* out, std::size_t numPixels, const float* factors)
+{
+	for (std::size_t i = 0; i < numPixels * 4; ++i)
+	{
+		int value = float_to_integer(static_cast<float>(in[i]) * factors[i & 3]);
+		out[i] = (value > 255) ? 255 : value;
+	}
+}
+
+void invertAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		out[3] = 255 - in[3];
+	}
+}
+
+void invertColor(const byte* in, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		out[0] = 255 - in[0];
+		out[1] = 255 - in[1];
+		out[2] = 255 - in[2];
+		out[3] = in[3];
+	}
+}
+
+void makeIntensity(const byte* in, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		out[0] = in[0];
+		out[1] = in[0];
+		out[2] = in[0];
+		out[3] = in[0];
+	}
+}
+
+void makeAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		out[0] = 255;
+		out[1] = 255;
+		out[2] = 255;
+		out[3] = (in[0] + in[1] + in[2]) / 3;
+	}
+}
+
+void smoothNormals(const byte* in, byte* out, std::size_t width, std::size_t height)
+{
+	for (std::size_t y = 0; y < height; ++y)
+	{
+		for (std::size_t x = 0; x < width; ++x, out += 4)
+		{
+			detail::smoothNormalsPixel(in, out, width, height, x, y);
+		}
+	}
+}
+
+void heightmapToNormalmap(const byte* in, byte* out, std::size_t width, std::size_t height, float scale)
+{
+	for (std::size_t y = 0; y < height; ++y)
+	{
+		for (std::size_t x = 0; x < width; ++x, out += 4)
+		{
+			detail::heightmapToNormalmapPixel(in, out, width, height, x, y, scale);
+		}
+	}
+}
+
+ImageKernels createScalarKernels()
+{
+	ImageKernels kernels;
+
+	kernels.name = "Scalar";
+	kernels.applyGammaTable = applyGammaTable;
+	kernels.mipReduce = mipReduce;
+	kernels.resampleLine = resampleLine;
+	kernels.lerpRows = lerpRows;
+	kernels.average = average;
+	kernels.addNormals = addNormals;
+	kernels.scale = scale;
+	kernels.invertAlpha = invertAlpha;
+	kernels.invertColor = invertColor;
+	kernels.makeIntensity = makeIntensity;
+	kernels.makeAlpha = makeAlpha;
+	kernels.smoothNormals = smoothNormals;
+	kernels.heightmapToNormalmap = heightmapToNormalmap;
+
+	return kernels;
+}
+
+#if defined(IMAGE_KERNELS_X86)
+
+bool cpuSupportsSSE2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true; // part of the x86-64 baseline
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+
+bool cpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+
+	if (info[0] < 7) return false;
+
+	// The OS needs to save the YMM registers
+	__cpuid(info, 1);
+
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	// This checks the OS support for the YMM registers too
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+// The kernel tables, set up on first use
+struct KernelTables
+{
+	ImageKernels scalar;
+	ImageKernels sse2;
+	ImageKernels avx2;
+
+	bool hasSSE2;
+	bool hasAVX2;
+
+	KernelTables() :
+		scalar(createScalarKernels()),
+		sse2(scalar),
+		avx2(scalar),
+		hasSSE2(false),
+		hasAVX2(false)
+	{
+#if defined(IMAGE_KERNELS_X86)
+		hasSSE2 = cpuSupportsSSE2();
+		hasAVX2 = hasSSE2 && cpuSupportsAVX2();
+
+		// Each level falls back to the previous one for the kernels
+		// it doesn't implement
+		detail::fillSSE2Kernels(sse2);
+
+		avx2 = sse2;
+		detail::fillAVX2Kernels(avx2);
+#endif
+	}
+
+	static const KernelTables& Instance()
+	{
+		static KernelTables _tables;
+		return _tables;
+	}
+};
+
+} // namespace
+
+const ImageKernels& getKernels()
+{
+	const KernelTables& tables = KernelTables::Instance();
+
+	if (tables.hasAVX2) return tables.avx2;
+	if (tables.hasSSE2) return tables.sse2;
+
+	return tables.scalar;
+}
+
+const ImageKernels& getScalarKernels()
+{
+	return KernelTables::Instance().scalar;
+}
+
+const ImageKernels* getSSE2Kernels()
+{
+	const KernelTables& tables = KernelTables::Instance();
+
+	return tables.hasSSE2 ? &tables.sse2 : NULL;
+}
+
+const ImageKernels* getAVX2Kernels()
+{
+	const KernelTables& tables = KernelTables::Instance();
+
+	return tables.hasAVX2 ? &tables.avx2 : NULL;
+}
+
+void resample(const byte* in, std::size_t inWidth, std::size_t inHeight,
+			  byte* out, std::size_t outWidth, std::size_t outHeight,
+			  const ImageKernels& kernels)
+{
+	if (inWidth == 0 || inHeight == 0 || outWidth == 0 || outHeight == 0) return;
+
+	std::size_t inWidth4 = inWidth * 4;
+	std::size_t outWidth4 = outWidth * 4;
+
+	// The horizontally resampled input rows around the current output row
+	std::vector<byte> row1(outWidth4);
+	std::vector<byte> row2(outWidth4);
+
+	std::size_t fstep = static_cast<int>(inHeight * 65536.0f / outHeight);
+	std::size_t endy = inHeight - 1;
+	std::size_t oldy = 0;
+
+	kernels.resampleLine(in, &row1.front(), inWidth, outWidth);
+
+	if (inHeight > 1)
+	{
+		kernels.resampleLine(in + inWidth4, &row2.front(), inWidth, outWidth);
+	}
+
+	std::size_t f = 0;
+
+	for (std::size_t i = 0; i < outHeight; ++i, f += fstep, out += outWidth4)
+	{
+		std::size_t yi = f >> 16;
+
+		if (yi != oldy)
+		{
+			const byte* inrow = in + inWidth4 * yi;
+
+			if (yi == oldy + 1)
+			{
+				row1.swap(row2);
+			}
+			else
+			{
+				kernels.resampleLine(inrow, &row1.front(), inWidth, outWidth);
+			}
+
+			if (yi < endy)
+			{
+				kernels.resampleLine(inrow + inWidth4, &row2.front(), inWidth, outWidth);
+			}
+
+			oldy = yi;
+		}
+
+		if (yi < endy)
+		{
+			kernels.lerpRows(&row1.front(), &row2.front(), out, outWidth4, f & 0xFFFF);
+		}
+		else
+		{
+			std::memcpy(out, &row1.front(), outWidth4);
+		}
+	}
+}
+
+} // namespace image
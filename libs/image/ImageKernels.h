@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Pixel processing kernels used by the texture manipulation code and
+ * the map expressions. All buffers are 8 bit RGBA unless stated otherwise.
+ *
+ * Each kernel exists as portable scalar reference implementation plus SSE2
+ * and AVX2 variants, the best one supported by the CPU is selected at
+ * runtime. The vectorised variants produce the same output as the reference,
+ * heightmapToNormalmap may differ by one where the compiler contracts the
+ * floating point operations of the reference differently.
+ */
+namespace image
+{
+
+typedef unsigned char byte;
+
+struct ImageKernels
+{
+	// Name of the instruction set, for diagnostics
+	const char* name;
+
+	// Replaces the RGB values with the corresponding entries of the
+	// given 256 byte table, alpha is left alone
+	void (*applyGammaTable)(byte* pixels, std::size_t numPixels, const byte* table);
+
+	// Halves the image in the given directions by averaging the pixels,
+	// in and out may point to the same buffer
+	void (*mipReduce)(const byte* in, byte* out, std::size_t width, std::size_t height,
+					  bool reduceWidth, bool reduceHeight);
+
+	// Linearly resamples one line of pixels to the given width
+	void (*resampleLine)(const byte* in, byte* out, std::size_t inWidth, std::size_t outWidth);
+
+	// Interpolates between two rows of bytes, lerp is a 16.16 fixed point
+	// fraction: out = row1 + (row2 - row1) * lerp / 65536
+	void (*lerpRows)(const byte* row1, const byte* row2, byte* out,
+					 std::size_t numBytes, std::size_t lerp);
+
+	// Average of the two images in all four channels (add expression)
+	void (*average)(const byte* in1, const byte* in2, byte* out, std::size_t numPixels);
+
+	// Average of the two normal maps, alpha is set to 255 (addnormals expression)
+	void (*addNormals)(const byte* in1, const byte* in2, byte* out, std::size_t numPixels);
+
+	// Multiplies the four channels with the given factors, clamped to 255
+	void (*scale)(const byte* in, byte* out, std::size_t numPixels, const float* factors);
+
+	void (*invertAlpha)(const byte* in, byte* out, std::size_t numPixels);
+	void (*invertColor)(const byte* in, byte* out, std::size_t numPixels);
+
+	// Copies the red channel to all four channels
+	void (*makeIntensity)(const byte* in, byte* out, std::size_t numPixels);
+
+	// White image with the average of the RGB channels as alpha
+	void (*makeAlpha)(const byte* in, byte* out, std::size_t numPixels);
+
+	// Average over the 3x3 neighbourhood of each pixel, wrapping around
+	// the borders, alpha is set to 255 (smoothnormals expression)
+	void (*smoothNormals)(const byte* in, byte* out, std::size_t width, std::size_t height);
+
+	// Converts the red channel of the heightmap into a normal map, using
+	// a 3x3 Prewitt filter and wrapping around the borders
+	void (*heightmapToNormalmap)(const byte* in, byte* out, std::size_t width,
+								 std::size_t height, float scale);
+};
+
+// Returns the fastest kernels supported by this CPU
+const ImageKernels& getKernels();
+
+// The portable reference implementation
+const ImageKernels& getScalarKernels();
+
+// Return NULL if the instruction set is not supported by the CPU or the build
+const ImageKernels* getSSE2Kernels();
+const ImageKernels* getAVX2Kernels();
+
+/**
+ * Resamples the given image to the target dimensions using bilinear
+ * interpolation in 16.16 fixed point, using the given kernels.
+ */
+void resample(const byte* in, std::size_t inWidth, std::size_t inHeight,
+			  byte* out, std::size_t outWidth, std::size_t outHeight,
+			  const ImageKernels& kernels = getKernels());
+
+} // namespace image
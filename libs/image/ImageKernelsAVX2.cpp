@@ -0,0 +1,391 @@
+#include "ScalarKernels.h"
+
+#if defined(IMAGE_KERNELS_X86)
+
+#include <immintrin.h>
+
+namespace image
+{
+
+namespace
+{
+
+// See the SSE2 variant in ImageKernelsSSE2.cpp
+IMAGE_KERNELS_TARGET_AVX2
+inline __m256i mulLerp(__m256i diff, __m256i lerp)
+{
+	__m256i product = _mm256_mulhi_epi16(diff, lerp);
+	__m256i correction = _mm256_and_si256(diff, _mm256_srai_epi16(lerp, 15));
+
+	return _mm256_add_epi16(product, correction);
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+inline __m256i averageRoundEven(__m256i a, __m256i b)
+{
+	const __m256i low7 = _mm256_set1_epi8(0x7f);
+	const __m256i one = _mm256_set1_epi8(1);
+
+	__m256i x = _mm256_xor_si256(a, b);
+	__m256i floorAvg = _mm256_add_epi8(_mm256_and_si256(a, b), _mm256_and_si256(_mm256_srli_epi16(x, 1), low7));
+	__m256i roundUp = _mm256_and_si256(_mm256_and_si256(x, floorAvg), one);
+
+	return _mm256_add_epi8(floorAvg, roundUp);
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+inline __m256i load(const byte* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+inline void store(byte* p, __m256i value)
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), value);
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void mipReduce(const byte* in, byte* out, std::size_t width, std::size_t height,
+			   bool reduceWidth, bool reduceHeight)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	// The AVX2 unpack and pack instructions work within 128 bit lanes,
+	// the horizontal reductions leave the output pixels in the order
+	// 0 1 4 5 2 3 6 7 which is fixed by a single permutation
+	if (reduceWidth && reduceHeight)
+	{
+		std::size_t width2 = width >> 1;
+		std::size_t height2 = height >> 1;
+		std::size_t nextrow = width << 2;
+
+		for (std::size_t y = 0; y < height2; ++y)
+		{
+			const byte* row = in + y * (width2 * 8 + nextrow);
+			byte* outRow = out + y * width2 * 4;
+
+			std::size_t x = 0;
+
+			for (; x + 8 <= width2; x += 8)
+			{
+				__m256i a0 = load(row + x * 8);
+				__m256i a1 = load(row + x * 8 + 32);
+				__m256i b0 = load(row + nextrow + x * 8);
+				__m256i b1 = load(row + nextrow + x * 8 + 32);
+
+				__m256i s0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero), _mm256_unpacklo_epi8(b0, zero));
+				__m256i s1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero), _mm256_unpackhi_epi8(b0, zero));
+				__m256i s2 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero), _mm256_unpacklo_epi8(b1, zero));
+				__m256i s3 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero), _mm256_unpackhi_epi8(b1, zero));
+
+				__m256i q0 = _mm256_add_epi16(_mm256_unpacklo_epi64(s0, s1), _mm256_unpackhi_epi64(s0, s1));
+				__m256i q1 = _mm256_add_epi16(_mm256_unpacklo_epi64(s2, s3), _mm256_unpackhi_epi64(s2, s3));
+
+				__m256i result = _mm256_packus_epi16(_mm256_srli_epi16(q0, 2), _mm256_srli_epi16(q1, 2));
+
+				store(outRow + x * 4, _mm256_permute4x64_epi64(result, 0xD8));
+			}
+
+			for (; x < width2; ++x)
+			{
+				const byte* p = row + x * 8;
+				byte* o = outRow + x * 4;
+
+				o[0] = (byte) ((p[0] + p[4] + p[nextrow  ] + p[nextrow+4]) >> 2);
+				o[1] = (byte) ((p[1] + p[5] + p[nextrow+1] + p[nextrow+5]) >> 2);
+				o[2] = (byte) ((p[2] + p[6] + p[nextrow+2] + p[nextrow+6]) >> 2);
+				o[3] = (byte) ((p[3] + p[7] + p[nextrow+3] + p[nextrow+7]) >> 2);
+			}
+		}
+	}
+	else if (reduceWidth)
+	{
+		std::size_t width2 = width >> 1;
+		std::size_t total = width2 * height;
+
+		std::size_t i = 0;
+
+		for (; i + 8 <= total; i += 8)
+		{
+			__m256i a0 = load(in + i * 8);
+			__m256i a1 = load(in + i * 8 + 32);
+
+			__m256i s0 = _mm256_unpacklo_epi8(a0, zero);
+			__m256i s1 = _mm256_unpackhi_epi8(a0, zero);
+			__m256i s2 = _mm256_unpacklo_epi8(a1, zero);
+			__m256i s3 = _mm256_unpackhi_epi8(a1, zero);
+
+			__m256i q0 = _mm256_add_epi16(_mm256_unpacklo_epi64(s0, s1), _mm256_unpackhi_epi64(s0, s1));
+			__m256i q1 = _mm256_add_epi16(_mm256_unpacklo_epi64(s2, s3), _mm256_unpackhi_epi64(s2, s3));
+
+			__m256i result = _mm256_packus_epi16(_mm256_srli_epi16(q0, 1), _mm256_srli_epi16(q1, 1));
+
+			store(out + i * 4, _mm256_permute4x64_epi64(result, 0xD8));
+		}
+
+		for (; i < total; ++i)
+		{
+			const byte* p = in + i * 8;
+			byte* o = out + i * 4;
+
+			o[0] = (byte) ((p[0] + p[4]) >> 1);
+			o[1] = (byte) ((p[1] + p[5]) >> 1);
+			o[2] = (byte) ((p[2] + p[6]) >> 1);
+			o[3] = (byte) ((p[3] + p[7]) >> 1);
+		}
+	}
+	else if (reduceHeight)
+	{
+		const __m256i low7 = _mm256_set1_epi8(0x7f);
+
+		std::size_t height2 = height >> 1;
+		std::size_t nextrow = width << 2;
+
+		for (std::size_t y = 0; y < height2; ++y)
+		{
+			const byte* row = in + y * nextrow * 2;
+			byte* outRow = out + y * nextrow;
+
+			std::size_t i = 0;
+
+			for (; i + 32 <= nextrow; i += 32)
+			{
+				__m256i a = load(row + i);
+				__m256i b = load(row + nextrow + i);
+
+				store(outRow + i, _mm256_add_epi8(_mm256_and_si256(a, b),
+					_mm256_and_si256(_mm256_srli_epi16(_mm256_xor_si256(a, b), 1), low7)));
+			}
+
+			for (; i < nextrow; ++i)
+			{
+				outRow[i] = (byte) ((row[i] + row[nextrow + i]) >> 1);
+			}
+		}
+	}
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void lerpRows(const byte* row1, const byte* row2, byte* out, std::size_t numBytes, std::size_t lerp)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lerpVec = _mm256_set1_epi16(static_cast<short>(lerp));
+
+	std::size_t i = 0;
+
+	for (; i + 32 <= numBytes; i += 32)
+	{
+		__m256i a = load(row1 + i);
+		__m256i b = load(row2 + i);
+
+		__m256i aLo = _mm256_unpacklo_epi8(a, zero);
+		__m256i aHi = _mm256_unpackhi_epi8(a, zero);
+
+		__m256i lo = _mm256_add_epi16(aLo, mulLerp(_mm256_sub_epi16(_mm256_unpacklo_epi8(b, zero), aLo), lerpVec));
+		__m256i hi = _mm256_add_epi16(aHi, mulLerp(_mm256_sub_epi16(_mm256_unpackhi_epi8(b, zero), aHi), lerpVec));
+
+		// Unpacking and packing within the same lanes keeps the byte order
+		store(out + i, _mm256_packus_epi16(lo, hi));
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		out[i] = (byte) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i]);
+	}
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void average(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	std::size_t numBytes = numPixels * 4;
+	std::size_t i = 0;
+
+	for (; i + 32 <= numBytes; i += 32)
+	{
+		store(out + i, averageRoundEven(load(in1 + i), load(in2 + i)));
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		out[i] = float_to_integer((static_cast<float>(in1[i]) + in2[i]) * 0.5f);
+	}
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void addNormals(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	const __m256i alpha = _mm256_set1_epi32(0xff000000);
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= numPixels; i += 8)
+	{
+		store(out + i * 4, _mm256_or_si256(averageRoundEven(load(in1 + i * 4), load(in2 + i * 4)), alpha));
+	}
+
+	for (; i < numPixels; ++i)
+	{
+		const byte* a = in1 + i * 4;
+		const byte* b = in2 + i * 4;
+		byte* o = out + i * 4;
+
+		o[0] = float_to_integer((static_cast<double>(a[0]) + b[0]) * 0.5);
+		o[1] = float_to_integer((static_cast<double>(a[1]) + b[1]) * 0.5);
+		o[2] = float_to_integer((static_cast<double>(a[2]) + b[2]) * 0.5);
+		o[3] = 255;
+	}
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void scale(const byte* in, byte* out, std::size_t numPixels, const float* factors)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256 factorVec = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(factors));
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= numPixels; i += 8)
+	{
+		__m256i pixels = load(in + i * 4);
+
+		__m256i lo = _mm256_unpacklo_epi8(pixels, zero);
+		__m256i hi = _mm256_unpackhi_epi8(pixels, zero);
+
+		__m256i p0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(lo, zero)), factorVec));
+		__m256i p1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(lo, zero)), factorVec));
+		__m256i p2 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(hi, zero)), factorVec));
+		__m256i p3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(hi, zero)), factorVec));
+
+		store(out + i * 4, _mm256_packus_epi16(_mm256_packs_epi32(p0, p1), _mm256_packs_epi32(p2, p3)));
+	}
+
+	for (std::size_t b = i * 4; b < numPixels * 4; ++b)
+	{
+		int value = float_to_integer(static_cast<float>(in[b]) * factors[b & 3]);
+		out[b] = (value > 255) ? 255 : value;
+	}
+}
+
+template<typename PixelOp>
+IMAGE_KERNELS_TARGET_AVX2
+inline void forEachPixel(const byte* in, byte* out, std::size_t numPixels, const PixelOp& op)
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= numPixels; i += 8)
+	{
+		store(out + i * 4, op(load(in + i * 4)));
+	}
+
+	for (; i < numPixels; ++i)
+	{
+		__m256i pixel = _mm256_castsi128_si256(_mm_cvtsi32_si128(*reinterpret_cast<const int*>(in + i * 4)));
+		*reinterpret_cast<int*>(out + i * 4) = _mm_cvtsi128_si32(_mm256_castsi256_si128(op(pixel)));
+	}
+}
+
+struct InvertAlphaOp
+{
+	IMAGE_KERNELS_TARGET_AVX2
+	__m256i operator()(__m256i pixels) const
+	{
+		return _mm256_xor_si256(pixels, _mm256_set1_epi32(0xff000000));
+	}
+};
+
+struct InvertColorOp
+{
+	IMAGE_KERNELS_TARGET_AVX2
+	__m256i operator()(__m256i pixels) const
+	{
+		return _mm256_xor_si256(pixels, _mm256_set1_epi32(0x00ffffff));
+	}
+};
+
+struct MakeIntensityOp
+{
+	IMAGE_KERNELS_TARGET_AVX2
+	__m256i operator()(__m256i pixels) const
+	{
+		// Broadcast byte 0 of each pixel
+		const __m256i shuffle = _mm256_setr_epi8(
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12
+		);
+
+		return _mm256_shuffle_epi8(pixels, shuffle);
+	}
+};
+
+struct MakeAlphaOp
+{
+	IMAGE_KERNELS_TARGET_AVX2
+	__m256i operator()(__m256i pixels) const
+	{
+		const __m256i mask = _mm256_set1_epi32(0xff);
+
+		__m256i sum = _mm256_add_epi32(
+			_mm256_add_epi32(_mm256_and_si256(pixels, mask), _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask)),
+			_mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask)
+		);
+
+		// sum / 3, see the SSE2 variant
+		__m256i third = _mm256_srli_epi32(_mm256_mulhi_epu16(sum, _mm256_set1_epi32(43691)), 1);
+
+		return _mm256_or_si256(_mm256_slli_epi32(third, 24), _mm256_set1_epi32(0x00ffffff));
+	}
+};
+
+IMAGE_KERNELS_TARGET_AVX2
+void invertAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, InvertAlphaOp());
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void invertColor(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, InvertColorOp());
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void makeIntensity(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, MakeIntensityOp());
+}
+
+IMAGE_KERNELS_TARGET_AVX2
+void makeAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, MakeAlphaOp());
+}
+
+} // namespace
+
+namespace detail
+{
+
+void fillAVX2Kernels(ImageKernels& kernels)
+{
+	kernels.name = "AVX2";
+
+	// resampleLine, smoothNormals and heightmapToNormalmap don't gain from
+	// the wider registers and keep the SSE2 implementation. A nibble-based
+	// shuffle lookup for the gamma table turned out slower than the scalar loop.
+	kernels.mipReduce = mipReduce;
+	kernels.lerpRows = lerpRows;
+	kernels.average = average;
+	kernels.addNormals = addNormals;
+	kernels.scale = scale;
+	kernels.invertAlpha = invertAlpha;
+	kernels.invertColor = invertColor;
+	kernels.makeIntensity = makeIntensity;
+	kernels.makeAlpha = makeAlpha;
+}
+
+} // namespace detail
+
+} // namespace image
+
+#endif
@@ -0,0 +1,635 @@
+#include "ScalarKernels.h"
+
+#if defined(IMAGE_KERNELS_X86)
+
+#include <emmintrin.h>
+
+namespace image
+{
+
+namespace
+{
+
+// Computes floor(diff * lerp / 65536) for signed 16 bit differences and
+// unsigned 16 bit fractions. The multiplication treats lerp as signed,
+// which needs to be corrected for fractions >= 0.5.
+IMAGE_KERNELS_TARGET_SSE2
+inline __m128i mulLerp(__m128i diff, __m128i lerp)
+{
+	__m128i product = _mm_mulhi_epi16(diff, lerp);
+	__m128i correction = _mm_and_si128(diff, _mm_srai_epi16(lerp, 15));
+
+	return _mm_add_epi16(product, correction);
+}
+
+// Rounded average of the bytes, ties go to the even value (like lrint)
+IMAGE_KERNELS_TARGET_SSE2
+inline __m128i averageRoundEven(__m128i a, __m128i b)
+{
+	const __m128i low7 = _mm_set1_epi8(0x7f);
+	const __m128i one = _mm_set1_epi8(1);
+
+	__m128i x = _mm_xor_si128(a, b);
+
+	// floor((a + b) / 2) without overflow
+	__m128i floorAvg = _mm_add_epi8(_mm_and_si128(a, b), _mm_and_si128(_mm_srli_epi16(x, 1), low7));
+
+	// Odd sums with an odd floor are rounded up
+	__m128i roundUp = _mm_and_si128(_mm_and_si128(x, floorAvg), one);
+
+	return _mm_add_epi8(floorAvg, roundUp);
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void mipReduce(const byte* in, byte* out, std::size_t width, std::size_t height,
+			   bool reduceWidth, bool reduceHeight)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	if (reduceWidth && reduceHeight)
+	{
+		std::size_t width2 = width >> 1;
+		std::size_t height2 = height >> 1;
+		std::size_t nextrow = width << 2;
+
+		for (std::size_t y = 0; y < height2; ++y)
+		{
+			// Same row addressing as the reference, in case of odd widths
+			const byte* row = in + y * (width2 * 8 + nextrow);
+			byte* outRow = out + y * width2 * 4;
+
+			std::size_t x = 0;
+
+			// Four output pixels per iteration, the loads precede the
+			// stores so in and out may be the same buffer
+			for (; x + 4 <= width2; x += 4)
+			{
+				__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 8));
+				__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 8 + 16));
+				__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + nextrow + x * 8));
+				__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + nextrow + x * 8 + 16));
+
+				// Vertical sums of the pixel pairs, 16 bit
+				__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero)); // p0 p1
+				__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero)); // p2 p3
+				__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero)); // p4 p5
+				__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero)); // p6 p7
+
+				// Horizontal sums
+				__m128i q0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+				__m128i q1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+				__m128i result = _mm_packus_epi16(_mm_srli_epi16(q0, 2), _mm_srli_epi16(q1, 2));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow + x * 4), result);
+			}
+
+			for (; x < width2; ++x)
+			{
+				const byte* p = row + x * 8;
+				byte* o = outRow + x * 4;
+
+				o[0] = (byte) ((p[0] + p[4] + p[nextrow  ] + p[nextrow+4]) >> 2);
+				o[1] = (byte) ((p[1] + p[5] + p[nextrow+1] + p[nextrow+5]) >> 2);
+				o[2] = (byte) ((p[2] + p[6] + p[nextrow+2] + p[nextrow+6]) >> 2);
+				o[3] = (byte) ((p[3] + p[7] + p[nextrow+3] + p[nextrow+7]) >> 2);
+			}
+		}
+	}
+	else if (reduceWidth)
+	{
+		std::size_t width2 = width >> 1;
+		std::size_t total = width2 * height; // the reference treats the image as one long row
+
+		std::size_t i = 0;
+
+		for (; i + 4 <= total; i += 4)
+		{
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 8));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 8 + 16));
+
+			__m128i s0 = _mm_unpacklo_epi8(a0, zero);
+			__m128i s1 = _mm_unpackhi_epi8(a0, zero);
+			__m128i s2 = _mm_unpacklo_epi8(a1, zero);
+			__m128i s3 = _mm_unpackhi_epi8(a1, zero);
+
+			__m128i q0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+			__m128i q1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+			__m128i result = _mm_packus_epi16(_mm_srli_epi16(q0, 1), _mm_srli_epi16(q1, 1));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), result);
+		}
+
+		for (; i < total; ++i)
+		{
+			const byte* p = in + i * 8;
+			byte* o = out + i * 4;
+
+			o[0] = (byte) ((p[0] + p[4]) >> 1);
+			o[1] = (byte) ((p[1] + p[5]) >> 1);
+			o[2] = (byte) ((p[2] + p[6]) >> 1);
+			o[3] = (byte) ((p[3] + p[7]) >> 1);
+		}
+	}
+	else if (reduceHeight)
+	{
+		const __m128i low7 = _mm_set1_epi8(0x7f);
+
+		std::size_t height2 = height >> 1;
+		std::size_t nextrow = width << 2;
+
+		for (std::size_t y = 0; y < height2; ++y)
+		{
+			const byte* row = in + y * nextrow * 2;
+			byte* outRow = out + y * nextrow;
+
+			std::size_t i = 0;
+
+			for (; i + 16 <= nextrow; i += 16)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + nextrow + i));
+
+				// floor((a + b) / 2)
+				__m128i result = _mm_add_epi8(_mm_and_si128(a, b),
+					_mm_and_si128(_mm_srli_epi16(_mm_xor_si128(a, b), 1), low7));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow + i), result);
+			}
+
+			for (; i < nextrow; ++i)
+			{
+				outRow[i] = (byte) ((row[i] + row[nextrow + i]) >> 1);
+			}
+		}
+	}
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void resampleLine(const byte* in, byte* out, std::size_t inWidth, std::size_t outWidth)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	std::size_t fstep = static_cast<std::size_t>(inWidth * 65536.0f / outWidth);
+	std::size_t endx = (inWidth - 1);
+
+	std::size_t j = 0;
+	std::size_t f = 0;
+
+	// Two output pixels per iteration, as long as both have a right neighbour
+	for (; j + 1 < outWidth && ((f + fstep) >> 16) < endx; j += 2, f += fstep * 2)
+	{
+		std::size_t xiA = f >> 16;
+		std::size_t xiB = (f + fstep) >> 16;
+
+		__m128i pixelsA = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + xiA * 4));
+		__m128i pixelsB = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + xiB * 4));
+
+		__m128i a = _mm_unpacklo_epi8(pixelsA, zero); // left, right of A
+		__m128i b = _mm_unpacklo_epi8(pixelsB, zero); // left, right of B
+
+		__m128i left = _mm_unpacklo_epi64(a, b);
+		__m128i right = _mm_unpackhi_epi64(a, b);
+
+		__m128i lerp = _mm_unpacklo_epi64(
+			_mm_set1_epi16(static_cast<short>(f & 0xFFFF)),
+			_mm_set1_epi16(static_cast<short>((f + fstep) & 0xFFFF))
+		);
+
+		__m128i result = _mm_add_epi16(left, mulLerp(_mm_sub_epi16(right, left), lerp));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + j * 4), _mm_packus_epi16(result, result));
+	}
+
+	for (; j < outWidth; ++j, f += fstep)
+	{
+		std::size_t xi = f >> 16;
+		const byte* p = in + xi * 4;
+		byte* o = out + j * 4;
+
+		if (xi < endx)
+		{
+			std::size_t lerp = f & 0xFFFF;
+			o[0] = (byte) ((((p[4] - p[0]) * lerp) >> 16) + p[0]);
+			o[1] = (byte) ((((p[5] - p[1]) * lerp) >> 16) + p[1]);
+			o[2] = (byte) ((((p[6] - p[2]) * lerp) >> 16) + p[2]);
+			o[3] = (byte) ((((p[7] - p[3]) * lerp) >> 16) + p[3]);
+		}
+		else
+		{
+			o[0] = p[0];
+			o[1] = p[1];
+			o[2] = p[2];
+			o[3] = p[3];
+		}
+	}
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void lerpRows(const byte* row1, const byte* row2, byte* out, std::size_t numBytes, std::size_t lerp)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lerpVec = _mm_set1_epi16(static_cast<short>(lerp));
+
+	std::size_t i = 0;
+
+	for (; i + 16 <= numBytes; i += 16)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row2 + i));
+
+		__m128i aLo = _mm_unpacklo_epi8(a, zero);
+		__m128i aHi = _mm_unpackhi_epi8(a, zero);
+
+		__m128i lo = _mm_add_epi16(aLo, mulLerp(_mm_sub_epi16(_mm_unpacklo_epi8(b, zero), aLo), lerpVec));
+		__m128i hi = _mm_add_epi16(aHi, mulLerp(_mm_sub_epi16(_mm_unpackhi_epi8(b, zero), aHi), lerpVec));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		out[i] = (byte) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i]);
+	}
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void average(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	std::size_t numBytes = numPixels * 4;
+	std::size_t i = 0;
+
+	for (; i + 16 <= numBytes; i += 16)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in1 + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in2 + i));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), averageRoundEven(a, b));
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		out[i] = float_to_integer((static_cast<float>(in1[i]) + in2[i]) * 0.5f);
+	}
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void addNormals(const byte* in1, const byte* in2, byte* out, std::size_t numPixels)
+{
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+	std::size_t i = 0;
+
+	for (; i + 4 <= numPixels; i += 4)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in1 + i * 4));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in2 + i * 4));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_or_si128(averageRoundEven(a, b), alpha));
+	}
+
+	for (; i < numPixels; ++i)
+	{
+		const byte* a = in1 + i * 4;
+		const byte* b = in2 + i * 4;
+		byte* o = out + i * 4;
+
+		o[0] = float_to_integer((static_cast<double>(a[0]) + b[0]) * 0.5);
+		o[1] = float_to_integer((static_cast<double>(a[1]) + b[1]) * 0.5);
+		o[2] = float_to_integer((static_cast<double>(a[2]) + b[2]) * 0.5);
+		o[3] = 255;
+	}
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void scale(const byte* in, byte* out, std::size_t numPixels, const float* factors)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 factorVec = _mm_loadu_ps(factors);
+
+	std::size_t i = 0;
+
+	for (; i + 4 <= numPixels; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+
+		__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+		__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+		// One pixel per float vector, the conversion rounds to nearest even like lrint
+		__m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), factorVec));
+		__m128i p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), factorVec));
+		__m128i p2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), factorVec));
+		__m128i p3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), factorVec));
+
+		// Saturating packs clamp the values to 255
+		__m128i result = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), result);
+	}
+
+	for (std::size_t b = i * 4; b < numPixels * 4; ++b)
+	{
+		int value = float_to_integer(static_cast<float>(in[b]) * factors[b & 3]);
+		out[b] = (value > 255) ? 255 : value;
+	}
+}
+
+// Applies a 32 bit per pixel operation to all pixels, the operation
+// is a functor taking and returning a vector of four pixels
+template<typename PixelOp>
+IMAGE_KERNELS_TARGET_SSE2
+inline void forEachPixel(const byte* in, byte* out, std::size_t numPixels, const PixelOp& op)
+{
+	std::size_t i = 0;
+
+	for (; i + 4 <= numPixels; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), op(pixels));
+	}
+
+	for (; i < numPixels; ++i)
+	{
+		// Process the remaining pixels one by one, in a zeroed vector
+		__m128i pixel = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(in + i * 4));
+		int result = _mm_cvtsi128_si32(op(pixel));
+		*reinterpret_cast<int*>(out + i * 4) = result;
+	}
+}
+
+struct InvertAlphaOp
+{
+	IMAGE_KERNELS_TARGET_SSE2
+	__m128i operator()(__m128i pixels) const
+	{
+		return _mm_xor_si128(pixels, _mm_set1_epi32(0xff000000));
+	}
+};
+
+struct InvertColorOp
+{
+	IMAGE_KERNELS_TARGET_SSE2
+	__m128i operator()(__m128i pixels) const
+	{
+		return _mm_xor_si128(pixels, _mm_set1_epi32(0x00ffffff));
+	}
+};
+
+struct MakeIntensityOp
+{
+	IMAGE_KERNELS_TARGET_SSE2
+	__m128i operator()(__m128i pixels) const
+	{
+		__m128i red = _mm_and_si128(pixels, _mm_set1_epi32(0xff));
+		red = _mm_or_si128(red, _mm_slli_epi32(red, 8));
+		return _mm_or_si128(red, _mm_slli_epi32(red, 16));
+	}
+};
+
+struct MakeAlphaOp
+{
+	IMAGE_KERNELS_TARGET_SSE2
+	__m128i operator()(__m128i pixels) const
+	{
+		const __m128i mask = _mm_set1_epi32(0xff);
+
+		__m128i sum = _mm_add_epi32(
+			_mm_add_epi32(_mm_and_si128(pixels, mask), _mm_and_si128(_mm_srli_epi32(pixels, 8), mask)),
+			_mm_and_si128(_mm_srli_epi32(pixels, 16), mask)
+		);
+
+		// sum / 3 == (sum * 43691) >> 17 for all sums up to 765. The upper
+		// 16 bits of each lane are zero, so the 16 bit multiplication works.
+		__m128i third = _mm_srli_epi32(_mm_mulhi_epu16(sum, _mm_set1_epi32(43691)), 1);
+
+		return _mm_or_si128(_mm_slli_epi32(third, 24), _mm_set1_epi32(0x00ffffff));
+	}
+};
+
+IMAGE_KERNELS_TARGET_SSE2
+void invertAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, InvertAlphaOp());
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void invertColor(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, InvertColorOp());
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void makeIntensity(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, MakeIntensityOp());
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void makeAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	forEachPixel(in, out, numPixels, MakeAlphaOp());
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void smoothNormals(const byte* in, byte* out, std::size_t width, std::size_t height)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+	// The sums of nine values never hit a tie when rounding the average,
+	// so round(sum / 9) == (2 * sum + 9) / 18 == ((2 * sum + 9) * 3641) >> 16
+	const __m128i nine = _mm_set1_epi16(9);
+	const __m128i reciprocal = _mm_set1_epi16(3641);
+
+	for (std::size_t y = 0; y < height; ++y)
+	{
+		byte* outRow = out + y * width * 4;
+
+		if (y == 0 || y + 1 >= height || width < 6)
+		{
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				detail::smoothNormalsPixel(in, outRow + x * 4, width, height, x, y);
+			}
+
+			continue;
+		}
+
+		detail::smoothNormalsPixel(in, outRow, width, height, 0, y);
+
+		const byte* rows[3] = {
+			in + (y - 1) * width * 4,
+			in + y * width * 4,
+			in + (y + 1) * width * 4
+		};
+
+		std::size_t x = 1;
+
+		// Four pixels per iteration, the neighbours must not wrap around
+		for (; x + 5 <= width; x += 4)
+		{
+			__m128i sumLo = zero;
+			__m128i sumHi = zero;
+
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + (x + dx) * 4));
+
+					sumLo = _mm_add_epi16(sumLo, _mm_unpacklo_epi8(pixels, zero));
+					sumHi = _mm_add_epi16(sumHi, _mm_unpackhi_epi8(pixels, zero));
+				}
+			}
+
+			__m128i lo = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(sumLo, sumLo), nine), reciprocal);
+			__m128i hi = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(sumHi, sumHi), nine), reciprocal);
+
+			__m128i result = _mm_or_si128(_mm_packus_epi16(lo, hi), alpha);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow + x * 4), result);
+		}
+
+		for (; x < width; ++x)
+		{
+			detail::smoothNormalsPixel(in, outRow + x * 4, width, height, x, y);
+		}
+	}
+}
+
+// Loads the red channel of four pixels as floats divided by 255
+IMAGE_KERNELS_TARGET_SSE2
+inline __m128 loadHeights(const byte* pixels)
+{
+	__m128i red = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)), _mm_set1_epi32(0xff));
+	return _mm_div_ps(_mm_cvtepi32_ps(red), _mm_set1_ps(255.0f));
+}
+
+// Converts ((n + 1) * 127.5) to integers, in double precision like the reference
+IMAGE_KERNELS_TARGET_SSE2
+inline __m128i normalToInt(__m128 n)
+{
+	const __m128d factor = _mm_set1_pd(127.5);
+
+	__m128 shifted = _mm_add_ps(n, _mm_set1_ps(1.0f));
+
+	__m128i lo = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(shifted), factor));
+	__m128i hi = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(shifted, shifted)), factor));
+
+	return _mm_unpacklo_epi64(lo, hi);
+}
+
+IMAGE_KERNELS_TARGET_SSE2
+void heightmapToNormalmap(const byte* in, byte* out, std::size_t width, std::size_t height, float scale)
+{
+	const __m128 scaleVec = _mm_set1_ps(scale);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (std::size_t y = 0; y < height; ++y)
+	{
+		byte* outRow = out + y * width * 4;
+
+		if (y == 0 || y + 1 >= height || width < 6)
+		{
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				detail::heightmapToNormalmapPixel(in, outRow + x * 4, width, height, x, y, scale);
+			}
+
+			continue;
+		}
+
+		detail::heightmapToNormalmapPixel(in, outRow, width, height, 0, y, scale);
+
+		const byte* above = in + (y + 1) * width * 4;
+		const byte* row = in + y * width * 4;
+		const byte* below = in + (y - 1) * width * 4;
+
+		std::size_t x = 1;
+
+		for (; x + 5 <= width; x += 4)
+		{
+			__m128 aboveLeft = loadHeights(above + (x - 1) * 4);
+			__m128 aboveCenter = loadHeights(above + x * 4);
+			__m128 aboveRight = loadHeights(above + (x + 1) * 4);
+			__m128 left = loadHeights(row + (x - 1) * 4);
+			__m128 right = loadHeights(row + (x + 1) * 4);
+			__m128 belowLeft = loadHeights(below + (x - 1) * 4);
+			__m128 belowCenter = loadHeights(below + x * 4);
+			__m128 belowRight = loadHeights(below + (x + 1) * 4);
+
+			// Same summation order as the reference
+			__m128 du = _mm_setzero_ps();
+			du = _mm_add_ps(du, _mm_xor_ps(aboveLeft, signMask));
+			du = _mm_add_ps(du, _mm_xor_ps(left, signMask));
+			du = _mm_add_ps(du, _mm_xor_ps(belowLeft, signMask));
+			du = _mm_add_ps(du, aboveRight);
+			du = _mm_add_ps(du, right);
+			du = _mm_add_ps(du, belowRight);
+
+			__m128 dv = _mm_setzero_ps();
+			dv = _mm_add_ps(dv, aboveLeft);
+			dv = _mm_add_ps(dv, aboveCenter);
+			dv = _mm_add_ps(dv, aboveRight);
+			dv = _mm_add_ps(dv, _mm_xor_ps(belowLeft, signMask));
+			dv = _mm_add_ps(dv, _mm_xor_ps(belowCenter, signMask));
+			dv = _mm_add_ps(dv, _mm_xor_ps(belowRight, signMask));
+
+			__m128 nx = _mm_mul_ps(_mm_xor_ps(du, signMask), scaleVec);
+			__m128 ny = _mm_mul_ps(_mm_xor_ps(dv, signMask), scaleVec);
+
+			__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one);
+			__m128 norm = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+
+			__m128i red = normalToInt(_mm_mul_ps(nx, norm));
+			__m128i green = normalToInt(_mm_mul_ps(ny, norm));
+			__m128i blue = normalToInt(norm);
+
+			// Interleave the channels into RGBA pixels
+			__m128i rg = _mm_or_si128(red, _mm_slli_epi32(green, 8));
+			__m128i ba = _mm_or_si128(blue, _mm_set1_epi32(0xff00));
+
+			__m128i result = _mm_or_si128(rg, _mm_slli_epi32(ba, 16));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow + x * 4), result);
+		}
+
+		for (; x < width; ++x)
+		{
+			detail::heightmapToNormalmapPixel(in, outRow + x * 4, width, height, x, y, scale);
+		}
+	}
+}
+
+} // namespace
+
+namespace detail
+{
+
+void fillSSE2Kernels(ImageKernels& kernels)
+{
+	kernels.name = "SSE2";
+
+	// SSE2 has no byte shuffles, the gamma table lookup stays scalar
+	kernels.mipReduce = mipReduce;
+	kernels.resampleLine = resampleLine;
+	kernels.lerpRows = lerpRows;
+	kernels.average = average;
+	kernels.addNormals = addNormals;
+	kernels.scale = scale;
+	kernels.invertAlpha = invertAlpha;
+	kernels.invertColor = invertColor;
+	kernels.makeIntensity = makeIntensity;
+	kernels.makeAlpha = makeAlpha;
+	kernels.smoothNormals = smoothNormals;
+	kernels.heightmapToNormalmap = heightmapToNormalmap;
+}
+
+} // namespace detail
+
+} // namespace image
+
+#endif
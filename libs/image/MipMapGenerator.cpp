@@ -0,0 +1,300 @@
+#include "MipMapGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace image
+{
+
+namespace
+{
+
+typedef std::vector<float> FloatBuffer;
+
+const double PI = 3.14159265358979323846;
+
+// Resolution of the linear to sRGB conversion table
+const std::size_t SRGB_TABLE_SIZE = 16384;
+
+// Number of source pixels contributing to a destination pixel, per axis
+const int KAISER_TAPS = 6;
+
+// Shape of the Kaiser window and its half-width in destination pixels
+const double KAISER_ALPHA = 4.0;
+const double KAISER_WIDTH = 1.5;
+
+// Zeroth order modified Bessel function of the first kind
+double besselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; k < 32; ++k)
+	{
+		double factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+
+		if (term < sum * 1e-12) break;
+	}
+
+	return sum;
+}
+
+double sinc(double x)
+{
+	return std::fabs(x) < 1e-9 ? 1.0 : std::sin(PI * x) / (PI * x);
+}
+
+// The lookup tables, built when the library is loaded. A namespace-scope
+// object avoids initialisation races between the worker threads.
+struct FilterTables
+{
+	// sRGB byte to linear intensity
+	float toLinear[256];
+
+	// Linear intensity (scaled to the table size) to sRGB byte
+	std::vector<byte> fromLinear;
+
+	// Kaiser weights for the source pixels 2i-2 .. 2i+3
+	float kaiser[KAISER_TAPS];
+
+	FilterTables() :
+		fromLinear(SRGB_TABLE_SIZE)
+	{
+		for (std::size_t i = 0; i < 256; ++i)
+		{
+			double c = i / 255.0;
+			toLinear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+		}
+
+		for (std::size_t i = 0; i < SRGB_TABLE_SIZE; ++i)
+		{
+			double l = static_cast<double>(i) / (SRGB_TABLE_SIZE - 1);
+			double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+
+			fromLinear[i] = static_cast<byte>(std::min(255.0, std::floor(c * 255.0 + 0.5)));
+		}
+
+		// The destination pixel is centered between the source pixels 2i and 2i+1
+		double sum = 0;
+
+		for (int k = 0; k < KAISER_TAPS; ++k)
+		{
+			double x = (k - KAISER_TAPS / 2 + 0.5) / 2.0; // in destination pixels
+			double r = x / KAISER_WIDTH;
+
+			double window = besselI0(KAISER_ALPHA * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(KAISER_ALPHA);
+
+			kaiser[k] = static_cast<float>(sinc(x) * window);
+			sum += kaiser[k];
+		}
+
+		for (int k = 0; k < KAISER_TAPS; ++k)
+		{
+			kaiser[k] = static_cast<float>(kaiser[k] / sum);
+		}
+	}
+};
+
+const FilterTables tables;
+
+inline bool isPowerOfTwo(std::size_t size)
+{
+	return (size & (size - 1)) == 0;
+}
+
+inline byte toByte(float value)
+{
+	if (value <= 0) return 0;
+	if (value >= 1) return 255;
+
+	return static_cast<byte>(value * 255.0f + 0.5f);
+}
+
+inline byte linearToSRGB(float value)
+{
+	if (value <= 0) return 0;
+	if (value >= 1) return 255;
+
+	return tables.fromLinear[static_cast<std::size_t>(value * (SRGB_TABLE_SIZE - 1) + 0.5f)];
+}
+
+void toFloat(const byte* in, float* out, std::size_t numPixels, bool gammaCorrect)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			out[c] = gammaCorrect ? tables.toLinear[in[c]] : in[c] / 255.0f;
+		}
+
+		out[3] = in[3] / 255.0f;
+	}
+}
+
+void fromFloat(const float* in, byte* out, std::size_t numPixels, bool gammaCorrect)
+{
+	for (std::size_t i = 0; i < numPixels; ++i, in += 4, out += 4)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			out[c] = gammaCorrect ? linearToSRGB(in[c]) : toByte(in[c]);
+		}
+
+		out[3] = toByte(in[3]);
+	}
+}
+
+// Computes destination pixel i out of the source pixels along one axis.
+// Kaiser filtering wraps around the borders, since textures are tiling.
+inline void filterPixel(const float* in, std::size_t count, std::size_t stride,
+						std::size_t i, MipMapFilter filter, float* out)
+{
+	if (filter == MIPMAP_FILTER_BOX)
+	{
+		const float* a = in + (2 * i) * stride;
+		const float* b = in + (2 * i + 1) * stride;
+
+		for (int c = 0; c < 4; ++c)
+		{
+			out[c] = (a[c] + b[c]) * 0.5f;
+		}
+
+		return;
+	}
+
+	out[0] = out[1] = out[2] = out[3] = 0;
+
+	for (int k = 0; k < KAISER_TAPS; ++k)
+	{
+		std::ptrdiff_t j = static_cast<std::ptrdiff_t>(2 * i) + k - (KAISER_TAPS / 2 - 1);
+		std::ptrdiff_t n = static_cast<std::ptrdiff_t>(count);
+
+		j = ((j % n) + n) % n;
+
+		const float* pixel = in + j * stride;
+		float weight = tables.kaiser[k];
+
+		for (int c = 0; c < 4; ++c)
+		{
+			out[c] += pixel[c] * weight;
+		}
+	}
+}
+
+// Halves the width of the given image
+void reduceWidth(const FloatBuffer& in, FloatBuffer& out, std::size_t width, std::size_t height, MipMapFilter filter)
+{
+	std::size_t width2 = width >> 1;
+
+	out.resize(width2 * height * 4);
+
+	for (std::size_t y = 0; y < height; ++y)
+	{
+		const float* row = &in.front() + y * width * 4;
+		float* outRow = &out.front() + y * width2 * 4;
+
+		for (std::size_t x = 0; x < width2; ++x)
+		{
+			filterPixel(row, width, 4, x, filter, outRow + x * 4);
+		}
+	}
+}
+
+// Halves the height of the given image
+void reduceHeight(const FloatBuffer& in, FloatBuffer& out, std::size_t width, std::size_t height, MipMapFilter filter)
+{
+	std::size_t height2 = height >> 1;
+
+	out.resize(width * height2 * 4);
+
+	for (std::size_t y = 0; y < height2; ++y)
+	{
+		float* outRow = &out.front() + y * width * 4;
+
+		for (std::size_t x = 0; x < width; ++x)
+		{
+			filterPixel(&in.front() + x * 4, height, width * 4, y, filter, outRow + x * 4);
+		}
+	}
+}
+
+} // namespace
+
+void generateMipMaps(const byte* pixels, std::size_t width, std::size_t height,
+					 const MipMapOptions& options, MipMapChain& chain)
+{
+	chain.levels.clear();
+
+	std::size_t totalSize = 0;
+
+	for (std::size_t w = width, h = height; ; w = std::max<std::size_t>(w >> 1, 1), h = std::max<std::size_t>(h >> 1, 1))
+	{
+		MipMapLevel level;
+
+		level.width = w;
+		level.height = h;
+		level.offset = totalSize;
+		level.size = w * h * 4;
+
+		chain.levels.push_back(level);
+		totalSize += level.size;
+
+		if (w == 1 && h == 1) break;
+	}
+
+	chain.data.resize(totalSize);
+
+	std::memcpy(chain.getPixels(0), pixels, chain.levels[0].size);
+
+	if (options.filter == MIPMAP_FILTER_BOX && !options.gammaCorrect &&
+		isPowerOfTwo(width) && isPowerOfTwo(height))
+	{
+		// Integer averages are good enough here, using the image kernels
+		// (which don't handle odd dimensions)
+		const ImageKernels& kernels = getKernels();
+
+		for (std::size_t i = 1; i < chain.levels.size(); ++i)
+		{
+			const MipMapLevel& previous = chain.levels[i - 1];
+
+			kernels.mipReduce(chain.getPixels(i - 1), chain.getPixels(i),
+							  previous.width, previous.height,
+							  previous.width > 1, previous.height > 1);
+		}
+
+		return;
+	}
+
+	// Each level is computed from the unrounded values of the previous one
+	FloatBuffer current(width * height * 4);
+	FloatBuffer temp;
+
+	toFloat(pixels, &current.front(), width * height, options.gammaCorrect);
+
+	for (std::size_t i = 1; i < chain.levels.size(); ++i)
+	{
+		std::size_t w = chain.levels[i - 1].width;
+		std::size_t h = chain.levels[i - 1].height;
+
+		if (w > 1)
+		{
+			reduceWidth(current, temp, w, h, options.filter);
+			current.swap(temp);
+			w >>= 1;
+		}
+
+		if (h > 1)
+		{
+			reduceHeight(current, temp, w, h, options.filter);
+			current.swap(temp);
+			h >>= 1;
+		}
+
+		fromFloat(&current.front(), chain.getPixels(i), w * h, options.gammaCorrect);
+	}
+}
+
+} // namespace image
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ImageKernels.h"
+#include <vector>
+
+/**
+ * Generates the mipmap chain of 8 bit RGBA images on the CPU, which
+ * allows the work to be done in worker threads and the results to be cached,
+ * instead of leaving it to gluBuild2DMipmaps on the GL thread.
+ */
+namespace image
+{
+
+enum MipMapFilter
+{
+	// 2x2 average, fast
+	MIPMAP_FILTER_BOX,
+
+	// Kaiser-windowed sinc over 6x6 source pixels, keeps the smaller
+	// mipmaps sharper at the cost of some ringing
+	MIPMAP_FILTER_KAISER
+};
+
+struct MipMapOptions
+{
+	MipMapFilter filter;
+
+	// Filters the RGB channels in linear space, assuming sRGB input.
+	// Should be disabled for normal maps and other non-colour data.
+	bool gammaCorrect;
+
+	MipMapOptions() :
+		filter(MIPMAP_FILTER_BOX),
+		gammaCorrect(false)
+	{}
+};
+
+struct MipMapLevel
+{
+	std::size_t width;
+	std::size_t height;
+
+	// Location of the level's data within the chain
+	std::size_t offset;
+	std::size_t size;
+};
+
+// All levels of an image, stored in one contiguous buffer
+struct MipMapChain
+{
+	std::vector<byte> data;
+	std::vector<MipMapLevel> levels;
+
+	byte* getPixels(std::size_t level)
+	{
+		return &data.front() + levels[level].offset;
+	}
+
+	const byte* getPixels(std::size_t level) const
+	{
+		return &data.front() + levels[level].offset;
+	}
+};
+
+/**
+ * Fills the given chain with the levels of the given image, down to 1x1.
+ * Level 0 is a copy of the input, each further level halves the dimensions
+ * (rounding down, but not below 1) like OpenGL expects them.
+ */
+void generateMipMaps(const byte* pixels, std::size_t width, std::size_t height,
+					 const MipMapOptions& options, MipMapChain& chain);
+
+} // namespace image
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ImageKernels.h"
+#include "math/FloatTools.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IMAGE_KERNELS_X86
+#endif
+
+// The vectorised kernels are compiled with the respective instruction set
+// enabled per function, so the library itself doesn't need special flags
+#if defined(__GNUC__)
+#define IMAGE_KERNELS_TARGET_SSE2 __attribute__((target("sse2")))
+#define IMAGE_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define IMAGE_KERNELS_TARGET_SSE2
+#define IMAGE_KERNELS_TARGET_AVX2
+#endif
+
+/**
+ * Internal helpers shared by the kernel implementations. The vectorised
+ * kernels use the per-pixel functions for the image borders.
+ */
+namespace image
+{
+
+namespace detail
+{
+
+// Returns the pixel at the given coordinates, wrapping around at the borders
+inline const byte* getPixel(const byte* pixels, std::size_t width, std::size_t height,
+							std::size_t x, std::size_t y)
+{
+	return pixels + (((((y + height) % height) * width) + ((x + width) % width)) * 4);
+}
+
+inline void smoothNormalsPixel(const byte* in, byte* out, std::size_t width, std::size_t height,
+							   std::size_t x, std::size_t y)
+{
+	int sum[3] = { 0, 0, 0 };
+
+	for (int dy = -1; dy <= 1; ++dy)
+	{
+		for (int dx = -1; dx <= 1; ++dx)
+		{
+			const byte* pixel = getPixel(in, width, height, x + dx, y + dy);
+
+			sum[0] += pixel[0];
+			sum[1] += pixel[1];
+			sum[2] += pixel[2];
+		}
+	}
+
+	// Take the average normal vector as result
+	const double perKernelSize = 1.0f / 9;
+
+	out[0] = static_cast<byte>(float_to_integer(sum[0] * perKernelSize));
+	out[1] = static_cast<byte>(float_to_integer(sum[1] * perKernelSize));
+	out[2] = static_cast<byte>(float_to_integer(sum[2] * perKernelSize));
+	out[3] = 255;
+}
+
+inline void heightmapToNormalmapPixel(const byte* in, byte* out, std::size_t width, std::size_t height,
+									  std::size_t x, std::size_t y, float scale)
+{
+	// 3x3 Prewitt filtering, see http://en.wikipedia.org/wiki/Edge_detection
+	float du = 0;
+	du += (getPixel(in, width, height, x - 1, y + 1)[0] / 255.0f) * -1.0f;
+	du += (getPixel(in, width, height, x - 1, y    )[0] / 255.0f) * -1.0f;
+	du += (getPixel(in, width, height, x - 1, y - 1)[0] / 255.0f) * -1.0f;
+	du += (getPixel(in, width, height, x + 1, y + 1)[0] / 255.0f) * 1.0f;
+	du += (getPixel(in, width, height, x + 1, y    )[0] / 255.0f) * 1.0f;
+	du += (getPixel(in, width, height, x + 1, y - 1)[0] / 255.0f) * 1.0f;
+
+	float dv = 0;
+	dv += (getPixel(in, width, height, x - 1, y + 1)[0] / 255.0f) * 1.0f;
+	dv += (getPixel(in, width, height, x    , y + 1)[0] / 255.0f) * 1.0f;
+	dv += (getPixel(in, width, height, x + 1, y + 1)[0] / 255.0f) * 1.0f;
+	dv += (getPixel(in, width, height, x - 1, y - 1)[0] / 255.0f) * -1.0f;
+	dv += (getPixel(in, width, height, x    , y - 1)[0] / 255.0f) * -1.0f;
+	dv += (getPixel(in, width, height, x + 1, y - 1)[0] / 255.0f) * -1.0f;
+
+	float nx = -du * scale;
+	float ny = -dv * scale;
+	float nz = 1.0f;
+
+	// Normalize
+	float norm = 1.0f / std::sqrt(nx*nx + ny*ny + nz*nz);
+
+	out[0] = static_cast<byte>(float_to_integer(((nx * norm) + 1) * 127.5));
+	out[1] = static_cast<byte>(float_to_integer(((ny * norm) + 1) * 127.5));
+	out[2] = static_cast<byte>(float_to_integer(((nz * norm) + 1) * 127.5));
+	out[3] = 255;
+}
+
+// Replace the kernels they implement in the given table
+void fillSSE2Kernels(ImageKernels& kernels);
+void fillAVX2Kernels(ImageKernels& kernels);
+
+} // namespace detail
+
+} // namespace image
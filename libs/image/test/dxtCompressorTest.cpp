@@ -0,0 +1,187 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE dxtCompressorTest
+#include <boost/test/unit_test.hpp>
+
+#include <image/DXTCompressor.h>
+
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+using namespace image;
+
+namespace
+{
+    typedef std::vector<byte> Buffer;
+
+    // Smoothly varying colours with some noise, similar to a photo texture.
+    // Within a block the colours mostly vary along one axis, which is what
+    // the format can represent.
+    Buffer createReferenceImage(std::size_t width, std::size_t height)
+    {
+        std::srand(42);
+
+        Buffer pixels(width * height * 4);
+
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                byte* pixel = &pixels[(y * width + x) * 4];
+
+                double t = 0.5 + 0.5 * std::sin(x * 0.3) * std::cos(y * 0.2);
+
+                pixel[0] = static_cast<byte>(40 + 180 * t + std::rand() % 5);
+                pixel[1] = static_cast<byte>(60 + 120 * t + std::rand() % 5);
+                pixel[2] = static_cast<byte>(200 - 150 * t + std::rand() % 5);
+                pixel[3] = static_cast<byte>((x + y) * 255 / (width + height));
+            }
+        }
+
+        return pixels;
+    }
+
+    void makeOpaque(Buffer& pixels)
+    {
+        for (std::size_t i = 3; i < pixels.size(); i += 4)
+        {
+            pixels[i] = 255;
+        }
+    }
+
+    // Root mean square error of the given channel
+    double getRMSE(const Buffer& a, const Buffer& b, std::size_t channel)
+    {
+        double sum = 0;
+
+        for (std::size_t i = channel; i < a.size(); i += 4)
+        {
+            double d = static_cast<double>(a[i]) - b[i];
+            sum += d * d;
+        }
+
+        return std::sqrt(sum / (a.size() / 4));
+    }
+
+    Buffer roundTrip(DXTFormat format, const Buffer& pixels, std::size_t width, std::size_t height)
+    {
+        Buffer compressed(getCompressedSize(format, width, height));
+        compressDXT(format, &pixels.front(), width, height, &compressed.front());
+
+        Buffer result(width * height * 4);
+        decompressDXT(format, &compressed.front(), width, height, &result.front());
+
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compressedSizes)
+{
+    BOOST_CHECK_EQUAL(getCompressedSize(DXT_FORMAT_DXT1, 256, 128), 64 * 32 * 8);
+    BOOST_CHECK_EQUAL(getCompressedSize(DXT_FORMAT_DXT5, 256, 128), 64 * 32 * 16);
+
+    // Partial blocks occupy a full block
+    BOOST_CHECK_EQUAL(getCompressedSize(DXT_FORMAT_DXT1, 6, 3), 2 * 1 * 8);
+    BOOST_CHECK_EQUAL(getCompressedSize(DXT_FORMAT_DXT5, 1, 1), 16);
+}
+
+BOOST_AUTO_TEST_CASE(representableColoursAreExact)
+{
+    // Colours with exact 565 representations: 255 and 0 in all channels
+    Buffer pixels(8 * 8 * 4);
+
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+        bool white = ((i % 8) < 4) != ((i / 8) < 4);
+
+        pixels[i * 4 + 0] = white ? 255 : 0;
+        pixels[i * 4 + 1] = white ? 255 : 0;
+        pixels[i * 4 + 2] = 255;
+        pixels[i * 4 + 3] = 255;
+    }
+
+    Buffer result = roundTrip(DXT_FORMAT_DXT1, pixels, 8, 8);
+
+    BOOST_CHECK(result == pixels);
+}
+
+BOOST_AUTO_TEST_CASE(dxt1Quality)
+{
+    Buffer pixels = createReferenceImage(64, 64);
+    makeOpaque(pixels);
+
+    Buffer result = roundTrip(DXT_FORMAT_DXT1, pixels, 64, 64);
+
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+        BOOST_CHECK_LT(getRMSE(pixels, result, c), 6.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dxt1PunchThroughAlpha)
+{
+    Buffer pixels = createReferenceImage(16, 16);
+
+    // Binary alpha, the transparent pixels need to decode as transparent
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        pixels[i * 4 + 3] = (i % 3 == 0) ? 0 : 255;
+    }
+
+    Buffer result = roundTrip(DXT_FORMAT_DXT1, pixels, 16, 16);
+
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        BOOST_CHECK_EQUAL(result[i * 4 + 3], pixels[i * 4 + 3]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dxt5Quality)
+{
+    Buffer pixels = createReferenceImage(64, 64);
+
+    Buffer result = roundTrip(DXT_FORMAT_DXT5, pixels, 64, 64);
+
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+        BOOST_CHECK_LT(getRMSE(pixels, result, c), 6.0);
+    }
+
+    // Alpha gets 8 levels per block, a smooth gradient is almost exact
+    BOOST_CHECK_LT(getRMSE(pixels, result, 3), 1.5);
+
+    // Blocks with two alpha values are exact
+    Buffer twoValues(pixels);
+
+    for (std::size_t i = 0; i < 64 * 64; ++i)
+    {
+        twoValues[i * 4 + 3] = (i % 2 == 0) ? 17 : 230;
+    }
+
+    result = roundTrip(DXT_FORMAT_DXT5, twoValues, 64, 64);
+
+    BOOST_CHECK_EQUAL(getRMSE(twoValues, result, 3), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(oddSizes)
+{
+    Buffer pixels = createReferenceImage(6, 3);
+
+    Buffer result = roundTrip(DXT_FORMAT_DXT5, pixels, 6, 3);
+
+    for (std::size_t c = 0; c < 4; ++c)
+    {
+        BOOST_CHECK_LT(getRMSE(pixels, result, c), 8.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transparencyCheck)
+{
+    Buffer pixels(16, 255);
+
+    BOOST_CHECK(!hasTransparency(&pixels.front(), 4));
+
+    pixels[7] = 254;
+
+    BOOST_CHECK(hasTransparency(&pixels.front(), 4));
+}
@@ -0,0 +1,128 @@
+#include <image/ImageKernels.h>
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <ctime>
+
+/**
+ * Measures the throughput of the image kernels for each instruction set
+ * supported by this machine. This is not part of the test suite, run
+ * "make imageKernelBenchmark" and execute it manually.
+ */
+using namespace image;
+
+namespace
+{
+    const std::size_t SIZE = 2048;
+    const std::size_t NUM_PIXELS = SIZE * SIZE;
+    const int REPEATS = 10;
+
+    typedef std::vector<byte> Buffer;
+
+    struct Buffers
+    {
+        Buffer first;
+        Buffer second;
+        Buffer output;
+        Buffer table;
+
+        Buffers() :
+            first(NUM_PIXELS * 4),
+            second(NUM_PIXELS * 4),
+            output(NUM_PIXELS * 4),
+            table(256)
+        {
+            for (std::size_t i = 0; i < first.size(); ++i)
+            {
+                first[i] = static_cast<byte>(std::rand() & 0xff);
+                second[i] = static_cast<byte>(std::rand() & 0xff);
+            }
+
+            for (std::size_t i = 0; i < 256; ++i)
+            {
+                table[i] = static_cast<byte>(255 - i);
+            }
+        }
+    };
+
+    double now()
+    {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    // Runs the given kernel invocation and prints the input throughput
+    template<typename Function>
+    void measure(const char* name, const ImageKernels& kernels, const Function& function)
+    {
+        function(kernels); // warm up
+
+        double start = now();
+
+        for (int i = 0; i < REPEATS; ++i)
+        {
+            function(kernels);
+        }
+
+        double seconds = (now() - start) / REPEATS;
+        double megabytes = NUM_PIXELS * 4 / (1024.0 * 1024.0);
+
+        std::cout << std::setw(22) << std::left << name
+                  << std::setw(8) << kernels.name
+                  << std::setw(10) << std::right << std::fixed << std::setprecision(0)
+                  << (megabytes / seconds) << " MB/s" << std::endl;
+    }
+
+    Buffers buffers;
+
+    void gamma(const ImageKernels& k) { k.applyGammaTable(&buffers.output.front(), NUM_PIXELS, &buffers.table.front()); }
+    void mip(const ImageKernels& k) { k.mipReduce(&buffers.first.front(), &buffers.output.front(), SIZE, SIZE, true, true); }
+    void upsample(const ImageKernels& k) { resample(&buffers.first.front(), SIZE / 2, SIZE / 2, &buffers.output.front(), SIZE, SIZE, k); }
+    void average(const ImageKernels& k) { k.average(&buffers.first.front(), &buffers.second.front(), &buffers.output.front(), NUM_PIXELS); }
+    void addNormals(const ImageKernels& k) { k.addNormals(&buffers.first.front(), &buffers.second.front(), &buffers.output.front(), NUM_PIXELS); }
+
+    void scale(const ImageKernels& k)
+    {
+        const float factors[4] = { 0.5f, 1.5f, 1.0f, 0.75f };
+        k.scale(&buffers.first.front(), &buffers.output.front(), NUM_PIXELS, factors);
+    }
+
+    void invertColor(const ImageKernels& k) { k.invertColor(&buffers.first.front(), &buffers.output.front(), NUM_PIXELS); }
+    void makeIntensity(const ImageKernels& k) { k.makeIntensity(&buffers.first.front(), &buffers.output.front(), NUM_PIXELS); }
+    void makeAlpha(const ImageKernels& k) { k.makeAlpha(&buffers.first.front(), &buffers.output.front(), NUM_PIXELS); }
+    void smoothNormals(const ImageKernels& k) { k.smoothNormals(&buffers.first.front(), &buffers.output.front(), SIZE, SIZE); }
+    void heightmap(const ImageKernels& k) { k.heightmapToNormalmap(&buffers.first.front(), &buffers.output.front(), SIZE, SIZE, 2.0f); }
+}
+
+int main()
+{
+    std::vector<const ImageKernels*> list;
+
+    list.push_back(&getScalarKernels());
+
+    if (getSSE2Kernels() != NULL) list.push_back(getSSE2Kernels());
+    if (getAVX2Kernels() != NULL) list.push_back(getAVX2Kernels());
+
+    std::cout << "Kernel throughput on " << SIZE << "x" << SIZE << " RGBA images, "
+              << "selected: " << getKernels().name << std::endl;
+
+    for (std::size_t i = 0; i < list.size(); ++i)
+    {
+        const ImageKernels& k = *list[i];
+
+        measure("applyGammaTable", k, gamma);
+        measure("mipReduce", k, mip);
+        measure("resample (2x)", k, upsample);
+        measure("average", k, average);
+        measure("addNormals", k, addNormals);
+        measure("scale", k, scale);
+        measure("invertColor", k, invertColor);
+        measure("makeIntensity", k, makeIntensity);
+        measure("makeAlpha", k, makeAlpha);
+        measure("smoothNormals", k, smoothNormals);
+        measure("heightmapToNormalmap", k, heightmap);
+    }
+
+    return 0;
+}
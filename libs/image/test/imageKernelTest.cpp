@@ -0,0 +1,287 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE imageKernelTest
+#include <boost/test/unit_test.hpp>
+
+#include <image/ImageKernels.h>
+
+#include <vector>
+#include <cstdlib>
+
+using namespace image;
+
+namespace
+{
+    // Odd sizes to exercise the scalar tails of the vectorised loops
+    const std::size_t WIDTH = 67;
+    const std::size_t HEIGHT = 37;
+
+    typedef std::vector<byte> Buffer;
+
+    Buffer createRandomImage(std::size_t width, std::size_t height, unsigned int seed)
+    {
+        std::srand(seed);
+
+        Buffer pixels(width * height * 4);
+
+        for (std::size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = static_cast<byte>(std::rand() & 0xff);
+        }
+
+        return pixels;
+    }
+
+    // All kernel tables supported by this machine, except the reference
+    std::vector<const ImageKernels*> getVectorisedKernels()
+    {
+        std::vector<const ImageKernels*> list;
+
+        if (getSSE2Kernels() != NULL) list.push_back(getSSE2Kernels());
+        if (getAVX2Kernels() != NULL) list.push_back(getAVX2Kernels());
+
+        return list;
+    }
+
+    void checkEqual(const Buffer& expected, const Buffer& actual, const ImageKernels& kernels, int tolerance = 0)
+    {
+        BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            int difference = std::abs(static_cast<int>(expected[i]) - static_cast<int>(actual[i]));
+
+            if (difference > tolerance)
+            {
+                BOOST_ERROR(kernels.name << ": mismatch at byte " << i << ": "
+                    << static_cast<int>(expected[i]) << " != " << static_cast<int>(actual[i]));
+                return;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(applyGammaTable)
+{
+    Buffer table(256);
+
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        table[i] = static_cast<byte>((i * 7 + 13) & 0xff);
+    }
+
+    Buffer source = createRandomImage(WIDTH, HEIGHT, 1);
+
+    Buffer expected = source;
+    getScalarKernels().applyGammaTable(&expected.front(), WIDTH * HEIGHT, &table.front());
+
+    // Alpha is not touched
+    BOOST_CHECK_EQUAL(expected[3], source[3]);
+
+    std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+    for (std::size_t k = 0; k < list.size(); ++k)
+    {
+        Buffer actual = source;
+        list[k]->applyGammaTable(&actual.front(), WIDTH * HEIGHT, &table.front());
+
+        checkEqual(expected, actual, *list[k]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mipReduce)
+{
+    // Even and odd dimensions in all three reduction modes
+    const std::size_t sizes[][2] = { { 64, 32 }, { WIDTH, HEIGHT }, { 2, 1 }, { 1, 2 } };
+
+    for (std::size_t s = 0; s < 4; ++s)
+    {
+        std::size_t width = sizes[s][0];
+        std::size_t height = sizes[s][1];
+
+        Buffer source = createRandomImage(width, height, 2);
+
+        for (int mode = 1; mode <= 3; ++mode)
+        {
+            bool reduceWidth = (mode & 1) != 0;
+            bool reduceHeight = (mode & 2) != 0;
+
+            Buffer expected(source.size(), 0);
+            getScalarKernels().mipReduce(&source.front(), &expected.front(), width, height, reduceWidth, reduceHeight);
+
+            std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+            for (std::size_t k = 0; k < list.size(); ++k)
+            {
+                Buffer actual(source.size(), 0);
+                list[k]->mipReduce(&source.front(), &actual.front(), width, height, reduceWidth, reduceHeight);
+
+                checkEqual(expected, actual, *list[k]);
+
+                // In-place reduction as done by the TextureManipulator
+                Buffer inPlace = source;
+                list[k]->mipReduce(&inPlace.front(), &inPlace.front(), width, height, reduceWidth, reduceHeight);
+
+                Buffer expectedInPlace = source;
+                getScalarKernels().mipReduce(&expectedInPlace.front(), &expectedInPlace.front(), width, height, reduceWidth, reduceHeight);
+
+                checkEqual(expectedInPlace, inPlace, *list[k]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(resampleImage)
+{
+    Buffer source = createRandomImage(WIDTH, HEIGHT, 3);
+
+    // Upsampling, downsampling and mixed cases
+    const std::size_t sizes[][2] = { { 128, 64 }, { 32, 16 }, { 101, 19 }, { 1, 1 } };
+
+    for (std::size_t s = 0; s < 4; ++s)
+    {
+        std::size_t width = sizes[s][0];
+        std::size_t height = sizes[s][1];
+
+        Buffer expected(width * height * 4);
+        image::resample(&source.front(), WIDTH, HEIGHT, &expected.front(), width, height, getScalarKernels());
+
+        std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+        for (std::size_t k = 0; k < list.size(); ++k)
+        {
+            Buffer actual(width * height * 4);
+            image::resample(&source.front(), WIDTH, HEIGHT, &actual.front(), width, height, *list[k]);
+
+            checkEqual(expected, actual, *list[k]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(combineImages)
+{
+    Buffer first = createRandomImage(WIDTH, HEIGHT, 4);
+    Buffer second = createRandomImage(WIDTH, HEIGHT, 5);
+
+    std::size_t numPixels = WIDTH * HEIGHT;
+
+    Buffer expectedAverage(first.size());
+    Buffer expectedNormals(first.size());
+
+    getScalarKernels().average(&first.front(), &second.front(), &expectedAverage.front(), numPixels);
+    getScalarKernels().addNormals(&first.front(), &second.front(), &expectedNormals.front(), numPixels);
+
+    std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+    for (std::size_t k = 0; k < list.size(); ++k)
+    {
+        Buffer actual(first.size());
+
+        list[k]->average(&first.front(), &second.front(), &actual.front(), numPixels);
+        checkEqual(expectedAverage, actual, *list[k]);
+
+        list[k]->addNormals(&first.front(), &second.front(), &actual.front(), numPixels);
+        checkEqual(expectedNormals, actual, *list[k]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pixelOperations)
+{
+    Buffer source = createRandomImage(WIDTH, HEIGHT, 6);
+    std::size_t numPixels = WIDTH * HEIGHT;
+
+    // Includes factors that need clamping and exact .5 products
+    const float factors[4] = { 0.5f, 1.5f, 2.25f, 0.1f };
+
+    const ImageKernels& reference = getScalarKernels();
+
+    Buffer expectedScale(source.size());
+    Buffer expectedInvertAlpha(source.size());
+    Buffer expectedInvertColor(source.size());
+    Buffer expectedIntensity(source.size());
+    Buffer expectedAlpha(source.size());
+
+    reference.scale(&source.front(), &expectedScale.front(), numPixels, factors);
+    reference.invertAlpha(&source.front(), &expectedInvertAlpha.front(), numPixels);
+    reference.invertColor(&source.front(), &expectedInvertColor.front(), numPixels);
+    reference.makeIntensity(&source.front(), &expectedIntensity.front(), numPixels);
+    reference.makeAlpha(&source.front(), &expectedAlpha.front(), numPixels);
+
+    std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+    for (std::size_t k = 0; k < list.size(); ++k)
+    {
+        Buffer actual(source.size());
+
+        list[k]->scale(&source.front(), &actual.front(), numPixels, factors);
+        checkEqual(expectedScale, actual, *list[k]);
+
+        list[k]->invertAlpha(&source.front(), &actual.front(), numPixels);
+        checkEqual(expectedInvertAlpha, actual, *list[k]);
+
+        list[k]->invertColor(&source.front(), &actual.front(), numPixels);
+        checkEqual(expectedInvertColor, actual, *list[k]);
+
+        list[k]->makeIntensity(&source.front(), &actual.front(), numPixels);
+        checkEqual(expectedIntensity, actual, *list[k]);
+
+        list[k]->makeAlpha(&source.front(), &actual.front(), numPixels);
+        checkEqual(expectedAlpha, actual, *list[k]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(makeAlphaCoversAllSums)
+{
+    // Every possible RGB sum, to verify the division by three
+    Buffer source;
+
+    for (int sum = 0; sum <= 765; ++sum)
+    {
+        int r = sum > 510 ? 255 : (sum > 255 ? sum - 255 : 0);
+        int g = sum > 510 ? 255 : (sum > 255 ? 255 : sum);
+        int b = sum - r - g;
+
+        source.push_back(static_cast<byte>(r));
+        source.push_back(static_cast<byte>(g));
+        source.push_back(static_cast<byte>(b));
+        source.push_back(0);
+    }
+
+    std::size_t numPixels = source.size() / 4;
+
+    Buffer expected(source.size());
+    getScalarKernels().makeAlpha(&source.front(), &expected.front(), numPixels);
+
+    std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+    for (std::size_t k = 0; k < list.size(); ++k)
+    {
+        Buffer actual(source.size());
+        list[k]->makeAlpha(&source.front(), &actual.front(), numPixels);
+
+        checkEqual(expected, actual, *list[k]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(filterNormals)
+{
+    Buffer source = createRandomImage(WIDTH, HEIGHT, 7);
+
+    Buffer expectedSmooth(source.size());
+    Buffer expectedNormalmap(source.size());
+
+    getScalarKernels().smoothNormals(&source.front(), &expectedSmooth.front(), WIDTH, HEIGHT);
+    getScalarKernels().heightmapToNormalmap(&source.front(), &expectedNormalmap.front(), WIDTH, HEIGHT, 3.5f);
+
+    std::vector<const ImageKernels*> list = getVectorisedKernels();
+
+    for (std::size_t k = 0; k < list.size(); ++k)
+    {
+        Buffer actual(source.size());
+
+        list[k]->smoothNormals(&source.front(), &actual.front(), WIDTH, HEIGHT);
+        checkEqual(expectedSmooth, actual, *list[k]);
+
+        list[k]->heightmapToNormalmap(&source.front(), &actual.front(), WIDTH, HEIGHT, 3.5f);
+        checkEqual(expectedNormalmap, actual, *list[k], 1);
+    }
+}
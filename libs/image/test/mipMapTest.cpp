@@ -0,0 +1,166 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE mipMapTest
+#include <boost/test/unit_test.hpp>
+
+#include <image/MipMapGenerator.h>
+
+#include <cstdlib>
+
+using namespace image;
+
+namespace
+{
+    typedef std::vector<byte> Buffer;
+
+    Buffer createImage(std::size_t width, std::size_t height, byte r, byte g, byte b, byte a)
+    {
+        Buffer pixels(width * height * 4);
+
+        for (std::size_t i = 0; i < width * height; ++i)
+        {
+            pixels[i * 4 + 0] = r;
+            pixels[i * 4 + 1] = g;
+            pixels[i * 4 + 2] = b;
+            pixels[i * 4 + 3] = a;
+        }
+
+        return pixels;
+    }
+
+    // Black and white columns of one pixel width
+    Buffer createStripes(std::size_t width, std::size_t height)
+    {
+        Buffer pixels = createImage(width, height, 0, 0, 0, 255);
+
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 1; x < width; x += 2)
+            {
+                byte* pixel = &pixels[(y * width + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = 255;
+            }
+        }
+
+        return pixels;
+    }
+
+    MipMapOptions getOptions(MipMapFilter filter, bool gammaCorrect)
+    {
+        MipMapOptions options;
+
+        options.filter = filter;
+        options.gammaCorrect = gammaCorrect;
+
+        return options;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(levelDimensions)
+{
+    Buffer pixels = createImage(8, 2, 10, 20, 30, 40);
+
+    MipMapChain chain;
+    generateMipMaps(&pixels.front(), 8, 2, MipMapOptions(), chain);
+
+    // 8x2, 4x1, 2x1, 1x1
+    BOOST_REQUIRE_EQUAL(chain.levels.size(), 4);
+
+    BOOST_CHECK_EQUAL(chain.levels[1].width, 4);
+    BOOST_CHECK_EQUAL(chain.levels[1].height, 1);
+    BOOST_CHECK_EQUAL(chain.levels[3].width, 1);
+    BOOST_CHECK_EQUAL(chain.levels[3].height, 1);
+
+    // The levels are stored back to back
+    BOOST_CHECK_EQUAL(chain.levels[1].offset, 8 * 2 * 4);
+    BOOST_CHECK_EQUAL(chain.levels[2].offset, chain.levels[1].offset + 4 * 4);
+    BOOST_CHECK_EQUAL(chain.data.size(), (16 + 4 + 2 + 1) * 4);
+
+    // Level 0 is a copy of the source
+    BOOST_CHECK(std::equal(pixels.begin(), pixels.end(), chain.data.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(constantImagesStayConstant)
+{
+    Buffer pixels = createImage(16, 16, 200, 100, 50, 128);
+
+    for (int filter = MIPMAP_FILTER_BOX; filter <= MIPMAP_FILTER_KAISER; ++filter)
+    {
+        for (int gamma = 0; gamma <= 1; ++gamma)
+        {
+            MipMapChain chain;
+            generateMipMaps(&pixels.front(), 16, 16, getOptions(static_cast<MipMapFilter>(filter), gamma != 0), chain);
+
+            const byte* smallest = chain.getPixels(chain.levels.size() - 1);
+
+            BOOST_CHECK_EQUAL(smallest[0], 200);
+            BOOST_CHECK_EQUAL(smallest[1], 100);
+            BOOST_CHECK_EQUAL(smallest[2], 50);
+            BOOST_CHECK_EQUAL(smallest[3], 128);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(nonPowerOfTwoSizes)
+{
+    Buffer pixels = createImage(5, 3, 10, 20, 30, 40);
+
+    MipMapChain chain;
+    generateMipMaps(&pixels.front(), 5, 3, MipMapOptions(), chain);
+
+    // 5x3, 2x1, 1x1
+    BOOST_REQUIRE_EQUAL(chain.levels.size(), 3);
+
+    BOOST_CHECK_EQUAL(chain.levels[1].width, 2);
+    BOOST_CHECK_EQUAL(chain.levels[1].height, 1);
+
+    const byte* level1 = chain.getPixels(1);
+
+    BOOST_CHECK_EQUAL(level1[4], 10);
+    BOOST_CHECK_EQUAL(level1[7], 40);
+}
+
+BOOST_AUTO_TEST_CASE(boxFilterAveragesInGammaSpace)
+{
+    Buffer pixels = createStripes(2, 2);
+
+    MipMapChain chain;
+    generateMipMaps(&pixels.front(), 2, 2, getOptions(MIPMAP_FILTER_BOX, false), chain);
+
+    // The integer average rounds down, like the previous mip reduction
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[0], 127);
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[3], 255);
+}
+
+BOOST_AUTO_TEST_CASE(gammaCorrectAveraging)
+{
+    Buffer pixels = createStripes(2, 2);
+
+    MipMapChain chain;
+    generateMipMaps(&pixels.front(), 2, 2, getOptions(MIPMAP_FILTER_BOX, true), chain);
+
+    // Half of the light intensity is 188 in sRGB, not 128
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[0], 188);
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[1], 188);
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[2], 188);
+
+    // Alpha is linear
+    BOOST_CHECK_EQUAL(chain.getPixels(1)[3], 255);
+}
+
+BOOST_AUTO_TEST_CASE(kaiserFilterResolvesStripes)
+{
+    // The finest stripes can't be represented by the smaller level,
+    // they need to average out to grey without aliasing
+    Buffer pixels = createStripes(16, 4);
+
+    MipMapChain chain;
+    generateMipMaps(&pixels.front(), 16, 4, getOptions(MIPMAP_FILTER_KAISER, false), chain);
+
+    const MipMapLevel& level = chain.levels[1];
+    const byte* result = chain.getPixels(1);
+
+    for (std::size_t i = 0; i < level.width * level.height; ++i)
+    {
+        BOOST_CHECK(std::abs(result[i * 4] - 128) <= 1);
+    }
+}
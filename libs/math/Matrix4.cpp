@@ -919,3 +919,25 @@ std::size_t Matrix4::clipLine(const Vector3& p0, const Vector3& p1, Vector4 clip
 
 	return homogenous_clip_line(clipped);
 }
+
+ClipResult Matrix4::getClipMask(const Vector4& clipped)
+{
+	return homogenous_clip_point(clipped);
+}
+
+std::size_t Matrix4::clipTransformedLine(const Vector4& p0, const Vector4& p1, Vector4 clipped[2])
+{
+	clipped[0] = p0;
+	clipped[1] = p1;
+
+	return homogenous_clip_line(clipped);
+}
+
+std::size_t Matrix4::clipTransformedTriangle(const Vector4& p0, const Vector4& p1, const Vector4& p2, Vector4 clipped[9])
+{
+	clipped[0] = p0;
+	clipped[1] = p1;
+	clipped[2] = p2;
+
+	return homogenous_clip_triangle(clipped);
+}
@@ -675,6 +675,20 @@ public:
      * Returns the number of points in the resulting polygon.
      */
     std::size_t clipTriangle(const Vector3& p0, const Vector3& p1, const Vector3& p2, Vector4 clipped[9]) const;
+
+    /**
+     * Returns a bitmask indicating which clip-planes the given point is outside.
+     * The point is expected to be transformed into clip space already.
+     */
+    static ClipResult getClipMask(const Vector4& clipped);
+
+    /**
+     * Variants of clipLine() and clipTriangle() for points which have already been
+     * transformed into clip space. This allows for transforming the vertices of
+     * a whole primitive in one go before clipping its individual lines/triangles.
+     */
+    static std::size_t clipTransformedLine(const Vector4& p0, const Vector4& p1, Vector4 clipped[2]);
+    static std::size_t clipTransformedTriangle(const Vector4& p0, const Vector4& p1, const Vector4& p2, Vector4 clipped[9]);
 };
 
 // =========================================================================================
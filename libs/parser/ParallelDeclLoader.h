@@ -0,0 +1,265 @@
+#pragma once
+
+#include "ifilesystem.h"
+#include "iarchive.h"
+#include "iradiant.h"
+#include "ithread.h"
+#include "DefTokeniser.h"
+#include "DefBlockTokeniser.h"
+
+#include <vector>
+#include <glibmm/thread.h>
+#include <boost/function.hpp>
+
+namespace parser
+{
+
+/**
+ * A DefTokeniser returning the tokens of a list which has been filled
+ * beforehand, e.g. by tokenising a file on a worker thread.
+ *
+ * If tokenising the file failed, the list ends at the error. The error
+ * message is thrown once the list is used up, where the tokeniser reading
+ * the file would have thrown it, so the decl cut off by the error is never
+ * parsed from its incomplete tokens.
+ */
+class TokenListTokeniser :
+	public DefTokeniser
+{
+public:
+	typedef std::vector<std::string> Tokens;
+
+private:
+	const Tokens& _tokens;
+	Tokens::const_iterator _cur;
+
+	// The tokeniser error to throw after the last token, cleared once thrown
+	std::string _error;
+
+public:
+	TokenListTokeniser(const Tokens& tokens, const std::string& error = std::string()) :
+		_tokens(tokens),
+		_cur(_tokens.begin()),
+		_error(error)
+	{}
+
+	bool hasMoreTokens() const
+	{
+		return _cur != _tokens.end() || !_error.empty();
+	}
+
+	std::string nextToken()
+	{
+		if (_cur == _tokens.end())
+		{
+			// Report the error once, the token list is used up afterwards
+			std::string error;
+			error.swap(_error);
+
+			throwEndOfTokens(error);
+		}
+
+		return *_cur++;
+	}
+
+	std::string peek() const
+	{
+		if (_cur == _tokens.end())
+		{
+			throwEndOfTokens(_error);
+		}
+
+		return *_cur;
+	}
+
+private:
+	static void throwEndOfTokens(const std::string& error)
+	{
+		throw ParseException(error.empty() ? "DefTokeniser: no more tokens" : error);
+	}
+};
+
+/**
+ * Loads the decl files of a VFS folder on several threads. The loader is
+ * passed to VirtualFileSystem::forEachFile() to collect the file names,
+ * run() then opens and tokenises the files on worker threads.
+ *
+ * The results are stored in the order the VFS returned the files. Calling
+ * code merges them into its own containers after run() has returned,
+ * which keeps the precedence of redefined decls the same as loading one
+ * file after the other. The tokenise function must not touch any shared
+ * state, it only fills the result of its own file.
+ *
+ * Opening files is safe on any thread, the VFS index and the archives are
+ * not modified after the VFS has been initialised and the archives don't
+ * query the registry when opening files. The log output of the workers is
+ * collected per file and written by the calling thread once all files are
+ * done.
+ */
+template<typename Result>
+class ParallelDeclLoader :
+	public VirtualFileSystem::Visitor
+{
+public:
+	// Tokenises the given stream into the result, called on a worker thread
+	typedef boost::function<void(std::istream&, Result&)> TokeniseFunc;
+
+	struct File
+	{
+		// The VFS path relative to the base path, as passed to visit()
+		std::string name;
+
+		// The mod containing the file, as reported by the archive
+		std::string modName;
+
+		// False if the file couldn't be opened
+		bool opened;
+
+		// Set if the tokeniser threw, the result contains the tokens up to the error
+		std::string error;
+
+		// Messages written while opening and tokenising the file
+		CapturedLog log;
+
+		Result result;
+
+		File(const std::string& name_) :
+			name(name_),
+			opened(false)
+		{}
+	};
+	typedef std::vector<File> Files;
+
+private:
+	std::string _basePath;
+	TokeniseFunc _tokenise;
+
+	Files _files;
+
+	// The next file to be picked up by a worker
+	Glib::Mutex _lock;
+	std::size_t _nextFile;
+
+	// Acquired by the calling thread, used by the workers to capture their log
+	const ThreadManager* _threadManager;
+
+	// The number of threads reading the files, including the calling thread
+	static const std::size_t MAX_THREADS = 4;
+
+public:
+	ParallelDeclLoader(const std::string& basePath, const TokeniseFunc& tokenise) :
+		_basePath(basePath),
+		_tokenise(tokenise),
+		_nextFile(0),
+		_threadManager(NULL)
+	{}
+
+	// VirtualFileSystem::Visitor implementation, collects the file names
+	void visit(const std::string& filename)
+	{
+		_files.push_back(File(filename));
+	}
+
+	// Reads and tokenises all collected files, returns when all are done
+	void run()
+	{
+		_nextFile = 0;
+		_threadManager = &GlobalRadiant().getThreadManager();
+
+		std::vector<Glib::Thread*> threads;
+
+		for (std::size_t i = 1; i < MAX_THREADS && i < _files.size(); ++i)
+		{
+			threads.push_back(Glib::Thread::create(
+				sigc::mem_fun(*this, &ParallelDeclLoader::runWorker), true
+			));
+		}
+
+		// The calling thread helps out instead of waiting idly
+		runWorker();
+
+		for (std::vector<Glib::Thread*>::const_iterator i = threads.begin(); i != threads.end(); ++i)
+		{
+			(*i)->join();
+		}
+
+		for (typename Files::const_iterator i = _files.begin(); i != _files.end(); ++i)
+		{
+			i->log.writeToLog();
+		}
+	}
+
+	// The loaded files, in VFS order
+	Files& getFiles()
+	{
+		return _files;
+	}
+
+private:
+	void runWorker()
+	{
+		while (true)
+		{
+			std::size_t index = 0;
+
+			{
+				Glib::Mutex::Lock lock(_lock);
+
+				if (_nextFile >= _files.size())
+				{
+					return;
+				}
+
+				index = _nextFile++;
+			}
+
+			loadFile(_files[index]);
+		}
+	}
+
+	void loadFile(File& file)
+	{
+		ScopedLogCapture capture(*_threadManager, file.log);
+
+		ArchiveTextFilePtr textFile = GlobalFileSystem().openTextFile(_basePath + file.name);
+
+		if (textFile == NULL) return;
+
+		file.opened = true;
+		file.modName = textFile->getModName();
+
+		try
+		{
+			std::istream is(&(textFile->getInputStream()));
+			_tokenise(is, file.result);
+		}
+		catch (std::exception& e)
+		{
+			file.error = e.what();
+		}
+	}
+};
+
+// Tokenise function splitting the stream into single DefTokeniser tokens
+inline void tokeniseDefs(std::istream& is, TokenListTokeniser::Tokens& tokens)
+{
+	BasicDefTokeniser<std::istream> tokeniser(is);
+
+	while (tokeniser.hasMoreTokens())
+	{
+		tokens.push_back(tokeniser.nextToken());
+	}
+}
+
+// Tokenise function splitting the stream into named blocks
+inline void tokeniseBlocks(std::istream& is, std::vector<BlockTokeniser::Block>& blocks)
+{
+	BasicDefBlockTokeniser<std::istream> tokeniser(is);
+
+	while (tokeniser.hasMoreBlocks())
+	{
+		blocks.push_back(tokeniser.nextBlock());
+	}
+}
+
+} // namespace
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ivolumetest.h"
+#include "math/AABB.h"
+#include "math/Matrix4.h"
+#include "registry/CachedKey.h"
+
+#include <cstddef>
+
+namespace render
+{
+
+// Disable this to render all models at full detail, e.g. for screenshots
+const char* const RKEY_MESH_LOD_ENABLED = "user/ui/camera/meshLod";
+
+// The projected size in pixels below which the first simplified level is used,
+// each further level is used below half the size of the previous one
+const char* const RKEY_MESH_LOD_SWITCH_SIZE = "user/ui/camera/meshLodSwitchSize";
+
+/**
+ * Returns the detail level to render an object with the given world bounds,
+ * 0 being the full detail mesh and <numLevels> the number of simplified
+ * levels available. Only perspective views use simplified levels.
+ */
+inline std::size_t selectMeshLod(const VolumeTest& volume, const AABB& worldAABB, std::size_t numLevels)
+{
+	static registry::CachedKey<bool> enabled(RKEY_MESH_LOD_ENABLED);
+	static registry::CachedKey<int> switchSize(RKEY_MESH_LOD_SWITCH_SIZE);
+
+	if (numLevels == 0 || !enabled.get() || !volume.fill() ||
+		volume.GetProjection().zw() == 0 || !worldAABB.isValid())
+	{
+		return 0;
+	}
+
+	double radius = worldAABB.getRadius();
+
+	// The distance in front of the camera
+	double depth = -volume.GetModelview().transformPoint(worldAABB.getOrigin()).z();
+
+	if (depth <= radius)
+	{
+		return 0; // the camera is close or inside
+	}
+
+	// Diameter in pixels, the viewport scales from normalised device coordinates
+	double size = 2 * radius * volume.GetProjection().xx() * volume.GetViewport().xx() / depth;
+	double threshold = switchSize.get();
+
+	std::size_t level = 0;
+
+	while (level < numLevels && size < threshold)
+	{
+		++level;
+		threshold /= 2;
+	}
+
+	return level;
+}
+
+} // namespace render
@@ -0,0 +1,452 @@
+#pragma once
+
+#include "math/Vector3.h"
+#include "math/AABB.h"
+
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+
+namespace render
+{
+
+/// The maximum number of simplified levels generated per surface
+const std::size_t MAX_MESH_LOD_LEVELS = 3;
+
+/**
+ * Simplifies a triangle mesh by quadric error metric edge collapses
+ * (Garland/Heckbert). Collapses always move a vertex onto one of its
+ * neighbours, so the simplified meshes are index lists referencing the
+ * original vertices and can share their vertex arrays.
+ *
+ * Edges used by a single triangle, which includes texture and smoothing
+ * seams where the vertices are split, get additional boundary planes and
+ * keep their shape. Collapses which would flip a triangle or tear a hole
+ * into the mesh are rejected.
+ */
+class MeshSimplifier
+{
+	// Symmetric 4x4 matrix, the sum of the squared distances to a set of planes
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+		Quadric() :
+			a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0)
+		{}
+
+		void addPlane(const Vector3& normal, double dist, double weight)
+		{
+			double a = normal.x(), b = normal.y(), c = normal.z();
+
+			a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * dist;
+			b2 += weight * b * b; bc += weight * b * c; bd += weight * b * dist;
+			c2 += weight * c * c; cd += weight * c * dist;
+			d2 += weight * dist * dist;
+		}
+
+		void add(const Quadric& o)
+		{
+			a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad; b2 += o.b2;
+			bc += o.bc; bd += o.bd; c2 += o.c2; cd += o.cd; d2 += o.d2;
+		}
+
+		double evaluate(const Vector3& p) const
+		{
+			double x = p.x(), y = p.y(), z = p.z();
+
+			return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x + b2*y*y +
+				   2*bc*y*z + 2*bd*y + c2*z*z + 2*cd*z + d2;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		std::size_t from;
+		std::size_t to;
+
+		// The vertex versions at the time the collapse was queued
+		std::size_t fromVersion;
+		std::size_t toVersion;
+
+		// The cheapest collapse comes first
+		bool operator<(const Collapse& other) const
+		{
+			return cost > other.cost;
+		}
+	};
+
+	std::vector<Vector3> _positions;
+
+	std::vector<std::size_t> _triangles;
+	std::vector<bool> _triangleRemoved;
+	std::size_t _numTriangles;
+
+	// The triangles using each vertex, removed triangles are cleaned up lazily
+	std::vector< std::vector<std::size_t> > _vertexTriangles;
+
+	std::vector<Quadric> _quadrics;
+	std::vector<std::size_t> _versions;
+
+	std::priority_queue<Collapse> _queue;
+
+	// Boundary planes are weighted up to keep the outlines in place
+	static double BOUNDARY_WEIGHT() { return 4; }
+
+public:
+	MeshSimplifier(const std::vector<Vector3>& positions, const unsigned int* indices, std::size_t numIndices) :
+		_positions(positions),
+		_triangles(indices, indices + numIndices - numIndices % 3),
+		_triangleRemoved(numIndices / 3, false),
+		_numTriangles(numIndices / 3),
+		_vertexTriangles(positions.size()),
+		_quadrics(positions.size()),
+		_versions(positions.size(), 0)
+	{
+		for (std::size_t t = 0; t < _numTriangles; ++t)
+		{
+			const std::size_t* tri = &_triangles[t * 3];
+
+			if (tri[0] >= _positions.size() || tri[1] >= _positions.size() || tri[2] >= _positions.size())
+			{
+				// Leave invalid triangles alone
+				_triangleRemoved[t] = true;
+				continue;
+			}
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				_vertexTriangles[tri[k]].push_back(t);
+			}
+		}
+
+		for (std::size_t t = 0; t < _numTriangles; ++t)
+		{
+			if (_triangleRemoved[t]) continue;
+
+			const std::size_t* tri = &_triangles[t * 3];
+			Vector3 normal = getTriangleNormal(tri[0], tri[1], tri[2]);
+
+			double length = normal.getLength();
+
+			if (length <= 0) continue;
+
+			normal /= length;
+
+			double dist = -normal.dot(_positions[tri[0]]);
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				_quadrics[tri[k]].addPlane(normal, dist, 1);
+			}
+
+			// Boundary planes run through the edge, perpendicular to the triangle
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::size_t u = tri[k];
+				std::size_t v = tri[(k + 1) % 3];
+
+				if (!isBoundaryEdge(u, v)) continue;
+
+				Vector3 edge = _positions[v] - _positions[u];
+				Vector3 boundaryNormal = edge.crossProduct(normal);
+
+				double boundaryLength = boundaryNormal.getLength();
+
+				if (boundaryLength <= 0) continue;
+
+				boundaryNormal /= boundaryLength;
+
+				double boundaryDist = -boundaryNormal.dot(_positions[u]);
+
+				_quadrics[u].addPlane(boundaryNormal, boundaryDist, BOUNDARY_WEIGHT());
+				_quadrics[v].addPlane(boundaryNormal, boundaryDist, BOUNDARY_WEIGHT());
+			}
+		}
+
+		for (std::size_t t = 0; t < _numTriangles; ++t)
+		{
+			if (_triangleRemoved[t]) continue;
+
+			const std::size_t* tri = &_triangles[t * 3];
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				queueEdge(tri[k], tri[(k + 1) % 3]);
+			}
+		}
+
+		// Count the valid triangles only
+		for (std::size_t t = 0; t < _triangleRemoved.size(); ++t)
+		{
+			if (_triangleRemoved[t]) --_numTriangles;
+		}
+	}
+
+	std::size_t getNumTriangles() const
+	{
+		return _numTriangles;
+	}
+
+	/**
+	 * Collapses edges until at most <targetTriangles> are left, or the next
+	 * collapse would exceed <maxError> (a squared distance). Can be called
+	 * repeatedly with lower targets to produce coarser levels. The remaining
+	 * triangles are written to <indices> in their original order.
+	 */
+	void simplify(std::size_t targetTriangles, double maxError, std::vector<unsigned int>& indices)
+	{
+		while (_numTriangles > targetTriangles && !_queue.empty())
+		{
+			Collapse collapse = _queue.top();
+
+			if (_versions[collapse.from] != collapse.fromVersion ||
+				_versions[collapse.to] != collapse.toVersion)
+			{
+				// Outdated, the vertices have been changed since
+				_queue.pop();
+				continue;
+			}
+
+			if (collapse.cost > maxError)
+			{
+				// Keep it for the next, coarser level
+				break;
+			}
+
+			_queue.pop();
+
+			if (isValidCollapse(collapse.from, collapse.to))
+			{
+				performCollapse(collapse.from, collapse.to);
+			}
+		}
+
+		indices.clear();
+		indices.reserve(_numTriangles * 3);
+
+		for (std::size_t t = 0; t < _triangleRemoved.size(); ++t)
+		{
+			if (_triangleRemoved[t]) continue;
+
+			indices.push_back(static_cast<unsigned int>(_triangles[t * 3]));
+			indices.push_back(static_cast<unsigned int>(_triangles[t * 3 + 1]));
+			indices.push_back(static_cast<unsigned int>(_triangles[t * 3 + 2]));
+		}
+	}
+
+	/**
+	 * Generates up to MAX_MESH_LOD_LEVELS simplified index lists, each with
+	 * about half of the triangles of the previous one. The allowed error grows
+	 * with each level, relative to the size of the mesh. Levels which don't
+	 * save at least a quarter of the triangles are not generated, meshes
+	 * with less than <minTriangles> triangles don't get any levels.
+	 */
+	static void generateLevels(const std::vector<Vector3>& positions, const unsigned int* indices,
+							   std::size_t numIndices, std::size_t minTriangles,
+							   std::vector< std::vector<unsigned int> >& levels)
+	{
+		levels.clear();
+
+		if (numIndices / 3 < minTriangles) return;
+
+		AABB bounds;
+
+		for (std::size_t i = 0; i < positions.size(); ++i)
+		{
+			bounds.includePoint(positions[i]);
+		}
+
+		// The tolerated deviation on the first level, doubled on each further level
+		double tolerance = bounds.extents.getLength() * 2 * 0.005;
+
+		MeshSimplifier simplifier(positions, indices, numIndices);
+
+		std::size_t previous = simplifier.getNumTriangles();
+
+		for (std::size_t level = 0; level < MAX_MESH_LOD_LEVELS; ++level, tolerance *= 2)
+		{
+			std::vector<unsigned int> levelIndices;
+
+			simplifier.simplify(previous / 2, tolerance * tolerance, levelIndices);
+
+			std::size_t numTriangles = levelIndices.size() / 3;
+
+			if (numTriangles * 4 > previous * 3 || numTriangles == 0)
+			{
+				break;
+			}
+
+			levels.push_back(std::vector<unsigned int>());
+			levels.back().swap(levelIndices);
+
+			previous = numTriangles;
+		}
+	}
+
+private:
+	Vector3 getTriangleNormal(std::size_t a, std::size_t b, std::size_t c) const
+	{
+		return (_positions[b] - _positions[a]).crossProduct(_positions[c] - _positions[a]);
+	}
+
+	bool triangleContains(std::size_t t, std::size_t vertex) const
+	{
+		return _triangles[t * 3] == vertex || _triangles[t * 3 + 1] == vertex || _triangles[t * 3 + 2] == vertex;
+	}
+
+	// Returns the number of remaining triangles using both vertices
+	std::size_t countSharedTriangles(std::size_t u, std::size_t v) const
+	{
+		std::size_t count = 0;
+		const std::vector<std::size_t>& tris = _vertexTriangles[u];
+
+		for (std::size_t i = 0; i < tris.size(); ++i)
+		{
+			if (!_triangleRemoved[tris[i]] && triangleContains(tris[i], v)) ++count;
+		}
+
+		return count;
+	}
+
+	bool isBoundaryEdge(std::size_t u, std::size_t v) const
+	{
+		return countSharedTriangles(u, v) == 1;
+	}
+
+	double getCollapseCost(std::size_t from, std::size_t to) const
+	{
+		Quadric quadric = _quadrics[from];
+		quadric.add(_quadrics[to]);
+
+		return std::max(quadric.evaluate(_positions[to]), 0.0);
+	}
+
+	// Queues the cheaper direction of collapsing the given edge
+	void queueEdge(std::size_t u, std::size_t v)
+	{
+		double costUV = getCollapseCost(u, v);
+		double costVU = getCollapseCost(v, u);
+
+		Collapse collapse;
+
+		collapse.cost = costUV <= costVU ? costUV : costVU;
+		collapse.from = costUV <= costVU ? u : v;
+		collapse.to = costUV <= costVU ? v : u;
+		collapse.fromVersion = _versions[collapse.from];
+		collapse.toVersion = _versions[collapse.to];
+
+		_queue.push(collapse);
+	}
+
+	bool isValidCollapse(std::size_t from, std::size_t to) const
+	{
+		const std::vector<std::size_t>& tris = _vertexTriangles[from];
+		bool sharesTriangle = false;
+
+		for (std::size_t i = 0; i < tris.size(); ++i)
+		{
+			std::size_t t = tris[i];
+
+			if (_triangleRemoved[t]) continue;
+
+			const std::size_t* tri = &_triangles[t * 3];
+
+			if (triangleContains(t, to))
+			{
+				sharesTriangle = true;
+
+				// Removing a triangle with two open edges would tear a hole
+				std::size_t other = tri[0] != from && tri[0] != to ? tri[0] :
+									tri[1] != from && tri[1] != to ? tri[1] : tri[2];
+
+				if (isBoundaryEdge(from, other) && isBoundaryEdge(to, other))
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			// The triangle must not flip or degenerate when moving the vertex
+			Vector3 before = getTriangleNormal(tri[0], tri[1], tri[2]);
+
+			std::size_t moved[3] = { tri[0], tri[1], tri[2] };
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				if (moved[k] == from) moved[k] = to;
+			}
+
+			Vector3 after = getTriangleNormal(moved[0], moved[1], moved[2]);
+
+			if (before.dot(after) <= 0.2 * before.getLength() * after.getLength())
+			{
+				return false;
+			}
+		}
+
+		return sharesTriangle;
+	}
+
+	void performCollapse(std::size_t from, std::size_t to)
+	{
+		std::vector<std::size_t>& fromTris = _vertexTriangles[from];
+		std::vector<std::size_t>& toTris = _vertexTriangles[to];
+
+		for (std::size_t i = 0; i < fromTris.size(); ++i)
+		{
+			std::size_t t = fromTris[i];
+
+			if (_triangleRemoved[t]) continue;
+
+			if (triangleContains(t, to))
+			{
+				_triangleRemoved[t] = true;
+				--_numTriangles;
+				continue;
+			}
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				if (_triangles[t * 3 + k] == from) _triangles[t * 3 + k] = to;
+			}
+
+			toTris.push_back(t);
+		}
+
+		fromTris.clear();
+
+		_quadrics[to].add(_quadrics[from]);
+
+		// Invalidates the queued collapses of both vertices
+		++_versions[from];
+		++_versions[to];
+
+		// Drop the removed triangles and re-queue the edges around the remaining vertex
+		std::size_t kept = 0;
+
+		for (std::size_t i = 0; i < toTris.size(); ++i)
+		{
+			std::size_t t = toTris[i];
+
+			if (_triangleRemoved[t]) continue;
+
+			toTris[kept++] = t;
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::size_t other = _triangles[t * 3 + k];
+
+				if (other != to) queueEdge(to, other);
+			}
+		}
+
+		toTris.resize(kept);
+	}
+};
+
+} // namespace render
@@ -10,29 +10,38 @@ namespace scene
 
 namespace
 {
+    // Above this number of changed children the child bounds are recalculated
+    // from scratch, since we'd visit most of the children anyway
+    const std::size_t MAX_CHANGED_CHILDREN = 64;
 
-    /**
-     * greebo: This walker is used to traverse the children of
-     *         a given node and accumulate their values of worldAABB().
-     *
-     * Note: This walker's pre() method always returns false, so only
-     *       the first order children are visited.
-     */
-    class AABBAccumulateWalker :
-        public scene::NodeVisitor
+    // Returns true if the inner AABB doesn't touch any face of the outer one
+    inline bool isStrictlyInside(const AABB& inner, const AABB& outer)
     {
-        AABB& _aabb;
-    public:
-        AABBAccumulateWalker(AABB& aabb) :
-            _aabb(aabb)
-        {}
-
-        virtual bool pre(const INodePtr& node) {
-            _aabb.includeAABB(node->worldAABB());
-            // Don't traverse the children
-            return false;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (inner.origin[i] - inner.extents[i] <= outer.origin[i] - outer.extents[i] ||
+                inner.origin[i] + inner.extents[i] >= outer.origin[i] + outer.extents[i])
+            {
+                return false;
+            }
         }
-    };
+
+        return true;
+    }
+
+    inline bool contains(const AABB& outer, const AABB& inner)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (inner.origin[i] - inner.extents[i] < outer.origin[i] - outer.extents[i] ||
+                inner.origin[i] + inner.extents[i] > outer.origin[i] + outer.extents[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
 
 } // namespace
 
@@ -45,8 +54,10 @@ Node::Node() :
 	_boundsMutex(false),
 	_childBoundsChanged(true),
 	_childBoundsMutex(false),
+	_boundsChangeSignalled(false),
 	_transformChanged(true),
 	_transformMutex(false),
+	_transformChangeSignalled(false),
 	_local2world(Matrix4::getIdentity()),
 	_instantiated(false)
 {
@@ -65,6 +76,8 @@ Node::Node(const Node& other) :
 	_boundsMutex(false),
 	_childBoundsChanged(true),
 	_childBoundsMutex(false),
+	_boundsChangeSignalled(false),
+	_transformChangeSignalled(false),
 	_local2world(other._local2world),
 	_instantiated(false),
 	_layers(other._layers)
@@ -226,6 +239,9 @@ void Node::onChildAdded(const INodePtr& child)
 	// greebo: The bounds most probably change when child nodes are added
 	boundsChanged();
 
+	// The new child hasn't heard about a transform change we're holding back
+	_transformChangeSignalled = false;
+
 	if (!_instantiated) return;
 
 	GraphPtr sceneGraph = _sceneGraph.lock();
@@ -279,6 +295,10 @@ TraversableNodeSet& Node::getTraversable() {
 
 void Node::setParent(const INodePtr& parent) {
 	_parent = parent;
+
+	// A new parent needs to be notified about our next change
+	_boundsChangeSignalled = false;
+	_transformChangeSignalled = false;
 }
 
 scene::INodePtr Node::getParent() const {
@@ -335,6 +355,7 @@ void Node::evaluateBounds() const
 
 		_boundsMutex = false;
 		_boundsChanged = false;
+		_boundsChangeSignalled = false;
 
 		// Now that our bounds are re-calculated, notify the scenegraph
 		GraphPtr sceneGraph = _sceneGraph.lock();
@@ -351,43 +372,171 @@ const AABB& Node::childBounds() const {
 	return _childBounds;
 }
 
-void Node::evaluateChildBounds() const {
-	if (_childBoundsChanged) {
+void Node::evaluateChildBounds() const
+{
+	if (_childBoundsChanged)
+	{
 		ASSERT_MESSAGE(!_childBoundsMutex, "re-entering bounds evaluation");
 		_childBoundsMutex = true;
 
-		_childBounds = AABB();
-
-		// Instantiate an AABB accumulator
-		AABBAccumulateWalker accumulator(_childBounds);
-
-		// greebo: traverse the children of this node
-		traverseChildren(accumulator);
+		_changedChildren.clear();
+		accumulateChildBounds();
 
 		_childBoundsMutex = false;
 		_childBoundsChanged = false;
+		return;
+	}
+
+	if (_changedChildren.empty()) return;
+
+	ASSERT_MESSAGE(!_childBoundsMutex, "re-entering bounds evaluation");
+	_childBoundsMutex = true;
+
+	// Evaluating the children might queue them again, so work on a copy
+	ChangedChildren changedChildren;
+	changedChildren.swap(_changedChildren);
+
+	for (ChangedChildren::const_iterator i = changedChildren.begin();
+		 i != changedChildren.end(); ++i)
+	{
+		boost::shared_ptr<const Node> childPtr = i->lock();
+
+		// A child which is not ours anymore might have defined one of our extremes
+		if (!childPtr || childPtr->_parent.lock().get() != this)
+		{
+			_changedChildren.clear();
+			accumulateChildBounds();
+			break;
+		}
+
+		const Node& child = *childPtr;
+
+		const AABB& newBounds = child.worldAABB();
+		const AABB& oldBounds = child._boundsInParent;
+
+		// A child which grew or moved away from the faces of our bounds can be
+		// merged in, otherwise it might have been defining one of our extremes
+		if (!oldBounds.isValid() || contains(newBounds, oldBounds) ||
+			isStrictlyInside(oldBounds, _childBounds))
+		{
+			_childBounds.includeAABB(newBounds);
+			child._boundsInParent = newBounds;
+			continue;
+		}
+
+		_changedChildren.clear();
+		accumulateChildBounds();
+		break;
 	}
+
+	_childBoundsMutex = false;
 }
 
-void Node::boundsChanged() {
+void Node::accumulateChildBounds() const
+{
+	_childBounds = AABB();
+
+	// greebo: traverse the children of this node
+	_children.foreachNode([&] (const scene::INodePtr& child)->bool
+	{
+		const AABB& bounds = child->worldAABB();
+
+		Node* childNode = dynamic_cast<Node*>(child.get());
+
+		if (childNode != NULL)
+		{
+			childNode->_boundsInParent = bounds;
+		}
+
+		_childBounds.includeAABB(bounds);
+		return true;
+	});
+}
+
+void Node::boundsChanged()
+{
+	// Undo restores the faces of a brush one by one, each of them calls this.
+	// Nothing to do if the parent has been told and we haven't been evaluated since.
+	if (_boundsChanged && _childBoundsChanged && _boundsChangeSignalled && inBulkChange()) return;
+
 	_boundsChanged = true;
 	_childBoundsChanged = true;
+	_changedChildren.clear();
 
-	INodePtr parent = _parent.lock();
-	if (parent != NULL) {
-		parent->boundsChanged();
+	notifyParentOfBoundsChange();
+}
+
+void Node::onChildBoundsChanged(const Node& child)
+{
+	_boundsChanged = true;
+
+	// No need to remember the child if we're recalculating everything anyway
+	if (!_childBoundsChanged)
+	{
+		if (_changedChildren.size() < MAX_CHANGED_CHILDREN)
+		{
+			_changedChildren.push_back(child.shared_from_this());
+		}
+		else
+		{
+			_changedChildren.clear();
+			_childBoundsChanged = true;
+		}
 	}
 
+	notifyParentOfBoundsChange();
+}
+
+void Node::notifySceneGraphOfBoundsChange()
+{
+	GraphPtr sceneGraph = _sceneGraph.lock();
+
+	if (sceneGraph)
+	{
+		sceneGraph->boundsChanged();
+	}
+}
+
+bool Node::inBulkChange() const
+{
+	GraphPtr sceneGraph = _sceneGraph.lock();
+
+	return sceneGraph && sceneGraph->inBulkChange();
+}
+
+void Node::notifyParentOfBoundsChange()
+{
 	// greebo: It's enough if only root nodes call the global scenegraph
 	// as nodes are passing their calls up to their parents anyway
 	if (_isRoot)
 	{
-		GraphPtr sceneGraph = _sceneGraph.lock();
+		notifySceneGraphOfBoundsChange();
+	}
 
-		if (sceneGraph)
-		{
-			sceneGraph->boundsChanged();
-		}
+	// The ancestors have already been told and haven't been evaluated yet.
+	// The scene graph might have emitted its signal in the meantime without
+	// the observers evaluating us, so it needs to hear about this change.
+	if (_boundsChangeSignalled)
+	{
+		notifySceneGraphOfBoundsChange();
+		return;
+	}
+
+	INodePtr parent = _parent.lock();
+
+	if (parent == NULL) return;
+
+	_boundsChangeSignalled = true;
+
+	Node* parentNode = dynamic_cast<Node*>(parent.get());
+
+	if (parentNode != NULL)
+	{
+		parentNode->onChildBoundsChanged(*this);
+	}
+	else
+	{
+		parent->boundsChanged();
 	}
 }
 
@@ -416,6 +565,7 @@ void Node::evaluateTransform() const {
 
 		_transformMutex = false;
 		_transformChanged = false;
+		_transformChangeSignalled = false;
 	}
 }
 
@@ -434,6 +584,10 @@ void Node::transformChangedLocal()
 
 void Node::transformChanged()
 {
+	// Undo sets the spawnargs of an entity one by one, the children and the
+	// bounds only need to hear about it once until we're evaluated again
+	if (_transformChangeSignalled && inBulkChange()) return;
+
 	// First, notify ourselves
 	transformChangedLocal();
 
@@ -445,6 +599,8 @@ void Node::transformChanged()
 	});
 
 	boundsChanged();
+
+	_transformChangeSignalled = true;
 }
 
 void Node::setTransformChangedCallback(const Callback& callback) {
@@ -4,6 +4,7 @@
 #include "ipath.h"
 #include "irender.h"
 #include <list>
+#include <vector>
 #include "TraversableNodeSet.h"
 #include "math/AABB.h"
 #include "math/Matrix4.h"
@@ -50,8 +51,27 @@ private:
 	mutable bool _boundsMutex;
 	mutable bool _childBoundsChanged;
 	mutable bool _childBoundsMutex;
+
+	// The children whose bounds changed since the last child bounds evaluation.
+	// Only used as long as _childBoundsChanged is false, then the child bounds
+	// can often be updated without visiting all the children. Children which
+	// are gone or have been moved elsewhere in the meantime cause a full update.
+	typedef std::vector<boost::weak_ptr<const Node> > ChangedChildren;
+	mutable ChangedChildren _changedChildren;
+
+	// The bounds this node contributed to the child bounds of its parent
+	mutable AABB _boundsInParent;
+
+	// True if the parent has been notified about our bounds change
+	// and we haven't been evaluated since
+	mutable bool _boundsChangeSignalled;
+
 	mutable bool _transformChanged;
 	mutable bool _transformMutex;
+
+	// True if transformChanged() has notified the children and the bounds
+	// and we haven't been evaluated since
+	mutable bool _transformChangeSignalled;
 	Callback _transformChangedCallback;
 
 	mutable Matrix4 _local2world;
@@ -201,6 +221,22 @@ protected:
 private:
 	void evaluateBounds() const;
 	void evaluateChildBounds() const;
+
+	// Recalculates the child bounds by visiting all children
+	void accumulateChildBounds() const;
+
+	// Called by a child node when its bounds have changed
+	void onChildBoundsChanged(const Node& child);
+
+	// Passes the bounds change up to the parent (once until re-evaluation)
+	void notifyParentOfBoundsChange();
+
+	// Marks the bounds of our scene graph as changed
+	void notifySceneGraphOfBoundsChange();
+
+	// True if our scene graph is in the middle of a bulk change
+	bool inBulkChange() const;
+
 	void evaluateTransform() const;
 };
 
@@ -263,6 +263,17 @@ void TraversableNodeSet::importState(const IUndoMementoPtr& state)
 	}
 }
 
+IUndoMementoPtr TraversableNodeSet::compactState(const IUndoMementoPtr& state) const
+{
+	// Children which have only been modified don't change the set
+	if (std::static_pointer_cast<UndoListMemento>(state)->data() == _children)
+	{
+		return IUndoMementoPtr();
+	}
+
+	return state;
+}
+
 void TraversableNodeSet::postUndo()
 {
 	processInsertBuffer();
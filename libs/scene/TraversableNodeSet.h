@@ -84,6 +84,7 @@ public:
 	// Undoable implementation
 	IUndoMementoPtr exportState() const;
 	void importState(const IUndoMementoPtr& state);
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const;
 
 	// UndoSystem::Observer implementation
 	void postUndo();
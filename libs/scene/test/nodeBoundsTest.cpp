@@ -0,0 +1,254 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE nodeBoundsTest
+#include <boost/test/unit_test.hpp>
+
+#include "scene/Node.h"
+#include "math/AABB.h"
+
+#include <vector>
+#include <cstdlib>
+
+namespace
+{
+	// A node with freely settable local bounds and no transform
+	class TestNode :
+		public scene::Node
+	{
+		AABB _localAABB;
+
+	public:
+		TestNode(const AABB& bounds = AABB()) :
+			_localAABB(bounds)
+		{}
+
+		void setBounds(const AABB& bounds)
+		{
+			_localAABB = bounds;
+			boundsChanged();
+		}
+
+		const AABB& localAABB() const
+		{
+			return _localAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return Type::Unknown;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+	};
+	typedef boost::shared_ptr<TestNode> TestNodePtr;
+
+	AABB randomBox()
+	{
+		return AABB(Vector3(std::rand() % 4096 - 2048, std::rand() % 4096 - 2048, std::rand() % 4096 - 2048),
+					Vector3(std::rand() % 64 + 1, std::rand() % 64 + 1, std::rand() % 64 + 1));
+	}
+
+	// The bounds of the given subtree, calculated from scratch. The nodes
+	// have no transforms, so this is the union of all local bounds.
+	AABB fullBounds(const scene::INodePtr& node)
+	{
+		AABB bounds = dynamic_cast<const TestNode&>(*node).localAABB();
+
+		node->foreachNode([&] (const scene::INodePtr& child)->bool
+		{
+			bounds.includeAABB(dynamic_cast<const TestNode&>(*child).localAABB());
+			return true;
+		});
+
+		return bounds;
+	}
+
+	bool equal(const AABB& a, const AABB& b)
+	{
+		if (!a.isValid() || !b.isValid()) return a.isValid() == b.isValid();
+
+		return (a.origin - b.origin).getLengthSquared() < 1e-12 &&
+			   (a.extents - b.extents).getLengthSquared() < 1e-12;
+	}
+
+	class Tree
+	{
+	public:
+		TestNodePtr root;
+		std::vector<TestNodePtr> groups;
+		std::vector<TestNodePtr> leaves;
+
+		Tree(std::size_t numGroups, std::size_t leavesPerGroup) :
+			root(new TestNode)
+		{
+			for (std::size_t g = 0; g < numGroups; ++g)
+			{
+				groups.push_back(TestNodePtr(new TestNode));
+				root->addChildNode(groups.back());
+
+				for (std::size_t l = 0; l < leavesPerGroup; ++l)
+				{
+					addLeaf(g);
+				}
+			}
+		}
+
+		void addLeaf(std::size_t group)
+		{
+			leaves.push_back(TestNodePtr(new TestNode(randomBox())));
+			groups[group]->addChildNode(leaves.back());
+		}
+
+		// Removes the leaf from its parent, the tree doesn't hold it anymore
+		void removeLeaf(std::size_t leaf)
+		{
+			leaves[leaf]->getParent()->removeChildNode(leaves[leaf]);
+			leaves[leaf] = leaves.back();
+			leaves.pop_back();
+		}
+
+		void reparentLeaf(std::size_t leaf, std::size_t group)
+		{
+			TestNodePtr node = leaves[leaf];
+
+			node->getParent()->removeChildNode(node);
+			groups[group]->addChildNode(node);
+		}
+
+		void check() const
+		{
+			BOOST_REQUIRE(equal(root->worldAABB(), fullBounds(root)));
+
+			for (std::size_t g = 0; g < groups.size(); ++g)
+			{
+				BOOST_REQUIRE(equal(groups[g]->worldAABB(), fullBounds(groups[g])));
+			}
+		}
+	};
+}
+
+// Moving children around updates the parent bounds, whether or not the moved
+// children defined the previous extremes
+BOOST_AUTO_TEST_CASE(moveChildren)
+{
+	std::srand(1);
+
+	Tree tree(10, 50);
+	tree.check();
+
+	for (int step = 0; step < 2000; ++step)
+	{
+		std::size_t count = std::rand() % 5 + 1;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			TestNode& leaf = *tree.leaves[std::rand() % tree.leaves.size()];
+
+			if (std::rand() % 2 == 0)
+			{
+				leaf.setBounds(randomBox());
+			}
+			else
+			{
+				// Small moves stay inside the parent bounds most of the time
+				AABB bounds = leaf.localAABB();
+				bounds.origin += Vector3(std::rand() % 9 - 4, std::rand() % 9 - 4, 0);
+				leaf.setBounds(bounds);
+			}
+		}
+
+		tree.check();
+	}
+}
+
+// Adding, removing and re-parenting children between evaluations
+BOOST_AUTO_TEST_CASE(changeHierarchy)
+{
+	std::srand(2);
+
+	Tree tree(10, 50);
+	tree.check();
+
+	for (int step = 0; step < 2000; ++step)
+	{
+		// Move a few leaves first, so that they are queued in their parents
+		for (int i = 0; i < 3; ++i)
+		{
+			tree.leaves[std::rand() % tree.leaves.size()]->setBounds(randomBox());
+		}
+
+		switch (std::rand() % 3)
+		{
+		case 0:
+			tree.addLeaf(std::rand() % tree.groups.size());
+			break;
+		case 1:
+			if (tree.leaves.size() > 1) tree.removeLeaf(std::rand() % tree.leaves.size());
+			break;
+		case 2:
+			tree.reparentLeaf(std::rand() % tree.leaves.size(), std::rand() % tree.groups.size());
+			break;
+		}
+
+		tree.check();
+	}
+}
+
+// A child changing its bounds and being destroyed before the parent is
+// evaluated must not leave anything behind in the parent
+BOOST_AUTO_TEST_CASE(destroyQueuedChildren)
+{
+	std::srand(3);
+
+	Tree tree(4, 20);
+	tree.check();
+
+	for (int step = 0; step < 500; ++step)
+	{
+		std::size_t leaf = std::rand() % tree.leaves.size();
+
+		// Only the leaf's own bounds change is queued in the parent
+		tree.leaves[leaf]->setBounds(randomBox());
+
+		scene::INodePtr parent = tree.leaves[leaf]->getParent();
+
+		// Detach and release the leaf, then evaluate the parent of the leaf first
+		tree.removeLeaf(leaf);
+		BOOST_REQUIRE(equal(parent->worldAABB(), fullBounds(parent)));
+
+		tree.addLeaf(std::rand() % tree.groups.size());
+		tree.check();
+	}
+}
+
+// Evaluating a subtree on its own doesn't hide changes from the ancestors
+BOOST_AUTO_TEST_CASE(partialEvaluation)
+{
+	std::srand(4);
+
+	Tree tree(10, 50);
+	tree.check();
+
+	for (int step = 0; step < 1000; ++step)
+	{
+		TestNode& leaf = *tree.leaves[std::rand() % tree.leaves.size()];
+		leaf.setBounds(randomBox());
+
+		// Evaluate the leaf and its group before the root sees the change
+		leaf.worldAABB();
+		leaf.getParent()->worldAABB();
+
+		tree.check();
+	}
+}
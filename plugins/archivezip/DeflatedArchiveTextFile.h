@@ -27,12 +27,13 @@ public:
     /**
      * Constructor.
      *
-     * @param modDir
-     * The name of the mod directory this file's archive is located in.
+     * @param modName
+     * The name of the mod directory this file's archive is located in,
+     * relative to the engine path.
      */
     DeflatedArchiveTextFile(const std::string& name,
                             const std::string& archiveName,
-                            const std::string& modDir,
+                            const std::string& modName,
                             position_type position,
                             size_type stream_size)
     : m_name(name),
@@ -40,7 +41,7 @@ public:
       m_substream(m_istream, position, stream_size),
       m_zipstream(m_substream),
       m_textStream(m_zipstream),
-      _modDir(os::getRelativePathMinusFilename(modDir, GlobalRegistry().get(RKEY_ENGINE_PATH)))
+      _modDir(modName)
     {}
 
 	TextInputStream& getInputStream() {
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "iarchive.h"
+#include "archivelib.h"
+#include "MappedFile.h"
+#include "zlibstream.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+
+namespace archive
+{
+
+/**
+ * A seekable stream over a range of a memory mapped file. Reading is a
+ * plain copy out of the mapping, there are no file handles or buffers.
+ */
+class MappedInputStream :
+	public SeekableInputStream
+{
+	const byte_type* _begin;
+	const byte_type* _cur;
+	const byte_type* _end;
+
+public:
+	MappedInputStream(const byte_type* data, size_type size) :
+		_begin(data),
+		_cur(data),
+		_end(data + size)
+	{}
+
+	size_type read(byte_type* buffer, size_type length)
+	{
+		size_type count = std::min(static_cast<size_type>(_end - _cur), length);
+
+		std::copy(_cur, _cur + count, buffer);
+		_cur += count;
+
+		return count;
+	}
+
+	position_type seek(position_type position)
+	{
+		_cur = _begin + std::min(position, static_cast<position_type>(_end - _begin));
+		return tell();
+	}
+
+	position_type seek(offset_type offset, seekdir direction)
+	{
+		const byte_type* origin = direction == beg ? _begin : direction == cur ? _cur : _end;
+
+		// Clamp to the mapped range, like seeking in a file which has been truncated
+		std::ptrdiff_t position = (origin - _begin) + offset;
+		position = std::max(std::ptrdiff_t(0), std::min(position, _end - _begin));
+
+		_cur = _begin + position;
+		return tell();
+	}
+
+	position_type tell() const
+	{
+		return _cur - _begin;
+	}
+};
+
+/**
+ * ArchiveFile reading its data straight out of the memory mapped archive.
+ * The data of stored entries is handed out as a pointer into the mapping,
+ * see getData(), deflated ones are inflated from it. Each file has its own
+ * stream state and keeps the mapping alive.
+ */
+class MappedArchiveFile :
+	public ArchiveFile
+{
+	std::string _name;
+	MappedFilePtr _mappedFile;
+	std::size_t _size;
+	boost::scoped_ptr<InputStream> _stream;
+
+	// The contents within the mapping, NULL for deflated entries
+	const InputStream::byte_type* _data;
+
+public:
+	MappedArchiveFile(const std::string& name,
+					  const MappedFilePtr& mappedFile,
+					  std::size_t position,
+					  std::size_t streamSize,
+					  std::size_t fileSize,
+					  bool deflated) :
+		_name(name),
+		_mappedFile(mappedFile),
+		_size(fileSize),
+		_data(NULL)
+	{
+		const InputStream::byte_type* data = _mappedFile->data() + position;
+
+		if (deflated)
+		{
+			_stream.reset(new DeflatedMemoryInputStream(data, streamSize));
+		}
+		else
+		{
+			_stream.reset(new MappedInputStream(data, streamSize));
+
+			// The stored size must match, in case the directory is broken
+			if (streamSize == fileSize)
+			{
+				_data = data;
+			}
+		}
+	}
+
+	std::size_t size() const
+	{
+		return _size;
+	}
+
+	const std::string& getName() const
+	{
+		return _name;
+	}
+
+	InputStream& getInputStream()
+	{
+		return *_stream;
+	}
+
+	const InputStream::byte_type* getData() const
+	{
+		return _data;
+	}
+};
+
+/**
+ * ArchiveTextFile reading its data straight out of the memory mapped archive.
+ */
+class MappedArchiveTextFile :
+	public ArchiveTextFile
+{
+	std::string _name;
+	MappedFilePtr _mappedFile;
+	boost::scoped_ptr<InputStream> _stream;
+	boost::scoped_ptr< BinaryToTextInputStream<InputStream> > _textStream;
+
+	// Mod directory containing this file
+	std::string _modDir;
+
+public:
+	MappedArchiveTextFile(const std::string& name,
+						  const std::string& modDir,
+						  const MappedFilePtr& mappedFile,
+						  std::size_t position,
+						  std::size_t streamSize,
+						  bool deflated) :
+		_name(name),
+		_mappedFile(mappedFile),
+		_modDir(modDir)
+	{
+		const InputStream::byte_type* data = _mappedFile->data() + position;
+
+		if (deflated)
+		{
+			_stream.reset(new DeflatedMemoryInputStream(data, streamSize));
+		}
+		else
+		{
+			_stream.reset(new MappedInputStream(data, streamSize));
+		}
+
+		_textStream.reset(new BinaryToTextInputStream<InputStream>(*_stream));
+	}
+
+	TextInputStream& getInputStream()
+	{
+		return *_textStream;
+	}
+
+	const std::string& getName() const
+	{
+		return _name;
+	}
+
+	std::string getModName() const
+	{
+		return _modDir;
+	}
+};
+
+} // namespace archive
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <glib.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace archive
+{
+
+/**
+ * A read-only memory mapping of a whole file. The mapping is shared between
+ * the archive and the files opened from it, and stays valid as long as
+ * any of them is alive. The contents can be read from any thread.
+ */
+class MappedFile :
+	public boost::noncopyable
+{
+	GMappedFile* _file;
+	std::string _error;
+
+public:
+	typedef unsigned char byte_type;
+
+	MappedFile(const std::string& path) :
+		_file(NULL)
+	{
+		GError* error = NULL;
+		_file = g_mapped_file_new(path.c_str(), FALSE, &error);
+
+		if (error != NULL)
+		{
+			_error = error->message;
+			g_error_free(error);
+		}
+	}
+
+	~MappedFile()
+	{
+		if (_file != NULL)
+		{
+			g_mapped_file_unref(_file);
+		}
+	}
+
+	bool failed() const
+	{
+		return _file == NULL;
+	}
+
+	// The reason for the failure, empty on success
+	const std::string& getError() const
+	{
+		return _error;
+	}
+
+	// Returns NULL for empty files
+	const byte_type* data() const
+	{
+		return _file != NULL ?
+			reinterpret_cast<const byte_type*>(g_mapped_file_get_contents(_file)) : NULL;
+	}
+
+	std::size_t size() const
+	{
+		return _file != NULL ? g_mapped_file_get_length(_file) : 0;
+	}
+};
+typedef boost::shared_ptr<MappedFile> MappedFilePtr;
+
+} // namespace archive
@@ -1,141 +1,268 @@
 #include "ZipArchive.h"
 
 #include "iarchive.h"
+#include "iregistry.h"
+#include "itextstream.h"
 #include "archivelib.h"
+#include "fs_filesystem.h"
 
 #include "pkzip.h"
 #include "zlibstream.h"
 
+#include "MappedArchiveFile.h"
 #include "DeflatedArchiveFile.h"
 #include "DeflatedArchiveTextFile.h"
 
+#include <algorithm>
+
+namespace
+{
+	// Orders the index entries like the GenericFileSystem orders its paths
+	struct PathLess
+	{
+		template<typename Entry>
+		bool operator()(const Entry& entry, const std::string& path) const
+		{
+			return string_less_nocase(entry.path.c_str(), path.c_str());
+		}
+
+		template<typename Entry>
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			return string_less_nocase(a.path.c_str(), b.path.c_str());
+		}
+	};
+}
+
+ZipArchive::IndexEntry::IndexEntry(const std::string& path_, bool isDirectory_, const ZipRecord& record_) :
+	path(path_),
+	depth(path_get_depth(path_.c_str())),
+	isDirectory(isDirectory_),
+	record(record_)
+{}
+
 ZipArchive::ZipArchive(const std::string& name) :
 	m_name(name),
-	m_istream(name)
+	_modDir(os::getRelativePathMinusFilename(name, GlobalRegistry().get(RKEY_ENGINE_PATH))),
+	_mappedFile(new archive::MappedFile(name)),
+	_failed(false)
 {
-	if (!m_istream.failed()) {
-		if (!read_pkzip()) {
-			rError() << "ERROR: invalid zip-file " << name.c_str() << '\n';
+	bool valid = false;
+
+	if (!_mappedFile->failed())
+	{
+		archive::MappedInputStream istream(_mappedFile->data(), _mappedFile->size());
+		valid = read_pkzip(istream);
+	}
+	else
+	{
+		rWarning() << "Cannot map zip-file " << name << ": " << _mappedFile->getError()
+			<< ", falling back to file streams." << std::endl;
+
+		_mappedFile.reset();
+
+		FileInputStream istream(name);
+
+		if (istream.failed())
+		{
+			_failed = true;
+			return;
 		}
+
+		valid = read_pkzip(istream);
 	}
-}
 
-ZipArchive::~ZipArchive() {
-	for (ZipFileSystem::iterator i = m_filesystem.begin();
-		 i != m_filesystem.end(); ++i)
-	{
-		delete i->second.file();
+	if (!valid) {
+		rError() << "ERROR: invalid zip-file " << name.c_str() << '\n';
 	}
+
+	sortIndex();
 }
 
 bool ZipArchive::failed() {
-	return m_istream.failed();
+	return _failed;
 }
 
 ArchiveFilePtr ZipArchive::openFile(const std::string& name) {
-	ZipFileSystem::iterator i = m_filesystem.find(name);
-	if (i != m_filesystem.end() && !i->second.is_directory()) {
-		ZipRecord* file = i->second.file();
+	const ZipRecord* file = findFile(name);
+	std::size_t position = 0;
 
-		m_istream.seek(file->m_position);
-		zip_file_header file_header;
-		istream_read_zip_file_header(m_istream, file_header);
+	if (file == NULL || !getDataPosition(*file, position)) {
+		return ArchiveFilePtr();
+	}
 
-		if (file_header.z_magic != zip_file_header_magic) {
-			rError() << "error reading zip file " << m_name.c_str();
-			return ArchiveFilePtr();
-		}
+	if (_mappedFile) {
+		return ArchiveFilePtr(new archive::MappedArchiveFile(name, _mappedFile,
+			position, file->m_stream_size, file->m_file_size, file->m_mode == ZipRecord::eDeflated));
+	}
 
-		switch (file->m_mode) {
-			case ZipRecord::eStored:
-				return ArchiveFilePtr(new StoredArchiveFile(name, m_name, m_istream.tell(), file->m_stream_size, file->m_file_size));
-			case ZipRecord::eDeflated:
-				return ArchiveFilePtr(new DeflatedArchiveFile(name, m_name, m_istream.tell(), file->m_stream_size, file->m_file_size));
-		}
+	switch (file->m_mode) {
+		case ZipRecord::eStored:
+			return ArchiveFilePtr(new StoredArchiveFile(name, m_name, position, file->m_stream_size, file->m_file_size));
+		case ZipRecord::eDeflated:
+			return ArchiveFilePtr(new DeflatedArchiveFile(name, m_name, position, file->m_stream_size, file->m_file_size));
 	}
+
 	return ArchiveFilePtr();
 }
 
 ArchiveTextFilePtr ZipArchive::openTextFile(const std::string& name) {
-	ZipFileSystem::iterator i = m_filesystem.find(name);
-	if (i != m_filesystem.end() && !i->second.is_directory()) {
-		ZipRecord* file = i->second.file();
+	const ZipRecord* file = findFile(name);
+	std::size_t position = 0;
 
-		m_istream.seek(file->m_position);
-		zip_file_header file_header;
-		istream_read_zip_file_header(m_istream, file_header);
+	if (file == NULL || !getDataPosition(*file, position)) {
+		return ArchiveTextFilePtr();
+	}
 
-		if (file_header.z_magic != zip_file_header_magic) {
-			rError() << "error reading zip file " << m_name.c_str();
-			return ArchiveTextFilePtr();
-		}
+	if (_mappedFile) {
+		return ArchiveTextFilePtr(new archive::MappedArchiveTextFile(name, _modDir, _mappedFile,
+			position, file->m_stream_size, file->m_mode == ZipRecord::eDeflated));
+	}
 
-		switch (file->m_mode) {
-			case ZipRecord::eStored:
-				return ArchiveTextFilePtr(new StoredArchiveTextFile(name,
-					m_name,
-					m_name,
-					m_istream.tell(),
-					file->m_stream_size));
-			case ZipRecord::eDeflated:
-				return ArchiveTextFilePtr(new DeflatedArchiveTextFile(name,
-					m_name,
-					m_name,
-					m_istream.tell(),
-					file->m_stream_size));
-		}
+	switch (file->m_mode) {
+		case ZipRecord::eStored:
+			return ArchiveTextFilePtr(new StoredArchiveTextFile(name,
+				m_name,
+				_modDir,
+				position,
+				file->m_stream_size));
+		case ZipRecord::eDeflated:
+			return ArchiveTextFilePtr(new DeflatedArchiveTextFile(name,
+				m_name,
+				_modDir,
+				position,
+				file->m_stream_size));
 	}
+
 	return ArchiveTextFilePtr();
 }
 
 bool ZipArchive::containsFile(const std::string& name) {
-	ZipFileSystem::iterator i = m_filesystem.find(name);
-	return i != m_filesystem.end() && !i->second.is_directory();
+	return findFile(name) != NULL;
 }
 
 void ZipArchive::forEachFile(VisitorFunc visitor, const std::string& root) {
-	m_filesystem.traverse(visitor, root);
+	// Same traversal as GenericFileSystem::traverse(), on the flat index
+	Index::const_iterator i = _index.begin();
+
+	if (!root.empty()) {
+		const IndexEntry* rootEntry = findEntry(root);
+
+		if (rootEntry == NULL) {
+			return;
+		}
+
+		i = _index.begin() + (rootEntry - &_index.front()) + 1;
+	}
+
+	unsigned int startDepth = path_get_depth(root.c_str());
+	unsigned int skipDepth = 0;
+
+	for (; i != _index.end() && i->depth > startDepth; ++i) {
+		if (i->depth == skipDepth) {
+			skipDepth = 0;
+		}
+
+		if (skipDepth == 0) {
+			if (!i->isDirectory) {
+				visitor.file(i->path);
+			}
+			else if (visitor.directory(i->path, i->depth - startDepth)) {
+				skipDepth = i->depth;
+			}
+		}
+	}
 }
 
-bool ZipArchive::read_record() {
+const ZipArchive::IndexEntry* ZipArchive::findEntry(const std::string& path) const {
+	Index::const_iterator i = std::lower_bound(_index.begin(), _index.end(), path, PathLess());
+
+	if (i == _index.end() || string_less_nocase(path.c_str(), i->path.c_str())) {
+		return NULL;
+	}
+
+	return &(*i);
+}
+
+const ZipRecord* ZipArchive::findFile(const std::string& path) const {
+	const IndexEntry* entry = findEntry(path);
+
+	return entry != NULL && !entry->isDirectory ? &entry->record : NULL;
+}
+
+bool ZipArchive::getDataPosition(const ZipRecord& file, std::size_t& position) const {
+	zip_file_header file_header;
+
+	if (_mappedFile) {
+		// Each call uses a stream of its own, the mapping itself is read-only
+		archive::MappedInputStream istream(_mappedFile->data(), _mappedFile->size());
+
+		istream.seek(file.m_position);
+		istream_read_zip_file_header(istream, file_header);
+		position = istream.tell();
+
+		if (file_header.z_magic == zip_file_header_magic &&
+			position + file.m_stream_size > _mappedFile->size())
+		{
+			rError() << "error reading zip file " << m_name << ": entry exceeds the archive size" << std::endl;
+			return false;
+		}
+	}
+	else {
+		FileInputStream istream(m_name);
+
+		istream.seek(file.m_position);
+		istream_read_zip_file_header(istream, file_header);
+		position = istream.tell();
+	}
+
+	if (file_header.z_magic != zip_file_header_magic) {
+		rError() << "error reading zip file " << m_name.c_str();
+		return false;
+	}
+
+	return true;
+}
+
+bool ZipArchive::read_record(SeekableInputStream& istream) {
 	zip_magic magic;
-	istream_read_zip_magic(m_istream, magic);
+	istream_read_zip_magic(istream, magic);
 
 	if (!(magic == zip_root_dirent_magic)) {
 		return false;
 	}
 	zip_version version_encoder;
-	istream_read_zip_version(m_istream, version_encoder);
+	istream_read_zip_version(istream, version_encoder);
 	zip_version version_extract;
-	istream_read_zip_version(m_istream, version_extract);
+	istream_read_zip_version(istream, version_extract);
 	//unsigned short flags =
-	istream_read_int16_le(m_istream);
-	unsigned short compression_mode = istream_read_int16_le(m_istream);
+	istream_read_int16_le(istream);
+	unsigned short compression_mode = istream_read_int16_le(istream);
 
 	if (compression_mode != Z_DEFLATED && compression_mode != 0) {
 		return false;
 	}
 
 	zip_dostime dostime;
-	istream_read_zip_dostime(m_istream, dostime);
+	istream_read_zip_dostime(istream, dostime);
 
 	//unsigned int crc32 =
-	istream_read_int32_le(m_istream);
+	istream_read_int32_le(istream);
 
-	unsigned int compressed_size = istream_read_uint32_le(m_istream);
-	unsigned int uncompressed_size = istream_read_uint32_le(m_istream);
-	unsigned int namelength = istream_read_uint16_le(m_istream);
-	unsigned short extras = istream_read_uint16_le(m_istream);
-	unsigned short comment = istream_read_uint16_le(m_istream);
+	unsigned int compressed_size = istream_read_uint32_le(istream);
+	unsigned int uncompressed_size = istream_read_uint32_le(istream);
+	unsigned int namelength = istream_read_uint16_le(istream);
+	unsigned short extras = istream_read_uint16_le(istream);
+	unsigned short comment = istream_read_uint16_le(istream);
 
 	//unsigned short diskstart =
-	istream_read_int16_le(m_istream);
+	istream_read_int16_le(istream);
 	//unsigned short filetype =
-	istream_read_int16_le(m_istream);
+	istream_read_int16_le(istream);
 	//unsigned int filemode =
-	istream_read_int32_le(m_istream);
+	istream_read_int32_le(istream);
 
-	unsigned int position = istream_read_int32_le(m_istream);
+	unsigned int position = istream_read_int32_le(istream);
 
 	// greebo: Read the filename directly into a newly constructed std::string.
 
@@ -146,49 +273,50 @@ bool ZipArchive::read_record() {
 
 	std::string path(namelength, '\0');
 
-	m_istream.read(
-		reinterpret_cast<FileInputStream::byte_type*>(const_cast<char*>(path.data())),
+	istream.read(
+		reinterpret_cast<InputStream::byte_type*>(const_cast<char*>(path.data())),
 		namelength);
 
-	m_istream.seek(extras + comment, FileInputStream::cur);
+	istream.seek(extras + comment, SeekableInputStream::cur);
+
+	// Add the parent directories, the duplicates are removed after sorting
+	for (const char* end = path_remove_directory(path.c_str()); end[0] != '\0'; end = path_remove_directory(end))
+	{
+		std::string directory(path.c_str(), end - path.c_str());
+		_index.push_back(IndexEntry(directory, true, ZipRecord(0, 0, 0, ZipRecord::eStored)));
+	}
 
 	if (path_is_directory(path.c_str())) {
-		m_filesystem[path] = 0;
+		_index.push_back(IndexEntry(path, true, ZipRecord(0, 0, 0, ZipRecord::eStored)));
 	}
 	else {
-		ZipFileSystem::entry_type& file = m_filesystem[path];
-		if (!file.is_directory()) {
-			rMessage() << "Warning: zip archive "
-				<< m_name << " contains duplicated file: "
-				<< path << std::endl;
-		}
-		else {
-			file = new ZipRecord(position,
-								 compressed_size,
-								 uncompressed_size,
-								 (compression_mode == Z_DEFLATED) ? ZipRecord::eDeflated : ZipRecord::eStored);
-		}
+		_index.push_back(IndexEntry(path, false, ZipRecord(position,
+							 compressed_size,
+							 uncompressed_size,
+							 (compression_mode == Z_DEFLATED) ? ZipRecord::eDeflated : ZipRecord::eStored)));
 	}
 
 	return true;
 }
 
-bool ZipArchive::read_pkzip() {
-	SeekableStream::position_type pos = pkzip_find_disk_trailer(m_istream);
+bool ZipArchive::read_pkzip(SeekableInputStream& istream) {
+	SeekableStream::position_type pos = pkzip_find_disk_trailer(istream);
 	if (pos != 0) {
 		zip_disk_trailer disk_trailer;
 
-		m_istream.seek(pos);
-		istream_read_zip_disk_trailer(m_istream, disk_trailer);
+		istream.seek(pos);
+		istream_read_zip_disk_trailer(istream, disk_trailer);
 
 		if (!(disk_trailer.z_magic == zip_disk_trailer_magic)) {
 			return false;
 		}
 
-		m_istream.seek(disk_trailer.z_rootseek);
+		istream.seek(disk_trailer.z_rootseek);
+
+		_index.reserve(disk_trailer.z_entries);
 
 		for (unsigned int i = 0; i < disk_trailer.z_entries; ++i) {
-			if (!read_record()) {
+			if (!read_record(istream)) {
 				return false;
 			}
 		}
@@ -197,3 +325,26 @@ bool ZipArchive::read_pkzip() {
 	}
 	return false;
 }
+
+void ZipArchive::sortIndex() {
+	// Stable, so the first one of several duplicated files is kept
+	std::stable_sort(_index.begin(), _index.end(), PathLess());
+
+	Index sorted;
+	sorted.reserve(_index.size());
+
+	for (Index::const_iterator i = _index.begin(); i != _index.end(); ++i) {
+		if (!sorted.empty() && !PathLess()(sorted.back(), *i)) {
+			if (!i->isDirectory) {
+				rMessage() << "Warning: zip archive "
+					<< m_name << " contains duplicated file: "
+					<< i->path << std::endl;
+			}
+			continue;
+		}
+
+		sorted.push_back(*i);
+	}
+
+	_index.swap(sorted);
+}
@@ -2,8 +2,9 @@
 #define ZIPARCHIVE_H_
 
 #include "iarchive.h"
-#include "fs_filesystem.h"
-#include "stream/filestream.h"
+#include "idatastream.h"
+#include "MappedFile.h"
+#include <vector>
 
 class ZipRecord {
 public:
@@ -28,18 +29,46 @@ public:
 	unsigned int m_file_size;
 	ECompressionMode m_mode;
 };
-typedef GenericFileSystem<ZipRecord> ZipFileSystem;
 
+/**
+ * A PK4 archive. The archive file is memory mapped, the central directory
+ * is read into a flat index sorted by path. The index is not modified
+ * after construction and opening files doesn't touch any shared stream
+ * state, so files can be opened and read from several threads at once.
+ *
+ * If the archive can't be mapped (e.g. when running out of address
+ * space), the files are read through file streams of their own instead.
+ */
 class ZipArchive :
 	public Archive
 {
-	ZipFileSystem m_filesystem;
+	// An entry of the directory index, directories are implied by the paths
+	struct IndexEntry
+	{
+		std::string path;
+		unsigned int depth;
+		bool isDirectory;
+		ZipRecord record;
+
+		IndexEntry(const std::string& path_, bool isDirectory_, const ZipRecord& record_);
+	};
+	typedef std::vector<IndexEntry> Index;
+
+	// Sorted by path, case-insensitive
+	Index _index;
+
 	std::string m_name;
-	FileInputStream m_istream;
+
+	// The mod directory reported by the text files
+	std::string _modDir;
+
+	// NULL if the archive couldn't be mapped
+	archive::MappedFilePtr _mappedFile;
+
+	bool _failed;
 
 public:
 	ZipArchive(const std::string& name);
-	virtual ~ZipArchive();
 
 	bool failed();
 
@@ -50,8 +79,21 @@ public:
 	void forEachFile(VisitorFunc visitor, const std::string& root);
 
 private:
-	bool read_record();
-	bool read_pkzip();
+	// Returns the entry of the given path or NULL if not found
+	const IndexEntry* findEntry(const std::string& path) const;
+
+	// Returns the file entry of the given path or NULL if not found
+	const ZipRecord* findFile(const std::string& path) const;
+
+	// Reads the local header of the given file to find the offset of its data,
+	// returns false if the header or the data are invalid
+	bool getDataPosition(const ZipRecord& file, std::size_t& position) const;
+
+	bool read_record(SeekableInputStream& istream);
+	bool read_pkzip(SeekableInputStream& istream);
+
+	// Sorts the index and drops the duplicated entries
+	void sortIndex();
 };
 typedef boost::shared_ptr<ZipArchive> ZipArchivePtr;
 
@@ -33,7 +33,7 @@ class DeflatedInputStream : public InputStream
 {
   InputStream& m_istream;
   z_stream m_zipstream;
-  enum unnamed0 { m_bufsize = 1024 };
+  enum unnamed0 { m_bufsize = 65536 };
   unsigned char m_buffer[m_bufsize];
 
 public:
@@ -70,6 +70,55 @@ public:
   }
 };
 
+/// \brief Decompresses deflated data which is completely available in memory.
+///
+/// - Inflates straight from the source memory, without an intermediate buffer.
+/// - Doesn't share any state with other streams, so several of them can be read in parallel.
+class DeflatedMemoryInputStream : public InputStream
+{
+  z_stream m_zipstream;
+  bool m_finished;
+
+public:
+  DeflatedMemoryInputStream(const byte_type* data, size_type size)
+    : m_finished(false)
+  {
+    m_zipstream.zalloc = 0;
+    m_zipstream.zfree = 0;
+    m_zipstream.opaque = 0;
+    m_zipstream.next_in = const_cast<byte_type*>(data);
+    m_zipstream.avail_in = static_cast<uInt>(size);
+    inflateInit2(&m_zipstream, -MAX_WBITS);
+  }
+  ~DeflatedMemoryInputStream()
+  {
+    inflateEnd(&m_zipstream);
+  }
+  size_type read(byte_type* buffer, size_type length)
+  {
+    if(m_finished)
+    {
+      return 0;
+    }
+
+    m_zipstream.next_out = buffer;
+    m_zipstream.avail_out = static_cast<uInt>(length);
+
+    while(m_zipstream.avail_out != 0)
+    {
+      int result = inflate(&m_zipstream, Z_SYNC_FLUSH);
+
+      // All the input is there, so anything but progress means the end
+      if(result != Z_OK)
+      {
+        m_finished = true;
+        break;
+      }
+    }
+    return length - m_zipstream.avail_out;
+  }
+};
+
 #endif
 
 
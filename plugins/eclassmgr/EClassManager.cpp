@@ -10,6 +10,7 @@
 #include "ifilesystem.h"
 #include "archivelib.h"
 #include "parser/DefTokeniser.h"
+#include "parser/ParallelDeclLoader.h"
 
 #include "Doom3EntityClass.h"
 #include "Doom3ModelDef.h"
@@ -130,9 +131,34 @@ void EClassManager::parseDefFiles()
 	// Increase the parse stamp for this run
 	_curParseStamp++;
 
+	typedef parser::TokenListTokeniser::Tokens Tokens;
+	parser::ParallelDeclLoader<Tokens> loader("def/", &parser::tokeniseDefs);
+
+	GlobalFileSystem().forEachFile("def/", "def", loader);
+
+	{
+		ScopedDebugTimer timer("EntityDefs tokenised: ");
+		loader.run();
+	}
+
+	ScopedDebugTimer timer("EntityDefs parsed: ");
+
+	// Parse in VFS order to keep the redefinition warnings and mod names
+	parser::ParallelDeclLoader<Tokens>::Files& files = loader.getFiles();
+
+	for (std::size_t i = 0; i < files.size(); ++i)
 	{
-		ScopedDebugTimer timer("EntityDefs parsed: ");
-		GlobalFileSystem().forEachFile("def/", "def", *this);
+		if (!files[i].opened) continue;
+
+		try {
+			// Parse entity defs from the file, a tokeniser error is thrown where it occurred
+			parser::TokenListTokeniser tokeniser(files[i].result, files[i].error);
+			parse(tokeniser, files[i].modName);
+		}
+		catch (parser::ParseException& e) {
+			rError() << "[eclassmgr] failed to parse " << files[i].name
+					  << " (" << e.what() << ")" << std::endl;
+		}
 	}
 }
 
@@ -319,14 +345,10 @@ void EClassManager::onFileSystemShutdown()
 	unrealise();
 }
 
-// Parse the provided stream containing the contents of a single .def file.
+// Parse the provided tokens containing the contents of a single .def file.
 // Extract all entitydefs and create objects accordingly.
-void EClassManager::parse(TextInputStream& inStr, const std::string& modDir)
+void EClassManager::parse(parser::DefTokeniser& tokeniser, const std::string& modDir)
 {
-	// Construct a tokeniser for the stream
-	std::istream is(&inStr);
-    parser::BasicDefTokeniser<std::istream> tokeniser(is);
-
     while (tokeniser.hasMoreTokens())
 	{
         std::string blockType = tokeniser.nextToken();
@@ -415,22 +437,4 @@ void EClassManager::parse(TextInputStream& inStr, const std::string& modDir)
     }
 }
 
-void EClassManager::visit(const std::string& filename)
-{
-	const std::string fullname = "def/" + filename;
-
-	ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(fullname);
-
-	if (file == NULL) return;
-
-	try {
-		// Parse entity defs from the file
-		parse(file->getInputStream(), file->getModName());
-	}
-		catch (parser::ParseException& e) {
-			rError() << "[eclassmgr] failed to parse " << filename
-					  << " (" << e.what() << ")" << std::endl;
-	}
-}
-
 } // namespace eclass
@@ -22,18 +22,16 @@ namespace eclass
 /**
  * EClassManager - master entity loader
  *
- * This class is the master loader for the entity classes. It ensures that the
- * loadFile() function is called for every .def file in the def/ directory,
- * which in turn kicks off the parse process (including the resolution of
- * inheritance).
+ * This class is the master loader for the entity classes. It tokenises every
+ * .def file in the def/ directory (on several threads) and parses the tokens
+ * in VFS order, followed by the resolution of inheritance.
  *
  * It also accomodates ModuleObservers, presumably to be notified when the
  * dependency modules are realised. This one depends on the VFS.
  */
 class EClassManager :
     public IEntityClassManager,
-    public VirtualFileSystem::Observer,
-	public VirtualFileSystem::Visitor
+    public VirtualFileSystem::Observer
 {
     // Whether the entity classes have been realised
     bool _realised;
@@ -81,17 +79,14 @@ public:
 	virtual void initialiseModule(const ApplicationContext& ctx);
 	virtual void shutdownModule();
 
-	// Method loading the DEF files (gets called by GlobalFilesystem().foreach()).
-	void visit(const std::string& filename);
-
 private:
 	// Tries to insert the given eclass, not overwriting existing ones
 	// In either case, the eclass in the map is returned
 	Doom3EntityClassPtr insertUnique(const Doom3EntityClassPtr& eclass);
     Doom3EntityClassPtr findInternal(const std::string& name) const;
 
-	// Parses the given inputstream for DEFs.
-	void parse(TextInputStream& inStr, const std::string& modDir);
+	// Parses the tokens of a single .def file for DEFs.
+	void parse(parser::DefTokeniser& tokeniser, const std::string& modDir);
 
 	// Recursively resolves the inheritance of the model defs
 	void resolveModelInheritance(const std::string& name, const Doom3ModelDefPtr& model);
@@ -295,6 +295,8 @@ const ShaderPtr& EntityNode::getFillShader() const
 
 void EntityNode::onPostUndo()
 {
+	_modelKey.restoreLoadedModel();
+
 	// After undo operations there might remain some child nodes
 	// without renderentity, rectify that
 	foreachNode([&] (const scene::INodePtr& child)->bool
@@ -306,6 +308,8 @@ void EntityNode::onPostUndo()
 
 void EntityNode::onPostRedo()
 {
+	_modelKey.restoreLoadedModel();
+
 	// After redo operations there might remain some child nodes
 	// without renderentity, rectify that
 	foreachNode([&] (const scene::INodePtr& child)->bool
@@ -1,10 +1,12 @@
 #include "ModelKey.h"
 
 #include "imodelcache.h"
+#include "iundo.h"
 #include "ifiletypes.h"
 #include "scene/Node.h"
 #include "ifilter.h"
 #include "modelskin.h"
+#include <vector>
 #include <boost/algorithm/string/replace.hpp>
 
 ModelKey::ModelKey(scene::INode& parentNode) :
@@ -29,7 +31,7 @@ void ModelKey::refreshModel()
 	// Check if we have a skinnable model and remember the skin
 	SkinnedModelPtr skinned = boost::dynamic_pointer_cast<SkinnedModel>(_modelNode);
 
-	std::string skin = skinned ? skinned->getSkin() : "";
+	std::string skin = skinned ? skinned->getSkin() : _skin;
 	
 	attachModelNode();
 	
@@ -64,6 +66,11 @@ void ModelKey::modelChanged(const std::string& value)
 
 void ModelKey::attachModelNode()
 {
+	// A pending background load is of no interest anymore
+	_proxyConnection.disconnect();
+	_undoConnection.disconnect();
+	_pendingModelNode.reset();
+
 	// Remove the old model node first
 	if (_modelNode != NULL)
 	{
@@ -79,8 +86,23 @@ void ModelKey::attachModelNode()
 
 	// We have a non-empty model key, send the request to
 	// the model cache to acquire a new child node
-	_modelNode = GlobalModelCache().getModelNode(_modelPath);
+	_modelNode = GlobalModelCache().getModelNodeAsync(_modelPath);
+
+	// Get notified when the placeholder can be replaced
+	model::IModelProxyNodePtr proxy = boost::dynamic_pointer_cast<model::IModelProxyNode>(_modelNode);
+
+	if (proxy)
+	{
+		_proxyConnection = proxy->signal_modelLoaded().connect(
+			sigc::mem_fun(*this, &ModelKey::onModelLoaded)
+		);
+	}
+
+	insertModelNode();
+}
 
+void ModelKey::insertModelNode()
+{
 	// The model loader should not return NULL, but a sanity check is always ok
 	if (_modelNode)
 	{
@@ -105,8 +127,124 @@ void ModelKey::attachModelNode()
 	}
 }
 
+void ModelKey::onModelLoaded(const scene::INodePtr& modelNode)
+{
+	_proxyConnection.disconnect();
+
+	if (!_active) return; // parent node is being destroyed
+
+	// Swapping the children now would save the placeholder in the running
+	// operation (e.g. a drag), undoing it would bring the placeholder back
+	if (GlobalUndoSystem().operationStarted())
+	{
+		_pendingModelNode = modelNode;
+		_undoConnection = GlobalUndoSystem().signal_operationFinished().connect(
+			sigc::mem_fun(*this, &ModelKey::onUndoOperationFinished)
+		);
+		return;
+	}
+
+	replaceModelNode(modelNode);
+}
+
+void ModelKey::onUndoOperationFinished()
+{
+	_undoConnection.disconnect();
+
+	scene::INodePtr modelNode;
+	modelNode.swap(_pendingModelNode);
+
+	if (!_active) return;
+
+	replaceModelNode(modelNode);
+}
+
+void ModelKey::replaceModelNode(const scene::INodePtr& modelNode)
+{
+	if (_modelNode)
+	{
+		_parentNode.removeChildNode(_modelNode);
+	}
+
+	_modelNode = modelNode;
+
+	insertModelNode();
+
+	// The placeholder couldn't take the skin
+	SkinnedModelPtr skinned = boost::dynamic_pointer_cast<SkinnedModel>(_modelNode);
+
+	if (skinned && !_skin.empty())
+	{
+		skinned->skinChanged(_skin);
+	}
+}
+
+namespace
+{
+	// Collects the placeholders among the direct children of a node, except
+	// for the given model node, and checks whether that one is a child
+	class ProxyCollector :
+		public scene::NodeVisitor
+	{
+		const scene::INodePtr& _modelNode;
+
+	public:
+		std::vector<scene::INodePtr> proxies;
+		bool modelIsChild;
+
+		ProxyCollector(const scene::INodePtr& modelNode) :
+			_modelNode(modelNode),
+			modelIsChild(false)
+		{}
+
+		bool pre(const scene::INodePtr& node)
+		{
+			if (node == _modelNode)
+			{
+				modelIsChild = true;
+			}
+			else if (boost::dynamic_pointer_cast<model::IModelProxyNode>(node))
+			{
+				proxies.push_back(node);
+			}
+
+			return false;
+		}
+	};
+}
+
+void ModelKey::restoreLoadedModel()
+{
+	if (!_active || !_modelNode || _pendingModelNode) return;
+
+	ProxyCollector collector(_modelNode);
+	_parentNode.traverseChildren(collector);
+
+	if (collector.proxies.empty()) return;
+
+	// The undo system is not recording during onPostUndo/onPostRedo,
+	// the placeholders won't come back when redoing
+	for (std::size_t i = 0; i < collector.proxies.size(); ++i)
+	{
+		_parentNode.removeChildNode(collector.proxies[i]);
+	}
+
+	if (collector.modelIsChild) return;
+
+	insertModelNode();
+
+	SkinnedModelPtr skinned = boost::dynamic_pointer_cast<SkinnedModel>(_modelNode);
+
+	if (skinned && !_skin.empty())
+	{
+		skinned->skinChanged(_skin);
+	}
+}
+
 void ModelKey::skinChanged(const std::string& value)
 {
+	_skin = value;
+
 	// Check if we have a skinnable model
 	SkinnedModelPtr skinned = boost::dynamic_pointer_cast<SkinnedModel>(_modelNode);
 
@@ -2,13 +2,18 @@
 
 #include <string>
 #include "inode.h"
+#include <sigc++/trackable.h>
+#include <sigc++/connection.h>
 
 /**
  * greebo: A ModelKey object watches the "model" spawnarg of
  * an entity. As soon as the keyvalue changes, the according
  * modelnode is loaded and inserted into the entity's Traversable.
+ * Models which are not cached yet are loaded in the background,
+ * a placeholder node is inserted until they're available.
  */
-class ModelKey
+class ModelKey :
+	public sigc::trackable
 {
 private:
 	scene::INodePtr _modelNode;
@@ -18,6 +23,16 @@ private:
 
 	std::string _modelPath;
 
+	// The "skin" spawnarg, applied once a background load finishes
+	std::string _skin;
+
+	// Connected to the placeholder node while the model is loading
+	sigc::connection _proxyConnection;
+
+	// A loaded model waiting for the running undo operation to finish
+	scene::INodePtr _pendingModelNode;
+	sigc::connection _undoConnection;
+
 	// To deactivate model handling during node destruction
 	bool _active;
 
@@ -39,7 +54,21 @@ public:
 	// Returns the reference to the "singleton" model node
 	const scene::INodePtr& getNode() const;
 
+	// Called after undo or redo, which might have brought back a
+	// placeholder node that has been replaced by the loaded model since
+	void restoreLoadedModel();
+
 private:
 	// Loads the model node and attaches it to the parent node
 	void attachModelNode();
+
+	// Adds the current model node as child of the parent node
+	void insertModelNode();
+
+	// Replaces the placeholder once the model has been loaded in the background
+	void onModelLoaded(const scene::INodePtr& modelNode);
+	void onUndoOperationFinished();
+
+	// Puts the given node in place of the placeholder
+	void replaceModelNode(const scene::INodePtr& modelNode);
 };
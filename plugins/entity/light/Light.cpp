@@ -792,6 +792,17 @@ AABB Light::lightAABB() const
     return AABB(_originTransformed, m_doom3Radius.m_radiusTransformed);
 }
 
+AABB Light::lightVolumeAABB() const
+{
+    // The volume is rotated around the world origin, so a cube enclosing the
+    // sphere around the origin is sufficient for both light types
+    const AABB& bounds = localAABB();
+
+    double radius = bounds.origin.getLength() + bounds.extents.getLength();
+
+    return AABB(worldOrigin(), Vector3(radius, radius, radius));
+}
+
 bool Light::intersectsAABB(const AABB& other) const
 {
     bool returnVal;
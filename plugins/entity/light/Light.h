@@ -258,6 +258,9 @@ public:
 
     Matrix4 getLightTextureTransformation() const;
   	bool intersectsAABB(const AABB& other) const;
+
+	// Returns world-space bounds enclosing the light volume at any rotation
+	AABB lightVolumeAABB() const;
 	const Matrix4& rotation() const;
 	Vector3 getLightOrigin() const;
 	const Vector3& colour() const;
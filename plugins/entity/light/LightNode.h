@@ -123,6 +123,7 @@ public:
     Matrix4 getLightTextureTransformation() const;
 	ShaderPtr getShader() const;
 	bool intersectsAABB(const AABB& other) const;
+	AABB lightAABB() const;
 
 	Vector3 getLightOrigin() const;
 	const Matrix4& rotation() const;
@@ -3,14 +3,8 @@
 #include <iostream>
 #include "BasicTexture2D.h"
 
-TexturePtr DDSImage::bindTexture(const std::string& name) const
+bool DDSImage::uploadToTexture(GLuint textureNum) const
 {
-    GLuint textureNum;
-
-    GlobalOpenGL().assertNoErrors();
-
-    // Allocate a new texture number and store it into the Texture structure
-    glGenTextures(1, &textureNum);
     glBindTexture(GL_TEXTURE_2D, textureNum);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
@@ -36,11 +30,8 @@ TexturePtr DDSImage::bindTexture(const std::string& name) const
         // Handle unsupported format error
         if (glGetError() == GL_INVALID_ENUM)
         {
-            std::cerr << "[DDSImage] Unable to bind texture '"
-                      << name << "'; unsupported texture format"
-                      << std::endl;
-
-            return TexturePtr();
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return false;
         }
 
         GlobalOpenGL().assertNoErrors();
@@ -51,6 +42,28 @@ TexturePtr DDSImage::bindTexture(const std::string& name) const
     // Un-bind the texture
     glBindTexture(GL_TEXTURE_2D, 0);
 
+    return true;
+}
+
+TexturePtr DDSImage::bindTexture(const std::string& name) const
+{
+    GLuint textureNum;
+
+    GlobalOpenGL().assertNoErrors();
+
+    // Allocate a new texture number and store it into the Texture structure
+    glGenTextures(1, &textureNum);
+
+    if (!uploadToTexture(textureNum))
+    {
+        std::cerr << "[DDSImage] Unable to bind texture '"
+                  << name << "'; unsupported texture format"
+                  << std::endl;
+
+        glDeleteTextures(1, &textureNum);
+        return TexturePtr();
+    }
+
     // Create and return texture object
     BasicTexture2DPtr texObj(new BasicTexture2D(textureNum, name));
     texObj->setWidth(getWidth(0));
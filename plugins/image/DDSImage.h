@@ -119,6 +119,8 @@ public:
     /* BindableTexture implementation */
 	TexturePtr bindTexture(const std::string& name) const;
 
+	bool uploadToTexture(GLuint textureNum) const;
+
 	bool isPrecompressed() const {
 		return true;
 	}
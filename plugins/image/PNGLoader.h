@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <iostream>
 
 ImagePtr LoadPNG(ArchiveFile& file);
+bool GetPNGDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height);
 
 /* Tr3B: A PNGLoader is capable of loading Portable Network Graphic (PNG) files.
  *  
@@ -48,6 +49,11 @@ public:
 		// Pass the call to the according load function
 		return LoadPNG(file);
 	}
+
+	// Reads the width and height from the PNG header
+	bool getDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height) const {
+		return GetPNGDimensions(file, width, height);
+	}
 	
 	/* greebo: Gets the file extension of the supported image file type (e.g. "jpg") 
 	 */
@@ -110,6 +110,30 @@ DDSImagePtr LoadDDSFromStream(InputStream& stream)
 	return image;
 }
 
+bool GetDDSDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height)
+{
+	typedef StreamBase::byte_type byteType;
+	DDSHeader header;
+
+	if (file.getInputStream().read(reinterpret_cast<byteType*>(&header), sizeof(header)) != sizeof(header))
+	{
+		return false;
+	}
+
+	int ddsWidth(0), ddsHeight(0);
+	ddsPF_t pixelFormat;
+
+	if (DDSGetInfo(&header, &ddsWidth, &ddsHeight, &pixelFormat) == -1 || ddsWidth <= 0 || ddsHeight <= 0)
+	{
+		return false;
+	}
+
+	width = static_cast<std::size_t>(ddsWidth);
+	height = static_cast<std::size_t>(ddsHeight);
+
+	return true;
+}
+
 ImagePtr LoadDDS(ArchiveFile& file) {
 	return LoadDDSFromStream(file.getInputStream());
 }
@@ -6,6 +6,7 @@
 #include <iostream>
 
 ImagePtr LoadDDS(ArchiveFile& file);
+bool GetDDSDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height);
 
 /* greebo: A DDSLoader is capable of loading DDS image files.
  *
@@ -28,6 +29,11 @@ public:
 		return LoadDDS(file);
 	}
 
+	// Reads the width and height from the DDS header
+	bool getDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height) const {
+		return GetDDSDimensions(file, width, height);
+	}
+
 	/* greebo: Gets the file extension of the supported image file type (e.g. "dds")
 	 */
 	std::string getExtension() const {
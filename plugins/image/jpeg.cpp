@@ -40,6 +40,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include <jpeglib.h>
 #include <jerror.h>
@@ -249,19 +250,18 @@ static void jpeg_buffer_src (j_decompress_ptr cinfo, void* buffer, int bufsize)
 
 // =============================================================================
 
-static char errormsg[JMSG_LENGTH_MAX];
-
 typedef struct my_jpeg_error_mgr
 {
   struct jpeg_error_mgr pub;  // "public" fields
   jmp_buf setjmp_buffer;      // for return to caller
+  char errormsg[JMSG_LENGTH_MAX]; // per decoder, images may be loaded in parallel
 } bt_jpeg_error_mgr;
 
 static void my_jpeg_error_exit (j_common_ptr cinfo)
 {
   my_jpeg_error_mgr* myerr = (bt_jpeg_error_mgr*) cinfo->err;
 
-  (*cinfo->err->format_message) (cinfo, errormsg);
+  (*cinfo->err->format_message) (cinfo, myerr->errormsg);
 
   longjmp (myerr->setjmp_buffer, 1);
 }
@@ -363,7 +363,7 @@ static RGBAImagePtr LoadJPGBuff_(const void *src_buffer, int src_size)
 
   if (setjmp (jerr.setjmp_buffer)) //< TODO: use c++ exceptions instead of setjmp/longjmp to handle errors
   {
-    rError() << "WARNING: JPEG library error: " << errormsg << "\n";
+    rError() << "WARNING: JPEG library error: " << jerr.errormsg << "\n";
     jpeg_destroy_decompress (&cinfo);
     return RGBAImagePtr();
   }
@@ -403,3 +403,64 @@ ImagePtr LoadJPG(ArchiveFile& file)
   return LoadJPGBuff_(buffer.buffer, static_cast<int>(buffer.length));
 }
 
+bool GetJPGDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height)
+{
+  InputStream& stream = file.getInputStream();
+  InputStream::byte_type data[8];
+
+  // Start of image marker
+  if (stream.read(data, 2) != 2 || data[0] != 0xFF || data[1] != 0xD8)
+  {
+    return false;
+  }
+
+  // Walk the segments until we hit a start of frame marker
+  while (true)
+  {
+    if (stream.read(data, 1) != 1) return false;
+
+    if (data[0] != 0xFF) continue;
+
+    InputStream::byte_type marker = 0xFF;
+
+    // Markers may be preceded by any number of fill bytes
+    while (marker == 0xFF)
+    {
+      if (stream.read(&marker, 1) != 1) return false;
+    }
+
+    // Standalone markers without a length field
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+
+    if (marker == 0xD9 || marker == 0xDA) return false; // end of image or start of scan
+
+    if (stream.read(data, 2) != 2) return false;
+
+    std::size_t length = (data[0] << 8) | data[1];
+
+    if (length < 2) return false;
+
+    // SOF0..SOF15, except DHT, JPG and DAC
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+    {
+      // Sample precision, height, width
+      if (stream.read(data, 5) != 5) return false;
+
+      height = (data[1] << 8) | data[2];
+      width = (data[3] << 8) | data[4];
+
+      return width > 0 && height > 0;
+    }
+
+    // Skip the segment
+    for (std::size_t remaining = length - 2; remaining > 0; )
+    {
+      std::size_t chunk = std::min(remaining, sizeof(data));
+
+      if (stream.read(data, chunk) != chunk) return false;
+
+      remaining -= chunk;
+    }
+  }
+}
+
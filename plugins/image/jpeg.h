@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 
 ImagePtr LoadJPG(ArchiveFile& file);
+bool GetJPGDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height);
 
 /* greebo: A JPGLoader is capable of loading JPEG files.
  *
@@ -57,6 +58,11 @@ public:
 		return LoadJPG(file);
 	}
 
+	// Reads the width and height from the JPEG header
+	bool getDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height) const {
+		return GetJPGDimensions(file, width, height);
+	}
+
 	/* greebo: Gets the file extension of the supported image file type (e.g. "jpg")
 	 */
 	std::string getExtension() const {
@@ -181,3 +181,20 @@ ImagePtr LoadPNG(ArchiveFile& file)
 	ScopedArchiveBuffer buffer(file);
 	return LoadPNGBuff(buffer.buffer);//, static_cast<int>(buffer.length));
 }
+
+bool GetPNGDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height)
+{
+	// 8 bytes signature, followed by the IHDR chunk (length, type, width, height)
+	png_byte header[24];
+
+	if (file.getInputStream().read(header, sizeof(header)) != sizeof(header) ||
+		png_sig_cmp(header, 0, 8) != 0)
+	{
+		return false;
+	}
+
+	width = png_get_uint_32(header + 16);
+	height = png_get_uint_32(header + 20);
+
+	return width > 0 && height > 0;
+}
@@ -419,3 +419,19 @@ ImagePtr LoadTGA(ArchiveFile& file)
   ScopedArchiveBuffer buffer(file);
   return LoadTGABuff(buffer.buffer);
 }
+
+bool GetTGADimensions(ArchiveFile& file, std::size_t& width, std::size_t& height)
+{
+  // The fixed-size part of the header is 18 bytes, the size is stored at offset 12
+  byte header[18];
+
+  if (file.getInputStream().read(header, sizeof(header)) != sizeof(header))
+  {
+    return false;
+  }
+
+  width = header[12] | (header[13] << 8);
+  height = header[14] | (header[15] << 8);
+
+  return width > 0 && height > 0;
+}
@@ -6,6 +6,7 @@
 #include <iostream>
 
 ImagePtr LoadTGA(ArchiveFile& file);
+bool GetTGADimensions(ArchiveFile& file, std::size_t& width, std::size_t& height);
 
 /* greebo: A TGALoader is capable of loading TGA files.
  *
@@ -28,6 +29,11 @@ public:
 		return LoadTGA(file);
 	}
 
+	// Reads the width and height from the TGA header
+	bool getDimensions(ArchiveFile& file, std::size_t& width, std::size_t& height) const {
+		return GetTGADimensions(file, width, height);
+	}
+
 	/* greebo: Gets the file extension of the supported image file type (e.g. "tga")
 	 */
 	std::string getExtension() const {
@@ -3,14 +3,201 @@
 #include "itextstream.h"
 #include "string/convert.h"
 
+#include <cmath>
+#include <cstring>
+
 namespace md5
 {
 
+namespace
+{
+	// Increase this whenever the file layout changes
+	const guint32 CACHE_FILE_VERSION = 1;
+
+	const char CACHE_FILE_MAGIC[4] = { 'D', 'R', 'M', 'A' };
+
+	// The layout of the cache files: the header is followed by the joint table
+	// and the string data (command line and joint names, padded to four bytes).
+	// After that come the base frame (seven floats per joint), the bounds
+	// (six floats per frame) and the frame table as described in MD5Anim.h.
+	struct CacheFileHeader
+	{
+		char magic[4];
+		guint32 version;
+		gint32 frameRate;
+		gint32 numAnimatedComponents;
+		guint32 numJoints;
+		guint32 numFrames;
+		guint32 commandLineLength;
+		guint32 stringSize;
+	};
+
+	struct CacheFileJoint
+	{
+		gint32 parentId;
+		guint32 animComponents;
+		guint32 firstKey;
+		guint32 nameOffset; // relative to the string data
+		guint32 nameLength;
+	};
+
+	// Calculates the fourth component of a unit quaternion
+	inline float getQuaternionW(float x, float y, float z)
+	{
+		float w = -sqrt(1.0f - (x*x + y*y + z*z));
+
+		return isNaN(w) ? 0 : w;
+	}
+
+	// Returns the weights to slerp from qa to qb, in the way the MD5Skeleton
+	// used to do it. The second weight is negated if qb has to be flipped.
+	inline void getSlerpRatios(float cosHalfTheta, float fraction, float& ratioA, float& ratioB)
+	{
+		// if qa=qb or qa=-qb then theta = 0 and we can return qb
+		if (std::fabs(cosHalfTheta) > 1.0f)
+		{
+			ratioA = 0;
+			ratioB = 1;
+			return;
+		}
+
+		// greebo: I spotted this fix in the D3 SDK - sometimes we run into rotations
+		// of theta being almost 2*pi which can lead to huge rotational steps (~90 degrees)
+		// in a single frame - use this to rectify that.
+		float sign = 1.0f;
+
+		if (cosHalfTheta < 0.0f)
+		{
+			sign = -1.0f;
+			cosHalfTheta = -cosHalfTheta;
+		}
+
+		float halfTheta = acos(cosHalfTheta);
+		float sinHalfTheta = sqrt(1.0f - cosHalfTheta*cosHalfTheta);
+
+		// if theta = 180 degrees then result is not fully defined
+		// we could rotate around any axis normal to qa or qb
+		if (std::fabs(sinHalfTheta) < 0.006f)
+		{
+			ratioA = 1 - fraction;
+			ratioB = fraction * sign;
+			return;
+		}
+
+		ratioA = sin((1 - fraction) * halfTheta) / sinHalfTheta;
+		ratioB = sin(fraction * halfTheta) / sinHalfTheta * sign;
+	}
+}
+
 MD5Anim::MD5Anim() :
 	_frameRate(0),
-	_numAnimatedComponents(-1)
+	_numAnimatedComponents(-1),
+	_numFrames(0),
+	_frameTable(NULL),
+	_mappedFile(NULL)
 {}
 
+MD5Anim::~MD5Anim()
+{
+	if (_mappedFile != NULL)
+	{
+		g_mapped_file_unref(_mappedFile);
+	}
+}
+
+void MD5Anim::getJointPoses(std::size_t time, Keys& poses) const
+{
+	const std::size_t numJoints = _joints.size();
+
+	if (_numFrames == 0 || _frameRate <= 0 || numJoints == 0)
+	{
+		poses = _baseFrame;
+		return;
+	}
+
+	poses.resize(numJoints);
+
+	// Calculate the current frame number
+	float timePerFrameMsec = 1000 / static_cast<float>(_frameRate);
+
+	float frameTime = time / timePerFrameMsec;
+
+	// Pre-calculate the weighting of the next frame
+	float nextFrameFrac = float_mod(frameTime, 1.0f);
+
+	std::size_t curFrame = static_cast<std::size_t>(std::floor(frameTime)) % _numFrames;
+	std::size_t nextFrame = curFrame == _numFrames - 1 ? curFrame : (curFrame + 1) % _numFrames;
+
+	std::vector<float> pose(7 * numJoints);
+
+	interpolateFrames(getFrame(curFrame), getFrame(nextFrame), nextFrameFrac, numJoints, &pose[0]);
+
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		Key& key = poses[i];
+
+		key.origin = Vector3(pose[i], pose[numJoints + i], pose[2*numJoints + i]);
+		key.orientation = Quaternion(pose[3*numJoints + i], pose[4*numJoints + i],
+									 pose[5*numJoints + i], pose[6*numJoints + i]);
+	}
+}
+
+void MD5Anim::interpolateFrames(const float* first, const float* second, float fraction,
+								std::size_t numJoints, float* out)
+{
+	const std::size_t n = numJoints;
+	const float firstFraction = 1.0f - fraction;
+
+	// The positions are blended linearly, all three arrays in one go
+	for (std::size_t i = 0; i < 3*n; ++i)
+	{
+		out[i] = first[i] * firstFraction + second[i] * fraction;
+	}
+
+	const float* qa = first + 3*n;
+	const float* qb = second + 3*n;
+	float* q = out + 3*n;
+
+	// The angles between the orientations go into the slerp weights
+	std::vector<float> ratios(2*n);
+	float* ratioA = &ratios[0];
+	float* ratioB = &ratios[n];
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		ratioA[i] = qa[i]*qb[i] + qa[n+i]*qb[n+i] + qa[2*n+i]*qb[2*n+i] + qa[3*n+i]*qb[3*n+i];
+	}
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		getSlerpRatios(ratioA[i], fraction, ratioA[i], ratioB[i]);
+	}
+
+	for (std::size_t c = 0; c < 4*n; c += n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			q[c+i] = qa[c+i] * ratioA[i] + qb[c+i] * ratioB[i];
+		}
+	}
+
+	// Normalise the orientations
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		float length = sqrt(q[i]*q[i] + q[n+i]*q[n+i] + q[2*n+i]*q[2*n+i] + q[3*n+i]*q[3*n+i]);
+
+		if (length > 0)
+		{
+			float invLength = 1.0f / length;
+
+			q[i] *= invLength;
+			q[n+i] *= invLength;
+			q[2*n+i] *= invLength;
+			q[3*n+i] *= invLength;
+		}
+	}
+}
+
 void MD5Anim::parseJointHierarchy(parser::DefTokeniser& tok)
 {
 	tok.assertNextToken("hierarchy");
@@ -50,7 +237,7 @@ void MD5Anim::parseFrameBounds(parser::DefTokeniser& tok)
 	tok.assertNextToken("bounds");
 	tok.assertNextToken("{");
 		
-	for (std::size_t i = 0; i < _frames.size(); ++i)
+	for (std::size_t i = 0; i < _numFrames; ++i)
 	{
 		tok.assertNextToken("(");
 
@@ -121,77 +308,330 @@ void MD5Anim::parseFrame(std::size_t frame, parser::DefTokeniser& tok)
 
 	tok.assertNextToken("{");
 
-	// Reserve space for the floats
-	_frames[parsedFrameNum].resize(_numAnimatedComponents);
-
 	// Each frame block has <numAnimatedComponents> float values
-	for (std::size_t i = 0; i < _numAnimatedComponents; ++i)
+	std::vector<float> components(std::max(_numAnimatedComponents, 0));
+
+	for (std::size_t i = 0; i < components.size(); ++i)
 	{
-		_frames[parsedFrameNum][i] = string::convert<float>(tok.nextToken());
+		components[i] = string::convert<float>(tok.nextToken());
 	}
 
 	tok.assertNextToken("}");
+
+	// Apply the animated components to the base frame, the joint.firstKey
+	// member holds the offset into the component array
+	const std::size_t numJoints = _joints.size();
+	float* table = &_frameTableStorage[frame * 7 * numJoints];
+
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		const Joint& joint = _joints[i];
+		const Key& baseKey = _baseFrame[i];
+
+		float values[7] = {
+			static_cast<float>(baseKey.origin.x()),
+			static_cast<float>(baseKey.origin.y()),
+			static_cast<float>(baseKey.origin.z()),
+			static_cast<float>(baseKey.orientation.x()),
+			static_cast<float>(baseKey.orientation.y()),
+			static_cast<float>(baseKey.orientation.z()),
+			static_cast<float>(baseKey.orientation.w())
+		};
+
+		std::size_t key = joint.firstKey;
+
+		// X, Y, Z, YAW, PITCH and ROLL map to the first six values
+		for (std::size_t c = 0; c < 6; ++c)
+		{
+			if ((joint.animComponents & (1 << c)) && key < components.size())
+			{
+				values[c] = components[key++];
+			}
+		}
+
+		if (joint.animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL))
+		{
+			values[6] = getQuaternionW(values[3], values[4], values[5]);
+		}
+
+		for (std::size_t c = 0; c < 7; ++c)
+		{
+			table[c * numJoints + i] = values[c];
+		}
+	}
 }
 
-void MD5Anim::parseFromStream(std::istream& stream)
+bool MD5Anim::parseFromStream(std::istream& stream)
 {
 	parser::BasicDefTokeniser<std::istream> tokeniser(stream);
-	parseFromTokens(tokeniser);
+
+	try
+	{
+		parseFromTokens(tokeniser);
+		return true;
+	}
+	catch (parser::ParseException& ex)
+	{
+		rError() << "Error parsing MD5 Animation: " << ex.what() << std::endl;
+		return false;
+	}
 }
 
 void MD5Anim::parseFromTokens(parser::DefTokeniser& tok)
 {
-	try
+	tok.assertNextToken("MD5Version");
+
+	int version = string::convert<int>(tok.nextToken());
+
+	if (version != 10)
 	{
-		tok.assertNextToken("MD5Version");
+		rWarning() << "Unexpected version encountered: " << version 
+			<< " (expected 10), will attempt to load anyway." << std::endl;
+	}
+
+	tok.assertNextToken("commandline");
+	_commandLine = tok.nextToken();
 
-		int version = string::convert<int>(tok.nextToken());
+	tok.assertNextToken("numFrames");
+	int numFrames = string::convert<int>(tok.nextToken());
 
-		if (version != 10)
+	tok.assertNextToken("numJoints");
+	std::size_t numJoints = string::convert<std::size_t>(tok.nextToken());
+
+	// Adjust the arrays
+	_numFrames = static_cast<std::size_t>(std::max(numFrames, 0));
+	_joints.resize(numJoints);
+	_bounds.resize(_numFrames);
+	_baseFrame.resize(numJoints);
+
+	tok.assertNextToken("frameRate");
+	_frameRate = string::convert<int>(tok.nextToken());
+
+	tok.assertNextToken("numAnimatedComponents");
+	_numAnimatedComponents = string::convert<int>(tok.nextToken());
+
+	// Parse hierarchy block
+	parseJointHierarchy(tok);
+	
+	// Parse bounds block
+	parseFrameBounds(tok);
+
+	// Parse base frame
+	parseBaseFrame(tok);
+
+	// Frames that fail to parse keep the base frame pose
+	_frameTableStorage.resize(_numFrames * 7 * numJoints);
+	_frameTable = _frameTableStorage.empty() ? NULL : &_frameTableStorage[0];
+
+	for (std::size_t i = 0; i < _numFrames; ++i)
+	{
+		float* table = &_frameTableStorage[i * 7 * numJoints];
+
+		for (std::size_t j = 0; j < numJoints; ++j)
 		{
-			rWarning() << "Unexpected version encountered: " << version 
-				<< " (expected 10), will attempt to load anyway." << std::endl;
+			table[j] = static_cast<float>(_baseFrame[j].origin.x());
+			table[numJoints + j] = static_cast<float>(_baseFrame[j].origin.y());
+			table[2*numJoints + j] = static_cast<float>(_baseFrame[j].origin.z());
+			table[3*numJoints + j] = static_cast<float>(_baseFrame[j].orientation.x());
+			table[4*numJoints + j] = static_cast<float>(_baseFrame[j].orientation.y());
+			table[5*numJoints + j] = static_cast<float>(_baseFrame[j].orientation.z());
+			table[6*numJoints + j] = static_cast<float>(_baseFrame[j].orientation.w());
 		}
+	}
+
+	// Parse each actual frame
+	for (std::size_t i = 0; i < _numFrames; ++i)
+	{
+		parseFrame(i, tok);
+	}
+}
 
-		tok.assertNextToken("commandline");
-		_commandLine = tok.nextToken();
+bool MD5Anim::loadFromCacheFile(GMappedFile* file)
+{
+	const char* data = g_mapped_file_get_contents(file);
+	std::size_t length = g_mapped_file_get_length(file);
 
-		tok.assertNextToken("numFrames");
-		int numFrames = string::convert<int>(tok.nextToken());
+	CacheFileHeader header;
 
-		tok.assertNextToken("numJoints");
-		std::size_t numJoints = string::convert<std::size_t>(tok.nextToken());
+	if (data == NULL || length < sizeof(header))
+	{
+		return false;
+	}
 
-		// Adjust the arrays
-		_joints.resize(numJoints);
-		_bounds.resize(numFrames);
-		_baseFrame.resize(numJoints);
-		_frames.resize(numFrames);
+	std::memcpy(&header, data, sizeof(header));
 
-		tok.assertNextToken("frameRate");
-		_frameRate = string::convert<int>(tok.nextToken());
+	if (std::memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != CACHE_FILE_VERSION ||
+		header.commandLineLength > header.stringSize ||
+		header.stringSize % 4 != 0)
+	{
+		return false;
+	}
 
-		tok.assertNextToken("numAnimatedComponents");
-		_numAnimatedComponents = string::convert<int>(tok.nextToken());
+	const std::size_t numJoints = header.numJoints;
+	const std::size_t numFrames = header.numFrames;
 
-		// Parse hierarchy block
-		parseJointHierarchy(tok);
-		
-		// Parse bounds block
-		parseFrameBounds(tok);
+	// Compare the sizes in 64 bits, the counts come from the file
+	guint64 expectedLength = sizeof(header) + static_cast<guint64>(numJoints) * sizeof(CacheFileJoint) +
+		header.stringSize + (static_cast<guint64>(numJoints) * 7 + static_cast<guint64>(numFrames) * 6 +
+		static_cast<guint64>(numFrames) * numJoints * 7) * sizeof(float);
+
+	if (expectedLength != length)
+	{
+		return false;
+	}
+
+	const char* joints = data + sizeof(header);
+	const char* strings = joints + numJoints * sizeof(CacheFileJoint);
+	const float* floats = reinterpret_cast<const float*>(strings + header.stringSize);
+
+	std::vector<Joint> parsedJoints(numJoints);
 
-		// Parse base frame
-		parseBaseFrame(tok);
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		CacheFileJoint record;
+		std::memcpy(&record, joints + i * sizeof(record), sizeof(record));
 
-		// Parse each actual frame
-		for (std::size_t i = 0; i < _frames.size(); ++i)
+		if (record.parentId < -1 || record.parentId >= static_cast<gint32>(numJoints) ||
+			record.parentId == static_cast<gint32>(i) ||
+			static_cast<std::size_t>(record.nameOffset) + record.nameLength > header.stringSize)
 		{
-			parseFrame(i, tok);
+			return false;
 		}
+
+		Joint& joint = parsedJoints[i];
+
+		joint.id = static_cast<int>(i);
+		joint.name.assign(strings + record.nameOffset, record.nameLength);
+		joint.parentId = record.parentId;
+		joint.animComponents = record.animComponents;
+		joint.firstKey = record.firstKey;
 	}
-	catch (parser::ParseException& ex)
+
+	for (std::size_t i = 0; i < numJoints; ++i)
 	{
-		rError() << "Error parsing MD5 Animation: " << ex.what() << std::endl;
+		if (parsedJoints[i].parentId >= 0)
+		{
+			parsedJoints[parsedJoints[i].parentId].children.push_back(parsedJoints[i].id);
+		}
+	}
+
+	_commandLine.assign(strings, header.commandLineLength);
+	_frameRate = header.frameRate;
+	_numAnimatedComponents = header.numAnimatedComponents;
+	_joints.swap(parsedJoints);
+
+	_baseFrame.resize(numJoints);
+
+	for (std::size_t i = 0; i < numJoints; ++i, floats += 7)
+	{
+		_baseFrame[i].origin = Vector3(floats[0], floats[1], floats[2]);
+		_baseFrame[i].orientation = Quaternion(floats[3], floats[4], floats[5], floats[6]);
+	}
+
+	_bounds.resize(numFrames);
+
+	for (std::size_t i = 0; i < numFrames; ++i, floats += 6)
+	{
+		_bounds[i].origin = Vector3(floats[0], floats[1], floats[2]);
+		_bounds[i].extents = Vector3(floats[3], floats[4], floats[5]);
+	}
+
+	// The frame table is used right from the mapped file
+	_numFrames = numFrames;
+	_frameTable = floats;
+	_frameTableStorage.clear();
+
+	if (_mappedFile != NULL)
+	{
+		g_mapped_file_unref(_mappedFile);
+	}
+
+	_mappedFile = file;
+
+	return true;
+}
+
+void MD5Anim::writeCacheFile(std::ostream& stream) const
+{
+	const std::size_t numJoints = _joints.size();
+
+	// Collect the strings and the joint records
+	std::string strings = _commandLine;
+	std::vector<CacheFileJoint> joints(numJoints);
+
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		const Joint& joint = _joints[i];
+		CacheFileJoint& record = joints[i];
+
+		record.parentId = joint.parentId;
+		record.animComponents = static_cast<guint32>(joint.animComponents);
+		record.firstKey = static_cast<guint32>(joint.firstKey);
+		record.nameOffset = static_cast<guint32>(strings.size());
+		record.nameLength = static_cast<guint32>(joint.name.size());
+
+		strings += joint.name;
+	}
+
+	// Keep the floats aligned
+	strings.resize((strings.size() + 3) & ~static_cast<std::size_t>(3), '\0');
+
+	CacheFileHeader header;
+	std::memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_FILE_VERSION;
+	header.frameRate = _frameRate;
+	header.numAnimatedComponents = _numAnimatedComponents;
+	header.numJoints = static_cast<guint32>(numJoints);
+	header.numFrames = static_cast<guint32>(_numFrames);
+	header.commandLineLength = static_cast<guint32>(_commandLine.size());
+	header.stringSize = static_cast<guint32>(strings.size());
+
+	std::vector<float> floats;
+	floats.reserve(numJoints * 7 + _numFrames * 6);
+
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		const Key& key = _baseFrame[i];
+
+		floats.push_back(static_cast<float>(key.origin.x()));
+		floats.push_back(static_cast<float>(key.origin.y()));
+		floats.push_back(static_cast<float>(key.origin.z()));
+		floats.push_back(static_cast<float>(key.orientation.x()));
+		floats.push_back(static_cast<float>(key.orientation.y()));
+		floats.push_back(static_cast<float>(key.orientation.z()));
+		floats.push_back(static_cast<float>(key.orientation.w()));
+	}
+
+	for (std::size_t i = 0; i < _numFrames; ++i)
+	{
+		const AABB& bounds = _bounds[i];
+
+		floats.push_back(static_cast<float>(bounds.origin.x()));
+		floats.push_back(static_cast<float>(bounds.origin.y()));
+		floats.push_back(static_cast<float>(bounds.origin.z()));
+		floats.push_back(static_cast<float>(bounds.extents.x()));
+		floats.push_back(static_cast<float>(bounds.extents.y()));
+		floats.push_back(static_cast<float>(bounds.extents.z()));
+	}
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	if (!joints.empty())
+	{
+		stream.write(reinterpret_cast<const char*>(&joints[0]), joints.size() * sizeof(CacheFileJoint));
+	}
+
+	stream.write(strings.data(), strings.size());
+
+	if (!floats.empty())
+	{
+		stream.write(reinterpret_cast<const char*>(&floats[0]), floats.size() * sizeof(float));
+	}
+
+	if (_frameTable != NULL)
+	{
+		stream.write(reinterpret_cast<const char*>(_frameTable), _numFrames * 7 * numJoints * sizeof(float));
 	}
 }
 
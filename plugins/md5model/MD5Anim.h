@@ -2,6 +2,9 @@
 
 #include "imd5anim.h"
 #include <vector>
+#include <ostream>
+#include <glib.h>
+#include <boost/noncopyable.hpp>
 #include "parser/DefTokeniser.h"
 #include "math/AABB.h"
 #include "math/Vector3.h"
@@ -13,7 +16,8 @@ namespace md5
 class MD5AnimTokeniser;
 
 class MD5Anim :
-	public IMD5Anim
+	public IMD5Anim,
+	public boost::noncopyable
 {
 private:
 	// The command line used to export this md5anim def
@@ -27,15 +31,24 @@ private:
 	// One AABB per frame
 	std::vector<AABB> _bounds;
 
-	typedef std::vector<IMD5Anim::Key> Keys;
-
 	Keys _baseFrame;
 
-	// Each frame has <numAnimatedComponents> float values
-	std::vector<FrameKeys> _frames;
+	std::size_t _numFrames;
+
+	// The joint poses of all frames, decompressed from the animated components.
+	// Each frame holds seven arrays of <numJoints> floats: the x, y and z
+	// position followed by the x, y, z and w orientation components.
+	const float* _frameTable;
+
+	// The frame table of animations parsed from text
+	std::vector<float> _frameTableStorage;
+
+	// The binary cache file the frame table points into, or NULL
+	GMappedFile* _mappedFile;
 
 public:
 	MD5Anim();
+	~MD5Anim();
 
 	const std::string& getCommandLine() const
 	{
@@ -64,17 +77,39 @@ public:
 
 	std::size_t getNumFrames() const
 	{
-		return _frames.size();
+		return _numFrames;
 	}
 
-	const FrameKeys& getFrameKeys(std::size_t index) const
-	{
-		return _frames[index];
-	}
+	void getJointPoses(std::size_t time, Keys& poses) const;
 
-	void parseFromStream(std::istream& stream);
+	// Returns false if the stream couldn't be parsed
+	bool parseFromStream(std::istream& stream);
+
+	/**
+	 * Reads the animation from the given binary cache file, see writeCacheFile().
+	 * Takes ownership of the mapping if successful, returns false if the file
+	 * is not a valid cache file.
+	 */
+	bool loadFromCacheFile(GMappedFile* file);
+
+	// Writes the animation including the decompressed frames in binary form
+	void writeCacheFile(std::ostream& stream) const;
+
+	/**
+	 * Interpolates between the joint poses of two frames (see the frame table
+	 * layout above): the positions are blended linearly, the orientations are
+	 * slerped and normalised. Works on all joints at once, result is written
+	 * to <out> in the same layout.
+	 */
+	static void interpolateFrames(const float* first, const float* second, float fraction,
+								  std::size_t numJoints, float* out);
 
 private:
+	const float* getFrame(std::size_t index) const
+	{
+		return _frameTable + index * 7 * _joints.size();
+	}
+
 	void parseFromTokens(parser::DefTokeniser& tok);
 	void parseJointHierarchy(parser::DefTokeniser& tok);
 	void parseFrameBounds(parser::DefTokeniser& tok);
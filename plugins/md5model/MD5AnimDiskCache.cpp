@@ -0,0 +1,56 @@
+#include "MD5AnimDiskCache.h"
+
+#include <boost/bind.hpp>
+
+namespace md5
+{
+
+namespace
+{
+	const std::string CACHE_FOLDER = "animcache/";
+	const std::string CACHE_FILE_EXTENSION = ".danim";
+
+	// Animations are small compared to textures, 64 MB hold a few thousand
+	const std::size_t MAX_CACHE_SIZE = 64 << 20;
+}
+
+MD5AnimDiskCache::MD5AnimDiskCache() :
+	_cache(CACHE_FOLDER, CACHE_FILE_EXTENSION, MAX_CACHE_SIZE)
+{}
+
+std::string MD5AnimDiskCache::getKey(const std::string& contents)
+{
+	DiskCacheKey key;
+	key.add(contents.data(), contents.size());
+
+	return key.toString();
+}
+
+MD5AnimPtr MD5AnimDiskCache::load(const std::string& key)
+{
+	GMappedFile* file = _cache.open(key);
+
+	if (file == NULL)
+	{
+		return MD5AnimPtr();
+	}
+
+	MD5AnimPtr anim(new MD5Anim);
+
+	if (!anim->loadFromCacheFile(file))
+	{
+		g_mapped_file_unref(file);
+		_cache.remove(key);
+
+		return MD5AnimPtr();
+	}
+
+	return anim;
+}
+
+void MD5AnimDiskCache::store(const std::string& key, const MD5Anim& anim)
+{
+	_cache.store(key, boost::bind(&MD5Anim::writeCacheFile, &anim, _1));
+}
+
+} // namespace
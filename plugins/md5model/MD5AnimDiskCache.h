@@ -0,0 +1,34 @@
+#pragma once
+
+#include "MD5Anim.h"
+#include "DiskCache.h"
+
+#include <string>
+
+namespace md5
+{
+
+/**
+ * Persistent disk cache of parsed MD5 animations, located in the user's
+ * settings folder. The files hold the decompressed frame tables and are
+ * keyed by a hash of the .md5anim file contents, so changed files are
+ * picked up automatically. Cached animations are memory-mapped when loaded.
+ */
+class MD5AnimDiskCache
+{
+	DiskCache _cache;
+
+public:
+	MD5AnimDiskCache();
+
+	// Returns the cache key for the given .md5anim file contents
+	static std::string getKey(const std::string& contents);
+
+	// Returns the cached animation for the given key, or NULL if there is none
+	MD5AnimPtr load(const std::string& key);
+
+	// Writes the given animation to the cache
+	void store(const std::string& key, const MD5Anim& anim);
+};
+
+} // namespace
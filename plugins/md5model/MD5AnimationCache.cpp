@@ -5,6 +5,8 @@
 #include "archivelib.h"
 #include "parser/DefTokeniser.h"
 
+#include <sstream>
+
 namespace md5
 {
 
@@ -19,7 +21,7 @@ IMD5AnimPtr MD5AnimationCache::getAnim(const std::string& vfsPath)
 	}
 
 	// Not found, construct new animation with the given path
-	ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(vfsPath);
+	ArchiveFilePtr file = GlobalFileSystem().openFile(vfsPath);
 
 	if (file == NULL)
 	{
@@ -27,11 +29,38 @@ IMD5AnimPtr MD5AnimationCache::getAnim(const std::string& vfsPath)
 		return IMD5AnimPtr();
 	}
 
-	std::istream inputStream(&file->getInputStream());
-	
-	// Create the anim from scratch
-	MD5AnimPtr anim(new MD5Anim);
-	anim->parseFromStream(inputStream);
+	// The whole file is needed to calculate the disk cache key
+	std::string contents(file->size(), '\0');
+	std::size_t length = 0;
+
+	while (length < contents.size())
+	{
+		std::size_t bytesRead = file->getInputStream().read(
+			reinterpret_cast<InputStream::byte_type*>(&contents[length]), contents.size() - length);
+
+		if (bytesRead == 0) break;
+
+		length += bytesRead;
+	}
+
+	contents.resize(length);
+
+	// Try the disk cache first, it holds the decompressed frames
+	std::string key = MD5AnimDiskCache::getKey(contents);
+	MD5AnimPtr anim = _diskCache.load(key);
+
+	if (!anim)
+	{
+		// Create the anim from scratch
+		anim.reset(new MD5Anim);
+
+		std::istringstream inputStream(contents);
+
+		if (anim->parseFromStream(inputStream))
+		{
+			_diskCache.store(key, *anim);
+		}
+	}
 
 	// Store the anim in our cache
 	_animations.insert(AnimationMap::value_type(vfsPath, anim));
@@ -4,6 +4,7 @@
 #include <map>
 
 #include "MD5Anim.h"
+#include "MD5AnimDiskCache.h"
 
 namespace md5
 {
@@ -16,6 +17,8 @@ private:
 	typedef std::map<std::string, MD5AnimPtr> AnimationMap;
 	AnimationMap _animations;
 
+	MD5AnimDiskCache _diskCache;
+
 public:
 	// IAnimationCache implementation
 	IMD5AnimPtr getAnim(const std::string& vfsPath);
@@ -85,6 +85,15 @@ struct MD5Mesh
 	MD5Verts	vertices;
 	MD5Tris		triangles;
 	MD5Weights	weights;
+
+	// Simplified triangle index lists for rendering at a distance,
+	// generated from the default pose on first use, coarsest last
+	std::vector< std::vector<unsigned int> > lodIndices;
+	bool lodIndicesGenerated;
+
+	MD5Mesh() :
+		lodIndicesGenerated(false)
+	{}
 };
 typedef boost::shared_ptr<MD5Mesh> MD5MeshPtr;
 
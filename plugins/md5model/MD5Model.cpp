@@ -9,8 +9,20 @@
 #include "math/Ray.h"
 #include "MD5DataStructures.h"
 
+#include <algorithm>
+#include <boost/bind.hpp>
+
 namespace md5 {
 
+namespace
+{
+	// The number of vertices skinned by one job
+	const std::size_t SKINNING_RANGE_SIZE = 1024;
+
+	// Smaller models are skinned on the calling thread
+	const std::size_t MIN_PARALLEL_SKINNING_VERTICES = 4096;
+}
+
 MD5Model::MD5Model() :
 	_polyCount(0),
 	_vertexCount(0),
@@ -177,6 +189,14 @@ int MD5Model::getPolyCount() const
 	return static_cast<int>(_polyCount);
 }
 
+void MD5Model::generateLodLevels()
+{
+	for (SurfaceList::const_iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
+	{
+		i->surface->generateLodLevels();
+	}
+}
+
 void MD5Model::updateMaterialList()
 {
 	_surfaceNames.clear();
@@ -384,10 +404,79 @@ void MD5Model::updateAnim(std::size_t time)
 	// Update our joint hierarchy first
 	_skeleton.update(_anim, time);
 
+	// Split the surfaces into ranges of vertices which can be skinned in parallel
+	_skinningRanges.clear();
+
+	std::size_t numJoints = _skeleton.size();
+	std::size_t numVertices = 0;
+
 	for (SurfaceList::iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
 	{
-		i->surface->updateToSkeleton(_skeleton);
+		std::size_t surfaceVertices = i->surface->prepareSkinning();
+
+		numJoints = std::max(numJoints, i->surface->getNumSkinningJoints());
+		numVertices += surfaceVertices;
+
+		for (std::size_t first = 0; first < surfaceVertices; first += SKINNING_RANGE_SIZE)
+		{
+			SkinningRange range;
+
+			range.surface = i->surface.get();
+			range.first = first;
+			range.count = std::min(SKINNING_RANGE_SIZE, surfaceVertices - first);
+
+			_skinningRanges.push_back(range);
+		}
 	}
+
+	// Joints missing in the animation stay at the origin
+	_skinningJoints.resize(numJoints);
+
+	for (std::size_t i = 0; i < numJoints; ++i)
+	{
+		if (i < _skeleton.size())
+		{
+			const IMD5Anim::Key& key = _skeleton.getKey(i);
+			_skinningJoints[i].set(key.orientation, key.origin);
+		}
+		else
+		{
+			_skinningJoints[i].set(Quaternion::Identity(), Vector3(0, 0, 0));
+		}
+	}
+
+	if (numVertices >= MIN_PARALLEL_SKINNING_VERTICES)
+	{
+		WorkerPool& pool = getSkinningThreadPool();
+
+		pool.run(_skinningRanges.size(), boost::bind(&MD5Model::skinRange, this, _1));
+		pool.run(_surfaces.size(), boost::bind(&MD5Model::finishSurface, this, _1));
+	}
+	else
+	{
+		// Not worth waking up the worker threads
+		for (std::size_t i = 0; i < _skinningRanges.size(); ++i)
+		{
+			skinRange(i);
+		}
+
+		for (std::size_t i = 0; i < _surfaces.size(); ++i)
+		{
+			finishSurface(i);
+		}
+	}
+}
+
+void MD5Model::skinRange(std::size_t index)
+{
+	const SkinningRange& range = _skinningRanges[index];
+
+	range.surface->skinVertices(_skinningJoints, range.first, range.count);
+}
+
+void MD5Model::finishSurface(std::size_t index)
+{
+	_surfaces[index].surface->finishSkinning();
 }
 
 } // namespace
@@ -68,6 +68,18 @@ private:
 	// The current state of our animated skeleton
 	MD5Skeleton _skeleton;
 
+	// The joint matrices of the current pose, used to skin the surfaces
+	SkinningJoints _skinningJoints;
+
+	// A range of surface vertices, skinned by one job of the thread pool
+	struct SkinningRange
+	{
+		MD5Surface* surface;
+		std::size_t first;
+		std::size_t count;
+	};
+	std::vector<SkinningRange> _skinningRanges;
+
 	// The OpenGLRenderable visualising the MD5Skeleton
 	RenderableMD5Skeleton _renderableSkeleton;
 
@@ -131,6 +143,9 @@ public:
 	 */
 	virtual int getPolyCount() const;
 
+	// Generates the simplified levels of detail of all surfaces, if not done yet
+	void generateLodLevels();
+
 	/** Return a vector of strings listing the active materials used in this
 	 * model, after any skin remaps. The list is owned by the model instance.
 	 */
@@ -163,6 +178,10 @@ private:
 	void updateMaterialList();
 
 	void captureShaders();
+
+	// Thread pool jobs of updateAnim()
+	void skinRange(std::size_t index);
+	void finishSurface(std::size_t index);
 };
 typedef boost::shared_ptr<MD5Model> MD5ModelPtr;
 
@@ -21,6 +21,37 @@ namespace md5
 				path_is_absolute(name.c_str()) ? name : GlobalFileSystem().findFile(name)
 			);
 		}
+
+		// Parses the given file into a new model, throws parser::ParseException
+		MD5ModelPtr parseModel(ArchiveFile& file)
+		{
+			// Construct a new MD5Model container
+			MD5ModelPtr model(new MD5Model);
+
+			// Set the filename this model was loaded from
+			model->setFilename(os::getFilename(file.getName()));
+
+			// greebo: Get the Inputstream from the given file
+			BinaryToTextInputStream<InputStream> inputStream(file.getInputStream());
+
+			// Construct a Tokeniser object and start reading the file
+			std::istream is(&inputStream);
+			parser::BasicDefTokeniser<std::istream> tokeniser(is);
+
+			// Invoke the parser routine (might throw)
+			model->parseFromTokens(tokeniser);
+
+			return model;
+		}
+
+		// Parsing the MD5 mesh doesn't involve other modules, so the
+		// prepared model is the finished MD5Model
+		class PreparedMD5Model :
+			public model::PreparedModel
+		{
+		public:
+			MD5ModelPtr model;
+		};
 	} // namespace
 
 scene::INodePtr MD5ModelLoader::loadModel(const std::string& modelName)
@@ -63,25 +94,11 @@ model::IModelPtr MD5ModelLoader::loadModelFromPath(const std::string& name)
 
 	if (file != NULL)
 	{
-		// Construct a new MD5Model container
-		MD5ModelPtr model(new MD5Model);
-
-		// Store the VFS path in this model
-		model->setModelPath(name);
-		// Set the filename this model was loaded from
-		model->setFilename(os::getFilename(file->getName()));
+		MD5ModelPtr model;
 
-		// greebo: Get the Inputstream from the given file
-		BinaryToTextInputStream<InputStream> inputStream(file->getInputStream());
-
-		// Construct a Tokeniser object and start reading the file
 		try
 		{
-			std::istream is(&inputStream);
-			parser::BasicDefTokeniser<std::istream> tokeniser(is);
-
-			// Invoke the parser routine (might throw)
-			model->parseFromTokens(tokeniser);
+			model = parseModel(*file);
 		}
 		catch (parser::ParseException& e)
 		{
@@ -91,6 +108,9 @@ model::IModelPtr MD5ModelLoader::loadModelFromPath(const std::string& name)
 			return model::IModelPtr();
 		}
 
+		// Store the VFS path in this model
+		model->setModelPath(name);
+
 		// Load was successful, return the model
 		return model;
 	}
@@ -101,6 +121,40 @@ model::IModelPtr MD5ModelLoader::loadModelFromPath(const std::string& name)
 	}
 }
 
+model::PreparedModelPtr MD5ModelLoader::prepareModel(ArchiveFile& file)
+{
+	boost::shared_ptr<PreparedMD5Model> prepared(new PreparedMD5Model);
+
+	try
+	{
+		prepared->model = parseModel(file);
+	}
+	catch (parser::ParseException&)
+	{
+		// Don't report from the worker thread, the ModelCache
+		// retries on the main thread via loadModelFromPath()
+		return model::PreparedModelPtr();
+	}
+
+	return prepared;
+}
+
+model::IModelPtr MD5ModelLoader::createModel(const std::string& name, const model::PreparedModelPtr& prepared)
+{
+	boost::shared_ptr<PreparedMD5Model> md5Model =
+		boost::dynamic_pointer_cast<PreparedMD5Model>(prepared);
+
+	if (!md5Model)
+	{
+		return model::IModelPtr();
+	}
+
+	// Store the VFS path in this model
+	md5Model->model->setModelPath(name);
+
+	return md5Model->model;
+}
+
 // RegisterableModule implementation
 const std::string& MD5ModelLoader::getName() const
 {
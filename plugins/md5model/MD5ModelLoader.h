@@ -18,6 +18,8 @@ public:
 
 	// Documentation: See imodel.h
 	model::IModelPtr loadModelFromPath(const std::string& name);
+	model::PreparedModelPtr prepareModel(ArchiveFile& file);
+	model::IModelPtr createModel(const std::string& name, const model::PreparedModelPtr& prepared);
 
 	// RegisterableModule implementation
 	virtual const std::string& getName() const;
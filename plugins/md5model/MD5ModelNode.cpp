@@ -4,6 +4,8 @@
 #include "imodelcache.h"
 #include "ishaders.h"
 #include "iscenegraph.h"
+#include "render/MeshLod.h"
+#include "render/MeshSimplifier.h"
 #include <boost/bind.hpp>
 
 namespace md5 {
@@ -86,6 +88,11 @@ bool MD5ModelNode::intersectsLight(const RendererLight& light) const
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& MD5ModelNode::getLitObjectAABB() const
+{
+	return worldAABB();
+}
+
 void MD5ModelNode::insertLight(const RendererLight& light) {
 	const Matrix4& l2w = localToWorld();
 
@@ -135,6 +142,17 @@ void MD5ModelNode::render(RenderableCollector& collector, const VolumeTest& volu
 		return;
 	}
 
+	// Use the simplified surfaces if the model appears small in the camera view.
+	// The levels are simplified from the bind pose, an animated pose can move
+	// the vertices too far from it, so animated models are drawn at full detail.
+	std::size_t lodLevel = _model->getAnim() ? 0 : render::selectMeshLod(volume,
+		AABB::createFromOrientedAABBSafe(localAABB(), localToWorld), render::MAX_MESH_LOD_LEVELS);
+
+	if (lodLevel > 0)
+	{
+		_model->generateLodLevels();
+	}
+
 	SurfaceLightLists::const_iterator j = _surfaceLightLists.begin();
 
 	// greebo: Iterate over all MD5 surfaces and render them
@@ -150,7 +168,7 @@ void MD5ModelNode::render(RenderableCollector& collector, const VolumeTest& volu
 		if (surfaceShader->isVisible())
 		{
 			collector.setLights(*j);
-			i->surface->render(collector, localToWorld, i->shader, entity);
+			i->surface->render(collector, localToWorld, i->shader, entity, lodLevel);
 		}
 	}
 
@@ -0,0 +1,327 @@
+#include "MD5Skinning.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MD5_SKINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace md5
+{
+
+void SkinningJoint::set(const Quaternion& rotation, const Vector3& origin)
+{
+	// Same terms as Quaternion::transformPoint
+	double x = rotation.x();
+	double y = rotation.y();
+	double z = rotation.z();
+	double w = rotation.w();
+
+	double xx = x * x;
+	double yy = y * y;
+	double zz = z * z;
+	double ww = w * w;
+
+	double xy2 = x * y * 2;
+	double xz2 = x * z * 2;
+	double xw2 = x * w * 2;
+	double yz2 = y * z * 2;
+	double yw2 = y * w * 2;
+	double zw2 = z * w * 2;
+
+	float* c = columns;
+
+	c[0] = static_cast<float>(ww + xx - zz - yy);
+	c[1] = static_cast<float>(xy2 + zw2);
+	c[2] = static_cast<float>(xz2 - yw2);
+	c[3] = 0;
+
+	c[4] = static_cast<float>(xy2 - zw2);
+	c[5] = static_cast<float>(yy - zz + ww - xx);
+	c[6] = static_cast<float>(yz2 + xw2);
+	c[7] = 0;
+
+	c[8] = static_cast<float>(yw2 + xz2);
+	c[9] = static_cast<float>(yz2 - xw2);
+	c[10] = static_cast<float>(zz - yy - xx + ww);
+	c[11] = 0;
+
+	c[12] = static_cast<float>(origin.x());
+	c[13] = static_cast<float>(origin.y());
+	c[14] = static_cast<float>(origin.z());
+	c[15] = 0;
+}
+
+SkinningMesh::SkinningMesh(const MD5Mesh& mesh) :
+	numJoints(0)
+{
+	weightOffsets.reserve(mesh.vertices.size() + 1);
+	texcoords.reserve(mesh.vertices.size() * 2);
+
+	// Store the weights in vertex order, skipping invalid references
+	for (MD5Verts::const_iterator v = mesh.vertices.begin(); v != mesh.vertices.end(); ++v)
+	{
+		weightOffsets.push_back(static_cast<unsigned int>(weightJoints.size()));
+
+		texcoords.push_back(v->u);
+		texcoords.push_back(v->v);
+
+		for (std::size_t k = 0; k < v->weight_count; ++k)
+		{
+			std::size_t index = v->weight_index + k;
+
+			if (index >= mesh.weights.size()) break;
+
+			const MD5Weight& weight = mesh.weights[index];
+
+			weights.push_back(static_cast<float>(weight.v.x() * weight.t));
+			weights.push_back(static_cast<float>(weight.v.y() * weight.t));
+			weights.push_back(static_cast<float>(weight.v.z() * weight.t));
+			weights.push_back(weight.t);
+
+			weightJoints.push_back(static_cast<unsigned int>(weight.joint));
+
+			numJoints = std::max(numJoints, weight.joint + 1);
+		}
+	}
+
+	weightOffsets.push_back(static_cast<unsigned int>(weightJoints.size()));
+
+	std::size_t numVertices = mesh.vertices.size();
+
+	for (MD5Tris::const_iterator t = mesh.triangles.begin(); t != mesh.triangles.end(); ++t)
+	{
+		if (t->a >= numVertices || t->b >= numVertices || t->c >= numVertices) continue;
+
+		indices.push_back(static_cast<unsigned int>(t->a));
+		indices.push_back(static_cast<unsigned int>(t->b));
+		indices.push_back(static_cast<unsigned int>(t->c));
+
+		// Texture space differences of the two edges leaving vertex a
+		float ds1 = texcoords[t->b*2] - texcoords[t->a*2];
+		float dt1 = texcoords[t->b*2 + 1] - texcoords[t->a*2 + 1];
+		float ds2 = texcoords[t->c*2] - texcoords[t->a*2];
+		float dt2 = texcoords[t->c*2 + 1] - texcoords[t->a*2 + 1];
+
+		float det = ds1 * dt2 - dt1 * ds2;
+
+		// Degenerate texture mapping results in zero tangents,
+		// like in ArbitraryMeshTriangle_calcTangents
+		if (fabs(det) > 0.000001f)
+		{
+			tangentFactors.push_back(dt2 / det);
+			tangentFactors.push_back(-dt1 / det);
+			tangentFactors.push_back(-ds2 / det);
+			tangentFactors.push_back(ds1 / det);
+		}
+		else
+		{
+			tangentFactors.insert(tangentFactors.end(), 4, 0.0f);
+		}
+	}
+}
+
+void SkinningMesh::initialiseVertices(SkinnedVertices& vertices) const
+{
+	vertices.resize(getNumVertices());
+
+	if (vertices.empty()) return;
+
+	std::memset(&vertices[0], 0, vertices.size() * sizeof(SkinnedVertex));
+
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		vertices[i].texcoord[0] = texcoords[i*2];
+		vertices[i].texcoord[1] = texcoords[i*2 + 1];
+	}
+}
+
+namespace
+{
+
+void skinVerticesScalar(const SkinningMesh& mesh, const SkinningJoint* joints,
+						std::size_t first, std::size_t count, SkinnedVertex* out)
+{
+	const float* weights = mesh.weights.data();
+	const unsigned int* weightJoints = mesh.weightJoints.data();
+	const unsigned int* offsets = mesh.weightOffsets.data();
+
+	for (std::size_t v = first; v < first + count; ++v)
+	{
+		float sum[3] = { 0, 0, 0 };
+
+		for (unsigned int w = offsets[v]; w < offsets[v + 1]; ++w)
+		{
+			const float* m = joints[weightJoints[w]].columns;
+			const float* p = weights + w * 4;
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				sum[k] += (m[k] * p[0] + m[4 + k] * p[1]) + (m[8 + k] * p[2] + m[12 + k] * p[3]);
+			}
+		}
+
+		out[v].position[0] = sum[0];
+		out[v].position[1] = sum[1];
+		out[v].position[2] = sum[2];
+		out[v].position[3] = 0;
+	}
+}
+
+#if defined(MD5_SKINNING_SSE2)
+
+void skinVerticesSSE2(const SkinningMesh& mesh, const SkinningJoint* joints,
+					  std::size_t first, std::size_t count, SkinnedVertex* out)
+{
+	const float* weights = mesh.weights.data();
+	const unsigned int* weightJoints = mesh.weightJoints.data();
+	const unsigned int* offsets = mesh.weightOffsets.data();
+
+	for (std::size_t v = first; v < first + count; ++v)
+	{
+		__m128 sum = _mm_setzero_ps();
+
+		for (unsigned int w = offsets[v]; w < offsets[v + 1]; ++w)
+		{
+			const float* m = joints[weightJoints[w]].columns;
+			__m128 p = _mm_loadu_ps(weights + w * 4);
+
+			// One matrix column per component of the weighted position
+			__m128 a = _mm_mul_ps(_mm_loadu_ps(m), _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)));
+			__m128 b = _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+			__m128 c = _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+			__m128 d = _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+
+			sum = _mm_add_ps(sum, _mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)));
+		}
+
+		_mm_storeu_ps(out[v].position, sum);
+	}
+}
+
+#endif
+
+inline void addVector(float* target, const float* v)
+{
+	target[0] += v[0];
+	target[1] += v[1];
+	target[2] += v[2];
+}
+
+inline void normaliseVector(float* v)
+{
+	float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+	if (length > 0)
+	{
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+}
+
+const SkinningKernels _scalarKernels = { "Scalar", skinVerticesScalar };
+
+#if defined(MD5_SKINNING_SSE2)
+const SkinningKernels _sse2Kernels = { "SSE2", skinVerticesSSE2 };
+#endif
+
+} // namespace
+
+const SkinningKernels& getScalarSkinningKernels()
+{
+	return _scalarKernels;
+}
+
+const SkinningKernels* getSSE2SkinningKernels()
+{
+#if defined(MD5_SKINNING_SSE2)
+	return &_sse2Kernels;
+#else
+	return NULL;
+#endif
+}
+
+const SkinningKernels& getSkinningKernels()
+{
+	const SkinningKernels* sse2 = getSSE2SkinningKernels();
+
+	return sse2 != NULL ? *sse2 : getScalarSkinningKernels();
+}
+
+void calculateTangentFrames(const SkinningMesh& mesh, SkinnedVertex* vertices)
+{
+	std::size_t numVertices = mesh.getNumVertices();
+
+	for (std::size_t i = 0; i < numVertices; ++i)
+	{
+		SkinnedVertex& v = vertices[i];
+
+		std::memset(v.normal, 0, sizeof(v.normal));
+		std::memset(v.tangent, 0, sizeof(v.tangent));
+		std::memset(v.bitangent, 0, sizeof(v.bitangent));
+	}
+
+	const float* factors = mesh.tangentFactors.data();
+
+	for (std::size_t i = 0; i < mesh.indices.size(); i += 3, factors += 4)
+	{
+		SkinnedVertex& a = vertices[mesh.indices[i]];
+		SkinnedVertex& b = vertices[mesh.indices[i + 1]];
+		SkinnedVertex& c = vertices[mesh.indices[i + 2]];
+
+		float e1[3], e2[3];
+
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			e1[k] = b.position[k] - a.position[k];
+			e2[k] = c.position[k] - a.position[k];
+		}
+
+		// Area weighted normal, (c - a) x (b - a)
+		float normal[3] = {
+			e2[1] * e1[2] - e2[2] * e1[1],
+			e2[2] * e1[0] - e2[0] * e1[2],
+			e2[0] * e1[1] - e2[1] * e1[0]
+		};
+
+		float tangent[3], bitangent[3];
+
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			tangent[k] = factors[0] * e1[k] + factors[1] * e2[k];
+			bitangent[k] = factors[2] * e1[k] + factors[3] * e2[k];
+		}
+
+		addVector(a.normal, normal);
+		addVector(b.normal, normal);
+		addVector(c.normal, normal);
+
+		addVector(a.tangent, tangent);
+		addVector(b.tangent, tangent);
+		addVector(c.tangent, tangent);
+
+		addVector(a.bitangent, bitangent);
+		addVector(b.bitangent, bitangent);
+		addVector(c.bitangent, bitangent);
+	}
+
+	for (std::size_t i = 0; i < numVertices; ++i)
+	{
+		normaliseVector(vertices[i].normal);
+		normaliseVector(vertices[i].tangent);
+		normaliseVector(vertices[i].bitangent);
+	}
+}
+
+WorkerPool& getSkinningThreadPool()
+{
+	// Same number of threads as the decl loader uses
+	static WorkerPool _instance(4);
+	return _instance;
+}
+
+} // namespace
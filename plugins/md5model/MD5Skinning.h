@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "WorkerPool.h"
+#include "MD5DataStructures.h"
+
+namespace md5
+{
+
+/**
+ * A joint transform as 3x4 matrix, stored as four columns of four floats.
+ * The fourth component of each column is 0, which allows to process one
+ * column per SSE register.
+ */
+struct SkinningJoint
+{
+	float columns[16];
+
+	// Sets the matrix to the rotation followed by the translation
+	void set(const Quaternion& rotation, const Vector3& origin);
+};
+typedef std::vector<SkinningJoint> SkinningJoints;
+
+/**
+ * A skinned vertex as it is uploaded to the vertex buffer. The vectors
+ * are padded to four floats.
+ */
+struct SkinnedVertex
+{
+	float position[4];
+	float normal[4];
+	float tangent[4];
+	float bitangent[4];
+	float texcoord[4];
+};
+typedef std::vector<SkinnedVertex> SkinnedVertices;
+
+/**
+ * The data of an MD5 mesh prepared for skinning, it is built once and
+ * shared by all surfaces using the mesh.
+ */
+class SkinningMesh
+{
+public:
+	// Four floats per weight: the position relative to the joint
+	// multiplied with the weight factor, followed by the factor itself
+	std::vector<float> weights;
+
+	// The joint of each weight
+	std::vector<unsigned int> weightJoints;
+
+	// The first weight of each vertex, with an extra entry at the end
+	std::vector<unsigned int> weightOffsets;
+
+	// Three vertex indices per triangle
+	std::vector<unsigned int> indices;
+
+	// Four factors per triangle to calculate the tangent and bitangent
+	// from the triangle edges, they only depend on the texture coordinates
+	std::vector<float> tangentFactors;
+
+	// The texture coordinates of each vertex
+	std::vector<float> texcoords;
+
+	// The number of joints referenced by the weights
+	std::size_t numJoints;
+
+	SkinningMesh(const MD5Mesh& mesh);
+
+	std::size_t getNumVertices() const
+	{
+		return weightOffsets.size() - 1;
+	}
+
+	// Fills in the texture coordinates of the given vertices
+	void initialiseVertices(SkinnedVertices& vertices) const;
+};
+
+struct SkinningKernels
+{
+	// Name of the instruction set, for diagnostics
+	const char* name;
+
+	// Calculates the positions of the vertices [first, first + count)
+	void (*skinVertices)(const SkinningMesh& mesh, const SkinningJoint* joints,
+						 std::size_t first, std::size_t count, SkinnedVertex* out);
+};
+
+// Returns the fastest kernels supported by this build
+const SkinningKernels& getSkinningKernels();
+
+// The portable reference implementation
+const SkinningKernels& getScalarSkinningKernels();
+
+// Returns NULL if the build doesn't target SSE2
+const SkinningKernels* getSSE2SkinningKernels();
+
+/**
+ * Recalculates the normals, tangents and bitangents of the skinned
+ * vertices in one pass over the triangles.
+ */
+void calculateTangentFrames(const SkinningMesh& mesh, SkinnedVertex* vertices);
+
+// The worker pool shared by all models to skin their surfaces
+WorkerPool& getSkinningThreadPool();
+
+} // namespace
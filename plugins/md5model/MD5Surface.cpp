@@ -5,10 +5,19 @@
 #include "string/convert.h"
 #include "MD5Model.h"
 #include "math/Ray.h"
+#include "render/MeshSimplifier.h"
+
+#include <cstddef>
 
 namespace md5
 {
 
+namespace
+{
+	// Surfaces below this triangle count are rendered at full detail only
+	const std::size_t MIN_LOD_TRIANGLES = 200;
+}
+
 inline VertexPointer vertexpointer_arbitrarymeshvertex(const ArbitraryMeshVertex* array)
 {
   return VertexPointer(&array->vertex, sizeof(ArbitraryMeshVertex));
@@ -18,123 +27,160 @@ inline VertexPointer vertexpointer_arbitrarymeshvertex(const ArbitraryMeshVertex
 MD5Surface::MD5Surface() : 
 	_originalShaderName(""),
 	_mesh(new MD5Mesh),
-	_normalList(0),
-	_lightingList(0)
+	_vertexBuffer(0),
+	_indexBuffer(0),
+	_vertexBufferNeedsUpload(true),
+	_indexBufferNeedsUpload(true)
 {}
 
 MD5Surface::MD5Surface(const MD5Surface& other) :
 	_aabb_local(other._aabb_local),
 	_originalShaderName(other._originalShaderName),
 	_mesh(other._mesh),
-	_normalList(0),
-	_lightingList(0)
+	_skinningMesh(other._skinningMesh),
+	_vertexBuffer(0),
+	_indexBuffer(0),
+	_vertexBufferNeedsUpload(true),
+	_indexBufferNeedsUpload(true)
 {}
 
 // Destructor
 MD5Surface::~MD5Surface()
 {
-	// Release GL display lists
-	glDeleteLists(_normalList, 1);
-	glDeleteLists(_lightingList, 1);
+	// Release GL buffers
+	if (_vertexBuffer != 0)
+	{
+		glDeleteBuffersARB(1, &_vertexBuffer);
+		glDeleteBuffersARB(1, &_indexBuffer);
+	}
+}
+
+// Back-end render
+void MD5Surface::render(const RenderInfo& info) const
+{
+	renderLevel(info, 0);
 }
 
-// Update geometry
-void MD5Surface::updateGeometry()
+void MD5Surface::renderLevel(const RenderInfo& info, std::size_t level) const
 {
-	_aabb_local = AABB();
+	if (_indices.empty() || _skinnedVertices.empty()) return;
 
-	for (Vertices::const_iterator i = _vertices.begin(); i != _vertices.end(); ++i)
-	{
-		_aabb_local.includePoint(i->vertex);
-	}
+	const IndexBuffer& indices = level == 0 ? _indices : _mesh->lodIndices[level - 1];
 
-	for (Indices::iterator i = _indices.begin();
-		 i != _indices.end();
-		 i += 3)
+	// Offsets into the vertex buffer, or client-side arrays without buffer support
+	const char* vertexBase = NULL;
+	const RenderIndex* indexBase = NULL;
+
+	if (GLEW_ARB_vertex_buffer_object)
 	{
-		ArbitraryMeshVertex& a = _vertices[*(i + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(i + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(i + 2)];
+		bindBuffers();
 
-		ArbitraryMeshTriangle_sumTangents(a, b, c);
-	}
+		// The levels are stored one after the other
+		std::size_t offset = level == 0 ? 0 : _indices.size();
+
+		for (std::size_t i = 1; i < level; ++i)
+		{
+			offset += _mesh->lodIndices[i - 1].size();
+		}
 
-	for (Vertices::iterator i = _vertices.begin();
-		 i != _vertices.end();
-		 ++i)
+		indexBase += offset;
+	}
+	else
 	{
-		i->tangent.normalise();
-		i->bitangent.normalise();
+		vertexBase = reinterpret_cast<const char*>(_skinnedVertices.data());
+		indexBase = indices.data();
 	}
 
-	// Build the display lists
-	createDisplayLists();
-}
+	GLsizei stride = sizeof(SkinnedVertex);
 
-// Back-end render
-void MD5Surface::render(const RenderInfo& info) const
-{
 	if (info.checkFlag(RENDER_BUMP))
-    {
-		glCallList(_lightingList);
+	{
+		glVertexAttribPointerARB(ATTR_TEXCOORD, 2, GL_FLOAT, 0, stride, vertexBase + offsetof(SkinnedVertex, texcoord));
+		glVertexAttribPointerARB(ATTR_TANGENT, 3, GL_FLOAT, 0, stride, vertexBase + offsetof(SkinnedVertex, tangent));
+		glVertexAttribPointerARB(ATTR_BITANGENT, 3, GL_FLOAT, 0, stride, vertexBase + offsetof(SkinnedVertex, bitangent));
+		glVertexAttribPointerARB(ATTR_NORMAL, 3, GL_FLOAT, 0, stride, vertexBase + offsetof(SkinnedVertex, normal));
 	}
 	else
-    {
-		glCallList(_normalList);
+	{
+		glNormalPointer(GL_FLOAT, stride, vertexBase + offsetof(SkinnedVertex, normal));
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, stride, vertexBase + offsetof(SkinnedVertex, texcoord));
+	}
+
+	// No colour changing
+	glDisableClientState(GL_COLOR_ARRAY);
+	if (info.checkFlag(RENDER_VERTEX_COLOUR))
+	{
+		glColor3f(1, 1, 1);
+	}
+
+	glVertexPointer(3, GL_FLOAT, stride, vertexBase + offsetof(SkinnedVertex, position));
+
+	glDrawElements(GL_TRIANGLES, GLsizei(indices.size()), RenderIndexTypeID, indexBase);
+
+	if (GLEW_ARB_vertex_buffer_object)
+	{
+		glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+		glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
 	}
 }
 
-// Construct the display lists
-void MD5Surface::createDisplayLists()
+void MD5Surface::bindBuffers() const
 {
-	// Create the list for lighting mode
-	_lightingList = glGenLists(1);
-	assert(_lightingList != 0);
-	glNewList(_lightingList, GL_COMPILE);
+	if (_vertexBuffer == 0)
+	{
+		glGenBuffersARB(1, &_vertexBuffer);
+		glGenBuffersARB(1, &_indexBuffer);
+	}
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, _indexBuffer);
+
+	if (_indexBufferNeedsUpload)
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit the vertex attributes and coordinate
-		if (GLEW_ARB_vertex_program) {
-			// Submit the vertex attributes and coordinate
-			glVertexAttrib2dvARB(ATTR_TEXCOORD, v.texcoord);
-			glVertexAttrib3dvARB(ATTR_TANGENT, v.tangent);
-			glVertexAttrib3dvARB(ATTR_BITANGENT, v.bitangent);
-			glVertexAttrib3dvARB(ATTR_NORMAL, v.normal);
+		const std::vector<IndexBuffer>& lodIndices = _mesh->lodIndices;
+
+		std::size_t numIndices = _indices.size();
+
+		for (std::size_t i = 0; i < lodIndices.size(); ++i)
+		{
+			numIndices += lodIndices[i].size();
 		}
-		glVertex3dv(v.vertex);
-	}
-	glEnd();
 
-	glEndList();
+		glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(RenderIndex) * numIndices,
+			NULL, GL_STATIC_DRAW_ARB);
 
-	// Generate the list for flat-shaded (unlit) mode
-	_normalList = glGenLists(1);
-	assert(_normalList != 0);
-	glNewList(_normalList, GL_COMPILE);
+		// The full indices first, followed by the simplified levels
+		std::size_t offset = 0;
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
-	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
+		glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0,
+			sizeof(RenderIndex) * _indices.size(), _indices.data());
+
+		offset += _indices.size();
+
+		for (std::size_t i = 0; i < lodIndices.size(); ++i)
+		{
+			glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(RenderIndex) * offset,
+				sizeof(RenderIndex) * lodIndices[i].size(), lodIndices[i].data());
+
+			offset += lodIndices[i].size();
+		}
 
-		// Submit attributes
-		glNormal3dv(v.normal);
-		glTexCoord2dv(v.texcoord);
-		glVertex3dv(v.vertex);
+		_indexBufferNeedsUpload = false;
 	}
-	glEnd();
 
-	glEndList();
+	glBindBufferARB(GL_ARRAY_BUFFER_ARB, _vertexBuffer);
+
+	if (_vertexBufferNeedsUpload)
+	{
+		std::size_t size = sizeof(SkinnedVertex) * _skinnedVertices.size();
+
+		// Orphan the previous contents first, the driver doesn't need to
+		// wait for draw calls still using them
+		glBufferDataARB(GL_ARRAY_BUFFER_ARB, size, NULL, GL_DYNAMIC_DRAW_ARB);
+		glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, 0, size, _skinnedVertices.data());
+
+		_vertexBufferNeedsUpload = false;
+	}
 }
 
 // Selection test
@@ -207,12 +253,60 @@ const AABB& MD5Surface::localAABB() const {
 }
 
 void MD5Surface::render(RenderableCollector& collector, const Matrix4& localToWorld, 
-						const ShaderPtr& shader, const IRenderEntity& entity) const
+						const ShaderPtr& shader, const IRenderEntity& entity,
+						std::size_t lodLevel) const
 {
 	assert(shader); // shader must be captured at this point
 
 	collector.SetState(shader, RenderableCollector::eFullMaterials);
-	collector.addRenderable(*this, localToWorld, entity);
+
+	if (lodLevel == 0 || _lodLevels.empty())
+	{
+		collector.addRenderable(*this, localToWorld, entity);
+	}
+	else
+	{
+		std::size_t index = std::min(lodLevel, _lodLevels.size()) - 1;
+
+		collector.addRenderable(*_lodLevels[index], localToWorld, entity);
+	}
+}
+
+void MD5Surface::generateLodLevels()
+{
+	if (!_mesh->lodIndicesGenerated)
+	{
+		_mesh->lodIndicesGenerated = true;
+
+		std::vector<Vector3> positions(_vertices.size());
+
+		for (std::size_t i = 0; i < positions.size(); ++i)
+		{
+			positions[i] = _vertices[i].vertex;
+		}
+
+		render::MeshSimplifier::generateLevels(positions,
+			_indices.empty() ? NULL : _indices.data(), _indices.size(),
+			MIN_LOD_TRIANGLES, _mesh->lodIndices);
+	}
+
+	if (_lodLevels.size() != _mesh->lodIndices.size())
+	{
+		createLodLevels();
+	}
+}
+
+void MD5Surface::createLodLevels()
+{
+	_lodLevels.clear();
+
+	for (std::size_t i = 0; i < _mesh->lodIndices.size(); ++i)
+	{
+		_lodLevels.push_back(LodLevelPtr(new LodLevel(*this, i + 1)));
+	}
+
+	// The level indices follow the full indices in the index buffer
+	_indexBufferNeedsUpload = true;
 }
 
 int MD5Surface::getNumVertices() const
@@ -251,70 +345,36 @@ const std::string& MD5Surface::getDefaultMaterial() const
 
 void MD5Surface::updateToDefaultPose(const MD5Joints& joints)
 {
-	if (_vertices.size() != _mesh->vertices.size())
-	{
-		_vertices.resize(_mesh->vertices.size());
-	}
+	SkinningJoints skinningJoints(joints.size());
 
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
+	for (std::size_t i = 0; i < joints.size(); ++i)
 	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
-
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
-		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const MD5Joint& joint = joints[weight.joint];
-
-			Vector3 rotatedPoint = joint.rotation.transformPoint(weight.v);
-			skinned += (rotatedPoint + joint.position) * weight.t;
-		}
-
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
+		skinningJoints[i].set(joints[i].rotation, joints[i].position);
 	}
 
-	// Ensure the index array is ok
-	if (_indices.empty())
-	{
-		buildIndexArray();
-	}
+	updateToPose(skinningJoints);
+}
+
+void MD5Surface::updateToPose(const SkinningJoints& joints)
+{
+	std::size_t numVertices = prepareSkinning();
 
-	buildVertexNormals();
+	skinVertices(joints, 0, numVertices);
 
-	updateGeometry();
+	finishSkinning();
 }
 
-void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
+std::size_t MD5Surface::prepareSkinning()
 {
-	// Ensure we have all vertices allocated
-	if (_vertices.size() != _mesh->vertices.size())
+	if (!_skinningMesh)
 	{
-		_vertices.resize(_mesh->vertices.size());
+		_skinningMesh.reset(new SkinningMesh(*_mesh));
 	}
 
-	// Deform vertices to fit the skeleton
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
+	if (_skinnedVertices.size() != _skinningMesh->getNumVertices())
 	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
-
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
-		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const IMD5Anim::Key& key = skeleton.getKey(weight.joint);
-			//const Joint& joint = skeleton.getJoint(weight.joint);
-
-			Vector3 rotatedPoint = key.orientation.transformPoint(weight.v);
-			skinned += (rotatedPoint + key.origin) * weight.t;
-		}
-
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
+		_skinningMesh->initialiseVertices(_skinnedVertices);
+		_vertices.resize(_skinnedVertices.size());
 	}
 
 	// Ensure the index array is ok
@@ -323,36 +383,52 @@ void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
 		buildIndexArray();
 	}
 
-	buildVertexNormals();
+	return _skinnedVertices.size();
+}
 
-	updateGeometry();
+std::size_t MD5Surface::getNumSkinningJoints() const
+{
+	return _skinningMesh ? _skinningMesh->numJoints : 0;
 }
 
-void MD5Surface::buildVertexNormals()
+void MD5Surface::skinVertices(const SkinningJoints& joints, std::size_t first, std::size_t count)
 {
-	for (Indices::iterator j = _indices.begin(); j != _indices.end(); j += 3)
-	{
-		ArbitraryMeshVertex& a = _vertices[*(j + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(j + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(j + 2)];
+	assert(_skinningMesh && joints.size() >= _skinningMesh->numJoints);
+	assert(first + count <= _skinnedVertices.size());
 
-		Vector3 weightedNormal((c.vertex - a.vertex).crossProduct(b.vertex - a.vertex));
+	if (count == 0) return;
 
-		a.normal += weightedNormal;
-		b.normal += weightedNormal;
-		c.normal += weightedNormal;
-	}
+	getSkinningKernels().skinVertices(*_skinningMesh, joints.data(), first, count, _skinnedVertices.data());
+}
 
-	// Normalise all normal vectors
-	for (Vertices::iterator j = _vertices.begin(); j != _vertices.end(); ++j)
+void MD5Surface::finishSkinning()
+{
+	calculateTangentFrames(*_skinningMesh, _skinnedVertices.data());
+
+	_aabb_local = AABB();
+
+	// Keep the vertices used for selection and the IModelSurface interface in sync
+	for (std::size_t i = 0; i < _skinnedVertices.size(); ++i)
 	{
-		j->normal = Normal3f(j->normal.getNormalised());
+		const SkinnedVertex& skinned = _skinnedVertices[i];
+		ArbitraryMeshVertex& v = _vertices[i];
+
+		v.vertex = Vertex3f(skinned.position[0], skinned.position[1], skinned.position[2]);
+		v.normal = Normal3f(skinned.normal[0], skinned.normal[1], skinned.normal[2]);
+		v.tangent = Normal3f(skinned.tangent[0], skinned.tangent[1], skinned.tangent[2]);
+		v.bitangent = Normal3f(skinned.bitangent[0], skinned.bitangent[1], skinned.bitangent[2]);
+		v.texcoord = TexCoord2f(skinned.texcoord[0], skinned.texcoord[1]);
+
+		_aabb_local.includePoint(v.vertex);
 	}
+
+	_vertexBufferNeedsUpload = true;
 }
 
 void MD5Surface::buildIndexArray()
 {
 	_indices.clear();
+	_indexBufferNeedsUpload = true;
 
 	// Build the indices based on the triangle information
 	for (MD5Tris::const_iterator j = _mesh->triangles.begin(); j != _mesh->triangles.end(); ++j)
@@ -363,6 +439,8 @@ void MD5Surface::buildIndexArray()
 		_indices.push_back(static_cast<RenderIndex>(tri.b));
 		_indices.push_back(static_cast<RenderIndex>(tri.c));
 	}
+
+	createLodLevels();
 }
 
 void MD5Surface::parseFromTokens(parser::DefTokeniser& tok)
@@ -10,6 +10,7 @@
 #include "imodelsurface.h"
 
 #include "MD5DataStructures.h"
+#include "MD5Skinning.h"
 #include "parser/DefTokeniser.h"
 
 class Ray;
@@ -17,8 +18,6 @@ class Ray;
 namespace md5
 {
 
-class MD5Skeleton;
-
 class MD5Surface :
 	public model::IModelSurface,
 	public OpenGLRenderable
@@ -37,21 +36,57 @@ private:
 	// Several MD5Surfaces can share the same mesh
 	MD5MeshPtr _mesh;
 
+	// The mesh prepared for skinning, shared like the mesh definition
+	boost::shared_ptr<SkinningMesh> _skinningMesh;
+
+	// The skinned vertices as uploaded to the vertex buffer
+	SkinnedVertices _skinnedVertices;
+
 	// Our render data
 	Vertices _vertices;
 	Indices _indices;
 
-	// The GL display lists for this surface's geometry
-	GLuint _normalList;
-	GLuint _lightingList;
+	// The GL buffers for this surface's geometry, created on first render.
+	// The vertex buffer is re-filled after each pose update.
+	mutable GLuint _vertexBuffer;
+	mutable GLuint _indexBuffer;
+	mutable bool _vertexBufferNeedsUpload;
+	mutable bool _indexBufferNeedsUpload;
+
+	// A simplified level of detail, drawn from the same vertex buffer with
+	// the level's indices, which follow the full indices in the index buffer
+	class LodLevel :
+		public OpenGLRenderable
+	{
+		const MD5Surface& _surface;
+		std::size_t _level;
+
+	public:
+		LodLevel(const MD5Surface& surface, std::size_t level) :
+			_surface(surface),
+			_level(level)
+		{}
+
+		void render(const RenderInfo& info) const
+		{
+			_surface.renderLevel(info, _level);
+		}
+	};
+	typedef boost::shared_ptr<LodLevel> LodLevelPtr;
+
+	// The renderables of the simplified levels stored in the mesh
+	std::vector<LodLevelPtr> _lodLevels;
 
 private:
 
-	// Create the display lists
-	void createDisplayLists();
+	// Binds the GL buffers, uploading the data changed since the last render
+	void bindBuffers() const;
 
-	// Re-calculate the normal vectors
-	void buildVertexNormals();
+	// Draws the given level of detail, 0 is the full mesh
+	void renderLevel(const RenderInfo& info, std::size_t level) const;
+
+	// Creates the renderables for the levels stored in the mesh
+	void createLodLevels();
 
 public:
 
@@ -73,17 +108,29 @@ public:
 	// Set/get the shader name
 	void setDefaultMaterial(const std::string& name);
 	
-	/**
-	 * Calculate the AABB and build the display lists for rendering.
-	 */
-	void updateGeometry();
-
 	// Updates the mesh to the pose defined in the .md5mesh file - usually a T-Pose
 	// It needs the joints defined in that file as reference
 	void updateToDefaultPose(const MD5Joints& joints);
 
-	// Updates this mesh to the state of the given skeleton
-	void updateToSkeleton(const MD5Skeleton& skeleton);
+	// Updates this mesh to the pose defined by the given joint matrices
+	void updateToPose(const SkinningJoints& joints);
+
+	// The pose update is split into steps to distribute it across threads:
+	// prepareSkinning() is called first on the main thread, then the vertices
+	// are skinned in ranges (on any thread) and finishSkinning() recalculates
+	// the normals, tangents and bounds once all ranges are done.
+
+	// Prepares the skinning data, returns the number of skinned vertices
+	std::size_t prepareSkinning();
+
+	// The number of joint matrices required by the mesh weights
+	std::size_t getNumSkinningJoints() const;
+
+	// Calculates the positions of the vertices [first, first + count)
+	void skinVertices(const SkinningJoints& joints, std::size_t first, std::size_t count);
+
+	// Recalculates the tangent frames and bounds of the skinned vertices
+	void finishSkinning();
 
 	// Applies the given Skin to this surface.
 	void applySkin(const ModelSkin& skin);
@@ -93,8 +140,17 @@ public:
 
 	const AABB& localAABB() const;
 
+	// Submits the surface in the given level of detail, 0 is full detail.
+	// Levels beyond the ones available submit the coarsest one.
 	void render(RenderableCollector& collector, const Matrix4& localToWorld, 
-				const ShaderPtr& shader, const IRenderEntity& entity) const;
+				const ShaderPtr& shader, const IRenderEntity& entity,
+				std::size_t lodLevel = 0) const;
+
+	// Generates the simplified levels from the current pose, unless another copy
+	// of this surface did already, the levels are stored in the shared mesh
+	// definition. Called before the surface is drawn simplified for the first
+	// time, which only happens while the model shows its bind pose.
+	void generateLodLevels();
 
 	// Test for selection
 	void testSelect(Selector& selector,
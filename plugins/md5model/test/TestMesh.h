@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../MD5Skinning.h"
+
+#include <cstdlib>
+#include <cmath>
+
+namespace md5
+{
+
+namespace test
+{
+    inline double randomValue(double min, double max)
+    {
+        return min + (max - min) * std::rand() / RAND_MAX;
+    }
+
+    /**
+     * Creates a grid shaped mesh with random weights, each vertex is attached
+     * to one to four of the given number of joints.
+     */
+    inline MD5Mesh createMesh(std::size_t width, std::size_t height, std::size_t numJoints)
+    {
+        MD5Mesh mesh;
+
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                MD5Vert vert;
+
+                vert.index = mesh.vertices.size();
+                vert.u = static_cast<float>(x) / width;
+                vert.v = static_cast<float>(y) / height;
+                vert.weight_index = mesh.weights.size();
+                vert.weight_count = 1 + std::rand() % 4;
+
+                float total = 0;
+
+                for (std::size_t k = 0; k < vert.weight_count; ++k)
+                {
+                    MD5Weight weight;
+
+                    weight.index = mesh.weights.size();
+                    weight.joint = std::rand() % numJoints;
+                    weight.t = static_cast<float>(randomValue(0.1, 1));
+                    weight.v = Vector3(randomValue(-20, 20), randomValue(-20, 20), randomValue(-20, 20));
+
+                    total += weight.t;
+                    mesh.weights.push_back(weight);
+                }
+
+                for (std::size_t k = 0; k < vert.weight_count; ++k)
+                {
+                    mesh.weights[vert.weight_index + k].t /= total;
+                }
+
+                mesh.vertices.push_back(vert);
+            }
+        }
+
+        for (std::size_t y = 0; y + 1 < height; ++y)
+        {
+            for (std::size_t x = 0; x + 1 < width; ++x)
+            {
+                std::size_t corner = y * width + x;
+
+                MD5Tri first = { mesh.triangles.size(), corner, corner + width, corner + 1 };
+                mesh.triangles.push_back(first);
+
+                MD5Tri second = { mesh.triangles.size(), corner + 1, corner + width, corner + width + 1 };
+                mesh.triangles.push_back(second);
+            }
+        }
+
+        return mesh;
+    }
+
+    // Random joint rotations and positions
+    inline MD5Joints createJoints(std::size_t numJoints)
+    {
+        MD5Joints joints(numJoints);
+
+        for (std::size_t i = 0; i < numJoints; ++i)
+        {
+            Vector3 axis(randomValue(-1, 1), randomValue(-1, 1), randomValue(-1, 1));
+            double angle = randomValue(0, 3);
+
+            joints[i].parent = -1;
+            joints[i].rotation = Quaternion(axis.getNormalised() * sin(angle / 2), cos(angle / 2));
+            joints[i].position = Vector3(randomValue(-100, 100), randomValue(-100, 100), randomValue(-100, 100));
+        }
+
+        return joints;
+    }
+
+    inline SkinningJoints createSkinningJoints(const MD5Joints& joints)
+    {
+        SkinningJoints skinningJoints(joints.size());
+
+        for (std::size_t i = 0; i < joints.size(); ++i)
+        {
+            skinningJoints[i].set(joints[i].rotation, joints[i].position);
+        }
+
+        return skinningJoints;
+    }
+}
+
+}
@@ -0,0 +1,367 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE md5AnimTest
+#include <boost/test/unit_test.hpp>
+
+#include "MD5Anim.h"
+
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace md5;
+
+namespace
+{
+    const char* const CACHE_FILE = "md5AnimTest.cache";
+
+    // Three joints, one animating its position and orientation, one only its orientation
+    const char* const ANIM_SOURCE =
+        "MD5Version 10\n"
+        "commandline \"-rotate 90\"\n"
+        "numFrames 4\n"
+        "numJoints 3\n"
+        "frameRate 24\n"
+        "numAnimatedComponents 9\n"
+        "hierarchy {\n"
+        "  \"origin\" -1 0 0\n"
+        "  \"Hips\" 0 63 0\n"
+        "  \"Spine\" 1 56 6\n"
+        "}\n"
+        "bounds {\n"
+        "  ( -10 -10 0 ) ( 10 10 60 )\n"
+        "  ( -11 -10 0 ) ( 10 11 60 )\n"
+        "  ( -12 -10 0 ) ( 10 12 61 )\n"
+        "  ( -13 -10 0 ) ( 10 13 62 )\n"
+        "}\n"
+        "baseframe {\n"
+        "  ( 0 0 0 ) ( 0 0 0 )\n"
+        "  ( 0 0 40 ) ( 0.1 0 0 )\n"
+        "  ( 0 0 10 ) ( 0 0.2 0 )\n"
+        "}\n"
+        "frame 0 { 0 0 40 0.1 0 0 0 0.2 0 }\n"
+        "frame 1 { 1 0 41 0.2 0.1 0 0.1 0.3 0 }\n"
+        "frame 2 { 2 1 42 -0.3 0.1 0.2 0.2 0.1 -0.5 }\n"
+        "frame 3 { 3 1 40 -0.5 0.4 0.3 -0.6 0.2 -0.5 }\n";
+
+    // Offsets into the cache file, see CacheFileHeader and CacheFileJoint in MD5Anim.cpp
+    const std::size_t HEADER_SIZE = 32;
+    const std::size_t JOINT_RECORD_SIZE = 20;
+
+    MD5AnimPtr parseAnim()
+    {
+        std::istringstream stream(ANIM_SOURCE);
+
+        MD5AnimPtr anim(new MD5Anim);
+        BOOST_REQUIRE(anim->parseFromStream(stream));
+
+        return anim;
+    }
+
+    std::string getCacheData(const MD5Anim& anim)
+    {
+        std::ostringstream stream;
+        anim.writeCacheFile(stream);
+
+        return stream.str();
+    }
+
+    // Writes the given data to the cache file and loads it from there,
+    // returns an empty pointer if the anim refused the file
+    MD5AnimPtr loadCacheData(const std::string& data)
+    {
+        {
+            std::ofstream file(CACHE_FILE, std::ios::binary);
+            file.write(data.data(), data.size());
+        }
+
+        GMappedFile* mapped = g_mapped_file_new(CACHE_FILE, FALSE, NULL);
+        BOOST_REQUIRE(mapped != NULL);
+
+        MD5AnimPtr anim(new MD5Anim);
+
+        if (!anim->loadFromCacheFile(mapped))
+        {
+            g_mapped_file_unref(mapped);
+            anim.reset();
+        }
+
+        std::remove(CACHE_FILE);
+
+        return anim;
+    }
+
+    void setUInt32(std::string& data, std::size_t offset, guint32 value)
+    {
+        std::memcpy(&data[offset], &value, sizeof(value));
+    }
+
+    // This is the slerp the MD5Skeleton used before MD5Anim::interpolateFrames()
+    Quaternion slerp(const Quaternion& qa, const Quaternion& qb, float fraction)
+    {
+        Quaternion qm;
+
+        float cosHalfTheta = qa.w() * qb.w() + qa.x() * qb.x() + qa.y() * qb.y() + qa.z() * qb.z();
+
+        if (std::fabs(cosHalfTheta) > 1.0f)
+        {
+            return qb;
+        }
+
+        Quaternion temp;
+
+        if (cosHalfTheta < 0.0f)
+        {
+            temp = qb*(-1);
+            cosHalfTheta = -cosHalfTheta;
+        }
+        else
+        {
+            temp = qb;
+        }
+
+        float halfTheta = acos(cosHalfTheta);
+        float sinHalfTheta = sqrt(1.0f - cosHalfTheta*cosHalfTheta);
+
+        if (std::fabs(sinHalfTheta) < 0.006f)
+        {
+            qm.w() = (qa.w() * (1-fraction) + temp.w() * fraction);
+            qm.x() = (qa.x() * (1-fraction) + temp.x() * fraction);
+            qm.y() = (qa.y() * (1-fraction) + temp.y() * fraction);
+            qm.z() = (qa.z() * (1-fraction) + temp.z() * fraction);
+            return qm;
+        }
+
+        float ratioA = sin((1 - fraction) * halfTheta) / sinHalfTheta;
+        float ratioB = sin(fraction * halfTheta) / sinHalfTheta;
+
+        qm.w() = (qa.w() * ratioA + temp.w() * ratioB);
+        qm.x() = (qa.x() * ratioA + temp.x() * ratioB);
+        qm.y() = (qa.y() * ratioA + temp.y() * ratioB);
+        qm.z() = (qa.z() * ratioA + temp.z() * ratioB);
+
+        return qm;
+    }
+
+    Quaternion randomQuaternion()
+    {
+        Quaternion q(std::rand() % 2001 - 1000, std::rand() % 2001 - 1000,
+                     std::rand() % 2001 - 1000, std::rand() % 2001 - 1000);
+
+        return q.getNormalised();
+    }
+
+    float randomFloat()
+    {
+        return static_cast<float>(std::rand() % 2001 - 1000) / 10;
+    }
+}
+
+// The cached animation has the same joints and poses as the parsed one
+BOOST_AUTO_TEST_CASE(cacheRoundTrip)
+{
+    MD5AnimPtr parsed = parseAnim();
+    MD5AnimPtr cached = loadCacheData(getCacheData(*parsed));
+
+    BOOST_REQUIRE(cached);
+
+    BOOST_CHECK_EQUAL(cached->getCommandLine(), parsed->getCommandLine());
+    BOOST_CHECK_EQUAL(cached->getFrameRate(), parsed->getFrameRate());
+    BOOST_REQUIRE_EQUAL(cached->getNumFrames(), parsed->getNumFrames());
+    BOOST_REQUIRE_EQUAL(cached->getNumJoints(), parsed->getNumJoints());
+
+    for (std::size_t i = 0; i < parsed->getNumJoints(); ++i)
+    {
+        const Joint& expected = parsed->getJoint(i);
+        const Joint& joint = cached->getJoint(i);
+
+        BOOST_CHECK_EQUAL(joint.id, expected.id);
+        BOOST_CHECK_EQUAL(joint.name, expected.name);
+        BOOST_CHECK_EQUAL(joint.parentId, expected.parentId);
+        BOOST_CHECK_EQUAL(joint.animComponents, expected.animComponents);
+        BOOST_CHECK_EQUAL(joint.firstKey, expected.firstKey);
+        BOOST_CHECK(joint.children == expected.children);
+
+        BOOST_CHECK(cached->getBaseFrameKey(i).origin == parsed->getBaseFrameKey(i).origin);
+        BOOST_CHECK(cached->getBaseFrameKey(i).orientation == parsed->getBaseFrameKey(i).orientation);
+    }
+
+    // Sample the frames and the blends in between
+    for (std::size_t time = 0; time < 250; time += 7)
+    {
+        IMD5Anim::Keys expected;
+        IMD5Anim::Keys poses;
+
+        parsed->getJointPoses(time, expected);
+        cached->getJointPoses(time, poses);
+
+        BOOST_REQUIRE_EQUAL(poses.size(), expected.size());
+
+        for (std::size_t i = 0; i < poses.size(); ++i)
+        {
+            BOOST_CHECK(poses[i].origin == expected[i].origin);
+            BOOST_CHECK(poses[i].orientation == expected[i].orientation);
+        }
+    }
+
+    // Writing the cached animation gives the same file again
+    BOOST_CHECK(getCacheData(*cached) == getCacheData(*parsed));
+}
+
+// Files cut off anywhere are rejected
+BOOST_AUTO_TEST_CASE(truncatedCacheFiles)
+{
+    std::string data = getCacheData(*parseAnim());
+
+    std::size_t lengths[] = {
+        0, 4, HEADER_SIZE - 1, HEADER_SIZE, HEADER_SIZE + JOINT_RECORD_SIZE, data.size() / 2, data.size() - 1
+    };
+
+    for (std::size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        BOOST_CHECK_MESSAGE(!loadCacheData(data.substr(0, lengths[i])), "length " << lengths[i]);
+    }
+
+    // Trailing data doesn't belong to a cache file either
+    BOOST_CHECK(!loadCacheData(data + std::string(4, '\0')));
+}
+
+// Files with inconsistent headers or joints are rejected
+BOOST_AUTO_TEST_CASE(corruptCacheFiles)
+{
+    const std::string data = getCacheData(*parseAnim());
+
+    BOOST_REQUIRE(loadCacheData(data));
+
+    std::string corrupt = data;
+    corrupt[0] = 'X';
+    BOOST_CHECK(!loadCacheData(corrupt)); // magic
+
+    corrupt = data;
+    setUInt32(corrupt, 4, 0xffff);
+    BOOST_CHECK(!loadCacheData(corrupt)); // version
+
+    corrupt = data;
+    setUInt32(corrupt, 16, 4);
+    BOOST_CHECK(!loadCacheData(corrupt)); // number of joints doesn't match the size
+
+    corrupt = data;
+    setUInt32(corrupt, 20, 0x40000000);
+    BOOST_CHECK(!loadCacheData(corrupt)); // number of frames overflowing 32 bits
+
+    corrupt = data;
+    setUInt32(corrupt, 24, 0x1000);
+    BOOST_CHECK(!loadCacheData(corrupt)); // command line longer than the strings
+
+    corrupt = data;
+    setUInt32(corrupt, 28, 0x1001);
+    BOOST_CHECK(!loadCacheData(corrupt)); // unaligned string size
+
+    // The second joint's parent, out of range and itself
+    corrupt = data;
+    setUInt32(corrupt, HEADER_SIZE + JOINT_RECORD_SIZE, 3);
+    BOOST_CHECK(!loadCacheData(corrupt));
+
+    corrupt = data;
+    setUInt32(corrupt, HEADER_SIZE + JOINT_RECORD_SIZE, 1);
+    BOOST_CHECK(!loadCacheData(corrupt));
+
+    // The second joint's name pointing outside the strings
+    corrupt = data;
+    setUInt32(corrupt, HEADER_SIZE + JOINT_RECORD_SIZE + 12, 0x1000);
+    BOOST_CHECK(!loadCacheData(corrupt));
+
+    corrupt = data;
+    setUInt32(corrupt, HEADER_SIZE + JOINT_RECORD_SIZE + 16, 0xffffffff);
+    BOOST_CHECK(!loadCacheData(corrupt));
+}
+
+// The blend of two frames matches the per-joint lerp and slerp the skeleton used to do
+BOOST_AUTO_TEST_CASE(interpolateFramesMatchesSlerp)
+{
+    std::srand(1);
+
+    const std::size_t numJoints = 64;
+
+    std::vector<float> first(7 * numJoints);
+    std::vector<float> second(7 * numJoints);
+    std::vector<float> out(7 * numJoints);
+
+    std::vector<Quaternion> qa(numJoints);
+    std::vector<Quaternion> qb(numJoints);
+
+    for (std::size_t i = 0; i < numJoints; ++i)
+    {
+        qa[i] = randomQuaternion();
+
+        // Cover identical, opposite and almost opposite orientations too
+        switch (i % 8)
+        {
+        case 0: qb[i] = qa[i]; break;
+        case 1: qb[i] = qa[i] * -1; break;
+        case 2: qb[i] = Quaternion(qa[i].x() + 0.001, qa[i].y(), qa[i].z(), -qa[i].w()).getNormalised() * -1; break;
+        default: qb[i] = randomQuaternion();
+        }
+
+        for (std::size_t c = 0; c < 3; ++c)
+        {
+            first[c * numJoints + i] = randomFloat();
+            second[c * numJoints + i] = randomFloat();
+        }
+
+        for (std::size_t c = 0; c < 4; ++c)
+        {
+            first[(3 + c) * numJoints + i] = static_cast<float>(qa[i][c]);
+            second[(3 + c) * numJoints + i] = static_cast<float>(qb[i][c]);
+        }
+    }
+
+    float fractions[] = { 0, 0.25f, 0.5f, 0.9f, 1 };
+
+    for (std::size_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); ++f)
+    {
+        float fraction = fractions[f];
+
+        MD5Anim::interpolateFrames(&first[0], &second[0], fraction, numJoints, &out[0]);
+
+        for (std::size_t i = 0; i < numJoints; ++i)
+        {
+            for (std::size_t c = 0; c < 3; ++c)
+            {
+                float expected = first[c * numJoints + i] * (1 - fraction) + second[c * numJoints + i] * fraction;
+                BOOST_CHECK_SMALL(out[c * numJoints + i] - expected, 1e-4f);
+            }
+
+            Quaternion a(first[3 * numJoints + i], first[4 * numJoints + i],
+                         first[5 * numJoints + i], first[6 * numJoints + i]);
+            Quaternion b(second[3 * numJoints + i], second[4 * numJoints + i],
+                         second[5 * numJoints + i], second[6 * numJoints + i]);
+
+            Quaternion expected = slerp(a, b, fraction).getNormalised();
+
+            // q and -q are the same rotation, for opposite quaternions the
+            // rounding decides which one comes out
+            double dot = 0;
+
+            for (std::size_t c = 0; c < 4; ++c)
+            {
+                dot += out[(3 + c) * numJoints + i] * expected[c];
+            }
+
+            if (dot < 0)
+            {
+                expected = Quaternion(-expected.x(), -expected.y(), -expected.z(), -expected.w());
+            }
+
+            for (std::size_t c = 0; c < 4; ++c)
+            {
+                BOOST_CHECK_MESSAGE(std::fabs(out[(3 + c) * numJoints + i] - expected[c]) < 1e-5,
+                    "joint " << i << " fraction " << fraction << ": " << out[(3 + c) * numJoints + i]
+                    << " != " << expected[c]);
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include "TestMesh.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <glibmm/timer.h>
+#include <boost/bind.hpp>
+
+/**
+ * Measures the time needed to skin a number of animated models per frame,
+ * including the tangent frames, with each kernel on the calling thread and
+ * with the fastest kernel on the thread pool. This is not part of the test
+ * suite, run "make skinningBenchmark" and execute it manually. The number
+ * of models can be passed as argument.
+ */
+using namespace md5;
+using namespace md5::test;
+
+namespace
+{
+    // Roughly the size of an AI character mesh
+    const std::size_t WIDTH = 64;
+    const std::size_t HEIGHT = 48;
+    const std::size_t NUM_JOINTS = 70;
+    const int FRAMES = 20;
+
+    // The number of vertices skinned by one job, as in MD5Model
+    const std::size_t RANGE_SIZE = 1024;
+
+    struct Model
+    {
+        SkinningJoints joints;
+        SkinnedVertices vertices;
+    };
+
+    struct Range
+    {
+        Model* model;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    class Benchmark
+    {
+        SkinningMesh _mesh;
+        std::vector<Model> _models;
+        std::vector<Range> _ranges;
+        const SkinningKernels* _kernels;
+
+    public:
+        Benchmark(std::size_t numModels) :
+            _mesh(createMesh(WIDTH, HEIGHT, NUM_JOINTS)),
+            _models(numModels),
+            _kernels(&getSkinningKernels())
+        {
+            for (std::size_t i = 0; i < _models.size(); ++i)
+            {
+                _models[i].joints = createSkinningJoints(createJoints(NUM_JOINTS));
+                _mesh.initialiseVertices(_models[i].vertices);
+
+                for (std::size_t first = 0; first < _mesh.getNumVertices(); first += RANGE_SIZE)
+                {
+                    Range range = { &_models[i], first, std::min(RANGE_SIZE, _mesh.getNumVertices() - first) };
+                    _ranges.push_back(range);
+                }
+            }
+        }
+
+        void skinRange(std::size_t index)
+        {
+            const Range& range = _ranges[index];
+            _kernels->skinVertices(_mesh, &range.model->joints[0], range.first, range.count, &range.model->vertices[0]);
+        }
+
+        void finishModel(std::size_t index)
+        {
+            calculateTangentFrames(_mesh, &_models[index].vertices[0]);
+        }
+
+        // Returns the milliseconds per frame
+        double measureSerial(const SkinningKernels& kernels)
+        {
+            _kernels = &kernels;
+
+            // Wall clock time, the CPU time would add up the threads
+            Glib::Timer timer;
+
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                for (std::size_t i = 0; i < _ranges.size(); ++i) skinRange(i);
+                for (std::size_t i = 0; i < _models.size(); ++i) finishModel(i);
+            }
+
+            return timer.elapsed() * 1000 / FRAMES;
+        }
+
+        double measurePool(WorkerPool& pool)
+        {
+            _kernels = &getSkinningKernels();
+
+            Glib::Timer timer;
+
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                pool.run(_ranges.size(), boost::bind(&Benchmark::skinRange, this, _1));
+                pool.run(_models.size(), boost::bind(&Benchmark::finishModel, this, _1));
+            }
+
+            return timer.elapsed() * 1000 / FRAMES;
+        }
+    };
+
+    void print(const std::string& name, double msecs)
+    {
+        std::cout << std::setw(24) << std::left << name
+                  << std::setw(10) << std::right << std::fixed << std::setprecision(2)
+                  << msecs << " ms per frame" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (!Glib::thread_supported()) Glib::thread_init();
+
+    std::size_t numModels = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 32;
+
+    std::srand(1);
+    Benchmark benchmark(numModels);
+
+    std::cout << "Skinning " << numModels << " models with " << WIDTH * HEIGHT << " vertices and "
+              << NUM_JOINTS << " joints, selected: " << getSkinningKernels().name << std::endl;
+
+    print(getScalarSkinningKernels().name, benchmark.measureSerial(getScalarSkinningKernels()));
+
+    if (getSSE2SkinningKernels() != NULL)
+    {
+        print(getSSE2SkinningKernels()->name, benchmark.measureSerial(*getSSE2SkinningKernels()));
+    }
+
+    WorkerPool pool(4);
+    print(std::string(getSkinningKernels().name) + ", 4 threads", benchmark.measurePool(pool));
+
+    return 0;
+}
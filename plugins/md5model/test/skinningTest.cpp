@@ -0,0 +1,164 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE skinningTest
+#include <boost/test/unit_test.hpp>
+
+#include "TestMesh.h"
+#include <render/ArbitraryMeshVertex.h>
+#include <boost/bind.hpp>
+
+#include <vector>
+#include <cmath>
+
+using namespace md5;
+using namespace md5::test;
+
+namespace
+{
+    const std::size_t WIDTH = 23;
+    const std::size_t HEIGHT = 17;
+    const std::size_t NUM_JOINTS = 12;
+
+    // All kernel tables available in this build
+    std::vector<const SkinningKernels*> getAllKernels()
+    {
+        std::vector<const SkinningKernels*> list;
+
+        list.push_back(&getScalarSkinningKernels());
+
+        if (getSSE2SkinningKernels() != NULL) list.push_back(getSSE2SkinningKernels());
+
+        return list;
+    }
+
+    void checkClose(const Vector3& expected, const float* actual, double tolerance, const char* what, std::size_t index)
+    {
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            if (std::fabs(expected[k] - actual[k]) > tolerance)
+            {
+                BOOST_ERROR(what << " mismatch at vertex " << index << ": "
+                    << expected << " != " << actual[0] << " " << actual[1] << " " << actual[2]);
+                return;
+            }
+        }
+    }
+}
+
+// The kernels must match the double precision quaternion transform
+BOOST_AUTO_TEST_CASE(skinVertices)
+{
+    std::srand(1);
+
+    MD5Mesh mesh = createMesh(WIDTH, HEIGHT, NUM_JOINTS);
+    MD5Joints joints = createJoints(NUM_JOINTS);
+    SkinningJoints skinningJoints = createSkinningJoints(joints);
+
+    SkinningMesh skinningMesh(mesh);
+
+    BOOST_REQUIRE_EQUAL(skinningMesh.getNumVertices(), mesh.vertices.size());
+
+    std::vector<const SkinningKernels*> kernels = getAllKernels();
+
+    for (std::size_t i = 0; i < kernels.size(); ++i)
+    {
+        SkinnedVertices vertices;
+        skinningMesh.initialiseVertices(vertices);
+
+        // Two ranges with an odd split
+        std::size_t split = vertices.size() / 3;
+        kernels[i]->skinVertices(skinningMesh, &skinningJoints[0], 0, split, &vertices[0]);
+        kernels[i]->skinVertices(skinningMesh, &skinningJoints[0], split, vertices.size() - split, &vertices[0]);
+
+        for (std::size_t v = 0; v < mesh.vertices.size(); ++v)
+        {
+            const MD5Vert& vert = mesh.vertices[v];
+            Vector3 expected(0, 0, 0);
+
+            for (std::size_t k = 0; k < vert.weight_count; ++k)
+            {
+                const MD5Weight& weight = mesh.weights[vert.weight_index + k];
+                const MD5Joint& joint = joints[weight.joint];
+
+                expected += (joint.rotation.transformPoint(weight.v) + joint.position) * weight.t;
+            }
+
+            checkClose(expected, vertices[v].position, 0.001, kernels[i]->name, v);
+        }
+    }
+}
+
+// The tangent frames must match the per-triangle calculation used for other models
+BOOST_AUTO_TEST_CASE(tangentFrames)
+{
+    std::srand(2);
+
+    MD5Mesh mesh = createMesh(WIDTH, HEIGHT, NUM_JOINTS);
+    SkinningJoints skinningJoints = createSkinningJoints(createJoints(NUM_JOINTS));
+
+    SkinningMesh skinningMesh(mesh);
+
+    SkinnedVertices vertices;
+    skinningMesh.initialiseVertices(vertices);
+
+    getScalarSkinningKernels().skinVertices(skinningMesh, &skinningJoints[0], 0, vertices.size(), &vertices[0]);
+    calculateTangentFrames(skinningMesh, &vertices[0]);
+
+    std::vector<ArbitraryMeshVertex> reference(vertices.size());
+
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        reference[v].vertex = Vertex3f(vertices[v].position[0], vertices[v].position[1], vertices[v].position[2]);
+        reference[v].texcoord = TexCoord2f(mesh.vertices[v].u, mesh.vertices[v].v);
+        reference[v].normal = Normal3f(0, 0, 0);
+    }
+
+    for (MD5Tris::const_iterator t = mesh.triangles.begin(); t != mesh.triangles.end(); ++t)
+    {
+        ArbitraryMeshVertex& a = reference[t->a];
+        ArbitraryMeshVertex& b = reference[t->b];
+        ArbitraryMeshVertex& c = reference[t->c];
+
+        Vector3 weightedNormal((c.vertex - a.vertex).crossProduct(b.vertex - a.vertex));
+
+        a.normal += weightedNormal;
+        b.normal += weightedNormal;
+        c.normal += weightedNormal;
+
+        ArbitraryMeshTriangle_sumTangents(a, b, c);
+    }
+
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        checkClose(reference[v].normal.getNormalised(), vertices[v].normal, 0.001, "normal", v);
+        checkClose(reference[v].tangent.getNormalised(), vertices[v].tangent, 0.001, "tangent", v);
+        checkClose(reference[v].bitangent.getNormalised(), vertices[v].bitangent, 0.001, "bitangent", v);
+    }
+}
+
+namespace
+{
+    void markJob(std::vector<int>* calls, std::size_t index)
+    {
+        ++(*calls)[index];
+    }
+}
+
+// Each job has to be executed exactly once, also when the pool is re-used
+BOOST_AUTO_TEST_CASE(threadPool)
+{
+    if (!Glib::thread_supported()) Glib::thread_init();
+
+    WorkerPool pool(4);
+
+    for (int round = 0; round < 3; ++round)
+    {
+        std::vector<int> calls(1000, 0);
+
+        pool.run(calls.size(), boost::bind(markJob, &calls, _1));
+
+        for (std::size_t i = 0; i < calls.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL(calls[i], 1);
+        }
+    }
+}
@@ -0,0 +1,312 @@
+#include "PicoModelDiskCache.h"
+
+#include <cstring>
+#include <boost/bind.hpp>
+
+namespace model
+{
+
+namespace
+{
+	const std::string CACHE_FOLDER = "modelcache/";
+	const std::string CACHE_FILE_EXTENSION = ".dmdl";
+
+	// A few thousand static models of average size
+	const std::size_t MAX_CACHE_SIZE = 256 << 20;
+
+	// Increase this whenever the file layout or the geometry extraction changes
+	const guint32 CACHE_FILE_VERSION = 3;
+
+	const char CACHE_FILE_MAGIC[4] = { 'D', 'R', 'P', 'M' };
+
+	// The number of doubles stored per vertex: texcoord, normal, vertex,
+	// tangent, bitangent and colour
+	const std::size_t DOUBLES_PER_VERTEX = 17;
+
+	// The layout of the cache files: the header is followed by the surface
+	// table and the shader names (padded to eight bytes). After that come
+	// the vertices of all surfaces, then the indices of all surfaces.
+	struct CacheFileHeader
+	{
+		char magic[4];
+		guint32 version;
+		guint32 numSurfaces;
+		guint32 stringSize;
+	};
+
+	struct CacheFileSurface
+	{
+		guint32 shaderNameOffset; // relative to the string data
+		guint32 shaderNameLength;
+		guint32 fallbackShaderNameOffset;
+		guint32 fallbackShaderNameLength;
+		guint32 numVertices;
+		guint32 numIndices;
+		double origin[3];
+		double extents[3];
+	};
+
+	void writeVector(double*& out, const Vector3& vector)
+	{
+		*out++ = vector.x();
+		*out++ = vector.y();
+		*out++ = vector.z();
+	}
+
+	void writeIndices(std::ostream& stream, const std::vector<unsigned int>& indices)
+	{
+		for (std::size_t n = 0; n < indices.size(); ++n)
+		{
+			guint32 index = static_cast<guint32>(indices[n]);
+			stream.write(reinterpret_cast<const char*>(&index), sizeof(index));
+		}
+	}
+
+	// Reads the given number of indices, returns false if any is out of range
+	bool readIndices(const char*& data, std::size_t count, std::size_t numVertices,
+					 std::vector<unsigned int>& indices)
+	{
+		indices.resize(count);
+
+		for (std::size_t n = 0; n < count; ++n, data += sizeof(guint32))
+		{
+			guint32 index;
+			std::memcpy(&index, data, sizeof(index));
+
+			if (index >= numVertices)
+			{
+				return false;
+			}
+
+			indices[n] = index;
+		}
+
+		return true;
+	}
+
+	void writeCacheFile(std::ostream& stream, const std::vector<PicoSurfaceGeometry>& surfaces)
+	{
+		std::string strings;
+		std::vector<CacheFileSurface> records(surfaces.size());
+
+		guint64 numVertices = 0;
+		guint64 numIndices = 0;
+
+		for (std::size_t i = 0; i < surfaces.size(); ++i)
+		{
+			const PicoSurfaceGeometry& surface = surfaces[i];
+			CacheFileSurface& record = records[i];
+
+			record.shaderNameOffset = static_cast<guint32>(strings.size());
+			record.shaderNameLength = static_cast<guint32>(surface.shaderName.size());
+			strings += surface.shaderName;
+
+			record.fallbackShaderNameOffset = static_cast<guint32>(strings.size());
+			record.fallbackShaderNameLength = static_cast<guint32>(surface.fallbackShaderName.size());
+			strings += surface.fallbackShaderName;
+
+			record.numVertices = static_cast<guint32>(surface.vertices.size());
+			record.numIndices = static_cast<guint32>(surface.indices.size());
+
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				record.origin[k] = surface.localAABB.origin[k];
+				record.extents[k] = surface.localAABB.extents[k];
+			}
+
+			numVertices += record.numVertices;
+			numIndices += record.numIndices;
+		}
+
+		// Keep the vertex data aligned
+		strings.resize((strings.size() + 7) & ~static_cast<std::size_t>(7), '\0');
+
+		CacheFileHeader header;
+		std::memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+		header.version = CACHE_FILE_VERSION;
+		header.numSurfaces = static_cast<guint32>(surfaces.size());
+		header.stringSize = static_cast<guint32>(strings.size());
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if (!records.empty())
+		{
+			stream.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(CacheFileSurface));
+		}
+
+		stream.write(strings.data(), strings.size());
+
+		double values[DOUBLES_PER_VERTEX];
+
+		for (std::size_t i = 0; i < surfaces.size(); ++i)
+		{
+			const std::vector<ArbitraryMeshVertex>& vertices = surfaces[i].vertices;
+
+			for (std::size_t v = 0; v < vertices.size(); ++v)
+			{
+				const ArbitraryMeshVertex& vertex = vertices[v];
+				double* out = values;
+
+				*out++ = vertex.texcoord.x();
+				*out++ = vertex.texcoord.y();
+				writeVector(out, vertex.normal);
+				writeVector(out, vertex.vertex);
+				writeVector(out, vertex.tangent);
+				writeVector(out, vertex.bitangent);
+				writeVector(out, vertex.colour);
+
+				stream.write(reinterpret_cast<const char*>(values), sizeof(values));
+			}
+		}
+
+		for (std::size_t i = 0; i < surfaces.size(); ++i)
+		{
+			writeIndices(stream, surfaces[i].indices);
+		}
+	}
+
+	bool readCacheFile(const char* data, std::size_t length, std::vector<PicoSurfaceGeometry>& surfaces)
+	{
+		CacheFileHeader header;
+
+		if (data == NULL || length < sizeof(header))
+		{
+			return false;
+		}
+
+		std::memcpy(&header, data, sizeof(header));
+
+		if (std::memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != CACHE_FILE_VERSION ||
+			header.stringSize % 8 != 0)
+		{
+			return false;
+		}
+
+		const std::size_t numSurfaces = header.numSurfaces;
+
+		// Compare the sizes in 64 bits, the counts come from the file
+		guint64 tableLength = sizeof(header) + static_cast<guint64>(numSurfaces) * sizeof(CacheFileSurface) +
+			header.stringSize;
+
+		if (tableLength > length)
+		{
+			return false;
+		}
+
+		const char* records = data + sizeof(header);
+		const char* strings = records + numSurfaces * sizeof(CacheFileSurface);
+
+		std::vector<CacheFileSurface> table(numSurfaces);
+
+		guint64 numVertices = 0;
+		guint64 numIndices = 0;
+
+		for (std::size_t i = 0; i < numSurfaces; ++i)
+		{
+			CacheFileSurface& record = table[i];
+			std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+
+			if (static_cast<guint64>(record.shaderNameOffset) + record.shaderNameLength > header.stringSize ||
+				static_cast<guint64>(record.fallbackShaderNameOffset) + record.fallbackShaderNameLength > header.stringSize ||
+				record.numIndices % 3 != 0)
+			{
+				return false;
+			}
+
+			numVertices += record.numVertices;
+			numIndices += record.numIndices;
+		}
+
+		if (tableLength + numVertices * DOUBLES_PER_VERTEX * sizeof(double) +
+			numIndices * sizeof(guint32) != length)
+		{
+			return false;
+		}
+
+		const char* vertexData = strings + header.stringSize;
+		const char* indexData = vertexData + numVertices * DOUBLES_PER_VERTEX * sizeof(double);
+
+		std::vector<PicoSurfaceGeometry> result(numSurfaces);
+
+		for (std::size_t i = 0; i < numSurfaces; ++i)
+		{
+			const CacheFileSurface& record = table[i];
+			PicoSurfaceGeometry& surface = result[i];
+
+			surface.shaderName.assign(strings + record.shaderNameOffset, record.shaderNameLength);
+			surface.fallbackShaderName.assign(strings + record.fallbackShaderNameOffset, record.fallbackShaderNameLength);
+			surface.localAABB = AABB(Vector3(record.origin), Vector3(record.extents));
+
+			surface.vertices.resize(record.numVertices);
+
+			double values[DOUBLES_PER_VERTEX];
+
+			for (std::size_t v = 0; v < surface.vertices.size(); ++v, vertexData += sizeof(values))
+			{
+				std::memcpy(values, vertexData, sizeof(values));
+
+				ArbitraryMeshVertex& vertex = surface.vertices[v];
+
+				vertex.texcoord = TexCoord2f(values[0], values[1]);
+				vertex.normal = Normal3f(values + 2);
+				vertex.vertex = Vertex3f(values + 5);
+				vertex.tangent = Normal3f(values + 8);
+				vertex.bitangent = Normal3f(values + 11);
+				vertex.colour = Vector3(values + 14);
+			}
+
+			if (!readIndices(indexData, record.numIndices, record.numVertices, surface.indices))
+			{
+				return false;
+			}
+		}
+
+		surfaces.swap(result);
+
+		return true;
+	}
+}
+
+PicoModelDiskCache::PicoModelDiskCache() :
+	_cache(CACHE_FOLDER, CACHE_FILE_EXTENSION, MAX_CACHE_SIZE)
+{}
+
+std::string PicoModelDiskCache::getKey(const void* contents, std::size_t length, const std::string& fExt)
+{
+	DiskCacheKey key;
+
+	// The extension determines how the material names are assigned
+	key.add(fExt);
+	key.add(contents, length);
+
+	return key.toString();
+}
+
+bool PicoModelDiskCache::load(const std::string& key, std::vector<PicoSurfaceGeometry>& surfaces)
+{
+	GMappedFile* file = _cache.open(key);
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	bool success = readCacheFile(g_mapped_file_get_contents(file), g_mapped_file_get_length(file), surfaces);
+
+	g_mapped_file_unref(file);
+
+	if (!success)
+	{
+		_cache.remove(key);
+	}
+
+	return success;
+}
+
+void PicoModelDiskCache::store(const std::string& key, const std::vector<PicoSurfaceGeometry>& surfaces)
+{
+	_cache.store(key, boost::bind(writeCacheFile, _1, boost::cref(surfaces)));
+}
+
+} // namespace
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "RenderablePicoSurface.h"
+#include "DiskCache.h"
+
+#include <string>
+#include <vector>
+
+namespace model
+{
+
+/**
+ * Persistent disk cache of models loaded through picomodel, located in the
+ * user's settings folder. The files hold the final surface geometry including
+ * the tangent frames, so neither the parser nor the tangent calculation need
+ * to run for cached models. They are keyed by a hash of the model file
+ * contents, changed files are picked up automatically.
+ */
+class PicoModelDiskCache
+{
+	DiskCache _cache;
+
+public:
+	PicoModelDiskCache();
+
+	// Returns the cache key for the given model file contents and lowercase extension
+	static std::string getKey(const void* contents, std::size_t length, const std::string& fExt);
+
+	// Reads the cached surfaces for the given key, returns false if there are none
+	bool load(const std::string& key, std::vector<PicoSurfaceGeometry>& surfaces);
+
+	// Writes the given surfaces to the cache
+	void store(const std::string& key, const std::vector<PicoSurfaceGeometry>& surfaces);
+};
+typedef boost::shared_ptr<PicoModelDiskCache> PicoModelDiskCachePtr;
+
+} // namespace
@@ -8,6 +8,7 @@
 #include "picomodel.h"
 
 #include "os/path.h"
+#include "archivelib.h"
 
 #include "PicoModelNode.h"
 
@@ -27,12 +28,24 @@ namespace {
 	size_t picoInputStreamReam(void* inputStream, unsigned char* buffer, size_t length) {
 		return reinterpret_cast<InputStream*>(inputStream)->read(buffer, length);
 	}
+
+	// The surface geometry, converted to a RenderablePicoModel in createModel()
+	class PreparedPicoModel :
+		public PreparedModel
+	{
+	public:
+		std::vector<PicoSurfaceGeometry> surfaces;
+
+		std::string filename;
+	};
 } // namespace
 
-PicoModelLoader::PicoModelLoader(const picoModule_t* module, const std::string& extension) :
+PicoModelLoader::PicoModelLoader(const picoModule_t* module, const std::string& extension,
+								 const PicoModelDiskCachePtr& diskCache) :
 	_module(module),
 	_extension(extension),
-	_moduleName("ModelLoader" + extension) // e.g. ModelLoaderASE
+	_moduleName("ModelLoader" + extension), // e.g. ModelLoaderASE
+	_diskCache(diskCache)
 {}
 
 // Returns a new ModelNode for the given model name
@@ -81,33 +94,87 @@ IModelPtr PicoModelLoader::loadModelFromPath(const std::string& name)
 		return IModelPtr();
 	}
 
+	return createModel(name, prepareModel(*file));
+}
+
+PreparedModelPtr PicoModelLoader::prepareModel(ArchiveFile& file)
+{
+	boost::shared_ptr<PreparedPicoModel> prepared(new PreparedPicoModel);
+
 	// Determine the file extension (ASE or LWO) to pass down to the PicoModel
-	std::string fName = file->getName();
+	std::string fName = file.getName();
 	boost::algorithm::to_lower(fName);
-	std::string fExt = fName.substr(fName.size() - 3, 3);
-
-	picoModel_t* model = PicoModuleLoadModelStream(
-		_module,
-		&file->getInputStream(),
-		picoInputStreamReam,
-		file->size(),
-		0
-	);
+	std::string extension = fName.substr(fName.size() - 3, 3);
+
+	prepared->filename = os::getFilename(file.getName());
+
+	// The contents are needed for the cache key and possibly the parser
+	MemoryArchiveFile contents(file);
+
+	std::string key = PicoModelDiskCache::getKey(contents.getData(), contents.size(), extension);
+
+	if (_diskCache->load(key, prepared->surfaces))
+	{
+		return prepared;
+	}
+
+	picoModel_t* model = NULL;
+
+	{
+		// The LWO reader keeps its file length in a global variable,
+		// so LWO files must not be parsed on several threads at once
+		Glib::Mutex::Lock lock(_parserLock, Glib::NOT_LOCK);
+
+		if (_extension == "LWO")
+		{
+			lock.acquire();
+		}
+
+		model = PicoModuleLoadModelStream(
+			_module,
+			&contents.getInputStream(),
+			picoInputStreamReam,
+			contents.size(),
+			0
+		);
+	}
+
+	if (model == NULL)
+	{
+		return PreparedModelPtr();
+	}
+
+	RenderablePicoModel::extractGeometry(model, extension, prepared->surfaces);
+
+	PicoFreeModel(model);
+
+	// Models without surfaces are failed loads, don't cache these
+	if (!prepared->surfaces.empty())
+	{
+		_diskCache->store(key, prepared->surfaces);
+	}
+
+	return prepared;
+}
+
+IModelPtr PicoModelLoader::createModel(const std::string& name, const PreparedModelPtr& prepared)
+{
+	boost::shared_ptr<PreparedPicoModel> picoModel =
+		boost::dynamic_pointer_cast<PreparedPicoModel>(prepared);
 
 	// greebo: Check if the model load was successful
-	if (model == NULL || model->numSurfaces == 0) {
+	if (!picoModel || picoModel->surfaces.empty()) {
 		// Model is either NULL or has no surfaces, this must've failed
 		return IModelPtr();
 	}
 
 	RenderablePicoModelPtr modelObj(
-		new RenderablePicoModel(model, fExt)
+		new RenderablePicoModel(picoModel->surfaces)
 	);
 	// Set the filename
-	modelObj->setFilename(os::getFilename(file->getName()));
+	modelObj->setFilename(picoModel->filename);
 	modelObj->setModelPath(name);
 
-	PicoFreeModel(model);
 	return modelObj;
 }
 
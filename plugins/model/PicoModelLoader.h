@@ -2,6 +2,8 @@
 #define PICOMODELLOADER_H_
 
 #include "imodel.h"
+#include "PicoModelDiskCache.h"
+#include <glibmm/thread.h>
 
 typedef struct picoModule_s picoModule_t;
 
@@ -17,8 +19,15 @@ class PicoModelLoader :
 
 	// The resulting name of the module (ModelLoaderASE, for instance)
 	std::string _moduleName;
+
+	// Serialises prepareModel() calls where the parser isn't reentrant
+	Glib::Mutex _parserLock;
+
+	// The converted models, shared by all picomodel loaders
+	PicoModelDiskCachePtr _diskCache;
 public:
-	PicoModelLoader(const picoModule_t* module, const std::string& extension);
+	PicoModelLoader(const picoModule_t* module, const std::string& extension,
+					const PicoModelDiskCachePtr& diskCache);
 
 	// Returns a new ModelNode for the given model name
 	virtual scene::INodePtr loadModel(const std::string& modelName);
@@ -26,6 +35,10 @@ public:
   	// Load the given model from the VFS path
 	IModelPtr loadModelFromPath(const std::string& name);
 
+	// Documentation: See imodel.h
+	PreparedModelPtr prepareModel(ArchiveFile& file);
+	IModelPtr createModel(const std::string& name, const PreparedModelPtr& prepared);
+
 	// RegisterableModule implementation
   	virtual const std::string& getName() const;
   	virtual const StringSet& getDependencies() const;
@@ -7,6 +7,8 @@
 #include "ifilter.h"
 #include "imodelcache.h"
 #include "math/Frustum.h"
+#include "render/MeshLod.h"
+#include "render/MeshSimplifier.h"
 #include "generic/callback.h"
 #include <boost/bind.hpp>
 
@@ -70,6 +72,11 @@ bool PicoModelNode::intersectsLight(const RendererLight& light) const
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& PicoModelNode::getLitObjectAABB() const
+{
+	return worldAABB();
+}
+
 // Add a light to this model instance
 void PicoModelNode::insertLight(const RendererLight& light)
 {
@@ -129,8 +136,18 @@ void PicoModelNode::submitRenderables(RenderableCollector& collector,
 		// Submit the lights
 		collector.setLights(_lights);
 
-		// Submit the model's geometry
-		_picoModel->submitRenderables(collector, localToWorld, entity);
+		// Submit the model's geometry, simplified if it appears small in the camera view.
+		// The surfaces fall back to the coarsest level they have, if any.
+		std::size_t lodLevel = render::selectMeshLod(volume,
+			AABB::createFromOrientedAABBSafe(_picoModel->localAABB(), localToWorld),
+			render::MAX_MESH_LOD_LEVELS);
+
+		if (lodLevel > 0)
+		{
+			_picoModel->generateLodLevels();
+		}
+
+		_picoModel->submitRenderables(collector, localToWorld, entity, lodLevel);
 	}
 }
 
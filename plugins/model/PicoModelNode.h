@@ -72,6 +72,7 @@ public:
 
 	// LitObject test function
 	bool intersectsLight(const RendererLight& light) const;
+	const AABB& getLitObjectAABB() const;
 	// Add a light to this model instance
 	void insertLight(const RendererLight& light);
 	// Clear all lights from this model instance
@@ -15,13 +15,34 @@ namespace model
 {
 
 // Constructor
-RenderablePicoModel::RenderablePicoModel(picoModel_t* mod,
-										 const std::string& fExt)
+RenderablePicoModel::RenderablePicoModel(std::vector<PicoSurfaceGeometry>& surfaces)
+{
+	// Create a RenderablePicoSurface for each surface
+	for (std::size_t n = 0; n < surfaces.size(); ++n)
+	{
+		// Create the RenderablePicoSurface object and add it to the vector
+		RenderablePicoSurfacePtr rSurf(new RenderablePicoSurface(surfaces[n]));
+
+		_surfVec.push_back(Surface(rSurf));
+
+		// Extend the model AABB to include the surface's AABB
+		_localAABB.includeAABB(rSurf->getAABB());
+	}
+
+	surfaces.clear();
+}
+
+void RenderablePicoModel::extractGeometry(picoModel_t* mod,
+										  const std::string& fExt,
+										  std::vector<PicoSurfaceGeometry>& surfaces)
 {
 	// Get the number of surfaces to create
 	int nSurf = PicoGetModelNumSurfaces(mod);
 
-	// Create a RenderablePicoSurface for each surface in the structure
+	surfaces.clear();
+	surfaces.reserve(nSurf);
+
+	// Convert each surface in the structure
 	for (int n = 0; n < nSurf; ++n)
 	{
 		// Retrieve the surface, discarding it if it is null or non-triangulated (?)
@@ -33,13 +54,8 @@ RenderablePicoModel::RenderablePicoModel(picoModel_t* mod,
 		// Fix the normals of the surface (?)
 		PicoFixSurfaceNormals(surf);
 
-		// Create the RenderablePicoSurface object and add it to the vector
-		RenderablePicoSurfacePtr rSurf(new RenderablePicoSurface(surf, fExt));
-
-		_surfVec.push_back(Surface(rSurf));
-
-		// Extend the model AABB to include the surface's AABB
-		_localAABB.includeAABB(rSurf->getAABB());
+		surfaces.push_back(PicoSurfaceGeometry());
+		RenderablePicoSurface::extractGeometry(surf, fExt, surfaces.back());
 	}
 }
 
@@ -60,7 +76,8 @@ RenderablePicoModel::RenderablePicoModel(const RenderablePicoModel& other) :
 // Front end renderable submission
 void RenderablePicoModel::submitRenderables(RenderableCollector& rend,
 											const Matrix4& localToWorld,
-											const IRenderEntity& entity)
+											const IRenderEntity& entity,
+											std::size_t lodLevel)
 {
 	// Submit renderables from each surface
 	for (SurfaceList::iterator i = _surfVec.begin(); i != _surfVec.end(); ++i)
@@ -73,11 +90,19 @@ void RenderablePicoModel::submitRenderables(RenderableCollector& rend,
 
 		if (surfaceShader->isVisible())
 		{
-			i->surface->submitRenderables(rend, localToWorld, i->shader, entity);
+			i->surface->submitRenderables(rend, localToWorld, i->shader, entity, lodLevel);
 		}
 	}
 }
 
+void RenderablePicoModel::generateLodLevels()
+{
+	for (SurfaceList::iterator i = _surfVec.begin(); i != _surfVec.end(); ++i)
+	{
+		i->surface->generateLodLevels();
+	}
+}
+
 void RenderablePicoModel::setRenderSystem(const RenderSystemPtr& renderSystem)
 {
 	_renderSystem = renderSystem;
@@ -5,6 +5,7 @@
 #include "math/AABB.h"
 #include "imodelsurface.h"
 
+#include <vector>
 #include <boost/shared_ptr.hpp>
 
 class Ray;
@@ -13,6 +14,7 @@ class Ray;
 namespace model
 {
 	class RenderablePicoSurface;
+	struct PicoSurfaceGeometry;
 	typedef boost::shared_ptr<RenderablePicoSurface> RenderablePicoSurfacePtr;
 }
 class RenderableCollector;
@@ -90,11 +92,20 @@ private:
 public:
 
 	/**
-	 * Constructor. Accepts a picoModel_t struct containing the raw model data
-	 * loaded from picomodel, and a string filename extension to allow the
-	 * correct handling of material paths (which differs between ASE and LWO)
+	 * Constructor. Accepts the surface geometry as extracted by extractGeometry(),
+	 * the geometry vector is left empty. Needs to be called on the main thread.
 	 */
-	RenderablePicoModel(picoModel_t* mod, const std::string& fExt);
+	RenderablePicoModel(std::vector<PicoSurfaceGeometry>& surfaces);
+
+	/**
+	 * Converts a picoModel_t struct containing the raw model data loaded from
+	 * picomodel into the given surface geometry. The string filename extension
+	 * allows the correct handling of material paths (which differs between
+	 * ASE and LWO). This doesn't use any other module and may be called on any
+	 * thread.
+	 */
+	static void extractGeometry(picoModel_t* mod, const std::string& fExt,
+								std::vector<PicoSurfaceGeometry>& surfaces);
 
 	/**
 	 * Copy constructor: re-use the surfaces from the other model
@@ -113,9 +124,18 @@ public:
 	 *
 	 * @param entity
 	 * The entity this model is attached to.
+	 *
+	 * @param lodLevel
+	 * The level of detail to submit the surfaces with, 0 is full detail.
 	 */
 	void submitRenderables(RenderableCollector& rend, const Matrix4& localToWorld,
-						   const IRenderEntity& entity);
+						   const IRenderEntity& entity, std::size_t lodLevel = 0);
+
+	/**
+	 * Generates the simplified levels of detail of all surfaces, if not done yet.
+	 * The surfaces are shared between the copies of a model, so are the levels.
+	 */
+	void generateLodLevels();
 
 	void setRenderSystem(const RenderSystemPtr& renderSystem);
 
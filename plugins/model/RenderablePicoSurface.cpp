@@ -5,56 +5,86 @@
 #include "math/Ray.h"
 #include "iselectiontest.h"
 #include "irenderable.h"
+#include "render/MeshSimplifier.h"
 
 #include <boost/algorithm/string/replace.hpp>
 
 namespace model {
 
-// Constructor. Copy the provided picoSurface_t structure into this object
-RenderablePicoSurface::RenderablePicoSurface(picoSurface_t* surf,
-											 const std::string& fExt)
-: _shaderName(""),
+namespace
+{
+	// Surfaces below this triangle count are rendered at full detail only
+	const std::size_t MIN_LOD_TRIANGLES = 200;
+}
+
+// Constructor. Take over the provided geometry
+RenderablePicoSurface::RenderablePicoSurface(PicoSurfaceGeometry& geometry)
+: _shaderName(geometry.shaderName),
+  _localAABB(geometry.localAABB),
   _dlRegular(0),
   _dlProgramVcol(0),
-  _dlProgramNoVCol(0)
+  _dlProgramNoVCol(0),
+  _lodLevelsGenerated(false)
+{
+	// If shader not found, fallback to alternative if available
+	// _shaderName is empty if the ase material has no BITMAP
+	// materialIsValid is false if _shaderName is not an existing shader
+	if ((_shaderName.empty() || !GlobalMaterialManager().materialExists(_shaderName)) &&
+		!geometry.fallbackShaderName.empty())
+	{
+		_shaderName = geometry.fallbackShaderName;
+	}
+
+	// Capturing the shader happens later on when we have a RenderSystem reference
+
+	_vertices.swap(geometry.vertices);
+	_indices.swap(geometry.indices);
+	_nIndices = static_cast<unsigned int>(_indices.size());
+
+	// Construct the DLs
+	createDisplayLists();
+}
+
+// Copy the provided picoSurface_t structure into the geometry
+void RenderablePicoSurface::extractGeometry(picoSurface_t* surf,
+											const std::string& fExt,
+											PicoSurfaceGeometry& geometry)
 {
 	// Get the shader from the picomodel struct. If this is a LWO model, use
 	// the material name to select the shader, while for an ASE model the
 	// bitmap path should be used.
 	picoShader_t* shader = PicoGetSurfaceShader(surf);
-	std::string rawName = "";
+
+	geometry.shaderName.clear();
+	geometry.fallbackShaderName.clear();
 
 	if (shader != 0)
 	{
 		if (fExt == "lwo")
 		{
-			_shaderName = PicoGetShaderName(shader);
+			geometry.shaderName = PicoGetShaderName(shader);
 		}
 		else if (fExt == "ase")
 		{
-			rawName = PicoGetShaderName(shader);
+			std::string rawName = PicoGetShaderName(shader);
 			std::string rawMapName = PicoGetShaderMapName(shader);
-			_shaderName = cleanupShaderName(rawMapName);
-		}
-	}
+			geometry.shaderName = cleanupShaderName(rawMapName);
 
-	// If shader not found, fallback to alternative if available
-	// _shaderName is empty if the ase material has no BITMAP
-	// materialIsValid is false if _shaderName is not an existing shader
-	if ((_shaderName.empty() || !GlobalMaterialManager().materialExists(_shaderName)) &&
-		!rawName.empty())
-	{
-		_shaderName = cleanupShaderName(rawName);
+			// Whether the material exists is checked on the main thread
+			if (!rawName.empty())
+			{
+				geometry.fallbackShaderName = cleanupShaderName(rawName);
+			}
+		}
 	}
 
-	// Capturing the shader happens later on when we have a RenderSystem reference
-
     // Get the number of vertices and indices, and reserve capacity in our
     // vectors in advance by populating them with empty structs.
     int nVerts = PicoGetSurfaceNumVertexes(surf);
-    _nIndices = PicoGetSurfaceNumIndexes(surf);
-    _vertices.resize(nVerts);
-    _indices.resize(_nIndices);
+    int nIndices = PicoGetSurfaceNumIndexes(surf);
+    geometry.vertices.resize(nVerts);
+    geometry.indices.resize(nIndices);
+    geometry.localAABB = AABB();
 
     // Stream in the vertex data from the raw struct, expanding the local AABB
     // to include each vertex.
@@ -64,25 +94,23 @@ RenderablePicoSurface::RenderablePicoSurface(picoSurface_t* surf,
 		Vertex3f vertex(PicoGetSurfaceXYZ(surf, vNum));
 
 		// Expand the AABB to include this new vertex
-    	_localAABB.includePoint(vertex);
+    	geometry.localAABB.includePoint(vertex);
 
-    	_vertices[vNum].vertex = vertex;
-    	_vertices[vNum].normal = Normal3f(PicoGetSurfaceNormal(surf, vNum));
-    	_vertices[vNum].texcoord = TexCoord2f(PicoGetSurfaceST(surf, 0, vNum));
-    	_vertices[vNum].colour =
-    		getColourVector(PicoGetSurfaceColor(surf, 0, vNum));
+    	ArbitraryMeshVertex& v = geometry.vertices[vNum];
+
+    	v.vertex = vertex;
+    	v.normal = Normal3f(PicoGetSurfaceNormal(surf, vNum));
+    	v.texcoord = TexCoord2f(PicoGetSurfaceST(surf, 0, vNum));
+    	v.colour = getColourVector(PicoGetSurfaceColor(surf, 0, vNum));
     }
 
     // Stream in the index data
     picoIndex_t* ind = PicoGetSurfaceIndexes(surf, 0);
-    for (unsigned int i = 0; i < _nIndices; i++)
-    	_indices[i] = ind[i];
+    for (int i = 0; i < nIndices; i++)
+    	geometry.indices[i] = ind[i];
 
 	// Calculate the tangent and bitangent vectors
-	calculateTangents();
-
-	// Construct the DLs
-	createDisplayLists();
+	calculateTangents(geometry);
 }
 
 std::string RenderablePicoSurface::cleanupShaderName(const std::string& inName)
@@ -133,6 +161,13 @@ RenderablePicoSurface::~RenderablePicoSurface()
 	glDeleteLists(_dlRegular, 1);
 	glDeleteLists(_dlProgramNoVCol, 1);
 	glDeleteLists(_dlProgramVcol, 1);
+
+	for (std::size_t i = 0; i < _lodLevels.size(); ++i)
+	{
+		glDeleteLists(_lodLevels[i]->dlRegular, 1);
+		glDeleteLists(_lodLevels[i]->dlProgramNoVCol, 1);
+		glDeleteLists(_lodLevels[i]->dlProgramVcol, 1);
+	}
 }
 
 // Convert byte pointers to colour vector
@@ -146,25 +181,27 @@ Vector3 RenderablePicoSurface::getColourVector(unsigned char* array) {
 }
 
 // Tangent calculation
-void RenderablePicoSurface::calculateTangents() {
+void RenderablePicoSurface::calculateTangents(PicoSurfaceGeometry& geometry) {
+
+	VertexVector& vertices = geometry.vertices;
 
 	// Calculate the tangents and bitangents using the indices into the vertex
 	// array.
-	for (Indices::iterator i = _indices.begin();
-		 i != _indices.end();
+	for (Indices::iterator i = geometry.indices.begin();
+		 i != geometry.indices.end();
 		 i += 3)
 	{
-		ArbitraryMeshVertex& a = _vertices[*i];
-		ArbitraryMeshVertex& b = _vertices[*(i + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(i + 2)];
+		ArbitraryMeshVertex& a = vertices[*i];
+		ArbitraryMeshVertex& b = vertices[*(i + 1)];
+		ArbitraryMeshVertex& c = vertices[*(i + 2)];
 
 		// Call the tangent calculation function
 		ArbitraryMeshTriangle_sumTangents(a, b, c);
 	}
 
 	// Normalise all of the tangent and bitangent vectors
-	for (VertexVector::iterator j = _vertices.begin();
-		 j != _vertices.end();
+	for (VertexVector::iterator j = vertices.begin();
+		 j != vertices.end();
 		 ++j)
 	{
 		j->tangent.normalise();
@@ -176,44 +213,61 @@ void RenderablePicoSurface::calculateTangents() {
 void RenderablePicoSurface::submitRenderables(RenderableCollector& rend,
 											  const Matrix4& localToWorld,
 											  const ShaderPtr& shader,
-											  const IRenderEntity& entity)
+											  const IRenderEntity& entity,
+											  std::size_t lodLevel)
 {
 	// Submit geometry
 	rend.SetState(shader, RenderableCollector::eFullMaterials);
-    rend.addRenderable(*this, localToWorld, entity);
+
+	if (lodLevel == 0 || _lodLevels.empty())
+	{
+		rend.addRenderable(*this, localToWorld, entity);
+	}
+	else
+	{
+		std::size_t index = std::min(lodLevel, _lodLevels.size()) - 1;
+
+		rend.addRenderable(*_lodLevels[index], localToWorld, entity);
+	}
 }
 
 // Back-end render function
 void RenderablePicoSurface::render(const RenderInfo& info) const
+{
+	callDisplayList(info, _dlRegular, _dlProgramVcol, _dlProgramNoVCol);
+}
+
+void RenderablePicoSurface::callDisplayList(const RenderInfo& info, GLuint regular,
+											GLuint programVcol, GLuint programNoVCol)
 {
 	// Invoke appropriate display list
 	if (info.checkFlag(RENDER_PROGRAM))
     {
         if (info.checkFlag(RENDER_VERTEX_COLOUR))
         {
-            glCallList(_dlProgramVcol);
+            glCallList(programVcol);
         }
         else
         {
-            glCallList(_dlProgramNoVCol);
+            glCallList(programNoVCol);
         }
 	}
 	else
     {
-		glCallList(_dlRegular);
+		glCallList(regular);
 	}
 }
 
 // Construct a list for GLProgram mode, either with or without vertex colour
-GLuint RenderablePicoSurface::compileProgramList(bool includeColour)
+GLuint RenderablePicoSurface::compileProgramList(const Indices& indices, bool includeColour)
 {
     GLuint list = glGenLists(1);
 	assert(list != 0); // check if we run out of display lists
     glNewList(list, GL_COMPILE);
 
 	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
+	for (Indices::const_iterator i = indices.begin();
+		 i != indices.end();
 		 ++i)
 	{
 		// Get the vertex for this index
@@ -244,21 +298,16 @@ GLuint RenderablePicoSurface::compileProgramList(bool includeColour)
     return list;
 }
 
-// Construct the two display lists
-void RenderablePicoSurface::createDisplayLists()
+// Construct the list for flat-shaded (unlit) mode
+GLuint RenderablePicoSurface::compileRegularList(const Indices& indices)
 {
-	// Generate the lists for lighting mode
-    _dlProgramNoVCol = compileProgramList(false);
-    _dlProgramVcol = compileProgramList(true);
-
-	// Generate the list for flat-shaded (unlit) mode
-	_dlRegular = glGenLists(1);
-	assert(_dlRegular != 0); // check if we run out of display lists
-	glNewList(_dlRegular, GL_COMPILE);
+	GLuint list = glGenLists(1);
+	assert(list != 0); // check if we run out of display lists
+	glNewList(list, GL_COMPILE);
 
 	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
+	for (Indices::const_iterator i = indices.begin();
+		 i != indices.end();
 		 ++i)
 	{
 		// Get the vertex for this index
@@ -272,6 +321,51 @@ void RenderablePicoSurface::createDisplayLists()
 	glEnd();
 
 	glEndList();
+
+	return list;
+}
+
+// Construct the display lists
+void RenderablePicoSurface::createDisplayLists()
+{
+	// Generate the lists for lighting mode
+    _dlProgramNoVCol = compileProgramList(_indices, false);
+    _dlProgramVcol = compileProgramList(_indices, true);
+
+	// Generate the list for flat-shaded (unlit) mode
+	_dlRegular = compileRegularList(_indices);
+}
+
+void RenderablePicoSurface::generateLodLevels()
+{
+	if (_lodLevelsGenerated) return;
+
+	_lodLevelsGenerated = true;
+
+	// The simplified levels are index lists into the same vertices
+	std::vector<Vector3> positions(_vertices.size());
+
+	for (std::size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = _vertices[i].vertex;
+	}
+
+	std::vector<Indices> lodIndices;
+
+	render::MeshSimplifier::generateLevels(positions,
+		_indices.empty() ? NULL : &_indices.front(),
+		_indices.size(), MIN_LOD_TRIANGLES, lodIndices);
+
+	for (std::size_t i = 0; i < lodIndices.size(); ++i)
+	{
+		LodLevelPtr level(new LodLevel);
+
+		level->dlProgramNoVCol = compileProgramList(lodIndices[i], false);
+		level->dlProgramVcol = compileProgramList(lodIndices[i], true);
+		level->dlRegular = compileRegularList(lodIndices[i]);
+
+		_lodLevels.push_back(level);
+	}
 }
 
 // Perform selection test for this surface
@@ -19,6 +19,23 @@ class Ray;
 namespace model
 {
 
+/**
+ * The geometry of a picomodel surface as needed for rendering, including the
+ * tangent frames. It doesn't depend on any other module, so it can be
+ * extracted on a worker thread and read from or written to the model cache.
+ */
+struct PicoSurfaceGeometry
+{
+	// The material name, the fallback is used if the material doesn't exist
+	std::string shaderName;
+	std::string fallbackShaderName;
+
+	std::vector<ArbitraryMeshVertex> vertices;
+	std::vector<unsigned int> indices;
+
+	AABB localAABB;
+};
+
 /* Renderable class containing a series of polygons textured with the same
  * material. RenderablePicoSurface objects are composited into a RenderablePicoModel
  * object to create a renderable static mesh.
@@ -53,26 +70,59 @@ class RenderablePicoSurface :
 	GLuint _dlProgramVcol;
     GLuint _dlProgramNoVCol;
 
+	// A simplified level of detail of this surface, submitted in place of
+	// the surface when the model appears small in the camera view
+	class LodLevel :
+		public OpenGLRenderable
+	{
+	public:
+		GLuint dlRegular;
+		GLuint dlProgramVcol;
+		GLuint dlProgramNoVCol;
+
+		void render(const RenderInfo& info) const
+		{
+			RenderablePicoSurface::callDisplayList(info, dlRegular, dlProgramVcol, dlProgramNoVCol);
+		}
+	};
+	typedef boost::shared_ptr<LodLevel> LodLevelPtr;
+
+	// The simplified levels, the submitted renderables need stable addresses
+	std::vector<LodLevelPtr> _lodLevels;
+	bool _lodLevelsGenerated;
+
 private:
 
 	// Get a colour vector from an unsigned char array (may be NULL)
-	Vector3 getColourVector(unsigned char* array);
+	static Vector3 getColourVector(unsigned char* array);
 
 	// Calculate tangent and bitangent vectors for all vertices.
-	void calculateTangents();
+	static void calculateTangents(PicoSurfaceGeometry& geometry);
 
 	// Create the display lists
-    GLuint compileProgramList(bool includeColour);
+    GLuint compileProgramList(const Indices& indices, bool includeColour);
+	GLuint compileRegularList(const Indices& indices);
 	void createDisplayLists();
 
-	std::string cleanupShaderName(const std::string& mapName);
+	// Invokes the display list matching the render flags
+	static void callDisplayList(const RenderInfo& info, GLuint regular,
+								GLuint programVcol, GLuint programNoVCol);
+
+	static std::string cleanupShaderName(const std::string& mapName);
 
 public:
 	/**
-	 * Constructor. Accepts a picoSurface_t struct and the file extension to determine
-	 * how to assign materials.
+	 * Constructor. Takes over the vertices and indices of the given geometry,
+	 * which is left empty. Needs to be called on the main thread.
+	 */
+	RenderablePicoSurface(PicoSurfaceGeometry& geometry);
+
+	/**
+	 * Converts a picoSurface_t struct into the given geometry, using the file
+	 * extension to determine how to assign materials.
 	 */
-	RenderablePicoSurface(picoSurface_t* surf, const std::string& fExt);
+	static void extractGeometry(picoSurface_t* surf, const std::string& fExt,
+								PicoSurfaceGeometry& geometry);
 
 	/**
 	 * Destructor.
@@ -93,9 +143,19 @@ public:
 	 *
 	 * @param entity
 	 * The entity this object is attached to.
+	 *
+	 * @param lodLevel
+	 * The level of detail to submit, 0 is the full detail surface. Levels
+	 * beyond the ones available submit the coarsest one.
 	 */
 	void submitRenderables(RenderableCollector& rend, const Matrix4& localToWorld,
-						   const ShaderPtr& shader, const IRenderEntity& entity);
+						   const ShaderPtr& shader, const IRenderEntity& entity,
+						   std::size_t lodLevel = 0);
+
+	// Generates the simplified levels and their display lists, if not done yet.
+	// This is deferred until the surface is about to be drawn simplified, so
+	// models never seen from a distance (or with LOD disabled) don't pay for it.
+	void generateLodLevels();
 
 	void setRenderSystem(const RenderSystemPtr& renderSystem);
 
@@ -84,6 +84,9 @@ extern "C" void DARKRADIANT_DLLEXPORT RegisterModule(IModuleRegistry& registry)
 
 	const picoModule_t** modules = PicoModuleList( 0 );
 
+	// All loaders share the same cache folder
+	model::PicoModelDiskCachePtr diskCache(new model::PicoModelDiskCache);
+
 	while (*modules != 0) {
 		const picoModule_t* module = *modules++;
 
@@ -94,7 +97,7 @@ extern "C" void DARKRADIANT_DLLEXPORT RegisterModule(IModuleRegistry& registry)
 				boost::algorithm::to_upper(extension);
 
 				registry.registerModule(
-					model::PicoModelLoaderPtr(new model::PicoModelLoader(module, extension))
+					model::PicoModelLoaderPtr(new model::PicoModelLoader(module, extension, diskCache))
 				);
 			}
 		}
@@ -0,0 +1,204 @@
+#include "ParticleEvaluationCache.h"
+
+#include <boost/functional/hash.hpp>
+
+namespace particles
+{
+
+namespace
+{
+	// Enough for a few thousand bunches of typical size
+	const std::size_t MAX_CACHE_SIZE = 32 * 1024 * 1024;
+
+	// Number of keys remembered for admission, the set is restarted when full
+	const std::size_t MAX_MISSED_KEYS = 65536;
+}
+
+std::size_t ParticleEvaluation::getMemorySize() const
+{
+	std::size_t floats = timeSecs.capacity() + angle.capacity() + size.capacity() + aspect.capacity();
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		floats += origin[i].capacity() + trail[i].capacity();
+	}
+
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		floats += colour[i].capacity();
+	}
+
+	return sizeof(ParticleEvaluation) + floats * sizeof(float);
+}
+
+bool ParticleEvaluationCache::Key::operator==(const Key& other) const
+{
+	return stage == other.stage && seed == other.seed && time == other.time &&
+		direction == other.direction && entityColour == other.entityColour;
+}
+
+std::size_t ParticleEvaluationCache::KeyHash::operator()(const Key& key) const
+{
+	std::size_t hash = 0;
+
+	boost::hash_combine(hash, key.stage);
+	boost::hash_combine(hash, key.seed);
+	boost::hash_combine(hash, key.time);
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		boost::hash_combine(hash, key.direction[i]);
+		boost::hash_combine(hash, key.entityColour[i]);
+	}
+
+	return hash;
+}
+
+ParticleEvaluationCache::ParticleEvaluationCache(std::size_t maxMemorySize) :
+	_memorySize(0),
+	_maxMemorySize(maxMemorySize),
+	_numLookups(0),
+	_numHits(0)
+{}
+
+ParticleEvaluationPtr ParticleEvaluationCache::find(const Key& key)
+{
+	Glib::Mutex::Lock lock(_lock);
+
+	checkSnapshot(*key.stage);
+
+	++_numLookups;
+
+	EntryMap::iterator found = _entries.find(key);
+
+	if (found == _entries.end())
+	{
+		return ParticleEvaluationPtr();
+	}
+
+	++_numHits;
+
+	// Move the entry to the front of the LRU list
+	_lru.splice(_lru.begin(), _lru, found->second.lruPosition);
+
+	return found->second.evaluation;
+}
+
+void ParticleEvaluationCache::insert(const Key& key, const ParticleEvaluationPtr& evaluation)
+{
+	Glib::Mutex::Lock lock(_lock);
+
+	checkSnapshot(*key.stage);
+
+	if (_entries.find(key) != _entries.end())
+	{
+		return; // another thread has been faster
+	}
+
+	// Only store keys which have been asked for before
+	std::size_t hash = KeyHash()(key);
+
+	if (_missedKeys.erase(hash) == 0)
+	{
+		if (_missedKeys.size() >= MAX_MISSED_KEYS)
+		{
+			_missedKeys.clear();
+		}
+
+		_missedKeys.insert(hash);
+		return;
+	}
+
+	std::size_t memorySize = evaluation->getMemorySize();
+
+	// Evict the least recently used entries
+	while (!_lru.empty() && _memorySize + memorySize > _maxMemorySize)
+	{
+		removeEntry(_entries.find(_lru.back()));
+	}
+
+	_lru.push_front(key);
+
+	Entry entry = { evaluation, memorySize, _lru.begin() };
+	_entries.insert(EntryMap::value_type(key, entry));
+
+	_memorySize += memorySize;
+}
+
+void ParticleEvaluationCache::clear()
+{
+	Glib::Mutex::Lock lock(_lock);
+
+	_entries.clear();
+	_lru.clear();
+	_snapshots.clear();
+	_missedKeys.clear();
+	_memorySize = 0;
+}
+
+void ParticleEvaluationCache::resetCounters()
+{
+	Glib::Mutex::Lock lock(_lock);
+
+	_numLookups = 0;
+	_numHits = 0;
+}
+
+ParticleCacheStats ParticleEvaluationCache::getStats() const
+{
+	Glib::Mutex::Lock lock(_lock);
+
+	ParticleCacheStats stats;
+
+	stats.numLookups = _numLookups;
+	stats.numHits = _numHits;
+	stats.numEntries = _entries.size();
+	stats.memoryBytes = _memorySize;
+
+	return stats;
+}
+
+void ParticleEvaluationCache::checkSnapshot(const IStageDef& stage)
+{
+	StageSnapshots::iterator snapshot = _snapshots.find(&stage);
+
+	if (snapshot != _snapshots.end() && *snapshot->second == stage)
+	{
+		return; // unchanged
+	}
+
+	// Unknown or changed, discard the entries of this stage
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); )
+	{
+		if (i->first.stage == &stage)
+		{
+			removeEntry(i++);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	if (snapshot == _snapshots.end())
+	{
+		snapshot = _snapshots.insert(StageSnapshots::value_type(&stage, StageDefPtr(new StageDef))).first;
+	}
+
+	snapshot->second->copyFrom(stage);
+}
+
+void ParticleEvaluationCache::removeEntry(EntryMap::iterator entry)
+{
+	_memorySize -= entry->second.memorySize;
+	_lru.erase(entry->second.lruPosition);
+	_entries.erase(entry);
+}
+
+ParticleEvaluationCache& ParticleEvaluationCache::Instance()
+{
+	static ParticleEvaluationCache _instance(MAX_CACHE_SIZE);
+	return _instance;
+}
+
+} // namespace
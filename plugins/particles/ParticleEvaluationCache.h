@@ -0,0 +1,147 @@
+#pragma once
+
+#include "iparticles.h"
+#include "iparticlestage.h"
+#include "math/Vector3.h"
+
+#include "StageDef.h"
+
+#include <map>
+#include <list>
+#include <vector>
+#include <glibmm/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+namespace particles
+{
+
+/**
+ * The state of all living particles of one bunch at a given time, in
+ * emitter space and independent of the view. Everything which depends on
+ * the viewer (the quad orientation) is applied by each bunch on its own.
+ */
+struct ParticleEvaluation
+{
+	std::vector<float> timeSecs;	// particle time in seconds
+	std::vector<float> angle;		// quad angle in degrees, rotation included
+	std::vector<float> size;
+	std::vector<float> aspect;
+	std::vector<float> origin[3];
+	std::vector<float> colour[4];
+
+	// Aimed orientation only: the origins of the trail quads, trailLength per particle
+	std::size_t trailLength;
+	std::vector<float> trail[3];
+
+	ParticleEvaluation() :
+		trailLength(0)
+	{}
+
+	std::size_t getNumParticles() const
+	{
+		return timeSecs.size();
+	}
+
+	// The number of bytes occupied by the arrays
+	std::size_t getMemorySize() const;
+};
+typedef boost::shared_ptr<const ParticleEvaluation> ParticleEvaluationPtr;
+
+/**
+ * Shared cache of evaluated particle bunches. Evaluation is deterministic
+ * for a given stage, seed, cycle time and emitter setup, so all instances
+ * of a particle def showing the same cycle reuse a single evaluation. The
+ * cache is bounded in size, the least recently used entries are dropped.
+ *
+ * An evaluation is only stored when its key is requested for the second
+ * time, such that emitters which never share their bunches (e.g. all
+ * instances using their own seeds) don't pay for storing them.
+ *
+ * Stages are compared against a snapshot of their settings on each lookup,
+ * entries belonging to a stage which has been changed since are discarded.
+ *
+ * Lookups are thread-safe, evaluations are calculated outside the lock.
+ */
+class ParticleEvaluationCache
+{
+public:
+	struct Key
+	{
+		const IStageDef* stage;
+		int seed;				// the bunch seed, derived from the cycle index
+		std::size_t time;		// the quantised cycle time in msecs
+		Vector3 direction;
+		Vector3 entityColour;	// only set for stages using the entity colour
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+private:
+	typedef std::list<Key> LruList;
+
+	struct Entry
+	{
+		ParticleEvaluationPtr evaluation;
+		std::size_t memorySize;
+		LruList::iterator lruPosition;
+	};
+
+	typedef boost::unordered_map<Key, Entry, KeyHash> EntryMap;
+	EntryMap _entries;
+
+	// Most recently used entries first
+	LruList _lru;
+
+	// The settings of each stage at the time its entries have been created
+	typedef std::map<const IStageDef*, StageDefPtr> StageSnapshots;
+	StageSnapshots _snapshots;
+
+	// The hashes of the keys which have been inserted once without being stored
+	typedef boost::unordered_set<std::size_t> KeyHashSet;
+	KeyHashSet _missedKeys;
+
+	std::size_t _memorySize;
+	std::size_t _maxMemorySize;
+
+	std::size_t _numLookups;
+	std::size_t _numHits;
+
+	mutable Glib::Mutex _lock;
+
+public:
+	ParticleEvaluationCache(std::size_t maxMemorySize);
+
+	// Returns the evaluation stored for the given key, or an empty pointer
+	ParticleEvaluationPtr find(const Key& key);
+
+	/**
+	 * Stores a new evaluation, dropping the least recently used ones if
+	 * necessary. Nothing is stored the first time a key is inserted.
+	 */
+	void insert(const Key& key, const ParticleEvaluationPtr& evaluation);
+
+	// Removes all entries
+	void clear();
+
+	// Resets the lookup counters, called before each simulation run
+	void resetCounters();
+
+	ParticleCacheStats getStats() const;
+
+	static ParticleEvaluationCache& Instance();
+
+private:
+	// Drops the entries of the given stage if its settings have been changed, called with _lock held
+	void checkSnapshot(const IStageDef& stage);
+
+	void removeEntry(EntryMap::iterator entry);
+};
+
+} // namespace
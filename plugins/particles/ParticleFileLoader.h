@@ -6,6 +6,8 @@
 #include "ifilesystem.h"
 #include "iarchive.h"
 #include "parser/ParseException.h"
+#include "parser/ParallelDeclLoader.h"
+#include "debugging/ScopedDebugTimer.h"
 
 #include <iostream>
 
@@ -13,7 +15,9 @@ namespace particles
 {
 
 /**
- * Loader class for PRT files.
+ * Loader class for PRT files. The visited files are tokenised on several
+ * threads by parseFiles(), which passes the tokens to the ParticlesManager
+ * in the order the files were visited.
  */
 class ParticleFileLoader :
 	public VirtualFileSystem::Visitor
@@ -21,35 +25,56 @@ class ParticleFileLoader :
 	// ParticlesManager to populate
 	ParticlesManager& _manager;
 
+	typedef parser::TokenListTokeniser::Tokens Tokens;
+	parser::ParallelDeclLoader<Tokens> _loader;
+
 public:
 	/**
 	 * Constructor. Set the ParticlesManager to populate.
 	 */
 	ParticleFileLoader(ParticlesManager& m)
-	: _manager(m)
+	: _manager(m),
+	  _loader(PARTICLES_DIR, &parser::tokeniseDefs)
 	{ }
 
-	// Functor operator
+	// Functor operator, collects the file names
 	void visit(const std::string& filename)
 	{
-		// Attempt to open the file in text mode
-		ArchiveTextFilePtr file =
-			GlobalFileSystem().openTextFile(PARTICLES_DIR + filename);
+		_loader.visit(filename);
+	}
+
+	// Reads the visited files and parses their particle defs
+	void parseFiles()
+	{
+		{
+			ScopedDebugTimer timer("Particle definitions tokenised: ");
+			_loader.run();
+		}
+
+		ScopedDebugTimer timer("Particle definitions parsed: ");
+
+		parser::ParallelDeclLoader<Tokens>::Files& files = _loader.getFiles();
+
+		for (std::size_t i = 0; i < files.size(); ++i)
+		{
+			const std::string& filename = files[i].name;
+
+			if (!files[i].opened)
+			{
+				std::cerr << "[particles] Unable to open " << filename << std::endl;
+				continue;
+			}
 
-		if (file != NULL) {
 			// File is open, so parse the tokens
 			try {
-				std::istream is(&(file->getInputStream()));
-				_manager.parseStream(is, filename);
+				parser::TokenListTokeniser tok(files[i].result, files[i].error);
+				_manager.parseTokens(tok, filename);
 			}
 			catch (parser::ParseException& e) {
 				std::cerr << "[particles] Failed to parse " << filename
 						  << ": " << e.what() << std::endl;
 			}
 		}
-		else {
-			std::cerr << "[particles] Unable to open " << filename << std::endl;
-		}
 	}
 };
 
@@ -57,24 +57,6 @@ struct ParticleRenderInfo
 		t0(0),
 		tWidth(1)
 	{}
-
-	// Construct a particle with the given index, and fill in the random variables
-	ParticleRenderInfo(std::size_t index_, boost::rand48& random) :
-		index(index_),
-		angle(0),
-		sWidth(1),
-		t0(0),
-		tWidth(1)
-	{
-		boost::rand48::result_type maxVal = GET_BOOST_RAND48_MAX(random);
-
-		// Generate five random numbers for path calcs, this is needed in calculateOrigin
-		rand[0] = static_cast<float>(random()) / maxVal;
-		rand[1] = static_cast<float>(random()) / maxVal;
-		rand[2] = static_cast<float>(random()) / maxVal;
-		rand[3] = static_cast<float>(random()) / maxVal;
-		rand[4] = static_cast<float>(random()) / maxVal;
-	}
 };
 
 } // namespace
@@ -0,0 +1,102 @@
+#include "ParticleSimulator.h"
+
+#include <boost/bind.hpp>
+
+namespace particles
+{
+
+namespace
+{
+	// Below this number of particles the thread synchronisation costs more than it saves
+	const std::size_t MIN_PARALLEL_PARTICLES = 2048;
+
+	// The number of particles to hand to a worker at once
+	const std::size_t PARTICLES_PER_JOB = 512;
+}
+
+ParticleSimulator::ParticleSimulator() :
+	_pool(WorkerPool::getNumHardwareThreads())
+{}
+
+void ParticleSimulator::schedule(const RenderableParticleBunchPtr& bunch)
+{
+	_pending.push_back(bunch);
+}
+
+void ParticleSimulator::flush()
+{
+	if (_pending.empty()) return;
+
+	// The render statistics show the cache hits of the last run
+	ParticleEvaluationCache::Instance().resetCounters();
+
+	// Collect the bunches which are still alive and not simulated on demand meanwhile
+	std::size_t numParticles = 0;
+
+	for (BunchList::const_iterator i = _pending.begin(); i != _pending.end(); ++i)
+	{
+		RenderableParticleBunchPtr bunch = i->lock();
+
+		if (bunch && bunch->needsSimulation())
+		{
+			_bunches.push_back(bunch);
+			numParticles += bunch->getNumParticles();
+		}
+	}
+
+	_pending.clear();
+
+	// A single core only pays for the job handling
+	if (numParticles < MIN_PARALLEL_PARTICLES || _pool.getNumThreads() == 1)
+	{
+		for (std::size_t i = 0; i < _bunches.size(); ++i)
+		{
+			_bunches[i]->simulate();
+		}
+	}
+	else
+	{
+		// Split the bunches into jobs of roughly the same number of particles
+		_jobStart.push_back(0);
+
+		std::size_t jobParticles = 0;
+
+		for (std::size_t i = 0; i < _bunches.size(); ++i)
+		{
+			jobParticles += _bunches[i]->getNumParticles();
+
+			if (jobParticles >= PARTICLES_PER_JOB)
+			{
+				_jobStart.push_back(i + 1);
+				jobParticles = 0;
+			}
+		}
+
+		if (_jobStart.back() != _bunches.size())
+		{
+			_jobStart.push_back(_bunches.size());
+		}
+
+		_pool.run(_jobStart.size() - 1, boost::bind(&ParticleSimulator::simulateJob, this, _1));
+
+		_jobStart.clear();
+	}
+
+	_bunches.clear();
+}
+
+void ParticleSimulator::simulateJob(std::size_t job)
+{
+	for (std::size_t i = _jobStart[job]; i < _jobStart[job + 1]; ++i)
+	{
+		_bunches[i]->simulate();
+	}
+}
+
+ParticleSimulator& ParticleSimulator::Instance()
+{
+	static ParticleSimulator _instance;
+	return _instance;
+}
+
+} // namespace
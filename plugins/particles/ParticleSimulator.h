@@ -0,0 +1,49 @@
+#pragma once
+
+#include "RenderableParticleBunch.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+namespace particles
+{
+
+/**
+ * Collects the particle bunches which need new geometry and simulates them
+ * all at once, spread across a WorkerPool. Bunches are scheduled during the
+ * front-end pass of all particle nodes and flushed before the first of them
+ * is drawn, such that the particles of all emitters and the particle editor
+ * preview are calculated in parallel.
+ *
+ * Only to be used from the main thread.
+ */
+class ParticleSimulator
+{
+	// The bunches waiting for their simulation
+	typedef std::vector<RenderableParticleBunchWeakPtr> BunchList;
+	BunchList _pending;
+
+	WorkerPool _pool;
+
+	// The bunches of the current flush, referenced by the jobs
+	std::vector<RenderableParticleBunchPtr> _bunches;
+
+	// The first bunch of each job, plus the end of the last one
+	std::vector<std::size_t> _jobStart;
+
+public:
+	ParticleSimulator();
+
+	// Adds the given bunch to the next simulation run
+	void schedule(const RenderableParticleBunchPtr& bunch);
+
+	// Simulates all scheduled bunches which still need it, returns when done
+	void flush();
+
+	static ParticleSimulator& Instance();
+
+private:
+	void simulateJob(std::size_t job);
+};
+
+} // namespace
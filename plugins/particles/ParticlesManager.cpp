@@ -5,6 +5,7 @@
 #include "StageDef.h"
 #include "ParticleNode.h"
 #include "RenderableParticle.h"
+#include "ParticleEvaluationCache.h"
 
 #include "icommandsystem.h"
 #include "ieventmanager.h"
@@ -16,8 +17,6 @@
 #include "math/Vector4.h"
 #include "os/fs.h"
 
-#include "debugging/ScopedDebugTimer.h"
-
 #include <fstream>
 #include <iostream>
 #include <boost/version.hpp>
@@ -128,12 +127,9 @@ void ParticlesManager::removeParticleDef(const std::string& name)
 	}
 }
 
-// Parse particle defs from string
-void ParticlesManager::parseStream(std::istream& contents, const std::string& filename)
+// Parse particle defs from the tokens of a file
+void ParticlesManager::parseTokens(parser::DefTokeniser& tok, const std::string& filename)
 {
-	// Usual ritual, get a parser::DefTokeniser and start tokenising the DEFs
-	parser::BasicDefTokeniser<std::istream> tok(contents);
-
 	while (tok.hasMoreTokens())
 	{
 		parseParticleDef(tok, filename);
@@ -219,13 +215,22 @@ void ParticlesManager::reloadParticleDefs()
 	// Use a ParticleFileLoader to load each file
 	ParticleFileLoader loader(*this);
 
-	ScopedDebugTimer timer("Particle definitions parsed: ");
 	GlobalFileSystem().forEachFile(PARTICLES_DIR, PARTICLES_EXT, loader, 1);
+	loader.parseFiles();
+
+	// The cached particles of changed stages would be dropped on their next
+	// lookup anyway, free the memory right away
+	ParticleEvaluationCache::Instance().clear();
 
 	// Notify observers about this event
     _particlesReloadedSignal.emit();
 }
 
+ParticleCacheStats ParticlesManager::getCacheStats() const
+{
+	return ParticleEvaluationCache::Instance().getStats();
+}
+
 void ParticlesManager::saveParticleDef(const std::string& particleName)
 {
 	ParticleDefMap::const_iterator found = _particleDefs.find(particleName);
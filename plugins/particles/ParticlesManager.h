@@ -43,6 +43,7 @@ public:
 
 	IRenderableParticlePtr getRenderableParticle(const std::string& name);
 	void reloadParticleDefs();
+	ParticleCacheStats getCacheStats() const;
 
 	/**
 	 * Writes the named particle declaration to the file it is associated with, 
@@ -62,10 +63,10 @@ public:
 	void saveParticleDef(const std::string& particle);
 
 	/**
-	 * Accept a stream containing particle definitions to parse and add to the
-	 * list.
+	 * Accept the tokens of a file containing particle definitions to parse
+	 * and add to the list.
 	 */
-	void parseStream(std::istream& s, const std::string& filename);
+	void parseTokens(parser::DefTokeniser& tok, const std::string& filename);
 
 	// RegisterableModule implementation
 	const std::string& getName() const;
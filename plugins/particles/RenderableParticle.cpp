@@ -1,10 +1,17 @@
 #include "RenderableParticle.h"
 
+#include "registry/registry.h"
 #include <boost/foreach.hpp>
 
 namespace particles
 {
 
+namespace
+{
+	// The seed used to generate the stage seeds if instances share them
+	const boost::rand48::result_type PARTICLE_SEED = 1;
+}
+
 RenderableParticle::RenderableParticle(const IParticleDefPtr& particleDef) :
 	_particleDef(), // don't initialise the ptr yet
 	_random(rand()), // use a random seed
@@ -176,6 +183,15 @@ void RenderableParticle::setupStages()
 
 	if (_particleDef == NULL) return; // nothing to do.
 
+	// If enabled, all instances of a particle def get the same stage seeds, such
+	// that they can share their particles through the ParticleEvaluationCache
+	bool shareSeeds = registry::getValue<bool>(RKEY_PARTICLES_SHARE_SEEDS);
+
+	if (shareSeeds)
+	{
+		_random.seed(PARTICLE_SEED);
+	}
+
 	for (std::size_t i = 0; i < _particleDef->getNumStages(); ++i)
 	{
 		const IStageDef& stage = _particleDef->getStage(i);
@@ -188,7 +204,7 @@ void RenderableParticle::setupStages()
 		}
 
 		// Create a new renderable stage and add it to the shader
-		RenderableParticleStagePtr renderableStage(new RenderableParticleStage(stage, _random, _direction, _entityColour));
+		RenderableParticleStagePtr renderableStage(new RenderableParticleStage(stage, _random, _direction, _entityColour, shareSeeds));
 		_shaderMap[materialName].stages.push_back(renderableStage);
 	}
 }
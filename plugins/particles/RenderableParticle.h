@@ -40,6 +40,8 @@ class RenderableParticle : public IRenderableParticle,
 	// The random number generator, this is used to generate "constant"
 	// starting values for each bunch of particles. This enables us
 	// to go back in time when rendering the particle stage.
+	// It is reset to PARTICLE_SEED when the stages are set up and the
+	// instances of a def share their seeds.
 	boost::rand48 _random;
 
 	// The particle direction, usually set by the emitter entity or the preview
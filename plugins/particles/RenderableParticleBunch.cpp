@@ -1,51 +1,281 @@
 #include "RenderableParticleBunch.h"
+#include "ParticleSimulator.h"
 
 #include "itextstream.h"
 #include "math/pi.h"
 
 #include "string/string.h"
 
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace particles
 {
 
+namespace
+{
+    // Particle times are quantised to this, one frame at 60 fps
+    const std::size_t SIMULATION_STEP_MSECS = 16;
+
+    // Writes the four corners of a quad centred at the given point, 3 floats per corner.
+    // The corners are rotated by the angle within the plane spanned by axisX and axisY.
+    inline void writeQuadVertices(float* vertex, const float* centre, const float* axisX, const float* axisY,
+                                  float halfWidth, float halfHeight, float cosPhi, float sinPhi)
+    {
+#if defined(PARTICLES_SSE2)
+        // One lane per corner
+        const __m128 signX = _mm_setr_ps(-1, 1, 1, -1);
+        const __m128 signY = _mm_setr_ps(1, 1, -1, -1);
+
+        __m128 cornerX = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(halfWidth * cosPhi), signX),
+                                    _mm_mul_ps(_mm_set1_ps(halfHeight * sinPhi), signY));
+        __m128 cornerY = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(halfHeight * cosPhi), signY),
+                                    _mm_mul_ps(_mm_set1_ps(halfWidth * sinPhi), signX));
+
+        __m128 x = _mm_add_ps(_mm_set1_ps(centre[0]), _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(axisX[0]), cornerX), _mm_mul_ps(_mm_set1_ps(axisY[0]), cornerY)));
+        __m128 y = _mm_add_ps(_mm_set1_ps(centre[1]), _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(axisX[1]), cornerX), _mm_mul_ps(_mm_set1_ps(axisY[1]), cornerY)));
+        __m128 z = _mm_add_ps(_mm_set1_ps(centre[2]), _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(axisX[2]), cornerX), _mm_mul_ps(_mm_set1_ps(axisY[2]), cornerY)));
+
+        // Interleave to x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+        __m128 xy01 = _mm_unpacklo_ps(x, y);
+        __m128 xy23 = _mm_unpackhi_ps(x, y);
+
+        __m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+        __m128 y1z1 = _mm_shuffle_ps(xy01, z, _MM_SHUFFLE(1, 1, 3, 3));
+        __m128 z23xy3 = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+
+        _mm_storeu_ps(vertex, _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(vertex + 4, _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(vertex + 8, _mm_shuffle_ps(z23xy3, z23xy3, _MM_SHUFFLE(1, 3, 2, 0)));
+#else
+        const float cornerX[4] = {
+            -halfWidth * cosPhi + halfHeight * sinPhi,
+            +halfWidth * cosPhi + halfHeight * sinPhi,
+            +halfWidth * cosPhi - halfHeight * sinPhi,
+            -halfWidth * cosPhi - halfHeight * sinPhi
+        };
+
+        const float cornerY[4] = {
+            +halfHeight * cosPhi + halfWidth * sinPhi,
+            +halfHeight * cosPhi - halfWidth * sinPhi,
+            -halfHeight * cosPhi - halfWidth * sinPhi,
+            -halfHeight * cosPhi + halfWidth * sinPhi
+        };
+
+        for (std::size_t i = 0; i < 4; ++i, vertex += 3)
+        {
+            vertex[0] = centre[0] + axisX[0] * cornerX[i] + axisY[0] * cornerY[i];
+            vertex[1] = centre[1] + axisX[1] * cornerX[i] + axisY[1] * cornerY[i];
+            vertex[2] = centre[2] + axisX[2] * cornerX[i] + axisY[2] * cornerY[i];
+        }
+#endif
+    }
+
+    // Writes the attributes shared by the four corners of a quad and advances the pointers
+    inline void writeQuadAttributes(float*& texcoord, float*& normal, float*& colour,
+                                    const float* quadNormal, const float* quadColour, float s0, float sWidth)
+    {
+        const float texcoords[8] = {
+            s0, 0, s0 + sWidth, 0, s0 + sWidth, 1, s0, 1
+        };
+
+        std::copy(texcoords, texcoords + 8, texcoord);
+        texcoord += 8;
+
+        for (std::size_t i = 0; i < 4; ++i, normal += 3, colour += 4)
+        {
+            std::copy(quadNormal, quadNormal + 3, normal);
+            std::copy(quadColour, quadColour + 4, colour);
+        }
+    }
+}
+
+void RenderableParticleBunch::Particles::clear()
+{
+    index.clear();
+    timeSecs.clear();
+    timeFraction.clear();
+    angle.clear();
+
+    for (std::size_t i = 0; i < 5; ++i)
+    {
+        rand[i].clear();
+    }
+
+}
+
 RenderableParticleBunch::RenderableParticleBunch(std::size_t index,
     int randSeed, const IStageDef& stage, const Matrix4& viewRotation,
-    const Vector3& direction, const Vector3& entityColour) :
+    const Vector3& direction, const Vector3& entityColour, bool shareEvaluation) :
     _index(index),
     _stage(stage),
-    _quads(),
     _randSeed(randSeed),
     _distributeParticlesRandomly(_stage.getRandomDistribution()),
     _offset(_stage.getOffset()),
     _viewRotation(viewRotation),
     _direction(direction),
-    _entityColour(entityColour)
+    _entityColour(entityColour),
+    _shareEvaluation(shareEvaluation),
+    _time(0),
+    _needsSimulation(false),
+    _simulated(false),
+    _simulatedTime(0)
 {
-    // Geometry is written in update(), just reserve the space
+    // Geometry is written in simulate()
+
+    if (_stage.getCustomPathType() == IStageDef::PATH_ORBIT ||
+        _stage.getCustomPathType() == IStageDef::PATH_DRIP)
+    {
+        // These are actually unsupported by the engine ("bad path type")
+        rWarning() << "Unsupported path type (drip/orbit)." << std::endl;
+    }
 }
 
-void RenderableParticleBunch::update(std::size_t time)
+bool RenderableParticleBunch::update(std::size_t time)
 {
-    _bounds = AABB();
-    _quads.clear();
+    _time = getSimulationTime(time);
+
+    if (_needsSimulation)
+    {
+        return false; // already waiting, the simulation will use the new time
+    }
+
+    if (_simulated && _simulatedTime == _time && _simulatedViewRotation == _viewRotation &&
+        _simulatedDirection == _direction && _simulatedEntityColour == _entityColour)
+    {
+        return false; // the result would be the same
+    }
+
+    _needsSimulation = true;
 
+    return true;
+}
+
+std::size_t RenderableParticleBunch::getSimulationTime(std::size_t time) const
+{
     // Length of one cycle (duration + deadtime)
     std::size_t cycleMsec = static_cast<std::size_t>(_stage.getCycleMsec());
 
-    if (cycleMsec == 0)
+    if (cycleMsec == 0 || _stage.getCount() <= 0)
     {
-        return;
+        return 0;
     }
 
-    // Reserve enough space for all the particles (non-animated case)
-    _quads.reserve(_stage.getCount() * 4);
-
     // Normalise the global input time into local cycle time
     // The cycleTime may be larger than the _stage.cycleMsec argument if bunching is turned off
     std::size_t cycleTime = time - cycleMsec * _index;
 
-    // Reset the random number generator using our stored seed
-    _random.seed(_randSeed);
+    // Quantise the time, such that bunches of all emitters share their evaluations
+    if (_shareEvaluation)
+    {
+        cycleTime -= cycleTime % SIMULATION_STEP_MSECS;
+    }
+
+    std::size_t stageDurationMsec = static_cast<std::size_t>(SEC2MS(_stage.getDuration()));
+    float spawnSpacing = _stage.getBunching() * static_cast<float>(stageDurationMsec) / _stage.getCount();
+    std::size_t spawnSpacingMsec = static_cast<std::size_t>(spawnSpacing);
+
+    // All particles have expired after this time, nothing changes anymore
+    std::size_t endTime = (_stage.getCount() - 1) * spawnSpacingMsec + stageDurationMsec + 1;
+
+    return std::min(cycleTime, endTime);
+}
+
+std::size_t RenderableParticleBunch::getNumParticles() const
+{
+    return static_cast<std::size_t>(std::max(_stage.getCount(), 0));
+}
+
+void RenderableParticleBunch::simulate()
+{
+    _needsSimulation = false;
+
+    _simulated = true;
+    _simulatedTime = _time;
+    _simulatedViewRotation = _viewRotation;
+    _simulatedDirection = _direction;
+    _simulatedEntityColour = _entityColour;
+
+    _bounds = AABB();
+
+    _vertices.clear();
+    _texcoords.clear();
+    _normals.clear();
+    _colours.clear();
+
+    if (_stage.getCycleMsec() <= 0 || _stage.getCount() <= 0)
+    {
+        _evaluation.reset();
+        return;
+    }
+
+    if (_shareEvaluation)
+    {
+        // The evaluation only depends on these, the view is applied below
+        ParticleEvaluationCache::Key key = {
+            &_stage, _randSeed, _time, _direction,
+            _stage.getUseEntityColour() ? _entityColour : Vector3(0,0,0)
+        };
+
+        ParticleEvaluationCache& cache = ParticleEvaluationCache::Instance();
+
+        _evaluation = cache.find(key);
+
+        if (!_evaluation)
+        {
+            _evaluation = evaluate();
+            cache.insert(key, _evaluation);
+        }
+    }
+    else
+    {
+        _evaluation = evaluate();
+    }
+
+    const ParticleEvaluation& evaluation = *_evaluation;
+
+    if (evaluation.getNumParticles() == 0)
+    {
+        return;
+    }
+
+    // Reserve enough space for all quads, aimed particles have trails and
+    // animated ones are drawn as two crossfaded quads
+    std::size_t quadsPerParticle = _stage.getAnimationFrames() > 0 ? 2 : 1;
+
+    if (_stage.getOrientationType() == IStageDef::ORIENTATION_AIMED)
+    {
+        quadsPerParticle *= evaluation.trailLength;
+    }
+
+    std::size_t numVertices = evaluation.getNumParticles() * quadsPerParticle * 4;
+
+    _vertices.reserve(numVertices * 3);
+    _texcoords.reserve(numVertices * 2);
+    _normals.reserve(numVertices * 3);
+    _colours.reserve(numVertices * 4);
+
+    // For aimed orientation, we need to override particle height and aspect
+    if (_stage.getOrientationType() == IStageDef::ORIENTATION_AIMED)
+    {
+        pushAimedParticles(evaluation);
+    }
+    else
+    {
+        pushOrientedParticles(evaluation);
+    }
+}
+
+ParticleEvaluationPtr RenderableParticleBunch::evaluate()
+{
+    boost::shared_ptr<ParticleEvaluation> evaluation(new ParticleEvaluation);
 
     // Calculate the time between each particle spawn
     // When bunching is set to 1 the spacing is 0, and vice versa.
@@ -56,118 +286,141 @@ void RenderableParticleBunch::update(std::size_t time)
     // This is the spacing between each particle
     std::size_t spawnSpacingMsec = static_cast<std::size_t>(spawnSpacing);
 
-    // Generate all particle quads, regardless of their visibility
-    // Visibility is considered by not rendering particles that haven't been spawned yet
-    for (std::size_t i = 0; i < static_cast<std::size_t>(_stage.getCount()); ++i)
+    _particles.clear();
+
+    spawnParticles(_time, spawnSpacingMsec, stageDurationMsec);
+
+    if (_particles.size() == 0)
+    {
+        return evaluation;
+    }
+
+    // Check if the main direction is different to the z axis
+    Vector3 dir = _direction.getNormalised();
+    Vector3 z(0,0,1);
+
+    double deviation = dir.angle(z);
+
+    _directionRotation = deviation != 0 ? Matrix4::getRotation(z, dir) : Matrix4::getIdentity();
+
+    // Consider offset as starting point
+    _rotatedOffset = _directionRotation.transformPoint(_offset);
+
+    // Consider gravity
+    // if "world" is set, use -z as gravity direction, otherwise use the reverse emitter direction
+    _gravity = (_stage.getWorldGravityFlag() ? Vector3(0,0,-1) : -_direction.getNormalised()) * _stage.getGravity();
+
+    evaluation->timeSecs = _particles.timeSecs;
+
+    calculateOrigins(*evaluation);
+    calculateColours(*evaluation);
+    calculateQuadParameters(*evaluation);
+
+    if (_stage.getOrientationType() == IStageDef::ORIENTATION_AIMED)
+    {
+        calculateTrails(*evaluation);
+    }
+
+    return evaluation;
+}
+
+void RenderableParticleBunch::spawnParticles(std::size_t cycleTime, std::size_t spawnSpacingMsec,
+                                             std::size_t stageDurationMsec)
+{
+    // Reset the random number generator using our stored seed
+    _random.seed(_randSeed);
+
+    const boost::rand48::result_type maxVal = GET_BOOST_RAND48_MAX(_random);
+    const float initialAngle = _stage.getInitialAngle();
+
+    std::size_t count = static_cast<std::size_t>(_stage.getCount());
+
+    // Particles are spawned one after the other, the ones with a start time
+    // in the future are not visible yet. Each spawned particle changes the RNG
+    // state, expired ones too, which is important for all subsequent particles.
+    for (std::size_t i = 0; i < count && i * spawnSpacingMsec <= cycleTime; ++i)
     {
         // Consider bunching parameter
         std::size_t particleStartTimeMsec = i * spawnSpacingMsec;
 
-        if (cycleTime < particleStartTimeMsec)
-        {
-            // This particle is not visible at the given time
-            continue;
-        }
-
         assert(particleStartTimeMsec < stageDurationMsec);  // some sanity checks
 
         // Get the "local particle time" in msecs
         std::size_t particleTime = cycleTime - particleStartTimeMsec;
 
-        // Generate the particle renderinfo structure (our working set)
-        ParticleRenderInfo particle(i, _random);
-
-        // Calculate the time fraction [0..1]
-        particle.timeFraction = static_cast<float>(particleTime) / stageDurationMsec;
+        // Generate five random numbers for path calcs, this is needed in calculateOrigin
+        float rand[5];
 
-        // We need the particle time in seconds for the location/angle integrations
-        particle.timeSecs = MS2SEC(particleTime);
-
-        // Calculate particle origin at time t
-        calculateOrigin(particle);
+        for (std::size_t r = 0; r < 5; ++r)
+        {
+            rand[r] = static_cast<float>(_random()) / maxVal;
+        }
 
-        // Get the initial angle value
-        particle.angle = _stage.getInitialAngle();
+        float angle = initialAngle;
 
-        if (particle.angle == 0)
+        if (angle == 0)
         {
             // Use random angle
-            particle.angle = 360 * static_cast<float>(_random()) / GET_BOOST_RAND48_MAX(_random);
+            angle = 360 * static_cast<float>(_random()) / maxVal;
         }
 
-        // Past this point, no more "randomness" is required, so let's check if we still need
-        // to render this particular particle. Don't dismiss particles too early, as each of them
-        // will change the RNG state in the calculations above. These state changes are important for
-        // all the subsequent particles.
-
         // Each particle has a lifetime of <stage duration> at maximum
         if (particleTime > stageDurationMsec)
         {
             continue; // particle has expired
         }
 
-        // Calculate the time-dependent angle
-        // according to docs, half the quads have negative rotation speed
-        int rotFactor = i % 2 == 0 ? -1 : 1;
-        particle.angle += rotFactor * integrate(_stage.getRotationSpeed(), particle.timeSecs);
-
-        // Calculate render colour for this particle
-        calculateColour(particle);
-
-        // Consider quad size
-        particle.size = _stage.getSize().evaluate(particle.timeFraction);
+        _particles.index.push_back(i);
 
-        // Consider aspect ratio
-        particle.aspect = _stage.getAspect().evaluate(particle.timeFraction);
+        // Calculate the time fraction [0..1]
+        _particles.timeFraction.push_back(static_cast<float>(particleTime) / stageDurationMsec);
 
-        // Consider animation frames
-        particle.animFrames = static_cast<std::size_t>(_stage.getAnimationFrames());
+        // We need the particle time in seconds for the location/angle integrations
+        _particles.timeSecs.push_back(MS2SEC(particleTime));
 
-        if (particle.animFrames > 0)
-        {
-            // Calculate the s coordinates and the resulting particle colour
-            calculateAnim(particle);
-        }
+        _particles.angle.push_back(angle);
 
-        // For aimed orientation, we need to override particle height and aspect
-        if (_stage.getOrientationType() == IStageDef::ORIENTATION_AIMED)
-        {
-            pushAimedParticles(particle, stageDurationMsec);
-        }
-        else
+        for (std::size_t r = 0; r < 5; ++r)
         {
-            if (particle.animFrames > 0)
-            {
-                // Animated, push two crossfaded quads
-                pushQuad(particle, particle.curColour, particle.sWidth * particle.curFrame, particle.sWidth);
-                pushQuad(particle, particle.nextColour, particle.sWidth * particle.nextFrame, particle.sWidth);
-            }
-            else
-            {
-                // Non-animated quad
-                pushQuad(particle, particle.colour);
-            }
+            _particles.rand[r].push_back(rand[r]);
         }
     }
 }
 
 void RenderableParticleBunch::render(const RenderInfo& info) const
 {
-    if (_quads.empty()) return;
+    if (_needsSimulation)
+    {
+        // The first bunch to be drawn calculates all pending ones in one go
+        ParticleSimulator::Instance().flush();
+    }
+
+    if (_vertices.empty()) return;
 
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
 
-    glVertexPointer(3, GL_DOUBLE, sizeof(ParticleQuad::Vertex), &(_quads.front().verts[0].vertex));
-    glTexCoordPointer(2, GL_DOUBLE, sizeof(ParticleQuad::Vertex), &(_quads.front().verts[0].texcoord));
-    glNormalPointer(GL_DOUBLE, sizeof(ParticleQuad::Vertex), &(_quads.front().verts[0].normal));
-    glColorPointer(4, GL_DOUBLE, sizeof(ParticleQuad::Vertex), &(_quads.front().verts[0].colour));
+    glVertexPointer(3, GL_FLOAT, 0, &_vertices.front());
+    glTexCoordPointer(2, GL_FLOAT, 0, &_texcoords.front());
+    glNormalPointer(GL_FLOAT, 0, &_normals.front());
+    glColorPointer(4, GL_FLOAT, 0, &_colours.front());
 
-    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(_quads.size())*4);
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(_vertices.size() / 3));
 }
 
 const AABB& RenderableParticleBunch::getBounds()
 {
+    if (_needsSimulation)
+    {
+        // Bounds are requested before rendering, calculate the pending ones now
+        ParticleSimulator::Instance().flush();
+
+        if (_needsSimulation)
+        {
+            simulate(); // not scheduled
+        }
+    }
+
     if (!_bounds.isValid())
     {
         calculateBounds();
@@ -241,83 +494,187 @@ void RenderableParticleBunch::calculateAnim(ParticleRenderInfo& particle)
     particle.sWidth = 1.0f / particle.animFrames;
 }
 
-void RenderableParticleBunch::calculateColour(ParticleRenderInfo& particle)
+void RenderableParticleBunch::calculateColours(ParticleEvaluation& evaluation)
 {
-    Vector4 mainColour = !_stage.getUseEntityColour() ? 
+    Vector4 mainColour = !_stage.getUseEntityColour() ?
         _stage.getColour() : Vector4(_entityColour.x(), _entityColour.y(), _entityColour.z(), 1);
 
-    // We start with the stage's standard colour
-    particle.colour = mainColour;
+    const Vector4& fadeColour = _stage.getFadeColour();
 
     // Consider fade index fraction, which can spawn particles already faded to some extent
     float fadeIndexFraction = _stage.getFadeIndexFraction();
+    float startFrac = 1.0f - fadeIndexFraction;
+
+    float fadeInFraction = _stage.getFadeInFraction();
 
-    if (fadeIndexFraction > 0)
+    float fadeOutFraction = _stage.getFadeOutFraction();
+    float fadeOutFractionInverse = 1.0f - fadeOutFraction;
+
+    int count = _stage.getCount();
+
+    for (std::size_t c = 0; c < 4; ++c)
     {
-        // greebo: The linear fading function goes like this:
-        // frac(t) = (startFrac - t) / (startFrac - 1) with t in [0..1]
-        // Boundary conditions: frac(1) = 1 and frac(startFrac) = 0
+        evaluation.colour[c].resize(_particles.size());
+    }
+
+    for (std::size_t p = 0; p < _particles.size(); ++p)
+    {
+        // We start with the stage's standard colour
+        Vector4 colour = mainColour;
+
+        if (fadeIndexFraction > 0)
+        {
+            // greebo: The linear fading function goes like this:
+            // frac(t) = (startFrac - t) / (startFrac - 1) with t in [0..1]
+            // Boundary conditions: frac(1) = 1 and frac(startFrac) = 0
+
+            // Use the particle index as "time", normalised to [0..1]
+            // such that particle with higher index start more faded
+            float pIdx = static_cast<float>(_particles.index[p]) / count;
 
-        // Use the particle index as "time", normalised to [0..1]
-        // such that particle with higher index start more faded
-        float pIdx = static_cast<float>(particle.index) / _stage.getCount();
+            // Calculate how much we should be faded already
+            float frac = (startFrac - pIdx) / (startFrac - 1.0f);
 
-        // Calculate how much we should be faded already
-        float startFrac = 1.0f - fadeIndexFraction;
-        float frac = (startFrac - pIdx) / (startFrac - 1.0f);
+            // Ignore negative fraction values, this also takes care that only
+            // those particles with time >= fadeIndexFraction get faded.
+            if (frac > 0)
+            {
+                colour = lerpColour(colour, fadeColour, frac);
+            }
+        }
+
+        float timeFraction = _particles.timeFraction[p];
+
+        if (fadeInFraction > 0 && timeFraction <= fadeInFraction)
+        {
+            colour = lerpColour(fadeColour, mainColour, timeFraction / fadeInFraction);
+        }
+
+        if (fadeOutFraction > 0 && timeFraction >= fadeOutFractionInverse)
+        {
+            colour = lerpColour(mainColour, fadeColour, (timeFraction - fadeOutFractionInverse) / fadeOutFraction);
+        }
 
-        // Ignore negative fraction values, this also takes care that only
-        // those particles with time >= fadeIndexFraction get faded.
-        if (frac > 0)
+        for (std::size_t c = 0; c < 4; ++c)
         {
-            particle.colour = lerpColour(particle.colour, _stage.getFadeColour(), frac);
+            evaluation.colour[c][p] = static_cast<float>(colour[c]);
         }
     }
+}
 
-    float fadeInFraction = _stage.getFadeInFraction();
+void RenderableParticleBunch::calculateOrigins(ParticleEvaluation& evaluation)
+{
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        evaluation.origin[i].resize(_particles.size());
+    }
 
-    if (fadeInFraction > 0 && particle.timeFraction <= fadeInFraction)
+    for (std::size_t p = 0; p < _particles.size(); ++p)
     {
-        particle.colour = lerpColour(_stage.getFadeColour(), mainColour, particle.timeFraction / fadeInFraction);
+        float rand[5] = {
+            _particles.rand[0][p], _particles.rand[1][p], _particles.rand[2][p],
+            _particles.rand[3][p], _particles.rand[4][p]
+        };
+
+        Vector3 origin = calculateOrigin(rand, _particles.timeSecs[p]);
+
+        evaluation.origin[0][p] = static_cast<float>(origin.x());
+        evaluation.origin[1][p] = static_cast<float>(origin.y());
+        evaluation.origin[2][p] = static_cast<float>(origin.z());
     }
+}
 
-    float fadeOutFraction = _stage.getFadeOutFraction();
-    float fadeOutFractionInverse = 1.0f - fadeOutFraction;
+void RenderableParticleBunch::calculateQuadParameters(ParticleEvaluation& evaluation)
+{
+    const IParticleParameter& size = _stage.getSize();
+    const IParticleParameter& aspect = _stage.getAspect();
+    const IParticleParameter& rotationSpeed = _stage.getRotationSpeed();
+
+    evaluation.angle.resize(_particles.size());
+    evaluation.size.resize(_particles.size());
+    evaluation.aspect.resize(_particles.size());
 
-    if (fadeOutFraction > 0 && particle.timeFraction >= fadeOutFractionInverse)
+    for (std::size_t p = 0; p < _particles.size(); ++p)
     {
-        particle.colour = lerpColour(mainColour, _stage.getFadeColour(), (particle.timeFraction - fadeOutFractionInverse) / fadeOutFraction);
+        // Calculate the time-dependent angle
+        // according to docs, half the quads have negative rotation speed
+        int rotFactor = _particles.index[p] % 2 == 0 ? -1 : 1;
+        evaluation.angle[p] = _particles.angle[p] + rotFactor * integrate(rotationSpeed, _particles.timeSecs[p]);
+
+        // Consider quad size and aspect ratio
+        evaluation.size[p] = size.evaluate(_particles.timeFraction[p]);
+        evaluation.aspect[p] = aspect.evaluate(_particles.timeFraction[p]);
     }
 }
 
-void RenderableParticleBunch::calculateOrigin(ParticleRenderInfo& particle)
+void RenderableParticleBunch::calculateTrails(ParticleEvaluation& evaluation)
 {
-    // Check if the main direction is different to the z axis
-    Vector3 dir = _direction.getNormalised();
-    Vector3 z(0,0,1);
+    int trails = static_cast<int>(_stage.getOrientationParm(0)); // trails
+    float aimedTime = _stage.getOrientationParm(1); // time
 
-    double deviation = dir.angle(z);
+    if (trails < 0)
+    {
+        trails = 0;
+    }
+
+    // The time parameter defaults to 0.5 if not specified
+    if (aimedTime == 0.0f)
+    {
+        aimedTime = 0.5f;
+    }
+
+    // The number of quads drawn per particle
+    evaluation.trailLength = trails + 1;
+
+    // The time delta between quads
+    float timeStep = aimedTime / evaluation.trailLength;
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        evaluation.trail[i].resize(_particles.size() * evaluation.trailLength);
+    }
+
+    for (std::size_t p = 0; p < _particles.size(); ++p)
+    {
+        float rand[5] = {
+            _particles.rand[0][p], _particles.rand[1][p], _particles.rand[2][p],
+            _particles.rand[3][p], _particles.rand[4][p]
+        };
+
+        // Step into the past, the end of each quad is the start of the next one
+        for (std::size_t q = 0; q < evaluation.trailLength; ++q)
+        {
+            Vector3 origin = calculateOrigin(rand, _particles.timeSecs[p] - timeStep * (q + 1));
 
-    Matrix4 rotation = deviation != 0 ? Matrix4::getRotation(z, dir) : Matrix4::getIdentity();
+            std::size_t index = p * evaluation.trailLength + q;
 
+            evaluation.trail[0][index] = static_cast<float>(origin.x());
+            evaluation.trail[1][index] = static_cast<float>(origin.y());
+            evaluation.trail[2][index] = static_cast<float>(origin.z());
+        }
+    }
+}
+
+Vector3 RenderableParticleBunch::calculateOrigin(const float* rand, float timeSecs)
+{
     // Consider offset as starting point
-    particle.origin = rotation.transformPoint(_offset);
+    Vector3 origin = _rotatedOffset;
 
     switch (_stage.getCustomPathType())
     {
     case IStageDef::PATH_STANDARD: // Standard path calculation
         {
             // Consider particle distribution
-            Vector3 distributionOffset = getDistributionOffset(particle, _distributeParticlesRandomly);
+            Vector3 distributionOffset = getDistributionOffset(rand, _distributeParticlesRandomly);
 
             // Add this to the origin
-            particle.origin += distributionOffset;
+            origin += distributionOffset;
 
             // Calculate particle direction, pass distribution offset (this is needed for DIRECTION_OUTWARD)
-            Vector3 particleDirection = getDirection(particle, rotation, distributionOffset);
+            Vector3 particleDirection = getDirection(rand, distributionOffset);
 
             // Consider speed
-            particle.origin += particleDirection * integrate(_stage.getSpeed(), particle.timeSecs);
+            origin += particleDirection * integrate(_stage.getSpeed(), timeSecs);
         }
         break;
 
@@ -333,22 +690,22 @@ void RenderableParticleBunch::calculateOrigin(ParticleRenderInfo& particle)
             float radius = _stage.getCustomPathParm(2);
 
             // Generate starting conditions speed (+/-50%)
-            float rand = 2 * particle.rand[0] - 1.0f;
-            float radialSpeedFactor = 1.0f + 0.5f * rand * rand;
+            float randValue = 2 * rand[0] - 1.0f;
+            float radialSpeedFactor = 1.0f + 0.5f * randValue * randValue;
 
             // greebo: factor 0.4 is empirical, I measured a few D3 particles for their circulation times
             float radialSpeed = _stage.getCustomPathParm(0) * radialSpeedFactor * 0.4f;
 
-            rand = 2 * particle.rand[1] - 1.0f;
-            float axialSpeedFactor = 1.0f + 0.5f * rand * rand;
+            randValue = 2 * rand[1] - 1.0f;
+            float axialSpeedFactor = 1.0f + 0.5f * randValue * randValue;
             float axialSpeed = _stage.getCustomPathParm(1) * axialSpeedFactor * 0.4f;
 
-            float phi0 = 2 * static_cast<float>(c_pi) * particle.rand[2];
-            float theta0 = static_cast<float>(c_pi) * particle.rand[3];
+            float phi0 = 2 * static_cast<float>(c_pi) * rand[2];
+            float theta0 = static_cast<float>(c_pi) * rand[3];
 
             // Calculate angles at the given particleTime
-            float phi = phi0 + axialSpeed * particle.timeSecs;
-            float theta = theta0 + radialSpeed * particle.timeSecs;
+            float phi = phi0 + axialSpeed * timeSecs;
+            float theta = theta0 + radialSpeed * timeSecs;
 
             // Pre-calculate the sin/cos values
             float cosPhi = cos(phi);
@@ -357,7 +714,7 @@ void RenderableParticleBunch::calculateOrigin(ParticleRenderInfo& particle)
             float sinTheta = sin(theta);
 
             // Move the particle origin
-            particle.origin += Vector3(radius * cosTheta * sinPhi, radius * sinTheta * sinPhi, radius * cosPhi);
+            origin += Vector3(radius * cosTheta * sinPhi, radius * sinTheta * sinPhi, radius * cosPhi);
         }
         break;
 
@@ -372,56 +729,49 @@ void RenderableParticleBunch::calculateOrigin(ParticleRenderInfo& particle)
             float sizeY = _stage.getCustomPathParm(1);
             float sizeZ = _stage.getCustomPathParm(2);
 
-            float radialSpeed = _stage.getCustomPathParm(3) * (2 * particle.rand[0] - 1.0f);
-            float axialSpeed = _stage.getCustomPathParm(4) * (2 * particle.rand[1] - 1.0f);
+            float radialSpeed = _stage.getCustomPathParm(3) * (2 * rand[0] - 1.0f);
+            float axialSpeed = _stage.getCustomPathParm(4) * (2 * rand[1] - 1.0f);
 
-            float phi0 = 2 * static_cast<float>(c_pi) * particle.rand[2];
-            float z0 = sizeZ * (2 * particle.rand[3] - 1.0f);
+            float phi0 = 2 * static_cast<float>(c_pi) * rand[2];
+            float z0 = sizeZ * (2 * rand[3] - 1.0f);
 
-            float sinPhi = sin(phi0 + radialSpeed * particle.timeSecs);
-            float cosPhi = cos(phi0 + radialSpeed * particle.timeSecs);
+            float sinPhi = sin(phi0 + radialSpeed * timeSecs);
+            float cosPhi = cos(phi0 + radialSpeed * timeSecs);
 
             float x = sizeX * cosPhi;
             float y = sizeY * sinPhi;
-            float z = z0 + axialSpeed * particle.timeSecs;
+            float z = z0 + axialSpeed * timeSecs;
 
-            particle.origin += Vector3(x, y, z);
+            origin += Vector3(x, y, z);
         }
         break;
 
-    case IStageDef::PATH_ORBIT:
-    case IStageDef::PATH_DRIP:
-        // These are actually unsupported by the engine ("bad path type")
-        rWarning() << "Unsupported path type (drip/orbit)." << std::endl;
-        break;
-
     default:
-        // Nothing
+        // Nothing, orbit and drip are unsupported by the engine
         break;
     };
 
     // Consider gravity
-    // if "world" is set, use -z as gravity direction, otherwise use the reverse emitter direction
-    Vector3 gravity = _stage.getWorldGravityFlag() ? Vector3(0,0,-1) : -_direction.getNormalised();
+    origin += _gravity * timeSecs * timeSecs * 0.5f;
 
-    particle.origin += gravity * _stage.getGravity() * particle.timeSecs * particle.timeSecs * 0.5f;
+    return origin;
 }
 
-Vector3 RenderableParticleBunch::getDirection(ParticleRenderInfo& particle, const Matrix4& rotation, const Vector3& distributionOffset)
+Vector3 RenderableParticleBunch::getDirection(const float* rand, const Vector3& distributionOffset)
 {
     switch (_stage.getDirectionType())
     {
     case IStageDef::DIRECTION_CONE:
         {
             // Find a random vector on the sphere surface defined by the cone with apex 2*angle
-            float u = particle.rand[3];
+            float u = rand[3];
 
             // Scale the variable v such that it takes uniform values in the interval [(1+cos(angle))/2 .. 1]
             float angleRad = _stage.getDirectionParm(0) * static_cast<float>(c_pi) / 180.0f;
             float v0 = (1 + cos(angleRad)) * 0.5f;
             float v1 = 1;
 
-            float v = v0 + particle.rand[4] * (v1 - v0);
+            float v = v0 + rand[4] * (v1 - v0);
 
             float theta = 2 * static_cast<float>(c_pi) * u;
             float phi = acos(2*v - 1);
@@ -429,7 +779,7 @@ Vector3 RenderableParticleBunch::getDirection(ParticleRenderInfo& particle, cons
             Vector3 endPoint(cos(theta) * sin(phi), sin(theta) * sin(phi), cos(phi));
 
             // Rotate the vector into the particle's main direction
-            endPoint = rotation.transformPoint(endPoint);
+            endPoint = _directionRotation.transformPoint(endPoint);
 
             return endPoint.getNormalised();
         }
@@ -448,7 +798,7 @@ Vector3 RenderableParticleBunch::getDirection(ParticleRenderInfo& particle, cons
     };
 }
 
-Vector3 RenderableParticleBunch::getDistributionOffset(ParticleRenderInfo& particle, bool distributeParticlesRandomly)
+Vector3 RenderableParticleBunch::getDistributionOffset(const float* rand, bool distributeParticlesRandomly)
 {
     switch (_stage.getDistributionType())
     {
@@ -463,9 +813,9 @@ Vector3 RenderableParticleBunch::getDistributionOffset(ParticleRenderInfo& parti
             if (distributeParticlesRandomly)
             {
                 // Rectangular spawn zone
-                randX = 2 * particle.rand[0] - 1.0f;
-                randY = 2 * particle.rand[1] - 1.0f;
-                randZ = 2 * particle.rand[2] - 1.0f;
+                randX = 2 * rand[0] - 1.0f;
+                randY = 2 * rand[1] - 1.0f;
+                randZ = 2 * rand[2] - 1.0f;
             }
 
             // If random distribution is off, particles get spawned at <sizex, sizey, sizez>
@@ -497,11 +847,11 @@ Vector3 RenderableParticleBunch::getDistributionOffset(ParticleRenderInfo& parti
             if (distributeParticlesRandomly)
             {
                 // Get a random angle in [0..2pi]
-                float angle = static_cast<float>(2*c_pi) * particle.rand[0];
+                float angle = static_cast<float>(2*c_pi) * rand[0];
 
                 float xPos = cos(angle) * sizeX;
                 float yPos = sin(angle) * sizeY;
-                float zPos = sizeZ * (2 * particle.rand[1] - 1.0f);
+                float zPos = sizeZ * (2 * rand[1] - 1.0f);
 
                 return Vector3(xPos, yPos, zPos);
             }
@@ -527,14 +877,14 @@ Vector3 RenderableParticleBunch::getDistributionOffset(ParticleRenderInfo& parti
             if (distributeParticlesRandomly)
             {
                 // The following is modeled after http://mathworld.wolfram.com/SpherePointPicking.html
-                float u = particle.rand[0];
-                float v = particle.rand[1];
+                float u = rand[0];
+                float v = rand[1];
 
                 float theta = 2 * static_cast<float>(c_pi) * u;
                 float phi = acos(2*v - 1);
 
                 // Take the sqrt(radius) to correct bunching at the center of the sphere
-                float r = sqrt(particle.rand[2]);
+                float r = sqrt(rand[2]);
 
                 float x = (minX + (maxX - minX) * r) * cos(theta) * sin(phi);
                 float y = (minY + (maxY - minY) * r) * sin(theta) * sin(phi);
@@ -555,39 +905,160 @@ Vector3 RenderableParticleBunch::getDistributionOffset(ParticleRenderInfo& parti
     };
 }
 
-void RenderableParticleBunch::pushQuad(ParticleRenderInfo& particle, const Vector4& colour, float s0, float sWidth)
+void RenderableParticleBunch::pushOrientedParticles(const ParticleEvaluation& evaluation)
 {
+    std::size_t animFrames = static_cast<std::size_t>(_stage.getAnimationFrames());
+
+    // Animated particles are drawn as two crossfaded quads
+    std::size_t numQuads = evaluation.getNumParticles() * (animFrames > 0 ? 2 : 1);
+
+    _vertices.resize(numQuads * 12);
+    _texcoords.resize(numQuads * 8);
+    _normals.resize(numQuads * 12);
+    _colours.resize(numQuads * 16);
+
+    float* vertex = &_vertices.front();
+    float* texcoord = &_texcoords.front();
+    float* normal = &_normals.front();
+    float* colour = &_colours.front();
+
     // greebo: Create a (rotated) quad facing the z axis
     // then rotate it to fit the requested orientation
     // finally translate it to its position.
-    const Vector3& normal = _viewRotation.z().getVector3();
+    const Matrix4& r = _viewRotation;
+
+    // The quad plane's axes and the normal in object space, the same for all quads
+    const float axisX[3] = { float(r.xx()), float(r.xy()), float(r.xz()) };
+    const float axisY[3] = { float(r.yx()), float(r.yy()), float(r.yz()) };
+    const float quadNormal[3] = { float(r.zx()), float(r.zy()), float(r.zz()) };
+
+    for (std::size_t p = 0; p < evaluation.getNumParticles(); ++p)
+    {
+        const float centre[3] = {
+            evaluation.origin[0][p] + float(r.tx()),
+            evaluation.origin[1][p] + float(r.ty()),
+            evaluation.origin[2][p] + float(r.tz())
+        };
+
+        const float particleColour[4] = {
+            evaluation.colour[0][p], evaluation.colour[1][p], evaluation.colour[2][p], evaluation.colour[3][p]
+        };
+
+        float angle = static_cast<float>(degrees_to_radians(evaluation.angle[p]));
+        float particleSize = evaluation.size[p];
+
+        writeQuadVertices(vertex, centre, axisX, axisY,
+                          particleSize * evaluation.aspect[p], particleSize, cos(angle), sin(angle));
+
+        if (animFrames > 0)
+        {
+            // Calculate the s coordinates and the resulting particle colour
+            ParticleRenderInfo particle;
+
+            particle.timeSecs = evaluation.timeSecs[p];
+            particle.colour = Vector4(particleColour[0], particleColour[1], particleColour[2], particleColour[3]);
+            particle.animFrames = animFrames;
+
+            calculateAnim(particle);
+
+            const float curColour[4] = {
+                float(particle.curColour.x()), float(particle.curColour.y()),
+                float(particle.curColour.z()), float(particle.curColour.w())
+            };
+
+            const float nextColour[4] = {
+                float(particle.nextColour.x()), float(particle.nextColour.y()),
+                float(particle.nextColour.z()), float(particle.nextColour.w())
+            };
+
+            // Animated, push two crossfaded quads at the same position
+            std::copy(vertex, vertex + 12, vertex + 12);
+            vertex += 24;
+
+            writeQuadAttributes(texcoord, normal, colour, quadNormal, curColour,
+                                particle.sWidth * particle.curFrame, particle.sWidth);
+            writeQuadAttributes(texcoord, normal, colour, quadNormal, nextColour,
+                                particle.sWidth * particle.nextFrame, particle.sWidth);
+        }
+        else
+        {
+            // Non-animated quad
+            vertex += 12;
 
-    _quads.push_back(ParticleQuad(particle.size, particle.aspect, particle.angle, colour, normal, s0, sWidth));
-    _quads.back().transform(_viewRotation);
-    _quads.back().translate(particle.origin);
+            writeQuadAttributes(texcoord, normal, colour, quadNormal, particleColour, 0, 1);
+        }
+    }
 }
 
-void RenderableParticleBunch::pushAimedParticles(ParticleRenderInfo& particle, std::size_t stageDurationMsec)
+void RenderableParticleBunch::pushQuad(const ParticleQuad& quad)
 {
-    int trails = static_cast<int>(_stage.getOrientationParm(0)); // trails
-    float aimedTime = _stage.getOrientationParm(1); // time
-
-    if (trails < 0)
+    for (std::size_t i = 0; i < 4; ++i)
     {
-        trails = 0;
+        const ParticleQuad::Vertex& v = quad.verts[i];
+
+        _vertices.push_back(static_cast<float>(v.vertex.x()));
+        _vertices.push_back(static_cast<float>(v.vertex.y()));
+        _vertices.push_back(static_cast<float>(v.vertex.z()));
+
+        _texcoords.push_back(static_cast<float>(v.texcoord.x()));
+        _texcoords.push_back(static_cast<float>(v.texcoord.y()));
+
+        _normals.push_back(static_cast<float>(v.normal.x()));
+        _normals.push_back(static_cast<float>(v.normal.y()));
+        _normals.push_back(static_cast<float>(v.normal.z()));
+
+        _colours.push_back(static_cast<float>(v.colour.x()));
+        _colours.push_back(static_cast<float>(v.colour.y()));
+        _colours.push_back(static_cast<float>(v.colour.z()));
+        _colours.push_back(static_cast<float>(v.colour.w()));
     }
+}
 
-    // The time parameter defaults to 0.5 if not specified
-    if (aimedTime == 0.0f)
+void RenderableParticleBunch::pushAimedParticles(const ParticleEvaluation& evaluation)
+{
+    std::size_t animFrames = static_cast<std::size_t>(_stage.getAnimationFrames());
+
+    // The quads of one particle's trail, re-used for all particles
+    std::vector<ParticleQuad> trail;
+
+    for (std::size_t p = 0; p < evaluation.getNumParticles(); ++p)
     {
-        aimedTime = 0.5f;
+        ParticleRenderInfo particle;
+
+        particle.timeSecs = evaluation.timeSecs[p];
+
+        particle.origin = Vector3(evaluation.origin[0][p], evaluation.origin[1][p], evaluation.origin[2][p]);
+        particle.colour = Vector4(evaluation.colour[0][p], evaluation.colour[1][p],
+                                  evaluation.colour[2][p], evaluation.colour[3][p]);
+
+        // Consider quad size and aspect ratio
+        particle.size = evaluation.size[p];
+        particle.aspect = evaluation.aspect[p];
+
+        // Consider animation frames
+        particle.animFrames = animFrames;
+
+        if (particle.animFrames > 0)
+        {
+            // Calculate the s coordinates and the resulting particle colour
+            calculateAnim(particle);
+        }
+
+        pushAimedParticle(particle, evaluation, p * evaluation.trailLength, trail);
+
+        for (std::size_t q = 0; q < trail.size(); ++q)
+        {
+            pushQuad(trail[q]);
+        }
     }
+}
 
-    // The time delta to step into the past
-    int numQuads = trails + 1;
+void RenderableParticleBunch::pushAimedParticle(ParticleRenderInfo& particle, const ParticleEvaluation& evaluation,
+                                                std::size_t firstTrailOrigin, std::vector<ParticleQuad>& trail)
+{
+    trail.clear();
 
-    // The time delta between quads
-    float timeStep = aimedTime / numQuads;
+    int numQuads = static_cast<int>(evaluation.trailLength);
 
     Vector3 lastOrigin = particle.origin;
 
@@ -596,12 +1067,11 @@ void RenderableParticleBunch::pushAimedParticles(ParticleRenderInfo& particle, s
         // Copy over the info of the incoming particle (contains anim info, colour, etc.)
         ParticleRenderInfo aimedParticle = particle;
 
-        // Get the time of the i-th particle in seconds, plus the fraction
-        aimedParticle.timeSecs = particle.timeSecs - timeStep * i;
-        aimedParticle.timeFraction = SEC2MS(aimedParticle.timeSecs) / stageDurationMsec;
+        // Get the origin of the i-th quad, stepping into the past
+        std::size_t index = firstTrailOrigin + i - 1;
 
-        // Get origin and velocity at that time
-        calculateOrigin(aimedParticle);
+        aimedParticle.origin = Vector3(evaluation.trail[0][index], evaluation.trail[1][index],
+                                       evaluation.trail[2][index]);
 
         // Gotcha: don't bother calculating the actual velocity at the given time, just use the
         // difference vector of the two origins, this is enough to receive the "aimed" direction
@@ -646,10 +1116,10 @@ void RenderableParticleBunch::pushAimedParticles(ParticleRenderInfo& particle, s
                 // Glue the first row of vertices to the last quad, if applicable
                 if (i > 1)
                 {
-                    snapQuads(curQuad, *(_quads.end()-2));
+                    snapQuads(curQuad, *(trail.end()-2));
                 }
 
-                _quads.push_back(curQuad);
+                trail.push_back(curQuad);
 
                 // "Next" quad, re-use the curQuad structure
                 curQuad.assignColour(aimedParticle.nextColour);
@@ -659,20 +1129,20 @@ void RenderableParticleBunch::pushAimedParticles(ParticleRenderInfo& particle, s
 
                 if (i > 1)
                 {
-                    snapQuads(curQuad, *(_quads.end()-2));
+                    snapQuads(curQuad, *(trail.end()-2));
                 }
 
-                _quads.push_back(curQuad);
+                trail.push_back(curQuad);
             }
             else
             {
                 if (i > 1)
                 {
-                    snapQuads(curQuad, _quads.back());
+                    snapQuads(curQuad, trail.back());
                 }
 
                 // Non-animated case
-                _quads.push_back(curQuad);
+                trail.push_back(curQuad);
             }
         }
 
@@ -700,12 +1170,9 @@ void RenderableParticleBunch::snapQuads(ParticleQuad& curQuad, ParticleQuad& pre
 
 void RenderableParticleBunch::calculateBounds()
 {
-    for (Quads::const_iterator i = _quads.begin(); i != _quads.end(); ++i)
+    for (std::size_t i = 0; i + 2 < _vertices.size(); i += 3)
     {
-        _bounds.includePoint(i->verts[0].vertex);
-        _bounds.includePoint(i->verts[1].vertex);
-        _bounds.includePoint(i->verts[2].vertex);
-        _bounds.includePoint(i->verts[3].vertex);
+        _bounds.includePoint(Vector3(_vertices[i], _vertices[i + 1], _vertices[i + 2]));
     }
 }
 
@@ -9,10 +9,12 @@
 #include "math/Vector3.h"
 #include "math/Matrix4.h"
 
+#include <vector>
 #include <boost/random/linear_congruential.hpp>
 
 #include "ParticleQuad.h"
 #include "ParticleRenderInfo.h"
+#include "ParticleEvaluationCache.h"
 
 namespace particles
 {
@@ -21,7 +23,22 @@ namespace particles
 #define SEC2MS(x) ((x)*1000)
 #define MS2SEC(x) ((x)*0.001f)
 
-/// A single bunch of particles, consisting of a renderable set of quads
+/**
+ * A single bunch of particles, consisting of a renderable set of quads.
+ *
+ * update() only records the time, the geometry is calculated by simulate(),
+ * which the ParticleSimulator runs for all pending bunches at once. The
+ * particles are processed attribute by attribute in flat arrays and the
+ * quads are written to one array per vertex attribute. simulate() doesn't
+ * touch anything outside this bunch and the ParticleEvaluationCache, it
+ * may run on any thread.
+ *
+ * If the instances of a particle def share their seeds, the particle state
+ * is shared with all other bunches of the same stage, seed and time through
+ * the ParticleEvaluationCache, each bunch only orients the quads according
+ * to its own view rotation. The time is quantised in that case, such that
+ * the bunches of all instances hit the same cache entries.
+ */
 class RenderableParticleBunch : public OpenGLRenderable
 {
 	// The bunch index
@@ -30,10 +47,6 @@ class RenderableParticleBunch : public OpenGLRenderable
 	// The stage this bunch is part of
 	const IStageDef& _stage;
 
-	// The quads of this particle bunch
-	typedef std::vector<ParticleQuad> Quads;
-	Quads _quads;
-
 	// The seed for our local randomiser, as passed by the parent stage
 	int _randSeed;
 
@@ -58,6 +71,53 @@ class RenderableParticleBunch : public OpenGLRenderable
 	// The entity colour (instance owned by RenderableParticle)
 	const Vector3& _entityColour;
 
+	// Whether to use the ParticleEvaluationCache, only worth it if the seeds are shared
+	bool _shareEvaluation;
+
+	// The cycle time requested by the last update() and whether the geometry
+	// still needs to be calculated for it
+	std::size_t _time;
+	bool _needsSimulation;
+
+	// The inputs of the current geometry, unchanged inputs don't need a new simulation
+	bool _simulated;
+	std::size_t _simulatedTime;
+	Matrix4 _simulatedViewRotation;
+	Vector3 _simulatedDirection;
+	Vector3 _simulatedEntityColour;
+
+	// The spawned particles during an evaluation, one array per attribute
+	struct Particles
+	{
+		std::vector<std::size_t> index;
+		std::vector<float> timeSecs;
+		std::vector<float> timeFraction;
+		std::vector<float> rand[5];
+		std::vector<float> angle;	// initial angle
+
+		std::size_t size() const
+		{
+			return index.size();
+		}
+
+		void clear();
+	};
+	Particles _particles;
+
+	// The particle state the current geometry has been built from
+	ParticleEvaluationPtr _evaluation;
+
+	// Values derived from the emitter and stage settings, fixed during one simulation
+	Matrix4 _directionRotation;
+	Vector3 _rotatedOffset;
+	Vector3 _gravity;
+
+	// The quad vertices, four per quad, one array per vertex attribute
+	std::vector<float> _vertices;	// 3 floats per vertex
+	std::vector<float> _texcoords;	// 2 floats per vertex
+	std::vector<float> _normals;	// 3 floats per vertex
+	std::vector<float> _colours;	// 4 floats per vertex
+
 public:
 	// Each bunch has a defined zero-based index
 	RenderableParticleBunch(std::size_t index,
@@ -65,16 +125,65 @@ public:
 							const IStageDef& stage,
 							const Matrix4& viewRotation,
 							const Vector3& direction,
-							const Vector3& entityColour);
+							const Vector3& entityColour,
+							bool shareEvaluation);
 
 	std::size_t getIndex() const
 	{
 		return _index;
 	}
 
-	// Update the particle geometry and render information.
-	// Time is specified in stage time without offset,in msecs.
-	void update(std::size_t time);
+	// Sets the time to calculate the geometry for, in stage time without
+	// offset, in msecs. Returns true if the bunch needs to be simulated and
+	// has to be passed to the ParticleSimulator, false if the current
+	// geometry is still valid or the bunch is already waiting for it.
+	bool update(std::size_t time);
+
+	// Calculates the particle geometry for the time passed to update()
+	void simulate();
+
+	// Returns true if update() has been called since the last simulation
+	bool needsSimulation() const
+	{
+		return _needsSimulation;
+	}
+
+	// The maximum number of particles of this bunch, to balance the simulation work
+	std::size_t getNumParticles() const;
+
+	// Returns the number of quads generated by the last simulation
+	std::size_t getNumQuads() const
+	{
+		return _vertices.size() / 12;
+	}
+
+	// The vertex positions generated by the last simulation, 3 floats per vertex
+	const std::vector<float>& getVertices() const
+	{
+		return _vertices;
+	}
+
+	// The other vertex attributes: 2 texcoords, 3 normal and 4 colour components per vertex
+	const std::vector<float>& getTexcoords() const
+	{
+		return _texcoords;
+	}
+
+	const std::vector<float>& getNormals() const
+	{
+		return _normals;
+	}
+
+	const std::vector<float>& getColours() const
+	{
+		return _colours;
+	}
+
+	// The particle state the current geometry has been built from, may be empty
+	const ParticleEvaluationPtr& getEvaluation() const
+	{
+		return _evaluation;
+	}
 
 	void render(const RenderInfo& info) const;
 
@@ -87,33 +196,60 @@ private:
 		return (param.getTo() - param.getFrom()) / _stage.getDuration() * time*time * 0.5f + param.getFrom() * time;
 	}
 
-	Vector4 lerpColour(const Vector4& startColour, const Vector4& endColour, float fraction)
+	static Vector4 lerpColour(const Vector4& startColour, const Vector4& endColour, float fraction)
 	{
 		return startColour * (1.0f - fraction) + endColour * fraction;
 	}
 
-	void calculateColour(ParticleRenderInfo& particle);
+	// Returns the time at which the geometry needs to be calculated, all
+	// times past the end of the cycle map to the same (empty) result
+	std::size_t getSimulationTime(std::size_t time) const;
+
+	// Calculates the view-independent state of all particles at the current time
+	ParticleEvaluationPtr evaluate();
+
+	// Generates the random values of all particles spawned at the given
+	// cycle time, keeping the ones which haven't expired yet
+	void spawnParticles(std::size_t cycleTime, std::size_t spawnSpacingMsec, std::size_t stageDurationMsec);
+
+	// Calculates the colour of each particle
+	void calculateColours(ParticleEvaluation& evaluation);
+
+	// Calculates the origin of each particle
+	void calculateOrigins(ParticleEvaluation& evaluation);
 
-	// Calculates origin at the given time, write result back to the given struct
-	void calculateOrigin(ParticleRenderInfo& particle);
+	// Calculates the angle, size and aspect of each particle
+	void calculateQuadParameters(ParticleEvaluation& evaluation);
+
+	// Calculates the origins of the trail quads for aimed orientation
+	void calculateTrails(ParticleEvaluation& evaluation);
+
+	// Calculates the origin of a single particle at the given time
+	Vector3 calculateOrigin(const float* rand, float timeSecs);
 
 	// Handles animFrame stuff, may only be called if animFrames > 0
 	void calculateAnim(ParticleRenderInfo& particle);
 
 	// The rotation is used to deviate the offsets should be normalised and not degenerate
-	Vector3 getDirection(ParticleRenderInfo& particle, const Matrix4& rotation, const Vector3& distributionOffset);
+	Vector3 getDirection(const float* rand, const Vector3& distributionOffset);
+
+	Vector3 getDistributionOffset(const float* rand, bool distributeParticlesRandomly);
+
+	// Generates the quads of all particles facing the view (or the stage's axis)
+	void pushOrientedParticles(const ParticleEvaluation& evaluation);
 
-	Vector3 getDistributionOffset(ParticleRenderInfo& particle, bool distributeParticlesRandomly);
+	// Generates the quads of all particles with aimed orientation
+	void pushAimedParticles(const ParticleEvaluation& evaluation);
 
 	// Calculates the matrix which rotates faces towards the viewer (used for "aimed" orientation)
 	Matrix4 getAimedMatrix(const Vector3& particleVelocity);
 
 	// Handles aimed particles
-	void pushAimedParticles(ParticleRenderInfo& particle, std::size_t stageDurationMsec);
+	void pushAimedParticle(ParticleRenderInfo& particle, const ParticleEvaluation& evaluation,
+						   std::size_t firstTrailOrigin, std::vector<ParticleQuad>& trail);
 
-	// Generates a new quad using the given struct as data source.
-	// colour, s0 and sWidth override the values in info
-	void pushQuad(ParticleRenderInfo& particle, const Vector4& colour, float s0 = 0.0f, float sWidth = 1.0f);
+	// Appends the given quad to the vertex arrays
+	void pushQuad(const ParticleQuad& quad);
 
 	// Makes the quad transition seamless by snapping the adjacent vertices at the midpoint
 	void snapQuads(ParticleQuad& curQuad, ParticleQuad& prevQuad);
@@ -121,6 +257,7 @@ private:
 	void calculateBounds();
 };
 typedef boost::shared_ptr<RenderableParticleBunch> RenderableParticleBunchPtr;
+typedef boost::weak_ptr<RenderableParticleBunch> RenderableParticleBunchWeakPtr;
 
 } // namespace
 
@@ -1,4 +1,5 @@
 #include "RenderableParticleStage.h"
+#include "ParticleSimulator.h"
 
 namespace particles
 {
@@ -7,14 +8,16 @@ RenderableParticleStage::RenderableParticleStage(
 		const IStageDef& stage,
 		boost::rand48& random,
 		const Vector3& direction,
-		const Vector3& entityColour) :
+		const Vector3& entityColour,
+		bool shareEvaluation) :
 	_stageDef(stage),
 	_numSeeds(32),
 	_seeds(_numSeeds),
 	_bunches(2), // two bunches
 	_viewRotation(Matrix4::getIdentity()), // is re-calculated each update anyway
 	_direction(direction),
-	_entityColour(entityColour)
+	_entityColour(entityColour),
+	_shareEvaluation(shareEvaluation)
 {
 	// Generate our vector of random numbers used seed particle bunches
 	// using the random number generator as provided by our parent particle system
@@ -68,16 +71,14 @@ void RenderableParticleStage::update(std::size_t time, const Matrix4& viewRotati
 
 	// The 0 bunch is the active one, the 1 bunch is the previous one if not null
 
-	// Tell the particle batches to update their geometry
-	if (_bunches[0] != NULL)
-	{
-		// Get one of our seed values
-		_bunches[0]->update(localtimeMsec);
-	}
-
-	if (_bunches[1] != NULL)
+	// Tell the particle batches to update their geometry, the ones which
+	// changed are simulated together with all other particles before rendering
+	for (std::size_t i = 0; i < _bunches.size(); ++i)
 	{
-		_bunches[1]->update(localtimeMsec);
+		if (_bunches[i] != NULL && _bunches[i]->update(localtimeMsec))
+		{
+			ParticleSimulator::Instance().schedule(_bunches[i]);
+		}
 	}
 }
 
@@ -192,7 +193,7 @@ void RenderableParticleStage::ensureBunches(std::size_t localTimeMSec)
 RenderableParticleBunchPtr RenderableParticleStage::createBunch(std::size_t cycleIndex)
 {
 	return RenderableParticleBunchPtr(new RenderableParticleBunch(
-		cycleIndex, getSeed(cycleIndex), _stageDef, _viewRotation, _direction, _entityColour));
+		cycleIndex, getSeed(cycleIndex), _stageDef, _viewRotation, _direction, _entityColour, _shareEvaluation));
 }
 
 int RenderableParticleStage::getSeed(std::size_t cycleIndex)
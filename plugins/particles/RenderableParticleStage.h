@@ -41,11 +41,15 @@ class RenderableParticleStage :
 	// The entity colour (instance owned by RenderableParticle)
 	const Vector3& _entityColour;
 
+	// TRUE if the instances of the particle def share their seeds (and their bunches)
+	bool _shareEvaluation;
+
 public:
 	RenderableParticleStage(const IStageDef& stage, 
 							boost::rand48& random, 
 							const Vector3& direction,
-							const Vector3& entityColour);
+							const Vector3& entityColour,
+							bool shareEvaluation);
 
 	void render(const RenderInfo& info) const;
 
@@ -166,7 +166,7 @@ void StageDef::copyFrom(const IStageDef& other)
 
 	setDistributionType(other.getDistributionType());
 
-	for (int i = 0; i < 3; ++i)
+	for (int i = 0; i < 4; ++i)
 	{
 		setDistributionParm(i, other.getDistributionParm(i));
 	}
@@ -750,7 +750,7 @@ bool StageDef::operator==(const IStageDef& other) const
 
     if (getDistributionType() != other.getDistributionType()) return false;
 
-    for (int i = 0; i < 3; ++i)
+    for (int i = 0; i < 4; ++i)
     {
         if (getDistributionParm(i) != other.getDistributionParm(i)) return false;
     }
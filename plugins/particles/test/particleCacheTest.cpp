@@ -0,0 +1,212 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE particleCacheTest
+#include <boost/test/unit_test.hpp>
+
+#include "StageDef.h"
+#include "RenderableParticleBunch.h"
+
+using namespace particles;
+
+namespace
+{
+    StageDefPtr createStage(const std::string& body)
+    {
+        std::string source = body + " }";
+        parser::BasicDefTokeniser<std::string> tok(source);
+
+        return StageDefPtr(new StageDef(tok));
+    }
+
+    // The inputs owned by the stage and the particle in the regular code
+    struct Emitter
+    {
+        Matrix4 viewRotation;
+        Vector3 direction;
+        Vector3 entityColour;
+
+        Emitter() :
+            viewRotation(Matrix4::getIdentity()),
+            direction(0, 0, 1),
+            entityColour(1, 1, 1)
+        {}
+
+        RenderableParticleBunchPtr createBunch(const IStageDef& stage, int seed)
+        {
+            return RenderableParticleBunchPtr(new RenderableParticleBunch(
+                0, seed, stage, viewRotation, direction, entityColour, true));
+        }
+    };
+
+    void simulate(const RenderableParticleBunchPtr& bunch, std::size_t time)
+    {
+        bunch->update(time);
+        bunch->simulate();
+    }
+
+    ParticleCacheStats getStats()
+    {
+        return ParticleEvaluationCache::Instance().getStats();
+    }
+}
+
+// Emitters of the same stage share the particles, but use their own view
+BOOST_AUTO_TEST_CASE(shareBetweenEmitters)
+{
+    StageDefPtr stage = createStage("count 20 time 2 distribution sphere 10 10 10 speed 30");
+
+    Emitter first;
+    Emitter second;
+    second.viewRotation = Matrix4::getRotation(Vector3(0, 0, 1), Vector3(1, 0, 0));
+
+    ParticleEvaluationCache::Instance().resetCounters();
+
+    RenderableParticleBunchPtr a = first.createBunch(*stage, 42);
+    RenderableParticleBunchPtr b = second.createBunch(*stage, 42);
+    RenderableParticleBunchPtr c = first.createBunch(*stage, 42);
+
+    // The first evaluation isn't stored, the second one is
+    simulate(a, 1000);
+    simulate(b, 1000);
+    simulate(c, 1000);
+
+    BOOST_CHECK_EQUAL(getStats().numLookups, 3);
+    BOOST_CHECK_EQUAL(getStats().numHits, 1);
+
+    BOOST_REQUIRE_EQUAL(a->getNumQuads(), b->getNumQuads());
+    BOOST_CHECK(a->getVertices() == c->getVertices());
+    BOOST_CHECK(a->getVertices() != b->getVertices());
+
+    // Times within the same step share the evaluation too
+    simulate(c, 1005);
+    BOOST_CHECK_EQUAL(getStats().numHits, 2);
+
+    // A different seed, direction or time needs a new evaluation
+    simulate(first.createBunch(*stage, 43), 1000);
+    simulate(c, 1100);
+
+    second.direction = Vector3(1, 0, 0);
+    simulate(b, 1000);
+
+    BOOST_CHECK_EQUAL(getStats().numLookups, 7);
+    BOOST_CHECK_EQUAL(getStats().numHits, 2);
+}
+
+// Bunches which are only evaluated once are not stored
+BOOST_AUTO_TEST_CASE(storeOnSecondRequest)
+{
+    StageDefPtr stage = createStage("count 20 time 2 speed 30");
+    Emitter emitter;
+
+    ParticleEvaluationCache::Instance().clear();
+    ParticleEvaluationCache::Instance().resetCounters();
+
+    for (int seed = 0; seed < 50; ++seed)
+    {
+        simulate(emitter.createBunch(*stage, seed), 1000);
+    }
+
+    BOOST_CHECK_EQUAL(getStats().numHits, 0);
+    BOOST_CHECK_EQUAL(getStats().numEntries, 0);
+    BOOST_CHECK_EQUAL(getStats().memoryBytes, 0);
+
+    // Asking for one of them again stores it, the third request hits
+    simulate(emitter.createBunch(*stage, 7), 1000);
+    BOOST_CHECK_EQUAL(getStats().numEntries, 1);
+
+    simulate(emitter.createBunch(*stage, 7), 1000);
+    BOOST_CHECK_EQUAL(getStats().numHits, 1);
+}
+
+// The entity colour only matters for stages using it
+BOOST_AUTO_TEST_CASE(entityColourKey)
+{
+    StageDefPtr stage = createStage("count 20 time 2 speed 30");
+    StageDefPtr colourStage = createStage("count 20 time 2 speed 30 entityColor 1");
+
+    Emitter red;
+    red.entityColour = Vector3(1, 0, 0);
+
+    Emitter blue;
+    blue.entityColour = Vector3(0, 0, 1);
+
+    ParticleEvaluationCache::Instance().resetCounters();
+
+    // Each key is requested twice, the second request stores it
+    simulate(red.createBunch(*stage, 1), 500);
+    simulate(red.createBunch(*stage, 1), 500);
+    simulate(blue.createBunch(*stage, 1), 500);
+    BOOST_CHECK_EQUAL(getStats().numHits, 1);
+
+    simulate(red.createBunch(*colourStage, 1), 500);
+    simulate(red.createBunch(*colourStage, 1), 500);
+    simulate(blue.createBunch(*colourStage, 1), 500);
+    BOOST_CHECK_EQUAL(getStats().numHits, 1);
+}
+
+// Changing a stage discards its cached particles
+BOOST_AUTO_TEST_CASE(invalidateChangedStages)
+{
+    StageDefPtr stage = createStage("count 20 time 2 bunching 1 speed 30");
+    Emitter emitter;
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 7);
+
+    simulate(bunch, 1000);
+    BOOST_CHECK_EQUAL(bunch->getNumQuads(), 10);
+
+    stage->setCount(10);
+
+    ParticleEvaluationCache::Instance().resetCounters();
+
+    RenderableParticleBunchPtr other = emitter.createBunch(*stage, 7);
+    simulate(other, 1000);
+
+    BOOST_CHECK_EQUAL(getStats().numHits, 0);
+    BOOST_CHECK_EQUAL(other->getNumQuads(), 5);
+}
+
+// The cache drops the least recently used evaluations when it gets full
+BOOST_AUTO_TEST_CASE(evictLeastRecentlyUsed)
+{
+    StageDefPtr stage = createStage("count 100 time 2 speed 30");
+    Emitter emitter;
+
+    ParticleEvaluationCache& cache = ParticleEvaluationCache::Instance();
+    cache.clear();
+
+    // Find out the size of one evaluation, it is stored on the second request
+    simulate(emitter.createBunch(*stage, 0), 1000);
+    simulate(emitter.createBunch(*stage, 0), 1000);
+    std::size_t entrySize = getStats().memoryBytes;
+
+    ParticleEvaluationCache small(entrySize * 3);
+
+    ParticleEvaluationCache::Key keys[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ParticleEvaluationCache::Key key = { stage.get(), i, 1000, Vector3(0, 0, 1), Vector3(0, 0, 0) };
+        keys[i] = key;
+
+        boost::shared_ptr<ParticleEvaluation> entry(new ParticleEvaluation);
+        entry->timeSecs.resize((entrySize - sizeof(ParticleEvaluation)) / sizeof(float));
+
+        if (i == 3)
+        {
+            // Use the first one, such that the second one is the oldest
+            BOOST_CHECK(small.find(keys[0]));
+        }
+
+        // Insert twice to get past the admission
+        small.insert(key, entry);
+        small.insert(key, entry);
+    }
+
+    BOOST_CHECK_EQUAL(small.getStats().numEntries, 3);
+    BOOST_CHECK(small.getStats().memoryBytes <= entrySize * 3);
+
+    BOOST_CHECK(small.find(keys[0]));
+    BOOST_CHECK(!small.find(keys[1]));
+    BOOST_CHECK(small.find(keys[2]));
+    BOOST_CHECK(small.find(keys[3]));
+}
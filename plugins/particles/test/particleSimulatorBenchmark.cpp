@@ -0,0 +1,204 @@
+#include "StageDef.h"
+#include "ParticleSimulator.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <glibmm/timer.h>
+
+/**
+ * Measures the time needed to calculate the particles of a large number of
+ * emitters per frame, one bunch after the other on the calling thread, with
+ * the ParticleSimulator and with a paused clock, where all bunches can be
+ * reused. The unique emitters are all at a different point of their cycle,
+ * the instanced ones show the same particles from different angles, like
+ * the emitters of one particle def do in the editor. This is not part of the
+ * test suite, run "make particleSimulatorBenchmark" and execute it manually.
+ * The number of emitters can be passed as argument.
+ */
+using namespace particles;
+
+namespace
+{
+    const int FRAMES = 20;
+
+    // 60 fps
+    const std::size_t FRAME_MSECS = 16;
+
+    // A mix of typical smoke, spark and fire stages
+    const char* const STAGES[] = {
+        "count 40 time 3 bunching 1 distribution cylinder 8 8 4 direction cone 20 speed 20 to 40 "
+            "size 4 to 16 rotation 10 to 30 fadeIn 0.2 fadeOut 0.5 gravity -5 }",
+        "count 60 time 1 bunching 0.5 distribution sphere 2 2 2 direction outward 0.3 speed 80 to 20 "
+            "size 0.5 gravity world 120 orientation aimed 2 0.1 }",
+        "count 30 time 1.5 bunching 1 distribution rect 6 6 2 speed 30 size 8 to 2 "
+            "animationFrames 8 animationrate 6 fadeIndex 0.2 }",
+    };
+
+    const std::size_t NUM_STAGES = sizeof(STAGES) / sizeof(STAGES[0]);
+
+    struct Emitter
+    {
+        Matrix4 viewRotation;
+        Vector3 direction;
+        Vector3 entityColour;
+        std::vector<RenderableParticleBunchPtr> bunches;
+    };
+
+    class Benchmark
+    {
+        std::vector<StageDefPtr> _stages;
+        std::vector<std::string> _sources;
+        std::vector<Emitter> _emitters;
+        bool _instanced;
+
+    public:
+        Benchmark(std::size_t numEmitters, bool instanced) :
+            _emitters(numEmitters),
+            _instanced(instanced)
+        {
+            for (std::size_t i = 0; i < NUM_STAGES; ++i)
+            {
+                _sources.push_back(STAGES[i]);
+
+                parser::BasicDefTokeniser<std::string> tok(_sources.back());
+                _stages.push_back(StageDefPtr(new StageDef(tok)));
+            }
+
+            for (std::size_t i = 0; i < _emitters.size(); ++i)
+            {
+                Emitter& emitter = _emitters[i];
+
+                // Each emitter is rotated differently relative to the camera
+                emitter.viewRotation = Matrix4::getRotation(Vector3(0, 0, 1), 0.01 * i);
+                emitter.direction = Vector3(0, 0, 1);
+                emitter.entityColour = Vector3(1, 1, 1);
+
+                // Every emitter shows two bunches, like a stage in its second cycle
+                const IStageDef& stage = *_stages[i % NUM_STAGES];
+
+                for (std::size_t b = 0; b < 2; ++b)
+                {
+                    // Instances get the same stage seeds
+                    int seed = _instanced ? static_cast<int>(b) : std::rand();
+
+                    emitter.bunches.push_back(RenderableParticleBunchPtr(new RenderableParticleBunch(
+                        b, seed, stage, emitter.viewRotation, emitter.direction, emitter.entityColour,
+                        _instanced)));
+                }
+            }
+        }
+
+        std::size_t getNumParticles() const
+        {
+            std::size_t count = 0;
+
+            for (std::size_t i = 0; i < _emitters.size(); ++i)
+            {
+                for (std::size_t b = 0; b < _emitters[i].bunches.size(); ++b)
+                {
+                    count += _emitters[i].bunches[b]->getNumParticles();
+                }
+            }
+
+            return count;
+        }
+
+        // Returns the milliseconds per frame
+        double measureSerial()
+        {
+            ParticleEvaluationCache::Instance().clear();
+
+            // Wall clock time, the CPU time would add up the threads
+            Glib::Timer timer;
+
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                forEachBunch(getTime(frame), false);
+            }
+
+            return timer.elapsed() * 1000 / FRAMES;
+        }
+
+        double measureSimulator(bool paused)
+        {
+            ParticleEvaluationCache::Instance().clear();
+
+            Glib::Timer timer;
+
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                forEachBunch(getTime(paused ? 0 : frame), true);
+                ParticleSimulator::Instance().flush();
+            }
+
+            return timer.elapsed() * 1000 / FRAMES;
+        }
+
+    private:
+        // Each emitter runs at a different point in its second cycle
+        std::size_t getTime(int frame)
+        {
+            return 3000 + FRAME_MSECS * frame;
+        }
+
+        void forEachBunch(std::size_t time, bool schedule)
+        {
+            for (std::size_t i = 0; i < _emitters.size(); ++i)
+            {
+                std::size_t emitterTime = _instanced ? time : time + (i * 97) % 1000;
+
+                for (std::size_t b = 0; b < _emitters[i].bunches.size(); ++b)
+                {
+                    const RenderableParticleBunchPtr& bunch = _emitters[i].bunches[b];
+
+                    if (!bunch->update(emitterTime)) continue;
+
+                    if (schedule)
+                    {
+                        ParticleSimulator::Instance().schedule(bunch);
+                    }
+                    else
+                    {
+                        bunch->simulate();
+                    }
+                }
+            }
+        }
+    };
+
+    void print(const std::string& name, double msecs)
+    {
+        std::cout << std::setw(24) << std::left << name
+                  << std::setw(10) << std::right << std::fixed << std::setprecision(2)
+                  << msecs << " ms per frame" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (!Glib::thread_supported()) Glib::thread_init();
+
+    std::size_t numEmitters = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 2000;
+
+    std::srand(1);
+
+    for (int instanced = 0; instanced < 2; ++instanced)
+    {
+        Benchmark benchmark(numEmitters, instanced != 0);
+
+        std::cout << "Simulating " << numEmitters << (instanced ? " instanced" : " unique")
+                  << " emitters with up to " << benchmark.getNumParticles() << " particles" << std::endl;
+
+        print("serial", benchmark.measureSerial());
+        print("simulator", benchmark.measureSimulator(false));
+
+        ParticleCacheStats stats = ParticleEvaluationCache::Instance().getStats();
+        std::cout << "  cache hits of the last frame: " << stats.numHits << "/" << stats.numLookups << std::endl;
+
+        print("simulator, paused", benchmark.measureSimulator(true));
+    }
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE particleSimulatorTest
+#include <boost/test/unit_test.hpp>
+
+#include "StageDef.h"
+#include "ParticleSimulator.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace particles;
+
+namespace
+{
+    // Creates a stage from the body of a stage declaration
+    StageDefPtr createStage(const std::string& body)
+    {
+        std::string source = body + " }";
+        parser::BasicDefTokeniser<std::string> tok(source);
+
+        return StageDefPtr(new StageDef(tok));
+    }
+
+    // The inputs owned by the stage and the particle in the regular code
+    struct Emitter
+    {
+        Matrix4 viewRotation;
+        Vector3 direction;
+        Vector3 entityColour;
+
+        Emitter() :
+            viewRotation(Matrix4::getRotation(Vector3(0.3, 0.5, 0.8).getNormalised(), 0.7)),
+            direction(0.2, 0.1, 1),
+            entityColour(1, 1, 1)
+        {}
+
+        RenderableParticleBunchPtr createBunch(const IStageDef& stage, std::size_t index, int seed)
+        {
+            return RenderableParticleBunchPtr(new RenderableParticleBunch(
+                index, seed, stage, viewRotation, direction, entityColour, false));
+        }
+    };
+
+    // The float arrays are calculated in single precision
+    bool closeTo(double value, double expected)
+    {
+        return std::abs(value - expected) <= 1e-4 * std::max(1.0, std::abs(expected));
+    }
+
+    // Checks the vertex of the given quad against a quad built like the previous
+    // implementation did: a ParticleQuad transformed by the view rotation, then
+    // translated to the particle origin
+    void checkQuadVertex(const RenderableParticleBunch& bunch, std::size_t quad, std::size_t corner,
+                         const ParticleQuad& expected)
+    {
+        std::size_t v = quad * 4 + corner;
+        const ParticleQuad::Vertex& e = expected.verts[corner];
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            BOOST_CHECK(closeTo(bunch.getVertices()[v * 3 + i], e.vertex[i]));
+            BOOST_CHECK(closeTo(bunch.getNormals()[v * 3 + i], e.normal[i]));
+        }
+
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            BOOST_CHECK(closeTo(bunch.getTexcoords()[v * 2 + i], e.texcoord[i]));
+        }
+    }
+
+    ParticleQuad createPreviousQuad(const ParticleEvaluation& evaluation, std::size_t p,
+                                    const Matrix4& viewRotation, float s0, float sWidth)
+    {
+        Vector4 colour(evaluation.colour[0][p], evaluation.colour[1][p],
+                       evaluation.colour[2][p], evaluation.colour[3][p]);
+
+        ParticleQuad quad(evaluation.size[p], evaluation.aspect[p], evaluation.angle[p], colour,
+                          viewRotation.z().getVector3(), s0, sWidth);
+
+        quad.transform(viewRotation);
+        quad.translate(Vector3(evaluation.origin[0][p], evaluation.origin[1][p], evaluation.origin[2][p]));
+
+        return quad;
+    }
+}
+
+// Particles are spawned one after the other and expire after the stage duration
+BOOST_AUTO_TEST_CASE(spawnAndExpireParticles)
+{
+    StageDefPtr stage = createStage("count 10 time 1 bunching 1 distribution rect 5 5 5 speed 10");
+    Emitter emitter;
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 0, 1234);
+
+    // The particles 0..4 have been spawned at 0, 100, .. 400 msecs
+    BOOST_CHECK(bunch->update(450));
+    bunch->simulate();
+    BOOST_CHECK_EQUAL(bunch->getNumQuads(), 5);
+    BOOST_CHECK(bunch->getBounds().isValid());
+
+    // The particles 0..4 have expired, 5..9 are still alive
+    BOOST_CHECK(bunch->update(1450));
+    bunch->simulate();
+    BOOST_CHECK_EQUAL(bunch->getNumQuads(), 5);
+
+    // Everything has expired
+    BOOST_CHECK(bunch->update(1950));
+    bunch->simulate();
+    BOOST_CHECK_EQUAL(bunch->getNumQuads(), 0);
+}
+
+// Bunches only need a new simulation if the time or the emitter changed
+BOOST_AUTO_TEST_CASE(reuseUnchangedBunches)
+{
+    StageDefPtr stage = createStage("count 10 time 1 bunching 1 distribution rect 5 5 5 speed 10");
+    Emitter emitter;
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 0, 1234);
+
+    BOOST_CHECK(bunch->update(300));
+    BOOST_CHECK(!bunch->update(350)); // already waiting for the simulation
+    bunch->simulate();
+
+    BOOST_CHECK(!bunch->update(350));
+    BOOST_CHECK(bunch->update(360));
+    bunch->simulate();
+
+    emitter.direction = Vector3(1, 0, 0);
+    BOOST_CHECK(bunch->update(360));
+    bunch->simulate();
+
+    emitter.viewRotation = Matrix4::getIdentity();
+    BOOST_CHECK(bunch->update(360));
+    bunch->simulate();
+
+    // All times after the last particle has expired give the same result
+    BOOST_CHECK(bunch->update(2500));
+    bunch->simulate();
+    BOOST_CHECK(!bunch->update(2600));
+    BOOST_CHECK(!bunch->update(5000));
+}
+
+// The view-facing quads need to match the ParticleQuads of the previous implementation
+BOOST_AUTO_TEST_CASE(orientedQuadsMatchParticleQuads)
+{
+    StageDefPtr stage = createStage("count 40 time 2 bunching 0.7 distribution rect 10 20 5 "
+        "direction cone 30 speed 10 to 50 size 2 to 6 aspect 1 to 2 rotation 20 to 90 gravity 20");
+
+    Emitter emitter;
+    emitter.viewRotation.t() = Vector4(12, -7, 30, 1);
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 0, 4321);
+
+    BOOST_REQUIRE(bunch->update(1500));
+    bunch->simulate();
+
+    const ParticleEvaluation& evaluation = *bunch->getEvaluation();
+
+    BOOST_REQUIRE(evaluation.getNumParticles() > 0);
+    BOOST_REQUIRE_EQUAL(bunch->getNumQuads(), evaluation.getNumParticles());
+
+    for (std::size_t p = 0; p < evaluation.getNumParticles(); ++p)
+    {
+        ParticleQuad expected = createPreviousQuad(evaluation, p, emitter.viewRotation, 0, 1);
+
+        for (std::size_t corner = 0; corner < 4; ++corner)
+        {
+            checkQuadVertex(*bunch, p, corner, expected);
+
+            for (std::size_t i = 0; i < 4; ++i)
+            {
+                BOOST_CHECK(closeTo(bunch->getColours()[(p * 4 + corner) * 4 + i],
+                                    expected.verts[corner].colour[i]));
+            }
+        }
+    }
+}
+
+// Animated particles are two crossfaded quads covering adjacent frames
+BOOST_AUTO_TEST_CASE(animatedQuadsMatchParticleQuads)
+{
+    StageDefPtr stage = createStage("count 30 time 1.5 distribution sphere 20 20 20 0.5 "
+        "direction outward 0.5 speed 5 rotation 10 to 180 animationFrames 4 animationrate 3 gravity world 10");
+
+    Emitter emitter;
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 0, 99);
+
+    BOOST_REQUIRE(bunch->update(1200));
+    bunch->simulate();
+
+    const ParticleEvaluation& evaluation = *bunch->getEvaluation();
+
+    BOOST_REQUIRE(evaluation.getNumParticles() > 0);
+    BOOST_REQUIRE_EQUAL(bunch->getNumQuads(), evaluation.getNumParticles() * 2);
+
+    const std::vector<float>& texcoords = bunch->getTexcoords();
+    const std::vector<float>& colours = bunch->getColours();
+    const float sWidth = 0.25f;
+
+    for (std::size_t p = 0; p < evaluation.getNumParticles(); ++p)
+    {
+        float curS0 = texcoords[p * 16];
+        float nextS0 = texcoords[p * 16 + 8];
+
+        // The next frame follows the current one, wrapping around
+        BOOST_CHECK(closeTo(std::fmod(curS0 + sWidth, 1.0f), nextS0));
+
+        for (std::size_t q = 0; q < 2; ++q)
+        {
+            ParticleQuad expected = createPreviousQuad(evaluation, p, emitter.viewRotation,
+                                                       q == 0 ? curS0 : nextS0, sWidth);
+
+            for (std::size_t corner = 0; corner < 4; ++corner)
+            {
+                checkQuadVertex(*bunch, p * 2 + q, corner, expected);
+            }
+        }
+
+        // The crossfaded colours add up to the particle colour
+        for (std::size_t corner = 0; corner < 4; ++corner)
+        {
+            for (std::size_t i = 0; i < 4; ++i)
+            {
+                float sum = colours[(p * 8 + corner) * 4 + i] + colours[(p * 8 + 4 + corner) * 4 + i];
+                BOOST_CHECK(closeTo(sum, evaluation.colour[i][p]));
+            }
+        }
+    }
+}
+
+// The simulator needs to produce the same geometry as simulating each bunch
+// on its own, both for the serial and the threaded case
+BOOST_AUTO_TEST_CASE(simulatorMatchesSingleBunches)
+{
+    std::vector<StageDefPtr> stages;
+    stages.push_back(createStage("count 40 time 2 bunching 0.7 distribution rect 10 20 5 "
+        "direction cone 30 speed 10 to 50 size 2 to 6 aspect 1 to 2 rotation 20 to 90 gravity 20"));
+    stages.push_back(createStage("count 30 time 1.5 distribution sphere 20 20 20 0.5 "
+        "direction outward 0.5 speed 5 animationFrames 4 animationrate 3 gravity world 10"));
+    stages.push_back(createStage("count 25 time 3 distribution cylinder 10 10 30 2 "
+        "customPath flies 1 2 30 orientation x"));
+    stages.push_back(createStage("count 20 time 2 distribution rect 5 5 5 direction cone 45 "
+        "orientation aimed 4 0.3 speed 60"));
+
+    Emitter emitter;
+
+    // Few and many bunches to cover both code paths
+    std::size_t numBunches[] = { 4, 400 };
+
+    for (std::size_t n = 0; n < 2; ++n)
+    {
+        std::vector<RenderableParticleBunchPtr> bunches;
+        std::vector<RenderableParticleBunchPtr> expected;
+
+        for (std::size_t i = 0; i < numBunches[n]; ++i)
+        {
+            const IStageDef& stage = *stages[i % stages.size()];
+            std::size_t time = 100 + (i * 37) % 1400;
+
+            bunches.push_back(emitter.createBunch(stage, 0, static_cast<int>(i)));
+            expected.push_back(emitter.createBunch(stage, 0, static_cast<int>(i)));
+
+            BOOST_REQUIRE(bunches.back()->update(time));
+            ParticleSimulator::Instance().schedule(bunches.back());
+
+            expected.back()->update(time);
+            expected.back()->simulate();
+        }
+
+        // Don't let the simulator pick up the evaluations of the expected bunches
+        ParticleEvaluationCache::Instance().clear();
+        ParticleSimulator::Instance().flush();
+
+        for (std::size_t i = 0; i < bunches.size(); ++i)
+        {
+            BOOST_REQUIRE(!bunches[i]->needsSimulation());
+            BOOST_REQUIRE_EQUAL(bunches[i]->getNumQuads(), expected[i]->getNumQuads());
+            BOOST_CHECK(bunches[i]->getVertices() == expected[i]->getVertices());
+        }
+    }
+}
+
+// Bunches destroyed before the flush are skipped
+BOOST_AUTO_TEST_CASE(skipDestroyedBunches)
+{
+    StageDefPtr stage = createStage("count 10 time 1");
+    Emitter emitter;
+
+    RenderableParticleBunchPtr bunch = emitter.createBunch(*stage, 0, 1234);
+
+    BOOST_REQUIRE(bunch->update(500));
+    ParticleSimulator::Instance().schedule(bunch);
+    bunch.reset();
+
+    ParticleSimulator::Instance().flush();
+}
@@ -13,10 +13,33 @@
 namespace scene
 {
 
+namespace
+{
+	// Dispatches the nodes visited by the volume traversal to a functor
+	class FunctorWalker :
+		public Graph::Walker
+	{
+		const INode::VisitorFunc& _functor;
+
+	public:
+		FunctorWalker(const INode::VisitorFunc& functor) :
+			_functor(functor)
+		{}
+
+		bool visit(const INodePtr& node)
+		{
+			return _functor(node);
+		}
+	};
+}
+
 SceneGraph::SceneGraph() :
+	_boundsChangedPending(false),
 	_spacePartition(new Octree),
 	_visitedSPNodes(0),
-	_skippedSPNodes(0)
+	_skippedSPNodes(0),
+	_bulkChangeDepth(0),
+	_sceneChangedPending(false)
 {}
 
 SceneGraph::~SceneGraph()
@@ -48,6 +71,14 @@ void SceneGraph::removeSceneObserver(Graph::Observer* observer) {
 }
 
 void SceneGraph::sceneChanged() {
+	// Every node calls this during large undo operations, the observers
+	// are notified once when the bulk change is over
+	if (_bulkChangeDepth > 0)
+	{
+		_sceneChangedPending = true;
+		return;
+	}
+
 	for (ObserverList::iterator i = _sceneObservers.begin(); i != _sceneObservers.end(); ++i) {
 		Graph::Observer* observer = *i;
 		observer->onSceneGraphChange();
@@ -75,8 +106,10 @@ void SceneGraph::setRoot(const INodePtr& newRoot)
 
 	_root = newRoot;
 
-	// Refresh the space partition class
+	// Refresh the space partition class, pending re-links refer to the old one
 	_spacePartition = ISpacePartitionSystemPtr(new Octree);
+	_pendingRelinks.clear();
+	_pendingRelinkSet.clear();
 
 	if (_root != NULL)
 	{
@@ -89,6 +122,16 @@ void SceneGraph::setRoot(const INodePtr& newRoot)
 
 void SceneGraph::boundsChanged()
 {
+    // During large transformations this is called for every node,
+    // the signal is emitted once before the next traversal
+    _boundsChangedPending = true;
+}
+
+void SceneGraph::flushBoundsChanged()
+{
+    if (!_boundsChangedPending) return;
+
+    _boundsChangedPending = false;
     _sigBoundsChanged();
 }
 
@@ -132,6 +175,17 @@ void SceneGraph::nodeBoundsChanged(const scene::INodePtr& node)
 {
 	//assert(_visitedSPNodes == 0); // Disallow this during traversal
 
+	if (_bulkChangeDepth > 0)
+	{
+		// Re-link each node only once, with its final bounds
+		if (_pendingRelinkSet.insert(node.get()).second)
+		{
+			_pendingRelinks.push_back(node);
+		}
+
+		return;
+	}
+
 	if (_spacePartition->unlink(node))
 	{
 		// unlink returned true, so the given node was linked before => re-link it
@@ -139,6 +193,56 @@ void SceneGraph::nodeBoundsChanged(const scene::INodePtr& node)
 	}
 }
 
+void SceneGraph::beginBulkChange()
+{
+	++_bulkChangeDepth;
+}
+
+void SceneGraph::endBulkChange()
+{
+	ASSERT_MESSAGE(_bulkChangeDepth > 0, "endBulkChange() called without beginBulkChange()");
+
+	if (_bulkChangeDepth == 0 || --_bulkChangeDepth > 0) return;
+
+	flushPendingRelinks();
+
+	if (_sceneChangedPending)
+	{
+		_sceneChangedPending = false;
+		sceneChanged();
+	}
+
+	_sigBulkChangeFinished();
+}
+
+bool SceneGraph::inBulkChange() const
+{
+	return _bulkChangeDepth > 0;
+}
+
+sigc::signal<void> SceneGraph::signal_bulkChangeFinished() const
+{
+	return _sigBulkChangeFinished;
+}
+
+void SceneGraph::flushPendingRelinks()
+{
+	if (_pendingRelinks.empty()) return;
+
+	std::vector<INodePtr> relinks;
+	relinks.swap(_pendingRelinks);
+	_pendingRelinkSet.clear();
+
+	for (std::vector<INodePtr>::const_iterator i = relinks.begin(); i != relinks.end(); ++i)
+	{
+		// Nodes erased in the meantime are not linked anymore and stay out
+		if (_spacePartition->unlink(*i))
+		{
+			_spacePartition->link(*i);
+		}
+	}
+}
+
 void SceneGraph::foreachNode(const INode::VisitorFunc& functor)
 {
 	if (!_root) return;
@@ -170,15 +274,17 @@ void SceneGraph::foreachVisibleNode(const INode::VisitorFunc& functor)
 
 void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor)
 {
-	foreachNodeInVolume(volume, functor, true); // visit hidden
+	FunctorWalker walker(functor);
+	foreachNodeInVolume(volume, walker, true); // visit hidden
 }
 
 void SceneGraph::foreachVisibleNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor)
 {
-	foreachNodeInVolume(volume, functor, false); // don't visit hidden
+	FunctorWalker walker(functor);
+	foreachNodeInVolume(volume, walker, false); // don't visit hidden
 }
 
-void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor, bool visitHidden)
+void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, Walker& walker, bool visitHidden)
 {
 	// Acquire the worldAABB() of the scenegraph root - if any node got changed in the graph
 	// the scenegraph's root bounds are marked as "dirty" and the bounds will be re-calculated
@@ -186,37 +292,44 @@ void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, const INode::Visi
 	// changes during traversal so let's call this now. If nothing got changed, this call is very cheap.
 	if (_root != NULL) _root->worldAABB();
 
+	// The space partition must be up to date, even in the middle of a bulk change
+	flushPendingRelinks();
+
+	// Let the observers know about any bounds changes before the traversal
+	flushBoundsChanged();
+
 	// Descend the SpacePartition tree and call the walker for each (partially) visible member
 	ISPNodePtr root = _spacePartition->getRoot();
 
 	_visitedSPNodes = _skippedSPNodes = 0;
 
-	foreachNodeInVolume_r(*root, volume, functor, visitHidden);
+	foreachNodeInVolume_r(*root, volume, walker, visitHidden);
 
 	_visitedSPNodes = _skippedSPNodes = 0;
 }
 
 void SceneGraph::foreachNodeInVolume(const VolumeTest& volume, Walker& walker)
 {
-	// Use a small adaptor lambda to dispatch calls to the walker
-	foreachNodeInVolume(volume, 
-		[&] (const INodePtr& node) { return walker.visit(node); }, 
-		true); // visit hidden
+	foreachNodeInVolume(volume, walker, true); // visit hidden
 }
 
 void SceneGraph::foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& walker)
 {
-	// Use a small adaptor lambda to dispatch calls to the walker
-	foreachNodeInVolume(volume, 
-		[&] (const INodePtr& node) { return walker.visit(node); }, 
-		false); // don't visit hidden
+	foreachNodeInVolume(volume, walker, false); // don't visit hidden
 }
 
 bool SceneGraph::foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& volume, 
-									   const INode::VisitorFunc& functor, bool visitHidden)
+									   Walker& walker, bool visitHidden)
 {
 	_visitedSPNodes++;
 
+	// The walker might take care of this subtree itself
+	if (!walker.visitSPNode(node))
+	{
+		_skippedSPNodes++;
+		return true;
+	}
+
 	// Visit all members
 	const ISPNode::MemberList& members = node.getMembers();
 
@@ -231,7 +344,7 @@ bool SceneGraph::foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& vo
 		}
 
 		// We're done, as soon as the walker returns FALSE
-		if (!functor(*m++))
+		if (!walker.visit(*m++))
 		{
 			return false;
 		}
@@ -250,7 +363,7 @@ bool SceneGraph::foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& vo
 		}
 
 		// Traverse all the children too, enter recursion
-		if (!foreachNodeInVolume_r(**i, volume, functor, visitHidden))
+		if (!foreachNodeInVolume_r(**i, volume, walker, visitHidden))
 		{
 			// The walker returned false somewhere in the recursion depths, propagate this message
 			return false;
@@ -2,6 +2,8 @@
 
 #include <map>
 #include <list>
+#include <set>
+#include <vector>
 #include <sigc++/signal.h>
 
 #include "iscenegraph.h"
@@ -27,6 +29,10 @@ private:
 	ObserverList _sceneObservers;
 
     sigc::signal<void> _sigBoundsChanged;
+    sigc::signal<void> _sigBulkChangeFinished;
+
+	// True if boundsChanged() has been called since the signal has been emitted last
+	bool _boundsChangedPending;
 
 	// The root-element, the scenegraph starts here
 	scene::INodePtr _root;
@@ -37,6 +43,17 @@ private:
 	std::size_t _visitedSPNodes;
 	std::size_t _skippedSPNodes;
 
+	// The number of open bulk changes
+	std::size_t _bulkChangeDepth;
+
+	// True if sceneChanged() has been called during the current bulk change
+	bool _sceneChangedPending;
+
+	// The nodes to re-link in the space partition at the end of the bulk change,
+	// in the order their bounds changed first. The set avoids duplicates.
+	std::vector<INodePtr> _pendingRelinks;
+	std::set<INode*> _pendingRelinkSet;
+
 public:
 	SceneGraph();
 
@@ -55,9 +72,11 @@ public:
 	const INodePtr& root() const;
 	void setRoot(const INodePtr& newRoot);
 
-	// greebo: Emits the "bounds changed" signal to all connected observers
+	// Marks the bounds as changed, the "bounds changed" signal is emitted
+	// to all connected observers on the next flushBoundsChanged() call
 	// Note: these are the WorkZone and the SelectionSystem, AFAIK
 	void boundsChanged();
+	void flushBoundsChanged();
 
     /// Return the boundsChanged signal
     sigc::signal<void> signal_boundsChanged() const;
@@ -67,6 +86,11 @@ public:
 
 	void nodeBoundsChanged(const scene::INodePtr& node);
 
+	void beginBulkChange();
+	void endBulkChange();
+	bool inBulkChange() const;
+	sigc::signal<void> signal_bulkChangeFinished() const;
+
 	// Walker variants
 	void foreachNodeInVolume(const VolumeTest& volume, Walker& walker);
 	void foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& walker);
@@ -79,11 +103,14 @@ public:
 
 	ISpacePartitionSystemPtr getSpacePartition();
 private:
-	void foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor, bool visitHidden);
+	// Re-links the nodes whose bounds changed during the bulk change
+	void flushPendingRelinks();
+
+	void foreachNodeInVolume(const VolumeTest& volume, Walker& walker, bool visitHidden);
 
 	// Recursive method used to descend the SpacePartition tree, returns FALSE if the walker signaled stop
 	bool foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& volume, 
-							   const INode::VisitorFunc& functor, bool visitHidden);
+							   Walker& walker, bool visitHidden);
 };
 typedef boost::shared_ptr<SceneGraph> SceneGraphPtr;
 
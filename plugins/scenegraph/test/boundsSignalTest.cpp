@@ -0,0 +1,223 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE boundsSignalTest
+#include <boost/test/unit_test.hpp>
+
+#include "SceneGraph.h"
+#include "scene/Node.h"
+#include "render/NopVolumeTest.h"
+#include "math/AABB.h"
+
+#include <sigc++/functors/mem_fun.h>
+
+namespace
+{
+	class TestNode :
+		public scene::Node
+	{
+		AABB _localAABB;
+		Type _type;
+
+	public:
+		TestNode(Type type, const AABB& bounds = AABB()) :
+			_localAABB(bounds),
+			_type(type)
+		{}
+
+		void setBounds(const AABB& bounds)
+		{
+			_localAABB = bounds;
+			boundsChanged();
+		}
+
+		const AABB& localAABB() const
+		{
+			return _localAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return _type;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+	};
+	typedef boost::shared_ptr<TestNode> TestNodePtr;
+
+	// Stands in for the selection system, which updates the pivot and
+	// the workzone when the signal is emitted
+	class BoundsObserver :
+		public sigc::trackable
+	{
+		scene::INodePtr _root;
+
+	public:
+		std::size_t emissions;
+		AABB rootBounds;
+
+		BoundsObserver(const scene::INodePtr& root) :
+			_root(root),
+			emissions(0)
+		{}
+
+		void onBoundsChanged()
+		{
+			++emissions;
+			rootBounds = _root->worldAABB();
+		}
+	};
+
+	bool equal(const AABB& a, const AABB& b)
+	{
+		return (a.origin - b.origin).getLengthSquared() < 1e-12 &&
+			   (a.extents - b.extents).getLengthSquared() < 1e-12;
+	}
+
+	struct Fixture
+	{
+		scene::SceneGraphPtr graph;
+		TestNodePtr root;
+		TestNodePtr leaf;
+		BoundsObserver observer;
+
+		Fixture() :
+			graph(new scene::SceneGraph),
+			root(new TestNode(scene::INode::Type::MapRoot)),
+			leaf(new TestNode(scene::INode::Type::Primitive, AABB(Vector3(0, 0, 0), Vector3(16, 16, 16)))),
+			observer(root)
+		{
+			root->setIsRoot(true);
+			graph->setRoot(root);
+			root->addChildNode(leaf);
+
+			graph->signal_boundsChanged().connect(
+				sigc::mem_fun(observer, &BoundsObserver::onBoundsChanged)
+			);
+
+			// Start without anything pending
+			root->worldAABB();
+			graph->flushBoundsChanged();
+			observer.emissions = 0;
+		}
+
+		~Fixture()
+		{
+			graph->setRoot(scene::INodePtr());
+		}
+	};
+}
+
+// The signal is held back while nodes are changing, but the views receive it
+// before they traverse the scene for the next frame
+BOOST_FIXTURE_TEST_CASE(emittedBeforeTraversal, Fixture)
+{
+	AABB newBounds(Vector3(512, 0, 0), Vector3(32, 16, 16));
+
+	leaf->setBounds(newBounds);
+	leaf->setBounds(AABB(Vector3(256, 0, 0), Vector3(16, 16, 16)));
+	leaf->setBounds(newBounds);
+
+	BOOST_CHECK_EQUAL(observer.emissions, 0);
+
+	std::size_t emissionsAtFirstVisit = 0;
+	std::size_t visited = 0;
+
+	render::NopVolumeTest volume;
+
+	graph->foreachNodeInVolume(volume, [&] (const scene::INodePtr& node)->bool
+	{
+		if (visited++ == 0)
+		{
+			emissionsAtFirstVisit = observer.emissions;
+		}
+
+		return true;
+	});
+
+	BOOST_CHECK(visited > 0);
+	BOOST_CHECK_EQUAL(emissionsAtFirstVisit, 1);
+	BOOST_CHECK_EQUAL(observer.emissions, 1);
+
+	// The observer saw the bounds of this frame, not the ones of the last
+	BOOST_CHECK(equal(observer.rootBounds, newBounds));
+
+	// Nothing changed since, the next frame doesn't emit again
+	graph->foreachNodeInVolume(volume, [&] (const scene::INodePtr& node)->bool
+	{
+		return true;
+	});
+
+	BOOST_CHECK_EQUAL(observer.emissions, 1);
+}
+
+// Requesting the workzone flushes the pending signal as well
+BOOST_FIXTURE_TEST_CASE(emittedOnFlush, Fixture)
+{
+	AABB newBounds(Vector3(0, -1024, 0), Vector3(8, 8, 8));
+
+	leaf->setBounds(newBounds);
+	BOOST_CHECK_EQUAL(observer.emissions, 0);
+
+	graph->flushBoundsChanged();
+
+	BOOST_CHECK_EQUAL(observer.emissions, 1);
+	BOOST_CHECK(equal(observer.rootBounds, newBounds));
+
+	graph->flushBoundsChanged();
+	BOOST_CHECK_EQUAL(observer.emissions, 1);
+}
+
+// Observers which only look at the changed node leave its ancestors unevaluated,
+// further changes of the node still need to reach the scene graph
+BOOST_AUTO_TEST_CASE(emittedWithUnevaluatedAncestors)
+{
+	scene::SceneGraphPtr graph(new scene::SceneGraph);
+	TestNodePtr root(new TestNode(scene::INode::Type::MapRoot));
+	TestNodePtr group(new TestNode(scene::INode::Type::Entity));
+	TestNodePtr leaf(new TestNode(scene::INode::Type::Primitive, AABB(Vector3(0, 0, 0), Vector3(8, 8, 8))));
+
+	root->setIsRoot(true);
+	graph->setRoot(root);
+	root->addChildNode(group);
+	group->addChildNode(leaf);
+
+	root->worldAABB();
+	graph->flushBoundsChanged();
+
+	std::size_t emissions = 0;
+
+	graph->signal_boundsChanged().connect([&]
+	{
+		++emissions;
+		leaf->worldAABB(); // evaluates the leaf, but not the group
+	});
+
+	leaf->setBounds(AABB(Vector3(128, 0, 0), Vector3(8, 8, 8)));
+	graph->flushBoundsChanged();
+
+	BOOST_CHECK_EQUAL(emissions, 1);
+
+	leaf->setBounds(AABB(Vector3(256, 0, 0), Vector3(8, 8, 8)));
+
+	render::NopVolumeTest volume;
+
+	graph->foreachNodeInVolume(volume, [&] (const scene::INodePtr& node)->bool
+	{
+		return true;
+	});
+
+	BOOST_CHECK_EQUAL(emissions, 2);
+
+	graph->setRoot(scene::INodePtr());
+}
@@ -0,0 +1,212 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE bulkChangeTest
+#include <boost/test/unit_test.hpp>
+
+#include "SceneGraph.h"
+#include "scene/Node.h"
+#include "math/AABB.h"
+
+#include <boost/bind.hpp>
+
+namespace
+{
+	class TestNode :
+		public scene::Node
+	{
+		AABB _localAABB;
+		Type _type;
+
+	public:
+		std::size_t transformNotifications;
+
+		TestNode(Type type, const AABB& bounds = AABB()) :
+			_localAABB(bounds),
+			_type(type),
+			transformNotifications(0)
+		{
+			setTransformChangedCallback(boost::bind(&TestNode::onTransformChanged, this));
+		}
+
+		void setBounds(const AABB& bounds)
+		{
+			_localAABB = bounds;
+			boundsChanged();
+		}
+
+		const AABB& localAABB() const
+		{
+			return _localAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return _type;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+
+	private:
+		void onTransformChanged()
+		{
+			++transformNotifications;
+		}
+	};
+	typedef boost::shared_ptr<TestNode> TestNodePtr;
+
+	class BulkChangeObserver :
+		public sigc::trackable
+	{
+	public:
+		std::size_t finished;
+
+		BulkChangeObserver() :
+			finished(0)
+		{}
+
+		void onBulkChangeFinished()
+		{
+			++finished;
+		}
+	};
+
+	bool equal(const AABB& a, const AABB& b)
+	{
+		return (a.origin - b.origin).getLengthSquared() < 1e-12 &&
+			   (a.extents - b.extents).getLengthSquared() < 1e-12;
+	}
+
+	// A map root holding an entity with a single brush
+	struct Fixture
+	{
+		scene::SceneGraphPtr graph;
+		TestNodePtr root;
+		TestNodePtr entity;
+		TestNodePtr brush;
+
+		Fixture() :
+			graph(new scene::SceneGraph),
+			root(new TestNode(scene::INode::Type::MapRoot)),
+			entity(new TestNode(scene::INode::Type::Entity)),
+			brush(new TestNode(scene::INode::Type::Primitive, AABB(Vector3(0, 0, 0), Vector3(16, 16, 16))))
+		{
+			root->setIsRoot(true);
+			graph->setRoot(root);
+			root->addChildNode(entity);
+			entity->addChildNode(brush);
+
+			root->worldAABB();
+			brush->transformNotifications = 0;
+		}
+
+		~Fixture()
+		{
+			graph->setRoot(scene::INodePtr());
+		}
+	};
+}
+
+// Undo restores the spawnargs of an entity one by one, the children are only
+// told once until they have been evaluated
+BOOST_FIXTURE_TEST_CASE(transformChangeCoalesced, Fixture)
+{
+	{
+		scene::BulkChange bulkChange(*graph);
+
+		entity->transformChanged();
+		entity->transformChanged();
+		entity->transformChanged();
+
+		BOOST_CHECK_EQUAL(brush->transformNotifications, 1);
+
+		// After an evaluation the next change needs to reach the children again
+		brush->localToWorld();
+		entity->transformChanged();
+
+		BOOST_CHECK_EQUAL(brush->transformNotifications, 2);
+	}
+
+	// Outside of bulk changes every call is passed on
+	entity->transformChanged();
+	entity->transformChanged();
+
+	BOOST_CHECK_EQUAL(brush->transformNotifications, 4);
+}
+
+// A child added in the middle of a bulk change hasn't seen the held back change
+BOOST_FIXTURE_TEST_CASE(childAddedDuringBulkChange, Fixture)
+{
+	TestNodePtr added(new TestNode(scene::INode::Type::Primitive));
+
+	{
+		scene::BulkChange bulkChange(*graph);
+
+		entity->transformChanged();
+
+		entity->addChildNode(added);
+		added->transformNotifications = 0;
+
+		entity->transformChanged();
+	}
+
+	BOOST_CHECK_EQUAL(added->transformNotifications, 1);
+}
+
+// Repeated bounds changes don't leave the ancestors with stale bounds
+BOOST_FIXTURE_TEST_CASE(boundsCorrectAfterBulkChange, Fixture)
+{
+	AABB newBounds(Vector3(-2048, 0, 0), Vector3(8, 8, 8));
+
+	{
+		scene::BulkChange bulkChange(*graph);
+
+		brush->setBounds(AABB(Vector3(512, 0, 0), Vector3(16, 16, 16)));
+		brush->setBounds(AABB(Vector3(1024, 0, 0), Vector3(16, 16, 16)));
+		brush->setBounds(newBounds);
+	}
+
+	BOOST_CHECK(equal(entity->worldAABB(), newBounds));
+	BOOST_CHECK(equal(root->worldAABB(), newBounds));
+
+	// Once evaluated, the next change is passed up again
+	brush->setBounds(AABB(Vector3(0, 0, 0), Vector3(1, 1, 1)));
+	BOOST_CHECK(equal(root->worldAABB(), AABB(Vector3(0, 0, 0), Vector3(1, 1, 1))));
+}
+
+// The signal is emitted when the outermost bulk change is closed
+BOOST_FIXTURE_TEST_CASE(finishedSignal, Fixture)
+{
+	BulkChangeObserver observer;
+
+	graph->signal_bulkChangeFinished().connect(
+		sigc::mem_fun(observer, &BulkChangeObserver::onBulkChangeFinished)
+	);
+
+	BOOST_CHECK(!graph->inBulkChange());
+
+	graph->beginBulkChange();
+	graph->beginBulkChange();
+
+	BOOST_CHECK(graph->inBulkChange());
+
+	graph->endBulkChange();
+
+	BOOST_CHECK(graph->inBulkChange());
+	BOOST_CHECK_EQUAL(observer.finished, 0);
+
+	graph->endBulkChange();
+
+	BOOST_CHECK(!graph->inBulkChange());
+	BOOST_CHECK_EQUAL(observer.finished, 1);
+}
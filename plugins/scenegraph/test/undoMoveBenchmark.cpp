@@ -0,0 +1,518 @@
+#include "SceneGraph.h"
+#include "ispacepartition.h"
+#include "scene/Node.h"
+#include "BasicUndoMemento.h"
+#include "math/AABB.h"
+
+#include "SnapShot.h"
+#include "Operation.h"
+#include "Stack.h"
+#include "StackFiller.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <glibmm/timer.h>
+
+/**
+ * Measures the time needed to undo and redo a rotation of many func_statics,
+ * with and without the scene graph's bulk change the undo system opens around
+ * the snapshot restore. Each entity holds a number of brushes with six faces.
+ *
+ * The test nodes send the notifications the real ones send when their state
+ * is imported: a face tells its brush that its plane and its shader changed
+ * (Face::importState), which marks the brush bounds as changed. The entity
+ * gets its "origin" and "rotation" spawnargs back one by one, each of them
+ * passes a transform change to the child brushes (Doom3Group::updateTransform),
+ * which mark their light lists as dirty (BrushNode::lightsChanged). Nothing is
+ * evaluated before the undo is finished, as in the editor.
+ *
+ * The selection notifications deferred by the selection system are not part
+ * of this measurement. This is not part of the test suite, run
+ * "make undoMoveBenchmark" and execute it manually. The number of entities
+ * can be passed as argument.
+ */
+namespace
+{
+	const std::size_t NUM_FACES = 6;
+	const std::size_t BRUSHES_PER_ENTITY = 8;
+	const int REPEATS = 5;
+
+	class TestBrush;
+
+	// Stands in for a brush face, its state is the distance of its plane
+	class TestFace :
+		public IUndoable
+	{
+		TestBrush& _owner;
+		double _distance;
+
+	public:
+		undo::UndoStackFiller saver;
+
+		TestFace(TestBrush& owner, double distance) :
+			_owner(owner),
+			_distance(distance)
+		{}
+
+		double getDistance() const
+		{
+			return _distance;
+		}
+
+		void setDistance(double distance);
+
+		IUndoMementoPtr exportState() const
+		{
+			return IUndoMementoPtr(new undo::BasicUndoMemento<double>(_distance));
+		}
+
+		void importState(const IUndoMementoPtr& state);
+	};
+
+	class TestBrush :
+		public scene::Node
+	{
+		mutable AABB _localAABB;
+		std::vector<TestFace*> _faces;
+
+	public:
+		// Counts the light list invalidations
+		std::size_t lightsChanged;
+
+		TestBrush(const Vector3& origin) :
+			lightsChanged(0)
+		{
+			// The faces point along +x, -x, +y, -y, +z, -z
+			for (std::size_t i = 0; i < NUM_FACES; ++i)
+			{
+				double sign = i % 2 == 0 ? 1 : -1;
+				_faces.push_back(new TestFace(*this, origin[i / 2] * sign + 8));
+			}
+
+			setTransformChangedCallback(boost::bind(&TestBrush::onLightsChanged, this));
+		}
+
+		~TestBrush()
+		{
+			for (std::size_t i = 0; i < _faces.size(); ++i)
+			{
+				delete _faces[i];
+			}
+		}
+
+		TestFace& getFace(std::size_t index)
+		{
+			return *_faces[index];
+		}
+
+		void translate(const Vector3& translation)
+		{
+			for (std::size_t i = 0; i < NUM_FACES; ++i)
+			{
+				double sign = i % 2 == 0 ? 1 : -1;
+				_faces[i]->setDistance(_faces[i]->getDistance() + translation[i / 2] * sign);
+			}
+		}
+
+		// Brush::planeChanged()
+		void planeChanged()
+		{
+			boundsChanged();
+			onLightsChanged();
+		}
+
+		const AABB& localAABB() const
+		{
+			Vector3 max(_faces[0]->getDistance(), _faces[2]->getDistance(), _faces[4]->getDistance());
+			Vector3 min(-_faces[1]->getDistance(), -_faces[3]->getDistance(), -_faces[5]->getDistance());
+
+			_localAABB = AABB::createFromMinMax(min, max);
+			return _localAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return Type::Primitive;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+
+	private:
+		void onLightsChanged()
+		{
+			++lightsChanged;
+		}
+	};
+	typedef boost::shared_ptr<TestBrush> TestBrushPtr;
+
+	void TestFace::setDistance(double distance)
+	{
+		saver.save(*this);
+		_distance = distance;
+		_owner.planeChanged();
+	}
+
+	void TestFace::importState(const IUndoMementoPtr& state)
+	{
+		saver.save(*this);
+		_distance = std::static_pointer_cast<undo::BasicUndoMemento<double> >(state)->data();
+
+		// planeChanged() and shaderChanged() both end up in Brush::planeChanged()
+		_owner.planeChanged();
+		_owner.planeChanged();
+	}
+
+	// Stands in for a spawnarg of an entity which passes a transform change on
+	class TestKey :
+		public IUndoable
+	{
+		scene::Node& _owner;
+		double _value;
+
+	public:
+		undo::UndoStackFiller saver;
+
+		TestKey(scene::Node& owner) :
+			_owner(owner),
+			_value(0)
+		{}
+
+		double getValue() const
+		{
+			return _value;
+		}
+
+		void setValue(double value)
+		{
+			saver.save(*this);
+			_value = value;
+			_owner.transformChanged();
+		}
+
+		IUndoMementoPtr exportState() const
+		{
+			return IUndoMementoPtr(new undo::BasicUndoMemento<double>(_value));
+		}
+
+		void importState(const IUndoMementoPtr& state)
+		{
+			saver.save(*this);
+			_value = std::static_pointer_cast<undo::BasicUndoMemento<double> >(state)->data();
+			_owner.transformChanged();
+		}
+	};
+
+	class TestEntity :
+		public scene::Node
+	{
+		AABB _emptyAABB;
+
+	public:
+		TestKey origin;
+		TestKey rotation;
+
+		TestEntity() :
+			origin(*this),
+			rotation(*this)
+		{}
+
+		const AABB& localAABB() const
+		{
+			return _emptyAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return Type::Entity;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+	};
+	typedef boost::shared_ptr<TestEntity> TestEntityPtr;
+
+	class TestRoot :
+		public scene::Node
+	{
+		AABB _emptyAABB;
+
+	public:
+		const AABB& localAABB() const
+		{
+			return _emptyAABB;
+		}
+
+		Type getNodeType() const
+		{
+			return Type::MapRoot;
+		}
+
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const
+		{}
+
+		void setRenderSystem(const RenderSystemPtr& renderSystem)
+		{}
+
+		bool isHighlighted() const
+		{
+			return false;
+		}
+	};
+
+	// Mirrors the undo and redo of the RadiantUndoSystem
+	class History
+	{
+		scene::Graph& _graph;
+		std::vector<undo::UndoStackFiller*> _savers;
+
+	public:
+		undo::UndoStack undoStack;
+		undo::UndoStack redoStack;
+		bool bulkChange;
+
+		History(scene::Graph& graph) :
+			_graph(graph),
+			bulkChange(true)
+		{}
+
+		void addSaver(undo::UndoStackFiller& saver)
+		{
+			_savers.push_back(&saver);
+		}
+
+		void start()
+		{
+			redoStack.clear();
+			undoStack.start("unnamedCommand");
+			setStack(&undoStack);
+		}
+
+		void finish(const std::string& command)
+		{
+			undoStack.finish(command);
+			setStack(NULL);
+		}
+
+		void undo()
+		{
+			restore(undoStack, redoStack);
+		}
+
+		void redo()
+		{
+			restore(redoStack, undoStack);
+		}
+
+	private:
+		void setStack(undo::UndoStack* stack)
+		{
+			for (std::size_t i = 0; i < _savers.size(); ++i)
+			{
+				_savers[i]->setStack(stack);
+			}
+		}
+
+		void restore(undo::UndoStack& from, undo::UndoStack& to)
+		{
+			const undo::OperationPtr& operation = from.back();
+
+			to.start("unnamedCommand");
+			setStack(&to);
+
+			if (bulkChange) _graph.beginBulkChange();
+
+			operation->restoreSnapshot();
+			to.finish(operation->getName());
+			from.pop_back();
+
+			_graph.sceneChanged();
+
+			if (bulkChange) _graph.endBulkChange();
+
+			setStack(NULL);
+		}
+	};
+
+	std::size_t countMembers(const scene::ISPNode& node)
+	{
+		std::size_t count = node.getMembers().size();
+
+		for (scene::ISPNode::NodeList::const_iterator i = node.getChildNodes().begin();
+			 i != node.getChildNodes().end(); ++i)
+		{
+			count += countMembers(**i);
+		}
+
+		return count;
+	}
+
+	struct Result
+	{
+		double undoTime;
+		double redoTime;
+		std::size_t lightsChanged;
+		AABB bounds;
+		std::size_t linkedNodes;
+	};
+
+	Result run(std::size_t numEntities, bool bulkChange)
+	{
+		scene::SceneGraphPtr graph(new scene::SceneGraph);
+		History history(*graph);
+
+		history.bulkChange = bulkChange;
+
+		scene::INodePtr root(new TestRoot);
+		root->setIsRoot(true);
+		graph->setRoot(root);
+
+		std::srand(1);
+
+		std::vector<TestEntityPtr> entities;
+		std::vector<TestBrushPtr> brushes;
+
+		for (std::size_t e = 0; e < numEntities; ++e)
+		{
+			TestEntityPtr entity(new TestEntity);
+
+			history.addSaver(entity->origin.saver);
+			history.addSaver(entity->rotation.saver);
+
+			root->addChildNode(entity);
+			entities.push_back(entity);
+
+			Vector3 origin(std::rand() % 16384 - 8192, std::rand() % 16384 - 8192, std::rand() % 2048 - 1024);
+
+			for (std::size_t i = 0; i < BRUSHES_PER_ENTITY; ++i)
+			{
+				TestBrushPtr brush(new TestBrush(origin + Vector3(i * 32.0, 0, 0)));
+
+				for (std::size_t f = 0; f < NUM_FACES; ++f)
+				{
+					history.addSaver(brush->getFace(f).saver);
+				}
+
+				entity->addChildNode(brush);
+				brushes.push_back(brush);
+			}
+		}
+
+		root->worldAABB();
+
+		// Rotate and move everything by a large distance, so that all brushes change their octree node
+		history.start();
+
+		for (std::size_t i = 0; i < entities.size(); ++i)
+		{
+			entities[i]->origin.setValue(entities[i]->origin.getValue() + 2048);
+			entities[i]->rotation.setValue(entities[i]->rotation.getValue() + 90);
+		}
+
+		for (std::size_t i = 0; i < brushes.size(); ++i)
+		{
+			brushes[i]->translate(Vector3(2048, 1024, 512));
+		}
+
+		history.finish("rotateSelected");
+		root->worldAABB();
+
+		Result result;
+		result.undoTime = result.redoTime = 0;
+
+		for (std::size_t i = 0; i < brushes.size(); ++i)
+		{
+			brushes[i]->lightsChanged = 0;
+		}
+
+		Glib::Timer timer;
+
+		for (int r = 0; r < REPEATS; ++r)
+		{
+			timer.start();
+			history.undo();
+			root->worldAABB(); // the next frame evaluates what is still pending
+			timer.stop();
+			result.undoTime += timer.elapsed();
+
+			timer.start();
+			history.redo();
+			root->worldAABB();
+			timer.stop();
+			result.redoTime += timer.elapsed();
+		}
+
+		result.lightsChanged = 0;
+
+		for (std::size_t i = 0; i < brushes.size(); ++i)
+		{
+			result.lightsChanged += brushes[i]->lightsChanged;
+		}
+
+		result.bounds = root->worldAABB();
+		result.linkedNodes = countMembers(*graph->getSpacePartition()->getRoot());
+
+		graph->setRoot(scene::INodePtr());
+
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::size_t numEntities = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 2500;
+
+	Result single = run(numEntities, false);
+	Result bulk = run(numEntities, true);
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Undo and redo of a rotation of " << numEntities << " entities with "
+			  << BRUSHES_PER_ENTITY << " brushes each, average of " << REPEATS << " runs" << std::endl;
+
+	std::cout << "Without bulk change: undo " << single.undoTime * 1000 / REPEATS << " ms, redo "
+			  << single.redoTime * 1000 / REPEATS << " ms, "
+			  << single.lightsChanged / REPEATS << " light list updates per undo and redo pair" << std::endl;
+
+	std::cout << "With bulk change:    undo " << bulk.undoTime * 1000 / REPEATS << " ms, redo "
+			  << bulk.redoTime * 1000 / REPEATS << " ms, "
+			  << bulk.lightsChanged / REPEATS << " light list updates per undo and redo pair" << std::endl;
+
+	// Both ways have to end up with the same scene
+	if (single.bounds.getOrigin() != bulk.bounds.getOrigin() ||
+		single.bounds.getExtents() != bulk.bounds.getExtents() ||
+		single.linkedNodes != bulk.linkedNodes)
+	{
+		std::cout << "Error: the scenes differ after undo and redo" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE volumeTraversalTest
+#include <boost/test/unit_test.hpp>
+
+#include "SceneGraph.h"
+#include "ispacepartition.h"
+#include "scene/Node.h"
+#include "render/NopVolumeTest.h"
+#include "math/AABB.h"
+
+#include <vector>
+
+namespace
+{
+	class TestNode :
+		public scene::Node
+	{
+		AABB _localAABB;
+		Type _type;
+
+	public:
+		TestNode(Type type, const AABB& bounds = AABB()) :
+			_localAABB(bounds),
+			_type(type)
+		{}
+
+		void setBounds(const AABB& bounds)
+		{
+			_localAABB = bounds;
+			boundsChanged();
+		}
+
+		const AABB& localAABB() const { return _localAABB; }
+		Type getNodeType() const { return _type; }
+		void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const {}
+		void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const {}
+		void setRenderSystem(const RenderSystemPtr& renderSystem) {}
+		bool isHighlighted() const { return false; }
+	};
+	typedef boost::shared_ptr<TestNode> TestNodePtr;
+
+	// Records the visited nodes along with the bounds of the space
+	// partition node they have been found in
+	class RecordingWalker :
+		public scene::Graph::Walker
+	{
+		bool _enterSPNodes;
+		AABB _currentBounds;
+
+	public:
+		std::vector<scene::INodePtr> nodes;
+		std::vector<AABB> spNodeBounds;
+		std::size_t numSPNodes;
+
+		RecordingWalker(bool enterSPNodes) :
+			_enterSPNodes(enterSPNodes),
+			numSPNodes(0)
+		{}
+
+		bool visit(const scene::INodePtr& node)
+		{
+			nodes.push_back(node);
+			spNodeBounds.push_back(_currentBounds);
+			return true;
+		}
+
+		// The members of a space partition node are visited before its children
+		bool visitSPNode(const scene::ISPNode& node)
+		{
+			++numSPNodes;
+			_currentBounds = node.getBounds();
+			return _enterSPNodes;
+		}
+	};
+
+	// A map root holding an entity with a single brush
+	struct Fixture
+	{
+		scene::SceneGraphPtr graph;
+		TestNodePtr root;
+		TestNodePtr entity;
+		TestNodePtr brush;
+		render::NopVolumeTest volume;
+
+		Fixture() :
+			graph(new scene::SceneGraph),
+			root(new TestNode(scene::INode::Type::MapRoot)),
+			entity(new TestNode(scene::INode::Type::Entity)),
+			brush(new TestNode(scene::INode::Type::Primitive, AABB(Vector3(0, 0, 0), Vector3(16, 16, 16))))
+		{
+			root->setIsRoot(true);
+			graph->setRoot(root);
+			root->addChildNode(entity);
+			entity->addChildNode(brush);
+
+			root->worldAABB();
+		}
+
+		~Fixture()
+		{
+			graph->setRoot(scene::INodePtr());
+		}
+
+		// Returns the index of the brush in the visited nodes, -1 if not visited
+		int findBrush(const RecordingWalker& walker) const
+		{
+			for (std::size_t i = 0; i < walker.nodes.size(); ++i)
+			{
+				if (walker.nodes[i] == brush) return static_cast<int>(i);
+			}
+
+			return -1;
+		}
+	};
+}
+
+// Every space partition node is passed to the walker before its members
+BOOST_FIXTURE_TEST_CASE(spNodesVisited, Fixture)
+{
+	RecordingWalker walker(true);
+	graph->foreachVisibleNodeInVolume(volume, walker);
+
+	BOOST_CHECK(walker.numSPNodes > 0);
+	BOOST_REQUIRE(findBrush(walker) >= 0);
+	BOOST_CHECK(walker.spNodeBounds[findBrush(walker)].contains(brush->worldAABB()));
+}
+
+// Space partition nodes refused by the walker are not descended into
+BOOST_FIXTURE_TEST_CASE(spNodesSkipped, Fixture)
+{
+	RecordingWalker walker(false);
+	graph->foreachVisibleNodeInVolume(volume, walker);
+
+	BOOST_CHECK_EQUAL(walker.numSPNodes, 1);
+	BOOST_CHECK(walker.nodes.empty());
+}
+
+// Nodes moved during a bulk change are found in the right place when
+// the scene is traversed before the bulk change is over
+BOOST_FIXTURE_TEST_CASE(nodesRelinkedDuringBulkChange, Fixture)
+{
+	scene::BulkChange bulkChange(*graph);
+
+	AABB newBounds(Vector3(4096, 0, 0), Vector3(16, 16, 16));
+	brush->setBounds(newBounds);
+
+	RecordingWalker walker(true);
+	graph->foreachVisibleNodeInVolume(volume, walker);
+
+	BOOST_REQUIRE(findBrush(walker) >= 0);
+	BOOST_CHECK(walker.spNodeBounds[findBrush(walker)].contains(newBounds));
+}
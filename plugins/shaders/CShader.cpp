@@ -23,7 +23,7 @@ namespace shaders
 /* Constructor. Sets the name and the ShaderDefinition to use.
  */
 CShader::CShader(const std::string& name, const ShaderDefinition& definition) :
-	_template(definition.shaderTemplate),
+	_template(definition.getTemplate()),
 	_fileName(definition.filename),
 	_name(name),
 	m_bInUse(false),
@@ -1,5 +1,6 @@
 #include "Doom3ShaderLayer.h"
 #include "Doom3ShaderSystem.h"
+#include "ShaderExpression.h"
 
 namespace shaders
 {
@@ -81,6 +82,8 @@ const IShaderExpressionPtr Doom3ShaderLayer::NULL_EXPRESSION;
 Doom3ShaderLayer::Doom3ShaderLayer(ShaderTemplate& material, ShaderLayer::Type type, const NamedBindablePtr& btex)
 :	_material(material),
 	_registers(NUM_RESERVED_REGISTERS),
+	_program(_registers),
+	_numCompiledExpressions(0),
 	_condition(REG_ONE),
 	_bindableTex(btex),
 	_type(type),
@@ -120,6 +123,18 @@ Doom3ShaderLayer::Doom3ShaderLayer(ShaderTemplate& material, ShaderLayer::Type t
 	_texGenParams[0] = _texGenParams[1] = _texGenParams[2] = 0;
 }
 
+void Doom3ShaderLayer::compileExpressions()
+{
+	_program.clear();
+
+	for (Expressions::const_iterator i = _expressions.begin(); i != _expressions.end(); ++i)
+	{
+		ShaderExpression::compileLinked(*i, _program);
+	}
+
+	_numCompiledExpressions = _expressions.size();
+}
+
 TexturePtr Doom3ShaderLayer::getTexture() const
 {
     // Bind texture to GL if needed
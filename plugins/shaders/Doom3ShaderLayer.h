@@ -5,6 +5,7 @@
 
 #include "math/Vector4.h"
 #include "NamedBindable.h"
+#include "ExpressionProgram.h"
 
 namespace shaders
 {
@@ -43,6 +44,12 @@ private:
     typedef std::vector<IShaderExpressionPtr> Expressions;
     Expressions _expressions;
 
+    // The expressions compiled into register operations
+    ExpressionProgram _program;
+
+    // The number of expressions in the program, it is re-compiled when more are added
+    std::size_t _numCompiledExpressions;
+
     static const IShaderExpressionPtr NULL_EXPRESSION;
 
     // The condition register for this stage. Points to a register to be interpreted as bool.
@@ -142,20 +149,52 @@ public:
 
     void evaluateExpressions(std::size_t time) 
     {
-        for (Expressions::iterator i = _expressions.begin(); i != _expressions.end(); ++i)
+        if (_numCompiledExpressions != _expressions.size())
         {
-            (*i)->evaluate(time);
+            compileExpressions();
         }
+
+        _program.execute(time, NULL);
     }
 
     void evaluateExpressions(std::size_t time, const IRenderEntity& entity)
+    {
+        if (_numCompiledExpressions != _expressions.size())
+        {
+            compileExpressions();
+        }
+
+        _program.execute(time, &entity);
+    }
+
+    bool dependsOnEntity() const
+    {
+        // Not compiled yet, be on the safe side
+        if (_numCompiledExpressions != _expressions.size())
+        {
+            return true;
+        }
+
+        return _program.dependsOnEntity();
+    }
+
+    // Compiles the expressions of this stage, called when the material has been parsed
+    void compileExpressions();
+
+    // Evaluates the expression trees without the compiled program, used for comparison
+    void interpretExpressions(std::size_t time)
     {
         for (Expressions::iterator i = _expressions.begin(); i != _expressions.end(); ++i)
         {
-            (*i)->evaluate(time, entity);
+            (*i)->evaluate(time);
         }
     }
 
+    const ExpressionProgram& getExpressionProgram() const
+    {
+        return _program;
+    }
+
     /**
      * \brief
      * Set the bindable texture object.
@@ -15,9 +15,9 @@
 #include "ShaderDefinition.h"
 #include "ShaderFileLoader.h"
 #include "ShaderExpression.h"
-
 #include "debugging/ScopedDebugTimer.h"
 
+
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/bind.hpp>
 
@@ -50,6 +50,7 @@ void Doom3ShaderSystem::construct()
 {
 	_library = ShaderLibraryPtr(new ShaderLibrary());
 	_textureManager = GLTextureManagerPtr(new GLTextureManager());
+	_textureManager->signal_texturesStreamed().connect(_sigTexturesStreamed.make_slot());
 
 	// Register this class as VFS observer
 	GlobalFileSystem().addObserver(*this);
@@ -90,10 +91,8 @@ void Doom3ShaderSystem::loadMaterialFiles()
 
 	// Load each file from the global filesystem
 	ShaderFileLoader loader(sPath);
-	{
-		ScopedDebugTimer timer("ShaderFiles parsed: ");
-		GlobalFileSystem().forEachFile(sPath, extension, loader, 0);
-	}
+	GlobalFileSystem().forEachFile(sPath, extension, loader, 0);
+	loader.parseFiles();
 
 	rMessage() << _library->getNumShaders() << " shaders found." << std::endl;
 }
@@ -268,6 +267,26 @@ TexturePtr Doom3ShaderSystem::loadTextureFromFile(const std::string& filename,
 	return _library->loadTextureFromFile(filename, moduleNames);
 }
 
+void Doom3ShaderSystem::uploadStreamedTextures()
+{
+	_textureManager->uploadStreamedTextures();
+}
+
+sigc::signal<void> Doom3ShaderSystem::signal_texturesStreamed() const
+{
+	return _sigTexturesStreamed;
+}
+
+void Doom3ShaderSystem::markTexturesVisible(const std::vector<GLuint>& textureNums)
+{
+	_textureManager->markTexturesVisible(textureNums);
+}
+
+TextureMemoryStats Doom3ShaderSystem::getTextureMemoryStats() const
+{
+	return _textureManager->getMemoryStats();
+}
+
 IShaderExpressionPtr Doom3ShaderSystem::createShaderExpressionFromString(const std::string& exprStr)
 {
 	return ShaderExpression::createFromString(exprStr);
@@ -301,6 +320,116 @@ void Doom3ShaderSystem::refreshShadersCmd(const cmd::ArgumentList& args)
 	GlobalMainFrame().updateAllWindows();
 }
 
+void Doom3ShaderSystem::printTextureMemoryStatsCmd(const cmd::ArgumentList& args)
+{
+	TextureMemoryStats stats = getTextureMemoryStats();
+
+	rMessage() << "Texture memory: " << (stats.currentBytes >> 20) << " MB, peak "
+		<< (stats.peakBytes >> 20) << " MB, budget ";
+
+	if (stats.budgetBytes > 0)
+	{
+		rMessage() << (stats.budgetBytes >> 20) << " MB";
+	}
+	else
+	{
+		rMessage() << "unlimited";
+	}
+
+	rMessage() << std::endl << "Textures: " << stats.numTextures << ", reduced to a smaller mipmap: "
+		<< stats.numReduced << std::endl;
+}
+
+namespace
+{
+	// Gathers the stages of the materials defined in files containing the filter string
+	class StageCollector
+	{
+		ShaderLibrary& _library;
+		std::string _filter;
+
+	public:
+		std::vector<Doom3ShaderLayerPtr> stages;
+
+		StageCollector(ShaderLibrary& library, const std::string& filter) :
+			_library(library),
+			_filter(filter)
+		{}
+
+		void operator()(const std::string& name)
+		{
+			ShaderDefinition& def = _library.getDefinition(name);
+
+			if (!_filter.empty() && def.filename.find(_filter) == std::string::npos)
+			{
+				return;
+			}
+
+			const ShaderTemplate::Layers& layers = def.getTemplate()->getLayers();
+			stages.insert(stages.end(), layers.begin(), layers.end());
+		}
+	};
+}
+
+void Doom3ShaderSystem::benchmarkShaderExpressionsCmd(const cmd::ArgumentList& args)
+{
+	// Simulate a number of frames with each stage being rendered several times per frame
+	const std::size_t NUM_FRAMES = 1000;
+	const std::size_t EVALUATIONS_PER_FRAME = 8;
+	const std::size_t FRAME_MSECS = 16;
+
+	StageCollector collector(*_library, args.empty() ? "" : args[0].getString());
+	_library->foreachShaderName(boost::ref(collector));
+
+	std::vector<Doom3ShaderLayerPtr>& stages = collector.stages;
+
+	std::size_t numOps = 0;
+
+	for (std::size_t i = 0; i < stages.size(); ++i)
+	{
+		numOps += stages[i]->getExpressionProgram().getNumOps();
+	}
+
+	timeval start, end;
+
+	gettimeofday(&start, NULL);
+
+	for (std::size_t frame = 0; frame < NUM_FRAMES; ++frame)
+	{
+		for (std::size_t n = 0; n < EVALUATIONS_PER_FRAME; ++n)
+		{
+			for (std::size_t i = 0; i < stages.size(); ++i)
+			{
+				stages[i]->interpretExpressions(frame * FRAME_MSECS);
+			}
+		}
+	}
+
+	gettimeofday(&end, NULL);
+	double treeSeconds = end - start;
+
+	gettimeofday(&start, NULL);
+
+	for (std::size_t frame = 0; frame < NUM_FRAMES; ++frame)
+	{
+		for (std::size_t n = 0; n < EVALUATIONS_PER_FRAME; ++n)
+		{
+			for (std::size_t i = 0; i < stages.size(); ++i)
+			{
+				stages[i]->evaluateExpressions(frame * FRAME_MSECS);
+			}
+		}
+	}
+
+	gettimeofday(&end, NULL);
+	double programSeconds = end - start;
+
+	rMessage() << "Shader expressions: " << stages.size() << " stages, " << numOps
+		<< " compiled operations, " << NUM_FRAMES << " frames" << std::endl;
+	rMessage() << "Expression trees: " << treeSeconds << " seconds, compiled: "
+		<< programSeconds << " seconds" << std::endl;
+}
+
 const std::string& Doom3ShaderSystem::getName() const {
 	static std::string _name(MODULE_SHADERSYSTEM);
 	return _name;
@@ -326,6 +455,10 @@ void Doom3ShaderSystem::initialiseModule(const ApplicationContext& ctx)
 	GlobalCommandSystem().addCommand("RefreshShaders", boost::bind(&Doom3ShaderSystem::refreshShadersCmd, this, _1));
 	GlobalEventManager().addCommand("RefreshShaders", "RefreshShaders");
 
+	GlobalCommandSystem().addCommand("TextureMemoryStats", boost::bind(&Doom3ShaderSystem::printTextureMemoryStatsCmd, this, _1));
+	GlobalCommandSystem().addCommand("BenchmarkShaderExpressions",
+		boost::bind(&Doom3ShaderSystem::benchmarkShaderExpressionsCmd, this, _1), cmd::ARGTYPE_STRING|cmd::ARGTYPE_OPTIONAL);
+
 	construct();
 	realise();
 
@@ -499,6 +632,9 @@ void Doom3ShaderSystem::shutdownModule()
 {
 	rMessage() << "Doom3ShaderSystem::shutdownModule called\n";
 
+	// Don't leave any texture loads running in the thread pool
+	_textureManager->cancelStreaming();
+
 	destroy();
 	unrealise();
 }
@@ -47,6 +47,9 @@ class Doom3ShaderSystem
 	// notified upon realisation of this class.
 	ModuleObservers _observers;
 
+	// Forwards the texture manager's notifications
+	sigc::signal<void> _sigTexturesStreamed;
+
 public:
 
 	// Constructor, allocates the library
@@ -107,6 +110,12 @@ public:
 	TexturePtr loadTextureFromFile(const std::string& filename,
 								   const std::string& moduleNames = "GDK");
 
+	void uploadStreamedTextures();
+	sigc::signal<void> signal_texturesStreamed() const;
+
+	void markTexturesVisible(const std::vector<GLuint>& textureNums);
+	TextureMemoryStats getTextureMemoryStats() const;
+
 	ShaderLibrary& getLibrary();
 	GLTextureManager& getTextureManager();
 
@@ -124,6 +133,13 @@ public:
 	// The "Flush & Reload Shaders" command target
 	void refreshShadersCmd(const cmd::ArgumentList& args);
 
+	// Prints the texture memory statistics to the console
+	void printTextureMemoryStatsCmd(const cmd::ArgumentList& args);
+
+	// Compares the compiled shader expressions against the expression trees,
+	// the optional argument restricts the test to the matching material files
+	void benchmarkShaderExpressionsCmd(const cmd::ArgumentList& args);
+
 public:
 
 	/** Load the shader definitions from the MTR files
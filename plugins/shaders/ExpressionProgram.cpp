@@ -0,0 +1,277 @@
+#include "ExpressionProgram.h"
+
+#include "irender.h"
+#include "TableDefinition.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+namespace shaders
+{
+
+ExpressionProgram::ExpressionProgram(Registers& registers) :
+	_registers(&registers),
+	_timeRegister(0),
+	_cachedTime(0),
+	_cacheValid(false)
+{}
+
+void ExpressionProgram::clear()
+{
+	_timeOps.clear();
+	_entityOps.clear();
+	_dependencies.clear();
+	_timeRegister = 0;
+	_cacheValid = false;
+}
+
+bool ExpressionProgram::empty() const
+{
+	return _timeOps.empty() && _entityOps.empty();
+}
+
+bool ExpressionProgram::dependsOnEntity() const
+{
+	// Expressions evaluated through their virtual interface are counted in, too
+	return !_entityOps.empty();
+}
+
+std::size_t ExpressionProgram::getNumOps() const
+{
+	return _timeOps.size() + _entityOps.size();
+}
+
+void ExpressionProgram::execute(std::size_t time, const IRenderEntity* entity)
+{
+	// The time-dependent values are the same for all entities rendered in a frame
+	if (!_cacheValid || time != _cachedTime)
+	{
+		executeOps(_timeOps, time, entity);
+
+		_cachedTime = time;
+		_cacheValid = true;
+	}
+
+	executeOps(_entityOps, time, entity);
+}
+
+void ExpressionProgram::executeOps(const Ops& ops, std::size_t time, const IRenderEntity* entity)
+{
+	Registers& r = *_registers;
+
+	for (Ops::const_iterator i = ops.begin(); i != ops.end(); ++i)
+	{
+		const Op& op = *i;
+
+		switch (op.code)
+		{
+		case OP_ADD:
+			r[op.dest] = r[op.a] + r[op.b];
+			break;
+		case OP_SUBTRACT:
+			r[op.dest] = r[op.a] - r[op.b];
+			break;
+		case OP_MULTIPLY:
+			r[op.dest] = r[op.a] * r[op.b];
+			break;
+		case OP_TABLE:
+			r[op.dest] = op.table->getValue(r[op.a]);
+			break;
+		case OP_TIME:
+			r[op.dest] = time / 1000.0f; // convert msecs to secs
+			break;
+		case OP_SHADERPARM:
+			// parmNN is 0 without entity
+			r[op.dest] = entity != NULL ? entity->getShaderParm(static_cast<int>(op.a)) : 0.0f;
+			break;
+		case OP_MOVE:
+			r[op.dest] = r[op.a];
+			break;
+		case OP_EXPRESSION:
+			r[op.dest] = entity != NULL ? op.expression->getValue(time, *entity) : op.expression->getValue(time);
+			break;
+		case OP_EVALUATE:
+			if (entity != NULL)
+			{
+				op.expression->evaluate(time, *entity);
+			}
+			else
+			{
+				op.expression->evaluate(time);
+			}
+			break;
+		default:
+			r[op.dest] = applyBinary(op.code, r[op.a], r[op.b]);
+			break;
+		};
+	}
+}
+
+float ExpressionProgram::applyBinary(OpCode code, float a, float b)
+{
+	switch (code)
+	{
+	case OP_ADD:			return a + b;
+	case OP_SUBTRACT:		return a - b;
+	case OP_MULTIPLY:		return a * b;
+	case OP_DIVIDE:			return a / b;
+	case OP_MODULO:			return fmod(a, b);
+	case OP_LESS:			return a < b ? 1.0f : 0;
+	case OP_LESS_EQUAL:		return a <= b ? 1.0f : 0;
+	case OP_GREATER:		return a > b ? 1.0f : 0;
+	case OP_GREATER_EQUAL:	return a >= b ? 1.0f : 0;
+	case OP_EQUAL:			return a == b ? 1.0f : 0;
+	case OP_NOT_EQUAL:		return a != b ? 1.0f : 0;
+	case OP_AND:			return (a != 0 && b != 0) ? 1.0f : 0;
+	case OP_OR:				return (a != 0 || b != 0) ? 1.0f : 0;
+	default:
+		assert(false);
+		return 0;
+	};
+}
+
+std::size_t ExpressionProgram::constant(float value)
+{
+	// Re-use the reserved registers
+	if (value == 0)
+	{
+		return REG_ZERO;
+	}
+	else if (value == 1)
+	{
+		return REG_ONE;
+	}
+
+	return allocate(value, CONSTANT);
+}
+
+std::size_t ExpressionProgram::time()
+{
+	if (_timeRegister == 0)
+	{
+		_timeRegister = allocate(0, TIME);
+		emit(TIME, OP_TIME, _timeRegister);
+	}
+
+	return _timeRegister;
+}
+
+std::size_t ExpressionProgram::shaderParm(int parmNum)
+{
+	std::size_t dest = allocate(0, ENTITY);
+	emit(ENTITY, OP_SHADERPARM, dest, static_cast<std::size_t>(parmNum));
+
+	return dest;
+}
+
+std::size_t ExpressionProgram::binary(OpCode code, std::size_t a, std::size_t b)
+{
+	Dependency dependency = std::max(getDependency(a), getDependency(b));
+
+	if (dependency == CONSTANT)
+	{
+		// Fold the constants
+		return constant(applyBinary(code, (*_registers)[a], (*_registers)[b]));
+	}
+
+	std::size_t dest = allocate(0, dependency);
+	emit(dependency, code, dest, a, b);
+
+	return dest;
+}
+
+std::size_t ExpressionProgram::tableLookup(TableDefinition& table, std::size_t index)
+{
+	Dependency dependency = getDependency(index);
+
+	if (dependency == CONSTANT)
+	{
+		return constant(table.getValue((*_registers)[index]));
+	}
+
+	std::size_t dest = allocate(0, dependency);
+	emit(dependency, OP_TABLE, dest, index, 0, &table);
+
+	return dest;
+}
+
+std::size_t ExpressionProgram::expression(IShaderExpression& expr)
+{
+	// Nothing is known about the expression, evaluate it every time
+	std::size_t dest = allocate(0, ENTITY);
+	emit(ENTITY, OP_EXPRESSION, dest, 0, 0, NULL, &expr);
+
+	return dest;
+}
+
+void ExpressionProgram::link(std::size_t dest, std::size_t value)
+{
+	if (dest == value) return;
+
+	Dependency dependency = getDependency(value);
+
+	if (dependency == CONSTANT)
+	{
+		// Constant results are written once
+		(*_registers)[dest] = (*_registers)[value];
+		return;
+	}
+
+	if (_dependencies.size() <= dest)
+	{
+		_dependencies.resize(dest + 1, CONSTANT);
+	}
+
+	_dependencies[dest] = static_cast<unsigned char>(dependency);
+
+	Ops& ops = dependency == TIME ? _timeOps : _entityOps;
+
+	// The value is usually the result of the last operation, which can write
+	// to the linked register directly. The shared time register is an exception.
+	if (!ops.empty() && ops.back().dest == value && value != _timeRegister)
+	{
+		ops.back().dest = dest;
+		return;
+	}
+
+	emit(dependency, OP_MOVE, dest, value);
+}
+
+void ExpressionProgram::evaluate(IShaderExpression& expr)
+{
+	emit(ENTITY, OP_EVALUATE, 0, 0, 0, NULL, &expr);
+}
+
+std::size_t ExpressionProgram::allocate(float value, Dependency dependency)
+{
+	_registers->push_back(value);
+
+	std::size_t reg = _registers->size() - 1;
+
+	_dependencies.resize(_registers->size(), CONSTANT);
+	_dependencies[reg] = static_cast<unsigned char>(dependency);
+
+	return reg;
+}
+
+ExpressionProgram::Dependency ExpressionProgram::getDependency(std::size_t reg) const
+{
+	return reg < _dependencies.size() ? static_cast<Dependency>(_dependencies[reg]) : CONSTANT;
+}
+
+void ExpressionProgram::emit(Dependency dependency, OpCode code, std::size_t dest, std::size_t a, std::size_t b,
+							 TableDefinition* table, IShaderExpression* expression)
+{
+	Op op;
+	op.code = code;
+	op.dest = dest;
+	op.a = a;
+	op.b = b;
+	op.table = table;
+	op.expression = expression;
+
+	(dependency == TIME ? _timeOps : _entityOps).push_back(op);
+}
+
+} // namespace
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include "ishaderexpression.h"
+
+class IRenderEntity;
+
+namespace shaders
+{
+
+class TableDefinition;
+
+/**
+ * The shader expressions of a material stage, compiled into a flat list of
+ * register operations. The operations read and write the register array of
+ * the stage, temporary values and constants are stored in registers of
+ * their own which are appended to the array during compilation.
+ *
+ * Subexpressions made of constants are folded at compile time. Operations
+ * depending on the time only are kept apart from the ones depending on the
+ * render entity, they are executed once per time value and re-used for all
+ * entities rendered at the same time.
+ */
+class ExpressionProgram
+{
+public:
+	enum OpCode
+	{
+		OP_ADD,
+		OP_SUBTRACT,
+		OP_MULTIPLY,
+		OP_DIVIDE,
+		OP_MODULO,
+		OP_LESS,
+		OP_LESS_EQUAL,
+		OP_GREATER,
+		OP_GREATER_EQUAL,
+		OP_EQUAL,
+		OP_NOT_EQUAL,
+		OP_AND,
+		OP_OR,
+		OP_TABLE,		// dest = table[a]
+		OP_TIME,		// dest = time in seconds
+		OP_SHADERPARM,	// dest = entity shaderparm a
+		OP_MOVE,		// dest = a
+		OP_EXPRESSION,	// dest = value of an expression which couldn't be compiled
+		OP_EVALUATE,	// evaluates an expression writing its linked register itself
+	};
+
+private:
+	struct Op
+	{
+		OpCode code;
+		std::size_t dest;
+		std::size_t a;
+		std::size_t b;
+		TableDefinition* table;
+		IShaderExpression* expression;
+	};
+	typedef std::vector<Op> Ops;
+
+	// What the value of a register depends on, the higher value wins
+	enum Dependency
+	{
+		CONSTANT,
+		TIME,
+		ENTITY,
+	};
+
+	Registers* _registers;
+
+	// The dependency of each register, registers not written by this program are constant
+	std::vector<unsigned char> _dependencies;
+
+	// Operations executed once per time value
+	Ops _timeOps;
+
+	// Operations executed on every evaluation
+	Ops _entityOps;
+
+	// The register holding the time, allocated on first use
+	std::size_t _timeRegister;
+
+	// The time the time operations have been executed for
+	std::size_t _cachedTime;
+	bool _cacheValid;
+
+public:
+	ExpressionProgram(Registers& registers);
+
+	// Removes all operations, the allocated registers are kept
+	void clear();
+
+	// Returns true if no operations need to be executed
+	bool empty() const;
+
+	// Returns true if any operation reads the render entity
+	bool dependsOnEntity() const;
+
+	/**
+	 * Executes the program, writing the results into the registers. The
+	 * entity may be NULL, in which case all shaderparms evaluate to 0.
+	 */
+	void execute(std::size_t time, const IRenderEntity* entity);
+
+	// Returns the number of operations
+	std::size_t getNumOps() const;
+
+	// Compile functions, each returns the register holding the result
+
+	// Allocates a register holding the given value
+	std::size_t constant(float value);
+
+	// The current time in seconds
+	std::size_t time();
+
+	// The given shaderparm of the render entity
+	std::size_t shaderParm(int parmNum);
+
+	// A binary operation (OP_ADD to OP_OR) on the given registers
+	std::size_t binary(OpCode code, std::size_t a, std::size_t b);
+
+	// A lookup in the given table
+	std::size_t tableLookup(TableDefinition& table, std::size_t index);
+
+	// Calls getValue() on the given expression, which must outlive the program
+	std::size_t expression(IShaderExpression& expr);
+
+	// Writes the value of the given register into the linked register of an expression
+	void link(std::size_t dest, std::size_t value);
+
+	// Calls evaluate() on the given expression, which writes its linked register itself
+	void evaluate(IShaderExpression& expr);
+
+	// Applies one of the binary operations to the given values
+	static float applyBinary(OpCode code, float a, float b);
+
+private:
+	std::size_t allocate(float value, Dependency dependency);
+	Dependency getDependency(std::size_t reg) const;
+	void emit(Dependency dependency, OpCode code, std::size_t dest, std::size_t a = 0, std::size_t b = 0,
+			  TableDefinition* table = NULL, IShaderExpression* expression = NULL);
+	void executeOps(const Ops& ops, std::size_t time, const IRenderEntity* entity);
+};
+
+} // namespace
@@ -12,6 +12,7 @@
 #include "math/Vector3.h"
 
 #include "RGBAImage.h"
+#include "image/ImageKernels.h"
 #include "textures/ImageFileLoader.h"
 #include "textures/HeightmapCreator.h"
 #include "textures/TextureManipulator.h"
@@ -141,6 +142,10 @@ std::string HeightMapExpression::getIdentifier() const {
 	return identifier;
 }
 
+void HeightMapExpression::collectImageNames(std::set<std::string>& names) const {
+	heightMapExp->collectImageNames(names);
+}
+
 AddNormalsExpression::AddNormalsExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExpOne = createForToken(token);
@@ -176,36 +181,9 @@ ImagePtr AddNormalsExpression::getImage() const {
     byte* pixTwo = imgTwo->getMipMapPixels(0);
     byte* pixOut = result->getMipMapPixels(0);
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++ )
-	{
-		for( std::size_t x = 0; x < width; x++ )
-		{
-			// create the two vectors
-			Vector3 vectorOne(
-    			static_cast<double>(pixOne[0]),
-    			static_cast<double>(pixOne[1]),
-    			static_cast<double>(pixOne[2])
-			);
-			Vector3 vectorTwo(
-    			static_cast<double>(pixTwo[0]),
-    			static_cast<double>(pixTwo[1]),
-    			static_cast<double>(pixTwo[2])
-			);
-			// Take the mean value of the two vectors
-			Vector3 vectorOut = (vectorOne + vectorTwo) * 0.5;
-
-			pixOut[0] = float_to_integer(vectorOut.x());
-			pixOut[1] = float_to_integer(vectorOut.y());
-			pixOut[2] = float_to_integer(vectorOut.z());
-			pixOut[3] = 255;
-
-			// advance the pixel pointer
-			pixOne += 4;
-			pixTwo += 4;
-			pixOut += 4;
-		}
-    }
+    // Take the mean value of the two normal vectors
+    image::getKernels().addNormals(pixOne, pixTwo, pixOut, width * height);
+
     return result;
 }
 
@@ -215,6 +193,11 @@ std::string AddNormalsExpression::getIdentifier() const {
 	return identifier;
 }
 
+void AddNormalsExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExpOne->collectImageNames(names);
+	mapExpTwo->collectImageNames(names);
+}
+
 SmoothNormalsExpression::SmoothNormalsExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -241,53 +224,9 @@ ImagePtr SmoothNormalsExpression::getImage() const {
 	byte* in = normalMap->getMipMapPixels(0);
 	byte* out = result->getMipMapPixels(0);
 
-	struct KernelElement {
-		// offset to the current pixel
-		int dx, dy;
-	};
-
-	// a 3x3 kernel with the surrounding pixels including the pixel itself
-	const int kernelSize = 9;
-	KernelElement kernel[kernelSize] = {
-		{-1, -1 },
-		{ 0, -1 },
-		{ 1, -1 },
-		{ 1,  0 },
-		{ 1,  1 },
-		{ 0,  1 },
-		{-1,  1 },
-		{-1,  0 },
-		{ 0,  0 }
-	};
-	const float perKernelSize = 1.0f/kernelSize;
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++) {
-		for( std::size_t x = 0; x < width; x++) {
-			//the new normal vector for this pixel
-			Vector3 smoothVector(0,0,0);
-
-			// calculate the average direction of the surrounding vectors
-			for (KernelElement* i = kernel; i != kernel + kernelSize; ++i) {
-				// temporary vector to represent one of the surrounding pixels
-				byte* pixel = getPixel(in, width, height, x + i->dx, y + i->dy);
-				Vector3 temp(pixel[0], pixel[1], pixel[2]);
-
-				smoothVector += temp;
-			}
-
-			// Take the average normal vector as result
-			smoothVector *= perKernelSize;
-
-			out[0] = float_to_integer(smoothVector.x());
-			out[1] = float_to_integer(smoothVector.y());
-			out[2] = float_to_integer(smoothVector.z());
-			out[3] = 255;
-
-			// advance the pixel pointer
-			out += 4;
-	    }
-	}
+	// Average the 3x3 neighbourhood of each normal vector
+	image::getKernels().smoothNormals(in, out, width, height);
+
     return result;
 }
 
@@ -297,6 +236,10 @@ std::string SmoothNormalsExpression::getIdentifier() const {
 	return identifier;
 }
 
+void SmoothNormalsExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 AddExpression::AddExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExpOne = createForToken(token);
@@ -332,23 +275,9 @@ ImagePtr AddExpression::getImage() const {
     byte* pixTwo = imgTwo->getMipMapPixels(0);
     byte* pixOut = result->getMipMapPixels(0);
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++)
-	{
-		for( std::size_t x = 0; x < width; x++)
-		{
-			// add the colors
-			pixOut[0] = float_to_integer((static_cast<float>(pixOne[0]) + pixTwo[0]) * 0.5f);
-			pixOut[1] = float_to_integer((static_cast<float>(pixOne[1]) + pixTwo[1]) * 0.5f);
-			pixOut[2] = float_to_integer((static_cast<float>(pixOne[2]) + pixTwo[2]) * 0.5f);
-			pixOut[3] = float_to_integer((static_cast<float>(pixOne[3]) + pixTwo[3]) * 0.5f);
-
-			//advance the pixel pointer
-			pixOne += 4;
-			pixTwo += 4;
-			pixOut += 4;
-		}
-    }
+    // add the colors
+    image::getKernels().average(pixOne, pixTwo, pixOut, width * height);
+
 	return result;
 }
 
@@ -358,6 +287,11 @@ std::string AddExpression::getIdentifier() const {
 	return identifier;
 }
 
+void AddExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExpOne->collectImageNames(names);
+	mapExpTwo->collectImageNames(names);
+}
+
 ScaleExpression::ScaleExpression (DefTokeniser& token) : scaleGreen(0),scaleBlue(0),scaleAlpha(0) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -402,29 +336,10 @@ ImagePtr ScaleExpression::getImage() const {
     byte* in = img->getMipMapPixels(0);
     byte* out = result->getMipMapPixels(0);
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			// prevent negative values and check for values >255
-			int red = float_to_integer(static_cast<float>(in[0]) * scaleRed);
-			out[0] = (red>255) ? 255 : red;
-
-			int green = float_to_integer(static_cast<float>(in[1]) * scaleGreen);
-			out[1] = (green>255) ? 255 : green;
-
-			int blue = float_to_integer(static_cast<float>(in[2]) * scaleBlue);
-			out[2] = (blue>255) ? 255 : blue;
-
-			int alpha = float_to_integer(static_cast<float>(in[3]) * scaleAlpha);
-			out[3] = (alpha>255) ? 255 : alpha;
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-    }
+    // the kernel clamps the scaled values to 255
+    const float factors[4] = { scaleRed, scaleGreen, scaleBlue, scaleAlpha };
+    image::getKernels().scale(in, out, width * height, factors);
+
 	return result;
 }
 
@@ -434,6 +349,10 @@ std::string ScaleExpression::getIdentifier() const {
 	return identifier;
 }
 
+void ScaleExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 InvertAlphaExpression::InvertAlphaExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -459,21 +378,7 @@ ImagePtr InvertAlphaExpression::getImage() const {
 	byte* in = img->getMipMapPixels(0);
 	byte* out = result->getMipMapPixels(0);
 
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			out[0] = in[0];
-			out[1] = in[1];
-			out[2] = in[2];
-			out[3] = 255 - in[3];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	image::getKernels().invertAlpha(in, out, width * height);
 
 	return result;
 }
@@ -484,6 +389,10 @@ std::string InvertAlphaExpression::getIdentifier() const {
 	return identifier;
 }
 
+void InvertAlphaExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 InvertColorExpression::InvertColorExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -509,19 +418,7 @@ ImagePtr InvertColorExpression::getImage() const {
 	byte* in = img->getMipMapPixels(0);
 	byte* out = result->getMipMapPixels(0);
 
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++) {
-		for( std::size_t x = 0; x < width; x++) {
-			out[0] = 255 - in[0];
-			out[1] = 255 - in[1];
-			out[2] = 255 - in[2];
-			out[3] = in[3];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	image::getKernels().invertColor(in, out, width * height);
 
 	return result;
 }
@@ -532,6 +429,10 @@ std::string InvertColorExpression::getIdentifier() const {
 	return identifier;
 }
 
+void InvertColorExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 MakeIntensityExpression::MakeIntensityExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -557,21 +458,7 @@ ImagePtr MakeIntensityExpression::getImage() const {
 	byte* in = img->getMipMapPixels(0);
 	byte* out = result->getMipMapPixels(0);
 
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			out[0] = in[0];
-			out[1] = in[0];
-			out[2] = in[0];
-			out[3] = in[0];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	image::getKernels().makeIntensity(in, out, width * height);
 
 	return result;
 }
@@ -582,6 +469,10 @@ std::string MakeIntensityExpression::getIdentifier() const {
 	return identifier;
 }
 
+void MakeIntensityExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 MakeAlphaExpression::MakeAlphaExpression (DefTokeniser& token) {
 	token.assertNextToken("(");
 	mapExp = createForToken(token);
@@ -607,21 +498,7 @@ ImagePtr MakeAlphaExpression::getImage() const {
 	byte* in = img->getMipMapPixels(0);
 	byte* out = result->getMipMapPixels(0);
 
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++)
-	{
-		for( std::size_t x = 0; x < width; x++)
-		{
-			out[0] = 255;
-			out[1] = 255;
-			out[2] = 255;
-			out[3] = (in[0] + in[1] + in[2])/3;
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	image::getKernels().makeAlpha(in, out, width * height);
 
 	return result;
 }
@@ -632,6 +509,10 @@ std::string MakeAlphaExpression::getIdentifier() const {
 	return identifier;
 }
 
+void MakeAlphaExpression::collectImageNames(std::set<std::string>& names) const {
+	mapExp->collectImageNames(names);
+}
+
 /* ImageExpression */
 
 ImageExpression::ImageExpression(const std::string& imgName)
@@ -727,4 +608,17 @@ std::string ImageExpression::getIdentifier() const
 	return _imgName;
 }
 
+bool ImageExpression::isBuiltInImage() const
+{
+	return !_imgName.empty() && _imgName[0] == '_';
+}
+
+void ImageExpression::collectImageNames(std::set<std::string>& names) const
+{
+	if (!isBuiltInImage())
+	{
+		names.insert(_imgName);
+	}
+}
+
 } // namespace shaders
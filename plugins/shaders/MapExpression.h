@@ -2,6 +2,7 @@
 #define MAPEXPRESSION_H_
 
 #include <string>
+#include <set>
 
 #include <boost/shared_ptr.hpp>
 
@@ -34,6 +35,13 @@ public: /* INTERFACE METHODS */
      */
 	virtual ImagePtr getImage() const = 0;
 
+	/**
+	 * Adds the VFS names of all image files this expression is
+	 * reading (without extension) to the given set. Built-in images like
+	 * "_white" are not included.
+	 */
+	virtual void collectImageNames(std::set<std::string>& names) const = 0;
+
     /**
      * \brief
      * Return whether this map expression creates a cube map.
@@ -90,6 +98,7 @@ public:
 	HeightMapExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class AddNormalsExpression : public MapExpression {
@@ -99,6 +108,7 @@ public:
 	AddNormalsExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class SmoothNormalsExpression : public MapExpression {
@@ -107,6 +117,7 @@ public:
 	SmoothNormalsExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class AddExpression : public MapExpression {
@@ -116,6 +127,7 @@ public:
 	AddExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class ScaleExpression : public MapExpression {
@@ -128,6 +140,7 @@ public:
 	ScaleExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class InvertAlphaExpression : public MapExpression {
@@ -136,6 +149,7 @@ public:
 	InvertAlphaExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class InvertColorExpression : public MapExpression {
@@ -144,6 +158,7 @@ public:
 	InvertColorExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class MakeIntensityExpression : public MapExpression {
@@ -152,6 +167,7 @@ public:
 	MakeIntensityExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 class MakeAlphaExpression : public MapExpression {
@@ -160,6 +176,7 @@ public:
 	MakeAlphaExpression (DefTokeniser& token);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
 };
 
 /**
@@ -179,6 +196,11 @@ public:
 	ImageExpression(const std::string& imgName);
 	ImagePtr getImage() const;
 	std::string getIdentifier() const;
+	void collectImageNames(std::set<std::string>& names) const;
+
+	// Returns true if this refers to one of the built-in images like "_white",
+	// which are loaded from the bitmaps folder instead of the VFS
+	bool isBuiltInImage() const;
 };
 
 } // namespace shaders
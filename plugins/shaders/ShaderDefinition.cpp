@@ -0,0 +1,50 @@
+#include "ShaderDefinition.h"
+
+#include <glibmm/thread.h>
+
+namespace shaders
+{
+
+namespace
+{
+	// Guards the construction of the templates
+	Glib::Mutex& getTemplateLock()
+	{
+		static Glib::Mutex _lock;
+		return _lock;
+	}
+}
+
+ShaderDefinition::ShaderDefinition(const ShaderTemplatePtr& templ, const std::string& fname) :
+	_template(templ),
+	_offset(0),
+	_length(0),
+	filename(fname)
+{}
+
+ShaderDefinition::ShaderDefinition(const std::string& name, const BlockBufferPtr& buffer,
+								   std::size_t offset, std::size_t length, const std::string& fname) :
+	_name(name),
+	_buffer(buffer),
+	_offset(offset),
+	_length(length),
+	filename(fname)
+{}
+
+const ShaderTemplatePtr& ShaderDefinition::getTemplate() const
+{
+	Glib::Mutex::Lock lock(getTemplateLock());
+
+	if (!_template)
+	{
+		// The template will be parsed when its values are requested
+		_template.reset(new ShaderTemplate(_name, _buffer->substr(_offset, _length)));
+
+		// The block is stored in the template now
+		_buffer.reset();
+	}
+
+	return _template;
+}
+
+} // namespace
@@ -9,24 +9,46 @@
 namespace shaders
 {
 
+// The raw block contents of a material file, shared by the definitions in it
+typedef boost::shared_ptr<const std::string> BlockBufferPtr;
+
 /**
  * Wrapper class that associates a ShaderTemplate with its filename.
+ *
+ * Definitions read from the material files just store the range of their
+ * raw block in the buffer of the file. The template is constructed the
+ * first time it is requested, which is done for a small part of the
+ * materials only.
  */
-struct ShaderDefinition
+class ShaderDefinition
 {
-	// The shader template
-	ShaderTemplatePtr shaderTemplate;
+	// The template, NULL until requested
+	mutable ShaderTemplatePtr _template;
+
+	// The name of the template to construct
+	std::string _name;
+
+	// The range of the raw block contents, released with the template construction
+	mutable BlockBufferPtr _buffer;
+	std::size_t _offset;
+	std::size_t _length;
 
+public:
 	// Filename from which the shader was parsed
 	std::string filename;
 
-	/* Constructor
-	 */
-	ShaderDefinition(const ShaderTemplatePtr& templ, const std::string& fname) :
-		shaderTemplate(templ),
-		filename(fname)
-	{}
+	// Constructs a definition wrapping an existing template
+	ShaderDefinition(const ShaderTemplatePtr& templ, const std::string& fname);
+
+	// Constructs a definition from a block in the given buffer
+	ShaderDefinition(const std::string& name, const BlockBufferPtr& buffer,
+					 std::size_t offset, std::size_t length, const std::string& fname);
 
+	/**
+	 * Returns the template, constructing it from the raw block if this is
+	 * the first request. Can be called from any thread.
+	 */
+	const ShaderTemplatePtr& getTemplate() const;
 };
 
 typedef std::map<std::string, ShaderDefinition, ShaderNameCompareFunctor> ShaderDefinitionMap;
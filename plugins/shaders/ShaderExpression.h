@@ -4,6 +4,7 @@
 #include "irender.h"
 #include "parser/DefTokeniser.h"
 #include "TableDefinition.h"
+#include "ExpressionProgram.h"
 
 namespace shaders
 {
@@ -64,6 +65,41 @@ public:
 		return _index;
 	}
 
+	/**
+	 * Appends the operations calculating this expression to the given
+	 * program, returns the register holding the result.
+	 */
+	virtual std::size_t compile(ExpressionProgram& program) = 0;
+
+	/**
+	 * Compiles the given expression into the program. Expressions not
+	 * derived from ShaderExpression are evaluated by calling getValue().
+	 */
+	static std::size_t compile(const IShaderExpressionPtr& expr, ExpressionProgram& program)
+	{
+		ShaderExpression* shaderExpr = dynamic_cast<ShaderExpression*>(expr.get());
+
+		return shaderExpr != NULL ? shaderExpr->compile(program) : program.expression(*expr);
+	}
+
+	/**
+	 * Compiles the given expression into the program, writing the result
+	 * into the register the expression has been linked to.
+	 */
+	static void compileLinked(const IShaderExpressionPtr& expr, ExpressionProgram& program)
+	{
+		ShaderExpression* shaderExpr = dynamic_cast<ShaderExpression*>(expr.get());
+
+		if (shaderExpr != NULL && shaderExpr->_registers != NULL)
+		{
+			program.link(shaderExpr->_index, shaderExpr->compile(program));
+		}
+		else
+		{
+			program.evaluate(*expr);
+		}
+	}
+
 	static IShaderExpressionPtr createFromString(const std::string& exprStr);
 
 	static IShaderExpressionPtr createFromTokens(parser::DefTokeniser& tokeniser);
@@ -97,6 +133,11 @@ public:
 	{
 		return entity.getShaderParm(_parmNum);
 	}
+
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		return program.shaderParm(_parmNum);
+	}
 };
 
 class GlobalShaderParmExpression :
@@ -121,6 +162,11 @@ public:
 	{
 		return getValue(time);
 	}
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		// globalNN is always 0 so far
+		return program.constant(0);
+	}
 };
 
 // An expression returning the current (game) time as result
@@ -141,6 +187,10 @@ public:
 	{
 		return getValue(time);
 	}
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		return program.time();
+	}
 };
 
 // An expression representing a constant floating point number
@@ -165,6 +215,10 @@ public:
 	{
 		return getValue(time);
 	}
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		return program.constant(_value);
+	}
 };
 
 // An expression looking up a value in a table def
@@ -198,6 +252,11 @@ public:
 		float lookupVal = _lookupExpr->getValue(time, entity);
 		return _tableDef->getValue(lookupVal);
 	}
+
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		return program.tableLookup(*_tableDef, ShaderExpression::compile(_lookupExpr, program));
+	}
 };
 
 // Abstract base class for an expression taking two sub-expression as arguments
@@ -225,16 +284,29 @@ protected:
 	IShaderExpressionPtr _b;
 	Precedence _precedence;
 
+	// The operation of the compiled expression
+	ExpressionProgram::OpCode _opCode;
+
 public:
 	BinaryExpression(Precedence precedence,
+					 ExpressionProgram::OpCode opCode,
 					 const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 				     const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
 		ShaderExpression(),
 		_a(a),
 		_b(b),
-		_precedence(precedence)
+		_precedence(precedence),
+		_opCode(opCode)
 	{}
 
+	virtual std::size_t compile(ExpressionProgram& program)
+	{
+		std::size_t a = ShaderExpression::compile(_a, program);
+		std::size_t b = ShaderExpression::compile(_b, program);
+
+		return program.binary(_opCode, a, b);
+	}
+
 	Precedence getPrecedence() const
 	{
 		return _precedence;
@@ -259,7 +331,7 @@ class AddExpression :
 public:
 	AddExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 				  const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(ADDITION, a, b)
+		BinaryExpression(ADDITION, ExpressionProgram::OP_ADD, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -280,7 +352,7 @@ class SubtractExpression :
 public:
 	SubtractExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					   const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(SUBTRACTION, a, b)
+		BinaryExpression(SUBTRACTION, ExpressionProgram::OP_SUBTRACT, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -301,7 +373,7 @@ class MultiplyExpression :
 public:
 	MultiplyExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					   const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(MULTIPLICATION, a, b)
+		BinaryExpression(MULTIPLICATION, ExpressionProgram::OP_MULTIPLY, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -322,7 +394,7 @@ class DivideExpression :
 public:
 	DivideExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					 const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(DIVISION, a, b)
+		BinaryExpression(DIVISION, ExpressionProgram::OP_DIVIDE, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -343,7 +415,7 @@ class ModuloExpression :
 public:
 	ModuloExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					 const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(MODULO, a, b)
+		BinaryExpression(MODULO, ExpressionProgram::OP_MODULO, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -364,7 +436,7 @@ class LesserThanExpression :
 public:
 	LesserThanExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 						 const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(RELATIONAL_COMPARISON, a, b)
+		BinaryExpression(RELATIONAL_COMPARISON, ExpressionProgram::OP_LESS, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -385,7 +457,7 @@ class LesserThanOrEqualExpression :
 public:
 	LesserThanOrEqualExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 								const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(RELATIONAL_COMPARISON, a, b)
+		BinaryExpression(RELATIONAL_COMPARISON, ExpressionProgram::OP_LESS_EQUAL, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -406,7 +478,7 @@ class GreaterThanExpression :
 public:
 	GreaterThanExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 						  const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(RELATIONAL_COMPARISON, a, b)
+		BinaryExpression(RELATIONAL_COMPARISON, ExpressionProgram::OP_GREATER, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -427,7 +499,7 @@ class GreaterThanOrEqualExpression :
 public:
 	GreaterThanOrEqualExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 								 const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(RELATIONAL_COMPARISON, a, b)
+		BinaryExpression(RELATIONAL_COMPARISON, ExpressionProgram::OP_GREATER_EQUAL, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -448,7 +520,7 @@ class EqualityExpression :
 public:
 	EqualityExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					   const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(EQUALITY_COMPARISON, a, b)
+		BinaryExpression(EQUALITY_COMPARISON, ExpressionProgram::OP_EQUAL, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -469,7 +541,7 @@ class InequalityExpression :
 public:
 	InequalityExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					     const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(EQUALITY_COMPARISON, a, b)
+		BinaryExpression(EQUALITY_COMPARISON, ExpressionProgram::OP_NOT_EQUAL, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -490,7 +562,7 @@ class LogicalAndExpression :
 public:
 	LogicalAndExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					     const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(LOGICAL_AND, a, b)
+		BinaryExpression(LOGICAL_AND, ExpressionProgram::OP_AND, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -511,7 +583,7 @@ class LogicalOrExpression :
 public:
 	LogicalOrExpression(const IShaderExpressionPtr& a = IShaderExpressionPtr(), 
 					    const IShaderExpressionPtr& b = IShaderExpressionPtr()) :
-		BinaryExpression(LOGICAL_OR, a, b)
+		BinaryExpression(LOGICAL_OR, ExpressionProgram::OP_OR, a, b)
 	{}
 
 	virtual float getValue(std::size_t time)
@@ -7,6 +7,7 @@
 #include "ShaderDefinition.h"
 #include "Doom3ShaderSystem.h"
 #include "TableDefinition.h"
+#include "debugging/ScopedDebugTimer.h"
 
 #include <iostream>
 #include <boost/algorithm/string/replace.hpp>
@@ -16,20 +17,34 @@
 
 namespace shaders {
 
-/* Parses through the shader file and processes the tokens delivered by
- * DefTokeniser.
+ShaderFileLoader::ShaderFileLoader(const std::string& path) :
+	_basePath(path),
+	_loader(path, &parser::tokeniseBlocks),
+	_blockBytes(0)
+{}
+
+/* Processes the blocks of a shader file delivered by the block tokeniser,
+ * the actual block contents will be parsed separately.
  */
-void ShaderFileLoader::parseShaderFile(std::istream& inStr,
-									   const std::string& filename)
+void ShaderFileLoader::parseShaderBlocks(Blocks& blocks,
+										 const std::string& filename)
 {
-	// Parse the file with a blocktokeniser, the actual block contents
-	// will be parsed separately.
-	parser::BasicDefBlockTokeniser<std::istream> tokeniser(inStr);
+	// The shader blocks of this file are copied into a single buffer, the
+	// templates are constructed from it when they are first requested
+	boost::shared_ptr<std::string> buffer(new std::string);
+
+	std::size_t totalSize = 0;
 
-	while (tokeniser.hasMoreBlocks())
+	for (Blocks::const_iterator i = blocks.begin(); i != blocks.end(); ++i)
 	{
-		// Get the next block
-		parser::BlockTokeniser::Block block = tokeniser.nextBlock();
+		totalSize += i->contents.size();
+	}
+
+	buffer->reserve(totalSize);
+
+	for (Blocks::iterator i = blocks.begin(); i != blocks.end(); ++i)
+	{
+		parser::BlockTokeniser::Block& block = *i;
 
 		// Skip tables
 		if (block.name.substr(0, 5) == "table")
@@ -63,13 +78,16 @@ void ShaderFileLoader::parseShaderFile(std::istream& inStr,
 
 		boost::algorithm::replace_all(block.name, "\\", "/"); // use forward slashes
 
-		ShaderTemplatePtr shaderTemplate(new ShaderTemplate(block.name, block.contents));
-
 		// Construct the ShaderDefinition wrapper class
-		ShaderDefinition def(shaderTemplate, filename);
+		ShaderDefinition def(block.name, buffer, buffer->size(), block.contents.size(), filename);
 
 		// Insert into the definitions map, if not already present
-		if (!GetShaderLibrary().addDefinition(block.name, def))
+		if (GetShaderLibrary().addDefinition(block.name, def))
+		{
+			buffer->append(block.contents);
+			_blockBytes += block.contents.size();
+		}
+		else
 		{
     		rError() << "[shaders] " << filename
 				<< ": shader " << block.name << " already defined." << std::endl;
@@ -79,20 +97,45 @@ void ShaderFileLoader::parseShaderFile(std::istream& inStr,
 
 void ShaderFileLoader::visit(const std::string& filename)
 {
-	// Construct the full VFS path
-	std::string fullPath = _basePath + filename;
-
-	// Open the file
-	ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(fullPath);
+	_loader.visit(filename);
+}
 
-	if (file != NULL) {
-		std::istream is(&(file->getInputStream()));
-		parseShaderFile(is, fullPath);
+void ShaderFileLoader::parseFiles()
+{
+	{
+		ScopedDebugTimer timer("ShaderFiles tokenised: ");
+		_loader.run();
 	}
-	else
+
+	ScopedDebugTimer timer("ShaderFiles parsed: ");
+
+	// Add the definitions in VFS order, the first definition wins
+	parser::ParallelDeclLoader<Blocks>::Files& files = _loader.getFiles();
+
+	for (std::size_t i = 0; i < files.size(); ++i)
 	{
-		throw std::runtime_error("Unable to read shaderfile: " + fullPath);
+		// Construct the full VFS path
+		std::string fullPath = _basePath + files[i].name;
+
+		if (!files[i].opened)
+		{
+			throw std::runtime_error("Unable to read shaderfile: " + fullPath);
+		}
+
+		parseShaderBlocks(files[i].result, fullPath);
+
+		// The blocks have been copied into the buffer of the file
+		Blocks().swap(files[i].result);
+
+		// Report tokeniser errors after the blocks preceding them
+		if (!files[i].error.empty())
+		{
+			throw parser::ParseException(files[i].error);
+		}
 	}
+
+	rMessage() << "[shaders] " << (_blockBytes >> 10)
+		<< " kB of material blocks kept for parsing on demand." << std::endl;
 }
 
 } // namespace shaders
@@ -4,6 +4,7 @@
 #include "ShaderTemplate.h"
 
 #include "parser/DefTokeniser.h"
+#include "parser/ParallelDeclLoader.h"
 
 #include <string>
 
@@ -11,7 +12,9 @@ namespace shaders
 {
 
 /**
- * VFS functor class which loads material (mtr) files.
+ * VFS functor class which loads material (mtr) files. The visited files
+ * are collected first, parseFiles() splits them into blocks on several
+ * threads and adds the definitions in the order the files were visited.
  */
 class ShaderFileLoader :
 	public VirtualFileSystem::Visitor
@@ -20,19 +23,26 @@ private:
 	// The base path for the shaders (e.g. "materials/")
 	std::string _basePath;
 
+	typedef std::vector<parser::BlockTokeniser::Block> Blocks;
+	parser::ParallelDeclLoader<Blocks> _loader;
+
+	// The size of the raw shader blocks kept for the templates
+	std::size_t _blockBytes;
+
 private:
 
-	// Parse a shader file with the given contents and filename
-	void parseShaderFile(std::istream& inStr, const std::string& filename);
+	// Parse the blocks of a shader file with the given filename
+	void parseShaderBlocks(Blocks& blocks, const std::string& filename);
 
 public:
 	// Constructor. Set the basepath to prepend onto shader filenames.
-	ShaderFileLoader(const std::string& path)
-	: _basePath(path)
-	{}
+	ShaderFileLoader(const std::string& path);
 
 	// FileVisitor implementation
 	void visit(const std::string& filename);
+
+	// Reads the visited files and adds their tables and shaders to the library
+	void parseFiles();
 };
 
 }
@@ -12,20 +12,50 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <iostream>
+#include <glibmm/thread.h>
 
 #include "ShaderExpression.h"
 
 namespace shaders
 {
 
+namespace
+{
+	// Serialises the parsing of all templates. Recursive, since parsing a
+	// template may run into getters of the same template again.
+	Glib::RecMutex& getParseLock()
+	{
+		static Glib::RecMutex _lock;
+		return _lock;
+	}
+}
+
 NamedBindablePtr ShaderTemplate::getEditorTexture()
 {
-    if (!_parsed)
-        parseDefinition();
+    ensureParsed();
 
     return _editorTex;
 }
 
+void ShaderTemplate::parseDefinitionLocked()
+{
+	Glib::RecMutex::Lock lock(getParseLock());
+
+	// Another thread might have finished the parse while we were waiting,
+	// or this is a getter called by the parse functions
+	if (g_atomic_int_get(&_parsed) || _parsing)
+	{
+		return;
+	}
+
+	_parsing = true;
+	parseDefinition();
+	_parsing = false;
+
+	// Publish the parsed values to the threads skipping the lock
+	g_atomic_int_set(&_parsed, 1);
+}
+
 IShaderExpressionPtr ShaderTemplate::parseSingleExpressionTerm(parser::DefTokeniser& tokeniser)
 {
 	std::string token = tokeniser.nextToken();
@@ -1153,8 +1183,6 @@ void ShaderTemplate::parseDefinition()
         "{}(),"  // add the comma character to the kept delimiters
     );
 
-    _parsed = true; // we're parsed from now on
-
     try
     {
         int level = 1;  // we always start at top level
@@ -1285,6 +1313,9 @@ void ShaderTemplate::parseDefinition()
 
 void ShaderTemplate::addLayer(const Doom3ShaderLayerPtr& layer)
 {
+	// The stage is complete, turn its expressions into register operations
+	layer->compileExpressions();
+
 	// Add the layer
 	_layers.push_back(layer);
 
@@ -1304,7 +1335,7 @@ void ShaderTemplate::addLayer(ShaderLayer::Type type, const MapExpressionPtr& ma
 
 bool ShaderTemplate::hasDiffusemap()
 {
-	if (!_parsed) parseDefinition();
+	ensureParsed();
 
 	for (Layers::const_iterator i = _layers.begin(); i != _layers.end(); ++i)
     {
@@ -8,6 +8,7 @@
 #include "math/Vector3.h"
 
 #include <map>
+#include <glib.h>
 #include <boost/shared_ptr.hpp>
 
 namespace shaders { class MapExpression; }
@@ -19,6 +20,9 @@ namespace shaders
  * Data structure storing parsed material information from a material decl. This
  * class parses the decl using a tokeniser and stores the relevant information
  * internally, for later use by a CShader.
+ *
+ * The decl is parsed the first time any of the parsed information is
+ * requested. This may happen on any thread, the parse is done only once.
  */
 class ShaderTemplate
 {
@@ -86,8 +90,12 @@ private:
 	// Raw material declaration
 	std::string _blockContents;
 
-	// Whether the block has been parsed
-	bool _parsed;
+	// Whether the block has been parsed, accessed through the glib atomics
+	volatile gint _parsed;
+
+	// Set while the block is being parsed, getters called by the parse
+	// functions return the values parsed so far
+	bool _parsing;
 
 public:
 
@@ -112,7 +120,8 @@ public:
       _polygonOffset(0.0f),
 	  _coverage(Material::MC_UNDETERMINED),
 	  _blockContents(blockContents),
-	  _parsed(false)
+	  _parsed(0),
+	  _parsing(false)
 	{
 		_decalInfo.stayMilliSeconds = 0;
 		_decalInfo.fadeMilliSeconds = 0;
@@ -138,97 +147,97 @@ public:
 
 	const std::string& getDescription()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return description;
 	}
 
 	int getMaterialFlags()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _materialFlags;
 	}
 
 	Material::CullType getCullType()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _cullType;
 	}
 
 	ClampType getClampType()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _clampType;
 	}
 
 	int getSurfaceFlags()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _surfaceFlags;
 	}
 
 	Material::SurfaceType getSurfaceType()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _surfaceType;
 	}
 
 	Material::DeformType getDeformType()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _deformType;
 	}
 
 	int getSpectrum()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _spectrum;
 	}
 
 	const Material::DecalInfo& getDecalInfo()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _decalInfo;
 	}
 
 	Material::Coverage getCoverage()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _coverage;
 	}
 
 	const Layers& getLayers()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _layers;
 	}
 
 	bool isFogLight()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return fogLight;
 	}
 
 	bool isAmbientLight()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return ambientLight;
 	}
 
 	bool isBlendLight()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return blendLight;
 	}
 
     int getSortRequest()
     {
-		if (!_parsed) parseDefinition();
+		ensureParsed();
         return _sortReq;
     }
 
     float getPolygonOffset()
     {
-		if (!_parsed) parseDefinition();
+		ensureParsed();
         return _polygonOffset;
     }
 
@@ -252,7 +261,7 @@ public:
 
 	const shaders::MapExpressionPtr& getLightFalloff()
 	{
-		if (!_parsed) parseDefinition();
+		ensureParsed();
 		return _lightFalloff;
 	}
 
@@ -264,6 +273,18 @@ public:
 
 private:
 
+	// Parses the block unless this has been done already
+	void ensureParsed()
+	{
+		if (!g_atomic_int_get(&_parsed))
+		{
+			parseDefinitionLocked();
+		}
+	}
+
+	// Parses the block while holding the parse lock, see ensureParsed()
+	void parseDefinitionLocked();
+
 	// Add the given layer and assigns editor preview layer if applicable
 	void addLayer(const Doom3ShaderLayerPtr& layer);
 
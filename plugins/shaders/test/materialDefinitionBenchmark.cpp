@@ -0,0 +1,179 @@
+#include "../ShaderDefinition.h"
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <glibmm/timer.h>
+
+/**
+ * Measures the time and heap memory needed to store the definitions of the
+ * material files at startup: a ShaderTemplate constructed for each block
+ * (the previous implementation) compared to the block ranges in a shared
+ * buffer per file. The materials are generated, a typical material with
+ * editor image, diffuse, bump and specular map and a glow stage each. This is
+ * not part of the test suite, run "make materialDefinitionBenchmark" and
+ * execute it manually. The number of materials can be passed as argument.
+ */
+namespace
+{
+	const std::size_t MATERIALS_PER_FILE = 500;
+
+	// Heap bytes currently allocated through operator new
+	std::size_t allocatedBytes = 0;
+
+	// The size is stored in front of each block, keeping it aligned
+	const std::size_t HEADER_SIZE = 16;
+
+	struct Block
+	{
+		std::string name;
+		std::string contents;
+	};
+
+	typedef std::vector<Block> Blocks;
+
+	void generateFiles(std::size_t numMaterials, std::vector<Blocks>& files)
+	{
+		char buffer[64];
+
+		for (std::size_t i = 0; i < numMaterials; ++i)
+		{
+			if (i % MATERIALS_PER_FILE == 0)
+			{
+				files.push_back(Blocks());
+			}
+
+			Block block;
+
+			std::sprintf(buffer, "textures/darkmod/stone/brick/material_%u", static_cast<unsigned int>(i));
+			block.name = buffer;
+
+			const std::string& name = block.name;
+
+			block.contents = "\n"
+				"\tqer_editorimage " + name + "_ed\n"
+				"\tstone\n"
+				"\tdiffusemap " + name + "\n"
+				"\tbumpmap " + name + "_local\n"
+				"\tspecularmap " + name + "_s\n"
+				"\t{\n"
+				"\t\tblend add\n"
+				"\t\tmap " + name + "_glow\n"
+				"\t\trgb 0.5 + 0.5 * sintable[time * 0.2]\n"
+				"\t}\n";
+
+			files.back().push_back(block);
+		}
+	}
+
+	void printResult(const char* name, double seconds, std::size_t bytes)
+	{
+		std::cout << std::left << std::setw(34) << name << std::right
+				  << std::fixed << std::setprecision(2) << std::setw(8) << seconds * 1000 << " ms, "
+				  << std::setw(8) << (bytes >> 10) << " kB" << std::endl;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	char* block = static_cast<char*>(std::malloc(size + HEADER_SIZE));
+
+	if (block == NULL) throw std::bad_alloc();
+
+	*reinterpret_cast<std::size_t*>(block) = size;
+	allocatedBytes += size;
+
+	return block + HEADER_SIZE;
+}
+
+void operator delete(void* pointer) throw()
+{
+	if (pointer == NULL) return;
+
+	char* block = static_cast<char*>(pointer) - HEADER_SIZE;
+
+	allocatedBytes -= *reinterpret_cast<std::size_t*>(block);
+	std::free(block);
+}
+
+int main(int argc, char* argv[])
+{
+	using namespace shaders;
+
+	std::size_t numMaterials = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 20000;
+
+	std::vector<Blocks> files;
+	generateFiles(numMaterials, files);
+
+	std::cout << "Storing the definitions of " << numMaterials << " materials in "
+			  << files.size() << " files" << std::endl;
+
+	{
+		std::size_t bytesBefore = allocatedBytes;
+		Glib::Timer timer;
+
+		ShaderDefinitionMap definitions;
+
+		for (std::size_t f = 0; f < files.size(); ++f)
+		{
+			for (Blocks::const_iterator i = files[f].begin(); i != files[f].end(); ++i)
+			{
+				ShaderTemplatePtr shaderTemplate(new ShaderTemplate(i->name, i->contents));
+				definitions.insert(ShaderDefinitionMap::value_type(i->name, ShaderDefinition(shaderTemplate, "test.mtr")));
+			}
+		}
+
+		printResult("templates per block (previous)", timer.elapsed(), allocatedBytes - bytesBefore);
+	}
+
+	{
+		std::size_t bytesBefore = allocatedBytes;
+		Glib::Timer timer;
+
+		ShaderDefinitionMap definitions;
+
+		for (std::size_t f = 0; f < files.size(); ++f)
+		{
+			// Like the ShaderFileLoader, one buffer per file
+			boost::shared_ptr<std::string> buffer(new std::string);
+
+			std::size_t totalSize = 0;
+
+			for (Blocks::const_iterator i = files[f].begin(); i != files[f].end(); ++i)
+			{
+				totalSize += i->contents.size();
+			}
+
+			buffer->reserve(totalSize);
+
+			for (Blocks::const_iterator i = files[f].begin(); i != files[f].end(); ++i)
+			{
+				definitions.insert(ShaderDefinitionMap::value_type(i->name,
+					ShaderDefinition(i->name, buffer, buffer->size(), i->contents.size(), "test.mtr")));
+				buffer->append(i->contents);
+			}
+		}
+
+		printResult("block ranges in a shared buffer", timer.elapsed(), allocatedBytes - bytesBefore);
+
+		// A map uses a small part of the materials, their templates are constructed on request
+		timer.reset();
+		timer.start();
+
+		std::size_t numRequested = 0;
+
+		for (ShaderDefinitionMap::const_iterator i = definitions.begin(); i != definitions.end(); ++i)
+		{
+			if (++numRequested % 20 != 0) continue;
+
+			i->second.getTemplate();
+		}
+
+		printResult("  after requesting 5% of them", timer.elapsed(), allocatedBytes - bytesBefore);
+	}
+
+	return 0;
+}
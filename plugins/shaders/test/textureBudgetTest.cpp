@@ -0,0 +1,279 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE textureBudgetTest
+#include <boost/test/unit_test.hpp>
+
+#include "../textures/TextureBudget.h"
+
+#include <map>
+#include <vector>
+
+using shaders::TextureBudget;
+
+namespace
+{
+	const gint64 SECOND = 1000000;
+
+	class TestTexture :
+		public Texture
+	{
+		GLuint _texNum;
+
+	public:
+		TestTexture(GLuint texNum) :
+			_texNum(texNum)
+		{}
+
+		std::string getName() const { return "texture"; }
+		GLuint getGLTexNum() const { return _texNum; }
+		std::size_t getWidth() const { return 256; }
+		std::size_t getHeight() const { return 256; }
+	};
+
+	// Textures of a given size, reducing them shrinks them to a tenth
+	class TestBackend :
+		public TextureBudget::Backend
+	{
+	public:
+		std::map<GLuint, std::size_t> sizes;
+		std::vector<GLuint> reduced;
+		gint64 time;
+
+		TestBackend() :
+			time(10 * SECOND)
+		{}
+
+		std::size_t measureTexture(GLuint textureNum)
+		{
+			return sizes[textureNum];
+		}
+
+		std::size_t reduceTexture(GLuint textureNum)
+		{
+			std::size_t size = sizes[textureNum] / 10;
+
+			if (size == 0) return 0;
+
+			reduced.push_back(textureNum);
+			sizes[textureNum] = size;
+
+			return size;
+		}
+
+		gint64 getTime()
+		{
+			return time;
+		}
+	};
+	typedef boost::shared_ptr<TestBackend> TestBackendPtr;
+
+	struct Fixture
+	{
+		TestBackendPtr backend;
+		TextureBudget budget;
+		std::vector<TexturePtr> textures;
+
+		Fixture() :
+			backend(new TestBackend),
+			budget(backend)
+		{}
+
+		// Adds a texture of the given size, its number is its index plus one
+		GLuint addTexture(std::size_t bytes)
+		{
+			GLuint texNum = static_cast<GLuint>(textures.size() + 1);
+
+			backend->sizes[texNum] = bytes;
+			textures.push_back(TexturePtr(new TestTexture(texNum)));
+
+			budget.add(textures.back(), NamedBindablePtr());
+
+			return texNum;
+		}
+
+		void markVisible(GLuint texNum)
+		{
+			budget.markVisible(std::vector<GLuint>(1, texNum));
+		}
+	};
+}
+
+BOOST_FIXTURE_TEST_CASE(tracksMemoryUsage, Fixture)
+{
+	GLuint first = addTexture(1000);
+	addTexture(500);
+
+	BOOST_CHECK_EQUAL(budget.getStats().currentBytes, 1500);
+	BOOST_CHECK_EQUAL(budget.getStats().numTextures, 2);
+
+	budget.remove(first);
+
+	BOOST_CHECK_EQUAL(budget.getStats().currentBytes, 500);
+	BOOST_CHECK_EQUAL(budget.getStats().peakBytes, 1500);
+	BOOST_CHECK_EQUAL(budget.getStats().numTextures, 1);
+}
+
+// Nothing is reduced without a budget or within it
+BOOST_FIXTURE_TEST_CASE(noEvictionWithinBudget, Fixture)
+{
+	addTexture(1000);
+	addTexture(1000);
+
+	backend->time += 10 * SECOND;
+
+	budget.evict();
+	BOOST_CHECK(backend->reduced.empty());
+
+	budget.setBudget(2000);
+	budget.evict();
+	BOOST_CHECK(backend->reduced.empty());
+}
+
+// The least recently used textures are reduced until the usage is below 90% of the budget
+BOOST_FIXTURE_TEST_CASE(evictsLeastRecentlyUsed, Fixture)
+{
+	GLuint first = addTexture(1000);
+	GLuint second = addTexture(1000);
+	GLuint third = addTexture(1000);
+
+	backend->time += SECOND;
+	markVisible(first);
+	backend->time += SECOND;
+	markVisible(third);
+
+	// 3000 bytes, reducing one texture doesn't get below 1800
+	budget.setBudget(2000);
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	BOOST_REQUIRE_EQUAL(backend->reduced.size(), 2);
+	BOOST_CHECK_EQUAL(backend->reduced[0], second);
+	BOOST_CHECK_EQUAL(backend->reduced[1], first);
+
+	BOOST_CHECK_EQUAL(budget.getStats().currentBytes, 1200);
+	BOOST_CHECK_EQUAL(budget.getStats().numReduced, 2);
+
+	// Reduced textures are not reduced any further
+	budget.setBudget(100);
+	budget.evict();
+
+	BOOST_CHECK_EQUAL(backend->reduced.size(), 3);
+	BOOST_CHECK_EQUAL(backend->reduced[2], third);
+}
+
+// Textures which have been visible in the last two seconds are kept
+BOOST_FIXTURE_TEST_CASE(keepsRecentlyVisible, Fixture)
+{
+	GLuint first = addTexture(1000);
+	GLuint second = addTexture(1000);
+
+	budget.setBudget(500);
+
+	backend->time += 10 * SECOND;
+	markVisible(second);
+	backend->time += SECOND;
+	budget.evict();
+
+	BOOST_REQUIRE_EQUAL(backend->reduced.size(), 1);
+	BOOST_CHECK_EQUAL(backend->reduced[0], first);
+
+	backend->time += SECOND;
+	budget.evict();
+
+	BOOST_CHECK_EQUAL(backend->reduced.size(), 2);
+}
+
+// Textures which can't be reduced are skipped
+BOOST_FIXTURE_TEST_CASE(skipsIrreducibleTextures, Fixture)
+{
+	addTexture(5);
+	GLuint large = addTexture(1000);
+
+	budget.setBudget(500);
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	BOOST_REQUIRE_EQUAL(backend->reduced.size(), 1);
+	BOOST_CHECK_EQUAL(backend->reduced[0], large);
+	BOOST_CHECK_EQUAL(budget.getStats().numReduced, 1);
+}
+
+// Reduced textures becoming visible are requested once until they are reloaded
+BOOST_FIXTURE_TEST_CASE(reloadsVisibleReducedTextures, Fixture)
+{
+	GLuint texNum = addTexture(1000);
+
+	budget.setBudget(500);
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	BOOST_REQUIRE_EQUAL(budget.getStats().numReduced, 1);
+
+	markVisible(texNum);
+	markVisible(texNum);
+
+	std::vector<TextureBudget::ReloadRequest> requests;
+	budget.getReloadRequests(requests);
+
+	BOOST_REQUIRE_EQUAL(requests.size(), 1);
+	BOOST_CHECK(requests[0].texture == textures[0]);
+
+	// Still loading, no further requests and no eviction
+	markVisible(texNum);
+	budget.setBudget(50);
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	budget.getReloadRequests(requests);
+	BOOST_CHECK(requests.empty());
+	BOOST_CHECK_EQUAL(backend->reduced.size(), 1);
+
+	// The full resolution is back
+	backend->sizes[texNum] = 1000;
+	budget.update(texNum);
+
+	BOOST_CHECK_EQUAL(budget.getStats().currentBytes, 1000);
+	BOOST_CHECK_EQUAL(budget.getStats().numReduced, 0);
+}
+
+// Cancelled reloads are requested again the next time the texture is visible
+BOOST_FIXTURE_TEST_CASE(cancelledReloadIsRequeued, Fixture)
+{
+	GLuint texNum = addTexture(1000);
+
+	budget.setBudget(500);
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	std::vector<TextureBudget::ReloadRequest> requests;
+
+	markVisible(texNum);
+	budget.getReloadRequests(requests);
+	BOOST_REQUIRE_EQUAL(requests.size(), 1);
+
+	budget.cancelReload(texNum);
+
+	budget.getReloadRequests(requests);
+	BOOST_CHECK(requests.empty());
+
+	markVisible(texNum);
+	budget.getReloadRequests(requests);
+	BOOST_CHECK_EQUAL(requests.size(), 1);
+	BOOST_CHECK_EQUAL(budget.getStats().numReduced, 1);
+}
+
+// Released textures are dropped before evicting
+BOOST_FIXTURE_TEST_CASE(removesReleasedTextures, Fixture)
+{
+	addTexture(1000);
+	addTexture(1000);
+
+	budget.setBudget(1500);
+	textures[0].reset();
+
+	backend->time += 10 * SECOND;
+	budget.evict();
+
+	BOOST_CHECK(backend->reduced.empty());
+	BOOST_CHECK_EQUAL(budget.getStats().currentBytes, 1000);
+	BOOST_CHECK_EQUAL(budget.getStats().numTextures, 1);
+}
@@ -0,0 +1,170 @@
+#include "GLTextureBudgetBackend.h"
+
+#include "igl.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace shaders
+{
+
+namespace
+{
+	// Reduced textures keep the largest mipmap fitting into this size
+	const GLint REDUCED_MAX_SIZE = 128;
+
+	const GLint MAX_MIPMAPS = 32;
+
+	struct LevelInfo
+	{
+		GLint width;
+		GLint height;
+		GLint compressed;
+		GLint internalFormat;
+		GLint size; // in bytes
+	};
+
+	// Queries the levels of the currently bound 2D texture
+	void getLevels(std::vector<LevelInfo>& levels)
+	{
+		GLint maxLevel = MAX_MIPMAPS - 1;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+		for (GLint level = 0; level <= std::min(maxLevel, MAX_MIPMAPS - 1); ++level)
+		{
+			LevelInfo info;
+
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &info.width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &info.height);
+
+			if (info.width == 0 || info.height == 0) break;
+
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &info.compressed);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_INTERNAL_FORMAT, &info.internalFormat);
+
+			if (info.compressed)
+			{
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &info.size);
+			}
+			else
+			{
+				info.size = info.width * info.height * 4;
+			}
+
+			levels.push_back(info);
+		}
+	}
+
+	std::size_t getTotalSize(const std::vector<LevelInfo>& levels)
+	{
+		std::size_t total = 0;
+
+		for (std::size_t i = 0; i < levels.size(); ++i)
+		{
+			total += levels[i].size;
+		}
+
+		return total;
+	}
+}
+
+std::size_t GLTextureBudgetBackend::measureTexture(GLuint textureNum)
+{
+	glBindTexture(GL_TEXTURE_2D, textureNum);
+
+	std::vector<LevelInfo> levels;
+	getLevels(levels);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return getTotalSize(levels);
+}
+
+std::size_t GLTextureBudgetBackend::reduceTexture(GLuint textureNum)
+{
+	glBindTexture(GL_TEXTURE_2D, textureNum);
+
+	std::vector<LevelInfo> levels;
+	getLevels(levels);
+
+	std::size_t first = 0;
+
+	while (first < levels.size() &&
+		   (levels[first].width > REDUCED_MAX_SIZE || levels[first].height > REDUCED_MAX_SIZE))
+	{
+		++first;
+	}
+
+	// Nothing to gain if the texture is small already or has no mipmaps
+	if (first == 0 || first == levels.size())
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return 0;
+	}
+
+	// Read back the levels to keep
+	std::vector< std::vector<unsigned char> > data(levels.size() - first);
+
+	for (std::size_t i = first; i < levels.size(); ++i)
+	{
+		std::vector<unsigned char>& buffer = data[i - first];
+		buffer.resize(levels[i].size);
+
+		if (levels[i].compressed)
+		{
+			glGetCompressedTexImage(GL_TEXTURE_2D, static_cast<GLint>(i), &buffer.front());
+		}
+		else
+		{
+			glGetTexImage(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA, GL_UNSIGNED_BYTE, &buffer.front());
+		}
+	}
+
+	// Shift them down to level 0 and release the remaining levels
+	glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+
+	for (std::size_t i = 0; i < levels.size(); ++i)
+	{
+		GLint level = static_cast<GLint>(i);
+
+		if (i < data.size())
+		{
+			const LevelInfo& info = levels[i + first];
+
+			if (info.compressed)
+			{
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, static_cast<GLenum>(info.internalFormat),
+					info.width, info.height, 0, info.size, &data[i].front());
+			}
+			else
+			{
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, info.width, info.height,
+					0, GL_RGBA, GL_UNSIGNED_BYTE, &data[i].front());
+			}
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(data.size() - 1));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	std::size_t result = 0;
+
+	for (std::size_t i = 0; i < data.size(); ++i)
+	{
+		result += data[i].size();
+	}
+
+	return result;
+}
+
+gint64 GLTextureBudgetBackend::getTime()
+{
+	return g_get_monotonic_time();
+}
+
+} // namespace shaders
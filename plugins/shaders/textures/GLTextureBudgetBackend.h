@@ -0,0 +1,23 @@
+#pragma once
+
+#include "TextureBudget.h"
+
+namespace shaders
+{
+
+/**
+ * The TextureBudget backend used by the GLTextureManager. The textures are
+ * measured by querying their mipmap levels, reducing them reads back the
+ * levels fitting into 128x128 pixels and shifts them down to level 0.
+ * Needs a current GL context.
+ */
+class GLTextureBudgetBackend :
+	public TextureBudget::Backend
+{
+public:
+	std::size_t measureTexture(GLuint textureNum);
+	std::size_t reduceTexture(GLuint textureNum);
+	gint64 getTime();
+};
+
+} // namespace shaders
@@ -7,16 +7,137 @@
 #include "ImageFileLoader.h"
 #include "../MapExpression.h"
 #include "TextureManipulator.h"
+#include "GLTextureBudgetBackend.h"
 #include "parser/DefTokeniser.h"
+#include "registry/registry.h"
+#include "ipreferencesystem.h"
+#include "RGBAImage.h"
+#include "archivelib.h"
 
 namespace {
     const int MAX_TEXTURE_QUALITY = 3;
 
     const std::string SHADER_NOT_FOUND = "notex.bmp";
+
+    const std::string RKEY_TEXTURE_STREAMING = "user/ui/textures/streaming";
+    const std::string RKEY_TEXTURE_UPLOAD_BUDGET = "user/ui/textures/uploadBudget";
+    const std::string RKEY_TEXTURE_DISK_CACHE = "user/ui/textures/diskCache";
+    const std::string RKEY_TEXTURE_DISK_CACHE_SIZE = "user/ui/textures/diskCacheSize";
+    const std::string RKEY_TEXTURE_MIPMAP_FILTER = "user/ui/textures/mipMapFilter";
+    const std::string RKEY_TEXTURE_MIPMAP_GAMMA = "user/ui/textures/mipMapGammaCorrect";
+    const std::string RKEY_TEXTURE_COMPRESSION = "user/ui/textures/compression";
+    const std::string RKEY_TEXTURE_MEMORY_BUDGET = "user/ui/textures/memoryBudget";
+    const std::string RKEY_TEXTURE_LOG_LATENCIES = "user/ui/textures/logStreamingLatencies";
+
+    // Normal maps don't hold colours, so they are filtered without gamma
+    // correction. Doom 3 names them "_local", the normal map expressions
+    // are recognised by their identifiers.
+    bool isNormalMap(const std::string& identifier)
+    {
+        return identifier.find("_local") != std::string::npos ||
+               identifier.compare(0, 12, "_addnormals_") == 0 ||
+               identifier.compare(0, 15, "_smoothnormals_") == 0 ||
+               identifier.compare(0, 11, "_heightmap_") == 0;
+    }
 }
 
 namespace shaders {
 
+GLTextureManager::GLTextureManager() :
+    _budget(TextureBudget::BackendPtr(new GLTextureBudgetBackend)),
+    _streamingEnabled(registry::getValue<bool>(RKEY_TEXTURE_STREAMING)),
+    _uploadBudgetUsec(registry::getValue<int>(RKEY_TEXTURE_UPLOAD_BUDGET) * 1000),
+    _diskCacheEnabled(registry::getValue<bool>(RKEY_TEXTURE_DISK_CACHE)),
+    _mipMapFilter(static_cast<image::MipMapFilter>(registry::getValue<int>(RKEY_TEXTURE_MIPMAP_FILTER))),
+    _mipMapGammaCorrect(registry::getValue<bool>(RKEY_TEXTURE_MIPMAP_GAMMA)),
+    _compressionEnabled(registry::getValue<bool>(RKEY_TEXTURE_COMPRESSION)),
+    _memoryBudget(registry::getValue<std::size_t>(RKEY_TEXTURE_MEMORY_BUDGET))
+{
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_STREAMING).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_UPLOAD_BUDGET).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_DISK_CACHE).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_DISK_CACHE_SIZE).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_MIPMAP_FILTER).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_MIPMAP_GAMMA).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_COMPRESSION).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_MEMORY_BUDGET).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+    GlobalRegistry().signalForKey(RKEY_TEXTURE_LOG_LATENCIES).connect(
+        sigc::mem_fun(this, &GLTextureManager::keyChanged)
+    );
+
+    _streamer.setLogLatencies(registry::getValue<bool>(RKEY_TEXTURE_LOG_LATENCIES));
+    _diskCache.setMaxSize(registry::getValue<std::size_t>(RKEY_TEXTURE_DISK_CACHE_SIZE) << 20);
+    _budget.setBudget(_memoryBudget << 20);
+
+    // Streamed images replace the placeholder or the reduced texture
+    _streamer.signal_textureUploaded().connect(
+        sigc::mem_fun(_budget, &TextureBudget::update)
+    );
+
+    // A neutral grey is shown while the actual image is loading
+    RGBAImagePtr placeholder(new RGBAImage(1, 1));
+
+    placeholder->pixels[0].red = 128;
+    placeholder->pixels[0].green = 128;
+    placeholder->pixels[0].blue = 128;
+    placeholder->pixels[0].alpha = 255;
+
+    _streamingPlaceholder = placeholder;
+
+    constructPreferences();
+}
+
+void GLTextureManager::keyChanged()
+{
+    _streamingEnabled = registry::getValue<bool>(RKEY_TEXTURE_STREAMING);
+    _uploadBudgetUsec = registry::getValue<int>(RKEY_TEXTURE_UPLOAD_BUDGET) * 1000;
+    _diskCacheEnabled = registry::getValue<bool>(RKEY_TEXTURE_DISK_CACHE);
+    _mipMapFilter = static_cast<image::MipMapFilter>(registry::getValue<int>(RKEY_TEXTURE_MIPMAP_FILTER));
+    _mipMapGammaCorrect = registry::getValue<bool>(RKEY_TEXTURE_MIPMAP_GAMMA);
+    _compressionEnabled = registry::getValue<bool>(RKEY_TEXTURE_COMPRESSION);
+    _memoryBudget = registry::getValue<std::size_t>(RKEY_TEXTURE_MEMORY_BUDGET);
+
+    _streamer.setLogLatencies(registry::getValue<bool>(RKEY_TEXTURE_LOG_LATENCIES));
+    _diskCache.setMaxSize(registry::getValue<std::size_t>(RKEY_TEXTURE_DISK_CACHE_SIZE) << 20);
+    _budget.setBudget(_memoryBudget << 20);
+}
+
+void GLTextureManager::constructPreferences()
+{
+    PreferencesPagePtr page = GlobalPreferenceSystem().getPage("Settings/Textures");
+
+    page->appendCheckBox("", "Load textures in the background", RKEY_TEXTURE_STREAMING);
+    page->appendSpinner("Texture upload time per frame (ms)", RKEY_TEXTURE_UPLOAD_BUDGET, 1.0f, 100.0f, 0);
+    page->appendCheckBox("", "Cache processed textures on disk", RKEY_TEXTURE_DISK_CACHE);
+    page->appendSpinner("Texture disk cache size (MB)", RKEY_TEXTURE_DISK_CACHE_SIZE, 16.0f, 16384.0f, 0);
+
+    std::list<std::string> filters;
+    filters.push_back("Box");
+    filters.push_back("Kaiser (sharper)");
+
+    page->appendCombo("Mipmap filter", RKEY_TEXTURE_MIPMAP_FILTER, filters);
+    page->appendCheckBox("", "Gamma-correct mipmaps", RKEY_TEXTURE_MIPMAP_GAMMA);
+    page->appendCheckBox("", "Compress textures (DXT1/DXT5)", RKEY_TEXTURE_COMPRESSION);
+    page->appendSpinner("Texture memory budget (MB, 0 = unlimited)", RKEY_TEXTURE_MEMORY_BUDGET, 0.0f, 65536.0f, 0);
+    page->appendCheckBox("", "Log the loading time of each texture", RKEY_TEXTURE_LOG_LATENCIES);
+}
+
 void GLTextureManager::checkBindings() {
     // Check the TextureMap for unique pointers and release them
     // as they aren't used by anyone else than this class.
@@ -26,6 +147,8 @@ void GLTextureManager::checkBindings() {
     {
         // If the boost::shared_ptr is unique (i.e. refcount==1), remove it
         if (i->second.unique()) {
+            _budget.remove(i->second->getGLTexNum());
+
             // Be sure to increment the iterator with a postfix ++,
             // so that the iterator is incremented right before deletion
             _textures.erase(i++);
@@ -55,11 +178,27 @@ TexturePtr GLTextureManager::getBinding(NamedBindablePtr bindable)
     }
     else
     {
-        // Create and insert texture object, if it is valid
-        TexturePtr texture = bindable->bindTexture(identifier);
+        // Create and insert texture object, if it is valid. Plain image
+        // maps are loaded in the background if possible.
+        TexturePtr texture = createStreamedTexture(bindable, identifier);
+
+        if (!texture)
+        {
+            texture = bindWithDiskCache(bindable, identifier);
+        }
+
         if (texture)
         {
             _textures.insert(TextureMap::value_type(identifier, texture));
+
+            // Only the 2D textures of map expressions can be reduced and reloaded
+            MapExpressionPtr mapExpr = boost::dynamic_pointer_cast<MapExpression>(bindable);
+
+            if (mapExpr && !mapExpr->isCubeMap())
+            {
+                _budget.add(texture, bindable);
+            }
+
             return texture;
         }
         else
@@ -85,7 +224,7 @@ TexturePtr GLTextureManager::getBinding(const std::string& fullPath,
         if (img != NULL)
         {
             // Constructor returned a valid image, now create the texture object
-            TexturePtr texture = img->bindTexture(fullPath);
+            TexturePtr texture = generateMipMaps(img, fullPath)->bindTexture(fullPath);
             _textures[fullPath] = texture;
         }
         else
@@ -101,6 +240,258 @@ TexturePtr GLTextureManager::getBinding(const std::string& fullPath,
     return _textures[fullPath];
 }
 
+TexturePtr GLTextureManager::createStreamedTexture(const NamedBindablePtr& bindable,
+                                                  const std::string& identifier)
+{
+    if (!_streamingEnabled) return TexturePtr();
+
+    // Only plain images can be streamed, map expressions like addnormals()
+    // need to process their source images when being bound
+    boost::shared_ptr<ImageExpression> imageExpr =
+        boost::dynamic_pointer_cast<ImageExpression>(bindable);
+
+    if (!imageExpr || imageExpr->isBuiltInImage()) return TexturePtr();
+
+    // The VFS is not thread-safe, so the files are opened here. The first
+    // one is used to read the dimensions from the header, which need to be
+    // known right away (texture projections depend on them).
+    ImageLoaderPtr loader;
+    ArchiveFilePtr headerFile = ImageFileLoader::openFileFromVFS(identifier, loader);
+
+    std::size_t width = 0;
+    std::size_t height = 0;
+
+    if (!headerFile || !loader->getDimensions(*headerFile, width, height))
+    {
+        return TexturePtr(); // load synchronously, which takes care of any errors
+    }
+
+    headerFile.reset();
+
+    // The second file is handed to the decoding thread. It is opened before
+    // any GL object is created, so nothing needs to be released if it fails.
+    ArchiveFilePtr file = ImageFileLoader::openFileFromVFS(identifier, loader);
+
+    if (!file) return TexturePtr();
+
+    // Create the texture object right away, the render system is caching the texture numbers
+    GLuint textureNum;
+    glGenTextures(1, &textureNum);
+    _streamingPlaceholder->uploadToTexture(textureNum);
+
+    StreamedTexturePtr texture(new StreamedTexture(textureNum, identifier, width, height));
+
+    requestStreamedImage(identifier, file, loader, texture);
+
+    return texture;
+}
+
+bool GLTextureManager::requestStreamedImage(const std::string& identifier,
+                                            const StreamedTexturePtr& texture)
+{
+    ImageLoaderPtr loader;
+    ArchiveFilePtr file = ImageFileLoader::openFileFromVFS(identifier, loader);
+
+    if (!file) return false;
+
+    requestStreamedImage(identifier, file, loader, texture);
+
+    return true;
+}
+
+void GLTextureManager::requestStreamedImage(const std::string& identifier,
+                                            const ArchiveFilePtr& file,
+                                            const ImageLoaderPtr& loader,
+                                            const StreamedTexturePtr& texture)
+{
+    _streamer.request(identifier, file, loader, texture, getMipMapOptions(identifier),
+        _diskCacheEnabled ? &_diskCache : NULL, getBaseCacheKey(identifier));
+}
+
+TexturePtr GLTextureManager::bindWithDiskCache(const NamedBindablePtr& bindable,
+                                              const std::string& identifier)
+{
+    MapExpressionPtr mapExpr = boost::dynamic_pointer_cast<MapExpression>(bindable);
+
+    if (!mapExpr || mapExpr->isCubeMap())
+    {
+        return bindable->bindTexture(identifier);
+    }
+
+    ImagePtr image = loadImage(mapExpr, identifier);
+
+    return image ? image->bindTexture(identifier) : TexturePtr();
+}
+
+ImagePtr GLTextureManager::loadImage(const MapExpressionPtr& mapExpr, const std::string& identifier)
+{
+    if (!_diskCacheEnabled)
+    {
+        ImagePtr image = mapExpr->getImage();
+
+        return image ? generateMipMaps(image, identifier) : ImagePtr();
+    }
+
+    // The contents of all source images are part of the key, so the cache
+    // doesn't need to be invalidated when the files change
+    TextureCacheKey key = getBaseCacheKey(identifier);
+
+    std::set<std::string> imageNames;
+    mapExpr->collectImageNames(imageNames);
+
+    for (std::set<std::string>::const_iterator i = imageNames.begin(); i != imageNames.end(); ++i)
+    {
+        ImageLoaderPtr loader;
+        ArchiveFilePtr file = ImageFileLoader::openFileFromVFS(*i, loader);
+
+        if (!file)
+        {
+            // Let the expression handle the error, without caching the result
+            ImagePtr image = mapExpr->getImage();
+
+            return image ? generateMipMaps(image, identifier) : ImagePtr();
+        }
+
+        MemoryArchiveFile contents(*file);
+
+        key.add(loader->getExtension());
+        key.add(contents.getData(), contents.size());
+    }
+
+    ImagePtr image = _diskCache.load(key.toString());
+
+    if (!image)
+    {
+        image = mapExpr->getImage();
+
+        if (!image) return ImagePtr();
+
+        image = generateMipMaps(image, identifier);
+
+        _diskCache.store(key.toString(), image);
+    }
+
+    return image;
+}
+
+TextureCacheKey GLTextureManager::getBaseCacheKey(const std::string& identifier)
+{
+    TextureCacheKey key;
+
+    key.add(identifier);
+    key.addValue(TextureManipulator::instance().getTextureQuality());
+    key.addValue(TextureManipulator::instance().getGamma());
+
+    MipMapImage::Options options = getMipMapOptions(identifier);
+
+    key.addValue(options.mipMaps.filter);
+    key.addValue(options.mipMaps.gammaCorrect);
+    key.addValue(options.compress);
+
+    return key;
+}
+
+MipMapImage::Options GLTextureManager::getMipMapOptions(const std::string& identifier)
+{
+    MipMapImage::Options options;
+
+    options.mipMaps.filter = _mipMapFilter;
+    options.mipMaps.gammaCorrect = _mipMapGammaCorrect && !isNormalMap(identifier);
+
+    // Only compress if the driver can decompress
+    options.compress = _compressionEnabled && GLEW_EXT_texture_compression_s3tc;
+
+    return options;
+}
+
+ImagePtr GLTextureManager::generateMipMaps(const ImagePtr& image, const std::string& identifier)
+{
+    if (image->isPrecompressed())
+    {
+        return image;
+    }
+
+    return MipMapImage::create(*image, getMipMapOptions(identifier));
+}
+
+void GLTextureManager::uploadStreamedTextures()
+{
+    if (!_shaderNotFoundImage)
+    {
+        _shaderNotFoundImage = ImageFileLoader::imageFromFile(
+            GlobalRegistry().get("user/paths/bitmapsPath") + SHADER_NOT_FOUND, "bmp"
+        );
+    }
+
+    _streamer.uploadDecodedTextures(_uploadBudgetUsec, _shaderNotFoundImage);
+
+    reloadReducedTextures();
+
+    _budget.evict();
+}
+
+void GLTextureManager::reloadReducedTextures()
+{
+    std::vector<TextureBudget::ReloadRequest> requests;
+    _budget.getReloadRequests(requests);
+
+    gint64 startTime = g_get_monotonic_time();
+
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        const TextureBudget::ReloadRequest& request = requests[i];
+
+        GLuint textureNum = request.texture->getGLTexNum();
+        std::string identifier = request.bindable->getIdentifier();
+
+        // Plain images are streamed back in, the budget is updated after the upload
+        StreamedTexturePtr streamed = boost::dynamic_pointer_cast<StreamedTexture>(request.texture);
+
+        if (_streamingEnabled && streamed && requestStreamedImage(identifier, streamed))
+        {
+            continue;
+        }
+
+        // Everything else is loaded right away, as long as the time budget allows
+        if (g_get_monotonic_time() - startTime >= _uploadBudgetUsec)
+        {
+            _budget.cancelReload(textureNum);
+            continue;
+        }
+
+        MapExpressionPtr mapExpr = boost::dynamic_pointer_cast<MapExpression>(request.bindable);
+        ImagePtr image = mapExpr ? loadImage(mapExpr, identifier) : ImagePtr();
+
+        // Textures which failed to load keep their reduced contents and are
+        // not requested again, measuring them would count them as reloaded
+        if (image)
+        {
+            image->uploadToTexture(textureNum);
+            _budget.update(textureNum);
+        }
+    }
+}
+
+void GLTextureManager::cancelStreaming()
+{
+    _streamer.cancel();
+}
+
+sigc::signal<void> GLTextureManager::signal_texturesStreamed() const
+{
+    return _streamer.signal_texturesDecoded();
+}
+
+void GLTextureManager::markTexturesVisible(const std::vector<GLuint>& textureNums)
+{
+    _budget.markVisible(textureNums);
+}
+
+TextureMemoryStats GLTextureManager::getMemoryStats() const
+{
+    return _budget.getStats();
+}
+
 // Return the shader-not-found texture, loading if necessary
 TexturePtr GLTextureManager::getShaderNotFound()
 {
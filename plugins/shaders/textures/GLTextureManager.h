@@ -5,11 +5,17 @@
 #include <map>
 #include "../MapExpression.h"
 #include "texturelib.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "TextureBudget.h"
+#include "MipMapImage.h"
+#include <sigc++/trackable.h>
 
 namespace shaders
 {
 
-class GLTextureManager
+class GLTextureManager :
+	public sigc::trackable
 {
 	// The mapping between texturekeys and Texture instances
 	typedef std::map<std::string, TexturePtr> TextureMap;
@@ -18,13 +24,78 @@ class GLTextureManager
 	// The fallback textures in case a texture is empty or broken
 	TexturePtr _shaderNotFound;
 
+	// Processed images from previous sessions
+	TextureCache _diskCache;
+
+	// Loads the image maps in the background
+	TextureStreamer _streamer;
+
+	// Keeps the video memory used by the map expression textures in check
+	TextureBudget _budget;
+
+	// Shown by streamed textures until their image is available
+	ImagePtr _streamingPlaceholder;
+
+	// Uploaded into streamed textures which failed to load
+	ImagePtr _shaderNotFoundImage;
+
+	// Cached registry values
+	bool _streamingEnabled;
+	gint64 _uploadBudgetUsec;
+	bool _diskCacheEnabled;
+	image::MipMapFilter _mipMapFilter;
+	bool _mipMapGammaCorrect;
+	bool _compressionEnabled;
+	std::size_t _memoryBudget;
+
 private:
 
 	// Constructs the fallback textures like "Shader Image Missing"
 	TexturePtr loadStandardTexture(const std::string& filename);
 
+	// Returns a texture which is loaded in the background, or NULL if the
+	// given bindable can't be streamed and needs to be bound right away
+	TexturePtr createStreamedTexture(const NamedBindablePtr& bindable,
+									 const std::string& identifier);
+
+	// Opens the image file and queues it for loading into the given texture
+	bool requestStreamedImage(const std::string& identifier, const StreamedTexturePtr& texture);
+
+	// Queues the already opened image file for loading into the given texture
+	void requestStreamedImage(const std::string& identifier, const ArchiveFilePtr& file,
+							  const ImageLoaderPtr& loader, const StreamedTexturePtr& texture);
+
+	// Binds the given bindable, map expressions are bound using loadImage()
+	TexturePtr bindWithDiskCache(const NamedBindablePtr& bindable,
+								 const std::string& identifier);
+
+	// Returns the image of the given map expression with its mipmaps,
+	// taking it from the disk cache if possible. Images which are not
+	// in the cache yet are stored there.
+	ImagePtr loadImage(const MapExpressionPtr& mapExpr, const std::string& identifier);
+
+	// Loads the full resolution of the textures the budget reduced
+	// and which are visible again
+	void reloadReducedTextures();
+
+	// Returns the cache key for the given map expression, without the
+	// source file contents
+	TextureCacheKey getBaseCacheKey(const std::string& identifier);
+
+	// Returns the mipmap settings for the given texture. Needs to be
+	// called on the main thread, it is checking the GL extensions.
+	MipMapImage::Options getMipMapOptions(const std::string& identifier);
+
+	// Generates the mipmaps of the given image, unless it is precompressed
+	ImagePtr generateMipMaps(const ImagePtr& image, const std::string& identifier);
+
+	void keyChanged();
+	void constructPreferences();
+
 public:
 
+	GLTextureManager();
+
     /**
      * \brief
      * Construct a bound texture from a generic named bindable.
@@ -53,6 +124,24 @@ public:
 	 */
 	void checkBindings();
 
+	/**
+	 * Uploads the textures which have been decoded in the background,
+	 * within the time budget set in the preferences. Needs a current
+	 * GL context.
+	 */
+	void uploadStreamedTextures();
+
+	// Drops all outstanding texture loads
+	void cancelStreaming();
+
+	// Emitted when streamed textures are ready to be uploaded
+	sigc::signal<void> signal_texturesStreamed() const;
+
+	// See MaterialManager::markTexturesVisible()
+	void markTexturesVisible(const std::vector<GLuint>& textureNums);
+
+	TextureMemoryStats getMemoryStats() const;
+
 };
 
 typedef boost::shared_ptr<GLTextureManager> GLTextureManagerPtr;
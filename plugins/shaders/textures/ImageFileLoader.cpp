@@ -52,8 +52,22 @@ ImageFileLoader::getGameFileImageLoaders()
 // Load image from VFS
 ImagePtr ImageFileLoader::imageFromVFS(const std::string& name)
 {
-	ImagePtr returnValue;
+	ImageLoaderPtr loader;
+	ArchiveFilePtr file = openFileFromVFS(name, loader);
+
+	// Has the file been loaded?
+	if (file != NULL) {
+		// Try to invoke the imageloader with a reference to the
+		// ArchiveFile
+		return loader->load(*file);
+	}
+
+	return ImagePtr();
+}
 
+ArchiveFilePtr ImageFileLoader::openFileFromVFS(const std::string& name,
+                                                ImageLoaderPtr& loader)
+{
 	const ImageLoaderList& loaders = getGameFileImageLoaders();
 	for (ImageLoaderList::const_iterator i = loaders.begin();
 		 i != loaders.end();
@@ -69,16 +83,13 @@ ImagePtr ImageFileLoader::imageFromVFS(const std::string& name)
 		// Try to open the file (will fail if the extension does not fit)
 		ArchiveFilePtr file = GlobalFileSystem().openFile(fullName);
 
-		// Has the file been loaded?
 		if (file != NULL) {
-			// Try to invoke the imageloader with a reference to the
-			// ArchiveFile
-			returnValue = ldr->load(*file);
-			break;
+			loader = ldr;
+			return file;
 		}
 	}
 
-	return returnValue;
+	return ArchiveFilePtr();
 }
 
 ImagePtr ImageFileLoader::imageFromFile(const std::string& filename,
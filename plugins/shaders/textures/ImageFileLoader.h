@@ -2,6 +2,7 @@
 #define FILELODER_H_
 
 #include "iimage.h"
+#include "iarchive.h"
 
 namespace shaders
 {
@@ -31,6 +32,15 @@ public:
      */
     static ImagePtr imageFromVFS(const std::string& vfsPath);
 
+    /**
+     * \brief
+     * Open the image file for the given VFS path (without extension) and
+     * return the loader capable of decoding it. Returns an empty pointer if
+     * no matching file exists.
+     */
+    static ArchiveFilePtr openFileFromVFS(const std::string& vfsPath,
+                                          ImageLoaderPtr& loader);
+
 	/**
      * \brief
      * Load an image from a filesystem path.
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "BasicTexture2D.h"
+#include <boost/weak_ptr.hpp>
+
+namespace shaders
+{
+
+/**
+ * A texture whose image is loaded in the background by the
+ * TextureStreamer. The GL texture object exists right from the start and
+ * shows a placeholder until the actual image has been uploaded into it, so
+ * the texture number handed out to the render system stays valid. The
+ * dimensions are read from the image header beforehand.
+ */
+class StreamedTexture :
+	public BasicTexture2D
+{
+	bool _loaded;
+
+public:
+	StreamedTexture(GLuint texNum, const std::string& name,
+					std::size_t width, std::size_t height) :
+		BasicTexture2D(texNum, name),
+		_loaded(false)
+	{
+		setWidth(width);
+		setHeight(height);
+	}
+
+	// Called after the actual image has been uploaded
+	void setLoaded()
+	{
+		_loaded = true;
+	}
+
+	bool isLoaded() const
+	{
+		return _loaded;
+	}
+};
+typedef boost::shared_ptr<StreamedTexture> StreamedTexturePtr;
+typedef boost::weak_ptr<StreamedTexture> StreamedTextureWeakPtr;
+
+} // namespace shaders
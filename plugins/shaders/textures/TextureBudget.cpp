@@ -0,0 +1,238 @@
+#include "TextureBudget.h"
+
+#include "itextstream.h"
+#include "StreamedTexture.h"
+
+#include <algorithm>
+
+namespace shaders
+{
+
+namespace
+{
+	// Textures are not reduced before they have been invisible for this long
+	const gint64 EVICTION_DELAY_USEC = 2000000;
+
+	// The eviction goes a bit below the budget, so it doesn't kick in every frame
+	const std::size_t EVICTION_TARGET_PERCENT = 90;
+
+	typedef std::pair<gint64, GLuint> EvictionCandidate;
+}
+
+TextureBudget::TextureBudget(const BackendPtr& backend) :
+	_backend(backend),
+	_budget(0),
+	_currentBytes(0),
+	_peakBytes(0),
+	_numReduced(0)
+{}
+
+void TextureBudget::setBudget(std::size_t bytes)
+{
+	_budget = bytes;
+}
+
+void TextureBudget::add(const TexturePtr& texture, const NamedBindablePtr& bindable)
+{
+	GLuint textureNum = texture->getGLTexNum();
+
+	if (textureNum == 0) return;
+
+	// Replace any entry of a texture which used this number before
+	remove(textureNum);
+
+	Entry& entry = _entries[textureNum];
+
+	entry.texture = texture;
+	entry.bindable = bindable;
+	entry.bytes = 0;
+	entry.lastUsed = _backend->getTime();
+	entry.reduced = false;
+	entry.reloading = false;
+
+	setBytes(entry, _backend->measureTexture(textureNum));
+}
+
+void TextureBudget::update(GLuint textureNum)
+{
+	EntryMap::iterator found = _entries.find(textureNum);
+
+	if (found == _entries.end()) return;
+
+	Entry& entry = found->second;
+
+	if (entry.reduced)
+	{
+		entry.reduced = false;
+		--_numReduced;
+	}
+
+	entry.reloading = false;
+
+	setBytes(entry, _backend->measureTexture(textureNum));
+}
+
+void TextureBudget::remove(GLuint textureNum)
+{
+	EntryMap::iterator found = _entries.find(textureNum);
+
+	if (found == _entries.end()) return;
+
+	setBytes(found->second, 0);
+
+	if (found->second.reduced)
+	{
+		--_numReduced;
+	}
+
+	_entries.erase(found);
+}
+
+void TextureBudget::markVisible(const std::vector<GLuint>& textureNums)
+{
+	gint64 now = _backend->getTime();
+
+	for (std::vector<GLuint>::const_iterator i = textureNums.begin(); i != textureNums.end(); ++i)
+	{
+		EntryMap::iterator found = _entries.find(*i);
+
+		if (found == _entries.end()) continue;
+
+		Entry& entry = found->second;
+
+		entry.lastUsed = now;
+
+		if (!entry.reduced || entry.reloading) continue;
+
+		TexturePtr texture = entry.texture.lock();
+
+		if (!texture) continue;
+
+		entry.reloading = true;
+
+		ReloadRequest request;
+		request.texture = texture;
+		request.bindable = entry.bindable;
+
+		_reloadRequests.push_back(request);
+	}
+}
+
+void TextureBudget::getReloadRequests(std::vector<ReloadRequest>& requests)
+{
+	requests.swap(_reloadRequests);
+	_reloadRequests.clear();
+}
+
+void TextureBudget::cancelReload(GLuint textureNum)
+{
+	EntryMap::iterator found = _entries.find(textureNum);
+
+	if (found != _entries.end())
+	{
+		found->second.reloading = false;
+	}
+}
+
+void TextureBudget::evict()
+{
+	if (_budget == 0 || _currentBytes <= _budget) return;
+
+	removeExpired();
+
+	gint64 now = _backend->getTime();
+
+	std::vector<EvictionCandidate> candidates;
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+	{
+		const Entry& entry = i->second;
+
+		if (entry.reduced || entry.reloading || now - entry.lastUsed < EVICTION_DELAY_USEC)
+		{
+			continue;
+		}
+
+		// Textures still loading in the background show their placeholder
+		StreamedTexturePtr streamed = boost::dynamic_pointer_cast<StreamedTexture>(entry.texture.lock());
+
+		if (streamed && !streamed->isLoaded()) continue;
+
+		candidates.push_back(EvictionCandidate(entry.lastUsed, i->first));
+	}
+
+	// Least recently used first
+	std::sort(candidates.begin(), candidates.end());
+
+	std::size_t target = _budget / 100 * EVICTION_TARGET_PERCENT;
+	std::size_t numEvicted = 0;
+	std::size_t bytesBefore = _currentBytes;
+
+	for (std::size_t i = 0; i < candidates.size() && _currentBytes > target; ++i)
+	{
+		GLuint textureNum = candidates[i].second;
+
+		std::size_t reducedSize = _backend->reduceTexture(textureNum);
+
+		if (reducedSize == 0) continue;
+
+		Entry& entry = _entries[textureNum];
+
+		entry.reduced = true;
+		++_numReduced;
+		++numEvicted;
+
+		setBytes(entry, reducedSize);
+	}
+
+	if (numEvicted > 0)
+	{
+		rMessage() << "[shaders] Texture budget exceeded, reduced " << numEvicted
+			<< " textures, freed " << ((bytesBefore - _currentBytes) >> 20) << " MB" << std::endl;
+	}
+}
+
+TextureMemoryStats TextureBudget::getStats() const
+{
+	TextureMemoryStats stats;
+
+	stats.currentBytes = _currentBytes;
+	stats.peakBytes = _peakBytes;
+	stats.budgetBytes = _budget;
+	stats.numTextures = _entries.size();
+	stats.numReduced = _numReduced;
+
+	return stats;
+}
+
+void TextureBudget::setBytes(Entry& entry, std::size_t bytes)
+{
+	_currentBytes = _currentBytes - entry.bytes + bytes;
+	_peakBytes = std::max(_peakBytes, _currentBytes);
+
+	entry.bytes = bytes;
+}
+
+void TextureBudget::removeExpired()
+{
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); /* in-loop increment */)
+	{
+		if (i->second.texture.expired())
+		{
+			setBytes(i->second, 0);
+
+			if (i->second.reduced)
+			{
+				--_numReduced;
+			}
+
+			_entries.erase(i++);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+} // namespace shaders
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ishaders.h"
+#include "../NamedBindable.h"
+
+#include <map>
+#include <vector>
+#include <glib.h>
+#include <boost/weak_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace shaders
+{
+
+/**
+ * Keeps track of the video memory used by the 2D textures of the
+ * GLTextureManager and keeps it within a budget. When the budget is exceeded,
+ * the least recently rendered textures are reduced to one of their smaller
+ * mipmaps. The GL texture numbers stay the same (the render system caches
+ * them), only the contents of the texture objects are replaced.
+ *
+ * The render system reports the textures it has drawn, reduced textures
+ * which become visible again are handed out for reloading.
+ *
+ * All methods need to be called on the main thread. The texture objects
+ * are measured and reduced by the Backend, which needs a current GL context
+ * in case of the GLTextureBudgetBackend.
+ */
+class TextureBudget
+{
+public:
+	// Access to the texture objects and the clock
+	class Backend
+	{
+	public:
+		virtual ~Backend() {}
+
+		// Returns the video memory used by all mipmap levels of the given texture
+		virtual std::size_t measureTexture(GLuint textureNum) = 0;
+
+		// Replaces the contents of the given texture with one of its smaller
+		// mipmaps, returns the new size in bytes or 0 if it can't be reduced
+		virtual std::size_t reduceTexture(GLuint textureNum) = 0;
+
+		// Monotonic time in microseconds
+		virtual gint64 getTime() = 0;
+	};
+	typedef boost::shared_ptr<Backend> BackendPtr;
+
+	// A reduced texture which needs its full resolution again
+	struct ReloadRequest
+	{
+		TexturePtr texture;
+		NamedBindablePtr bindable;
+	};
+
+private:
+	BackendPtr _backend;
+
+	struct Entry
+	{
+		boost::weak_ptr<Texture> texture;
+
+		// Used to reload the full resolution
+		NamedBindablePtr bindable;
+
+		// Video memory used by all mipmap levels
+		std::size_t bytes;
+
+		// Monotonic time of the last use in microseconds
+		gint64 lastUsed;
+
+		// True if the texture holds one of its smaller mipmaps only
+		bool reduced;
+
+		// True while the full resolution is being loaded
+		bool reloading;
+	};
+
+	// Entries by GL texture number
+	typedef std::map<GLuint, Entry> EntryMap;
+	EntryMap _entries;
+
+	std::vector<ReloadRequest> _reloadRequests;
+
+	std::size_t _budget;
+	std::size_t _currentBytes;
+	std::size_t _peakBytes;
+	std::size_t _numReduced;
+
+public:
+	TextureBudget(const BackendPtr& backend);
+
+	// Sets the budget in bytes, 0 disables the eviction
+	void setBudget(std::size_t bytes);
+
+	// Starts tracking the given texture, its size is queried from the backend
+	void add(const TexturePtr& texture, const NamedBindablePtr& bindable);
+
+	// Queries the size again after the contents of the texture changed,
+	// reduced textures count as reloaded afterwards
+	void update(GLuint textureNum);
+
+	// Stops tracking the given texture
+	void remove(GLuint textureNum);
+
+	/**
+	 * Marks the given textures as visible. Textures which have been reduced
+	 * are queued for reloading, see getReloadRequests(). This doesn't
+	 * touch any GL state.
+	 */
+	void markVisible(const std::vector<GLuint>& textureNums);
+
+	// Moves the queued reload requests to the given vector
+	void getReloadRequests(std::vector<ReloadRequest>& requests);
+
+	// The given texture stays reduced for now, it is queued again
+	// the next time it is visible
+	void cancelReload(GLuint textureNum);
+
+	/**
+	 * Reduces the textures which have not been visible for a while, least
+	 * recently used first, until the memory usage is below the budget.
+	 */
+	void evict();
+
+	TextureMemoryStats getStats() const;
+
+private:
+	// Sets the size of the given entry, keeping the totals up to date
+	void setBytes(Entry& entry, std::size_t bytes);
+
+	// Removes the entries of released textures
+	void removeExpired();
+};
+
+} // namespace shaders
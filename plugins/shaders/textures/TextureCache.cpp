@@ -0,0 +1,288 @@
+#include "TextureCache.h"
+
+#include "igl.h"
+#include "BasicTexture2D.h"
+#include "MipMapImage.h"
+
+#include <vector>
+#include <cstring>
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace shaders
+{
+
+namespace
+{
+	const std::string CACHE_FOLDER = "texturecache/";
+	const std::string CACHE_FILE_EXTENSION = ".dtex";
+
+	// Increase this whenever the file layout or the image processing changes
+	const guint32 CACHE_FILE_VERSION = 2;
+
+	const guint32 MAX_MIPMAPS = 32;
+
+	// The layout of the cache files: the header is followed by the mipmap
+	// table and the pixel data. Offsets are relative to the beginning of the file.
+	struct CacheFileHeader
+	{
+		char magic[4];
+		guint32 version;
+		guint32 format; // GL_RGBA or one of the compressed GL formats
+		guint32 numMipMaps;
+	};
+
+	struct CacheFileMipMap
+	{
+		guint32 width;
+		guint32 height;
+		guint32 size;
+		guint32 offset;
+	};
+
+	const char CACHE_FILE_MAGIC[4] = { 'D', 'R', 'T', 'X' };
+
+	// An image whose pixel data is memory-mapped from a cache file
+	class CachedImage :
+		public Image,
+		public boost::noncopyable
+	{
+		GMappedFile* _file;
+		const byte* _data;
+
+		GLenum _format;
+
+		std::vector<CacheFileMipMap> _mipMaps;
+
+	public:
+		// Takes ownership of the given file
+		CachedImage(GMappedFile* file, GLenum format, const std::vector<CacheFileMipMap>& mipMaps) :
+			_file(file),
+			_data(reinterpret_cast<const byte*>(g_mapped_file_get_contents(file))),
+			_format(format),
+			_mipMaps(mipMaps)
+		{}
+
+		~CachedImage()
+		{
+			g_mapped_file_unref(_file);
+		}
+
+		// Returns NULL if the mapped file is not a valid cache file
+		static ImagePtr createFromFile(GMappedFile* file)
+		{
+			const char* data = g_mapped_file_get_contents(file);
+			std::size_t length = g_mapped_file_get_length(file);
+
+			CacheFileHeader header;
+
+			if (data == NULL || length < sizeof(header))
+			{
+				return ImagePtr();
+			}
+
+			std::memcpy(&header, data, sizeof(header));
+
+			if (std::memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+				header.version != CACHE_FILE_VERSION ||
+				header.numMipMaps == 0 || header.numMipMaps > MAX_MIPMAPS ||
+				length < sizeof(header) + header.numMipMaps * sizeof(CacheFileMipMap))
+			{
+				return ImagePtr();
+			}
+
+			std::vector<CacheFileMipMap> mipMaps(header.numMipMaps);
+			std::memcpy(&mipMaps.front(), data + sizeof(header), header.numMipMaps * sizeof(CacheFileMipMap));
+
+			for (std::size_t i = 0; i < mipMaps.size(); ++i)
+			{
+				const CacheFileMipMap& mipMap = mipMaps[i];
+
+				if (static_cast<std::size_t>(mipMap.offset) + mipMap.size > length ||
+					(header.format == GL_RGBA && mipMap.size != mipMap.width * mipMap.height * 4))
+				{
+					return ImagePtr();
+				}
+			}
+
+			return ImagePtr(new CachedImage(file, static_cast<GLenum>(header.format), mipMaps));
+		}
+
+		byte* getMipMapPixels(std::size_t mipMapIndex) const
+		{
+			assert(mipMapIndex < _mipMaps.size());
+
+			// The file is mapped copy-on-write, so clients are free to modify the data
+			return const_cast<byte*>(_data + _mipMaps[mipMapIndex].offset);
+		}
+
+		std::size_t getWidth(std::size_t mipMapIndex) const
+		{
+			assert(mipMapIndex < _mipMaps.size());
+
+			return _mipMaps[mipMapIndex].width;
+		}
+
+		std::size_t getHeight(std::size_t mipMapIndex) const
+		{
+			assert(mipMapIndex < _mipMaps.size());
+
+			return _mipMaps[mipMapIndex].height;
+		}
+
+		bool isPrecompressed() const
+		{
+			return _format != GL_RGBA;
+		}
+
+		bool uploadToTexture(GLuint textureNum) const
+		{
+			glBindTexture(GL_TEXTURE_2D, textureNum);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			if (_format == GL_RGBA && _mipMaps.size() == 1)
+			{
+				// Generate the mipmaps, like RGBAImage does
+				glBindTexture(GL_TEXTURE_2D, 0);
+
+				return MipMapImage::create(*this, MipMapImage::Options())->uploadToTexture(textureNum);
+			}
+
+			glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+
+			for (std::size_t i = 0; i < _mipMaps.size(); ++i)
+			{
+				const CacheFileMipMap& mipMap = _mipMaps[i];
+
+				if (_format == GL_RGBA)
+				{
+					glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA,
+						static_cast<GLsizei>(mipMap.width), static_cast<GLsizei>(mipMap.height),
+						0, GL_RGBA, GL_UNSIGNED_BYTE, _data + mipMap.offset);
+				}
+				else
+				{
+					glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), _format,
+						static_cast<GLsizei>(mipMap.width), static_cast<GLsizei>(mipMap.height),
+						0, static_cast<GLsizei>(mipMap.size), _data + mipMap.offset);
+				}
+
+				// Handle unsupported format error
+				if (glGetError() == GL_INVALID_ENUM)
+				{
+					glBindTexture(GL_TEXTURE_2D, 0);
+					return false;
+				}
+			}
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(_mipMaps.size() - 1));
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			return true;
+		}
+
+		TexturePtr bindTexture(const std::string& name) const
+		{
+			GLuint textureNum;
+
+			GlobalOpenGL().assertNoErrors();
+
+			glGenTextures(1, &textureNum);
+
+			if (!uploadToTexture(textureNum))
+			{
+				glDeleteTextures(1, &textureNum);
+				return TexturePtr();
+			}
+
+			BasicTexture2DPtr texObj(new BasicTexture2D(textureNum, name));
+			texObj->setWidth(getWidth(0));
+			texObj->setHeight(getHeight(0));
+
+			GlobalOpenGL().assertNoErrors();
+
+			return texObj;
+		}
+	};
+
+	// Writes the given image in the cache file layout, mipMapImage is the same
+	// image if it is a MipMapImage, NULL otherwise
+	void writeCacheFile(std::ostream& stream, const Image& image, const MipMapImage* mipMapImage)
+	{
+		CacheFileHeader header;
+		std::memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+		header.version = CACHE_FILE_VERSION;
+		header.format = mipMapImage ? mipMapImage->getFormat() : GL_RGBA;
+		header.numMipMaps = mipMapImage ? static_cast<guint32>(mipMapImage->getNumMipMaps()) : 1;
+
+		std::vector<CacheFileMipMap> mipMaps(header.numMipMaps);
+
+		std::size_t fileSize = sizeof(header) + mipMaps.size() * sizeof(CacheFileMipMap);
+
+		for (std::size_t i = 0; i < mipMaps.size(); ++i)
+		{
+			CacheFileMipMap& mipMap = mipMaps[i];
+
+			mipMap.width = static_cast<guint32>(image.getWidth(i));
+			mipMap.height = static_cast<guint32>(image.getHeight(i));
+			mipMap.size = mipMapImage ? static_cast<guint32>(mipMapImage->getMipMapSize(i)) : mipMap.width * mipMap.height * 4;
+			mipMap.offset = static_cast<guint32>(fileSize);
+
+			fileSize += mipMap.size;
+		}
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(&mipMaps.front()), mipMaps.size() * sizeof(CacheFileMipMap));
+
+		for (std::size_t i = 0; i < mipMaps.size(); ++i)
+		{
+			stream.write(reinterpret_cast<const char*>(image.getMipMapPixels(i)), mipMaps[i].size);
+		}
+	}
+}
+
+TextureCache::TextureCache() :
+	_cache(CACHE_FOLDER, CACHE_FILE_EXTENSION, 0)
+{}
+
+void TextureCache::setMaxSize(std::size_t maxSize)
+{
+	_cache.setMaxSize(maxSize);
+}
+
+ImagePtr TextureCache::load(const std::string& key)
+{
+	// Mapped copy-on-write, clients may modify the pixels of the image
+	GMappedFile* file = _cache.open(key, true);
+
+	if (file == NULL)
+	{
+		return ImagePtr();
+	}
+
+	ImagePtr image = CachedImage::createFromFile(file);
+
+	if (!image)
+	{
+		g_mapped_file_unref(file);
+		_cache.remove(key);
+	}
+
+	return image;
+}
+
+void TextureCache::store(const std::string& key, const ImagePtr& image)
+{
+	// Images with generated mipmaps are stored including all levels, they
+	// might be compressed. Other images are stored as single RGBA level.
+	MipMapImagePtr mipMapImage = boost::dynamic_pointer_cast<MipMapImage>(image);
+
+	if (!image || (!mipMapImage && image->isPrecompressed())) return;
+
+	_cache.store(key, boost::bind(&writeCacheFile, _1, boost::cref(*image), mipMapImage.get()));
+}
+
+} // namespace shaders
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "iimage.h"
+#include "DiskCache.h"
+
+#include <string>
+
+namespace shaders
+{
+
+/**
+ * Accumulates everything the result of a map expression depends on
+ * (the expression itself, the contents of its source images and the image
+ * processing settings), used to look up the processed image in the
+ * TextureCache.
+ */
+typedef DiskCacheKey TextureCacheKey;
+
+/**
+ * Persistent, content-addressed disk cache of processed images,
+ * located in the user's settings folder, see DiskCache. Cached images are
+ * memory-mapped when loaded.
+ *
+ * Load and store are thread-safe, they're used by the TextureStreamer jobs.
+ */
+class TextureCache
+{
+	DiskCache _cache;
+
+public:
+	TextureCache();
+
+	// Sets the size limit in bytes, removes old files if necessary
+	void setMaxSize(std::size_t maxSize);
+
+	/**
+	 * Returns the cached image for the given key (see TextureCacheKey),
+	 * or NULL if there is none.
+	 */
+	ImagePtr load(const std::string& key);
+
+	/**
+	 * Writes the given image to the cache. MipMapImages are stored with
+	 * all their levels. Other precompressed images (DDS) are not stored,
+	 * they don't need any processing anyway.
+	 */
+	void store(const std::string& key, const ImagePtr& image);
+};
+
+} // namespace shaders
@@ -8,6 +8,7 @@
 #include "ipreferencesystem.h"
 #include "../Doom3ShaderSystem.h"
 #include "RGBAImage.h"
+#include "image/ImageKernels.h"
 
 namespace 
 {
@@ -93,6 +94,16 @@ Vector3 TextureManipulator::getFlatshadeColour(const ImagePtr& input) {
 	return returnValue;
 }
 
+float TextureManipulator::getGamma() const
+{
+	return _gamma;
+}
+
+std::size_t TextureManipulator::getTextureQuality() const
+{
+	return _textureQuality;
+}
+
 ImagePtr TextureManipulator::getProcessedImage(const ImagePtr& input) {
 
 	ImagePtr output;
@@ -185,14 +196,8 @@ ImagePtr TextureManipulator::processGamma(const ImagePtr& input) {
 	// Set the pixel pointer to the very first pixel
 	byte* pixels = input->getMipMapPixels(0);
 
-	// Go over all the pixels and change their value accordingly
-	for (std::size_t i = 0; i < (numPixels*4); i += 4)
-	{
-		// Change the current RGB pixel value to the one in the gamma table
-		pixels[i] = _gammaTable[pixels[i]];
-		(pixels + 1)[i] = _gammaTable[(pixels + 1)[i]];
-		(pixels + 2)[i] = _gammaTable[(pixels + 2)[i]];
-	}
+	// Change the RGB values of all pixels to the ones in the gamma table
+	image::getKernels().applyGammaTable(pixels, numPixels, _gammaTable);
 
 	return input;
 }
@@ -294,6 +299,13 @@ R_ResampleTexture
 void TextureManipulator::resampleTexture(const void *indata, std::size_t inwidth, std::size_t inheight,
 										 void *outdata,  std::size_t outwidth, std::size_t outheight, int bytesperpixel)
 {
+	// RGBA images are handled by the vectorised image kernels
+	if (bytesperpixel == 4) {
+		image::resample(static_cast<const byte*>(indata), inwidth, inheight,
+						static_cast<byte*>(outdata), outwidth, outheight);
+		return;
+	}
+
 	if (rowsize < outwidth * bytesperpixel) {
 		if (row1)
 			free(row1);
@@ -305,96 +317,7 @@ void TextureManipulator::resampleTexture(const void *indata, std::size_t inwidth
 		row2 = (byte *)malloc(rowsize);
 	}
 
-	if (bytesperpixel == 4) {
-		std::size_t i, yi, oldy, f, fstep, lerp, endy = (inheight-1), inwidth4 = inwidth*4, outwidth4 = outwidth*4;
-		long j;
-		byte *inrow, *out;
-		out = (byte *)outdata;
-		fstep = (int) (inheight * 65536.0f / outheight);
-#define LERPBYTE(i) out[i] = (byte) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i])
-
-		inrow = (byte *)indata;
-		oldy = 0;
-		resampleTextureLerpLine(inrow, row1, inwidth, outwidth, bytesperpixel);
-		resampleTextureLerpLine(inrow + inwidth4, row2, inwidth, outwidth, bytesperpixel);
-
-		for (i = 0, f = 0;i < outheight;i++,f += fstep) {
-			yi = f >> 16;
-			if (yi < endy) {
-				lerp = f & 0xFFFF;
-				if (yi != oldy) {
-					inrow = (byte *)indata + inwidth4 * yi;
-					if (yi == oldy+1)
-						memcpy(row1, row2, outwidth4);
-					else
-						resampleTextureLerpLine(inrow, row1, inwidth, outwidth, bytesperpixel);
-
-					resampleTextureLerpLine(inrow + inwidth4, row2, inwidth, outwidth, bytesperpixel);
-					oldy = yi;
-				}
-				j = static_cast<long>(outwidth - 4);
-				while (j >= 0) {
-					LERPBYTE( 0);
-					LERPBYTE( 1);
-					LERPBYTE( 2);
-					LERPBYTE( 3);
-					LERPBYTE( 4);
-					LERPBYTE( 5);
-					LERPBYTE( 6);
-					LERPBYTE( 7);
-					LERPBYTE( 8);
-					LERPBYTE( 9);
-					LERPBYTE(10);
-					LERPBYTE(11);
-					LERPBYTE(12);
-					LERPBYTE(13);
-					LERPBYTE(14);
-					LERPBYTE(15);
-					out += 16;
-					row1 += 16;
-					row2 += 16;
-					j -= 4;
-				}
-				if (j & 2) {
-					LERPBYTE( 0);
-					LERPBYTE( 1);
-					LERPBYTE( 2);
-					LERPBYTE( 3);
-					LERPBYTE( 4);
-					LERPBYTE( 5);
-					LERPBYTE( 6);
-					LERPBYTE( 7);
-					out += 8;
-					row1 += 8;
-					row2 += 8;
-				}
-				if (j & 1) {
-					LERPBYTE( 0);
-					LERPBYTE( 1);
-					LERPBYTE( 2);
-					LERPBYTE( 3);
-					out += 4;
-					row1 += 4;
-					row2 += 4;
-				}
-				row1 -= outwidth4;
-				row2 -= outwidth4;
-			}
-			else {
-				if (yi != oldy) {
-					inrow = (byte *)indata + inwidth4*yi;
-					if (yi == oldy+1)
-						memcpy(row1, row2, outwidth4);
-					else
-						resampleTextureLerpLine(inrow, row1, inwidth, outwidth, bytesperpixel);
-
-					oldy = yi;
-				}
-				memcpy(out, row1, outwidth4);
-			}
-		}
-	}
-	else if (bytesperpixel == 3) {
+	if (bytesperpixel == 3) {
 		std::size_t i, yi, oldy, f, fstep, lerp, endy = (inheight-1), inwidth3 = inwidth * 3, outwidth3 = outwidth * 3;
 		long j;
 		byte *inrow, *out;
@@ -485,61 +408,12 @@ void TextureManipulator::mipReduce(byte *in, byte *out,
 								   std::size_t width, std::size_t height,
 								   std::size_t destwidth, std::size_t destheight)
 {
-	std::size_t x, y, width2, height2, nextrow;
-	if (width > destwidth) {
-		if (height > destheight) {
-			// reduce both
-			width2 = width >> 1;
-			height2 = height >> 1;
-			nextrow = width << 2;
-			for (y = 0;y < height2;y++) {
-				for (x = 0;x < width2;x++) {
-					out[0] = (byte) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
-					out[1] = (byte) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
-					out[2] = (byte) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
-					out[3] = (byte) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
-					out += 4;
-					in += 8;
-				}
-				in += nextrow; // skip a line
-			}
-		}
-		else {
-			// reduce width
-			width2 = width >> 1;
-			for (y = 0;y < height;y++) {
-				for (x = 0;x < width2;x++) {
-					out[0] = (byte) ((in[0] + in[4]) >> 1);
-					out[1] = (byte) ((in[1] + in[5]) >> 1);
-					out[2] = (byte) ((in[2] + in[6]) >> 1);
-					out[3] = (byte) ((in[3] + in[7]) >> 1);
-					out += 4;
-					in += 8;
-				}
-			}
-		}
-	}
-	else {
-		if (height > destheight) {
-			// reduce height
-			height2 = height >> 1;
-			nextrow = width << 2;
-			for (y = 0;y < height2;y++) {
-				for (x = 0;x < width;x++) {
-					out[0] = (byte) ((in[0] + in[nextrow  ]) >> 1);
-					out[1] = (byte) ((in[1] + in[nextrow+1]) >> 1);
-					out[2] = (byte) ((in[2] + in[nextrow+2]) >> 1);
-					out[3] = (byte) ((in[3] + in[nextrow+3]) >> 1);
-					out += 4;
-					in += 4;
-				}
-				in += nextrow; // skip a line
-			}
-		}
-		else {
-			rMessage() << "GL_MipReduce: desired size already achieved\n";
-		}
+	if (width <= destwidth && height <= destheight) {
+		rMessage() << "GL_MipReduce: desired size already achieved\n";
+		return;
 	}
+
+	image::getKernels().mipReduce(in, out, width, height, width > destwidth, height > destheight);
 }
 
 /* greebo: This gets called by the preference system and is responsible for adding the
@@ -55,6 +55,10 @@ public:
 	 */
 	Vector3 getFlatshadeColour(const ImagePtr& input);
 
+	// The current gamma and quality settings, these affect the processed images
+	float getGamma() const;
+	std::size_t getTextureQuality() const;
+
 private:
 	void keyChanged();
 
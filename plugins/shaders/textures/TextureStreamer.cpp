@@ -0,0 +1,231 @@
+#include "TextureStreamer.h"
+
+#include "iradiant.h"
+#include "ithread.h"
+#include "itextstream.h"
+#include "archivelib.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace shaders
+{
+
+namespace
+{
+	// Maximum number of thread pool jobs decoding images at the same time
+	const std::size_t MAX_WORKERS = 4;
+
+	inline double toMsec(gint64 usec)
+	{
+		return usec / 1000.0;
+	}
+}
+
+TextureStreamer::TextureStreamer() :
+	_logLatencies(false),
+	_queue(&TextureStreamer::process, MAX_WORKERS)
+{}
+
+TextureStreamer::~TextureStreamer()
+{
+	cancel();
+}
+
+void TextureStreamer::request(const std::string& name, const ArchiveFilePtr& file,
+							  const ImageLoaderPtr& loader, const StreamedTexturePtr& texture,
+							  const MipMapImage::Options& mipMapOptions,
+							  TextureCache* cache, const TextureCacheKey& cacheKey)
+{
+	RequestQueue::RequestPtr request(new Request);
+
+	request->name = name;
+	request->file = file;
+	request->loader = loader;
+	request->texture = texture;
+	request->mipMapOptions = mipMapOptions;
+	request->cache = cache;
+	request->cacheKey = cacheKey;
+	request->fromCache = false;
+	request->requestTime = g_get_monotonic_time();
+	request->decodeStartTime = request->requestTime;
+	request->decodeEndTime = request->requestTime;
+
+	_queue.push(request);
+}
+
+void TextureStreamer::process(Request& request)
+{
+	request.decodeStartTime = g_get_monotonic_time();
+
+	// Don't bother decoding textures which have been released already
+	if (!request.texture.expired())
+	{
+		request.image = decode(request);
+	}
+
+	// Release the file handle before the request goes back to the main thread
+	request.file.reset();
+
+	request.decodeEndTime = g_get_monotonic_time();
+}
+
+ImagePtr TextureStreamer::decode(Request& request)
+{
+	if (request.cache == NULL)
+	{
+		return generateMipMaps(request, request.loader->load(*request.file));
+	}
+
+	// Read the file into memory, its contents are part of the cache key
+	MemoryArchiveFile file(*request.file);
+
+	request.cacheKey.add(request.loader->getExtension());
+	request.cacheKey.add(file.getData(), file.size());
+
+	std::string key = request.cacheKey.toString();
+
+	ImagePtr image = request.cache->load(key);
+
+	if (image)
+	{
+		request.fromCache = true;
+		return image;
+	}
+
+	image = generateMipMaps(request, request.loader->load(file));
+
+	request.cache->store(key, image);
+
+	return image;
+}
+
+ImagePtr TextureStreamer::generateMipMaps(const Request& request, const ImagePtr& image)
+{
+	if (!image || image->isPrecompressed())
+	{
+		return image;
+	}
+
+	return MipMapImage::create(*image, request.mipMapOptions);
+}
+
+void TextureStreamer::uploadDecodedTextures(gint64 budgetUsec, const ImagePtr& fallback)
+{
+	RequestQueue::Requests decoded;
+	_queue.takeFinishedRequests(decoded);
+
+	if (decoded.empty())
+	{
+		reportStatistics();
+		return;
+	}
+
+	gint64 startTime = g_get_monotonic_time();
+
+	std::size_t i = 0;
+
+	for (; i < decoded.size(); ++i)
+	{
+		if (i > 0 && g_get_monotonic_time() - startTime >= budgetUsec)
+		{
+			break; // continue in the next slice
+		}
+
+		const Request& request = *decoded[i];
+
+		request.log.writeToLog();
+
+		StreamedTexturePtr texture = request.texture.lock();
+
+		if (!texture) continue; // released in the meantime
+
+		if (!request.image || !request.image->uploadToTexture(texture->getGLTexNum()))
+		{
+			rError() << "[shaders] Unable to load texture: " << request.name << std::endl;
+
+			if (fallback)
+			{
+				fallback->uploadToTexture(texture->getGLTexNum());
+			}
+
+			texture->setLoaded();
+			_sigTextureUploaded.emit(texture->getGLTexNum());
+			continue;
+		}
+
+		texture->setLoaded();
+		_sigTextureUploaded.emit(texture->getGLTexNum());
+
+		gint64 uploadTime = g_get_monotonic_time();
+
+		if (_logLatencies)
+		{
+			rMessage() << "[shaders] Streamed " << request.name << " ("
+				<< texture->getWidth() << "x" << texture->getHeight() << "): waited "
+				<< toMsec(request.decodeStartTime - request.requestTime) << " ms, decoded in "
+				<< toMsec(request.decodeEndTime - request.decodeStartTime)
+				<< (request.fromCache ? " ms (cached), available after " : " ms, available after ")
+				<< toMsec(uploadTime - request.requestTime) << " ms" << std::endl;
+		}
+
+		++_statistics.numTextures;
+
+		if (request.fromCache)
+		{
+			++_statistics.numFromCache;
+		}
+
+		_statistics.totalWait += request.decodeStartTime - request.requestTime;
+		_statistics.totalDecode += request.decodeEndTime - request.decodeStartTime;
+		_statistics.maxAvailable = std::max(_statistics.maxAvailable,
+			uploadTime - request.requestTime);
+	}
+
+	// Release the images we're done with, the rest is uploaded in the next slice
+	decoded.erase(decoded.begin(), decoded.begin() + i);
+
+	if (!decoded.empty())
+	{
+		_queue.returnFinishedRequests(decoded);
+		return;
+	}
+
+	reportStatistics();
+}
+
+void TextureStreamer::reportStatistics()
+{
+	// More textures are on their way if the queue is busy, report them all at once
+	if (_statistics.numTextures == 0 || !_queue.isIdle()) return;
+
+	rMessage() << "[shaders] Streamed " << _statistics.numTextures << " textures ("
+		<< _statistics.numFromCache << " from the cache), average wait "
+		<< toMsec(_statistics.totalWait / _statistics.numTextures) << " ms, average decode "
+		<< toMsec(_statistics.totalDecode / _statistics.numTextures) << " ms, all available after "
+		<< toMsec(_statistics.maxAvailable) << " ms" << std::endl;
+
+	_statistics.reset();
+}
+
+void TextureStreamer::cancel()
+{
+	_queue.cancel();
+}
+
+void TextureStreamer::setLogLatencies(bool logLatencies)
+{
+	_logLatencies = logLatencies;
+}
+
+sigc::signal<void> TextureStreamer::signal_texturesDecoded() const
+{
+	return _queue.signal_requestsFinished();
+}
+
+sigc::signal<void, GLuint> TextureStreamer::signal_textureUploaded() const
+{
+	return _sigTextureUploaded;
+}
+
+} // namespace shaders
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "iimage.h"
+#include "iarchive.h"
+#include "ithread.h"
+#include "StreamedTexture.h"
+#include "TextureCache.h"
+#include "MipMapImage.h"
+#include "BackgroundRequestQueue.h"
+
+#include <sigc++/signal.h>
+#include <boost/weak_ptr.hpp>
+
+namespace shaders
+{
+
+/**
+ * Loads textures asynchronously. The image files are opened on the
+ * main thread, reading and decoding them is done by a BackgroundRequestQueue
+ * in a limited number of thread pool jobs. The decoded images
+ * are uploaded to OpenGL on the main thread in time-budgeted slices, see
+ * uploadDecodedTextures(). The messages of the image loaders are collected
+ * per request and written to the log when the image is uploaded.
+ */
+class TextureStreamer
+{
+	struct Request
+	{
+		std::string name;
+
+		// Opened on the main thread, read and closed by the worker
+		ArchiveFilePtr file;
+		ImageLoaderPtr loader;
+
+		// How to generate the mipmaps of uncompressed images
+		MipMapImage::Options mipMapOptions;
+
+		// The disk cache to use, NULL if disabled. The key is completed
+		// by the worker, using the file contents.
+		TextureCache* cache;
+		TextureCacheKey cacheKey;
+
+		// Set by the worker
+		ImagePtr image;
+		bool fromCache;
+
+		// The log output of the loaders, written by the main thread
+		CapturedLog log;
+
+		// The texture to receive the image, might have been released meanwhile
+		StreamedTextureWeakPtr texture;
+
+		// Timestamps in microseconds, for the latency statistics
+		gint64 requestTime;
+		gint64 decodeStartTime;
+		gint64 decodeEndTime;
+	};
+	typedef BackgroundRequestQueue<Request> RequestQueue;
+
+	// Latencies of the textures uploaded since the streamer was last idle,
+	// only accessed by the main thread
+	struct Statistics
+	{
+		std::size_t numTextures;
+		std::size_t numFromCache;
+		gint64 totalWait;
+		gint64 totalDecode;
+		gint64 maxAvailable;
+
+		Statistics()
+		{
+			reset();
+		}
+
+		void reset()
+		{
+			numTextures = numFromCache = 0;
+			totalWait = totalDecode = maxAvailable = 0;
+		}
+	};
+	Statistics _statistics;
+
+	// Write the latencies of every texture to the log, not just the summary
+	bool _logLatencies;
+
+	// Decodes the requests, holds them until they are uploaded
+	RequestQueue _queue;
+
+	sigc::signal<void, GLuint> _sigTextureUploaded;
+
+public:
+	TextureStreamer();
+
+	// Cancels all pending requests and waits for the running decodes
+	~TextureStreamer();
+
+	/**
+	 * Queues the given file for decoding, the image is uploaded into the
+	 * given texture afterwards. The mipmaps of uncompressed images are
+	 * generated by the worker, using the given options. If a cache is passed,
+	 * the processed image is looked up there first, using the given key plus
+	 * the file contents.
+	 */
+	void request(const std::string& name, const ArchiveFilePtr& file,
+				 const ImageLoaderPtr& loader, const StreamedTexturePtr& texture,
+				 const MipMapImage::Options& mipMapOptions,
+				 TextureCache* cache, const TextureCacheKey& cacheKey);
+
+	/**
+	 * Uploads decoded images to OpenGL until the given time budget (in
+	 * microseconds) is used up, at least one image is uploaded per call.
+	 * Images which failed to load are replaced with the given fallback.
+	 * Needs to be called on the main thread with a current GL context.
+	 */
+	void uploadDecodedTextures(gint64 budgetUsec, const ImagePtr& fallback);
+
+	// Drops the pending requests and waits for the running decodes to finish
+	void cancel();
+
+	// Enables a log line with the wait, decode and availability times per texture
+	void setLogLatencies(bool logLatencies);
+
+	// Emitted on the main thread when decoded images are waiting for upload
+	sigc::signal<void> signal_texturesDecoded() const;
+
+	// Emitted after an image has been uploaded, passing the texture number
+	sigc::signal<void, GLuint> signal_textureUploaded() const;
+
+private:
+	// Decodes a single request, called on a worker thread
+	static void process(Request& request);
+
+	// Loads the image of the given request, from the cache if possible
+	static ImagePtr decode(Request& request);
+
+	// Generates the mipmaps of the given image, unless it is precompressed
+	static ImagePtr generateMipMaps(const Request& request, const ImagePtr& image);
+
+	// Logs the collected latencies once all requests have been uploaded
+	void reportStatistics();
+};
+
+} // namespace shaders
@@ -3,6 +3,8 @@
 #include "itextstream.h"
 #include "ifilesystem.h"
 #include "iarchive.h"
+#include "parser/ParallelDeclLoader.h"
+#include "debugging/ScopedDebugTimer.h"
 
 #include <iostream>
 
@@ -13,45 +15,7 @@ namespace {
 /* CONSTANTS */
 const char* SKINS_FOLDER = "skins/";
 
-/**
- * Filesystem traversal functor to load .skin files from the skins/ directory.
- * The functor opens each file and passes the contents (as a string) back to
- * the Doom3SkinCache module for parsing.
- */
-class SkinLoader :
-	public VirtualFileSystem::Visitor
-{
-	// Doom3SkinCache to parse files
-	Doom3SkinCache& _cache;
-
-public:
-
-	// Required typedef
-	typedef const std::string& first_argument_type;
-
-	// Constructor
-	SkinLoader(Doom3SkinCache& c)
-	: _cache(c)
-	{}
-
-	// Functor operator
-	void visit(const std::string& fileName)
-	{
-		// Open the .skin file and get its contents as a std::string
-		ArchiveTextFilePtr file =
-			GlobalFileSystem().openTextFile(SKINS_FOLDER + fileName);
-		assert(file);
-		std::istream is(&(file->getInputStream()));
-
-		try {
-			// Pass the contents back to the SkinCache module for parsing
-			_cache.parseFile(is, fileName);
-		}
-		catch (parser::ParseException& e) {
-			std::cout << "[skins]: in " << fileName << ": " << e.what() << std::endl;
-		}
-	}
-};
+typedef parser::TokenListTokeniser::Tokens Tokens;
 
 } // blank namespace
 
@@ -64,16 +28,27 @@ void Doom3SkinCache::realise() {
 
 	rMessage() << "[skins] Loading skins." << std::endl;
 
-	// Use a functor to traverse the skins directory, catching any parse
-	// exceptions that may be thrown
-	try
+	// Tokenise the .skin files on several threads
+	parser::ParallelDeclLoader<Tokens> loader(SKINS_FOLDER, &parser::tokeniseDefs);
+	GlobalFileSystem().forEachFile(SKINS_FOLDER, "skin", loader);
+
 	{
-		SkinLoader loader(*this);
-		GlobalFileSystem().forEachFile(SKINS_FOLDER, "skin", loader);
+		ScopedDebugTimer timer("Skins tokenised: ");
+		loader.run();
 	}
-	catch (parser::ParseException& e)
+
+	ScopedDebugTimer timer("Skins parsed: ");
+
+	// Parse the files in VFS order, the first definition of a skin wins
+	parser::ParallelDeclLoader<Tokens>::Files& files = loader.getFiles();
+
+	for (std::size_t i = 0; i < files.size(); ++i)
 	{
-		std::cout << "[skins]: " << e.what() << std::endl;
+		assert(files[i].opened);
+
+		// A tokeniser error is reported by parseFile() like any parse error
+		parser::TokenListTokeniser tok(files[i].result, files[i].error);
+		parseFile(tok, files[i].name);
 	}
 
 	// Set the realised flag
@@ -81,10 +56,7 @@ void Doom3SkinCache::realise() {
 }
 
 // Parse the contents of a .skin file
-void Doom3SkinCache::parseFile(std::istream& contents, const std::string& filename) {
-
-	// Construct a DefTokeniser to parse the file
-	parser::BasicDefTokeniser<std::istream> tok(contents);
+void Doom3SkinCache::parseFile(parser::DefTokeniser& tok, const std::string& filename) {
 
 	// Call the parseSkin() function for each skin decl
 	while (tok.hasMoreTokens()) {
@@ -89,12 +89,12 @@ public:
 	 */
 	void refresh();
 
-	/* Parse the provided istream as a .skin file, and add all skins found within
+	/* Parse the tokens of a .skin file, and add all skins found within
 	 * to the internal data structures.
 	 *
 	 * @filename: This is for informational purposes only (error message display).
 	 */
-	void parseFile(std::istream& contents, const std::string& filename);
+	void parseFile(parser::DefTokeniser& tok, const std::string& filename);
 
 	// RegisterableModule implementation
 	virtual const std::string& getName() const;
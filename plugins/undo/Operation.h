@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include "SnapShot.h"
 
 namespace undo
 {
@@ -14,10 +15,14 @@ private:
 	// The name of the UndoOperaton
 	std::string _command;
 
+	// The memory occupied by the snapshot, calculated by finish()
+	std::size_t _memorySize;
+
 public:
 	// Constructor
 	Operation(const std::string& command) :
-		_command(command)
+		_command(command),
+		_memorySize(0)
 	{}
 
 	const std::string& getName() const
@@ -39,6 +44,18 @@ public:
 	{
 		_snapshot.restore();
 	}
+
+	// Called when the operation is complete, reduces the snapshot to the changed states
+	void finish(const std::set<IUndoable*>& released)
+	{
+		_snapshot.compact(released);
+		_memorySize = sizeof(*this) + _command.capacity() + _snapshot.getMemorySize();
+	}
+
+	std::size_t getMemorySize() const
+	{
+		return _memorySize;
+	}
 };
 typedef std::shared_ptr<Operation> OperationPtr;
 
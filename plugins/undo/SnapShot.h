@@ -1,6 +1,9 @@
 #pragma once
 
 #include "iundo.h"
+#include <list>
+#include <set>
+#include <algorithm>
 
 namespace undo
 {
@@ -27,6 +30,19 @@ public:
 	{
 		_undoable.importState(_data);
 	}
+
+	// Replaces the saved state with the delta against the current state,
+	// returns false if the Undoable didn't change at all
+	bool compactState()
+	{
+		_data = _undoable.compactState(_data);
+		return _data.get() != NULL;
+	}
+
+	std::size_t getMemorySize() const
+	{
+		return sizeof(*this) + _data->getMemorySize();
+	}
 };
 
 /** 
@@ -58,6 +74,38 @@ public:
 			state.restoreState();
 		});
 	}
+
+	// Reduces the saved states to deltas once the operation is complete and drops
+	// the ones which didn't change. Undoables which have been released during the
+	// operation might be gone already, their states are kept as they are.
+	void compact(const std::set<IUndoable*>& released)
+	{
+		for (iterator i = begin(); i != end(); /* in-loop */)
+		{
+			if (released.find(&i->_undoable) != released.end() || i->compactState())
+			{
+				++i;
+			}
+			else
+			{
+				erase(i++);
+			}
+		}
+	}
+
+	// Returns the approximate number of bytes occupied by the saved states
+	std::size_t getMemorySize() const
+	{
+		std::size_t size = 0;
+
+		for (const_iterator i = begin(); i != end(); ++i)
+		{
+			// Each list node has two pointers in addition to the keeper
+			size += i->getMemorySize() + 2 * sizeof(void*);
+		}
+
+		return size;
+	}
 };
 
 } // namespace undo
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "debugging/debugging.h"
+#include <list>
+#include <set>
 
 namespace undo
 {
@@ -24,7 +26,16 @@ class UndoStack
 	// The pending undo operation (a working variable, so to say)
 	OperationPtr _pending;
 
+	// The memory occupied by all finished operations
+	std::size_t _memorySize;
+
+	// The Undoables which released their state saver since start()
+	std::set<IUndoable*> _released;
+
 public:
+	UndoStack() :
+		_memorySize(0)
+	{}
 
 	bool empty() const
 	{
@@ -48,17 +59,43 @@ public:
 
 	void pop_front()
 	{
+		_memorySize -= _stack.front()->getMemorySize();
 		_stack.pop_front();
 	}
 
 	void pop_back()
 	{
+		_memorySize -= _stack.back()->getMemorySize();
 		_stack.pop_back();
 	}
 
 	void clear()
 	{
 		_stack.clear();
+		_memorySize = 0;
+	}
+
+	// Returns the approximate number of bytes used by the operations on this stack
+	std::size_t getMemorySize() const
+	{
+		return _memorySize;
+	}
+
+	// Drops the oldest operations until the stack fits into the given number
+	// of bytes, the most recent operation is always kept
+	void trim(std::size_t maxMemorySize)
+	{
+		while (_stack.size() > 1 && _memorySize > maxMemorySize)
+		{
+			pop_front();
+		}
+	}
+
+	// Gets called when an Undoable is detached from the undo system, it might
+	// be destroyed before the current operation is finished
+	void release(IUndoable& undoable)
+	{
+		_released.insert(&undoable);
 	}
 
 	// Allocate a new Operation to work with
@@ -69,6 +106,7 @@ public:
 			_pending.reset();
 		}
 
+		_released.clear();
 		_pending.reset(new Operation(command));
 	}
 
@@ -78,6 +116,7 @@ public:
 		if (_pending)
 		{
 			_pending.reset();
+			_released.clear();
 			return false;
 		}
 		else 
@@ -85,6 +124,12 @@ public:
 			// Rename the last undo operation (it was "unnamed" till now)
 			ASSERT_MESSAGE(!_stack.empty(), "undo stack empty");
 			_stack.back()->setName(command);
+
+			// Reduce the saved states to the parts which actually changed
+			_stack.back()->finish(_released);
+			_memorySize += _stack.back()->getMemorySize();
+			_released.clear();
+
 			return true;
 		}
 	}
@@ -106,4 +151,18 @@ public:
 
 }; // class UndoStack
 
+/**
+ * Keeps the undo and redo stack together within the given number of bytes.
+ * The oldest undo operations are dropped first, then the redo operations
+ * furthest away. The most recent operation of each stack is always kept.
+ */
+inline void trimHistory(UndoStack& undoStack, UndoStack& redoStack, std::size_t maxMemorySize)
+{
+	std::size_t redoSize = redoStack.getMemorySize();
+	undoStack.trim(maxMemorySize > redoSize ? maxMemorySize - redoSize : 0);
+
+	std::size_t undoSize = undoStack.getMemorySize();
+	redoStack.trim(maxMemorySize > undoSize ? maxMemorySize - undoSize : 0);
+}
+
 } // namespace undo
@@ -55,13 +55,24 @@ class RadiantUndoSystem :
 
 	std::size_t _undoLevels;
 
+	// The maximum memory of the undo history in bytes
+	std::size_t _memoryBudget;
+
+	sigc::signal<void> _sigHistoryChanged;
+
+	// Set between start() and finish()/cancel()
+	bool _operationStarted;
+	sigc::signal<void> _sigOperationFinished;
+
 	typedef std::set<IUndoTracker*> Trackers;
 	Trackers _trackers;
 
 public:
 	// Constructor
 	RadiantUndoSystem() :
-		_undoLevels(64)
+		_undoLevels(64),
+		_memoryBudget(512 << 20),
+		_operationStarted(false)
 	{}
 
 	virtual ~RadiantUndoSystem()
@@ -75,6 +86,14 @@ public:
 		_undoLevels = registry::getValue<int>(RKEY_UNDO_QUEUE_SIZE);
 	}
 
+	void memoryBudgetChanged()
+	{
+		_memoryBudget = static_cast<std::size_t>(registry::getValue<int>(RKEY_UNDO_MEMORY_BUDGET)) << 20;
+
+		trimHistory();
+		_sigHistoryChanged.emit();
+	}
+
 	IUndoStateSaver* getStateSaver(IUndoable& undoable)
 	{
 		return &_undoables[&undoable];
@@ -83,6 +102,10 @@ public:
 	void releaseStateSaver(IUndoable& undoable)
 	{
 		_undoables.erase(&undoable);
+
+		// The Undoable might be destroyed before the running operation is finished
+		_undoStack.release(undoable);
+		_redoStack.release(undoable);
 	}
 
 	std::size_t size() const
@@ -99,6 +122,8 @@ public:
 		}
 		startUndo();
 		trackersBegin();
+
+		_operationStarted = true;
 	}
 
 	// greebo: This finishes the current operation and
@@ -111,12 +136,30 @@ public:
 			// Instantly remove the added operation
 			_undoStack.pop_back();
 		}
+
+		operationFinished();
 	}
 
 	void finish(const std::string& command) {
 		if (finishUndo(command)) {
 			rMessage() << command << std::endl;
+
+			// Drop the oldest operations if the history grew too large
+			trimHistory();
+			_sigHistoryChanged.emit();
 		}
+
+		operationFinished();
+	}
+
+	bool operationStarted() const
+	{
+		return _operationStarted;
+	}
+
+	sigc::signal<void> signal_operationFinished() const
+	{
+		return _sigOperationFinished;
 	}
 
 	void undo()
@@ -132,24 +175,33 @@ public:
 
 		startRedo();
 		trackersUndo();
-		operation->restoreSnapshot();
-		finishRedo(operation->getName());
-		_undoStack.pop_back();
 
-		for (Observers::iterator i = _observers.begin(); i != _observers.end(); /* in-loop */)
 		{
-			Observer* observer = *(i++);
-			observer->postUndo();
-		}
+			// The nodes only notify the scene graph once, after all of them are restored
+			scene::BulkChange bulkChange(GlobalSceneGraph());
 
-		// Trigger the onPostUndo event on all scene nodes
-		GlobalSceneGraph().foreachNode([&] (const scene::INodePtr& node)->bool
-		{
-			node->onPostUndo();
-			return true;
-		});
+			operation->restoreSnapshot();
+			finishRedo(operation->getName());
+			_undoStack.pop_back();
+
+			for (Observers::iterator i = _observers.begin(); i != _observers.end(); /* in-loop */)
+			{
+				Observer* observer = *(i++);
+				observer->postUndo();
+			}
+
+			// Trigger the onPostUndo event on all scene nodes
+			GlobalSceneGraph().foreachNode([&] (const scene::INodePtr& node)->bool
+			{
+				node->onPostUndo();
+				return true;
+			});
 
-		GlobalSceneGraph().sceneChanged();
+			GlobalSceneGraph().sceneChanged();
+		}
+
+		trimHistory();
+		_sigHistoryChanged.emit();
 	}
 
 	void redo()
@@ -165,24 +217,33 @@ public:
 
 		startUndo();
 		trackersRedo();
-		operation->restoreSnapshot();
-		finishUndo(operation->getName());
-		_redoStack.pop_back();
 
-		for (Observers::iterator i = _observers.begin(); i != _observers.end(); /* in-loop */)
 		{
-			Observer* observer = *(i++);
-			observer->postRedo();
+			// The nodes only notify the scene graph once, after all of them are restored
+			scene::BulkChange bulkChange(GlobalSceneGraph());
+
+			operation->restoreSnapshot();
+			finishUndo(operation->getName());
+			_redoStack.pop_back();
+
+			for (Observers::iterator i = _observers.begin(); i != _observers.end(); /* in-loop */)
+			{
+				Observer* observer = *(i++);
+				observer->postRedo();
+			}
+
+			// Trigger the onPostRedo event on all scene nodes
+			GlobalSceneGraph().foreachNode([&] (const scene::INodePtr& node)->bool
+			{
+				node->onPostRedo();
+				return true;
+			});
+
+			GlobalSceneGraph().sceneChanged();
 		}
 
-		// Trigger the onPostRedo event on all scene nodes
-		GlobalSceneGraph().foreachNode([&] (const scene::INodePtr& node)->bool
-		{
-			node->onPostRedo();
-			return true;
-		});
-
-		GlobalSceneGraph().sceneChanged();
+		trimHistory();
+		_sigHistoryChanged.emit();
 	}
 
 	void clear()
@@ -191,6 +252,10 @@ public:
 		_undoStack.clear();
 		_redoStack.clear();
 		trackersClear();
+		_sigHistoryChanged.emit();
+
+		// An operation running until now is gone with the history
+		operationFinished();
 
 		// greebo: This is called on map shutdown, so don't clear the observers,
 		// there are some "persistent" observers like EntityInspector and ShaderClipboard
@@ -230,6 +295,16 @@ public:
 		_trackers.erase(&tracker);
 	}
 
+	std::size_t getMemorySize() const
+	{
+		return _undoStack.getMemorySize() + _redoStack.getMemorySize();
+	}
+
+	sigc::signal<void> signal_historyChanged() const
+	{
+		return _sigHistoryChanged;
+	}
+
 	// RegisterableModule implementation
 	virtual const std::string& getName() const
 	{
@@ -272,6 +347,15 @@ public:
             sigc::mem_fun(this, &RadiantUndoSystem::keyChanged)
         );
 
+		if (GlobalRegistry().keyExists(RKEY_UNDO_MEMORY_BUDGET))
+		{
+			memoryBudgetChanged();
+		}
+
+		GlobalRegistry().signalForKey(RKEY_UNDO_MEMORY_BUDGET).connect(
+            sigc::mem_fun(this, &RadiantUndoSystem::memoryBudgetChanged)
+        );
+
 		// add the preference settings
 		constructPreferences();
 	}
@@ -335,6 +419,20 @@ private:
 		return changed;
 	}
 
+	void operationFinished()
+	{
+		if (!_operationStarted) return;
+
+		_operationStarted = false;
+		_sigOperationFinished.emit();
+	}
+
+	// Keeps the undo and redo history within the memory budget
+	void trimHistory()
+	{
+		undo::trimHistory(_undoStack, _redoStack, _memoryBudget);
+	}
+
 	// Assigns the given stack to all of the Undoables listed in the map
 	void setActiveUndoStack(UndoStack* stack)
 	{
@@ -0,0 +1,320 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE undoHistoryTest
+#include <boost/test/unit_test.hpp>
+
+#include "SnapShot.h"
+#include "Operation.h"
+#include "Stack.h"
+#include "StackFiller.h"
+
+#include <vector>
+
+using namespace undo;
+
+namespace
+{
+    const std::size_t NUM_VALUES = 100000;
+
+    // A large undoable object saving its full state like a patch does,
+    // compactState() reduces it to the changed values
+    class ValueGrid :
+        public IUndoable
+    {
+        class Memento :
+            public IUndoMemento
+        {
+        public:
+            std::vector<double> values;
+            std::vector<std::size_t> indices; // empty for full states
+            bool isDelta;
+
+            Memento() :
+                isDelta(false)
+            {}
+
+            std::size_t getMemorySize() const
+            {
+                return sizeof(*this) + values.capacity() * sizeof(double) +
+                    indices.capacity() * sizeof(std::size_t);
+            }
+        };
+
+        std::vector<double> _values;
+
+    public:
+        UndoStackFiller saver;
+
+        ValueGrid() :
+            _values(NUM_VALUES, 0.0)
+        {}
+
+        const std::vector<double>& getValues() const
+        {
+            return _values;
+        }
+
+        void set(std::size_t index, double value)
+        {
+            saver.save(*this);
+            _values[index] = value;
+        }
+
+        IUndoMementoPtr exportState() const
+        {
+            std::shared_ptr<Memento> memento(new Memento);
+            memento->values = _values;
+            return memento;
+        }
+
+        void importState(const IUndoMementoPtr& state)
+        {
+            saver.save(*this);
+
+            const Memento& memento = *std::static_pointer_cast<Memento>(state);
+
+            if (!memento.isDelta)
+            {
+                _values = memento.values;
+                return;
+            }
+
+            for (std::size_t i = 0; i < memento.indices.size(); ++i)
+            {
+                _values[memento.indices[i]] = memento.values[i];
+            }
+        }
+
+        IUndoMementoPtr compactState(const IUndoMementoPtr& state) const
+        {
+            const Memento& saved = *std::static_pointer_cast<Memento>(state);
+            std::shared_ptr<Memento> delta(new Memento);
+
+            delta->isDelta = true;
+
+            for (std::size_t i = 0; i < _values.size(); ++i)
+            {
+                if (saved.values[i] != _values[i])
+                {
+                    delta->indices.push_back(i);
+                    delta->values.push_back(saved.values[i]);
+                }
+            }
+
+            return delta->indices.empty() ? IUndoMementoPtr() : delta;
+        }
+    };
+
+    // Mirrors what the RadiantUndoSystem does for a single undoable
+    class History
+    {
+    public:
+        UndoStack undoStack;
+        UndoStack redoStack;
+        ValueGrid grid;
+
+        // Changes <count> values starting at <first> in one operation
+        void edit(std::size_t first, std::size_t count, double value)
+        {
+            redoStack.clear();
+            undoStack.start("unnamedCommand");
+            grid.saver.setStack(&undoStack);
+
+            for (std::size_t i = first; i < first + count; ++i)
+            {
+                grid.set(i % NUM_VALUES, value);
+            }
+
+            undoStack.finish("edit");
+            grid.saver.setStack(NULL);
+        }
+
+        void undo()
+        {
+            OperationPtr operation = undoStack.back();
+
+            redoStack.start("unnamedCommand");
+            grid.saver.setStack(&redoStack);
+            operation->restoreSnapshot();
+            redoStack.finish(operation->getName());
+            grid.saver.setStack(NULL);
+
+            undoStack.pop_back();
+        }
+
+        void redo()
+        {
+            OperationPtr operation = redoStack.back();
+
+            undoStack.start("unnamedCommand");
+            grid.saver.setStack(&undoStack);
+            operation->restoreSnapshot();
+            undoStack.finish(operation->getName());
+            grid.saver.setStack(NULL);
+
+            redoStack.pop_back();
+        }
+    };
+}
+
+// Hundreds of small edits to a large object must not keep a full copy per step
+BOOST_AUTO_TEST_CASE(deltasKeepHistorySmall)
+{
+    const std::size_t NUM_EDITS = 500;
+
+    History history;
+    std::vector< std::vector<double> > states;
+
+    states.push_back(history.grid.getValues());
+
+    for (std::size_t i = 0; i < NUM_EDITS; ++i)
+    {
+        history.edit(i * 997, 20, static_cast<double>(i + 1));
+        states.push_back(history.grid.getValues());
+    }
+
+    BOOST_CHECK_EQUAL(history.undoStack.size(), NUM_EDITS);
+
+    // A full copy of the grid alone is 800 KB
+    BOOST_CHECK(history.undoStack.getMemorySize() < NUM_EDITS * 1024);
+
+    for (std::size_t i = NUM_EDITS; i > 0; --i)
+    {
+        history.undo();
+        BOOST_REQUIRE(history.grid.getValues() == states[i - 1]);
+    }
+
+    BOOST_CHECK_EQUAL(history.undoStack.getMemorySize(), 0);
+    BOOST_CHECK(history.redoStack.getMemorySize() < NUM_EDITS * 1024);
+
+    for (std::size_t i = 1; i <= NUM_EDITS; ++i)
+    {
+        history.redo();
+        BOOST_REQUIRE(history.grid.getValues() == states[i]);
+    }
+}
+
+// Large edits are dropped from the front of the history to stay within the budget
+BOOST_AUTO_TEST_CASE(trimOldestOperations)
+{
+    const std::size_t BUDGET = 4 << 20;
+
+    History history;
+    std::vector< std::vector<double> > states;
+
+    states.push_back(history.grid.getValues());
+
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        history.edit(i * 7919, 20000, static_cast<double>(i + 1));
+        history.undoStack.trim(BUDGET);
+
+        BOOST_REQUIRE(history.undoStack.getMemorySize() <= BUDGET);
+
+        states.push_back(history.grid.getValues());
+    }
+
+    std::size_t remaining = history.undoStack.size();
+
+    BOOST_CHECK(remaining > 1 && remaining < 100);
+
+    // The remaining operations still undo correctly
+    for (std::size_t i = 0; i < remaining; ++i)
+    {
+        history.undo();
+        BOOST_REQUIRE(history.grid.getValues() == states[100 - i - 1]);
+    }
+
+    BOOST_CHECK(history.undoStack.empty());
+
+    // The most recent operation is kept, no matter how large it is
+    history.edit(0, NUM_VALUES, -1.0);
+    history.undoStack.trim(0);
+
+    BOOST_CHECK_EQUAL(history.undoStack.size(), 1);
+}
+
+// The redo operations count against the budget as well
+BOOST_AUTO_TEST_CASE(trimRedoOperations)
+{
+    const std::size_t BUDGET = 4 << 20;
+
+    History history;
+    std::vector< std::vector<double> > states;
+
+    states.push_back(history.grid.getValues());
+
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        history.edit(i * 7919, 20000, static_cast<double>(i + 1));
+        trimHistory(history.undoStack, history.redoStack, BUDGET);
+
+        states.push_back(history.grid.getValues());
+    }
+
+    std::size_t steps = history.undoStack.size();
+
+    // Undoing moves the operations over to the redo stack
+    for (std::size_t i = 0; i < steps; ++i)
+    {
+        history.undo();
+        trimHistory(history.undoStack, history.redoStack, BUDGET);
+
+        BOOST_REQUIRE(history.undoStack.getMemorySize() + history.redoStack.getMemorySize() <= BUDGET);
+    }
+
+    BOOST_CHECK(history.undoStack.empty());
+    BOOST_CHECK_EQUAL(history.redoStack.size(), steps);
+
+    // Lowering the budget drops the redo operations furthest away
+    trimHistory(history.undoStack, history.redoStack, BUDGET / 2);
+
+    std::size_t remaining = history.redoStack.size();
+
+    BOOST_CHECK(history.redoStack.getMemorySize() <= BUDGET / 2);
+    BOOST_CHECK(remaining > 1 && remaining < steps);
+
+    // The remaining ones still redo correctly
+    std::size_t first = 100 - steps;
+
+    for (std::size_t i = 1; i <= remaining; ++i)
+    {
+        history.redo();
+        BOOST_REQUIRE(history.grid.getValues() == states[first + i]);
+    }
+
+    // The most recent operation of each stack is kept
+    history.undo();
+    trimHistory(history.undoStack, history.redoStack, 0);
+
+    BOOST_CHECK_EQUAL(history.undoStack.size(), 1);
+    BOOST_CHECK_EQUAL(history.redoStack.size(), 1);
+}
+
+// Saving an undoable without changing it leaves nothing in the history
+BOOST_AUTO_TEST_CASE(dropUnchangedStates)
+{
+    History history;
+
+    history.edit(10, 5, 0.0);
+
+    BOOST_CHECK_EQUAL(history.undoStack.size(), 1);
+    BOOST_CHECK(history.undoStack.getMemorySize() < 1024);
+}
+
+// Undoables released during an operation might be gone on finish, keep their full state
+BOOST_AUTO_TEST_CASE(keepStatesOfReleasedUndoables)
+{
+    History history;
+
+    history.undoStack.start("unnamedCommand");
+    history.grid.saver.setStack(&history.undoStack);
+    history.grid.set(0, 1.0);
+    history.undoStack.release(history.grid);
+    history.undoStack.finish("release");
+    history.grid.saver.setStack(NULL);
+
+    BOOST_CHECK(history.undoStack.getMemorySize() >= NUM_VALUES * sizeof(double));
+
+    history.undo();
+    BOOST_CHECK_EQUAL(history.grid.getValues()[0], 0.0);
+}
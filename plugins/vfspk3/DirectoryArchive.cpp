@@ -1,6 +1,7 @@
 #include "DirectoryArchive.h"
 
 #include "archivelib.h"
+#include "iregistry.h"
 #include "UnixPath.h"
 #include "os/file.h"
 #include "os/dir.h"
@@ -10,7 +11,8 @@
 namespace fs = boost::filesystem;
 
 DirectoryArchive::DirectoryArchive(const std::string& root) :
-	_root(root)
+	_root(root),
+	_modName(os::getRelativePathMinusFilename(root, GlobalRegistry().get(RKEY_ENGINE_PATH)))
 {}
 
 ArchiveFilePtr DirectoryArchive::openFile(const std::string& name) {
@@ -30,7 +32,7 @@ ArchiveTextFilePtr DirectoryArchive::openTextFile(const std::string& name) {
 	UnixPath path(_root);
 	path.push_filename(name);
 
-	DirectoryArchiveTextFilePtr file(new DirectoryArchiveTextFile(name, _root, path));
+	DirectoryArchiveTextFilePtr file(new DirectoryArchiveTextFile(name, _modName, path));
 
 	if (!file->failed()) {
 		return file;
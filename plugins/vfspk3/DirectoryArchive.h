@@ -14,6 +14,12 @@ class DirectoryArchive :
 	public Archive
 {
 	std::string _root;
+
+	// The mod name reported by the text files, relative to the engine path.
+	// Calculated once, the registry must not be queried by the worker
+	// threads opening files.
+	std::string _modName;
+
 public:
 	// Pass the root path to the constructor
 	DirectoryArchive(const std::string& root);
@@ -151,6 +151,8 @@ void Doom3FileSystem::initialise()
         initDirectory(*i);
     }
 
+    buildIndex();
+
     for (ObserverList::iterator i = _observers.begin(); i != _observers.end(); ++i)
     {
         (*i)->onFileSystemInitialise();
@@ -165,10 +167,31 @@ void Doom3FileSystem::shutdown() {
 
     rMessage() << "filesystem shutdown" << std::endl;
 
+    _index.clear();
     _archives.clear();
     _numDirectories = 0;
 }
 
+void Doom3FileSystem::buildIndex()
+{
+    gint64 startTime = g_get_monotonic_time();
+
+    std::size_t numPakFiles = 0;
+
+    // The folders on disk are left out, files can be added to them at any time
+    for (std::size_t i = 0; i < _archives.size(); ++i)
+    {
+        if (_archives[i].is_pakfile)
+        {
+            _index.addArchive(i, *_archives[i].archive);
+            ++numPakFiles;
+        }
+    }
+
+    rMessage() << "[vfs] indexed " << _index.size() << " files in " << numPakFiles
+        << " pak files (" << (g_get_monotonic_time() - startTime) / 1000 << " msec)" << std::endl;
+}
+
 void Doom3FileSystem::addObserver(Observer& observer) {
     _observers.insert(&observer);
 }
@@ -177,12 +200,47 @@ void Doom3FileSystem::removeObserver(Observer& observer) {
     _observers.erase(&observer);
 }
 
+void Doom3FileSystem::findCandidates(const std::string& filename, Candidates& candidates)
+{
+    // The pak files are only asked if the index says they contain the file. The folders
+    // on disk are not indexed and always asked.
+    const FileIndex::Entry* entry = _index.find(filename);
+    std::size_t next = 0;
+
+    if (entry != NULL) {
+        for (std::vector<FileIndex::Location>::const_iterator i = entry->locations.begin();
+             i != entry->locations.end(); ++i)
+        {
+            for (; next < i->archive; ++next) {
+                if (!_archives[next].is_pakfile) {
+                    candidates.push_back(Candidate(_archives[next].archive.get(), filename));
+                }
+            }
+
+            // A pak file might contain several files differing in case only
+            if (next == i->archive) {
+                ++next;
+            }
+
+            candidates.push_back(Candidate(_archives[i->archive].archive.get(), i->name));
+        }
+    }
+
+    for (; next < _archives.size(); ++next) {
+        if (!_archives[next].is_pakfile) {
+            candidates.push_back(Candidate(_archives[next].archive.get(), filename));
+        }
+    }
+}
+
 int Doom3FileSystem::getFileCount(const std::string& filename) {
-    int count = 0;
-    std::string fixedFilename(os::standardPathWithSlash(filename));
+    std::string fixedFilename(os::standardPath(filename));
+
+    const FileIndex::Entry* entry = _index.find(fixedFilename);
+    int count = entry != NULL ? static_cast<int>(entry->locations.size()) : 0;
 
     for (ArchiveList::iterator i = _archives.begin(); i != _archives.end(); ++i) {
-        if (i->archive->containsFile(fixedFilename.c_str())) {
+        if (!i->is_pakfile && i->archive->containsFile(fixedFilename.c_str())) {
             ++count;
         }
     }
@@ -196,8 +254,11 @@ ArchiveFilePtr Doom3FileSystem::openFile(const std::string& filename) {
         return ArchiveFilePtr();
     }
 
-    for (ArchiveList::iterator i = _archives.begin(); i != _archives.end(); ++i) {
-        ArchiveFilePtr file = i->archive->openFile(filename);
+    Candidates candidates;
+    findCandidates(filename, candidates);
+
+    for (Candidates::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+        ArchiveFilePtr file = i->first->openFile(i->second);
         if (file != NULL) {
             return file;
         }
@@ -208,8 +269,11 @@ ArchiveFilePtr Doom3FileSystem::openFile(const std::string& filename) {
 }
 
 ArchiveTextFilePtr Doom3FileSystem::openTextFile(const std::string& filename) {
-    for (ArchiveList::iterator i = _archives.begin(); i != _archives.end(); ++i) {
-        ArchiveTextFilePtr file = i->archive->openTextFile(filename);
+    Candidates candidates;
+    findCandidates(filename, candidates);
+
+    for (Candidates::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+        ArchiveTextFilePtr file = i->first->openTextFile(i->second);
         if (file != NULL) {
             return file;
         }
@@ -259,15 +323,28 @@ void Doom3FileSystem::forEachFile(const std::string& basedir,
     // Wrap around the passed visitor
     FileVisitor visitor2(visitor, basedir, extension, visitedFiles);
 
-    // Visit each Archive, applying the FileVisitor to each one (which in
-    // turn calls the callback for each matching file.
-    for (ArchiveList::iterator i = _archives.begin();
-         i != _archives.end();
-         ++i)
+    // The files of the pak files are taken from the index, sorted by archive
+    std::vector<const FileIndex::Location*> locations;
+    _index.findFiles(basedir, depth, locations);
+
+    std::vector<const FileIndex::Location*>::const_iterator location = locations.begin();
+
+    // Visit each archive in the order of their priority and let the FileVisitor
+    // filter the files (which in turn calls the callback for each matching file).
+    // The folders on disk are traversed, their contents may have changed.
+    for (std::size_t i = 0; i < _archives.size(); ++i)
     {
-        i->archive->forEachFile(
-                        Archive::VisitorFunc(
-                                visitor2, Archive::eFiles, depth), basedir);
+        if (!_archives[i].is_pakfile)
+        {
+            _archives[i].archive->forEachFile(
+                Archive::VisitorFunc(visitor2, Archive::eFiles, depth), basedir);
+            continue;
+        }
+
+        for (; location != locations.end() && (*location)->archive == i; ++location)
+        {
+            visitor2.visit((*location)->name);
+        }
     }
 }
 
@@ -31,9 +31,10 @@
 #if !defined(INCLUDED_VFS_H)
 #define INCLUDED_VFS_H
 
-#include <list>
+#include <vector>
 #include "iarchive.h"
 #include "ifilesystem.h"
+#include "FileIndex.h"
 
 #define VFS_MAXDIRS 8
 
@@ -51,9 +52,13 @@ class Doom3FileSystem :
 		bool is_pakfile;
 	};
 
-	typedef std::list<ArchiveDescriptor> ArchiveList;
+	// In the order of their priority, the index refers to them by position
+	typedef std::vector<ArchiveDescriptor> ArchiveList;
 	ArchiveList _archives;
 
+	// The merged contents of all pak files
+	FileIndex _index;
+
 	typedef std::set<Observer*> ObserverList;
 	ObserverList _observers;
 
@@ -90,6 +95,15 @@ public:
 
 private:
 	void initPakFile(ArchiveLoader& archiveModule, const std::string& filename);
+
+	// Adds the contents of all pak files to the index
+	void buildIndex();
+
+	// The archives which may contain the given file, in the order of
+	// their priority, with the name of the file in each archive
+	typedef std::pair<Archive*, std::string> Candidate;
+	typedef std::vector<Candidate> Candidates;
+	void findCandidates(const std::string& filename, Candidates& candidates);
 };
 typedef boost::shared_ptr<Doom3FileSystem> Doom3FileSystemPtr;
 
@@ -0,0 +1,116 @@
+#include "FileIndex.h"
+
+#include <algorithm>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace
+{
+	// Collects the file names of an archive
+	class FileCollector :
+		public Archive::Visitor
+	{
+	public:
+		std::vector<std::string> files;
+
+		void visit(const std::string& name)
+		{
+			files.push_back(name);
+		}
+	};
+
+	struct LocationLess
+	{
+		bool operator()(const FileIndex::Location& a, const FileIndex::Location& b) const
+		{
+			return a.archive < b.archive;
+		}
+	};
+
+	struct ArchiveLess
+	{
+		bool operator()(const FileIndex::Location* a, const FileIndex::Location* b) const
+		{
+			return a->archive < b->archive;
+		}
+	};
+}
+
+void FileIndex::addArchive(std::size_t archiveNum, Archive& archive)
+{
+	// A depth of 0 traverses all subdirectories
+	FileCollector collector;
+	archive.forEachFile(Archive::VisitorFunc(collector, Archive::eFiles, 0), "");
+
+	for (std::vector<std::string>::const_iterator i = collector.files.begin();
+		 i != collector.files.end(); ++i)
+	{
+		std::string path = normalise(*i);
+
+		Entries::iterator found = _entries.find(path);
+
+		if (found == _entries.end())
+		{
+			found = _entries.insert(Entries::value_type(path, Entry())).first;
+			_lookup[path] = &found->second;
+		}
+
+		Location location;
+		location.archive = archiveNum;
+		location.name = *i;
+
+		// Keep the locations sorted by archive, after any existing ones of the same archive
+		std::vector<Location>& locations = found->second.locations;
+		locations.insert(std::upper_bound(locations.begin(), locations.end(), location, LocationLess()), location);
+	}
+}
+
+void FileIndex::clear()
+{
+	_lookup.clear();
+	_entries.clear();
+}
+
+std::size_t FileIndex::size() const
+{
+	return _entries.size();
+}
+
+const FileIndex::Entry* FileIndex::find(const std::string& path) const
+{
+	Lookup::const_iterator found = _lookup.find(normalise(path));
+
+	return found != _lookup.end() ? found->second : NULL;
+}
+
+void FileIndex::findFiles(const std::string& directory, std::size_t depth,
+						  std::vector<const Location*>& locations) const
+{
+	std::string prefix = normalise(directory);
+
+	if (!prefix.empty() && !boost::algorithm::ends_with(prefix, "/"))
+	{
+		prefix += "/";
+	}
+
+	for (Entries::const_iterator i = _entries.lower_bound(prefix);
+		 i != _entries.end() && boost::algorithm::starts_with(i->first, prefix); ++i)
+	{
+		// Files in subdirectories below the depth are skipped
+		if (depth > 0 &&
+			static_cast<std::size_t>(std::count(i->first.begin() + prefix.length(), i->first.end(), '/')) >= depth)
+		{
+			continue;
+		}
+
+		locations.push_back(&i->second.locations.front());
+	}
+
+	// The entries are sorted by path already
+	std::stable_sort(locations.begin(), locations.end(), ArchiveLess());
+}
+
+std::string FileIndex::normalise(const std::string& path)
+{
+	return boost::algorithm::to_lower_copy(path);
+}
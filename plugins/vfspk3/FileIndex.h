@@ -0,0 +1,75 @@
+#ifndef FILEINDEX_H_
+#define FILEINDEX_H_
+
+#include "iarchive.h"
+
+#include <map>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+/**
+ * The merged index of all the files in the VFS pak files. Paths are
+ * compared case-insensitively, each path maps to the archives containing
+ * it, in the order of their priority.
+ *
+ * The index is filled once when the VFS is initialised, the contents of
+ * the pak files never change. The folders on disk are not indexed.
+ *
+ * Lookups don't modify the index and can be called from several threads,
+ * as long as no archive is added or removed at the same time.
+ */
+class FileIndex
+{
+public:
+	// An archive containing a certain file
+	struct Location
+	{
+		// The position in the archive list of the VFS, lower numbers win
+		std::size_t archive;
+
+		// The path as stored in the archive, which may differ in case
+		std::string name;
+	};
+
+	struct Entry
+	{
+		// Sorted by archive
+		std::vector<Location> locations;
+	};
+
+private:
+	// Normalised paths, sorted for the directory queries
+	typedef std::map<std::string, Entry> Entries;
+	Entries _entries;
+
+	// Normalised paths for constant-time lookups
+	typedef boost::unordered_map<std::string, const Entry*> Lookup;
+	Lookup _lookup;
+
+public:
+	// Adds all files of the given archive, which is stored at the given
+	// position in the archive list
+	void addArchive(std::size_t archiveNum, Archive& archive);
+
+	void clear();
+
+	// Returns the number of indexed paths
+	std::size_t size() const;
+
+	// Returns the entry of the given path or NULL if no archive contains it
+	const Entry* find(const std::string& path) const;
+
+	/**
+	 * Collects the winning location of all files in the given directory
+	 * (including its subdirectories down to the given depth, 0 means
+	 * unlimited). The locations are sorted by archive, then by path, the
+	 * same order a traversal of the archives used to return them.
+	 */
+	void findFiles(const std::string& directory, std::size_t depth,
+				   std::vector<const Location*>& locations) const;
+
+	// Converts the given path into the key used by the index
+	static std::string normalise(const std::string& path);
+};
+
+#endif /*FILEINDEX_H_*/
@@ -1,5 +1,7 @@
 #include "RadiantThreadManager.h"
 
+#include "log/LogWriter.h"
+
 namespace radiant
 {
 
@@ -18,4 +20,14 @@ void RadiantThreadManager::execute(boost::function<void()> func) const
     _pool.push(sigc::bind(sigc::ptr_fun(&runFuncInThread), func));
 }
 
+void RadiantThreadManager::beginLogCapture(CapturedLog& log) const
+{
+    applog::LogWriter::setThreadCapture(&log);
+}
+
+void RadiantThreadManager::endLogCapture() const
+{
+    applog::LogWriter::setThreadCapture(NULL);
+}
+
 }
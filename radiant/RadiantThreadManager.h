@@ -15,6 +15,8 @@ public:
 
     // ThreadManager implementation
     void execute(boost::function<void()>) const;
+    void beginLogCapture(CapturedLog& log) const;
+    void endLogCapture() const;
 };
 
 }
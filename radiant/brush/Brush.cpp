@@ -381,6 +381,19 @@ void Brush::importState(const IUndoMementoPtr& state)
     }
 }
 
+IUndoMementoPtr Brush::compactState(const IUndoMementoPtr& state) const
+{
+	const BrushUndoMemento& memento = *std::static_pointer_cast<BrushUndoMemento>(state);
+
+	// Moving faces around doesn't change the face list, only the faces themselves
+	if (memento._faces == m_faces && memento._detailFlag == _detailFlag)
+	{
+		return IUndoMementoPtr();
+	}
+
+	return state;
+}
+
 /// \brief Appends a copy of \p face to the end of the face list.
 FacePtr Brush::addFace(const Face& face) {
     if (m_faces.size() == c_brush_maxFaces) {
@@ -168,6 +168,12 @@ public:
 
 		virtual ~BrushUndoMemento() {}
 
+		std::size_t getMemorySize() const
+		{
+			// The faces are shared, their state is saved by themselves
+			return sizeof(*this) + _faces.capacity() * sizeof(FacePtr);
+		}
+
 		Faces _faces;
 		DetailFlag _detailFlag;
 	};
@@ -255,6 +261,7 @@ public:
 	void undoSave();
 	IUndoMementoPtr exportState() const;
 	void importState(const IUndoMementoPtr& state);
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const;
 
 	/// \brief Appends a copy of \p face to the end of the face list.
 	FacePtr addFace(const Face& face);
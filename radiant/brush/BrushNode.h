@@ -132,6 +132,7 @@ public:
 
 	// LitObject implementation
 	bool intersectsLight(const RendererLight& light) const;
+	const AABB& getLitObjectAABB() const;
 	void insertLight(const RendererLight& light);
 	void clearLights();
 
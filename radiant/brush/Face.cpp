@@ -10,6 +10,7 @@
 
 #include "Brush.h"
 #include "BrushModule.h"
+#include "FaceUndoDelta.h"
 #include "ui/surfaceinspector/SurfaceInspector.h"
 
 Face::Face(Brush& owner, FaceObserver* observer) :
@@ -176,6 +177,36 @@ void Face::importState(const IUndoMementoPtr& data)
     m_observer->shaderChanged();
 }
 
+IUndoMementoPtr Face::compactState(const IUndoMementoPtr& data) const
+{
+	const SavedState& saved = *std::static_pointer_cast<SavedState>(data);
+
+	FaceUndoDelta changes(
+		saved.m_planeState.m_plane, m_plane.getPlane(),
+		saved.m_texdefState.m_projection.m_brushprimit_texdef, m_texdef.m_projection.m_brushprimit_texdef,
+		saved.m_shaderState._materialName, _faceShader.getMaterialName(),
+		saved.m_shaderState.m_flags, _faceShader.getFlags()
+	);
+
+	if (changes.empty())
+	{
+		return IUndoMementoPtr(); // untouched face
+	}
+
+	std::shared_ptr<SavedState> delta(new SavedState(saved));
+
+	delta->m_planeChanged = changes.planeChanged;
+	delta->m_texdefChanged = changes.texdefChanged;
+	delta->m_shaderChanged = changes.shaderChanged;
+
+	if (!delta->m_shaderChanged)
+	{
+		std::string().swap(delta->m_shaderState._materialName);
+	}
+
+	return delta;
+}
+
 void Face::flipWinding() {
     m_plane.reverse();
     planeChanged();
@@ -48,18 +48,31 @@ class Face :
 			FaceTexdef::SavedState m_texdefState;
 			FaceShader::SavedState m_shaderState;
 
+			// Delta states created by compactState() only export the changed parts
+			bool m_planeChanged;
+			bool m_texdefChanged;
+			bool m_shaderChanged;
+
 		SavedState(const Face& face) :
 			m_planeState(face.getPlane()),
 			m_texdefState(face.getTexdef()),
-			m_shaderState(face.getFaceShader())
+			m_shaderState(face.getFaceShader()),
+			m_planeChanged(true),
+			m_texdefChanged(true),
+			m_shaderChanged(true)
 		{}
 
 		virtual ~SavedState() {}
 
+		std::size_t getMemorySize() const
+		{
+			return sizeof(*this) + m_shaderState._materialName.capacity();
+		}
+
 		void exportState(Face& face) const {
-			m_planeState.exportState(face.getPlane());
-			m_shaderState.exportState(face.getFaceShader());
-			m_texdefState.exportState(face.getTexdef());
+			if (m_planeChanged) m_planeState.exportState(face.getPlane());
+			if (m_shaderChanged) m_shaderState.exportState(face.getFaceShader());
+			if (m_texdefChanged) m_texdefState.exportState(face.getTexdef());
 		}
 	};
 
@@ -127,6 +140,7 @@ public:
 	// undoable
 	IUndoMementoPtr exportState() const;
 	void importState(const IUndoMementoPtr& data);
+	IUndoMementoPtr compactState(const IUndoMementoPtr& data) const;
 
     /// Translate the face by the given vector
     void translate(const Vector3& translation);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "math/Plane3.h"
+#include "BrushPrimitTexDef.h"
+#include "ContentsFlagsValue.h"
+
+#include <string>
+
+/**
+ * The parts of a brush face which differ between a saved undo state and the
+ * current state of the face. Face::compactState() only keeps these parts of
+ * the saved state, the others are left untouched when it is imported.
+ *
+ * The comparisons are exact, Plane3::operator== uses an epsilon and would
+ * miss small moves, which could then not be undone.
+ */
+struct FaceUndoDelta
+{
+	bool planeChanged;
+	bool texdefChanged;
+	bool shaderChanged;
+
+	FaceUndoDelta(const Plane3& savedPlane, const Plane3& plane,
+				  const BrushPrimitTexDef& savedTexdef, const BrushPrimitTexDef& texdef,
+				  const std::string& savedMaterial, const std::string& material,
+				  const ContentsFlagsValue& savedFlags, const ContentsFlagsValue& flags) :
+		planeChanged(!planesEqual(savedPlane, plane)),
+		texdefChanged(!texdefsEqual(savedTexdef, texdef)),
+		shaderChanged(savedMaterial != material || !flagsEqual(savedFlags, flags))
+	{}
+
+	// True if the face is in the saved state
+	bool empty() const
+	{
+		return !planeChanged && !texdefChanged && !shaderChanged;
+	}
+
+	static bool planesEqual(const Plane3& a, const Plane3& b)
+	{
+		return a.normal().x() == b.normal().x() && a.normal().y() == b.normal().y() &&
+			a.normal().z() == b.normal().z() && a.dist() == b.dist();
+	}
+
+	// Only the brush primitive texdef is saved and restored
+	static bool texdefsEqual(const BrushPrimitTexDef& a, const BrushPrimitTexDef& b)
+	{
+		for (std::size_t i = 0; i < 2; ++i)
+		{
+			for (std::size_t j = 0; j < 3; ++j)
+			{
+				if (a.coords[i][j] != b.coords[i][j])
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static bool flagsEqual(const ContentsFlagsValue& a, const ContentsFlagsValue& b)
+	{
+		return a.m_surfaceFlags == b.m_surfaceFlags && a.m_contentFlags == b.m_contentFlags &&
+			a.m_value == b.m_value && a.m_specified == b.m_specified;
+	}
+};
@@ -62,6 +62,8 @@ void CamRenderer::setLights(const LightList& lights)
 void CamRenderer::addRenderable(const OpenGLRenderable& renderable,
                                 const Matrix4& world)
 {
+    render::SampledProfileZone zone(render::PROFILE_ZONE_SORT);
+
     if(_stateStack.back().highlightPrimitives)
     {
         highlightedPrimitiveShader->addRenderable(
@@ -85,6 +87,8 @@ void CamRenderer::addRenderable(const OpenGLRenderable& renderable,
                                 const Matrix4& world,
                                 const IRenderEntity& entity)
 {
+    render::SampledProfileZone zone(render::PROFILE_ZONE_SORT);
+
     if (_stateStack.back().highlightPrimitives)
     {
         highlightedPrimitiveShader->addRenderable(
@@ -5,6 +5,8 @@
 #include "iuimanager.h"
 #include "ieventmanager.h"
 #include "imainframe.h"
+#include "ishaders.h"
+#include "iparticles.h"
 
 #include "gtkutil/GLWidgetSentry.h"
 #include <time.h>
@@ -18,6 +20,7 @@
 #include "CameraSettings.h"
 #include "GlobalCamera.h"
 #include "render/RenderStatistics.h"
+#include "render/FrameProfiler.h"
 #include "registry/adaptors.h"
 #include "selection/OccludeSelector.h"
 
@@ -34,6 +37,31 @@ namespace
     const std::string FAR_CLIP_IN_TEXT = "Move far clip plane closer";
     const std::string FAR_CLIP_OUT_TEXT = "Move far clip plane further away";
     const std::string FAR_CLIP_DISABLED_TEXT = " (currently disabled in preferences)";
+
+    // The texture memory line of the statistics overlay
+    std::string getTextureMemoryString()
+    {
+        TextureMemoryStats stats = GlobalMaterialManager().getTextureMemoryStats();
+
+        std::string budget = stats.budgetBytes > 0 ?
+            (boost::format("%d MB") % (stats.budgetBytes >> 20)).str() : "unlimited";
+
+        return (boost::format("textures: %d MB / %s (peak %d MB) | reduced: %d/%d")
+            % (stats.currentBytes >> 20) % budget % (stats.peakBytes >> 20)
+            % stats.numReduced % stats.numTextures).str();
+    }
+
+    // The particle cache part of the statistics overlay
+    std::string getParticleCacheString()
+    {
+        particles::ParticleCacheStats stats = GlobalParticlesManager().getCacheStats();
+
+        std::size_t hitRate = stats.numLookups > 0 ? stats.numHits * 100 / stats.numLookups : 0;
+
+        return (boost::format("particles: %d%% cached (%d/%d) | bunches: %d, %d KB")
+            % hitRate % stats.numHits % stats.numLookups
+            % stats.numEntries % (stats.memoryBytes >> 10)).str();
+    }
 }
 
 class ObjectFinder :
@@ -539,6 +567,9 @@ bool CamWnd::freeMoveEnabled() const {
 
 void CamWnd::Cam_Draw()
 {
+    render::FrameProfiler& profiler = render::FrameProfiler::Instance();
+    profiler.beginFrame(render::PROFILE_VIEW_CAMERA);
+
     glViewport(0, 0, m_Camera.width, m_Camera.height);
 
     // enable depth buffer writes
@@ -660,6 +691,9 @@ void CamWnd::Cam_Draw()
         renderer.render(m_Camera.modelview, m_Camera.projection);
     }
 
+    // Everything from here on is counted as overlay
+    profiler.enterZone(render::PROFILE_ZONE_OVERLAY);
+
     // greebo: Draw the clipper's points (skipping the depth-test)
     {
         glDisable(GL_DEPTH_TEST);
@@ -729,6 +763,16 @@ void CamWnd::Cam_Draw()
 
 	GlobalOpenGL().drawString(render::View::getCullStats());
 
+    glRasterPos3f(1.0f, static_cast<float>(m_Camera.height) - 21.0f, 0.0f);
+
+    GlobalOpenGL().drawString(getTextureMemoryString() + " | " + getParticleCacheString());
+
+    if (profiler.isEnabled())
+    {
+        // Draw the graph of the previous frames below the statistics text
+        profiler.drawGraph(render::PROFILE_VIEW_CAMERA, 4.0f, 24.0f, 256.0f, 96.0f);
+    }
+
     drawTime();
 
     // Draw the selection drag rectangle
@@ -784,6 +828,9 @@ void CamWnd::Cam_Draw()
     // bind back to the default texture so that we don't have problems
     // elsewhere using/modifying texture maps between contexts
     glBindTexture( GL_TEXTURE_2D, 0 );
+
+    profiler.leaveZone();
+    profiler.endFrame();
 }
 
 void CamWnd::draw()
@@ -804,20 +851,55 @@ void CamWnd::draw()
     m_drawing = false;
 }
 
-void CamWnd::benchmark() {
-    double dStart = clock() / 1000.0;
+void CamWnd::benchmark()
+{
+    // The profiler is left as it is, so the figures aren't skewed by its overhead
+    // unless the zone summary has been asked for by enabling it
+    render::FrameProfiler& profiler = render::FrameProfiler::Instance();
+
+    std::size_t firstFrame = profiler.getFrameCount();
+    Vector3 originalAngles = getCameraAngles();
+
+    double dStart = clock() / static_cast<double>(CLOCKS_PER_SEC);
 
-    for (int i=0 ; i < 100 ; i++) {
+    // Render a full turn of the camera synchronously
+    for (int i = 0; i < 100; i++)
+    {
         Vector3 angles;
         angles[CAMERA_ROLL] = 0;
         angles[CAMERA_PITCH] = 0;
         angles[CAMERA_YAW] = static_cast<double>(i * (360.0 / 100.0));
         setCameraAngles(angles);
+
+        draw();
     }
 
-    double dEnd = clock() / 1000.0;
+    double dEnd = clock() / static_cast<double>(CLOCKS_PER_SEC);
+
+    setCameraAngles(originalAngles);
+
+    rMessage() << "Camera benchmark: " << (boost::format("%5.2lf") % (dEnd - dStart)) << " seconds\n";
+
+    if (profiler.isEnabled())
+    {
+        // Pick the frames rendered by the benchmark from the history
+        render::FrameRecords history;
+        profiler.getHistory(history, render::PROFILE_VIEW_CAMERA);
+
+        render::FrameRecords frames;
 
-    rMessage() << (boost::format("%5.2lf") % (dEnd - dStart)) << " seconds\n";
+        for (render::FrameRecords::const_iterator i = history.begin(); i != history.end(); ++i)
+        {
+            if (i->frameNumber >= firstFrame)
+            {
+                frames.push_back(*i);
+            }
+        }
+
+        render::FrameProfiler::writeSummary(rMessage(), frames);
+    }
+
+    update();
 }
 
 void CamWnd::onSceneGraphChange() {
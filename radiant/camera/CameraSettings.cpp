@@ -2,9 +2,11 @@
 
 #include "i18n.h"
 #include "ieventmanager.h"
+#include "iparticles.h"
 #include "ipreferencesystem.h"
 
 #include "registry/registry.h"
+#include "render/MeshLod.h"
 #include "GlobalCamera.h"
 
 #include <boost/lexical_cast.hpp>
@@ -69,6 +71,13 @@ void CameraSettings::constructPreferencePage()
 	// States whether the selection boxes are stippled or not
 	page->appendCheckBox("", _("Solid selection boxes"), RKEY_SOLID_SELECTION_BOXES);
 
+	// Distant models are drawn with simplified meshes, disable for screenshots
+	page->appendCheckBox("", _("Simplify distant models (level of detail)"), render::RKEY_MESH_LOD_ENABLED);
+	page->appendSpinner(_("Model detail switch size (pixels)"), render::RKEY_MESH_LOD_SWITCH_SIZE, 10, 2000, 0);
+
+	// Identical particle emitters are cheaper to simulate, applies to newly created ones
+	page->appendCheckBox("", _("Instances of a particle system share their particles"), particles::RKEY_PARTICLES_SHARE_SEEDS);
+
     // Whether to show the toolbar (to please the screenspace addicts)
     page->appendCheckBox(
         "", _("Show camera toolbar"), RKEY_SHOW_CAMERA_TOOLBAR
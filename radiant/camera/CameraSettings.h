@@ -27,6 +27,7 @@ namespace
 	const std::string RKEY_TOGGLE_FREE_MOVE = RKEY_CAMERA_ROOT + "/toggleFreeMove";
 	const std::string RKEY_CAMERA_WINDOW_STATE = RKEY_CAMERA_ROOT + "/window";
     const std::string RKEY_SHOW_CAMERA_TOOLBAR = RKEY_CAMERA_ROOT + "/showToolbar";
+	const std::string RKEY_SHOW_FRAME_PROFILER = RKEY_CAMERA_ROOT + "/showFrameProfiler";
 }
 
 enum CameraDrawMode 
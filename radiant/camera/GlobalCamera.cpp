@@ -2,6 +2,7 @@
 
 #include "ieventmanager.h"
 #include "iselection.h"
+#include "ishaders.h"
 #include "gdk/gdkkeysyms.h"
 #include "xmlutil/Node.h"
 
@@ -14,6 +15,8 @@
 #include "modulesystem/StaticModule.h"
 
 #include "FloatingCamWnd.h"
+#include "render/FrameProfiler.h"
+#include <fstream>
 #include <boost/bind.hpp>
 
 // Constructor
@@ -36,6 +39,10 @@ void GlobalCameraManager::registerCommands()
 
 	GlobalCommandSystem().addCommand("TogglePreview", boost::bind(&GlobalCameraManager::toggleLightingMode, this, _1));
 
+	GlobalCommandSystem().addCommand("BenchmarkCamera", boost::bind(&GlobalCameraManager::benchmark, this, _1));
+	GlobalCommandSystem().addCommand("ExportFrameProfile", boost::bind(&GlobalCameraManager::exportFrameProfile, this, _1),
+		cmd::ARGTYPE_STRING | cmd::ARGTYPE_OPTIONAL);
+
 	// Insert movement commands
 	GlobalCommandSystem().addCommand("CameraForward", boost::bind(&GlobalCameraManager::moveForwardDiscrete, this, _1));
 	GlobalCommandSystem().addCommand("CameraBack", boost::bind(&GlobalCameraManager::moveBackDiscrete, this, _1));
@@ -74,6 +81,15 @@ void GlobalCameraManager::registerCommands()
 
 	GlobalEventManager().addCommand("TogglePreview", "TogglePreview");
 
+	GlobalEventManager().addCommand("BenchmarkCamera", "BenchmarkCamera");
+	GlobalEventManager().addCommand("ExportFrameProfile", "ExportFrameProfile");
+
+	GlobalEventManager().addRegistryToggle("ToggleFrameProfiler", RKEY_SHOW_FRAME_PROFILER);
+	GlobalRegistry().signalForKey(RKEY_SHOW_FRAME_PROFILER).connect(
+		sigc::mem_fun(this, &GlobalCameraManager::onFrameProfilerToggled)
+	);
+	onFrameProfilerToggled();
+
 	// Insert movement commands
 	GlobalEventManager().addCommand("CameraForward", "CameraForward");
 	GlobalEventManager().addCommand("CameraBack", "CameraBack");
@@ -206,7 +222,7 @@ void GlobalCameraManager::decreaseCameraSpeed(const cmd::ArgumentList& args) {
 	registry::setValue(RKEY_MOVEMENT_SPEED, movementSpeed);
 }
 
-void GlobalCameraManager::benchmark() {
+void GlobalCameraManager::benchmark(const cmd::ArgumentList& args) {
 	CamWndPtr camWnd = getActiveCamWnd();
 
 	if (camWnd != NULL) {
@@ -214,6 +230,32 @@ void GlobalCameraManager::benchmark() {
 	}
 }
 
+void GlobalCameraManager::exportFrameProfile(const cmd::ArgumentList& args)
+{
+	std::string filename = !args.empty() ? args[0].getString() :
+		module::getRegistry().getApplicationContext().getSettingsPath() + "frameprofile.json";
+
+	std::ofstream stream(filename.c_str());
+
+	if (!stream.good())
+	{
+		rError() << "Could not open " << filename << " for writing." << std::endl;
+		return;
+	}
+
+	render::FrameProfiler::Instance().writeChromeTrace(stream);
+
+	rMessage() << "Frame profile written to " << filename << std::endl;
+}
+
+void GlobalCameraManager::onFrameProfilerToggled()
+{
+	render::FrameProfiler::Instance().setEnabled(registry::getValue<bool>(RKEY_SHOW_FRAME_PROFILER));
+
+	// Redraw to show or hide the graph
+	update();
+}
+
 void GlobalCameraManager::update() {
 	// Issue the update call to all cameras
 	for (CamWndMap::iterator i = _cameras.begin(); i != _cameras.end(); /* in-loop */ ) {
@@ -486,6 +528,7 @@ const StringSet& GlobalCameraManager::getDependencies() const
 		_dependencies.insert(MODULE_EVENTMANAGER);
 		_dependencies.insert(MODULE_RENDERSYSTEM);
 		_dependencies.insert(MODULE_COMMANDSYSTEM);
+		_dependencies.insert(MODULE_SHADERSYSTEM);
 	}
 
 	return _dependencies;
@@ -508,6 +551,11 @@ void GlobalCameraManager::initialiseModule(const ApplicationContext& ctx)
 	registerCommands();
 
 	CamWnd::captureStates();
+
+	// Textures loaded in the background need a redraw to show up
+	GlobalMaterialManager().signal_texturesStreamed().connect(
+		sigc::mem_fun(*this, &GlobalCameraManager::update)
+	);
 }
 
 void GlobalCameraManager::shutdownModule()
@@ -88,8 +88,12 @@ public:
 	void decreaseCameraSpeed(const cmd::ArgumentList& args);
 
 	// greebo: This measures the rendering time for a full 360 degrees turn of the camera
-	// Note: unused at the moment
-	void benchmark();
+	// and writes the frame profile summary to the console
+	void benchmark(const cmd::ArgumentList& args);
+
+	// Writes the frame profiler history to the given file (or frameprofile.json
+	// in the settings folder) in the Chrome Trace Event format
+	void exportFrameProfile(const cmd::ArgumentList& args);
 
 	void update();
 
@@ -131,6 +135,9 @@ private:
 	// greebo: The construct method registers all the commands
 	void registerCommands();
 
+	// Enables or disables the frame profiler, following the registry key
+	void onFrameProfilerToggled();
+
 }; // class GlobalCameraManager
 
 // The accessor function that contains the static instance of the GlobalCameraManager class
@@ -57,6 +57,16 @@ LogStreamBuf::int_type LogStreamBuf::sync() {
 	return 0;
 }
 
+std::streamsize LogStreamBuf::xsputn(const char* s, std::streamsize count) {
+	writeToBuffer();
+
+	if (count > 0) {
+		LogWriter::Instance().write(s, static_cast<std::size_t>(count), _level);
+	}
+
+	return count;
+}
+
 void LogStreamBuf::writeToBuffer() {
 	int_type charsToWrite = pptr() - pbase();
 
@@ -23,8 +23,11 @@ public:
 	/**
 	 * greebo: Pass the level and the optional buffersize to the constructor.
 	 *         Level can be something like SYS_ERROR, SYS_STANDARD, etc.
+	 *
+	 * The streams are shared by all threads, so they are unbuffered by
+	 * default, a buffer would mix up the output of the threads.
 	 */
-	LogStreamBuf(ELogLevel level, int bufferSize = 1);
+	LogStreamBuf(ELogLevel level, int bufferSize = 0);
 
 	// Cleans up the buffer
 	virtual ~LogStreamBuf();
@@ -35,6 +38,9 @@ protected:
 	virtual int_type overflow(int_type c);
 	virtual int_type sync();
 
+	// Passes whole strings to the device instead of single characters
+	virtual std::streamsize xsputn(const char* s, std::streamsize count);
+
 private:
 	// Writes the buffer contents to the log device
 	void writeToBuffer();
@@ -1,8 +1,37 @@
 #include "LogWriter.h"
 
+#include "ithread.h"
+
 namespace applog {
 
+namespace
+{
+	// The log collecting the output of the calling thread, if any
+	Glib::StaticPrivate<CapturedLog> _threadCapture = GLIBMM_STATIC_PRIVATE_INIT;
+
+	CapturedLog::Level getCaptureLevel(ELogLevel level)
+	{
+		switch (level)
+		{
+		case SYS_ERROR:
+			return CapturedLog::Error;
+		case SYS_WARNING:
+			return CapturedLog::Warning;
+		default:
+			return CapturedLog::Message;
+		}
+	}
+}
+
 void LogWriter::write(const char* p, std::size_t length, ELogLevel level) {
+	CapturedLog* capture = _threadCapture.get();
+
+	// Worker threads must not touch the devices, the console is a GTK widget
+	if (capture != NULL) {
+		capture->append(getCaptureLevel(level), p, length);
+		return;
+	}
+
 	// Convert the buffer to a string
 	std::string output(p, length);
 
@@ -20,6 +49,11 @@ void LogWriter::detach(LogDevice* device) {
 	_devices.erase(device);
 }
 
+void LogWriter::setThreadCapture(CapturedLog* log) {
+	// No destroy function, the log belongs to the caller
+	_threadCapture.set(log, NULL);
+}
+
 LogWriter& LogWriter::Instance() {
 	static LogWriter _writer;
 	return _writer;
@@ -5,6 +5,8 @@
 #include "LogLevels.h"
 #include "LogDevice.h"
 
+class CapturedLog;
+
 namespace applog {
 
 /**
@@ -32,6 +34,13 @@ public:
 	void attach(LogDevice* device);
 	void detach(LogDevice* device);
 
+	/**
+	 * Collects everything written by the calling thread in the given log
+	 * instead of passing it to the devices, pass NULL to stop. The log is
+	 * owned by the caller. See ThreadManager::beginLogCapture().
+	 */
+	static void setThreadCapture(CapturedLog* log);
+
 	// Contains the static singleton instance of this writer
 	static LogWriter& Instance();
 };
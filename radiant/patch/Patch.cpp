@@ -452,6 +452,21 @@ void Patch::importState(const IUndoMementoPtr& state)
 
 	const SavedState& other = *(std::static_pointer_cast<SavedState>(state));
 
+	if (other.m_isDelta)
+	{
+		// The dimensions are unchanged, only overwrite the changed control points
+		other.restoreControlPoints(m_ctrl);
+
+		setShader(other.m_shader);
+		m_patchDef3 = other.m_patchDef3;
+		m_subdivisions_x = other.m_subdivisions_x;
+		m_subdivisions_y = other.m_subdivisions_y;
+
+		textureChanged();
+		controlPointsChanged();
+		return;
+	}
+
 	// begin duplicate of SavedState copy constructor, needs refactoring
 
     // copy construct
@@ -473,6 +488,12 @@ void Patch::importState(const IUndoMementoPtr& state)
 	controlPointsChanged();
 }
 
+IUndoMementoPtr Patch::compactState(const IUndoMementoPtr& state) const
+{
+	return SavedState::compact(state, m_width, m_height, m_ctrl, m_shader,
+		m_patchDef3, m_subdivisions_x, m_subdivisions_y);
+}
+
 void Patch::captureShader()
 {
 	RenderSystemPtr renderSystem = _renderSystem.lock();
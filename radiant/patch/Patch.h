@@ -351,6 +351,9 @@ public:
 	// Revert the state of this patch to the one that has been saved in the UndoMemento
 	void importState(const IUndoMementoPtr& state);
 
+	// Reduces the saved state to the control points which have changed
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const;
+
 	/** greebo: Sets/gets whether this patch is a patchDef3 (fixed tesselation)
 	 */
 	bool subdivionsFixed() const;
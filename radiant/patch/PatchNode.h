@@ -120,6 +120,7 @@ public:
 
 	// LitObject implementation
 	bool intersectsLight(const RendererLight& light) const;
+	const AABB& getLitObjectAABB() const;
 
 	// Renderable implementation
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "iundo.h"
 #include "PatchControl.h"
+#include <memory>
 
 /* greebo: This is a structure that is allocated on the heap and contains all the state
  * information of a patch. This information is used by the UndoSystem to save the current
@@ -18,6 +20,11 @@ public:
 	std::size_t m_subdivisions_x;
 	std::size_t m_subdivisions_y;
 
+	// Delta states created by Patch::compactState() only hold the control
+	// points which have changed, <m_ctrlIndices> contains their indices
+	bool m_isDelta;
+	std::vector<std::size_t> m_ctrlIndices;
+
 	// Constructor
 	SavedState(
 		std::size_t width,
@@ -34,7 +41,77 @@ public:
 		m_ctrl(ctrl),
 		m_patchDef3(patchDef3),
 		m_subdivisions_x(subdivisions_x),
-		m_subdivisions_y(subdivisions_y)
+		m_subdivisions_y(subdivisions_y),
+		m_isDelta(false)
     {
     }
+
+	std::size_t getMemorySize() const
+	{
+		return sizeof(*this) + m_shader.capacity() + m_ctrl.capacity() * sizeof(PatchControl) +
+			m_ctrlIndices.capacity() * sizeof(std::size_t);
+	}
+
+	/**
+	 * Reduces the given full state to the control points which differ from
+	 * the current patch state passed in the other arguments. Returns an empty
+	 * pointer if nothing differs. The full state is returned if the dimensions
+	 * changed or most of the points moved, the indices would outweigh the savings.
+	 */
+	static IUndoMementoPtr compact(const IUndoMementoPtr& state,
+		std::size_t width, std::size_t height, const PatchControlArray& ctrl,
+		const std::string& shader, bool patchDef3,
+		std::size_t subdivisions_x, std::size_t subdivisions_y)
+	{
+		const SavedState& saved = *(std::static_pointer_cast<SavedState>(state));
+
+		if (saved.m_width != width || saved.m_height != height)
+		{
+			return state; // the control points can't be matched, keep the full state
+		}
+
+		std::vector<std::size_t> changed;
+
+		for (std::size_t i = 0; i < ctrl.size(); ++i)
+		{
+			if (saved.m_ctrl[i].vertex != ctrl[i].vertex || saved.m_ctrl[i].texcoord != ctrl[i].texcoord)
+			{
+				changed.push_back(i);
+			}
+		}
+
+		if (changed.empty() && saved.m_shader == shader && saved.m_patchDef3 == patchDef3 &&
+			saved.m_subdivisions_x == subdivisions_x && saved.m_subdivisions_y == subdivisions_y)
+		{
+			return IUndoMementoPtr(); // nothing changed
+		}
+
+		if (changed.size() * (sizeof(PatchControl) + sizeof(std::size_t)) >= ctrl.size() * sizeof(PatchControl))
+		{
+			return state;
+		}
+
+		std::shared_ptr<SavedState> delta(new SavedState(width, height, PatchControlArray(),
+			saved.m_shader, saved.m_patchDef3, saved.m_subdivisions_x, saved.m_subdivisions_y));
+
+		delta->m_isDelta = true;
+		delta->m_ctrlIndices = changed;
+		delta->m_ctrl.reserve(changed.size());
+
+		for (std::size_t i = 0; i < changed.size(); ++i)
+		{
+			delta->m_ctrl.push_back(saved.m_ctrl[changed[i]]);
+		}
+
+		return delta;
+	}
+
+	// Delta states only: writes the saved control points back into the given array
+	void restoreControlPoints(PatchControlArray& ctrl) const
+	{
+		for (std::size_t i = 0; i < m_ctrlIndices.size(); ++i)
+		{
+			ctrl[m_ctrlIndices[i]] = m_ctrl[i];
+		}
+	}
 };
@@ -0,0 +1,36 @@
+#include "BackgroundModelLoader.h"
+
+namespace model
+{
+
+namespace
+{
+	// Maximum number of thread pool jobs parsing models at the same time
+	const std::size_t MAX_WORKERS = 4;
+}
+
+BackgroundModelLoader::BackgroundModelLoader() :
+	BackgroundRequestQueue<ModelLoadRequest>(&BackgroundModelLoader::process, MAX_WORKERS)
+{}
+
+void BackgroundModelLoader::request(const std::string& path, const ModelLoaderPtr& loader,
+									const ArchiveFilePtr& file)
+{
+	RequestPtr request(new Request);
+
+	request->path = path;
+	request->loader = loader;
+	request->file = file;
+
+	push(request);
+}
+
+void BackgroundModelLoader::process(Request& request)
+{
+	request.prepared = request.loader->prepareModel(*request.file);
+
+	// The file is not needed on the main thread anymore
+	request.file.reset();
+}
+
+} // namespace model
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "imodel.h"
+#include "iarchive.h"
+#include "ithread.h"
+#include "BackgroundRequestQueue.h"
+
+namespace model
+{
+
+struct ModelLoadRequest
+{
+	// The VFS path of the model
+	std::string path;
+
+	ModelLoaderPtr loader;
+
+	// Opened on the main thread, read and closed by the worker
+	ArchiveFilePtr file;
+
+	// Set by the worker, NULL if the file couldn't be parsed
+	PreparedModelPtr prepared;
+
+	// The messages of the loader, written before the model is created
+	CapturedLog log;
+};
+
+/**
+ * Parses model files in the background. The files are opened on the
+ * main thread, reading and parsing them is done by ModelLoader::prepareModel()
+ * in a limited number of thread pool jobs. The ModelCache collects the results
+ * on the main thread.
+ */
+class BackgroundModelLoader :
+	public BackgroundRequestQueue<ModelLoadRequest>
+{
+public:
+	typedef ModelLoadRequest Request;
+
+	BackgroundModelLoader();
+
+	// Queues the given file for parsing by the given loader
+	void request(const std::string& path, const ModelLoaderPtr& loader, const ArchiveFilePtr& file);
+
+private:
+	// Parses a single request, called on a worker thread
+	static void process(Request& request);
+};
+
+} // namespace model
@@ -10,6 +10,7 @@
 #include "ieventmanager.h"
 #include "iparticles.h"
 #include "iparticlenode.h"
+#include "iscenegraph.h"
 
 #include <iostream>
 #include <set>
@@ -200,6 +201,112 @@ scene::INodePtr ModelCache::getModelNode(const std::string& modelPath)
 	return NullModelLoader::InstancePtr()->loadModel(actualModelPath);
 }
 
+scene::INodePtr ModelCache::getModelNodeAsync(const std::string& modelPath)
+{
+	if (!_backgroundLoader)
+	{
+		return getModelNode(modelPath);
+	}
+
+	// Resolve modelDefs the same way getModelNode() does
+	IModelDefPtr modelDef = GlobalEntityClassManager().findModel(modelPath);
+	std::string actualModelPath = modelDef ? modelDef->mesh : modelPath;
+
+	std::string type = actualModelPath.substr(actualModelPath.rfind(".") + 1);
+
+	if (type == "prt")
+	{
+		return getModelNode(modelPath);
+	}
+
+	// The VFS path the model loaders pass to getModel()
+	std::string name = os::getRelativePath(actualModelPath, rootPath(actualModelPath));
+
+	if (_enabled && _modelMap.find(name) != _modelMap.end())
+	{
+		// Already loaded, constructing the node is cheap
+		return getModelNode(modelPath);
+	}
+
+	PendingModelMap::iterator pending = _pendingModels.find(name);
+
+	if (pending == _pendingModels.end())
+	{
+		ArchiveFilePtr file = GlobalFileSystem().openFile(name);
+
+		if (!file)
+		{
+			// Let the loader report the error and return the NullModel
+			return getModelNode(modelPath);
+		}
+
+		_backgroundLoader->request(name, getModelLoaderForType(type), file);
+
+		pending = _pendingModels.insert(PendingModelMap::value_type(name, Proxies())).first;
+	}
+
+	ModelProxyNodePtr proxy(new ModelProxyNode(modelPath));
+	pending->second.push_back(proxy);
+
+	return proxy;
+}
+
+void ModelCache::waitForPendingModels()
+{
+	if (!_backgroundLoader) return;
+
+	_backgroundLoader->waitForPendingRequests();
+
+	finishPendingModels();
+}
+
+void ModelCache::finishPendingModels()
+{
+	BackgroundModelLoader::Requests finished;
+	_backgroundLoader->takeFinishedRequests(finished);
+
+	if (finished.empty()) return;
+
+	for (BackgroundModelLoader::Requests::const_iterator i = finished.begin(); i != finished.end(); ++i)
+	{
+		const BackgroundModelLoader::Request& request = **i;
+
+		// The loader messages couldn't go to the console on the worker thread
+		request.log.writeToLog();
+
+		IModelPtr model = request.prepared ?
+			request.loader->createModel(request.path, request.prepared) : IModelPtr();
+
+		if (model && _enabled)
+		{
+			// Doesn't replace a model which has been loaded synchronously meanwhile
+			_modelMap.insert(ModelMap::value_type(request.path, model));
+		}
+
+		PendingModelMap::iterator pending = _pendingModels.find(request.path);
+
+		if (pending == _pendingModels.end()) continue;
+
+		Proxies proxies;
+		proxies.swap(pending->second);
+
+		_pendingModels.erase(pending);
+
+		for (Proxies::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+		{
+			ModelProxyNodePtr proxy = p->lock();
+
+			if (!proxy) continue; // discarded in the meantime
+
+			// This is served from the cache now. Models which failed in the
+			// background are loaded again here, reporting the error.
+			proxy->modelLoaded(getModelNode(proxy->getModelPath()));
+		}
+	}
+
+	SceneChangeNotify();
+}
+
 IModelPtr ModelCache::getModel(const std::string& modelPath) {
 	// Try to lookup the existing model
 	ModelMap::iterator found = _modelMap.find(modelPath);
@@ -239,6 +346,11 @@ void ModelCache::clear() {
 	_enabled = true;
 }
 
+void ModelCache::waitForPendingModelsCmd(const cmd::ArgumentList& args)
+{
+	waitForPendingModels();
+}
+
 void ModelCache::refreshModels(const cmd::ArgumentList& args)
 {
 	// Disable screen updates for the scope of this function
@@ -319,11 +431,24 @@ void ModelCache::initialiseModule(const ApplicationContext& ctx) {
 		"RefreshSelectedModels",
 		boost::bind(&ModelCache::refreshSelectedModels, this, _1)
 	);
+	GlobalCommandSystem().addCommand(
+		"WaitForPendingModels",
+		boost::bind(&ModelCache::waitForPendingModelsCmd, this, _1)
+	);
 	GlobalEventManager().addCommand("RefreshModels", "RefreshModels");
 	GlobalEventManager().addCommand("RefreshSelectedModels", "RefreshSelectedModels");
+
+	_backgroundLoader.reset(new BackgroundModelLoader);
+	_backgroundLoader->signal_requestsFinished().connect(
+		sigc::mem_fun(*this, &ModelCache::finishPendingModels)
+	);
 }
 
 void ModelCache::shutdownModule() {
+	// Wait for the running jobs, the proxies are discarded anyway
+	_backgroundLoader.reset();
+	_pendingModels.clear();
+
 	clear();
 }
 
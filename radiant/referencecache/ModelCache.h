@@ -2,8 +2,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include "imodelcache.h"
 #include "icommandsystem.h"
+#include "BackgroundModelLoader.h"
+#include "ModelProxyNode.h"
+#include <boost/scoped_ptr.hpp>
 
 namespace model {
 
@@ -17,12 +21,27 @@ class ModelCache :
 	// Flag to disable the cache on demand (used during clear())
 	bool _enabled;
 
+	// Parses the models requested by getModelNodeAsync(),
+	// constructed in initialiseModule()
+	boost::scoped_ptr<BackgroundModelLoader> _backgroundLoader;
+
+	// The proxies waiting for a model being loaded, by VFS path
+	typedef std::vector<ModelProxyNodeWeakPtr> Proxies;
+	typedef std::map<std::string, Proxies> PendingModelMap;
+	PendingModelMap _pendingModels;
+
 public:
 	ModelCache();
 
 	// greebo: For documentation, see the abstract base class.
 	virtual scene::INodePtr getModelNode(const std::string& modelPath);
 
+	// greebo: For documentation, see the abstract base class.
+	virtual scene::INodePtr getModelNodeAsync(const std::string& modelPath);
+
+	// greebo: For documentation, see the abstract base class.
+	virtual void waitForPendingModels();
+
 	// greebo: For documentation, see the abstract base class.
 	virtual IModelPtr getModel(const std::string& modelPath);
 
@@ -37,12 +56,19 @@ public:
 	void refreshModels(const cmd::ArgumentList& args);
 	// Command target: this reloads all selected models in the map
 	void refreshSelectedModels(const cmd::ArgumentList& args);
+	// Command target: blocks until all models are loaded, for scripts
+	void waitForPendingModelsCmd(const cmd::ArgumentList& args);
 
 	// RegisterableModule implementation
 	virtual const std::string& getName() const;
 	virtual const StringSet& getDependencies() const;
 	virtual void initialiseModule(const ApplicationContext& ctx);
 	virtual void shutdownModule();
+
+private:
+	// Creates the models parsed by the background loader and
+	// replaces the waiting proxies with the real model nodes
+	void finishPendingModels();
 };
 
 } // namespace model
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "imodelcache.h"
+#include "NullModelNode.h"
+
+namespace model
+{
+
+class ModelProxyNode;
+typedef boost::shared_ptr<ModelProxyNode> ModelProxyNodePtr;
+typedef boost::weak_ptr<ModelProxyNode> ModelProxyNodeWeakPtr;
+
+/**
+ * Stands in for a model which is being loaded in the background,
+ * see ModelCache::getModelNodeAsync(). Renders as NullModel box.
+ */
+class ModelProxyNode :
+	public NullModelNode,
+	public IModelProxyNode
+{
+private:
+	// The path as requested from the ModelCache, might be a modelDef name
+	std::string _modelPath;
+
+	sigc::signal<void, scene::INodePtr> _sigModelLoaded;
+
+public:
+	ModelProxyNode(const std::string& modelPath) :
+		NullModelNode(createNullModel(modelPath)),
+		_modelPath(modelPath)
+	{}
+
+	std::string name() const
+	{
+		return "modelproxy";
+	}
+
+	const std::string& getModelPath() const
+	{
+		return _modelPath;
+	}
+
+	sigc::signal<void, scene::INodePtr> signal_modelLoaded() const
+	{
+		return _sigModelLoaded;
+	}
+
+	// Called by the ModelCache once the real node is available
+	void modelLoaded(const scene::INodePtr& node)
+	{
+		_sigModelLoaded.emit(node);
+	}
+
+private:
+	static NullModelPtr createNullModel(const std::string& modelPath)
+	{
+		NullModelPtr model(new NullModel);
+
+		model->setModelPath(modelPath);
+		model->setFilename(modelPath);
+
+		return model;
+	}
+};
+
+} // namespace model
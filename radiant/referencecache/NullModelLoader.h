@@ -49,6 +49,15 @@ public:
 		return model;
 	}
 
+	// Nothing to load in the background
+	PreparedModelPtr prepareModel(ArchiveFile& file) {
+		return PreparedModelPtr();
+	}
+
+	IModelPtr createModel(const std::string& name, const PreparedModelPtr& prepared) {
+		return loadModelFromPath(name);
+	}
+
 	// RegisterableModule implementation
 	virtual const std::string& getName() const {
 		static std::string _name(MODULE_MODELLOADER + "NULL");
@@ -0,0 +1,532 @@
+#include "FrameProfiler.h"
+
+#include "igl.h"
+#include "math/AABB.h"
+#include "math/Matrix4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <boost/format.hpp>
+
+namespace render
+{
+
+namespace
+{
+	// Colours used for the zones in the graph overlay
+	const float ZONE_COLOURS[NUM_PROFILE_ZONES][3] =
+	{
+		{ 0.9f, 0.3f, 0.3f }, // cull
+		{ 0.9f, 0.7f, 0.2f }, // collect
+		{ 0.7f, 0.9f, 0.2f }, // sort
+		{ 0.2f, 0.8f, 0.8f }, // state
+		{ 0.3f, 0.5f, 1.0f }, // draw
+		{ 0.8f, 0.4f, 0.9f }, // overlay
+	};
+
+	// The graph is scaled such that this frame time hits the top
+	const double GRAPH_MAX_MSEC = 50.0;
+
+	// Percentile using the nearest-rank method, expects a sorted vector
+	double getPercentile(const std::vector<double>& sorted, double percent)
+	{
+		if (sorted.empty()) return 0;
+
+		std::size_t rank = static_cast<std::size_t>(percent / 100.0 * sorted.size() + 0.5);
+		rank = std::max<std::size_t>(rank, 1);
+
+		return sorted[std::min(rank, sorted.size()) - 1];
+	}
+
+	void writeSummaryLine(std::ostream& stream, const std::string& name,
+						  std::vector<double>& values, double avgCount)
+	{
+		std::sort(values.begin(), values.end());
+
+		double sum = 0;
+		for (std::size_t i = 0; i < values.size(); ++i)
+		{
+			sum += values[i];
+		}
+
+		stream << (boost::format("  %-8s mean %7.3f | p50 %7.3f | p90 %7.3f | p99 %7.3f | max %7.3f msec | items %9.1f")
+			% name
+			% (values.empty() ? 0 : sum / values.size())
+			% getPercentile(values, 50)
+			% getPercentile(values, 90)
+			% getPercentile(values, 99)
+			% (values.empty() ? 0 : values.back())
+			% avgCount) << std::endl;
+	}
+}
+
+FrameProfiler::FrameProfiler() :
+	_enabled(false),
+	_timeBase(g_get_monotonic_time()),
+	_written(0),
+	_eventsWritten(0),
+	_frameCounter(0),
+	_frameActive(false),
+	_zoneDepth(0),
+	_zoneResumed(0)
+{
+	std::memset(_ring, 0, sizeof(_ring));
+	std::memset(_events, 0, sizeof(_events));
+	std::memset(&_current, 0, sizeof(_current));
+
+	for (std::size_t i = 0; i < HISTORY_SIZE; ++i)
+	{
+		_sequence[i] = 0;
+	}
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+	_enabled = enabled;
+
+	if (!_enabled)
+	{
+		// Discard any unfinished frame
+		_frameActive = false;
+		_zoneDepth = 0;
+	}
+}
+
+gint64 FrameProfiler::now() const
+{
+	return g_get_monotonic_time() - _timeBase;
+}
+
+void FrameProfiler::beginFrame(ProfiledView view)
+{
+	if (!_enabled) return;
+
+	std::memset(&_current, 0, sizeof(_current));
+
+	_current.frameNumber = _frameCounter++;
+	_current.view = view;
+	_current.start = now();
+	_current.firstEvent = static_cast<std::size_t>(g_atomic_int_get(&_eventsWritten));
+
+	_zoneDepth = 0;
+	_frameActive = true;
+}
+
+void FrameProfiler::endFrame()
+{
+	if (!_frameActive) return;
+
+	// Close any zones left open
+	while (_zoneDepth > 0)
+	{
+		leaveZone();
+	}
+
+	_current.duration = now() - _current.start;
+	_current.numEvents = static_cast<std::size_t>(g_atomic_int_get(&_eventsWritten)) - _current.firstEvent;
+	_frameActive = false;
+
+	// The extrapolated samples might exceed the time measured for the enclosing zone
+	for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+	{
+		_current.zoneTime[zone] = std::max<gint64>(_current.zoneTime[zone], 0);
+	}
+
+	// Publish the frame into the next ring slot
+	std::size_t slot = static_cast<std::size_t>(g_atomic_int_get(&_written)) % HISTORY_SIZE;
+
+	g_atomic_int_inc(&_sequence[slot]); // odd: slot is being written
+	_ring[slot] = _current;
+	g_atomic_int_inc(&_sequence[slot]); // even: slot is consistent
+
+	g_atomic_int_inc(&_written);
+}
+
+void FrameProfiler::enterZone(ProfileZone zone)
+{
+	if (!_frameActive || _zoneDepth >= MAX_ZONE_DEPTH) return;
+
+	gint64 time = now();
+
+	// Pause the parent zone, its exclusive time doesn't include ours
+	if (_zoneDepth > 0)
+	{
+		_current.zoneTime[_zoneStack[_zoneDepth - 1]] += time - _zoneResumed;
+	}
+
+	_zoneStack[_zoneDepth] = zone;
+	_zoneEntered[_zoneDepth++] = time;
+	_zoneResumed = time;
+}
+
+void FrameProfiler::leaveZone()
+{
+	if (!_frameActive || _zoneDepth == 0) return;
+
+	gint64 time = now();
+
+	--_zoneDepth;
+	_current.zoneTime[_zoneStack[_zoneDepth]] += time - _zoneResumed;
+
+	// Publish the event, the slot of the oldest event is reused
+	std::size_t index = static_cast<std::size_t>(g_atomic_int_get(&_eventsWritten));
+
+	ZoneEvent& event = _events[index % EVENT_HISTORY_SIZE];
+	event.zone = _zoneStack[_zoneDepth];
+	event.start = _zoneEntered[_zoneDepth];
+	event.duration = time - _zoneEntered[_zoneDepth];
+
+	g_atomic_int_inc(&_eventsWritten);
+
+	// Resume the parent zone
+	_zoneResumed = time;
+}
+
+void FrameProfiler::addSample(ProfileZone zone, gint64 start)
+{
+	if (!_frameActive) return;
+
+	gint64 time = (now() - start) * SAMPLE_INTERVAL;
+
+	_current.zoneTime[zone] += time;
+	_current.zoneSampledTime[zone] += time;
+
+	// The call ran inside the active zone, which must not count it as well
+	if (_zoneDepth > 0)
+	{
+		_current.zoneTime[_zoneStack[_zoneDepth - 1]] -= time;
+	}
+}
+
+void FrameProfiler::getHistory(FrameRecords& frames) const
+{
+	frames.clear();
+
+	std::size_t written = static_cast<std::size_t>(g_atomic_int_get(&_written));
+	std::size_t available = std::min(written, HISTORY_SIZE);
+
+	frames.reserve(available);
+
+	for (std::size_t i = written - available; i < written; ++i)
+	{
+		std::size_t slot = i % HISTORY_SIZE;
+
+		gint before = g_atomic_int_get(&_sequence[slot]);
+
+		if (before % 2 != 0) continue; // being written right now
+
+		FrameRecord record = _ring[slot];
+
+		if (g_atomic_int_get(&_sequence[slot]) != before) continue; // overwritten while copying
+
+		frames.push_back(record);
+	}
+}
+
+void FrameProfiler::getHistory(FrameRecords& frames, ProfiledView view) const
+{
+	FrameRecords all;
+	getHistory(all);
+
+	frames.clear();
+
+	for (FrameRecords::const_iterator i = all.begin(); i != all.end(); ++i)
+	{
+		if (i->view == view)
+		{
+			frames.push_back(*i);
+		}
+	}
+}
+
+void FrameProfiler::getZoneEvents(const FrameRecord& frame, ZoneEvents& events) const
+{
+	events.clear();
+	events.reserve(frame.numEvents);
+
+	for (std::size_t i = frame.firstEvent; i < frame.firstEvent + frame.numEvents; ++i)
+	{
+		// Leave out events overwritten by newer ones (or being overwritten)
+		if (i + EVENT_HISTORY_SIZE <= static_cast<std::size_t>(g_atomic_int_get(&_eventsWritten)))
+		{
+			continue;
+		}
+
+		ZoneEvent event = _events[i % EVENT_HISTORY_SIZE];
+
+		if (i + EVENT_HISTORY_SIZE <= static_cast<std::size_t>(g_atomic_int_get(&_eventsWritten)))
+		{
+			continue; // overwritten while copying
+		}
+
+		events.push_back(event);
+	}
+}
+
+void FrameProfiler::clearHistory()
+{
+	g_atomic_int_set(&_written, 0);
+}
+
+void FrameProfiler::writeChromeTrace(std::ostream& stream) const
+{
+	FrameRecords frames;
+	getHistory(frames);
+
+	stream << "{\"traceEvents\":[" << std::endl;
+
+	bool first = true;
+
+	// Name the tracks, one process per view and one thread per zone
+	for (int view = 0; view < NUM_PROFILED_VIEWS; ++view)
+	{
+		stream << (first ? "" : ",\n") << (boost::format(
+			"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}")
+			% view % getViewName(static_cast<ProfiledView>(view)));
+		first = false;
+
+		for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+		{
+			stream << ",\n" << (boost::format(
+				"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}")
+				% view % (zone + 1) % getZoneName(static_cast<ProfileZone>(zone)));
+		}
+	}
+
+	ZoneEvents events;
+
+	for (FrameRecords::const_iterator f = frames.begin(); f != frames.end(); ++f)
+	{
+		stream << ",\n" << (boost::format(
+			"{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":%d,\"tid\":0,\"args\":{\"frame\":%d}}")
+			% f->start % f->duration % f->view % f->frameNumber);
+
+		getZoneEvents(*f, events);
+
+		for (ZoneEvents::const_iterator e = events.begin(); e != events.end(); ++e)
+		{
+			stream << ",\n" << (boost::format(
+				"{\"name\":\"%s\",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"frame\":%d}}")
+				% getZoneName(e->zone) % e->start % e->duration % f->view % (e->zone + 1)
+				% f->frameNumber);
+		}
+
+		// The sampled zones have no events, write their time per frame
+		for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+		{
+			if (f->zoneSampledTime[zone] == 0) continue;
+
+			stream << ",\n" << (boost::format(
+				"{\"name\":\"%s (sampled)\",\"cat\":\"zone\",\"ph\":\"C\",\"ts\":%d,\"pid\":%d,\"args\":{\"usec\":%d,\"count\":%d}}")
+				% getZoneName(static_cast<ProfileZone>(zone))
+				% f->start % f->view % f->zoneSampledTime[zone] % f->zoneCount[zone]);
+		}
+	}
+
+	stream << std::endl << "]}" << std::endl;
+}
+
+void FrameProfiler::writeSummary(std::ostream& stream, const FrameRecords& frames)
+{
+	stream << "Frame profile summary (" << frames.size() << " frames)" << std::endl;
+
+	if (frames.empty()) return;
+
+	std::vector<double> values;
+	values.reserve(frames.size());
+
+	for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+	{
+		values.clear();
+		double count = 0;
+
+		for (FrameRecords::const_iterator f = frames.begin(); f != frames.end(); ++f)
+		{
+			values.push_back(f->zoneTime[zone] / 1000.0);
+			count += f->zoneCount[zone];
+		}
+
+		writeSummaryLine(stream, getZoneName(static_cast<ProfileZone>(zone)),
+			values, count / frames.size());
+	}
+
+	values.clear();
+
+	for (FrameRecords::const_iterator f = frames.begin(); f != frames.end(); ++f)
+	{
+		values.push_back(f->duration / 1000.0);
+	}
+
+	writeSummaryLine(stream, "Total", values, 0);
+}
+
+void FrameProfiler::drawGraph(ProfiledView view, float x, float y, float width, float height) const
+{
+	FrameRecords frames;
+	getHistory(frames, view);
+
+	// Semi-transparent background
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	glColor4f(0, 0, 0, 0.5f);
+	glBegin(GL_QUADS);
+	glVertex2f(x, y);
+	glVertex2f(x + width, y);
+	glVertex2f(x + width, y + height);
+	glVertex2f(x, y + height);
+	glEnd();
+
+	glDisable(GL_BLEND);
+
+	// One bar per frame, newest on the right
+	float barWidth = 2.0f;
+	std::size_t maxBars = static_cast<std::size_t>(width / barWidth);
+	std::size_t firstFrame = frames.size() > maxBars ? frames.size() - maxBars : 0;
+
+	float scale = static_cast<float>(height / (GRAPH_MAX_MSEC * 1000.0));
+	float bottom = y + height;
+
+	glBegin(GL_QUADS);
+
+	for (std::size_t i = firstFrame; i < frames.size(); ++i)
+	{
+		float left = x + (i - firstFrame) * barWidth;
+		float base = bottom;
+
+		for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+		{
+			float top = std::max(base - frames[i].zoneTime[zone] * scale, y);
+
+			glColor3fv(ZONE_COLOURS[zone]);
+			glVertex2f(left, base);
+			glVertex2f(left + barWidth, base);
+			glVertex2f(left + barWidth, top);
+			glVertex2f(left, top);
+
+			base = top;
+		}
+	}
+
+	glEnd();
+
+	// Reference lines at 60 and 30 fps
+	glColor3f(1, 1, 1);
+	glBegin(GL_LINES);
+	glVertex2f(x, bottom - 16667 * scale);
+	glVertex2f(x + width, bottom - 16667 * scale);
+	glVertex2f(x, bottom - 33333 * scale);
+	glVertex2f(x + width, bottom - 33333 * scale);
+	glEnd();
+
+	// Legend with the figures of the most recent frame
+	if (frames.empty()) return;
+
+	const FrameRecord& last = frames.back();
+
+	for (int zone = 0; zone < NUM_PROFILE_ZONES; ++zone)
+	{
+		glColor3fv(ZONE_COLOURS[zone]);
+		glRasterPos3f(x + width + 4, y + 10 + zone * 11.0f, 0);
+
+		GlobalOpenGL().drawString((boost::format("%s: %.2f ms (%d)")
+			% getZoneName(static_cast<ProfileZone>(zone))
+			% (last.zoneTime[zone] / 1000.0)
+			% last.zoneCount[zone]).str());
+	}
+
+	glColor3f(1, 1, 1);
+	glRasterPos3f(x + width + 4, y + 10 + NUM_PROFILE_ZONES * 11.0f, 0);
+	GlobalOpenGL().drawString((boost::format("Frame: %.2f ms") % (last.duration / 1000.0)).str());
+}
+
+const char* FrameProfiler::getZoneName(ProfileZone zone)
+{
+	switch (zone)
+	{
+	case PROFILE_ZONE_CULL: return "Cull";
+	case PROFILE_ZONE_COLLECT: return "Collect";
+	case PROFILE_ZONE_SORT: return "Sort";
+	case PROFILE_ZONE_STATE: return "State";
+	case PROFILE_ZONE_DRAW: return "Draw";
+	case PROFILE_ZONE_OVERLAY: return "Overlay";
+	default: return "Unknown";
+	};
+}
+
+const char* FrameProfiler::getViewName(ProfiledView view)
+{
+	switch (view)
+	{
+	case PROFILE_VIEW_CAMERA: return "Camera";
+	case PROFILE_VIEW_ORTHO: return "Orthoview";
+	default: return "Unknown";
+	};
+}
+
+FrameProfiler& FrameProfiler::Instance()
+{
+	static FrameProfiler _instance;
+	return _instance;
+}
+
+// ProfiledVolumeTest
+
+bool ProfiledVolumeTest::TestPoint(const Vector3& point) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestPoint(point);
+}
+
+bool ProfiledVolumeTest::TestLine(const Segment& segment) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestLine(segment);
+}
+
+bool ProfiledVolumeTest::TestPlane(const Plane3& plane) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestPlane(plane);
+}
+
+bool ProfiledVolumeTest::TestPlane(const Plane3& plane, const Matrix4& localToWorld) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestPlane(plane, localToWorld);
+}
+
+VolumeIntersectionValue ProfiledVolumeTest::TestAABB(const AABB& aabb) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestAABB(aabb);
+}
+
+VolumeIntersectionValue ProfiledVolumeTest::TestAABB(const AABB& aabb, const Matrix4& localToWorld) const
+{
+	SampledProfileZone zone(PROFILE_ZONE_CULL);
+	return _volume.TestAABB(aabb, localToWorld);
+}
+
+bool ProfiledVolumeTest::fill() const
+{
+	return _volume.fill();
+}
+
+const Matrix4& ProfiledVolumeTest::GetViewport() const
+{
+	return _volume.GetViewport();
+}
+
+const Matrix4& ProfiledVolumeTest::GetProjection() const
+{
+	return _volume.GetProjection();
+}
+
+const Matrix4& ProfiledVolumeTest::GetModelview() const
+{
+	return _volume.GetModelview();
+}
+
+} // namespace
@@ -0,0 +1,300 @@
+#pragma once
+
+#include "ivolumetest.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <glib.h>
+
+namespace render
+{
+
+/// The distinct phases of a rendered frame tracked by the FrameProfiler
+enum ProfileZone
+{
+	PROFILE_ZONE_CULL,		// volume tests during scene traversal
+	PROFILE_ZONE_COLLECT,	// scene traversal and renderable submission
+	PROFILE_ZONE_SORT,		// bucketing renderables into shader passes
+	PROFILE_ZONE_STATE,		// applying OpenGL state per shader pass
+	PROFILE_ZONE_DRAW,		// issuing the actual draw calls
+	PROFILE_ZONE_OVERLAY,	// 2D overlays, clipper points, text
+	NUM_PROFILE_ZONES
+};
+
+/// The views which are submitting frames to the profiler
+enum ProfiledView
+{
+	PROFILE_VIEW_CAMERA,
+	PROFILE_VIEW_ORTHO,
+	NUM_PROFILED_VIEWS
+};
+
+/// A single entry into a zone, all times are in microseconds
+struct ZoneEvent
+{
+	ProfileZone zone;
+
+	// Entry time relative to the profiler's time base
+	gint64 start;
+
+	// Time until the zone was left, including nested zones
+	gint64 duration;
+};
+typedef std::vector<ZoneEvent> ZoneEvents;
+
+/// Timings of a single finished frame, all times are in microseconds
+struct FrameRecord
+{
+	std::size_t frameNumber;
+	ProfiledView view;
+
+	// Frame start relative to the profiler's time base
+	gint64 start;
+	gint64 duration;
+
+	// Exclusive time spent in each zone (nested zones are subtracted)
+	gint64 zoneTime[NUM_PROFILE_ZONES];
+
+	// The part of zoneTime extrapolated from sampled calls, these have no zone events
+	gint64 zoneSampledTime[NUM_PROFILE_ZONES];
+
+	// Number of items processed by each zone (tests, renderables, passes...)
+	std::size_t zoneCount[NUM_PROFILE_ZONES];
+
+	// The zone events of this frame, see FrameProfiler::getZoneEvents()
+	std::size_t firstEvent;
+	std::size_t numEvents;
+};
+typedef std::vector<FrameRecord> FrameRecords;
+
+/**
+ * The FrameProfiler collects per-zone timings of the frames
+ * drawn by the camera and the orthoviews. Finished frames are stored in a
+ * fixed-size ring buffer which is written by the render thread only.
+ * Each slot is guarded by a sequence counter, so readers can take snapshots
+ * without blocking the writer (they simply skip slots being overwritten).
+ *
+ * Every entry into a zone is recorded as ZoneEvent in a second ring buffer,
+ * which holds fewer frames than the frame history if the frames are busy.
+ * Calls which are too short and frequent to be timed each time (volume tests,
+ * renderable submissions) are sampled instead, see SampledProfileZone.
+ *
+ * Profiling is off by default, all zone calls reduce to a single
+ * flag check in that case.
+ */
+class FrameProfiler
+{
+public:
+	// Number of frames kept in the history
+	static const std::size_t HISTORY_SIZE = 512;
+
+	// Number of zone events kept in the history
+	static const std::size_t EVENT_HISTORY_SIZE = 131072;
+
+	// Only one in this many calls of a sampled zone is timed
+	static const std::size_t SAMPLE_INTERVAL = 32;
+
+private:
+	bool _enabled;
+
+	// Time base, all recorded times are relative to this
+	gint64 _timeBase;
+
+	FrameRecord _ring[HISTORY_SIZE];
+
+	// Per-slot sequence counters, odd while the slot is written
+	volatile gint _sequence[HISTORY_SIZE];
+
+	// Total number of frames ever written (the next slot is _written % SIZE)
+	volatile gint _written;
+
+	ZoneEvent _events[EVENT_HISTORY_SIZE];
+
+	// Total number of zone events ever written, like _written
+	volatile gint _eventsWritten;
+
+	std::size_t _frameCounter;
+
+	// The frame in progress
+	FrameRecord _current;
+	bool _frameActive;
+
+	// The stack of active zones, used to calculate exclusive times
+	enum { MAX_ZONE_DEPTH = 16 };
+	ProfileZone _zoneStack[MAX_ZONE_DEPTH];
+	gint64 _zoneEntered[MAX_ZONE_DEPTH];
+	std::size_t _zoneDepth;
+	gint64 _zoneResumed;
+
+public:
+	FrameProfiler();
+
+	bool isEnabled() const
+	{
+		return _enabled;
+	}
+
+	// Enables or disables the recording of frames. Disabling doesn't clear the history.
+	void setEnabled(bool enabled);
+
+	// Returns the number of frames begun so far, can be used to identify
+	// the frames recorded after a certain point in time
+	std::size_t getFrameCount() const
+	{
+		return _frameCounter;
+	}
+
+	// Returns the current time in microseconds relative to the time base
+	gint64 now() const;
+
+	// Frame handling, frames of different views must not be interleaved
+	void beginFrame(ProfiledView view);
+	void endFrame();
+
+	// Zone handling, use the ScopedProfileZone class instead of calling these directly
+	void enterZone(ProfileZone zone);
+	void leaveZone();
+
+	// Counts a call of a sampled zone, returns true if this call is to be timed.
+	// Use the SampledProfileZone class instead of calling these directly.
+	bool sampleCall(ProfileZone zone)
+	{
+		return _frameActive && _current.zoneCount[zone]++ % SAMPLE_INTERVAL == 0;
+	}
+
+	// Adds the extrapolated time of a timed call started at the given time
+	void addSample(ProfileZone zone, gint64 start);
+
+	// Adds the given amount to the item counter of the given zone
+	void addCount(ProfileZone zone, std::size_t count = 1)
+	{
+		if (_frameActive)
+		{
+			_current.zoneCount[zone] += count;
+		}
+	}
+
+	// Copies the recorded frames (oldest first) into the given vector.
+	// Slots currently being written are skipped. Safe to call from any thread.
+	void getHistory(FrameRecords& frames) const;
+
+	// Returns the history of the given view only
+	void getHistory(FrameRecords& frames, ProfiledView view) const;
+
+	// Copies the zone events of the given frame, events which have
+	// already been overwritten by newer frames are left out
+	void getZoneEvents(const FrameRecord& frame, ZoneEvents& events) const;
+
+	// Forgets all recorded frames
+	void clearHistory();
+
+	/**
+	 * Writes the recorded history in the Chrome Trace Event format
+	 * (load it in chrome://tracing). Each zone is put on its own track,
+	 * the frame itself is the first track. The sampled time of a frame is
+	 * written as counter, since it has no events.
+	 */
+	void writeChromeTrace(std::ostream& stream) const;
+
+	// Writes a summary (mean and percentiles per zone) of the given frames
+	static void writeSummary(std::ostream& stream, const FrameRecords& frames);
+
+	/**
+	 * Draws a stacked bar graph of the recent frames of the given view.
+	 * Expects an orthographic projection with the origin at the top left
+	 * and the pixel size as unit (as set up by the CamWnd for its 2D stuff).
+	 */
+	void drawGraph(ProfiledView view, float x, float y, float width, float height) const;
+
+	static const char* getZoneName(ProfileZone zone);
+	static const char* getViewName(ProfiledView view);
+
+	static FrameProfiler& Instance();
+};
+
+/// Scoped object measuring the time spent in its lifetime
+class ScopedProfileZone
+{
+	FrameProfiler& _profiler;
+	bool _active;
+
+public:
+	ScopedProfileZone(ProfileZone zone) :
+		_profiler(FrameProfiler::Instance()),
+		_active(_profiler.isEnabled())
+	{
+		if (_active)
+		{
+			_profiler.enterZone(zone);
+		}
+	}
+
+	~ScopedProfileZone()
+	{
+		if (_active)
+		{
+			_profiler.leaveZone();
+		}
+	}
+};
+
+/**
+ * Scoped object for calls which are too short and too frequent to be
+ * timed each time, reading the clock would cost more than the call itself.
+ * Every call is counted, one in FrameProfiler::SAMPLE_INTERVAL is timed
+ * and its time is extrapolated to the others.
+ */
+class SampledProfileZone
+{
+	FrameProfiler& _profiler;
+	ProfileZone _zone;
+	bool _timed;
+	gint64 _start;
+
+public:
+	SampledProfileZone(ProfileZone zone) :
+		_profiler(FrameProfiler::Instance()),
+		_zone(zone),
+		_timed(_profiler.isEnabled() && _profiler.sampleCall(zone)),
+		_start(_timed ? _profiler.now() : 0)
+	{}
+
+	~SampledProfileZone()
+	{
+		if (_timed)
+		{
+			_profiler.addSample(_zone, _start);
+		}
+	}
+};
+
+/**
+ * A VolumeTest decorator attributing the time spent in volume tests
+ * to the PROFILE_ZONE_CULL zone, the tests are sampled. Only used if
+ * profiling is enabled, otherwise the views pass their volume directly.
+ */
+class ProfiledVolumeTest :
+	public VolumeTest
+{
+	const VolumeTest& _volume;
+
+public:
+	ProfiledVolumeTest(const VolumeTest& volume) :
+		_volume(volume)
+	{}
+
+	bool TestPoint(const Vector3& point) const;
+	bool TestLine(const Segment& segment) const;
+	bool TestPlane(const Plane3& plane) const;
+	bool TestPlane(const Plane3& plane, const Matrix4& localToWorld) const;
+	VolumeIntersectionValue TestAABB(const AABB& aabb) const;
+	VolumeIntersectionValue TestAABB(const AABB& aabb, const Matrix4& localToWorld) const;
+
+	bool fill() const;
+	const Matrix4& GetViewport() const;
+	const Matrix4& GetProjection() const;
+	const Matrix4& GetModelview() const;
+};
+
+} // namespace
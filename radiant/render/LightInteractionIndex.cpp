@@ -0,0 +1,418 @@
+#include "LightInteractionIndex.h"
+
+#include "LinearLightList.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace render
+{
+
+namespace
+{
+	// Edge length of a grid cell in world units
+	const double CELL_SIZE = 512.0;
+
+	// Items covering more cells than this are kept in the oversized lists
+	const std::size_t MAX_CELLS_PER_ITEM = 512;
+
+	// Removes the first occurrence of the given element, not preserving the order
+	template<typename Container, typename Element>
+	inline void swapRemove(Container& container, const Element& element)
+	{
+		typename Container::iterator i = std::find(container.begin(), container.end(), element);
+
+		if (i != container.end())
+		{
+			*i = container.back();
+			container.pop_back();
+		}
+	}
+
+	inline int getCellCoord(double value)
+	{
+		return static_cast<int>(std::floor(value / CELL_SIZE));
+	}
+}
+
+LightInteractionIndex::LightInteractionIndex() :
+	_stamp(0)
+{}
+
+void LightInteractionIndex::addLight(RendererLight& light)
+{
+	// The light is sorted into the cells during the next update
+	_lights.insert(LightEntries::value_type(&light, LightEntry()));
+
+	lightChanged(light);
+}
+
+void LightInteractionIndex::removeLight(RendererLight& light)
+{
+	LightEntries::iterator found = _lights.find(&light);
+
+	if (found == _lights.end()) return;
+
+	LightEntry& entry = found->second;
+
+	// All objects touched by this light lose it
+	for (LightEntry::Interactions::const_iterator i = entry.interactions.begin(); i != entry.interactions.end(); ++i)
+	{
+		(*i)->setDirtyInternal();
+	}
+
+	removeLightFromCells(&light, entry.cells);
+
+	if (entry.changed)
+	{
+		swapRemove(_changedLights, &light);
+	}
+
+	_lights.erase(found);
+}
+
+void LightInteractionIndex::lightChanged(RendererLight& light)
+{
+	LightEntries::iterator found = _lights.find(&light);
+
+	if (found == _lights.end() || found->second.changed) return;
+
+	found->second.changed = true;
+	_changedLights.push_back(&light);
+}
+
+void LightInteractionIndex::removeObject(const LinearLightList& list)
+{
+	removeObjectFromCells(&list, list._cells);
+	list._cells = CellRange();
+
+	for (Lights::const_iterator i = list._activeLights.begin(); i != list._activeLights.end(); ++i)
+	{
+		LightEntries::iterator found = _lights.find(*i);
+
+		if (found != _lights.end())
+		{
+			found->second.interactions.erase(&list);
+		}
+	}
+
+	list._activeLights.clear();
+}
+
+void LightInteractionIndex::update()
+{
+	if (_changedLights.empty()) return;
+
+	for (Lights::const_iterator i = _changedLights.begin(); i != _changedLights.end(); ++i)
+	{
+		LightEntries::iterator found = _lights.find(*i);
+
+		if (found != _lights.end())
+		{
+			found->second.changed = false;
+			processChangedLight(*i, found->second);
+		}
+	}
+
+	_changedLights.clear();
+}
+
+void LightInteractionIndex::processChangedLight(RendererLight* light, LightEntry& entry)
+{
+	++_stamp;
+
+	// Check the objects which have been lit by this light so far
+	for (LightEntry::Interactions::const_iterator i = entry.interactions.begin(); i != entry.interactions.end(); ++i)
+	{
+		const LinearLightList& list = **i;
+		list._stamp = _stamp;
+
+		if (list.isDirty()) continue; // will be recalculated anyway
+
+		if (list.getLitObject().intersectsLight(*light))
+		{
+			// Still lit, but the object might need to refine its own lists
+			list.setLightsMoved();
+		}
+		else
+		{
+			list.setDirtyInternal();
+		}
+	}
+
+	// Move the light to its new cells
+	removeLightFromCells(light, entry.cells);
+	entry.cells = getCellRange(light->lightAABB());
+	insertLightIntoCells(light, entry.cells);
+
+	// Any other object sharing a cell with the light might gain it
+	LightLists candidates;
+
+	if (entry.cells.oversized)
+	{
+		// Check all registered objects
+		for (CellMap::const_iterator c = _cells.begin(); c != _cells.end(); ++c)
+		{
+			candidates.insert(candidates.end(), c->second.objects.begin(), c->second.objects.end());
+		}
+	}
+	else if (entry.cells.valid)
+	{
+		for (int x = entry.cells.min.x; x <= entry.cells.max.x; ++x)
+		{
+			for (int y = entry.cells.min.y; y <= entry.cells.max.y; ++y)
+			{
+				for (int z = entry.cells.min.z; z <= entry.cells.max.z; ++z)
+				{
+					CellKey key = { x, y, z };
+					CellMap::const_iterator c = _cells.find(key);
+
+					if (c != _cells.end())
+					{
+						candidates.insert(candidates.end(), c->second.objects.begin(), c->second.objects.end());
+					}
+				}
+			}
+		}
+	}
+
+	candidates.insert(candidates.end(), _oversizedObjects.begin(), _oversizedObjects.end());
+
+	for (LightLists::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
+	{
+		const LinearLightList& list = **i;
+
+		if (list._stamp == _stamp) continue; // already checked
+
+		list._stamp = _stamp;
+
+		if (!list.isDirty() && list.getLitObject().intersectsLight(*light))
+		{
+			list.setDirtyInternal();
+		}
+	}
+}
+
+void LightInteractionIndex::findInteractions(const LinearLightList& list, const AABB& bounds, Lights& result)
+{
+	// Leave the interaction lists of the previous lights
+	for (Lights::const_iterator i = result.begin(); i != result.end(); ++i)
+	{
+		LightEntries::iterator found = _lights.find(*i);
+
+		if (found != _lights.end())
+		{
+			found->second.interactions.erase(&list);
+		}
+	}
+
+	result.clear();
+
+	// Re-register the object using its current bounds
+	removeObjectFromCells(&list, list._cells);
+	list._cells = getCellRange(bounds);
+	insertObjectIntoCells(&list, list._cells);
+
+	++_stamp;
+
+	Lights candidates(_oversizedLights);
+
+	if (list._cells.oversized)
+	{
+		// Test everything
+		for (LightEntries::const_iterator i = _lights.begin(); i != _lights.end(); ++i)
+		{
+			candidates.push_back(i->first);
+		}
+	}
+	else if (list._cells.valid)
+	{
+		for (int x = list._cells.min.x; x <= list._cells.max.x; ++x)
+		{
+			for (int y = list._cells.min.y; y <= list._cells.max.y; ++y)
+			{
+				for (int z = list._cells.min.z; z <= list._cells.max.z; ++z)
+				{
+					CellKey key = { x, y, z };
+					CellMap::const_iterator c = _cells.find(key);
+
+					if (c != _cells.end())
+					{
+						candidates.insert(candidates.end(), c->second.lights.begin(), c->second.lights.end());
+					}
+				}
+			}
+		}
+	}
+
+	for (Lights::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
+	{
+		LightEntries::iterator found = _lights.find(*i);
+
+		if (found == _lights.end()) continue;
+
+		LightEntry& entry = found->second;
+
+		if (entry.stamp == _stamp) continue; // already tested
+
+		entry.stamp = _stamp;
+
+		if (list.getLitObject().intersectsLight(**i))
+		{
+			result.push_back(*i);
+			entry.interactions.insert(&list);
+		}
+	}
+}
+
+LightInteractionIndex::CellRange LightInteractionIndex::getCellRange(const AABB& bounds) const
+{
+	CellRange range;
+
+	if (!bounds.isValid())
+	{
+		return range;
+	}
+
+	Vector3 min = bounds.origin - bounds.extents;
+	Vector3 max = bounds.origin + bounds.extents;
+
+	// Guard against overflowing the integer coordinates
+	double limit = CELL_SIZE * (1 << 20);
+
+	if (std::fabs(min.x()) > limit || std::fabs(min.y()) > limit || std::fabs(min.z()) > limit ||
+		std::fabs(max.x()) > limit || std::fabs(max.y()) > limit || std::fabs(max.z()) > limit)
+	{
+		range.valid = true;
+		range.oversized = true;
+		return range;
+	}
+
+	range.min.x = getCellCoord(min.x());
+	range.min.y = getCellCoord(min.y());
+	range.min.z = getCellCoord(min.z());
+	range.max.x = getCellCoord(max.x());
+	range.max.y = getCellCoord(max.y());
+	range.max.z = getCellCoord(max.z());
+	range.valid = true;
+
+	std::size_t numCells = static_cast<std::size_t>(range.max.x - range.min.x + 1) *
+						   static_cast<std::size_t>(range.max.y - range.min.y + 1) *
+						   static_cast<std::size_t>(range.max.z - range.min.z + 1);
+
+	range.oversized = numCells > MAX_CELLS_PER_ITEM;
+
+	return range;
+}
+
+void LightInteractionIndex::insertLightIntoCells(RendererLight* light, const CellRange& range)
+{
+	if (!range.valid) return;
+
+	if (range.oversized)
+	{
+		_oversizedLights.push_back(light);
+		return;
+	}
+
+	for (int x = range.min.x; x <= range.max.x; ++x)
+	{
+		for (int y = range.min.y; y <= range.max.y; ++y)
+		{
+			for (int z = range.min.z; z <= range.max.z; ++z)
+			{
+				CellKey key = { x, y, z };
+				_cells[key].lights.push_back(light);
+			}
+		}
+	}
+}
+
+void LightInteractionIndex::removeLightFromCells(RendererLight* light, const CellRange& range)
+{
+	if (!range.valid) return;
+
+	if (range.oversized)
+	{
+		swapRemove(_oversizedLights, light);
+		return;
+	}
+
+	for (int x = range.min.x; x <= range.max.x; ++x)
+	{
+		for (int y = range.min.y; y <= range.max.y; ++y)
+		{
+			for (int z = range.min.z; z <= range.max.z; ++z)
+			{
+				CellKey key = { x, y, z };
+				CellMap::iterator c = _cells.find(key);
+
+				if (c == _cells.end()) continue;
+
+				swapRemove(c->second.lights, light);
+
+				if (c->second.lights.empty() && c->second.objects.empty())
+				{
+					_cells.erase(c);
+				}
+			}
+		}
+	}
+}
+
+void LightInteractionIndex::insertObjectIntoCells(const LinearLightList* list, const CellRange& range)
+{
+	if (!range.valid) return;
+
+	if (range.oversized)
+	{
+		_oversizedObjects.push_back(list);
+		return;
+	}
+
+	for (int x = range.min.x; x <= range.max.x; ++x)
+	{
+		for (int y = range.min.y; y <= range.max.y; ++y)
+		{
+			for (int z = range.min.z; z <= range.max.z; ++z)
+			{
+				CellKey key = { x, y, z };
+				_cells[key].objects.push_back(list);
+			}
+		}
+	}
+}
+
+void LightInteractionIndex::removeObjectFromCells(const LinearLightList* list, const CellRange& range)
+{
+	if (!range.valid) return;
+
+	if (range.oversized)
+	{
+		swapRemove(_oversizedObjects, list);
+		return;
+	}
+
+	for (int x = range.min.x; x <= range.max.x; ++x)
+	{
+		for (int y = range.min.y; y <= range.max.y; ++y)
+		{
+			for (int z = range.min.z; z <= range.max.z; ++z)
+			{
+				CellKey key = { x, y, z };
+				CellMap::iterator c = _cells.find(key);
+
+				if (c == _cells.end()) continue;
+
+				swapRemove(c->second.objects, list);
+
+				if (c->second.lights.empty() && c->second.objects.empty())
+				{
+					_cells.erase(c);
+				}
+			}
+		}
+	}
+}
+
+} // namespace render
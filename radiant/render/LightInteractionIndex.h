@@ -0,0 +1,157 @@
+#pragma once
+
+#include "irender.h"
+#include "math/AABB.h"
+
+#include <map>
+#include <vector>
+#include <boost/unordered_set.hpp>
+
+namespace render
+{
+
+class LinearLightList;
+
+/**
+ * \brief
+ * Spatial index of the interactions between lights and lit objects.
+ *
+ * Lights and lit objects are registered in a sparse uniform grid, using the
+ * world bounds of the light volume and the object respectively. An object only
+ * needs to test the lights sharing at least one cell with it, and a changed
+ * light only needs to look at the objects it touched before plus the ones
+ * sharing cells with its new volume. Objects whose set of lights is not
+ * affected by a light change are not flagged for recalculation.
+ *
+ * Light changes are queued and processed in one go by update(), which is
+ * invoked by the LinearLightLists before they hand out their lights.
+ */
+class LightInteractionIndex
+{
+public:
+	typedef std::vector<RendererLight*> Lights;
+	typedef std::vector<const LinearLightList*> LightLists;
+
+	// Integer coordinates of a grid cell
+	struct CellKey
+	{
+		int x;
+		int y;
+		int z;
+
+		bool operator<(const CellKey& other) const
+		{
+			if (x != other.x) return x < other.x;
+			if (y != other.y) return y < other.y;
+			return z < other.z;
+		}
+	};
+
+	// The block of cells covered by a light or an object
+	struct CellRange
+	{
+		CellKey min;
+		CellKey max;
+
+		// false if the range is empty (not registered in any cell)
+		bool valid;
+
+		// true if the range was too large, the item is kept in the oversized list
+		bool oversized;
+
+		CellRange() :
+			valid(false),
+			oversized(false)
+		{}
+	};
+
+private:
+	struct Cell
+	{
+		Lights lights;
+		LightLists objects;
+	};
+	typedef std::map<CellKey, Cell> CellMap;
+	CellMap _cells;
+
+	struct LightEntry
+	{
+		CellRange cells;
+
+		// Stamp to avoid testing the same light twice during a query
+		std::size_t stamp;
+
+		// True if this light is queued in _changedLights
+		bool changed;
+
+		// The objects currently having this light in their interaction set,
+		// a set since objects leave it one by one
+		typedef boost::unordered_set<const LinearLightList*> Interactions;
+		Interactions interactions;
+
+		LightEntry() :
+			stamp(0),
+			changed(false)
+		{}
+	};
+	typedef std::map<RendererLight*, LightEntry> LightEntries;
+	LightEntries _lights;
+
+	// Lights and objects which are too large to be sorted into cells
+	Lights _oversizedLights;
+	LightLists _oversizedObjects;
+
+	// Lights changed since the last update()
+	Lights _changedLights;
+
+	std::size_t _stamp;
+
+public:
+	LightInteractionIndex();
+
+	// Light registration, the index is updated lazily on the next update() call
+	void addLight(RendererLight& light);
+	void removeLight(RendererLight& light);
+	void lightChanged(RendererLight& light);
+
+	// Unregisters the given object from all cells and lights
+	void removeObject(const LinearLightList& list);
+
+	/**
+	 * Processes all queued light changes. Objects gaining or losing a light are
+	 * flagged for a full recalculation, objects still touched by a changed light
+	 * only need to re-insert their existing lights.
+	 */
+	void update();
+
+	/**
+	 * Determine the lights intersecting the object of the given light list,
+	 * placed at the given world bounds. The result is written to the given
+	 * vector, the object's registration in the index is updated.
+	 */
+	void findInteractions(const LinearLightList& list, const AABB& bounds, Lights& result);
+
+	bool containsLight(RendererLight& light) const
+	{
+		return _lights.find(&light) != _lights.end();
+	}
+
+	// Returns the number of registered lights
+	std::size_t getNumLights() const
+	{
+		return _lights.size();
+	}
+
+private:
+	CellRange getCellRange(const AABB& bounds) const;
+
+	void insertLightIntoCells(RendererLight* light, const CellRange& range);
+	void removeLightFromCells(RendererLight* light, const CellRange& range);
+
+	void insertObjectIntoCells(const LinearLightList* list, const CellRange& range);
+	void removeObjectFromCells(const LinearLightList* list, const CellRange& range);
+
+	void processChangedLight(RendererLight* light, LightEntry& entry);
+};
+
+} // namespace render
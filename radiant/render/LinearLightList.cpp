@@ -7,24 +7,34 @@ namespace render
 
 void LinearLightList::calculateIntersectingLights() const
 {
-    // Get the renderer to tell us whether anything actually needs updating
-    _testDirtyFunc();
+    // Let the index process pending light changes, this might flag us
+    _index.update();
 
     if (m_dirty)
     {
         m_dirty = false;
+        _lightsMoved = false;
 
-        _activeLights.clear();
         _litObject.clearLights();
 
         // Determine which lights intersect object
-        BOOST_FOREACH(RendererLight* light, _allLights)
+        _index.findInteractions(*this, _litObject.getLitObjectAABB(), _activeLights);
+
+        BOOST_FOREACH(RendererLight* light, _activeLights)
+        {
+            _litObject.insertLight(*light);
+        }
+    }
+    else if (_lightsMoved)
+    {
+        _lightsMoved = false;
+
+        // Same set of lights, but the object might need to refine its own lists
+        _litObject.clearLights();
+
+        BOOST_FOREACH(RendererLight* light, _activeLights)
         {
-            if (_litObject.intersectsLight(*light))
-            {
-                _activeLights.push_back(light);
-                _litObject.insertLight(*light);
-            }
+            _litObject.insertLight(*light);
         }
     }
 }
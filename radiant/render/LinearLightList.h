@@ -1,45 +1,48 @@
 #pragma once
 
 #include "irender.h"
-#include <list>
-#include <boost/function/function_fwd.hpp>
+#include "LightInteractionIndex.h"
 
 namespace render
 {
 
-typedef std::set<RendererLight*> RendererLights;
-
 /**
  * \brief
  * Main renderer implementation of LightList interface.
  *
  * The LinearLightList is reponsible for associating a single lit object with
- * all of the lights which currently light it.
+ * all of the lights which currently light it. The candidate lights are
+ * looked up in the LightInteractionIndex, which also takes care of flagging
+ * this list when a light change affects the object.
  */
 class LinearLightList :
 	public LightList
 {
-public:
-	typedef boost::function<void()> VoidCallback;
-
 private:
+	friend class LightInteractionIndex;
 
     // Target object
 	LitObject& _litObject;
 
-    // Set of all available lights
-	RendererLights& _allLights;
-
-    // Update callback
-	VoidCallback _testDirtyFunc;
+    // The index of all lights in the scene
+	LightInteractionIndex& _index;
 
-    // List of lights which are intersecting our lit object
-	typedef std::list<RendererLight*> Lights;
-	mutable Lights _activeLights;
+    // Lights which are intersecting our lit object
+	mutable LightInteractionIndex::Lights _activeLights;
 
     // Dirty flag indicating recalculation needed
 	mutable bool m_dirty;
 
+	// Set if a light changed without entering or leaving our object, the
+	// existing lights need to be re-inserted into the lit object
+	mutable bool _lightsMoved;
+
+	// The cells of the index this object is registered in
+	mutable LightInteractionIndex::CellRange _cells;
+
+	// Stamp to avoid testing the same object twice during an index update
+	mutable std::size_t _stamp;
+
 public:
 
     /**
@@ -49,25 +52,43 @@ public:
      * \param object
      * The illuminatable object whose lit status we are tracking.
      *
-     * \param lights
-     * Entire set of available light sources provided by the renderer.
-     *
-     * \param testFunc
-     * A callback function to request the renderer check if the light list
-     * needs to recalculate its intersections, and call setDirty() if necessary.
+     * \param index
+     * The index of all light sources provided by the renderer.
      */
-    LinearLightList(LitObject& object,
-                    RendererLights& lights,
-                    VoidCallback testFunc)
-    : _litObject(object), _allLights(lights), _testDirtyFunc(testFunc)
-	{
-		m_dirty = true;
-	}
+    LinearLightList(LitObject& object, LightInteractionIndex& index) :
+		_litObject(object),
+		_index(index),
+		m_dirty(true),
+		_lightsMoved(false),
+		_stamp(0)
+	{}
 
     // LightList implementation
 	void calculateIntersectingLights() const;
 	void forEachLight(const RendererLightCallback& callback) const;
 	void setDirty();
+
+	bool isDirty() const
+	{
+		return m_dirty;
+	}
+
+	const LitObject& getLitObject() const
+	{
+		return _litObject;
+	}
+
+private:
+	// Called by the index if a light change doesn't affect the interaction set
+	void setLightsMoved() const
+	{
+		_lightsMoved = true;
+	}
+
+	void setDirtyInternal() const
+	{
+		m_dirty = true;
+	}
 };
 
 } // namespace render
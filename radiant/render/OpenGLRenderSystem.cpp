@@ -41,7 +41,6 @@ OpenGLRenderSystem::OpenGLRenderSystem() :
 	_currentShaderProgram(SHADER_PROGRAM_NONE),
 	_shadersAvailable(false),
 	_time(0),
-	m_lightsChanged(true),
 	m_traverseRenderablesMutex(false)
 {
 	// For the static default rendersystem, the MaterialManager is not existent yet,
@@ -96,6 +95,10 @@ void OpenGLRenderSystem::render(RenderStateFlags globalstate,
                                const Matrix4& projection,
                                const Vector3& viewer)
 {
+	// Upload the textures which finished loading in the background,
+	// before we start setting up the GL state
+	GlobalMaterialManager().uploadStreamedTextures();
+
 	// Set the projection and modelview matrices
 	glMatrixMode(GL_PROJECTION);
 	glLoadMatrixd(projection);
@@ -186,8 +189,18 @@ void OpenGLRenderSystem::render(RenderStateFlags globalstate,
         if (!i->second->empty())
         {
             i->second->render(current, globalstate, viewer, _time);
+
+            const OpenGLState& passState = i->second->state();
+
+            if (passState.texture0 != 0) _visibleTextures.push_back(passState.texture0);
+            if (passState.texture1 != 0) _visibleTextures.push_back(passState.texture1);
+            if (passState.texture2 != 0) _visibleTextures.push_back(passState.texture2);
         }
 	}
+
+    // Let the texture manager know which textures are in use
+    GlobalMaterialManager().markTexturesVisible(_visibleTextures);
+    _visibleTextures.clear();
 }
 
 void OpenGLRenderSystem::realise()
@@ -355,21 +368,20 @@ LightList& OpenGLRenderSystem::attachLitObject(LitObject& object)
 	return m_lightLists.insert(
 		LightLists::value_type(
 			&object,
-			LinearLightList(
-                object,
-                m_lights,
-                boost::bind(
-                    &OpenGLRenderSystem::propagateLightChangedFlagToAllLights,
-                    this
-                )
-            )
+			LinearLightList(object, _lightIndex)
         )
     ).first->second;
 }
 
 void OpenGLRenderSystem::detachLitObject(LitObject& object) 
 {
-	m_lightLists.erase(&object);
+	LightLists::iterator i = m_lightLists.find(&object);
+
+	if (i != m_lightLists.end())
+	{
+		_lightIndex.removeObject(i->second);
+		m_lightLists.erase(i);
+	}
 }
 
 void OpenGLRenderSystem::litObjectChanged(LitObject& object) 
@@ -382,35 +394,19 @@ void OpenGLRenderSystem::litObjectChanged(LitObject& object)
 
 void OpenGLRenderSystem::attachLight(RendererLight& light)
 {
-    ASSERT_MESSAGE(m_lights.find(&light) == m_lights.end(), "light could not be attached");
-    m_lights.insert(&light);
-    lightChanged(light);
+    ASSERT_MESSAGE(!_lightIndex.containsLight(light), "light could not be attached");
+    _lightIndex.addLight(light);
 }
 
 void OpenGLRenderSystem::detachLight(RendererLight& light)
 {
-    ASSERT_MESSAGE(m_lights.find(&light) != m_lights.end(), "light could not be detached");
-    m_lights.erase(&light);
-    lightChanged(light);
+    ASSERT_MESSAGE(_lightIndex.containsLight(light), "light could not be detached");
+    _lightIndex.removeLight(light);
 }
 
 void OpenGLRenderSystem::lightChanged(RendererLight& light)
 {
-    m_lightsChanged = true;
-}
-
-void OpenGLRenderSystem::propagateLightChangedFlagToAllLights()
-{
-    if (m_lightsChanged)
-    {
-    	m_lightsChanged = false;
-    	for (LightLists::iterator i = m_lightLists.begin();
-             i != m_lightLists.end();
-             ++i) 
-        {
-    		i->second.setDirty();
-    	}
-	}
+    _lightIndex.lightChanged(light);
 }
 
 void OpenGLRenderSystem::insertSortedState(const OpenGLStates::value_type& val) {
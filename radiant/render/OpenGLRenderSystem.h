@@ -2,6 +2,7 @@
 
 #include "irender.h"
 #include <map>
+#include <vector>
 #include "imodule.h"
 #include "backend/OpenGLStateManager.h"
 #include "backend/OpenGLShader.h"
@@ -42,15 +43,14 @@ private:
 	// Render time
 	std::size_t _time;
 
+	// The textures used by the passes rendered in the current frame
+	std::vector<GLuint> _visibleTextures;
+
 	// Lights
-	RendererLights m_lights;
-	bool m_lightsChanged;
+	LightInteractionIndex _lightIndex;
 	typedef std::map<LitObject*, LinearLightList> LightLists;
 	LightLists m_lightLists;
 
-private:
-	void propagateLightChangedFlagToAllLights();
-
 public:
 
 	/**
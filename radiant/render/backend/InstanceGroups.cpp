@@ -0,0 +1,60 @@
+#include "InstanceGroups.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace render
+{
+
+namespace
+{
+	// Orders by renderable, then by submission order
+	inline bool compareInstances(const InstanceGroups::Instance& a, const InstanceGroups::Instance& b)
+	{
+		if (a.renderable != b.renderable)
+		{
+			return std::less<const OpenGLRenderable*>()(a.renderable, b.renderable);
+		}
+
+		return a.index < b.index;
+	}
+}
+
+void InstanceGroups::add(const OpenGLRenderable& renderable, const Matrix4& transform, const RendererLight* light)
+{
+	Instance instance = { &renderable, &transform, light, _instances.size() };
+
+	if (_grouped && !_instances.empty() &&
+		std::less<const OpenGLRenderable*>()(&renderable, _instances.back().renderable))
+	{
+		_grouped = false;
+	}
+
+	_instances.push_back(instance);
+}
+
+void InstanceGroups::group()
+{
+	if (_grouped) return;
+
+	std::sort(_instances.begin(), _instances.end(), compareInstances);
+
+	_grouped = true;
+}
+
+std::size_t InstanceGroups::getNumGroups() const
+{
+	std::size_t numGroups = 0;
+
+	for (std::size_t i = 0; i < _instances.size(); ++i)
+	{
+		if (i == 0 || _instances[i].renderable != _instances[i - 1].renderable)
+		{
+			++numGroups;
+		}
+	}
+
+	return numGroups;
+}
+
+} // namespace render
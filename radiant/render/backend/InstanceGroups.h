@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/* FORWARD DECLS */
+class Matrix4;
+class OpenGLRenderable;
+class RendererLight;
+
+namespace render
+{
+
+/**
+ * The renderables submitted to a shader pass, grouped by their
+ * OpenGLRenderable. Models share their surfaces through the model cache, so
+ * all instances of the same model surface end up in one group and are drawn
+ * one after the other, with only the transform (and the light) changing in
+ * between. Within a group the instances keep their submission order.
+ *
+ * This doesn't call OpenGL, the grouping can be tested and benchmarked
+ * without a GL context.
+ */
+class InstanceGroups
+{
+public:
+	// A single renderable with its transform and the light falling on it
+	struct Instance
+	{
+		const OpenGLRenderable* renderable;
+		const Matrix4* transform;
+		const RendererLight* light;
+
+		// The submission order
+		std::size_t index;
+	};
+	typedef std::vector<Instance> Instances;
+	typedef Instances::const_iterator const_iterator;
+	typedef const_iterator iterator; // instances are read-only
+
+private:
+	Instances _instances;
+
+	// True while the submitted renderables are in group order already
+	bool _grouped;
+
+public:
+	InstanceGroups() :
+		_grouped(true)
+	{}
+
+	void add(const OpenGLRenderable& renderable, const Matrix4& transform, const RendererLight* light);
+
+	// Sorts the instances into groups, does nothing if they are grouped already
+	void group();
+
+	// Returns the number of distinct renderables, the instances need to be grouped
+	std::size_t getNumGroups() const;
+
+	bool empty() const
+	{
+		return _instances.empty();
+	}
+
+	std::size_t size() const
+	{
+		return _instances.size();
+	}
+
+	const_iterator begin() const
+	{
+		return _instances.begin();
+	}
+
+	const_iterator end() const
+	{
+		return _instances.end();
+	}
+
+	// Removes all instances, the memory is kept for the next frame
+	void clear()
+	{
+		_instances.clear();
+		_grouped = true;
+	}
+};
+
+} // namespace render
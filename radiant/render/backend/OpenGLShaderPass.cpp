@@ -11,6 +11,7 @@
 #include <boost/foreach.hpp>
 
 #include "debugging/render.h"
+#include "render/FrameProfiler.h"
 
 namespace render
 {
@@ -573,7 +574,7 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
                                       const Matrix4& modelview,
                                       const RendererLight* light)
 {
-    _renderablesWithoutEntity.push_back(TransformedRenderable(renderable, modelview, light, NULL));
+    _renderablesWithoutEntity.add(renderable, modelview, light);
 }
 
 void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
@@ -581,6 +582,12 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
                                       const IRenderEntity& entity,
                                       const RendererLight* light)
 {
+    if (!stagesDependOnEntity())
+    {
+        _renderablesOfAnyEntity.add(renderable, modelview, light);
+        return;
+    }
+
     RenderablesByEntity::iterator i = _renderables.find(&entity);
 
     if (i == _renderables.end())
@@ -588,7 +595,7 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
         i = _renderables.insert(RenderablesByEntity::value_type(&entity, Renderables())).first;
     }
 
-    i->second.push_back(TransformedRenderable(renderable, modelview, light, &entity));
+    i->second.add(renderable, modelview, light);
 }
 
 // Render the bucket contents
@@ -603,30 +610,53 @@ void OpenGLShaderPass::render(OpenGLState& current,
 
     glMatrixMode(GL_MODELVIEW);
 
+    FrameProfiler& profiler = FrameProfiler::Instance();
+
     // Apply our state to the current state object
-    applyState(current, flagsMask, viewer, time, NULL);
+    {
+        ScopedProfileZone zone(PROFILE_ZONE_STATE);
+        profiler.addCount(PROFILE_ZONE_STATE);
+        applyState(current, flagsMask, viewer, time, NULL);
+    }
 
     if (!_renderablesWithoutEntity.empty())
     {
+        ScopedProfileZone zone(PROFILE_ZONE_DRAW);
+        profiler.addCount(PROFILE_ZONE_DRAW, _renderablesWithoutEntity.size());
         renderAllContained(_renderablesWithoutEntity, current, viewer, time);
     }
 
-    for (RenderablesByEntity::const_iterator i = _renderables.begin();
+    // The state evaluated above is valid for these as well
+    if (!_renderablesOfAnyEntity.empty() && stateIsActive())
+    {
+        ScopedProfileZone zone(PROFILE_ZONE_DRAW);
+        profiler.addCount(PROFILE_ZONE_DRAW, _renderablesOfAnyEntity.size());
+        renderAllContained(_renderablesOfAnyEntity, current, viewer, time);
+    }
+
+    for (RenderablesByEntity::iterator i = _renderables.begin();
          i != _renderables.end();
          ++i)
     {
         // Apply our state to the current state object
-        applyState(current, flagsMask, viewer, time, i->first);
+        {
+            ScopedProfileZone zone(PROFILE_ZONE_STATE);
+            profiler.addCount(PROFILE_ZONE_STATE);
+            applyState(current, flagsMask, viewer, time, i->first);
+        }
 
         if (!stateIsActive())
         {
             continue;
         }
 
+        ScopedProfileZone zone(PROFILE_ZONE_DRAW);
+        profiler.addCount(PROFILE_ZONE_DRAW, i->second.size());
         renderAllContained(i->second, current, viewer, time);
     }
 
     _renderablesWithoutEntity.clear();
+    _renderablesOfAnyEntity.clear();
     _renderables.clear();
 }
 
@@ -638,6 +668,15 @@ bool OpenGLShaderPass::stateIsActive()
             (_glState.stage3 == NULL || _glState.stage3->isVisible()));
 }
 
+bool OpenGLShaderPass::stagesDependOnEntity() const
+{
+    return (_glState.stage0 && _glState.stage0->dependsOnEntity()) ||
+           (_glState.stage1 && _glState.stage1->dependsOnEntity()) ||
+           (_glState.stage2 && _glState.stage2->dependsOnEntity()) ||
+           (_glState.stage3 && _glState.stage3->dependsOnEntity()) ||
+           (_glState.stage4 && _glState.stage4->dependsOnEntity());
+}
+
 // Setup lighting
 void OpenGLShaderPass::setUpLightingCalculation(OpenGLState& current,
                                                 const RendererLight* light,
@@ -693,18 +732,27 @@ void OpenGLShaderPass::setUpLightingCalculation(OpenGLState& current,
 }
 
 // Flush renderables
-void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
+void OpenGLShaderPass::renderAllContained(Renderables& renderables,
                                           OpenGLState& current,
                                           const Vector3& viewer,
                                           std::size_t time)
 {
+    {
+        // Draw the instances of each surface one after the other
+        ScopedProfileZone zone(PROFILE_ZONE_SORT);
+        renderables.group();
+    }
+
     // Keep a pointer to the last transform matrix and render entity used
     const Matrix4* transform = 0;
 
+    // The face direction set for the last transform
+    GLenum frontFace = 0;
+
     glPushMatrix();
 
     // Iterate over each transformed renderable in the vector
-    BOOST_FOREACH (const TransformedRenderable& r, renderables)
+    BOOST_FOREACH (const InstanceGroups::Instance& r, renderables)
     {
         // If the current iteration's transform matrix was different from the
         // last, apply it and store for the next iteration
@@ -717,14 +765,13 @@ void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
             glMultMatrixd(*transform);
 
             // Determine the face direction
-            if (current.testRenderFlag(RENDER_CULLFACE)
-                && transform->getHandedness() == Matrix4::RIGHTHANDED)
-            {
-                glFrontFace(GL_CW);
-            }
-            else
+            GLenum requiredFrontFace = current.testRenderFlag(RENDER_CULLFACE)
+                && transform->getHandedness() == Matrix4::RIGHTHANDED ? GL_CW : GL_CCW;
+
+            if (requiredFrontFace != frontFace)
             {
-                glFrontFace(GL_CCW);
+                glFrontFace(requiredFrontFace);
+                frontFace = requiredFrontFace;
             }
         }
 
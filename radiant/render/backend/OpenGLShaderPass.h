@@ -2,6 +2,7 @@
 
 #include "math/Vector3.h"
 #include "iglrender.h"
+#include "InstanceGroups.h"
 
 #include <vector>
 #include <map>
@@ -30,39 +31,14 @@ class OpenGLShaderPass
 	// The state applied to this bucket
 	OpenGLState _glState;
 
-	/*
-	 * Representation of a transformed-and-lit renderable object. Stores a
-	 * single object, with its transform matrix and illuminating light source.
-	 */
-	struct TransformedRenderable
-	{
-    	// The renderable object
-    	const OpenGLRenderable* renderable;
-
-    	// The modelview transform for this renderable
-    	const Matrix4* transform;
-
-		// The light falling on this obejct
-    	const RendererLight* light;
-
-		// The entity attached to this renderable
-		const IRenderEntity* entity;
-
-		// Constructor
-		TransformedRenderable(const OpenGLRenderable& r,
-							  const Matrix4& t,
-							  const RendererLight* l,
-							  const IRenderEntity* e)
-		: renderable(&r),
-		  transform(&t),
-		  light(l),
-		  entity(e)
-		{}
-	};
-
-	// Vector of transformed renderables using this state
-	typedef std::vector<TransformedRenderable> Renderables;
+	// Transformed renderables using this state, grouped by renderable
+	typedef InstanceGroups Renderables;
 	Renderables _renderablesWithoutEntity;
+
+	// Renderables attached to an entity, as long as none of the stages reads
+	// entity shaderparms. The stages evaluate the same for all entities then,
+	// so these share one state evaluation and are grouped across entities.
+	Renderables _renderablesOfAnyEntity;
 	
 	// Renderables sorted by RenderEntity
 	typedef std::map<const IRenderEntity*, Renderables> RenderablesByEntity;
@@ -83,10 +59,13 @@ private:
 	// Returns true if the stage associated to this pass is active and should be rendered
 	bool stateIsActive();
 
+	// Returns true if any of the stages reads entity shaderparms
+	bool stagesDependOnEntity() const;
+
 	void setupTextureMatrix(GLenum textureUnit, const ShaderLayerPtr& stage);
 
-	// Render all of the given TransformedRenderables
-	void renderAllContained(const Renderables& renderables,
+	// Render all of the given renderables, one group after the other
+	void renderAllContained(Renderables& renderables,
 							OpenGLState& current,
 						    const Vector3& viewer,
 							std::size_t time);
@@ -179,7 +158,8 @@ public:
 	 */
 	bool empty() const
 	{
-		return _renderables.empty() && _renderablesWithoutEntity.empty();
+		return _renderables.empty() && _renderablesWithoutEntity.empty() &&
+			   _renderablesOfAnyEntity.empty();
 	}
 
 	friend std::ostream& operator<<(std::ostream& st, const OpenGLShaderPass& self);
@@ -4,6 +4,7 @@
 #include "ientity.h"
 #include "ieclass.h"
 #include "iscenegraph.h"
+#include "render/FrameProfiler.h"
 #include <boost/bind.hpp>
 
 namespace render
@@ -92,6 +93,23 @@ public:
 	 * graph and submit all visible objects to the provided RenderableCollector.
 	 */
 	static void collectRenderablesInScene(RenderableCollector& collector, const VolumeTest& volume)
+	{
+		ScopedProfileZone zone(PROFILE_ZONE_COLLECT);
+
+		if (FrameProfiler::Instance().isEnabled())
+		{
+			// Route all volume tests through the profiler to measure the culling time
+			ProfiledVolumeTest profiledVolume(volume);
+			collectRenderables(collector, profiledVolume);
+		}
+		else
+		{
+			collectRenderables(collector, volume);
+		}
+	}
+
+private:
+	static void collectRenderables(RenderableCollector& collector, const VolumeTest& volume)
 	{
 		// Instantiate a new walker class
 		RenderHighlighted renderHighlightWalker(collector, volume);
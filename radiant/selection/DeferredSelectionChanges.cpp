@@ -0,0 +1,55 @@
+#include "DeferredSelectionChanges.h"
+
+namespace selection
+{
+
+DeferredSelectionChanges::DeferredSelectionChanges(const SignalFunc& emitSignal,
+												   const ObserverFunc& notifyObservers) :
+	_emitSignal(emitSignal),
+	_notifyObservers(notifyObservers)
+{}
+
+void DeferredSelectionChanges::add(const scene::INodePtr& node, bool isComponent)
+{
+	Change change(node, isComponent);
+
+	if (_changeSet.insert(change).second)
+	{
+		_changes.push_back(change);
+	}
+}
+
+bool DeferredSelectionChanges::empty() const
+{
+	return _changes.empty();
+}
+
+void DeferredSelectionChanges::send()
+{
+	if (_changes.empty()) return;
+
+	// The callbacks might cause new changes, start with a clean list
+	std::vector<Change> changes;
+	changes.swap(_changes);
+	_changeSet.clear();
+
+	// The signal listeners only look at the current selection, one emission is enough.
+	// The component selectables might be gone by now, pass the last selectable node instead.
+	for (std::vector<Change>::const_reverse_iterator i = changes.rbegin(); i != changes.rend(); ++i)
+	{
+		SelectablePtr selectable = Node_getSelectable(i->first);
+
+		if (selectable)
+		{
+			_emitSignal(*selectable);
+			break;
+		}
+	}
+
+	for (std::vector<Change>::const_iterator i = changes.begin(); i != changes.end(); ++i)
+	{
+		_notifyObservers(i->first, i->second);
+	}
+}
+
+} // namespace selection
@@ -0,0 +1,50 @@
+#ifndef DEFERREDSELECTIONCHANGES_H_
+#define DEFERREDSELECTIONCHANGES_H_
+
+#include "inode.h"
+#include "iselectable.h"
+
+#include <set>
+#include <vector>
+#include <boost/function.hpp>
+
+namespace selection
+{
+
+/**
+ * Selection changes held back while the scene graph is in a bulk change
+ * (like undo, which deselects every node it removes from the scene). When
+ * the changes are sent, the selection changed signal is emitted once and
+ * the observers are notified once per node, in the order of the first
+ * change of each node.
+ */
+class DeferredSelectionChanges
+{
+public:
+	typedef boost::function<void (const Selectable&)> SignalFunc;
+	typedef boost::function<void (const scene::INodePtr&, bool)> ObserverFunc;
+
+private:
+	SignalFunc _emitSignal;
+	ObserverFunc _notifyObservers;
+
+	// The flag is TRUE for component changes, the set avoids duplicates
+	typedef std::pair<scene::INodePtr, bool> Change;
+	std::vector<Change> _changes;
+	std::set<Change> _changeSet;
+
+public:
+	DeferredSelectionChanges(const SignalFunc& emitSignal, const ObserverFunc& notifyObservers);
+
+	// Records a change of the given node, repeated changes are sent once
+	void add(const scene::INodePtr& node, bool isComponent);
+
+	bool empty() const;
+
+	// Emits the signal and notifies the observers, does nothing if no change has been recorded
+	void send();
+};
+
+} // namespace selection
+
+#endif /* DEFERREDSELECTIONCHANGES_H_ */
@@ -3,6 +3,8 @@
 #include "gdk/gdktypes.h"
 
 #include "iundo.h"
+#include "iscenegraph.h"
+#include "iselectable.h"
 #include "igrid.h"
 #include "iradiant.h"
 #include "ieventmanager.h"
@@ -18,6 +20,8 @@
 #include "selection/algorithm/General.h"
 
 #include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <ctime>
 
 // Initialise the shader pointer
 ShaderPtr RadiantSelectionSystem::_state;
@@ -67,6 +71,10 @@ RadiantSelectionSystem::RadiantSelectionSystem() :
     _translateManipulator(*this, 2, 64),    // initialise the Manipulators with a pointer to self
     _rotateManipulator(*this, 8, 64),
     _scaleManipulator(*this, 0, 64),
+    _deferredSelectionChanges(
+        [this] (const Selectable& selectable) { _sigSelectionChanged(selectable); },
+        boost::bind(&RadiantSelectionSystem::notifyObservers, this, _1, _2)
+    ),
     _pivotChanged(false),
     _pivotMoving(false)
 {}
@@ -300,10 +308,8 @@ void RadiantSelectionSystem::onSelectedChanged(const scene::INodePtr& node, cons
     }
 
 	// greebo: Moved this here, the selectionInfo structure should be up to date before calling this
-	_sigSelectionChanged(selectable);
-
-    // Notify observers, FALSE = primitive selection change
-    notifyObservers(node, false);
+	// FALSE = primitive selection change
+	notifySelectionChanged(node, selectable, false);
 
     // Check if the number of selected primitives in the list matches the value of the selection counter
     ASSERT_MESSAGE(_selection.size() == _countPrimitive, "selection-tracking error");
@@ -322,7 +328,6 @@ void RadiantSelectionSystem::onComponentSelection(const scene::INodePtr& node, c
     int delta = selectable.isSelected() ? +1 : -1;
 
     _countComponent += delta;
-    _sigSelectionChanged(selectable);
 
     _selectionInfo.totalCount += delta;
     _selectionInfo.componentCount += delta;
@@ -336,7 +341,7 @@ void RadiantSelectionSystem::onComponentSelection(const scene::INodePtr& node, c
     }
 
     // Notify observers, TRUE => this is a component selection change
-    notifyObservers(node, true);
+    notifySelectionChanged(node, selectable, true);
 
     // Check if the number of selected components in the list matches the value of the selection counter
     ASSERT_MESSAGE(_componentSelection.size() == _countComponent, "component selection-tracking error");
@@ -348,6 +353,25 @@ void RadiantSelectionSystem::onComponentSelection(const scene::INodePtr& node, c
     _requestSceneGraphChange = true;
 }
 
+void RadiantSelectionSystem::notifySelectionChanged(const scene::INodePtr& node, const Selectable& selectable, bool isComponent)
+{
+    // Undo deselects every node it removes from the scene, the observers
+    // would rebuild their widgets for each one of them
+    if (GlobalSceneGraph().inBulkChange())
+    {
+        _deferredSelectionChanges.add(node, isComponent);
+        return;
+    }
+
+    _sigSelectionChanged(selectable);
+    notifyObservers(node, isComponent);
+}
+
+void RadiantSelectionSystem::onSceneBulkChangeFinished()
+{
+    _deferredSelectionChanges.send();
+}
+
 // Returns the last instance in the list (if the list is not empty)
 scene::INodePtr RadiantSelectionSystem::ultimateSelected()
 {
@@ -978,7 +1002,9 @@ void RadiantSelectionSystem::endMove() {
 
 const selection::WorkZone& RadiantSelectionSystem::getWorkZone()
 {
-    // Flush any pending idle callbacks, we need the workzone now
+    // Deliver any coalesced bounds changes and flush pending idle callbacks,
+    // we need the workzone now
+    GlobalSceneGraph().flushBoundsChanged();
     flushIdleCallback();
 
     return _workZone;
@@ -1165,11 +1191,19 @@ void RadiantSelectionSystem::initialiseModule(const ApplicationContext& ctx)
 	GlobalCommandSystem().addCommand("UnSelectSelection", boost::bind(&RadiantSelectionSystem::deselectCmd, this, _1));
 	GlobalEventManager().addCommand("UnSelectSelection", "UnSelectSelection");
 
+	GlobalCommandSystem().addCommand("BenchmarkAreaSelection",
+		boost::bind(&RadiantSelectionSystem::benchmarkAreaSelection, this, _1),
+		cmd::ARGTYPE_INT | cmd::ARGTYPE_OPTIONAL);
+
     // Connect the bounds changed caller
     GlobalSceneGraph().signal_boundsChanged().connect(
         sigc::mem_fun(this, &RadiantSelectionSystem::onSceneBoundsChanged)
     );
 
+    GlobalSceneGraph().signal_bulkChangeFinished().connect(
+        sigc::mem_fun(this, &RadiantSelectionSystem::onSceneBulkChangeFinished)
+    );
+
     GlobalRenderSystem().attachRenderable(*this);
 }
 
@@ -1433,3 +1467,54 @@ void RadiantSelectionSystem::deselectCmd(const cmd::ArgumentList& args)
 
 // Define the static SelectionSystem module
 module::StaticModule<RadiantSelectionSystem> radiantSelectionSystemModule;
+
+void RadiantSelectionSystem::benchmarkAreaSelection(const cmd::ArgumentList& args)
+{
+	int runs = (args.size() > 0 && args[0].getInt() > 0) ? args[0].getInt() : 10;
+
+	const scene::INodePtr& root = GlobalSceneGraph().root();
+	AABB bounds = root ? root->worldAABB() : AABB();
+
+	if (!bounds.isValid())
+	{
+		rError() << "BenchmarkAreaSelection: nothing to select." << std::endl;
+		return;
+	}
+
+	// Set up a top view enclosing the whole scene, with a small margin
+	Vector3 extents = bounds.extents * 1.1 + Vector3(1, 1, 1);
+
+	Matrix4 projection = Matrix4::getIdentity();
+	projection.xx() = 1.0 / extents.x();
+	projection.yy() = 1.0 / extents.y();
+	projection.zz() = 1.0 / extents.z();
+	projection.tx() = -bounds.origin.x() / extents.x();
+	projection.ty() = -bounds.origin.y() / extents.y();
+	projection.tz() = -bounds.origin.z() / extents.z();
+
+	render::View view;
+	view.Construct(projection, Matrix4::getIdentity(), 1024, 1024);
+
+	// Drag a box across the full view
+	render::View scissored(view);
+	ConstructSelectionTest(scissored, Rectangle::ConstructFromArea(Vector2(-1, -1), Vector2(2, 2)));
+
+	SelectionVolume volume(scissored);
+	std::size_t numCandidates = 0;
+
+	double start = clock() / static_cast<double>(CLOCKS_PER_SEC);
+
+	for (int i = 0; i < runs; ++i)
+	{
+		SelectablesList candidates;
+		testSelectScene(candidates, volume, scissored, ePrimitive, ComponentMode());
+
+		numCandidates = candidates.size();
+	}
+
+	double seconds = clock() / static_cast<double>(CLOCKS_PER_SEC) - start;
+
+	rMessage() << "Area selection benchmark: " << runs << " runs, "
+		<< numCandidates << " candidates, "
+		<< (boost::format("%5.3lf") % (seconds / runs)) << " seconds per run" << std::endl;
+}
@@ -17,6 +17,7 @@
 #include "ClipManipulator.h"
 #include "Selectors.h"
 #include "SelectedNodeList.h"
+#include "DeferredSelectionChanges.h"
 
 /* greebo: This can be tricky to understand (and I don't know if I do :D), but
  * I'll try:
@@ -113,6 +114,10 @@ private:
 	SelectionListType _selection;
 	SelectionListType _componentSelection;
 
+	// Selection changes during a bulk change of the scene graph (like undo),
+	// sent when it's over
+	selection::DeferredSelectionChanges _deferredSelectionChanges;
+
 	void ConstructPivot();
 	mutable bool _pivotChanged;
 	bool _pivotMoving;
@@ -158,6 +163,9 @@ public:
 	void onSelectedChanged(const scene::INodePtr& node, const Selectable& selectable);
 	void onComponentSelection(const scene::INodePtr& node, const Selectable& selectable);
 
+	// Sends the selection changes held back during the bulk change
+	void onSceneBulkChangeFinished();
+
     SelectionChangedSignal signal_selectionChanged() const
     {
         return _sigSelectionChanged;
@@ -267,5 +275,13 @@ private:
 
 	void checkComponentModeSelectionMode(const Selectable& selectable); // connects to the selection change signal
 
+	// Emits the selection changed signal and notifies the observers, unless the
+	// scene graph is in a bulk change, in which case the notification is deferred
+	void notifySelectionChanged(const scene::INodePtr& node, const Selectable& selectable, bool isComponent);
+
 	void deselectCmd(const cmd::ArgumentList& args);
+
+	// Runs a drag-selection over the whole scene a number of times (default: 10)
+	// and prints the timings, the current selection is not changed
+	void benchmarkAreaSelection(const cmd::ArgumentList& args);
 };
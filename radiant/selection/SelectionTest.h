@@ -1,46 +1,11 @@
 #pragma once
 
-#include "math/Matrix4.h"
-#include "math/Vector3.h"
 #include "iselectiontest.h"
 
-#include "render/View.h"
-#include "BestPoint.h"
+#include "SelectionVolume.h"
 #include "SelectionBox.h"
 
-class SelectionVolume : public SelectionTest {
-  Matrix4 _local2view;
-  const render::View& _view;
-  clipcull_t _cull;
-  Vector3 _near;
-  Vector3 _far;
-public:
-  SelectionVolume(const render::View& view): _view(view) {}
-
-  const VolumeTest& getVolume() const {
-    return _view;
-  }
-
-  const Vector3& getNear() const {
-    return _near;
-  }
-
-  const Vector3& getFar() const {
-    return _far;
-  }
-
-  void BeginMesh(const Matrix4& localToWorld, bool twoSided);
-  void TestPoint(const Vector3& point, SelectionIntersection& best);
-  void TestPolygon(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
-  void TestLineLoop(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
-  void TestLineStrip(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
-  void TestLines(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
-  void TestTriangles(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
-  void TestQuads(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
-  void TestQuadStrip(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
-};
-
-// --------------------------------------------------------------------------------
+#include <vector>
 
 // Base class for SelectionTesters, provides some convenience methods
 class SelectionTestWalker :
@@ -0,0 +1,234 @@
+#include "SelectionVolume.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SELECTION_VOLUME_SSE2
+#include <emmintrin.h>
+#endif
+
+inline SelectionIntersection select_point_from_clipped(Vector4& clipped) {
+  return SelectionIntersection(clipped[2] / clipped[3], static_cast<float>(Vector3(clipped[0] / clipped[3], clipped[1] / clipped[3], 0).getLengthSquared()));
+}
+
+void SelectionVolume::BeginMesh(const Matrix4& localToWorld, bool twoSided)
+{
+    _local2view = _view.GetViewMatrix().getMultipliedBy(localToWorld);
+
+    // Cull back-facing polygons based on winding being clockwise or counter-clockwise.
+    // Don't cull if the view is wireframe and the polygons are two-sided.
+    _cull = twoSided && !_view.fill() ? eClipCullNone : (localToWorld.getHandedness() == Matrix4::RIGHTHANDED) ? eClipCullCW : eClipCullCCW;
+
+    {
+      Matrix4 screen2world(_local2view.getFullInverse());
+
+      _near = screen2world.transformPoint(Vector3(0, 0, -1));
+	  _far = screen2world.transformPoint(Vector3(0, 0, 1));
+    }
+}
+
+void SelectionVolume::TestPoint(const Vector3& point, SelectionIntersection& best) {
+    Vector4 clipped;
+    if (_local2view.clipPoint(point, clipped) == c_CLIP_PASS)
+    {
+      best = select_point_from_clipped(clipped);
+    }
+}
+
+bool SelectionVolume::transformVertices(const VertexPointer& vertices, std::size_t count)
+{
+    if (_clipped.size() < count)
+    {
+        _clipped.resize(count);
+        _clipMasks.resize(count);
+    }
+
+    // The clip planes all vertices are outside of
+    ClipResult commonMask = c_CLIP_FAIL;
+
+    VertexPointer::iterator v = vertices.begin();
+
+#if defined(SELECTION_VOLUME_SSE2)
+    // Two lanes of doubles hold x,y and z,w of the transformed vertex
+    const double* m = _local2view;
+
+    const __m128d col0xy = _mm_loadu_pd(m), col0zw = _mm_loadu_pd(m + 2);
+    const __m128d col1xy = _mm_loadu_pd(m + 4), col1zw = _mm_loadu_pd(m + 6);
+    const __m128d col2xy = _mm_loadu_pd(m + 8), col2zw = _mm_loadu_pd(m + 10);
+    const __m128d col3xy = _mm_loadu_pd(m + 12), col3zw = _mm_loadu_pd(m + 14);
+
+    const __m128d negate = _mm_set1_pd(-0.0);
+
+    for (std::size_t i = 0; i < count; ++i, ++v)
+    {
+        const Vector3& p = *v;
+
+        const __m128d x = _mm_set1_pd(p[0]);
+        const __m128d y = _mm_set1_pd(p[1]);
+        const __m128d z = _mm_set1_pd(p[2]);
+
+        __m128d xy = _mm_add_pd(_mm_add_pd(_mm_mul_pd(col0xy, x), _mm_mul_pd(col1xy, y)),
+                                _mm_add_pd(_mm_mul_pd(col2xy, z), col3xy));
+        __m128d zw = _mm_add_pd(_mm_add_pd(_mm_mul_pd(col0zw, x), _mm_mul_pd(col1zw, y)),
+                                _mm_add_pd(_mm_mul_pd(col2zw, z), col3zw));
+
+        double* c = _clipped[i];
+        _mm_storeu_pd(c, xy);
+        _mm_storeu_pd(c + 2, zw);
+
+        // The same tests as Matrix4::getClipMask(), one bit per passed plane
+        __m128d w = _mm_unpackhi_pd(zw, zw);
+        __m128d negW = _mm_xor_pd(w, negate);
+
+        int xyLT = _mm_movemask_pd(_mm_cmplt_pd(xy, w));
+        int xyGT = _mm_movemask_pd(_mm_cmpgt_pd(xy, negW));
+        int zLT = _mm_movemask_pd(_mm_cmplt_pd(zw, w)) & 1;
+        int zGT = _mm_movemask_pd(_mm_cmpgt_pd(zw, negW)) & 1;
+
+        int passed = (xyLT & 1) | ((xyGT & 1) << 1) | ((xyLT & 2) << 1) | ((xyGT & 2) << 2) |
+                     (zLT << 4) | (zGT << 5);
+
+        _clipMasks[i] = c_CLIP_FAIL & ~static_cast<ClipResult>(passed);
+        commonMask &= _clipMasks[i];
+    }
+#else
+    // Copy the matrix elements to locals, so the compiler can keep them in registers
+    const double m0 = _local2view[0], m1 = _local2view[1], m2 = _local2view[2], m3 = _local2view[3];
+    const double m4 = _local2view[4], m5 = _local2view[5], m6 = _local2view[6], m7 = _local2view[7];
+    const double m8 = _local2view[8], m9 = _local2view[9], m10 = _local2view[10], m11 = _local2view[11];
+    const double m12 = _local2view[12], m13 = _local2view[13], m14 = _local2view[14], m15 = _local2view[15];
+
+    for (std::size_t i = 0; i < count; ++i, ++v)
+    {
+        const Vector3& p = *v;
+        Vector4& c = _clipped[i];
+
+        c[0] = m0 * p[0] + m4 * p[1] + m8  * p[2] + m12;
+        c[1] = m1 * p[0] + m5 * p[1] + m9  * p[2] + m13;
+        c[2] = m2 * p[0] + m6 * p[1] + m10 * p[2] + m14;
+        c[3] = m3 * p[0] + m7 * p[1] + m11 * p[2] + m15;
+
+        _clipMasks[i] = Matrix4::getClipMask(c);
+        commonMask &= _clipMasks[i];
+    }
+#endif
+
+    // If all vertices are outside the same plane, the primitive can't intersect the volume
+    return count > 0 && commonMask == c_CLIP_PASS;
+}
+
+bool SelectionVolume::transformIndexedVertices(const VertexPointer& vertices, const IndexPointer& indices)
+{
+    IndexPointer::index_type maxIndex = 0;
+
+    for (IndexPointer::iterator i(indices.begin()); i != indices.end(); ++i)
+    {
+        if (*i > maxIndex) maxIndex = *i;
+    }
+
+    return indices.begin() != indices.end() && transformVertices(vertices, maxIndex + 1);
+}
+
+void SelectionVolume::testTransformedTriangle(std::size_t i0, std::size_t i1, std::size_t i2, SelectionIntersection& best)
+{
+    // Skip triangles which are completely outside any clip plane
+    if (_clipMasks[i0] & _clipMasks[i1] & _clipMasks[i2]) return;
+
+    Vector4 clipped[9];
+    std::size_t count = 3;
+
+    clipped[0] = _clipped[i0];
+    clipped[1] = _clipped[i1];
+    clipped[2] = _clipped[i2];
+
+    // Triangles inside all planes come out of the clipping unchanged
+    if (_clipMasks[i0] | _clipMasks[i1] | _clipMasks[i2])
+    {
+      count = Matrix4::clipTransformedTriangle(_clipped[i0], _clipped[i1], _clipped[i2], clipped);
+    }
+
+    BestPoint(count, clipped, best, _cull);
+}
+
+void SelectionVolume::testTransformedLine(std::size_t i0, std::size_t i1, SelectionIntersection& best)
+{
+    if (_clipMasks[i0] & _clipMasks[i1]) return;
+
+    Vector4 clipped[9];
+    BestPoint(
+      Matrix4::clipTransformedLine(_clipped[i0], _clipped[i1], clipped),
+      clipped,
+      best,
+      _cull
+    );
+}
+
+void SelectionVolume::TestPolygon(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) {
+    if (!transformVertices(vertices, count))
+      return;
+
+    for(std::size_t i=0; i+2<count; ++i)
+    {
+      testTransformedTriangle(0, i+1, i+2, best);
+    }
+}
+
+void SelectionVolume::TestLineLoop(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) {
+    if (!transformVertices(vertices, count))
+      return;
+
+    for(std::size_t i = 0, prev = count-1; i < count; prev = i, ++i)
+    {
+      testTransformedLine(prev, i, best);
+    }
+}
+
+void SelectionVolume::TestLineStrip(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) {
+    if (!transformVertices(vertices, count))
+      return;
+
+    for(std::size_t i = 0; i+1 < count; ++i)
+    {
+      testTransformedLine(i, i+1, best);
+    }
+}
+
+void SelectionVolume::TestLines(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best) {
+    if (!transformVertices(vertices, count))
+      return;
+
+    for(std::size_t i = 0; i+1 < count; i += 2)
+    {
+      testTransformedLine(i, i+1, best);
+    }
+}
+
+void SelectionVolume::TestTriangles(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) {
+    if (!transformIndexedVertices(vertices, indices))
+      return;
+
+    for(IndexPointer::iterator i(indices.begin()); i != indices.end(); i += 3)
+    {
+      testTransformedTriangle(*i, *(i+1), *(i+2), best);
+    }
+}
+
+void SelectionVolume::TestQuads(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) {
+    if (!transformIndexedVertices(vertices, indices))
+      return;
+
+    for(IndexPointer::iterator i(indices.begin()); i != indices.end(); i += 4)
+    {
+      testTransformedTriangle(*i, *(i+1), *(i+3), best);
+      testTransformedTriangle(*(i+1), *(i+2), *(i+3), best);
+    }
+}
+
+void SelectionVolume::TestQuadStrip(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best) {
+    if (!transformIndexedVertices(vertices, indices))
+      return;
+
+    for(IndexPointer::iterator i(indices.begin()); i+2 != indices.end(); i += 2)
+    {
+      testTransformedTriangle(*i, *(i+1), *(i+2), best);
+      testTransformedTriangle(*(i+2), *(i+1), *(i+3), best);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "math/Matrix4.h"
+#include "math/Vector3.h"
+#include "iselectiontest.h"
+
+#include "render/View.h"
+#include "BestPoint.h"
+
+#include <vector>
+
+/**
+ * The SelectionTest used by the selection system, testing the primitives
+ * against the (scissored) view volume in clip space.
+ */
+class SelectionVolume : public SelectionTest {
+  Matrix4 _local2view;
+  const render::View& _view;
+  clipcull_t _cull;
+  Vector3 _near;
+  Vector3 _far;
+
+  // The vertices of the tested primitive in clip space, plus the clip planes
+  // each of them is outside of. Re-used between the tests to avoid allocations.
+  std::vector<Vector4> _clipped;
+  std::vector<ClipResult> _clipMasks;
+
+  // Transforms the given vertices to clip space in one go, returns false if
+  // all of them are outside the same clip plane (i.e. the primitive can be skipped)
+  bool transformVertices(const VertexPointer& vertices, std::size_t count);
+  bool transformIndexedVertices(const VertexPointer& vertices, const IndexPointer& indices);
+
+  // Clip and test primitives formed by the transformed vertices with the given indices
+  void testTransformedTriangle(std::size_t i0, std::size_t i1, std::size_t i2, SelectionIntersection& best);
+  void testTransformedLine(std::size_t i0, std::size_t i1, SelectionIntersection& best);
+
+public:
+  SelectionVolume(const render::View& view): _view(view) {}
+
+  const VolumeTest& getVolume() const {
+    return _view;
+  }
+
+  const Vector3& getNear() const {
+    return _near;
+  }
+
+  const Vector3& getFar() const {
+    return _far;
+  }
+
+  void BeginMesh(const Matrix4& localToWorld, bool twoSided);
+  void TestPoint(const Vector3& point, SelectionIntersection& best);
+  void TestPolygon(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
+  void TestLineLoop(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
+  void TestLineStrip(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
+  void TestLines(const VertexPointer& vertices, std::size_t count, SelectionIntersection& best);
+  void TestTriangles(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
+  void TestQuads(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
+  void TestQuadStrip(const VertexPointer& vertices, const IndexPointer& indices, SelectionIntersection& best);
+};
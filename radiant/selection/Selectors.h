@@ -3,12 +3,13 @@
 
 #include <map>
 #include <set>
+#include <vector>
+#include <list>
+#include <algorithm>
 #include "iselectiontest.h"
 #include "iselectable.h"
 
-typedef std::multimap<SelectionIntersection, Selectable*> SelectableSortedSet;
-
-// A simple set that gets filled after the SelectableSortedSet is populated.
+// A simple set that gets filled after the SelectionPool is populated.
 // greebo: I used this to merge two SelectionPools (entities and primitives)
 // 		   with a preferred sorting (see RadiantSelectionSystem::Scene_TestSelect())
 typedef std::list<Selectable*> SelectablesList;
@@ -19,21 +20,91 @@ typedef std::list<Selectable*> SelectablesList;
  * The addIntersection() method gets called by the tested object between
  * pushSelectable() and popSelectable() and picks the best Intersection out of the crop.
  *
+ * The candidates are appended to a flat vector during the test, which is
+ * sorted and stripped of duplicate Selectables once, when the pool is
+ * traversed for the first time. Only the best intersection of each Selectable
+ * is kept, candidates with equal intersections keep their insertion order.
  */
 class SelectionPool :
 	public Selector
 {
-	SelectableSortedSet 	_pool;
+public:
+	typedef std::pair<SelectionIntersection, Selectable*> Candidate;
+	typedef std::vector<Candidate> Candidates;
+
+private:
+	// The candidates, including their insertion index for a stable ordering
+	struct Entry
+	{
+		Candidate candidate;
+		std::size_t index;
+	};
+	typedef std::vector<Entry> Entries;
+	Entries _entries;
+
+	// The sorted result, valid if _sorted is true
+	Candidates _pool;
+	bool _sorted;
+
 	SelectionIntersection	_intersection;
 	Selectable* 			_selectable;
 
-	// A set of all current Selectable* candidates, to prevent double-insertions
-	// The iterator value points to an element in the SelectableSortedSet
-	// to allow for fast removals.
-	typedef std::map<Selectable*, SelectableSortedSet::iterator> SelectablesMap;
-	SelectablesMap _currentSelectables;
+	// Orders by Selectable first, to group the duplicates, best intersection first
+	static bool compareBySelectable(const Entry& a, const Entry& b)
+	{
+		if (a.candidate.second != b.candidate.second)
+		{
+			return a.candidate.second < b.candidate.second;
+		}
+
+		if (a.candidate.first < b.candidate.first) return true;
+		if (b.candidate.first < a.candidate.first) return false;
+
+		return a.index < b.index;
+	}
+
+	// The final ordering, by intersection and insertion order
+	static bool compareByIntersection(const Entry& a, const Entry& b)
+	{
+		if (a.candidate.first < b.candidate.first) return true;
+		if (b.candidate.first < a.candidate.first) return false;
+
+		return a.index < b.index;
+	}
+
+	void sort()
+	{
+		if (_sorted) return;
+
+		_sorted = true;
+
+		// Keep the best entry of each Selectable only
+		std::sort(_entries.begin(), _entries.end(), compareBySelectable);
+
+		Entries::iterator last = std::unique(_entries.begin(), _entries.end(), sameSelectable);
+		_entries.erase(last, _entries.end());
+
+		std::sort(_entries.begin(), _entries.end(), compareByIntersection);
+
+		_pool.clear();
+		_pool.reserve(_entries.size());
+
+		for (Entries::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+		{
+			_pool.push_back(i->candidate);
+		}
+	}
+
+	static bool sameSelectable(const Entry& a, const Entry& b)
+	{
+		return a.candidate.second == b.candidate.second;
+	}
 
 public:
+	SelectionPool() :
+		_sorted(true),
+		_selectable(NULL)
+	{}
 
 	/** greebo: This is called before an entity/patch/brush is
 	 * 			tested against selection to notify the SelectionPool
@@ -68,56 +139,37 @@ public:
 
 	/** greebo: This makes sure that only valid Intersections get added, otherwise
 	 * 			we would add Selectables that haven't passed the test.
+	 *
+	 * It's possible that the selectable is the parent of two different child
+	 * primitives, and both may want to add themselves to this pool. Duplicates
+	 * are resolved when sorting, the "worse" primitive never shadows the "better" one.
 	 */
 	void addSelectable(const SelectionIntersection& intersection, Selectable* selectable)
 	{
 		if (!intersection.valid()) return; // skip invalid intersections
 
-		SelectablesMap::iterator existing = _currentSelectables.find(selectable);
-
-		if (existing != _currentSelectables.end())
-		{
-			// greebo: We had that selectable before, check if the intersection is a better one
-			// and update it if necessary. It's possible that the selectable is the parent of
-			// two different child primitives, but both may want to add themselves to this pool.
-			// To prevent the "worse" primitive from shadowing the "better" one, perform this check.
-
-			// Check if the intersection is better
-			if (intersection < existing->second->first)
-			{
-				// Yes, update the map, remove old stuff first
-				_pool.erase(existing->second);
-				_currentSelectables.erase(existing);
-			}
-			else
-			{
-				// The existing intersection is better, we're done here
-				return;
-			}
-		}
-
-		// At this point, the selectable is ready for insertion into the pool
-		// Either it's a completely new Selectable, or it is replacing an existing one
-		SelectableSortedSet::iterator result = _pool.insert(
-			SelectableSortedSet::value_type(intersection, selectable)
-		);
+		Entry entry;
+		entry.candidate = Candidate(intersection, selectable);
+		entry.index = _entries.size();
 
-		// Memorise the Selectable for fast lookups
-		_currentSelectables.insert(SelectablesMap::value_type(selectable, result));
+		_entries.push_back(entry);
+		_sorted = false;
 	}
 
-	typedef SelectableSortedSet::iterator iterator;
+	typedef Candidates::iterator iterator;
 
 	iterator begin() {
+		sort();
 		return _pool.begin();
 	}
 
 	iterator end() {
+		sort();
 		return _pool.end();
 	}
 
 	bool failed() {
-		return _pool.empty();
+		return _entries.empty();
 	}
 };
 
@@ -1,6 +1,7 @@
 #include "General.h"
 
 #include "imodel.h"
+#include "imodelcache.h"
 #include "iselection.h"
 #include "iundo.h"
 #include "igrid.h"
@@ -882,6 +883,9 @@ void floorNode(const scene::INodePtr& node)
 
 void floorSelection(const cmd::ArgumentList& args)
 {
+	// The lowest vertices of the models are needed
+	GlobalModelCache().waitForPendingModels();
+
 	UndoableCommand undo("floorSelected");
 
 	GlobalSelectionSystem().foreachSelected([] (const scene::INodePtr& node)
@@ -0,0 +1,205 @@
+#include "radiant/selection/SelectionVolume.h"
+#include "radiant/selection/SelectionBox.h"
+#include "ibrush.h"
+#include "math/AABB.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <glibmm/timer.h>
+
+/**
+ * Measures the time needed to test the faces of a map with many brushes
+ * against a drag-selection, the way the brush nodes do it: brushes outside the
+ * view are rejected by their bounds, the others call TestPolygon() for each
+ * face winding. The previous implementation, clipping each triangle of the
+ * fan on its own, is timed for comparison. This is not part of the test suite,
+ * run "make areaSelectionBenchmark" and execute it manually. The number of
+ * brushes can be passed as argument.
+ */
+namespace
+{
+    const int RUNS = 10;
+    const double BRUSH_SIZE = 32;
+
+    // The six faces of an axis-aligned box, a winding of four vertices each
+    struct TestBrush
+    {
+        AABB bounds;
+        WindingVertex vertices[6][4];
+
+        TestBrush(const Vector3& mins)
+        {
+            Vector3 maxs = mins + Vector3(BRUSH_SIZE, BRUSH_SIZE, BRUSH_SIZE);
+            bounds = AABB::createFromMinMax(mins, maxs);
+
+            Vector3 c[8];
+
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                c[i] = Vector3(i & 1 ? maxs.x() : mins.x(), i & 2 ? maxs.y() : mins.y(), i & 4 ? maxs.z() : mins.z());
+            }
+
+            const std::size_t faces[6][4] = {
+                { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 },
+                { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 }
+            };
+
+            for (std::size_t f = 0; f < 6; ++f)
+            {
+                for (std::size_t v = 0; v < 4; ++v)
+                {
+                    vertices[f][v].vertex = c[faces[f][v]];
+                }
+            }
+        }
+
+        VertexPointer getWinding(std::size_t face) const
+        {
+            return VertexPointer(&vertices[face][0].vertex, sizeof(WindingVertex));
+        }
+    };
+
+    // Tests the faces like SelectionVolume::TestPolygon() did before the
+    // vertices were transformed in one go
+    void testPolygonPerTriangle(const Matrix4& local2view, const VertexPointer& vertices,
+                                std::size_t count, SelectionIntersection& best)
+    {
+        Vector4 clipped[9];
+
+        for (std::size_t i = 0; i + 2 < count; ++i)
+        {
+            BestPoint(
+                local2view.clipTriangle(vertices[0], vertices[i + 1], vertices[i + 2], clipped),
+                clipped,
+                best,
+                eClipCullCW
+            );
+        }
+    }
+
+    // Returns the number of selected brushes of the last run and prints the time per run
+    template<typename TestFunc>
+    std::size_t measure(const char* name, const std::vector<TestBrush>& brushes,
+                        const render::View& view, TestFunc testBrush)
+    {
+        std::size_t selected = 0;
+
+        Glib::Timer timer;
+
+        for (int run = 0; run < RUNS; ++run)
+        {
+            selected = 0;
+
+            for (std::vector<TestBrush>::const_iterator b = brushes.begin(); b != brushes.end(); ++b)
+            {
+                if (view.TestAABB(b->bounds) == VOLUME_OUTSIDE) continue;
+
+                SelectionIntersection best;
+                testBrush(*b, best);
+
+                if (best.valid()) ++selected;
+            }
+        }
+
+        double msecs = timer.elapsed() * 1000 / RUNS;
+
+        std::cout << std::left << std::setw(28) << name << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(8) << msecs << " ms per run, "
+                  << selected << " brushes selected" << std::endl;
+
+        return selected;
+    }
+
+    void measureArea(const std::vector<TestBrush>& brushes, const render::View& view,
+                     const Rectangle& area)
+    {
+        render::View scissored(view);
+        scissored.EnableScissor(area.min[0], area.max[0], area.min[1], area.max[1]);
+
+        SelectionVolume volume(scissored);
+        Matrix4 local2view = scissored.GetViewMatrix();
+
+        std::size_t expected = measure("per triangle (previous)", brushes, scissored,
+            [&] (const TestBrush& brush, SelectionIntersection& best)
+            {
+                // The brush nodes call this in both cases
+                volume.BeginMesh(Matrix4::getIdentity(), false);
+
+                for (std::size_t f = 0; f < 6; ++f)
+                {
+                    testPolygonPerTriangle(local2view, brush.getWinding(f), 4, best);
+                }
+            });
+
+        std::size_t selected = measure("SelectionVolume", brushes, scissored,
+            [&] (const TestBrush& brush, SelectionIntersection& best)
+            {
+                volume.BeginMesh(Matrix4::getIdentity(), false);
+
+                for (std::size_t f = 0; f < 6; ++f)
+                {
+                    volume.TestPolygon(brush.getWinding(f), 4, best);
+                }
+            });
+
+        if (selected != expected)
+        {
+            std::cout << "Mismatch: " << selected << " instead of " << expected << " brushes" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t numBrushes = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 50000;
+
+    std::srand(1);
+
+    // Scatter the brushes across a map of roughly square layout
+    std::size_t rowLength = 1;
+
+    while (rowLength * rowLength < numBrushes) ++rowLength;
+
+    std::vector<TestBrush> brushes;
+    brushes.reserve(numBrushes);
+
+    for (std::size_t i = 0; i < numBrushes; ++i)
+    {
+        brushes.push_back(TestBrush(Vector3(
+            static_cast<double>(i % rowLength) * BRUSH_SIZE * 2,
+            static_cast<double>(i / rowLength) * BRUSH_SIZE * 2,
+            static_cast<double>(std::rand() % 16) * BRUSH_SIZE
+        )));
+    }
+
+    AABB mapBounds;
+
+    for (std::vector<TestBrush>::const_iterator b = brushes.begin(); b != brushes.end(); ++b)
+    {
+        mapBounds.includeAABB(b->bounds);
+    }
+
+    // A top view enclosing the whole map, like the BenchmarkAreaSelection command
+    Vector3 extents = mapBounds.extents * 1.1 + Vector3(1, 1, 1);
+
+    Matrix4 projection = Matrix4::getIdentity();
+    projection.xx() = 1.0 / extents.x();
+    projection.yy() = 1.0 / extents.y();
+    projection.zz() = 1.0 / extents.z();
+    projection.tx() = -mapBounds.origin.x() / extents.x();
+    projection.ty() = -mapBounds.origin.y() / extents.y();
+    projection.tz() = -mapBounds.origin.z() / extents.z();
+
+    render::View view;
+    view.Construct(projection, Matrix4::getIdentity(), 1024, 1024);
+
+    std::cout << "Drag-selecting the whole map of " << numBrushes << " brushes" << std::endl;
+    measureArea(brushes, view, Rectangle::ConstructFromArea(Vector2(-1, -1), Vector2(2, 2)));
+
+    std::cout << "Drag-selecting a quarter of the map" << std::endl;
+    measureArea(brushes, view, Rectangle::ConstructFromArea(Vector2(-0.5, -0.5), Vector2(1, 1)));
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE deferredSelectionChangesTest
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/selection/DeferredSelectionChanges.h"
+#include "scene/Node.h"
+#include "math/AABB.h"
+
+#include <vector>
+#include <boost/bind.hpp>
+
+using selection::DeferredSelectionChanges;
+
+namespace
+{
+    class TestNode :
+        public scene::Node,
+        public Selectable
+    {
+        AABB _localAABB;
+        bool _selected;
+
+    public:
+        TestNode() :
+            _selected(false)
+        {}
+
+        void setSelected(bool select) { _selected = select; }
+        bool isSelected() const { return _selected; }
+        void invertSelected() { _selected = !_selected; }
+
+        const AABB& localAABB() const { return _localAABB; }
+        Type getNodeType() const { return Type::Primitive; }
+        void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const {}
+        void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const {}
+        void setRenderSystem(const RenderSystemPtr& renderSystem) {}
+        bool isHighlighted() const { return false; }
+    };
+    typedef boost::shared_ptr<TestNode> TestNodePtr;
+
+    // A node which can't be selected, like a removed component owner
+    class PlainNode :
+        public scene::Node
+    {
+        AABB _localAABB;
+
+    public:
+        const AABB& localAABB() const { return _localAABB; }
+        Type getNodeType() const { return Type::Primitive; }
+        void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const {}
+        void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const {}
+        void setRenderSystem(const RenderSystemPtr& renderSystem) {}
+        bool isHighlighted() const { return false; }
+    };
+
+    // Records what the selection system would send
+    struct Recorder
+    {
+        std::vector<const Selectable*> signals;
+        std::vector<std::pair<scene::INodePtr, bool> > observed;
+
+        void onSignal(const Selectable& selectable)
+        {
+            signals.push_back(&selectable);
+        }
+
+        void onObserver(const scene::INodePtr& node, bool isComponent)
+        {
+            observed.push_back(std::make_pair(node, isComponent));
+        }
+    };
+
+    struct Fixture
+    {
+        Recorder recorder;
+        DeferredSelectionChanges changes;
+
+        Fixture() :
+            changes(boost::bind(&Recorder::onSignal, &recorder, _1),
+                    boost::bind(&Recorder::onObserver, &recorder, _1, _2))
+        {}
+    };
+}
+
+// Nothing is sent until the bulk change is over
+BOOST_FIXTURE_TEST_CASE(heldBackUntilSent, Fixture)
+{
+    TestNodePtr node(new TestNode);
+
+    changes.add(node, false);
+
+    BOOST_CHECK(!changes.empty());
+    BOOST_CHECK(recorder.signals.empty());
+    BOOST_CHECK(recorder.observed.empty());
+
+    changes.send();
+
+    BOOST_CHECK(changes.empty());
+    BOOST_CHECK_EQUAL(recorder.signals.size(), 1);
+    BOOST_CHECK_EQUAL(recorder.observed.size(), 1);
+
+    // Nothing left to send
+    changes.send();
+
+    BOOST_CHECK_EQUAL(recorder.signals.size(), 1);
+    BOOST_CHECK_EQUAL(recorder.observed.size(), 1);
+}
+
+// One signal for all changes, one observer call per node in the order of the first change
+BOOST_FIXTURE_TEST_CASE(coalescedPerNode, Fixture)
+{
+    TestNodePtr first(new TestNode);
+    TestNodePtr second(new TestNode);
+
+    // Undo deselects and reselects the same nodes
+    changes.add(first, false);
+    changes.add(second, false);
+    changes.add(first, false);
+    changes.add(second, true);
+    changes.add(second, false);
+
+    changes.send();
+
+    BOOST_REQUIRE_EQUAL(recorder.signals.size(), 1);
+    BOOST_CHECK(recorder.signals[0] == second.get());
+
+    BOOST_REQUIRE_EQUAL(recorder.observed.size(), 3);
+    BOOST_CHECK(recorder.observed[0].first == first && !recorder.observed[0].second);
+    BOOST_CHECK(recorder.observed[1].first == second && !recorder.observed[1].second);
+    BOOST_CHECK(recorder.observed[2].first == second && recorder.observed[2].second);
+}
+
+// The signal needs a selectable, the observers are told about every node
+BOOST_FIXTURE_TEST_CASE(signalWithLastSelectable, Fixture)
+{
+    TestNodePtr selectable(new TestNode);
+    scene::INodePtr plain(new PlainNode);
+
+    changes.add(selectable, false);
+    changes.add(plain, true);
+
+    changes.send();
+
+    BOOST_REQUIRE_EQUAL(recorder.signals.size(), 1);
+    BOOST_CHECK(recorder.signals[0] == selectable.get());
+    BOOST_CHECK_EQUAL(recorder.observed.size(), 2);
+
+    // No signal if none of the nodes can be selected
+    recorder.signals.clear();
+
+    changes.add(plain, true);
+    changes.send();
+
+    BOOST_CHECK(recorder.signals.empty());
+    BOOST_CHECK_EQUAL(recorder.observed.size(), 3);
+}
+
+// Changes made by the observers are recorded for the next bulk change
+BOOST_AUTO_TEST_CASE(changesDuringSend)
+{
+    TestNodePtr node(new TestNode);
+    TestNodePtr other(new TestNode);
+
+    Recorder recorder;
+    DeferredSelectionChanges* changesPtr = NULL;
+    std::size_t observerCalls = 0;
+
+    DeferredSelectionChanges changes(
+        boost::bind(&Recorder::onSignal, &recorder, _1),
+        [&] (const scene::INodePtr& changed, bool isComponent)
+        {
+            if (observerCalls++ == 0)
+            {
+                changesPtr->add(other, false);
+            }
+        }
+    );
+    changesPtr = &changes;
+
+    changes.add(node, false);
+    changes.send();
+
+    BOOST_CHECK_EQUAL(observerCalls, 1);
+    BOOST_CHECK(!changes.empty());
+
+    changes.send();
+
+    BOOST_CHECK_EQUAL(observerCalls, 2);
+    BOOST_CHECK(changes.empty());
+}
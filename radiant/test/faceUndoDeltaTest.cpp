@@ -0,0 +1,153 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE faceUndoDeltaTest
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/brush/FaceUndoDelta.h"
+#include "radiant/brush/FacePlane.h"
+
+namespace
+{
+    // The parts of a face saved by Face::SavedState, restored the same way:
+    // only the parts marked as changed by compactState() are imported
+    struct FaceData
+    {
+        FacePlane plane;
+        BrushPrimitTexDef texdef;
+        std::string material;
+        ContentsFlagsValue flags;
+
+        FaceData() :
+            material("textures/common/caulk"),
+            flags(0, 0, 0, false)
+        {
+            plane.setPlane(Plane3(Vector3(0, 0, 1), 64));
+        }
+    };
+
+    struct SavedFace
+    {
+        FacePlane::SavedState planeState;
+        BrushPrimitTexDef texdef;
+        std::string material;
+        ContentsFlagsValue flags;
+
+        SavedFace(const FaceData& face) :
+            planeState(face.plane),
+            texdef(face.texdef),
+            material(face.material),
+            flags(face.flags)
+        {}
+    };
+
+    FaceUndoDelta compact(const SavedFace& saved, const FaceData& face)
+    {
+        return FaceUndoDelta(saved.planeState.m_plane, face.plane.getPlane(),
+                             saved.texdef, face.texdef,
+                             saved.material, face.material,
+                             saved.flags, face.flags);
+    }
+
+    void import(const SavedFace& saved, const FaceUndoDelta& delta, FaceData& face)
+    {
+        if (delta.planeChanged) saved.planeState.exportState(face.plane);
+        if (delta.texdefChanged) face.texdef = saved.texdef;
+
+        if (delta.shaderChanged)
+        {
+            face.material = saved.material;
+            face.flags = saved.flags;
+        }
+    }
+
+    bool equal(const FaceData& a, const FaceData& b)
+    {
+        return FaceUndoDelta::planesEqual(a.plane.getPlane(), b.plane.getPlane()) &&
+               FaceUndoDelta::texdefsEqual(a.texdef, b.texdef) &&
+               a.material == b.material && FaceUndoDelta::flagsEqual(a.flags, b.flags);
+    }
+
+    // Exports the face, applies the change, compacts the saved state and
+    // imports it again, the face needs to be exactly in its original state
+    template<typename Change>
+    FaceUndoDelta roundTrip(FaceData& face, const Change& change)
+    {
+        FaceData before = face;
+        SavedFace saved(face);
+
+        change(face);
+
+        FaceUndoDelta delta = compact(saved, face);
+        import(saved, delta, face);
+
+        BOOST_REQUIRE(equal(face, before));
+
+        return delta;
+    }
+}
+
+// Small moves are below the epsilon of Plane3::operator== but still changes
+BOOST_AUTO_TEST_CASE(moveFaceSlightly)
+{
+    FaceData face;
+
+    FaceUndoDelta delta = roundTrip(face, [] (FaceData& f)
+    {
+        f.plane.translate(Vector3(0, 0, 1e-6));
+    });
+
+    BOOST_CHECK(delta.planeChanged);
+    BOOST_CHECK(!delta.texdefChanged);
+    BOOST_CHECK(!delta.shaderChanged);
+}
+
+// Moving and rotating a brush changes the plane and the texture projection
+BOOST_AUTO_TEST_CASE(transformFace)
+{
+    FaceData face;
+
+    FaceUndoDelta delta = roundTrip(face, [] (FaceData& f)
+    {
+        f.plane.setPlane(Plane3(Vector3(0, 1, 0), -32));
+        f.texdef.shift(0.25f, 0);
+        f.texdef.rotate(15);
+    });
+
+    BOOST_CHECK(delta.planeChanged);
+    BOOST_CHECK(delta.texdefChanged);
+    BOOST_CHECK(!delta.shaderChanged);
+}
+
+// Applying a shader or changing the flags leaves the plane alone
+BOOST_AUTO_TEST_CASE(changeShader)
+{
+    FaceData face;
+
+    FaceUndoDelta delta = roundTrip(face, [] (FaceData& f)
+    {
+        f.material = "textures/darkmod/wood/boards/rough_planks";
+    });
+
+    BOOST_CHECK(!delta.planeChanged);
+    BOOST_CHECK(!delta.texdefChanged);
+    BOOST_CHECK(delta.shaderChanged);
+
+    delta = roundTrip(face, [] (FaceData& f)
+    {
+        f.flags = ContentsFlagsValue(0, BRUSH_DETAIL_MASK, 0, true);
+    });
+
+    BOOST_CHECK(delta.shaderChanged);
+}
+
+// Saving a face without changing it leaves nothing to restore
+BOOST_AUTO_TEST_CASE(untouchedFace)
+{
+    FaceData face;
+
+    FaceUndoDelta delta = roundTrip(face, [] (FaceData& f)
+    {
+        f.plane.setPlane(f.plane.getPlane());
+    });
+
+    BOOST_CHECK(delta.empty());
+}
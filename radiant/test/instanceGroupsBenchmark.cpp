@@ -0,0 +1,103 @@
+#include "radiant/render/backend/InstanceGroups.h"
+#include "irender.h"
+#include "math/Matrix4.h"
+
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <glibmm/timer.h>
+
+/**
+ * Measures the time needed to group the renderables of a map with many
+ * instances of the same static models. The renderables are submitted in
+ * entity order, like the scene traversal does. This is not part of the test
+ * suite, run "make instanceGroupsBenchmark" and execute it manually. The
+ * number of models and the number of instances can be passed as arguments.
+ */
+using render::InstanceGroups;
+
+namespace
+{
+    const std::size_t SURFACES_PER_MODEL = 3;
+    const int FRAMES = 100;
+
+    class TestRenderable :
+        public OpenGLRenderable
+    {
+    public:
+        void render(const RenderInfo& info) const
+        {}
+    };
+
+    // The number of times the drawn renderable changes between two instances
+    template<typename Iterator>
+    std::size_t countSwitches(Iterator begin, Iterator end)
+    {
+        std::size_t switches = 0;
+
+        for (Iterator i = begin; i != end; ++i)
+        {
+            if (i == begin || (i - 1)->renderable != i->renderable) ++switches;
+        }
+
+        return switches;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t numModels = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 50;
+    std::size_t numInstances = argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 5000;
+
+    std::srand(1);
+
+    std::vector<TestRenderable> surfaces(numModels * SURFACES_PER_MODEL);
+    std::vector<Matrix4> transforms(numInstances, Matrix4::getIdentity());
+
+    // Each entity references a random model
+    std::vector<std::size_t> models(numInstances);
+
+    for (std::size_t i = 0; i < numInstances; ++i)
+    {
+        models[i] = std::rand() % numModels;
+    }
+
+    InstanceGroups groups;
+    std::vector<InstanceGroups::Instance> submitted;
+
+    Glib::Timer timer;
+
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        groups.clear();
+
+        for (std::size_t i = 0; i < numInstances; ++i)
+        {
+            for (std::size_t s = 0; s < SURFACES_PER_MODEL; ++s)
+            {
+                groups.add(surfaces[models[i] * SURFACES_PER_MODEL + s], transforms[i], NULL);
+            }
+        }
+
+        if (frame == 0)
+        {
+            submitted.assign(groups.begin(), groups.end());
+        }
+
+        groups.group();
+    }
+
+    double msecs = timer.elapsed() * 1000 / FRAMES;
+
+    std::cout << numInstances << " instances of " << numModels << " models with "
+              << SURFACES_PER_MODEL << " surfaces each" << std::endl;
+    std::cout << "Renderable switches in submission order: "
+              << countSwitches(submitted.begin(), submitted.end()) << std::endl;
+    std::cout << "Renderable switches after grouping:      "
+              << countSwitches(groups.begin(), groups.end()) << std::endl;
+    std::cout << "Submission and grouping: " << std::fixed << std::setprecision(3)
+              << msecs << " ms per frame" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE instanceGroupsTest
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/render/backend/InstanceGroups.h"
+#include "irender.h"
+#include "math/Matrix4.h"
+
+#include <vector>
+#include <cstdlib>
+
+using render::InstanceGroups;
+
+namespace
+{
+    class TestRenderable :
+        public OpenGLRenderable
+    {
+    public:
+        void render(const RenderInfo& info) const
+        {}
+    };
+}
+
+// Every instance has to come out exactly once, grouped by renderable and in
+// submission order within each group
+BOOST_AUTO_TEST_CASE(groupInstances)
+{
+    std::srand(1);
+
+    std::vector<TestRenderable> renderables(7);
+    std::vector<Matrix4> transforms(500, Matrix4::getIdentity());
+
+    InstanceGroups groups;
+
+    for (int round = 0; round < 2; ++round)
+    {
+        groups.clear();
+
+        std::vector<std::size_t> submitted;
+
+        for (std::size_t i = 0; i < transforms.size(); ++i)
+        {
+            std::size_t r = std::rand() % renderables.size();
+
+            groups.add(renderables[r], transforms[i], NULL);
+            submitted.push_back(r);
+        }
+
+        groups.group();
+
+        BOOST_REQUIRE_EQUAL(groups.size(), transforms.size());
+        BOOST_CHECK_EQUAL(groups.getNumGroups(), renderables.size());
+
+        std::vector<bool> seen(transforms.size(), false);
+
+        for (InstanceGroups::const_iterator i = groups.begin(); i != groups.end(); ++i)
+        {
+            std::size_t index = i->transform - &transforms[0];
+
+            BOOST_REQUIRE(index < transforms.size());
+            BOOST_CHECK(!seen[index]);
+            seen[index] = true;
+
+            BOOST_CHECK(i->renderable == &renderables[submitted[index]]);
+
+            if (i != groups.begin())
+            {
+                InstanceGroups::const_iterator prev = i - 1;
+
+                // Transforms were submitted in order
+                if (prev->renderable == i->renderable)
+                {
+                    BOOST_CHECK(prev->transform < i->transform);
+                }
+            }
+        }
+    }
+}
+
+// Renderables submitted in group order already are left alone
+BOOST_AUTO_TEST_CASE(keepGroupedOrder)
+{
+    std::vector<TestRenderable> renderables(3);
+    Matrix4 transform = Matrix4::getIdentity();
+
+    InstanceGroups groups;
+
+    groups.add(renderables[0], transform, NULL);
+    groups.add(renderables[0], transform, NULL);
+    groups.add(renderables[2], transform, NULL);
+
+    groups.group();
+
+    BOOST_CHECK_EQUAL(groups.getNumGroups(), 2);
+    BOOST_CHECK(groups.begin()->renderable == &renderables[0]);
+    BOOST_CHECK((groups.end() - 1)->renderable == &renderables[2]);
+}
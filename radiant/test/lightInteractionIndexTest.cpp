@@ -0,0 +1,295 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE lightInteractionIndexTest
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/render/LightInteractionIndex.h"
+#include "radiant/render/LinearLightList.h"
+#include "irender.h"
+#include "math/AABB.h"
+#include "math/Matrix4.h"
+
+#include <set>
+#include <vector>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+using render::LightInteractionIndex;
+using render::LinearLightList;
+
+namespace
+{
+    // A box-shaped light, the volume is all the index gets to see
+    class TestLight :
+        public RendererLight
+    {
+        ShaderPtr _shader;
+        Vector3 _direction;
+
+    public:
+        AABB volume;
+
+        TestLight(const AABB& volume_) :
+            volume(volume_)
+        {}
+
+        float getShaderParm(int parmNum) const { return 0; }
+        const Vector3& getDirection() const { return _direction; }
+        const ShaderPtr& getWireShader() const { return _shader; }
+        ShaderPtr getShader() const { return _shader; }
+        Vector3 worldOrigin() const { return volume.origin; }
+        Matrix4 getLightTextureTransformation() const { return Matrix4::getIdentity(); }
+        Vector3 getLightOrigin() const { return volume.origin; }
+
+        bool intersectsAABB(const AABB& aabb) const
+        {
+            return volume.intersects(aabb);
+        }
+
+        AABB lightAABB() const
+        {
+            return volume;
+        }
+    };
+
+    class TestObject :
+        public LitObject
+    {
+    public:
+        AABB bounds;
+
+        TestObject(const AABB& bounds_) :
+            bounds(bounds_)
+        {}
+
+        bool intersectsLight(const RendererLight& light) const
+        {
+            return light.intersectsAABB(bounds);
+        }
+
+        const AABB& getLitObjectAABB() const
+        {
+            return bounds;
+        }
+    };
+
+    typedef std::set<const RendererLight*> LightSet;
+
+    void collectLight(LightSet& set, const RendererLight& light)
+    {
+        set.insert(&light);
+    }
+
+    AABB randomBox(double maxExtent)
+    {
+        Vector3 origin(std::rand() % 8192 - 4096, std::rand() % 8192 - 4096, std::rand() % 2048 - 1024);
+        Vector3 extents(std::rand() % int(maxExtent) + 1, std::rand() % int(maxExtent) + 1, std::rand() % int(maxExtent) + 1);
+
+        return AABB(origin, extents);
+    }
+
+    class Scene
+    {
+    public:
+        LightInteractionIndex index;
+        std::vector<boost::shared_ptr<TestLight> > lights;
+        std::vector<boost::shared_ptr<TestObject> > objects;
+        std::vector<boost::shared_ptr<LinearLightList> > lists;
+
+        Scene(std::size_t numLights, std::size_t numObjects)
+        {
+            for (std::size_t i = 0; i < numLights; ++i)
+            {
+                lights.push_back(boost::shared_ptr<TestLight>(new TestLight(randomBox(1024))));
+                index.addLight(*lights.back());
+            }
+
+            for (std::size_t i = 0; i < numObjects; ++i)
+            {
+                objects.push_back(boost::shared_ptr<TestObject>(new TestObject(randomBox(256))));
+                lists.push_back(boost::shared_ptr<LinearLightList>(new LinearLightList(*objects.back(), index)));
+            }
+        }
+
+        ~Scene()
+        {
+            for (std::size_t i = 0; i < lists.size(); ++i)
+            {
+                index.removeObject(*lists[i]);
+            }
+        }
+
+        // The lights intersecting the given object, tested against every light
+        LightSet bruteForce(std::size_t object) const
+        {
+            LightSet set;
+
+            for (std::size_t i = 0; i < lights.size(); ++i)
+            {
+                if (lights[i]->lightAABB().intersects(objects[object]->bounds))
+                {
+                    set.insert(lights[i].get());
+                }
+            }
+
+            return set;
+        }
+
+        LightSet indexed(std::size_t object) const
+        {
+            LightSet set;
+            lists[object]->forEachLight(boost::bind(&collectLight, boost::ref(set), _1));
+            return set;
+        }
+
+        void checkAll() const
+        {
+            for (std::size_t i = 0; i < objects.size(); ++i)
+            {
+                BOOST_REQUIRE(indexed(i) == bruteForce(i));
+            }
+        }
+    };
+}
+
+// Moving lights across cells must flag exactly the objects gaining or losing them
+BOOST_AUTO_TEST_CASE(moveLights)
+{
+    std::srand(1);
+
+    Scene scene(40, 2000);
+    scene.checkAll();
+
+    for (int step = 0; step < 200; ++step)
+    {
+        std::vector<LightSet> before;
+
+        for (std::size_t i = 0; i < scene.objects.size(); ++i)
+        {
+            before.push_back(scene.bruteForce(i));
+        }
+
+        TestLight& light = *scene.lights[std::rand() % scene.lights.size()];
+        light.volume = randomBox(1024);
+        scene.index.lightChanged(light);
+
+        scene.index.update();
+
+        for (std::size_t i = 0; i < scene.objects.size(); ++i)
+        {
+            bool changed = before[i] != scene.bruteForce(i);
+            BOOST_REQUIRE_EQUAL(scene.lists[i]->isDirty(), changed);
+        }
+
+        scene.checkAll();
+    }
+}
+
+// Objects moving across cells pick up the lights at their new location
+BOOST_AUTO_TEST_CASE(moveObjects)
+{
+    std::srand(2);
+
+    Scene scene(40, 2000);
+    scene.checkAll();
+
+    for (int step = 0; step < 500; ++step)
+    {
+        std::size_t object = std::rand() % scene.objects.size();
+
+        scene.objects[object]->bounds = randomBox(256);
+        scene.lists[object]->setDirty();
+
+        // Move a light at the same time now and then
+        if (step % 5 == 0)
+        {
+            TestLight& light = *scene.lights[std::rand() % scene.lights.size()];
+            light.volume = randomBox(1024);
+            scene.index.lightChanged(light);
+        }
+
+        scene.checkAll();
+    }
+}
+
+// Oversized lights and objects are kept outside the grid, but still interact
+BOOST_AUTO_TEST_CASE(oversizedItems)
+{
+    std::srand(3);
+
+    Scene scene(10, 500);
+
+    scene.lights[0]->volume = AABB(Vector3(0, 0, 0), Vector3(65536, 65536, 65536));
+    scene.index.lightChanged(*scene.lights[0]);
+
+    scene.objects[0]->bounds = AABB(Vector3(0, 0, 0), Vector3(32768, 32768, 4096));
+    scene.lists[0]->setDirty();
+
+    scene.checkAll();
+
+    // Shrink both into the grid again
+    scene.lights[0]->volume = randomBox(1024);
+    scene.index.lightChanged(*scene.lights[0]);
+
+    scene.objects[0]->bounds = randomBox(256);
+    scene.lists[0]->setDirty();
+
+    scene.checkAll();
+}
+
+// Removed lights disappear from all objects they lit
+BOOST_AUTO_TEST_CASE(removeLights)
+{
+    std::srand(4);
+
+    Scene scene(40, 2000);
+    scene.checkAll();
+
+    while (!scene.lights.empty())
+    {
+        scene.index.removeLight(*scene.lights.back());
+        scene.lights.pop_back();
+
+        scene.checkAll();
+    }
+}
+
+// Removed objects leave the interactions of their lights
+BOOST_AUTO_TEST_CASE(removeObjects)
+{
+    std::srand(5);
+
+    Scene scene(1, 0);
+
+    // All objects are lit by the one light
+    scene.lights[0]->volume = AABB(Vector3(0, 0, 0), Vector3(1024, 1024, 1024));
+    scene.index.lightChanged(*scene.lights[0]);
+
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        scene.objects.push_back(boost::shared_ptr<TestObject>(new TestObject(
+            AABB(Vector3(std::rand() % 1024 - 512, std::rand() % 1024 - 512, 0), Vector3(16, 16, 16))
+        )));
+        scene.lists.push_back(boost::shared_ptr<LinearLightList>(
+            new LinearLightList(*scene.objects.back(), scene.index)
+        ));
+    }
+
+    scene.checkAll();
+
+    // Remove every other object
+    for (std::size_t i = 0; i < scene.lists.size(); i += 2)
+    {
+        scene.index.removeObject(*scene.lists[i]);
+    }
+
+    // Moving the light away only reaches the remaining objects
+    scene.lights[0]->volume = AABB(Vector3(100000, 0, 0), Vector3(16, 16, 16));
+    scene.index.lightChanged(*scene.lights[0]);
+    scene.index.update();
+
+    for (std::size_t i = 0; i < scene.lists.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(scene.lists[i]->isDirty(), i % 2 == 1);
+    }
+}
@@ -0,0 +1,115 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE meshSimplifierTest
+#include <boost/test/unit_test.hpp>
+
+#include "render/MeshSimplifier.h"
+
+#include <vector>
+#include <cmath>
+
+using render::MeshSimplifier;
+
+namespace
+{
+    const double RADIUS = 100;
+
+    // Builds a sphere out of rings and segments, outward facing
+    void createSphere(std::vector<Vector3>& positions, std::vector<unsigned int>& indices)
+    {
+        const int RINGS = 40;
+        const int SEGMENTS = 80;
+
+        for (int i = 0; i <= RINGS; ++i)
+        {
+            for (int j = 0; j <= SEGMENTS; ++j)
+            {
+                double theta = M_PI * i / RINGS;
+                double phi = 2 * M_PI * j / SEGMENTS;
+
+                positions.push_back(Vector3(RADIUS * sin(theta) * cos(phi),
+                                            RADIUS * sin(theta) * sin(phi),
+                                            RADIUS * cos(theta)));
+            }
+        }
+
+        for (int i = 0; i < RINGS; ++i)
+        {
+            for (int j = 0; j < SEGMENTS; ++j)
+            {
+                unsigned int a = i * (SEGMENTS + 1) + j;
+                unsigned int b = a + 1;
+                unsigned int c = a + SEGMENTS + 1;
+                unsigned int d = c + 1;
+
+                indices.push_back(a); indices.push_back(c); indices.push_back(b);
+                indices.push_back(b); indices.push_back(c); indices.push_back(d);
+            }
+        }
+    }
+}
+
+// Each level needs to be coarser than the previous one, reference only the
+// original vertices and keep the triangles facing outwards
+BOOST_AUTO_TEST_CASE(simplifySphere)
+{
+    std::vector<Vector3> positions;
+    std::vector<unsigned int> indices;
+
+    createSphere(positions, indices);
+
+    std::vector< std::vector<unsigned int> > levels;
+    MeshSimplifier::generateLevels(positions, &indices.front(), indices.size(), 200, levels);
+
+    BOOST_REQUIRE(!levels.empty());
+    BOOST_CHECK(levels.size() <= render::MAX_MESH_LOD_LEVELS);
+
+    std::size_t previous = indices.size();
+
+    for (std::size_t level = 0; level < levels.size(); ++level)
+    {
+        const std::vector<unsigned int>& lod = levels[level];
+
+        BOOST_CHECK(lod.size() % 3 == 0);
+        BOOST_CHECK(lod.size() * 4 <= previous * 3);
+
+        for (std::size_t i = 0; i < lod.size(); i += 3)
+        {
+            BOOST_REQUIRE(lod[i] < positions.size() && lod[i + 1] < positions.size() &&
+                          lod[i + 2] < positions.size());
+
+            const Vector3& a = positions[lod[i]];
+            const Vector3& b = positions[lod[i + 1]];
+            const Vector3& c = positions[lod[i + 2]];
+
+            Vector3 normal = (b - a).crossProduct(c - a);
+
+            BOOST_CHECK(normal.dot(a + b + c) > 0);
+        }
+
+        previous = lod.size();
+    }
+}
+
+// Small meshes and triangle soups without shared edges stay as they are
+BOOST_AUTO_TEST_CASE(keepUnsimplifiableMeshes)
+{
+    std::vector<Vector3> positions;
+    std::vector<unsigned int> indices;
+
+    for (unsigned int i = 0; i < 300; ++i)
+    {
+        for (unsigned int k = 0; k < 3; ++k)
+        {
+            positions.push_back(Vector3(i * 10 + k, k * 3, 0));
+            indices.push_back(i * 3 + k);
+        }
+    }
+
+    std::vector< std::vector<unsigned int> > levels;
+
+    MeshSimplifier::generateLevels(positions, &indices.front(), indices.size(), 200, levels);
+    BOOST_CHECK(levels.empty());
+
+    MeshSimplifier::generateLevels(positions, &indices.front(), 30, 200, levels);
+    BOOST_CHECK(levels.empty());
+}
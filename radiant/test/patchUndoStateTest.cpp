@@ -0,0 +1,223 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE patchUndoStateTest
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/patch/PatchSavedState.h"
+
+#include <cstdlib>
+
+namespace
+{
+    // The patch members Patch::exportState(), compactState() and
+    // importState() work with, saved and restored the same way
+    struct PatchData
+    {
+        std::size_t width;
+        std::size_t height;
+        PatchControlArray ctrl;
+        std::string shader;
+        bool patchDef3;
+        std::size_t subdivisionsX;
+        std::size_t subdivisionsY;
+
+        PatchData(std::size_t width_, std::size_t height_) :
+            width(width_),
+            height(height_),
+            ctrl(width_ * height_),
+            shader("textures/common/caulk"),
+            patchDef3(false),
+            subdivisionsX(0),
+            subdivisionsY(0)
+        {
+            for (std::size_t i = 0; i < ctrl.size(); ++i)
+            {
+                ctrl[i].vertex = Vector3(i % width * 64, i / width * 64, std::rand() % 32);
+                ctrl[i].texcoord = Vector2(i % width * 0.25, i / width * 0.25);
+            }
+        }
+
+        IUndoMementoPtr exportState() const
+        {
+            return IUndoMementoPtr(new SavedState(width, height, ctrl, shader,
+                patchDef3, subdivisionsX, subdivisionsY));
+        }
+
+        IUndoMementoPtr compactState(const IUndoMementoPtr& state) const
+        {
+            return SavedState::compact(state, width, height, ctrl, shader,
+                patchDef3, subdivisionsX, subdivisionsY);
+        }
+
+        void importState(const IUndoMementoPtr& state)
+        {
+            const SavedState& other = *std::static_pointer_cast<SavedState>(state);
+
+            if (other.m_isDelta)
+            {
+                other.restoreControlPoints(ctrl);
+            }
+            else
+            {
+                width = other.m_width;
+                height = other.m_height;
+                ctrl = other.m_ctrl;
+            }
+
+            shader = other.m_shader;
+            patchDef3 = other.m_patchDef3;
+            subdivisionsX = other.m_subdivisions_x;
+            subdivisionsY = other.m_subdivisions_y;
+        }
+
+        bool operator==(const PatchData& other) const
+        {
+            if (width != other.width || height != other.height || shader != other.shader ||
+                patchDef3 != other.patchDef3 || subdivisionsX != other.subdivisionsX ||
+                subdivisionsY != other.subdivisionsY || ctrl.size() != other.ctrl.size())
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < ctrl.size(); ++i)
+            {
+                if (ctrl[i].vertex != other.ctrl[i].vertex || ctrl[i].texcoord != other.ctrl[i].texcoord)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    const SavedState& getSavedState(const IUndoMementoPtr& state)
+    {
+        return *std::static_pointer_cast<SavedState>(state);
+    }
+
+    // Exports the state before the given change, compacts it afterwards and
+    // imports the result, which needs to restore the original patch exactly
+    template<typename Change>
+    IUndoMementoPtr roundTrip(PatchData& patch, const Change& change)
+    {
+        PatchData before = patch;
+
+        IUndoMementoPtr saved = patch.exportState();
+        change(patch);
+
+        IUndoMementoPtr compacted = patch.compactState(saved);
+
+        if (compacted)
+        {
+            patch.importState(compacted);
+        }
+
+        BOOST_REQUIRE(patch == before);
+
+        return compacted;
+    }
+}
+
+// Moving a few control points only keeps those points
+BOOST_AUTO_TEST_CASE(moveSomePoints)
+{
+    std::srand(1);
+
+    PatchData patch(15, 15);
+
+    for (int step = 0; step < 100; ++step)
+    {
+        std::size_t first = std::rand() % patch.ctrl.size();
+        std::size_t count = std::rand() % 20 + 1;
+
+        IUndoMementoPtr compacted = roundTrip(patch, [&] (PatchData& p)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                PatchControl& control = p.ctrl[(first + i * 7) % p.ctrl.size()];
+                control.vertex += Vector3(0.001, 0, std::rand() % 16 + 1);
+            }
+        });
+
+        BOOST_REQUIRE(compacted);
+        BOOST_REQUIRE(getSavedState(compacted).m_isDelta);
+        BOOST_REQUIRE_EQUAL(getSavedState(compacted).m_ctrl.size(), count);
+        BOOST_REQUIRE(compacted->getMemorySize() < patch.exportState()->getMemorySize());
+    }
+}
+
+// Texture changes are control point changes as well
+BOOST_AUTO_TEST_CASE(changeTexcoords)
+{
+    std::srand(2);
+
+    PatchData patch(9, 5);
+
+    IUndoMementoPtr compacted = roundTrip(patch, [&] (PatchData& p)
+    {
+        p.ctrl[3].texcoord += Vector2(0.5, 0);
+        p.ctrl[17].texcoord += Vector2(0, -0.125);
+        p.shader = "textures/darkmod/stone/brick/rough_big_blocks";
+    });
+
+    BOOST_REQUIRE(compacted);
+    BOOST_CHECK(getSavedState(compacted).m_isDelta);
+    BOOST_CHECK_EQUAL(getSavedState(compacted).m_ctrl.size(), 2);
+}
+
+// Only the settings changed, no control point needs to be kept
+BOOST_AUTO_TEST_CASE(changeSettingsOnly)
+{
+    std::srand(3);
+
+    PatchData patch(3, 3);
+
+    IUndoMementoPtr compacted = roundTrip(patch, [&] (PatchData& p)
+    {
+        p.patchDef3 = true;
+        p.subdivisionsX = 4;
+        p.subdivisionsY = 2;
+    });
+
+    BOOST_REQUIRE(compacted);
+    BOOST_CHECK(getSavedState(compacted).m_isDelta);
+    BOOST_CHECK(getSavedState(compacted).m_ctrl.empty());
+}
+
+// Changed dimensions and large edits keep the full state
+BOOST_AUTO_TEST_CASE(keepFullStates)
+{
+    std::srand(4);
+
+    PatchData patch(5, 5);
+
+    IUndoMementoPtr resized = roundTrip(patch, [&] (PatchData& p)
+    {
+        p = PatchData(7, 5);
+    });
+
+    BOOST_REQUIRE(resized);
+    BOOST_CHECK(!getSavedState(resized).m_isDelta);
+
+    IUndoMementoPtr moved = roundTrip(patch, [&] (PatchData& p)
+    {
+        for (std::size_t i = 0; i < p.ctrl.size(); ++i)
+        {
+            p.ctrl[i].vertex += Vector3(16, 0, 0);
+        }
+    });
+
+    BOOST_REQUIRE(moved);
+    BOOST_CHECK(!getSavedState(moved).m_isDelta);
+    BOOST_CHECK_EQUAL(getSavedState(moved).m_ctrl.size(), patch.ctrl.size());
+}
+
+// Saving a patch without changing it leaves nothing behind
+BOOST_AUTO_TEST_CASE(dropUnchangedStates)
+{
+    PatchData patch(3, 7);
+
+    IUndoMementoPtr compacted = roundTrip(patch, [&] (PatchData& p) {});
+
+    BOOST_CHECK(!compacted);
+}
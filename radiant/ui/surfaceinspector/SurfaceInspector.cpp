@@ -94,6 +94,7 @@ namespace
 SurfaceInspector::SurfaceInspector()
 : gtkutil::PersistentTransientWindow(_(WINDOW_TITLE), GlobalMainFrame().getTopLevelWindow(), true),
   _callbackActive(false),
+  _updatePending(false),
   _selectionInfo(GlobalSelectionSystem().getSelectionInfo())
 {
 	// Set the default border width in accordance to the HIG
@@ -569,8 +570,10 @@ void SurfaceInspector::updateTexDef()
 // Public soft update function
 void SurfaceInspector::update()
 {
-    if (InstancePtr())
+    if (InstancePtr() && !InstancePtr()->_updatePending)
     {
+	    InstancePtr()->_updatePending = true;
+
 	    // Request an idle callback to perform the update when GTK is idle
 	    Glib::signal_idle().connect_once(
             sigc::mem_fun(*InstancePtr(), &SurfaceInspector::doUpdate)
@@ -580,6 +583,8 @@ void SurfaceInspector::update()
 
 void SurfaceInspector::doUpdate()
 {
+	_updatePending = false;
+
 	bool valueSensitivity = false;
 	bool fitSensitivity = (_selectionInfo.totalCount > 0);
 	bool flipSensitivity = (_selectionInfo.totalCount > 0);
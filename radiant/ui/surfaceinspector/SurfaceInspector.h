@@ -100,6 +100,9 @@ class SurfaceInspector
 	// To avoid key changed loopbacks when the registry is updated
 	bool _callbackActive;
 
+	// True while an idle update is queued, every face requests one during undo
+	bool _updatePending;
+
 	// A reference to the SelectionInfo structure (with the counters)
 	const SelectionInfo& _selectionInfo;
 
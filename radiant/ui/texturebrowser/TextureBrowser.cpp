@@ -605,6 +605,9 @@ void TextureBrowser::draw()
 {
     GlobalOpenGL().assertNoErrors();
 
+    // Get the textures loaded in the background into GL
+    GlobalMaterialManager().uploadStreamedTextures();
+
     Vector3 colorBackground = ColourSchemes().getColour("texture_background");
     glClearColor(colorBackground[0], colorBackground[1], colorBackground[2], 0);
     glViewport(0, 0, _viewportSize.x(), _viewportSize.y());
@@ -1010,6 +1013,11 @@ Gtk::Widget* TextureBrowser::constructWindow(const Glib::RefPtr<Gtk::Window>& pa
 
     GlobalMaterialManager().addActiveShadersObserver(shared_from_this());
 
+    // Redraw when textures have finished loading in the background
+    _texturesStreamedConn = GlobalMaterialManager().signal_texturesStreamed().connect(
+        sigc::mem_fun(*this, &TextureBrowser::queueDraw)
+    );
+
     Gtk::HBox* hbox = Gtk::manage(new Gtk::HBox(false, 0));
 
     {
@@ -1112,6 +1120,7 @@ Gtk::Widget* TextureBrowser::constructWindow(const Glib::RefPtr<Gtk::Window>& pa
 void TextureBrowser::destroyWindow()
 {
     GlobalMaterialManager().removeActiveShadersObserver(shared_from_this());
+    _texturesStreamedConn.disconnect();
 
     // Remove the parent reference
     _parent.reset();
@@ -96,6 +96,8 @@ class TextureBrowser :
     Glib::RefPtr<Gtk::Window> _parent;
     gtkutil::GLWidget* _glWidget;
 
+    sigc::connection _texturesStreamedConn;
+
     Gtk::VScrollbar* _textureScrollbar;
     gtkutil::DeferredAdjustment* _vadjustment;
 
@@ -0,0 +1,68 @@
+#include "UndoHistoryStatus.h"
+
+#include "i18n.h"
+#include "iundo.h"
+#include "iuimanager.h"
+#include "ipreferencesystem.h"
+#include "modulesystem/StaticModule.h"
+
+#include <boost/format.hpp>
+
+namespace ui
+{
+
+namespace
+{
+	const char* const STATUSBAR_UNDO_MEMORY = "UndoMemory";
+}
+
+const std::string& UndoHistoryStatus::getName() const
+{
+	static std::string _name("UndoHistoryStatus");
+	return _name;
+}
+
+const StringSet& UndoHistoryStatus::getDependencies() const
+{
+	static StringSet _dependencies;
+
+	if (_dependencies.empty())
+	{
+		_dependencies.insert(MODULE_UNDOSYSTEM);
+		_dependencies.insert(MODULE_UIMANAGER);
+		_dependencies.insert(MODULE_PREFERENCESYSTEM);
+	}
+
+	return _dependencies;
+}
+
+void UndoHistoryStatus::initialiseModule(const ApplicationContext& ctx)
+{
+	PreferencesPagePtr page = GlobalPreferenceSystem().getPage(_("Settings/Undo System"));
+	page->appendSpinner(_("Undo Memory Budget (MB)"), RKEY_UNDO_MEMORY_BUDGET, 16, 4096, 0);
+
+	// Show the memory used by the undo history next to the map counters
+	GlobalUIManager().getStatusBarManager().addTextElement(
+		STATUSBAR_UNDO_MEMORY,
+		"",  // no icon
+		IStatusBarManager::POS_BRUSHCOUNT + 1
+	);
+
+	GlobalUndoSystem().signal_historyChanged().connect(
+		sigc::mem_fun(this, &UndoHistoryStatus::onHistoryChanged)
+	);
+
+	onHistoryChanged();
+}
+
+void UndoHistoryStatus::onHistoryChanged()
+{
+	std::string text = (boost::format(_("Undo: %d steps, %.1f MB")) %
+		GlobalUndoSystem().size() % (GlobalUndoSystem().getMemorySize() / 1048576.0)).str();
+
+	GlobalUIManager().getStatusBarManager().setText(STATUSBAR_UNDO_MEMORY, text);
+}
+
+module::StaticModule<UndoHistoryStatus> undoHistoryStatusModule;
+
+} // namespace ui
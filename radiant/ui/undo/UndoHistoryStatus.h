@@ -0,0 +1,28 @@
+#pragma once
+
+#include "imodule.h"
+#include <sigc++/trackable.h>
+
+namespace ui
+{
+
+/**
+ * Shows the number of undo steps and the memory used by the undo history
+ * in the status bar, and adds the memory budget to the undo preferences.
+ */
+class UndoHistoryStatus :
+	public RegisterableModule,
+	public sigc::trackable
+{
+public:
+	// RegisterableModule implementation
+	const std::string& getName() const;
+	const StringSet& getDependencies() const;
+	void initialiseModule(const ApplicationContext& ctx);
+
+private:
+	// Connected to the undo system
+	void onHistoryChanged();
+};
+
+} // namespace ui
@@ -34,6 +34,7 @@ namespace
 	const std::string RKEY_DEFAULT_BLOCKSIZE = "user/ui/xyview/defaultBlockSize";
 	const std::string RKEY_TRANSLATE_CONSTRAINED = "user/ui/xyview/translateConstrained";
 	const std::string RKEY_HIGHER_ENTITY_PRIORITY = "user/ui/xyview/higherEntitySelectionPriority";
+	const std::string RKEY_LOD_THRESHOLD = RKEY_XYVIEW_ROOT + "/lodThreshold";
 }
 
 // Constructor
@@ -184,6 +185,7 @@ void XYWndManager::constructPreferences()
 	page->appendCheckBox("", _("Show Workzone"), RKEY_SHOW_WORKZONE);
 	page->appendCheckBox("", _("Translate Manipulator always constrained to Axis"), RKEY_TRANSLATE_CONSTRAINED);
 	page->appendCheckBox("", _("Higher Selection Priority for Entities"), RKEY_HIGHER_ENTITY_PRIORITY);
+	page->appendSpinner(_("Simplify objects smaller than (pixels, 0 = off)"), RKEY_LOD_THRESHOLD, 0, 32, 0);
 }
 
 // Load/Reload the values from the registry
@@ -200,6 +202,7 @@ void XYWndManager::refreshFromRegistry()
 	_showAxes = registry::getValue<bool>(RKEY_SHOW_AXES);
 	_showWorkzone = registry::getValue<bool>(RKEY_SHOW_WORKZONE);
 	_defaultBlockSize = registry::getValue<int>(RKEY_DEFAULT_BLOCKSIZE);
+	_lodThreshold = registry::getValue<float>(RKEY_LOD_THRESHOLD);
 	updateAllViews();
 }
 
@@ -228,6 +231,10 @@ unsigned int XYWndManager::defaultBlockSize() const {
 	return _defaultBlockSize;
 }
 
+float XYWndManager::lodThreshold() const {
+	return _lodThreshold;
+}
+
 bool XYWndManager::showCoordinates() const {
 	return _showCoordinates;
 }
@@ -590,6 +597,7 @@ void XYWndManager::initialiseModule(const ApplicationContext& ctx)
 	observeKey(RKEY_SHOW_AXES);
 	observeKey(RKEY_SHOW_WORKZONE);
 	observeKey(RKEY_DEFAULT_BLOCKSIZE);
+	observeKey(RKEY_LOD_THRESHOLD);
 
 	// Trigger loading the values of the observed registry keys
 	refreshFromRegistry();
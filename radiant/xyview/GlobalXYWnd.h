@@ -37,6 +37,9 @@ class XYWndManager : public IXWndManager
 
 	unsigned int _defaultBlockSize;
 
+	// Objects smaller than this amount of pixels are drawn simplified (0 = off)
+	float _lodThreshold;
+
 	Glib::RefPtr<Gtk::Window> _globalParentWindow;
 
 private:
@@ -65,6 +68,7 @@ public:
 	bool higherEntitySelectionPriority() const;
 
 	unsigned int defaultBlockSize() const;
+	float lodThreshold() const;
 
 	// Passes a queueDraw() call to each allocated view
 	void updateAllViews();
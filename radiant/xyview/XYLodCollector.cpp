@@ -0,0 +1,250 @@
+#include "XYLodCollector.h"
+
+#include "igl.h"
+#include "ientity.h"
+#include "iscenegraph.h"
+#include "render/frontend/RenderHighlighted.h"
+#include "render/FrameProfiler.h"
+
+void XYLodProxies::addRectangle(const Vector3& corner, const Vector3& edge1, const Vector3& edge2)
+{
+	Vector3 opposite = corner + edge1 + edge2;
+
+	_lines.push_back(corner);
+	_lines.push_back(corner + edge1);
+
+	_lines.push_back(corner + edge1);
+	_lines.push_back(opposite);
+
+	_lines.push_back(opposite);
+	_lines.push_back(corner + edge2);
+
+	_lines.push_back(corner + edge2);
+	_lines.push_back(corner);
+}
+
+void XYLodProxies::render(const RenderInfo& info) const
+{
+	if (!_points.empty())
+	{
+		glVertexPointer(3, GL_DOUBLE, sizeof(Vector3), &_points.front());
+		glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(_points.size()));
+	}
+
+	if (!_lines.empty())
+	{
+		glVertexPointer(3, GL_DOUBLE, sizeof(Vector3), &_lines.front());
+		glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(_lines.size()));
+	}
+}
+
+XYLodCollector::XYLodCollector(RenderableCollector& collector, EViewType viewType,
+							   double scale, float lodThreshold) :
+	_collector(collector),
+	_axis1(viewType == YZ ? 1 : 0),
+	_axis2(viewType == XY ? 1 : 2),
+	_pixelSize(scale > 0 ? 1.0 / scale : 1.0),
+	_lodSize(lodThreshold > 0 ? lodThreshold * _pixelSize : 0),
+	_identity(Matrix4::getIdentity())
+{}
+
+class XYLodCollector::LodWalker :
+	public scene::Graph::Walker
+{
+	XYLodCollector& _owner;
+	render::RenderHighlighted& _walker;
+
+public:
+	LodWalker(XYLodCollector& owner, render::RenderHighlighted& walker) :
+		_owner(owner),
+		_walker(walker)
+	{}
+
+	bool visit(const scene::INodePtr& node)
+	{
+		if (!_owner.isHighlighted(node) && _owner.isBelowLodSize(node->worldAABB()))
+		{
+			ShaderPtr shader = _owner.getWireShader(node);
+
+			if (shader)
+			{
+				_owner.addProxy(shader, node->worldAABB());
+				return true;
+			}
+		}
+
+		return _walker.visit(node);
+	}
+
+	bool visitSPNode(const scene::ISPNode& node)
+	{
+		if (!_owner.isBelowLodSize(node.getBounds()))
+		{
+			return true;
+		}
+
+		// The whole subtree covers just a few pixels, merge it into one
+		// outline per colour
+		ShaderBounds bounds;
+
+		_owner.aggregate_r(node, _walker, bounds);
+
+		for (ShaderBounds::const_iterator b = bounds.begin(); b != bounds.end(); ++b)
+		{
+			_owner.addProxy(b->first, b->second);
+		}
+
+		return false;
+	}
+};
+
+void XYLodCollector::collectRenderables(const VolumeTest& volume)
+{
+	if (_lodSize <= 0)
+	{
+		render::RenderHighlighted::collectRenderablesInScene(_collector, volume);
+		return;
+	}
+
+	render::ScopedProfileZone zone(render::PROFILE_ZONE_COLLECT);
+
+	if (render::FrameProfiler::Instance().isEnabled())
+	{
+		render::ProfiledVolumeTest profiledVolume(volume);
+		render::RenderHighlighted walker(_collector, profiledVolume);
+		collectInScene(profiledVolume, walker);
+	}
+	else
+	{
+		render::RenderHighlighted walker(_collector, volume);
+		collectInScene(volume, walker);
+	}
+}
+
+std::size_t XYLodCollector::getNumProxies() const
+{
+	std::size_t count = 0;
+
+	for (ProxyMap::const_iterator i = _proxies.begin(); i != _proxies.end(); ++i)
+	{
+		count += i->second.size();
+	}
+
+	return count;
+}
+
+void XYLodCollector::collectInScene(const VolumeTest& volume, render::RenderHighlighted& walker)
+{
+	_proxies.clear();
+
+	// The scene graph brings the bounds and the space partition up to date
+	LodWalker lodWalker(*this, walker);
+	GlobalSceneGraph().foreachVisibleNodeInVolume(volume, lodWalker);
+
+	// Submit renderables directly attached to the ShaderCache
+	GlobalRenderSystem().forEachRenderable(walker.getRenderableCallback());
+
+	// Submit the batched proxies, one draw call per wire shader
+	for (ProxyMap::const_iterator i = _proxies.begin(); i != _proxies.end(); ++i)
+	{
+		_collector.PushState();
+		_collector.SetState(i->first, RenderableCollector::eWireframeOnly);
+		_collector.addRenderable(i->second, _identity);
+		_collector.PopState();
+	}
+}
+
+void XYLodCollector::aggregate_r(const scene::ISPNode& node, render::RenderHighlighted& walker,
+								 ShaderBounds& bounds)
+{
+	const scene::ISPNode::MemberList& members = node.getMembers();
+
+	for (scene::ISPNode::MemberList::const_iterator m = members.begin(); m != members.end(); ++m)
+	{
+		const scene::INodePtr& member = *m;
+
+		if (!member->visible()) continue;
+
+		if (isHighlighted(member))
+		{
+			walker.visit(member);
+			continue;
+		}
+
+		ShaderPtr memberShader = getWireShader(member);
+
+		if (!memberShader)
+		{
+			walker.visit(member);
+			continue;
+		}
+
+		bounds[memberShader].includeAABB(member->worldAABB());
+	}
+
+	const scene::ISPNode::NodeList& children = node.getChildNodes();
+
+	for (scene::ISPNode::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+	{
+		aggregate_r(**i, walker, bounds);
+	}
+}
+
+ShaderPtr XYLodCollector::getWireShader(const scene::INodePtr& node) const
+{
+	// Primitives are drawn with their parent entity's wire shader
+	scene::INodePtr parent = node->getParent();
+
+	if (Node_getEntity(parent) != NULL || Node_getEntity(node) != NULL)
+	{
+		const IRenderEntityPtr& renderEntity = node->getRenderEntity();
+
+		if (renderEntity)
+		{
+			return renderEntity->getWireShader();
+		}
+	}
+
+	return ShaderPtr();
+}
+
+bool XYLodCollector::isHighlighted(const scene::INodePtr& node) const
+{
+	if (node->isHighlighted()) return true;
+
+	scene::INodePtr parent = node->getParent();
+
+	return parent != NULL && parent->isHighlighted();
+}
+
+bool XYLodCollector::isBelowLodSize(const AABB& bounds) const
+{
+	if (!bounds.isValid()) return false;
+
+	return bounds.extents[_axis1] * 2 < _lodSize && bounds.extents[_axis2] * 2 < _lodSize;
+}
+
+void XYLodCollector::addProxy(const ShaderPtr& shader, const AABB& bounds)
+{
+	XYLodProxies& proxies = _proxies[shader];
+
+	double width = bounds.extents[_axis1] * 2;
+	double height = bounds.extents[_axis2] * 2;
+
+	if (width < _pixelSize && height < _pixelSize)
+	{
+		// Sub-pixel object, a point is all we can see of it
+		proxies.addPoint(bounds.origin);
+		return;
+	}
+
+	Vector3 corner = bounds.origin - bounds.extents;
+
+	Vector3 edge1(0, 0, 0);
+	edge1[_axis1] = width;
+
+	Vector3 edge2(0, 0, 0);
+	edge2[_axis2] = height;
+
+	proxies.addRectangle(corner, edge1, edge2);
+}
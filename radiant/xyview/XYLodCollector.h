@@ -0,0 +1,114 @@
+#pragma once
+
+#include "iorthoview.h"
+#include "irender.h"
+#include "irenderable.h"
+#include "ispacepartition.h"
+#include "math/AABB.h"
+#include "math/Matrix4.h"
+
+#include <map>
+#include <vector>
+
+namespace render { class RenderHighlighted; }
+
+/**
+ * A batch of simplified stand-ins for objects which are too small
+ * to be drawn in full detail. Objects smaller than a pixel end up as points,
+ * the others as 2D rectangle outlines. All points and lines of a batch are
+ * issued with a single draw call each.
+ */
+class XYLodProxies :
+	public OpenGLRenderable
+{
+	std::vector<Vector3> _points;
+	std::vector<Vector3> _lines;
+
+public:
+	void addPoint(const Vector3& point)
+	{
+		_points.push_back(point);
+	}
+
+	// Adds the outline of the given rectangle, spanned by the given corner and the two edges
+	void addRectangle(const Vector3& corner, const Vector3& edge1, const Vector3& edge2);
+
+	std::size_t size() const
+	{
+		return _points.size() + _lines.size() / 8;
+	}
+
+	void render(const RenderInfo& info) const;
+};
+
+/**
+ * Collects the renderables of an orthoview, replacing the objects
+ * smaller than the LOD threshold with XYLodProxies. The scene is traversed by
+ * the scene graph, space partition nodes which are small enough as a whole are
+ * not descended into, their members are merged into a single outline.
+ * Highlighted (selected) objects are always submitted in full detail, so
+ * selection feedback is never affected.
+ *
+ * The proxies are owned by this class, so it needs to stay alive until
+ * the collected renderables have been rendered.
+ */
+class XYLodCollector
+{
+	RenderableCollector& _collector;
+
+	// The two world axes visible in this view
+	int _axis1;
+	int _axis2;
+
+	// World size of one screen pixel
+	double _pixelSize;
+
+	// World size below which objects are simplified (0 = LOD disabled)
+	double _lodSize;
+
+	// One batch per wire shader
+	typedef std::map<ShaderPtr, XYLodProxies> ProxyMap;
+	ProxyMap _proxies;
+
+	// The merged bounds of an SP subtree, one outline per wire shader
+	typedef std::map<ShaderPtr, AABB> ShaderBounds;
+
+	// The proxies are already in world space
+	Matrix4 _identity;
+
+public:
+	/**
+	 * Construct the collector for the given view type and scale (pixels per
+	 * world unit). Objects smaller than lodThreshold pixels are simplified,
+	 * a threshold of 0 disables the LOD altogether.
+	 */
+	XYLodCollector(RenderableCollector& collector, EViewType viewType,
+				   double scale, float lodThreshold);
+
+	// Traverses the scene and submits all visible renderables to the collector
+	void collectRenderables(const VolumeTest& volume);
+
+	// Returns the number of proxies generated by the last collection
+	std::size_t getNumProxies() const;
+
+private:
+	// The scene graph walker replacing the small nodes with proxies
+	class LodWalker;
+
+	void collectInScene(const VolumeTest& volume, render::RenderHighlighted& walker);
+
+	// Merges the members of the given SP subtree into one proxy per wire shader,
+	// highlighted members are passed to the walker instead
+	void aggregate_r(const scene::ISPNode& node, render::RenderHighlighted& walker,
+					 ShaderBounds& bounds);
+
+	// Returns the wire shader the given node is drawn with, NULL if unknown
+	ShaderPtr getWireShader(const scene::INodePtr& node) const;
+
+	bool isHighlighted(const scene::INodePtr& node) const;
+
+	// Returns true if the given bounds are smaller than the LOD size in this view
+	bool isBelowLodSize(const AABB& bounds) const;
+
+	void addProxy(const ShaderPtr& shader, const AABB& bounds);
+};
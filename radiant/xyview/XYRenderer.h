@@ -2,6 +2,7 @@
 #define XYRENDERER_H_
 
 #include "irenderable.h"
+#include "render/FrameProfiler.h"
 
 class XYRenderer :
 	public RenderableCollector
@@ -68,6 +69,8 @@ public:
 	void addRenderable(const OpenGLRenderable& renderable,
 					   const Matrix4& localToWorld)
 	{
+		render::SampledProfileZone zone(render::PROFILE_ZONE_SORT);
+
 		if (_stateStack.back().highlightPrimitives)
 		{
 			_selectedShader->addRenderable(renderable, localToWorld);
@@ -82,6 +85,8 @@ public:
 					   const Matrix4& localToWorld,
 					   const IRenderEntity& entity)
 	{
+		render::SampledProfileZone zone(render::PROFILE_ZONE_SORT);
+
 		if (_stateStack.back().highlightPrimitives)
 		{
 			_selectedShader->addRenderable(renderable, localToWorld, entity);
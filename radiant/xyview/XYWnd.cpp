@@ -27,9 +27,11 @@
 
 #include "GlobalXYWnd.h"
 #include "XYRenderer.h"
+#include "XYLodCollector.h"
 #include "gamelib.h"
 #include "scenelib.h"
 #include "render/frontend/RenderHighlighted.h"
+#include "render/FrameProfiler.h"
 
 #include <boost/lexical_cast.hpp>
 #include <boost/format.hpp>
@@ -1484,6 +1486,9 @@ void XYWnd::updateModelview() {
 
 void XYWnd::draw()
 {
+	render::FrameProfiler& profiler = render::FrameProfiler::Instance();
+	profiler.beginFrame(render::PROFILE_VIEW_ORTHO);
+
 	// clear
 	glViewport(0, 0, _width, _height);
 	Vector3 colourGridBack = ColourSchemes().getColour("grid_background");
@@ -1502,6 +1507,9 @@ void XYWnd::draw()
 	int nDim2 = (m_viewType == XY) ? 1 : 2;
 	glTranslatef(-m_vOrigin[nDim1], -m_vOrigin[nDim2], 0);
 
+	// The background image and the grid are counted as overlay
+	profiler.enterZone(render::PROFILE_ZONE_OVERLAY);
+
 	// Call the image overlay draw method with the window coordinates
 	Vector4 windowCoords = getWindowCoordinates();
 	ui::Overlay::Instance().draw(
@@ -1524,6 +1532,8 @@ void XYWnd::draw()
 	if (xyWndManager.showBlocks())
 		drawBlockGrid();
 
+	profiler.leaveZone();
+
 	glLoadMatrixd(m_modelview);
 
 	unsigned int flagsMask = RENDER_POINT_COLOUR | RENDER_VERTEX_COLOUR;
@@ -1537,13 +1547,18 @@ void XYWnd::draw()
 		// Construct the renderer and render the scene
 		XYRenderer renderer(flagsMask, _selectedShader.get());
 
-		// First pass (scenegraph traversal)
-		render::RenderHighlighted::collectRenderablesInScene(renderer, m_view);
+		// First pass (scenegraph traversal), small objects are simplified
+		// if LOD is enabled. The collector owns the proxies until rendering is done.
+		XYLodCollector collector(renderer, m_viewType, m_fScale, xyWndManager.lodThreshold());
+		collector.collectRenderables(m_view);
 
 		// Second pass (GL calls)
 		renderer.render(m_modelview, m_projection);
 	}
 
+	// Everything from here on is counted as overlay
+	profiler.enterZone(render::PROFILE_ZONE_OVERLAY);
+
 	glDepthMask(GL_FALSE);
 
 	GlobalOpenGL().assertNoErrors();
@@ -1707,6 +1722,9 @@ void XYWnd::draw()
 	GlobalOpenGL().assertNoErrors();
 
 	glFinish();
+
+	profiler.leaveZone();
+	profiler.endFrame();
 }
 
 void XYWnd::mouseToPoint(int x, int y, Vector3& point) {
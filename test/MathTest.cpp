@@ -9,6 +9,7 @@ void MathTest::run()
 	testRotationMatrices();
 	testMultiplication();
 	testTransformation();
+	testClipping();
 	testMatrixDeterminant();
 	testMatrixInversion();
 	testQuaternions();
@@ -423,6 +424,42 @@ void MathTest::testTransformation()
 	REQUIRE_TRUE(a.t().z() == 53, "Matrix4::t failed");
 }
 
+void MathTest::testClipping()
+{
+	Matrix4 a = Matrix4::getScale(Vector3(0.5, 0.5, 0.5));
+
+	Vector3 p0(-4, -1, 0);
+	Vector3 p1(1, 1, 0);
+	Vector3 p2(-1, 4, 0);
+
+	// Clipping pre-transformed points must yield the same polygon
+	Vector4 clipped[9];
+	std::size_t count = a.clipTriangle(p0, p1, p2, clipped);
+
+	Vector4 clippedTransformed[9];
+	std::size_t countTransformed = Matrix4::clipTransformedTriangle(
+		a.transform(Vector4(p0, 1)), a.transform(Vector4(p1, 1)), a.transform(Vector4(p2, 1)),
+		clippedTransformed
+	);
+
+	REQUIRE_TRUE(count > 3, "Triangle clipping failed");
+	REQUIRE_TRUE(count == countTransformed, "Clipping of transformed triangle failed");
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		REQUIRE_TRUE(clipped[i] == clippedTransformed[i], "Clipping of transformed triangle failed");
+	}
+
+	// Points outside the unit cube report the failed planes
+	REQUIRE_TRUE(Matrix4::getClipMask(Vector4(0, 0, 0, 1)) == c_CLIP_PASS, "Clip mask failed");
+	REQUIRE_TRUE(Matrix4::getClipMask(Vector4(2, 0, 0, 1)) != c_CLIP_PASS, "Clip mask failed");
+
+	// A line completely outside one plane is rejected
+	Vector4 clippedLine[2];
+	REQUIRE_TRUE(Matrix4::clipTransformedLine(Vector4(2, 0, 0, 1), Vector4(3, 1, 0, 1), clippedLine) == 0,
+		"Line clipping failed");
+}
+
 void MathTest::testMatrixDeterminant()
 {
 	Matrix4 a = Matrix4::byColumns(3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59);
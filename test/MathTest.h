@@ -21,6 +21,7 @@ private:
 	void testRotationMatrices();
 	void testMultiplication();
 	void testTransformation();
+	void testClipping();
 	void testMatrixDeterminant();
 	void testMatrixInversion();
 	void testQuaternions();